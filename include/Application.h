@@ -2,6 +2,7 @@
 #define APPLICATION_H
 
 #include "assets/IAssetFactory.h"
+#include "commands/EditHistory.h"
 #include "export/ExportFacade.h"
 #include "graphics/Window.h"
 #include "timeline/Timeline.h"
@@ -30,19 +31,71 @@ public:
 
   void addFilters();
 
+  /**
+   * @brief Fade every entry on the selected track out over its duration
+   *
+   * Uses opacity keyframes instead of shader code, so the fade follows
+   * each entry when it is moved or trimmed and shows up in exports.
+   */
+  void dissolveSelectedTrack();
+
+  /**
+   * @brief Switch the selected track to the next blend mode
+   */
+  void cycleSelectedBlendMode();
+
+  /**
+   * @brief Switch the transition after the selected entry to the next type
+   */
+  void cycleSelectedTransition();
+
+  /**
+   * @brief Undo the last timeline edit
+   */
+  void undoEdit();
+
+  /**
+   * @brief Redo the last undone timeline edit
+   */
+  void redoEdit();
+
+  /**
+   * @brief Save the project (P saves binary, J saves JSON)
+   * @param json Save as JSON instead of the binary format
+   */
+  void saveProject(bool json);
+
+  /**
+   * @brief Switch between 8-bit and linear-light compositing
+   */
+  void toggleLinearLight();
+
 private:
+  /**
+   * @brief Open the project at projectPath into the timeline
+   * @param settings Receives the project's export settings
+   * @return true if opened
+   */
+  bool openProject(ExportSettings &settings);
+
+  /**
+   * @brief Give the track shader the current filters and blend modes
+   */
+  void updateTrackShader();
+
   Window *window;
   std::vector<Button *> buttons;
   std::vector<Glyph *> labels;
   IAssetFactory *assetFactory;
-  std::vector<Texture *> trackTextures;
   std::vector<std::string> trackFilters;
   Glyph *video;
-  Image blank;
+  Image compositeFrame;
   TrackShader *trackShader;
 
-  // Assets loaded from command line
+  // Assets loaded from command line or the project
   std::vector<IAsset *> assets;
+  std::vector<std::string> assetSources; // What each asset was created from
+  std::string projectPath;               // Project opened at startup, if any
 
   // Selection state
   int assetSelected = -1; // Index of selected asset (-1 = none)
@@ -60,6 +113,7 @@ private:
 
   // Timeline system
   Timeline *timeline;
+  EditHistory history; // Undo/redo of timeline edits
 
   // New UI components
   ButtonPanel *assetActionsPanel;
@@ -72,6 +126,7 @@ private:
   ExportMenuModel *exportMenuModel;
   ExportMenuView *exportMenuView;
   ExportMenuController *exportMenuController;
+  ExportJobManager *exportJobs;
 
   // Video playback members
   VideoReaderState video_state;
@@ -21,9 +21,11 @@ public:
   int getHeight() const;
   Color getPixel(int x, int y) const;
   void setPixel(int x, int y, const Color &color);
+  void fill(const Color &color);
   const unsigned char *getData() const { return pixels; }
   unsigned char *getData() { return pixels; }
   void operator=(const Image &image);
+  void swap(Image &other);
 
 private:
   int width;
@@ -2,6 +2,7 @@
 #define VIDEO_H_
 
 #include "Image.h"
+#include "timeline/Timebase.h"
 #include "video_reader.hpp"
 #include <chrono>
 
@@ -12,6 +13,17 @@ public:
   Video(const std::string &filename);
   virtual ~Video();
 
+  /**
+   * @brief Advance to the frame shown at a time
+   *
+   * Decodes forward to the last frame starting at or before time, seeking
+   * first when time is behind the current frame or more than a second
+   * ahead. Frame times are compared in Ticks, so the same time always
+   * selects the same frame.
+   *
+   * @param time Time in the video (in seconds)
+   * @return false if a frame could not be decoded
+   */
   bool nextFrame(double time);
   void seekFrame(double time);
   const Image &getFrame() const { return *frame; }
@@ -21,10 +33,27 @@ public:
 
 private:
   VideoReaderState videoState;
-  double lastFrameTime = 0.0;
+  Rational timeBase;        // Seconds per PTS unit
+  Rational rate = Rational(30, 1);
+  Ticks frameLength = 0;    // Nominal length of one frame
+  int64_t firstPts = 0;     // PTS of the frame at time 0
   int64_t currentPts = 0;
   double frameRate = 30.0;
   Image *frame;
+
+  /**
+   * @brief Get the time of a frame in the video
+   * @param pts Presentation timestamp of the frame
+   * @return Time since the first frame, in ticks
+   */
+  Ticks ptsToTicks(int64_t pts) const;
+
+  /**
+   * @brief Decode frames until the next one would start after a time
+   * @param target Time in the video (in ticks)
+   * @return false if a frame could not be decoded
+   */
+  bool decodeUntil(Ticks target);
 };
 
 } // namespace csci3081
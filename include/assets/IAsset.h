@@ -17,6 +17,15 @@ class IAsset {
 public:
   virtual ~IAsset() {}
   virtual double getDuration() const = 0;
+  /**
+   * @brief Get the frame shown at a time
+   *
+   * Frames hold premultiplied alpha, converted once when the asset makes
+   * them, so the compositor never has to multiply by alpha per blend.
+   *
+   * @param time Time in the asset (in seconds)
+   * @return The frame (owned by the asset)
+   */
   virtual const Image &getFrame(double time = 0.0) = 0;
   virtual const Image &getThumbnail() = 0;
   virtual bool isVideo() const = 0;
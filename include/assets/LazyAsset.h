@@ -0,0 +1,73 @@
+#ifndef LAZY_ASSET_H_
+#define LAZY_ASSET_H_
+
+#include "IAsset.h"
+#include "IAssetFactory.h"
+#include <mutex>
+#include <string>
+
+namespace csci3081 {
+
+/**
+ * @brief Stand-in for an asset that is only loaded when its frames are needed
+ *
+ * Opening a project creates one of these per asset instead of decoding
+ * every image and video up front. Duration and type come from the project
+ * file, so the timeline can be laid out and edited without touching the
+ * asset; the first getFrame() or getThumbnail() creates the real asset
+ * through the factory. That first call may come from any thread.
+ *
+ * Design Pattern: Proxy Pattern
+ * - LazyAsset is the Proxy with the same interface as the asset it stands for
+ */
+class LazyAsset : public IAsset {
+public:
+  /**
+   * @brief Create a proxy for an asset
+   * @param factory Creates the asset when needed (not owned; must outlive
+   *        the proxy's first frame request)
+   * @param source The string to create the asset from (a path, "text:...")
+   * @param duration Duration of the asset in seconds
+   * @param type Type of the asset
+   */
+  LazyAsset(const IAssetFactory* factory, const std::string& source,
+            double duration, AssetType type);
+  ~LazyAsset();
+
+  LazyAsset(const LazyAsset&) = delete;
+  LazyAsset& operator=(const LazyAsset&) = delete;
+
+  double getDuration() const override { return duration; }
+  const Image& getFrame(double time = 0.0) override;
+  const Image& getThumbnail() override;
+  bool isVideo() const override { return type == AssetType::VIDEO; }
+  AssetType getAssetType() const override { return type; }
+
+  /**
+   * @brief Get the string the asset is created from
+   * @return The source
+   */
+  const std::string& getSource() const { return source; }
+
+  /**
+   * @brief Check if the real asset has been created yet
+   * @return true once a frame or thumbnail has been requested
+   */
+  bool isLoaded() const;
+
+private:
+  const IAssetFactory* factory;
+  std::string source;
+  double duration;
+  AssetType type;
+
+  IAsset* asset;          // Created on first use, may stay null
+  std::once_flag loaded;
+  Image placeholder;      // Shown if the factory can't create the asset
+
+  IAsset* resolve();
+};
+
+} // namespace csci3081
+
+#endif // LAZY_ASSET_H_
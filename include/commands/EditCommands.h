@@ -0,0 +1,303 @@
+#ifndef EDIT_COMMANDS_H_
+#define EDIT_COMMANDS_H_
+
+#include "commands/IEditCommand.h"
+#include "timeline/Timeline.h"
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief Base for commands that edit the entries of one track
+ *
+ * Holds the timeline and track index rather than a Track pointer, so the
+ * command stays valid if the track list is reallocated.
+ */
+class EntryCommand : public IEditCommand {
+public:
+  /**
+   * @brief Check if command can execute
+   */
+  virtual bool canExecute() const override;
+
+protected:
+  /**
+   * @brief Create a command editing one track
+   * @param timeline The timeline (not owned)
+   * @param trackIndex Index of the track to edit
+   */
+  EntryCommand(Timeline* timeline, size_t trackIndex)
+    : timeline(timeline), trackIndex(trackIndex) {}
+
+  /**
+   * @brief Get the track being edited
+   * @return The track
+   * @throws std::runtime_error if the track no longer exists
+   */
+  Track& getTrack() const;
+
+  /**
+   * @brief Check if another command edits the same track
+   * @param other The other command
+   * @return true if both edit the same track of the same timeline
+   */
+  bool sameTrack(const EntryCommand& other) const {
+    return timeline == other.timeline && trackIndex == other.trackIndex;
+  }
+
+  Timeline* timeline;
+  size_t trackIndex;
+};
+
+/**
+ * @brief Add an entry to a track
+ */
+class AddEntryCommand : public EntryCommand {
+public:
+  /**
+   * @brief Create an add entry command
+   * @param timeline The timeline
+   * @param trackIndex Track to add to
+   * @param entry The entry to add
+   * @param ripple Push later entries back to make room
+   */
+  AddEntryCommand(Timeline* timeline, size_t trackIndex, const TimelineEntry& entry,
+                  bool ripple = false)
+    : EntryCommand(timeline, trackIndex), entry(entry), ripple(ripple), index(0) {}
+
+  virtual void execute() override;
+  virtual void undo() override;
+  virtual std::string getDescription() const override { return "Add entry"; }
+  virtual size_t getMemoryUsage() const override;
+
+  /**
+   * @brief Get where the entry went
+   * @return Index of the entry after execute()
+   */
+  size_t getIndex() const { return index; }
+
+private:
+  TimelineEntry entry;
+  bool ripple;
+  size_t index;
+};
+
+/**
+ * @brief Remove an entry from a track
+ */
+class RemoveEntryCommand : public EntryCommand {
+public:
+  /**
+   * @brief Create a remove entry command
+   * @param timeline The timeline
+   * @param trackIndex Track to remove from
+   * @param index Index of the entry
+   * @param ripple Move later entries earlier to close the hole
+   */
+  RemoveEntryCommand(Timeline* timeline, size_t trackIndex, size_t index,
+                     bool ripple = false)
+    : EntryCommand(timeline, trackIndex), index(index), ripple(ripple),
+      removed(nullptr, 0.0, 0.0) {}
+
+  virtual void execute() override;
+  virtual void undo() override;
+  virtual std::string getDescription() const override { return "Remove entry"; }
+  virtual size_t getMemoryUsage() const override;
+
+private:
+  size_t index;
+  bool ripple;
+  TimelineEntry removed;   // Copy kept for undo
+};
+
+/**
+ * @brief Move an entry to a new start time
+ *
+ * Consecutive moves of the same entry merge, so a drag is one step.
+ */
+class MoveEntryCommand : public EntryCommand {
+public:
+  /**
+   * @brief Create a move entry command
+   * @param timeline The timeline
+   * @param trackIndex Track of the entry
+   * @param index Index of the entry
+   * @param startTime New start time in seconds
+   */
+  MoveEntryCommand(Timeline* timeline, size_t trackIndex, size_t index, double startTime)
+    : EntryCommand(timeline, trackIndex), index(index), newIndex(index),
+      oldStart(0), newStart(secondsToTicks(startTime)) {}
+
+  virtual void execute() override;
+  virtual void undo() override;
+  virtual bool mergeWith(const IEditCommand& next) override;
+  virtual std::string getDescription() const override { return "Move entry"; }
+  virtual size_t getMemoryUsage() const override { return sizeof(*this); }
+
+  /**
+   * @brief Get where the entry went
+   * @return Index of the entry after execute() (moving past other entries
+   *         changes it)
+   */
+  size_t getIndex() const { return newIndex; }
+
+private:
+  size_t index;      // Before the move
+  size_t newIndex;   // After the move
+  Ticks oldStart;
+  Ticks newStart;
+};
+
+/**
+ * @brief Change the duration of an entry
+ *
+ * Consecutive resizes of the same entry merge, so a drag is one step.
+ */
+class ResizeEntryCommand : public EntryCommand {
+public:
+  /**
+   * @brief Create a resize entry command
+   * @param timeline The timeline
+   * @param trackIndex Track of the entry
+   * @param index Index of the entry
+   * @param duration New duration in seconds
+   * @param ripple Move later entries by the change
+   */
+  ResizeEntryCommand(Timeline* timeline, size_t trackIndex, size_t index,
+                     double duration, bool ripple = false)
+    : EntryCommand(timeline, trackIndex), index(index), ripple(ripple),
+      oldDuration(0), newDuration(secondsToTicks(duration)) {}
+
+  virtual void execute() override;
+  virtual void undo() override;
+  virtual bool mergeWith(const IEditCommand& next) override;
+  virtual std::string getDescription() const override { return "Resize entry"; }
+  virtual size_t getMemoryUsage() const override { return sizeof(*this); }
+
+private:
+  size_t index;
+  bool ripple;
+  Ticks oldDuration;
+  Ticks newDuration;
+};
+
+/**
+ * @brief Attach or remove the transition after an entry
+ */
+class SetTransitionCommand : public EntryCommand {
+public:
+  /**
+   * @brief Create a command attaching a transition
+   * @param timeline The timeline
+   * @param trackIndex Track of the entry
+   * @param index Index of the outgoing entry
+   * @param transition The transition
+   */
+  SetTransitionCommand(Timeline* timeline, size_t trackIndex, size_t index,
+                       const Transition& transition)
+    : EntryCommand(timeline, trackIndex), index(index), hadTransition(false),
+      hasTransition(true), newTransition(transition) {}
+
+  /**
+   * @brief Create a command removing a transition
+   * @param timeline The timeline
+   * @param trackIndex Track of the entry
+   * @param index Index of the outgoing entry
+   */
+  SetTransitionCommand(Timeline* timeline, size_t trackIndex, size_t index)
+    : EntryCommand(timeline, trackIndex), index(index), hadTransition(false),
+      hasTransition(false) {}
+
+  virtual void execute() override;
+  virtual void undo() override;
+  virtual std::string getDescription() const override {
+    return hasTransition ? "Set transition" : "Remove transition";
+  }
+  virtual size_t getMemoryUsage() const override { return sizeof(*this); }
+
+private:
+  size_t index;
+  bool hadTransition;
+  bool hasTransition;
+  Transition oldTransition;
+  Transition newTransition;
+
+  void apply(bool has, const Transition& transition);
+};
+
+/**
+ * @brief Replace the keyframes of one property of an entry
+ */
+class SetKeyframesCommand : public EntryCommand {
+public:
+  /**
+   * @brief Create a set keyframes command
+   * @param timeline The timeline
+   * @param trackIndex Track of the entry
+   * @param index Index of the entry
+   * @param property The property to animate
+   * @param keyframes Keyframes with times relative to the entry start
+   */
+  SetKeyframesCommand(Timeline* timeline, size_t trackIndex, size_t index,
+                      EntryProperty property, const KeyframeTrack& keyframes)
+    : EntryCommand(timeline, trackIndex), index(index), property(property),
+      newKeyframes(keyframes) {}
+
+  virtual void execute() override;
+  virtual void undo() override;
+  virtual std::string getDescription() const override { return "Set keyframes"; }
+  virtual size_t getMemoryUsage() const override;
+
+private:
+  size_t index;
+  EntryProperty property;
+  KeyframeTrack oldKeyframes;
+  KeyframeTrack newKeyframes;
+};
+
+/**
+ * @brief Several edits done and undone as one step
+ *
+ * Design Pattern: Composite Pattern
+ */
+class EditGroupCommand : public IEditCommand {
+public:
+  /**
+   * @brief Create an empty group
+   * @param description Name of the step (e.g. "Dissolve track")
+   */
+  explicit EditGroupCommand(const std::string& description)
+    : description(description) {}
+
+  virtual ~EditGroupCommand();
+
+  EditGroupCommand(const EditGroupCommand&) = delete;
+  EditGroupCommand& operator=(const EditGroupCommand&) = delete;
+
+  /**
+   * @brief Add an edit to the group
+   * @param command The edit (the group takes ownership)
+   */
+  void add(IEditCommand* command) { commands.push_back(command); }
+
+  /**
+   * @brief Run every edit in order
+   *
+   * If one fails, the edits before it are undone before the error is
+   * passed on, so the group is all or nothing.
+   */
+  virtual void execute() override;
+  virtual void undo() override;
+  virtual std::string getDescription() const override { return description; }
+  virtual bool canExecute() const override { return !commands.empty(); }
+  virtual size_t getMemoryUsage() const override;
+
+private:
+  std::string description;
+  std::vector<IEditCommand*> commands;
+};
+
+} // namespace csci3081
+
+#endif // EDIT_COMMANDS_H_
@@ -0,0 +1,147 @@
+#ifndef EDIT_HISTORY_H_
+#define EDIT_HISTORY_H_
+
+#include "commands/IEditCommand.h"
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief Undo and redo stacks of timeline edits
+ *
+ * Every edit goes through perform(), which runs the command and keeps it
+ * for undo. A command that the previous step can absorb is merged into it,
+ * so the many small moves of one drag become a single step; seal() ends
+ * the step when the drag does.
+ *
+ * Steps keep only what they changed, and the oldest are dropped once the
+ * history holds more than its memory limit.
+ *
+ * Design Pattern: Command Pattern
+ * - EditHistory is the Invoker
+ */
+class EditHistory {
+public:
+  /**
+   * @brief Create an empty history
+   * @param memoryLimit Bytes of undo steps to keep
+   */
+  explicit EditHistory(size_t memoryLimit = DEFAULT_MEMORY_LIMIT);
+
+  ~EditHistory();
+
+  EditHistory(const EditHistory&) = delete;
+  EditHistory& operator=(const EditHistory&) = delete;
+
+  /**
+   * @brief Default memory limit (16 MB)
+   */
+  static const size_t DEFAULT_MEMORY_LIMIT;
+
+  /**
+   * @brief Run an edit and record it
+   *
+   * Clears the redo stack. Failed edits leave the timeline unchanged and
+   * are not recorded.
+   *
+   * @param command The edit (the history takes ownership, even on failure)
+   * @return true if the edit was made
+   */
+  bool perform(IEditCommand* command);
+
+  /**
+   * @brief Undo the last step
+   * @return true if a step was undone
+   */
+  bool undo();
+
+  /**
+   * @brief Redo the last undone step
+   * @return true if a step was redone
+   */
+  bool redo();
+
+  /**
+   * @brief Check if there is a step to undo
+   * @return true if undo() would do something
+   */
+  bool canUndo() const { return !done.empty(); }
+
+  /**
+   * @brief Check if there is a step to redo
+   * @return true if redo() would do something
+   */
+  bool canRedo() const { return !undone.empty(); }
+
+  /**
+   * @brief Stop the next edit from merging into the last step
+   *
+   * Call when a continuous gesture (a drag) ends.
+   */
+  void seal() { sealed = true; }
+
+  /**
+   * @brief Forget every step
+   */
+  void clear();
+
+  /**
+   * @brief Get the number of steps that can be undone
+   * @return Undo step count
+   */
+  size_t getUndoCount() const { return done.size(); }
+
+  /**
+   * @brief Get the number of steps that can be redone
+   * @return Redo step count
+   */
+  size_t getRedoCount() const { return undone.size(); }
+
+  /**
+   * @brief Get the memory kept by all steps
+   * @return Size in bytes
+   */
+  size_t getMemoryUsage() const { return memoryUsage; }
+
+  /**
+   * @brief Get the memory limit
+   * @return Size in bytes
+   */
+  size_t getMemoryLimit() const { return memoryLimit; }
+
+  /**
+   * @brief Change the memory limit, dropping old steps to fit
+   * @param limit Size in bytes
+   */
+  void setMemoryLimit(size_t limit);
+
+  /**
+   * @brief Get the description of the step undo() would reverse
+   * @return Description, or an empty string if there is none
+   */
+  std::string getUndoDescription() const;
+
+  /**
+   * @brief Get the description of the step redo() would repeat
+   * @return Description, or an empty string if there is none
+   */
+  std::string getRedoDescription() const;
+
+private:
+  std::deque<IEditCommand*> done;      // Oldest first
+  std::vector<IEditCommand*> undone;   // Most recently undone last
+  size_t memoryUsage;
+  size_t memoryLimit;
+  bool sealed;
+
+  void clearRedo();
+  // Drop the oldest steps until under the limit, always keeping the newest
+  void trim();
+};
+
+} // namespace csci3081
+
+#endif // EDIT_HISTORY_H_
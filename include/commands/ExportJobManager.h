@@ -0,0 +1,196 @@
+#ifndef EXPORT_JOB_MANAGER_H_
+#define EXPORT_JOB_MANAGER_H_
+
+#include "commands/ICommand.h"
+#include "export/ExportMonitor.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief Where an export job is in its life
+ */
+enum class ExportJobState {
+  QUEUED,      // Waiting for a free worker
+  RUNNING,
+  FINISHED,    // execute() returned
+  FAILED,      // execute() threw
+  CANCELLED    // Cancelled before it ran, or stopped by its monitor
+};
+
+/**
+ * @brief What an observer is told about a job
+ */
+struct ExportJobStatus {
+  int id;
+  std::string description;   // The command's getDescription()
+  ExportJobState state;
+  ExportProgress progress;
+  std::string error;         // Why it failed, if it did
+
+  ExportJobStatus() : id(0), state(ExportJobState::QUEUED) {}
+
+  /**
+   * @brief Check whether the job is over
+   * @return true if it finished, failed or was cancelled
+   */
+  bool isDone() const {
+    return state != ExportJobState::QUEUED && state != ExportJobState::RUNNING;
+  }
+};
+
+/**
+ * @brief Receives the state of the export jobs
+ *
+ * Design Pattern: Observer
+ * - IExportJobObserver is the Observer interface
+ * - ExportJobManager is the Subject
+ */
+class IExportJobObserver {
+public:
+  virtual ~IExportJobObserver() {}
+
+  /**
+   * @brief Called by ExportJobManager::update() when a job changed
+   * @param jobs Every job the manager holds, oldest first
+   */
+  virtual void onJobsChanged(const std::vector<ExportJobStatus>& jobs) = 0;
+};
+
+/**
+ * @brief Runs export commands on worker threads, a few at a time
+ *
+ * submit() queues a command and returns at once. Up to maxConcurrent
+ * commands run at a time, each on its own worker thread, in the order
+ * they were submitted; the rest wait. A running command reports progress
+ * and notices cancellation through the ExportMonitor it is given (see
+ * ICommand::setMonitor()).
+ *
+ * Observers are only called from update(), which the UI calls once a
+ * frame, so they run on the UI thread and can touch UI state freely.
+ *
+ * Design Pattern: Command Pattern
+ * - ExportJobManager is the Invoker
+ */
+class ExportJobManager {
+public:
+  /**
+   * @brief Start the worker threads
+   * @param maxConcurrent Most jobs that run at once (at least 1)
+   */
+  explicit ExportJobManager(int maxConcurrent = 1);
+
+  /**
+   * @brief Cancel every job and wait for the running ones to stop
+   */
+  ~ExportJobManager();
+
+  ExportJobManager(const ExportJobManager&) = delete;
+  ExportJobManager& operator=(const ExportJobManager&) = delete;
+
+  /**
+   * @brief Queue a command to run on a worker thread
+   * @param command The command (the manager takes ownership, even on failure)
+   * @return The job's id, or -1 if the command can't execute
+   */
+  int submit(ICommand* command);
+
+  /**
+   * @brief Cancel a job
+   *
+   * A queued job never runs. A running job is asked to stop through its
+   * monitor and is CANCELLED once it does.
+   *
+   * @param id The job
+   * @return false if there is no such job or it is already over
+   */
+  bool cancel(int id);
+
+  /**
+   * @brief Cancel every job that isn't over
+   */
+  void cancelAll();
+
+  /**
+   * @brief Get the state of every job
+   * @return Every job the manager holds, oldest first
+   */
+  std::vector<ExportJobStatus> getJobs() const;
+
+  /**
+   * @brief Check whether any job is queued or running
+   * @return true if some job isn't over
+   */
+  bool isBusy() const;
+
+  /**
+   * @brief Wait until every job is over
+   */
+  void waitForAll();
+
+  /**
+   * @brief Forget the jobs that are over
+   */
+  void removeFinished();
+
+  /**
+   * @brief Tell the observers about jobs that changed since the last call
+   *
+   * A job changes when its state changes or it writes frames.
+   */
+  void update();
+
+  /**
+   * @brief Start telling an observer about the jobs
+   * @param observer The observer (not owned)
+   */
+  void addObserver(IExportJobObserver* observer);
+
+  /**
+   * @brief Stop telling an observer about the jobs
+   * @param observer The observer
+   */
+  void removeObserver(IExportJobObserver* observer);
+
+  /**
+   * @brief Get the most jobs that run at once
+   * @return The concurrency limit
+   */
+  int getMaxConcurrent() const { return static_cast<int>(workers.size()); }
+
+private:
+  struct Job {
+    int id;
+    std::unique_ptr<ICommand> command;
+    std::string description;
+    ExportMonitor monitor;
+    ExportJobState state;
+    std::string error;
+  };
+
+  void workerLoop();
+  static bool isOver(const Job& job);
+  ExportJobStatus statusOf(const Job& job) const;
+
+  std::vector<std::thread> workers;
+  mutable std::mutex mutex;               // Guards the fields below
+  std::condition_variable wake;           // Signals workers that a job was queued
+  std::condition_variable finished;       // Signals waitForAll() that a job ended
+  std::vector<std::unique_ptr<Job> > jobs;
+  std::deque<Job*> queue;
+  int nextId;
+  bool stopping;
+
+  std::vector<IExportJobObserver*> observers;       // Only used by update()
+  std::vector<ExportJobStatus> lastNotified;
+};
+
+} // namespace csci3081
+
+#endif // EXPORT_JOB_MANAGER_H_
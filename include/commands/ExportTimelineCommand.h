@@ -0,0 +1,89 @@
+#ifndef EXPORT_TIMELINE_COMMAND_H_
+#define EXPORT_TIMELINE_COMMAND_H_
+
+#include "commands/ICommand.h"
+#include "export/ExportFacade.h"
+#include "timeline/Timeline.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace csci3081 {
+
+/**
+ * @brief Command to export a timeline as a video
+ *
+ * The command is made on the editor's thread and may be executed on
+ * another: it keeps a snapshot of the timeline as it was when the command
+ * was made, and a facade of its own with the editor's asset lists frozen,
+ * so the editor can go on editing while it runs.
+ *
+ * Design Pattern: Command Pattern
+ * - ExportTimelineCommand is a ConcreteCommand
+ * - ExportFacade is the Receiver
+ * - ICommand is the Command interface
+ */
+class ExportTimelineCommand : public ICommand {
+public:
+  /**
+   * @brief Create an export timeline command
+   * @param facade The export facade to copy (with its asset sources)
+   * @param timeline The timeline to export, as it is now
+   * @param filename Output filename
+   * @param settings Export settings
+   * @param width Width of output video
+   * @param height Height of output video
+   */
+  ExportTimelineCommand(const ExportFacade& facade, const Timeline& timeline,
+                        const std::string& filename, const ExportSettings& settings,
+                        int width, int height)
+    : facade(facade), timeline(timeline.snapshot()), filename(filename), settings(settings),
+      width(width), height(height) {
+    this->facade.freezeAssetSources();
+  }
+
+  virtual ~ExportTimelineCommand() {}
+
+  /**
+   * @brief Execute the export command
+   */
+  virtual void execute() override {
+    bool success = facade.exportTimeline(timeline.get(), filename, settings, width, height);
+    if (!success) {
+      throw std::runtime_error("Export failed: " + facade.getLastError());
+    }
+  }
+
+  /**
+   * @brief Get description of this command
+   */
+  virtual std::string getDescription() const override {
+    return "Export timeline to " + filename;
+  }
+
+  /**
+   * @brief Check if command can execute
+   */
+  virtual bool canExecute() const override {
+    return !filename.empty() && width > 0 && height > 0 && timeline->getTotalDuration() > 0.0;
+  }
+
+  /**
+   * @brief Report the export's progress to a monitor
+   */
+  virtual void setMonitor(ExportMonitor* monitor) override {
+    facade.setMonitor(monitor);
+  }
+
+private:
+  ExportFacade facade;
+  std::shared_ptr<const Timeline> timeline;
+  std::string filename;
+  ExportSettings settings;
+  int width;
+  int height;
+};
+
+} // namespace csci3081
+
+#endif // EXPORT_TIMELINE_COMMAND_H_
@@ -5,6 +5,8 @@
 
 namespace csci3081 {
 
+class ExportMonitor;
+
 /**
  * @brief Command pattern interface for encapsulating actions
  *
@@ -40,6 +42,16 @@ public:
    * @return true if command can execute, false otherwise
    */
   virtual bool canExecute() const = 0;
+
+  /**
+   * @brief Report progress to a monitor and stop when it is cancelled
+   *
+   * Called before execute() when the command runs as a background job.
+   * Commands that finish quickly can ignore it.
+   *
+   * @param monitor The monitor (not owned)
+   */
+  virtual void setMonitor(ExportMonitor* monitor) {}
 };
 
 } // namespace csci3081
@@ -0,0 +1,57 @@
+#ifndef IEDIT_COMMAND_H_
+#define IEDIT_COMMAND_H_
+
+#include "commands/ICommand.h"
+#include <cstddef>
+
+namespace csci3081 {
+
+/**
+ * @brief A timeline edit that can be undone
+ *
+ * Edit commands record only what they change (an entry's old start time,
+ * a removed entry...), never a copy of the timeline, so undoing or redoing
+ * one costs as much as the edit itself. execute() throws if the edit is
+ * not possible; after a successful execute(), undo() restores the exact
+ * previous state and execute() may be called again to redo.
+ *
+ * Commands refer to entries by track and index, so they must be undone in
+ * the reverse order they were executed, with no other edits in between.
+ * EditHistory keeps that order.
+ *
+ * Design Pattern: Command Pattern
+ * - IEditCommand extends the Command interface with undo
+ * - Track is the Receiver that performs the edits
+ * - EditHistory is the Invoker that keeps the undo and redo stacks
+ */
+class IEditCommand : public ICommand {
+public:
+  virtual ~IEditCommand() {}
+
+  /**
+   * @brief Reverse the last execute()
+   */
+  virtual void undo() = 0;
+
+  /**
+   * @brief Fold the next command into this one
+   *
+   * Called after next has executed. A command that can absorb it (the
+   * next step of the same drag, say) takes over its end state and returns
+   * true, and next is discarded; undoing this command then undoes both.
+   *
+   * @param next A command executed right after this one
+   * @return true if merged
+   */
+  virtual bool mergeWith(const IEditCommand& next) { return false; }
+
+  /**
+   * @brief Get the approximate memory kept by this command
+   * @return Size in bytes
+   */
+  virtual size_t getMemoryUsage() const = 0;
+};
+
+} // namespace csci3081
+
+#endif // IEDIT_COMMAND_H_
@@ -0,0 +1,71 @@
+#ifndef AFFINE_BLITTER_H_
+#define AFFINE_BLITTER_H_
+
+#include "Image.h"
+#include "compositor/Blend.h"
+#include "compositor/LinearFrame.h"
+#include "timeline/EntryTransform.h"
+
+namespace csci3081 {
+
+/**
+ * @brief Draws a layer into a frame through an EntryTransform
+ *
+ * The layer is positioned, scaled and rotated by the transform and blended
+ * onto the destination with its opacity and blend mode. Only the destination rows and
+ * spans covered by the transformed layer are touched, so a small caption or
+ * picture-in-picture costs proportionally less than a full-frame layer.
+ *
+ * Source pixels are sampled with bilinear filtering (SSE2 when available).
+ * A full-frame layer that already matches the destination size skips
+ * sampling and is blended row by row.
+ */
+class AffineBlitter {
+public:
+  /**
+   * @brief Blend a layer into a frame
+   * @param src The layer image
+   * @param dst The frame to draw into (modified in place)
+   * @param transform Placement of the layer in the frame
+   * @param mode How the layer combines with the frame
+   */
+  static void blit(const Image& src, Image& dst, const EntryTransform& transform,
+                   BlendMode mode = BlendMode::NORMAL);
+
+  /**
+   * @brief Blend a layer into a linear-light frame
+   *
+   * Sampled spans are converted to linear light a chunk at a time and
+   * blended with blendLinearSpan().
+   *
+   * @param src The layer image (sRGB-encoded)
+   * @param dst The frame to draw into (modified in place)
+   * @param transform Placement of the layer in the frame
+   * @param mode How the layer combines with the frame
+   */
+  static void blit(const Image& src, LinearFrame& dst,
+                   const EntryTransform& transform,
+                   BlendMode mode = BlendMode::NORMAL);
+
+  /**
+   * @brief Sample a span of pixels along a line in source space
+   *
+   * Pixel i of the span is sampled at (u + i * du, v + i * dv), in source
+   * pixel units where texel (x, y) covers [x, x+1) x [y, y+1). Coordinates
+   * outside the image are clamped to the edge.
+   *
+   * @param src The image to sample
+   * @param u Starting horizontal source coordinate
+   * @param v Starting vertical source coordinate
+   * @param du Horizontal step per output pixel
+   * @param dv Vertical step per output pixel
+   * @param out Output RGBA pixels (count * 4 bytes)
+   * @param count Number of pixels to sample
+   */
+  static void sampleSpan(const Image& src, float u, float v, float du, float dv,
+                         unsigned char* out, int count);
+};
+
+} // namespace csci3081
+
+#endif // AFFINE_BLITTER_H_
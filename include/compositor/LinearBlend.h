@@ -0,0 +1,87 @@
+#ifndef LINEAR_BLEND_H_
+#define LINEAR_BLEND_H_
+
+#include "compositor/Blend.h"
+#include "compositor/LinearFrame.h"
+#include "graphics/Color.h"
+#include "timeline/Transition.h"
+#include <cstdint>
+
+namespace csci3081 {
+
+/**
+ * @brief Convert sRGB-encoded 8-bit pixels to linear 16-bit pixels
+ *
+ * Both sides are premultiplied. Color channels of opaque pixels go straight
+ * through a 256-entry lookup table; translucent pixels are unpremultiplied
+ * for the lookup and premultiplied again after it. Alpha is scaled.
+ *
+ * @param dst Output pixels (count * 4 values)
+ * @param src Input RGBA8 pixels
+ * @param count Number of pixels
+ */
+void srgbToLinearSpan(uint16_t* dst, const unsigned char* src, int count);
+
+/**
+ * @brief Convert linear 16-bit pixels back to sRGB-encoded 8-bit pixels
+ *
+ * Uses a 4096-entry lookup table indexed by the top 12 bits (of the
+ * unpremultiplied value for translucent pixels). Every opaque 8-bit pixel
+ * survives a round trip through srgbToLinearSpan() unchanged.
+ *
+ * @param dst Output RGBA8 pixels
+ * @param src Input pixels (count * 4 values)
+ * @param count Number of pixels
+ */
+void linearToSrgbSpan(unsigned char* dst, const uint16_t* src, int count);
+
+/**
+ * @brief Convert one sRGB-encoded channel value to linear 16-bit
+ * @param value Channel value (0-255)
+ * @return Linear value (0-65535)
+ */
+uint16_t srgbToLinear(int value);
+
+/**
+ * @brief Convert a straight-alpha sRGB color to a premultiplied linear pixel
+ * @param color The color
+ * @param rgba Output pixel (4 values)
+ */
+void colorToLinear(const Color& color, uint16_t* rgba);
+
+/**
+ * @brief Blend a span of linear pixels onto a destination span
+ *
+ * Same premultiplied formulas as blendSpan(), on linear values.
+ * The arithmetic is done in single precision, one pixel per SSE register
+ * when available; the scalar fallback does the same operations in the
+ * same order.
+ *
+ * @param dst Destination pixels (modified in place)
+ * @param src Source pixels
+ * @param count Number of pixels
+ * @param opacity Layer opacity (0-255)
+ * @param mode How source and destination colors combine
+ */
+void blendLinearSpan(uint16_t* dst, const uint16_t* src, int count, int opacity,
+                     BlendMode mode);
+
+/**
+ * @brief Mix two linear frames according to a transition
+ *
+ * The linear-light counterpart of applyTransition(); dst may alias from
+ * or to.
+ *
+ * @param from Frame with the outgoing entry
+ * @param to Frame with the incoming entry
+ * @param dst Output frame
+ * @param transition Transition type and dip color
+ * @param progress Position in the transition (0 = all from, 1 = all to)
+ */
+void applyLinearTransition(const LinearFrame& from, const LinearFrame& to,
+                           LinearFrame& dst, const Transition& transition,
+                           double progress);
+
+} // namespace csci3081
+
+#endif // LINEAR_BLEND_H_
@@ -0,0 +1,71 @@
+#ifndef LINEAR_FRAME_H_
+#define LINEAR_FRAME_H_
+
+#include "Image.h"
+#include "graphics/Color.h"
+#include <cstdint>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief How the CPU compositor stores the frame while layers are drawn
+ */
+enum class CompositingMode {
+  GAMMA_8BIT,    // Blend sRGB-encoded 8-bit values (matches the original preview)
+  LINEAR_16BIT   // Blend in linear light with 16 bits per channel
+};
+
+/**
+ * @brief An RGBA frame in linear light with 16 bits per channel
+ *
+ * Color channels hold linear intensity (0 = black, 65535 = white),
+ * premultiplied by alpha, and alpha is scaled to 0-65535. Layers are converted to linear light as they are
+ * drawn, and the frame is converted back to sRGB once when it is done, so
+ * stacking many soft-edged or translucent layers neither darkens edges nor
+ * accumulates 8-bit rounding.
+ */
+class LinearFrame {
+public:
+  LinearFrame() : width(0), height(0) {}
+
+  /**
+   * @brief Create a frame (contents undefined)
+   * @param width Frame width
+   * @param height Frame height
+   */
+  LinearFrame(int width, int height);
+
+  /**
+   * @brief Resize the frame, reallocating only if the size changes
+   * @param width New width
+   * @param height New height
+   */
+  void resize(int width, int height);
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  uint16_t* getData() { return pixels.data(); }
+  const uint16_t* getData() const { return pixels.data(); }
+
+  /**
+   * @brief Fill every pixel with a (straight-alpha) sRGB color
+   * @param color Color to fill with
+   */
+  void fill(const Color& color);
+
+  /**
+   * @brief Convert the frame to a premultiplied 8-bit sRGB image
+   * @param image Image of the same size to write into
+   */
+  void toImage(Image& image) const;
+
+private:
+  int width;
+  int height;
+  std::vector<uint16_t> pixels;
+};
+
+} // namespace csci3081
+
+#endif // LINEAR_FRAME_H_
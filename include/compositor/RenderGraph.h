@@ -0,0 +1,139 @@
+#ifndef RENDER_GRAPH_H_
+#define RENDER_GRAPH_H_
+
+#include "compositor/RenderNode.h"
+#include "Image.h"
+#include <vector>
+
+namespace csci3081 {
+
+class ThreadPool;
+
+/**
+ * @brief A DAG of RenderNodes evaluated lazily from its output
+ *
+ * Evaluating the graph at a time pulls from the output node:
+ * 1. Nodes reachable from the output read their parameters (prepare()),
+ *    skipping inputs they don't need.
+ * 2. Every reached node gets a key from its parameters and its inputs'
+ *    keys. A node whose key matches the one it last computed keeps its
+ *    result, so static parts of a composition are rendered once.
+ * 3. The remaining nodes are grouped into levels by dependency and each
+ *    level is processed on the ThreadPool, so independent branches (the
+ *    layers of different tracks) decode and filter in parallel.
+ *
+ * Once the graph has been evaluated, evaluating it again only allocates
+ * if node output sizes change.
+ */
+class RenderGraph {
+public:
+  RenderGraph();
+  ~RenderGraph();
+
+  /**
+   * @brief Add a node; the graph takes ownership
+   * @param node The node (its inputs must be added to this graph too)
+   * @return The node, for wiring into later nodes
+   */
+  template <typename NodeType>
+  NodeType* addNode(NodeType* node) {
+    nodes.push_back(node);
+    orderValid = false;
+    return node;
+  }
+
+  /**
+   * @brief Set the node whose result is the graph's output
+   * @param node A node in this graph
+   */
+  void setOutput(RenderNode* node);
+
+  /**
+   * @brief Get the output node
+   * @return The output node, or nullptr if not set
+   */
+  RenderNode* getOutput() const { return output; }
+
+  /**
+   * @brief Delete every node
+   */
+  void clear();
+
+  /**
+   * @brief Get the number of nodes
+   * @return Node count
+   */
+  size_t getNodeCount() const { return nodes.size(); }
+
+  /**
+   * @brief Set the pool used to process independent nodes in parallel
+   *
+   * Defaults to ThreadPool::shared(). Pass nullptr to process everything
+   * on the calling thread (required when evaluating from a pool task).
+   *
+   * @param pool The pool, or nullptr
+   */
+  void setThreadPool(ThreadPool* pool) { threadPool = pool; }
+
+  /**
+   * @brief Evaluate the output at a time
+   * @param time Timeline time (in seconds)
+   * @param width Frame width
+   * @param height Frame height
+   * @return The output image, valid until the graph is evaluated again,
+   * modified or destroyed
+   */
+  const Image& evaluate(double time, int width, int height);
+
+  /**
+   * @brief Get the number of nodes processed by the last evaluate()
+   *
+   * Nodes that were up to date or not needed are not counted.
+   *
+   * @return Processed node count
+   */
+  size_t getProcessedCount() const { return processedCount; }
+
+  /**
+   * @brief Get the number of parallel steps in the last evaluate()
+   * @return Number of levels processed
+   */
+  size_t getLevelCount() const { return levelCount; }
+
+  RenderGraph(const RenderGraph&) = delete;
+  RenderGraph& operator=(const RenderGraph&) = delete;
+
+private:
+  std::vector<RenderNode*> nodes;
+  std::vector<RenderNode*> order;     // Inputs before the nodes reading them
+  std::vector<std::vector<RenderNode*> > levels;
+  RenderNode* output;
+  ThreadPool* threadPool;
+  bool orderValid;
+  size_t processedCount;
+  size_t levelCount;
+
+  /**
+   * @brief Sort the nodes topologically and count their consumers
+   */
+  void buildOrder();
+
+  /**
+   * @brief ThreadPool task that processes one node of a level
+   */
+  static void processTask(void* context, int index);
+
+  /**
+   * @brief Process a node and record its result as up to date
+   */
+  static void processNode(RenderNode* node, int width, int height);
+
+  // Frame size of the evaluation in progress, for processTask
+  int width;
+  int height;
+  const std::vector<RenderNode*>* currentLevel;
+};
+
+} // namespace csci3081
+
+#endif // RENDER_GRAPH_H_
@@ -0,0 +1,190 @@
+#ifndef RENDER_NODE_H_
+#define RENDER_NODE_H_
+
+#include "Image.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace csci3081 {
+
+class TransformNode;
+
+/**
+ * @brief Mix a value into a running 64-bit hash
+ * @param seed Hash so far
+ * @param value Value to add
+ * @return Combined hash
+ */
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+  // splitmix64 finalizer over the xor of seed and value
+  uint64_t x = seed ^ (value + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2));
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * @brief Mix a double into a running hash by its bit pattern
+ */
+inline uint64_t hashCombine(uint64_t seed, double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return hashCombine(seed, bits);
+}
+
+/**
+ * @brief Mix a float into a running hash by its bit pattern
+ */
+inline uint64_t hashCombine(uint64_t seed, float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return hashCombine(seed, static_cast<uint64_t>(bits));
+}
+
+/**
+ * @brief A step of a RenderGraph that produces one image
+ *
+ * Nodes are evaluated in two phases by the graph:
+ * - prepare() runs on the graph's thread. The node reads whatever
+ *   parameters it needs at the requested time, decides which inputs it
+ *   needs, and returns a key describing those parameters. Two calls that
+ *   return the same key (with the same input keys) must produce the same
+ *   pixels, so nodes key on the values they use (a static transform gives
+ *   the same key at every time) rather than on the time itself.
+ * - process() computes the pixels. It only runs when the key changed since
+ *   the last time, and may run on a worker thread at the same time as
+ *   nodes from other branches, so it must only touch the node's own state
+ *   and its inputs' results.
+ *
+ * A node's result is either its own buffer or an image owned by someone
+ * else (an asset frame, or an input passed through unchanged).
+ */
+class RenderNode {
+public:
+  RenderNode();
+  virtual ~RenderNode() {}
+
+  /**
+   * @brief Get the nodes this node reads from
+   * @return Input nodes, in the order the node uses them
+   */
+  const std::vector<RenderNode*>& getInputs() const { return inputs; }
+
+  /**
+   * @brief Get the image computed by the last evaluation
+   * @return The node's output (only valid after the graph evaluated it)
+   */
+  const Image& getResult() const { return *result; }
+
+  /**
+   * @brief Get this node as a placement, if it only positions its input
+   *
+   * Blend and transition nodes draw a TransformNode's input straight
+   * through its transform instead of asking it for a full-frame image.
+   *
+   * @return This node as a TransformNode, or nullptr
+   */
+  virtual const TransformNode* asTransform() const { return nullptr; }
+
+  RenderNode(const RenderNode&) = delete;
+  RenderNode& operator=(const RenderNode&) = delete;
+
+protected:
+  /**
+   * @brief Read parameters for a time and decide which inputs are needed
+   * @param time Timeline time being rendered (in seconds)
+   * @param width Output frame width
+   * @param height Output frame height
+   * @return Key of the parameters that affect the output
+   */
+  virtual uint64_t prepare(double time, int width, int height) = 0;
+
+  /**
+   * @brief Check if an input is used by the coming process() call
+   *
+   * Called after prepare(). Inputs that are not needed are not evaluated
+   * at all, so a layer at zero opacity never decodes its source.
+   *
+   * @param index Input index
+   * @return true if the input must be evaluated
+   */
+  virtual bool needsInput(size_t index) const { return true; }
+
+  /**
+   * @brief Compute the output from the inputs' results
+   * @param width Output frame width
+   * @param height Output frame height
+   */
+  virtual void process(int width, int height) = 0;
+
+  /**
+   * @brief Add an input; inputs can only be added while building the graph
+   * @param input Node whose result this node reads
+   */
+  void addInput(RenderNode* input) { inputs.push_back(input); }
+
+  /**
+   * @brief Get an input's result
+   * @param index Input index
+   * @return The input image
+   */
+  const Image& input(size_t index) const { return inputs[index]->getResult(); }
+
+  /**
+   * @brief Make the node's own buffer the result
+   *
+   * The buffer is only reallocated when the size changes. Its contents are
+   * whatever the last evaluation left there.
+   *
+   * @param width Buffer width
+   * @param height Buffer height
+   * @return The buffer to write into
+   */
+  Image& ownResult(int width, int height);
+
+  /**
+   * @brief Use an image owned by someone else as the result
+   * @param image Image that outlives this evaluation
+   */
+  void setResult(const Image& image) { result = &image; }
+
+  /**
+   * @brief Take an input's buffer as this node's result, if it is safe
+   *
+   * An input that was recomputed in this evaluation, has no other reader
+   * and owns its buffer can hand that buffer over, so chains of blends
+   * draw in place instead of copying the frame at every step. The input
+   * has to be recomputed the next time it is needed; if it then turns out
+   * not to have changed, the graph stops letting it be taken so it stays
+   * memoized.
+   *
+   * @param index Input index
+   * @return true if the buffer (holding the input's result) is now this
+   * node's result
+   */
+  bool takeInput(size_t index);
+
+private:
+  friend class RenderGraph;
+
+  std::vector<RenderNode*> inputs;
+  Image buffer;
+  const Image* result;
+
+  // Bookkeeping owned by the RenderGraph
+  uint64_t key;
+  uint64_t cachedKey;
+  bool cached;      // buffer/result hold the output for cachedKey
+  bool needed;      // Reached from the output in this evaluation
+  bool required;    // Must be processed in this evaluation
+  bool processed;   // Was processed in this evaluation
+  bool donated;     // Buffer was taken by a reader since it was processed
+  bool pinned;      // Output is reused between evaluations; never taken
+  int level;        // Scheduling level (longest chain of required inputs)
+  int consumers;    // Nodes (and the graph output) reading this node
+};
+
+} // namespace csci3081
+
+#endif // RENDER_NODE_H_
@@ -0,0 +1,274 @@
+#ifndef RENDER_NODES_H_
+#define RENDER_NODES_H_
+
+#include "compositor/RenderNode.h"
+#include "compositor/Blend.h"
+#include "compositor/LinearFrame.h"
+#include "filters/IFilter.h"
+#include "graphics/Color.h"
+#include "timeline/EntryTransform.h"
+#include "timeline/TimelineEntry.h"
+#include "timeline/Transition.h"
+#include <memory>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief Frame filled with a solid color
+ *
+ * The color is read on every evaluation, so changing it does not require
+ * rebuilding the graph.
+ */
+class BackgroundNode : public RenderNode {
+public:
+  /**
+   * @param color Color to fill with (must outlive the node)
+   */
+  explicit BackgroundNode(const Color& color);
+
+protected:
+  uint64_t prepare(double time, int width, int height) override;
+  void process(int width, int height) override;
+
+private:
+  const Color& color;
+};
+
+/**
+ * @brief The frame of a timeline entry's asset
+ *
+ * Static assets (images, text) give the same key at every time, so they
+ * are only read once. The asset's own frame is used as the result without
+ * copying, unless the asset is shared with another SourceNode: an asset
+ * only holds one decoded frame, so every node sharing it copies its frame
+ * and the nodes decode one after the other.
+ */
+class SourceNode : public RenderNode {
+public:
+  /**
+   * @param entry Entry to read frames from (must outlive the node)
+   * @param previousUse Earlier SourceNode for the same asset, or nullptr
+   */
+  explicit SourceNode(const TimelineEntry* entry, SourceNode* previousUse = nullptr);
+
+  const TimelineEntry* getEntry() const { return entry; }
+
+protected:
+  uint64_t prepare(double time, int width, int height) override;
+  void process(int width, int height) override;
+
+private:
+  const TimelineEntry* entry;
+  double localTime;
+  bool copyFrames;
+};
+
+/**
+ * @brief Applies a CPU filter to its input
+ *
+ * Filters are pure functions of their input, so a filtered still image is
+ * only computed once. The same filter object may be applied by several
+ * nodes from different threads at once.
+ */
+class FilterNode : public RenderNode {
+public:
+  /**
+   * @param input Node to filter
+   * @param filter The filter to apply
+   */
+  FilterNode(RenderNode* input, const std::shared_ptr<IFilter>& filter);
+
+protected:
+  uint64_t prepare(double time, int width, int height) override;
+  void process(int width, int height) override;
+
+private:
+  std::shared_ptr<IFilter> filter;
+};
+
+/**
+ * @brief Places its input in the frame through an EntryTransform
+ *
+ * On its own the node renders the placed layer over transparency. When a
+ * BlendNode or TransitionNode reads it, they draw the input directly
+ * through the transform instead, so no intermediate frame is made.
+ */
+class TransformNode : public RenderNode {
+public:
+  /**
+   * @brief Place the input with an entry's (possibly animated) transform
+   * @param input Layer to place
+   * @param entry Entry whose transform is used (must outlive the node)
+   */
+  TransformNode(RenderNode* input, const TimelineEntry* entry);
+
+  /**
+   * @brief Place the input with a fixed transform
+   * @param input Layer to place
+   * @param transform Placement of the layer
+   */
+  TransformNode(RenderNode* input, const EntryTransform& transform);
+
+  /**
+   * @brief Get the placement at a time
+   * @param time Timeline time (in seconds)
+   * @return The transform
+   */
+  EntryTransform transformAt(double time) const;
+
+  /**
+   * @brief Get the node being placed
+   * @return The input layer
+   */
+  RenderNode* getLayer() const { return getInputs()[0]; }
+
+  const TransformNode* asTransform() const override { return this; }
+
+protected:
+  uint64_t prepare(double time, int width, int height) override;
+  void process(int width, int height) override;
+
+private:
+  const TimelineEntry* entry;
+  EntryTransform transform;
+};
+
+/**
+ * @brief Draws a layer over a frame with a blend mode
+ *
+ * A layer at zero opacity is skipped without evaluating it, and the frame
+ * below is passed through unchanged.
+ */
+class BlendNode : public RenderNode {
+public:
+  /**
+   * @param below Frame-sized image to draw onto
+   * @param layer Layer to draw (a TransformNode places it)
+   * @param mode How the layer combines with the frame
+   */
+  BlendNode(RenderNode* below, RenderNode* layer, BlendMode mode);
+
+protected:
+  uint64_t prepare(double time, int width, int height) override;
+  bool needsInput(size_t index) const override;
+  void process(int width, int height) override;
+
+private:
+  const TransformNode* placement;
+  BlendMode mode;
+  EntryTransform transform;
+};
+
+/**
+ * @brief Draws a transition between two layers over a frame
+ *
+ * Each layer is drawn over the frame below, then the two whole frames are
+ * mixed by applyTransition(). Outside the transition window the frame
+ * below is passed through.
+ */
+class TransitionNode : public RenderNode {
+public:
+  /**
+   * @param below Frame-sized image to draw onto
+   * @param fromLayer Outgoing layer (a TransformNode places it)
+   * @param toLayer Incoming layer (a TransformNode places it)
+   * @param from Outgoing entry, which holds the transition
+   * @param to Incoming entry
+   * @param mode How the layers combine with the frame
+   */
+  TransitionNode(RenderNode* below, RenderNode* fromLayer, RenderNode* toLayer,
+                 const TimelineEntry* from, const TimelineEntry* to,
+                 BlendMode mode);
+
+protected:
+  uint64_t prepare(double time, int width, int height) override;
+  bool needsInput(size_t index) const override;
+  void process(int width, int height) override;
+
+private:
+  const TransformNode* fromPlacement;
+  const TransformNode* toPlacement;
+  const TimelineEntry* from;
+  const TimelineEntry* to;
+  BlendMode mode;
+
+  // Parameters read by prepare()
+  bool active;
+  Transition transition;
+  double progress;
+  EntryTransform fromTransform;
+  EntryTransform toTransform;
+
+  Image incoming;   // Scratch frame for the incoming side
+};
+
+/**
+ * @brief Composites a stack of layers in linear light
+ *
+ * Used by CompositingMode::LINEAR_16BIT. Where a chain of BlendNodes keeps
+ * an 8-bit frame between layers, this node draws the background and every
+ * layer (and transition) into one 16-bit LinearFrame and converts it back
+ * to sRGB once at the end. Layers at zero opacity and transitions that are
+ * not running are not evaluated, as with BlendNode and TransitionNode.
+ */
+class LinearCompositeNode : public RenderNode {
+public:
+  /**
+   * @param background Color under all layers (must outlive the node)
+   */
+  explicit LinearCompositeNode(const Color& background);
+
+  /**
+   * @brief Draw a layer over everything added so far
+   * @param layer Layer to draw (a TransformNode places it)
+   * @param mode How the layer combines with the frame
+   */
+  void addLayer(RenderNode* layer, BlendMode mode);
+
+  /**
+   * @brief Draw a transition between two layers over everything added so far
+   * @param fromLayer Outgoing layer (a TransformNode places it)
+   * @param toLayer Incoming layer (a TransformNode places it)
+   * @param from Outgoing entry, which holds the transition
+   * @param to Incoming entry
+   * @param mode How the layers combine with the frame
+   */
+  void addTransition(RenderNode* fromLayer, RenderNode* toLayer,
+                     const TimelineEntry* from, const TimelineEntry* to,
+                     BlendMode mode);
+
+protected:
+  uint64_t prepare(double time, int width, int height) override;
+  bool needsInput(size_t index) const override;
+  void process(int width, int height) override;
+
+private:
+  /**
+   * @brief A layer, or both sides of a transition
+   */
+  struct Step {
+    const TransformNode* placement[2];
+    size_t input;                // Index of the first layer's input
+    const TimelineEntry* from;   // nullptr for a plain layer
+    const TimelineEntry* to;
+    BlendMode mode;
+
+    // Parameters read by prepare()
+    bool active;
+    Transition transition;
+    double progress;
+    EntryTransform transform[2];
+  };
+
+  const Color& background;
+  std::vector<Step> steps;
+  std::vector<size_t> inputSteps;   // Index of the step drawing each input
+
+  LinearFrame frame;
+  LinearFrame incoming;   // Scratch frame for the incoming side of transitions
+};
+
+} // namespace csci3081
+
+#endif // RENDER_NODES_H_
@@ -0,0 +1,58 @@
+#ifndef TRANSITION_BLEND_H_
+#define TRANSITION_BLEND_H_
+
+#include "Image.h"
+#include "graphics/Color.h"
+#include "timeline/Transition.h"
+
+namespace csci3081 {
+
+/**
+ * @brief Linearly interpolate two spans of RGBA pixels
+ *
+ * dst = from * (256 - weight) / 256 + to * weight / 256, on all four
+ * channels, which is a correct mix of premultiplied pixels. Uses SSE2 when available; dst may alias from or to.
+ *
+ * @param dst Output pixels
+ * @param from Pixels at weight 0
+ * @param to Pixels at weight 256
+ * @param count Number of pixels
+ * @param weight Interpolation weight (0-256)
+ */
+void lerpSpan(unsigned char* dst, const unsigned char* from,
+              const unsigned char* to, int count, int weight);
+
+/**
+ * @brief Linearly interpolate a span of pixels towards a solid color
+ * @param dst Output pixels (may alias from)
+ * @param from Pixels at weight 0
+ * @param color Color at weight 256 (straight alpha; premultiplied here)
+ * @param count Number of pixels
+ * @param weight Interpolation weight (0-256)
+ */
+void lerpSpanToColor(unsigned char* dst, const unsigned char* from,
+                     const Color& color, int count, int weight);
+
+/**
+ * @brief Mix two composited frames according to a transition
+ *
+ * from and to are the frame with the outgoing and incoming entry drawn
+ * over everything below, so the transition mixes whole frames and never
+ * has to deal with transparency. All three images must be the same size;
+ * dst may alias from or to.
+ *
+ * The wipe edge is placed where the TrackShader puts it, so the preview
+ * and exports match.
+ *
+ * @param from Frame with the outgoing entry
+ * @param to Frame with the incoming entry
+ * @param dst Output frame
+ * @param transition Transition type and dip color
+ * @param progress Position in the transition (0 = all from, 1 = all to)
+ */
+void applyTransition(const Image& from, const Image& to, Image& dst,
+                     const Transition& transition, double progress);
+
+} // namespace csci3081
+
+#endif // TRANSITION_BLEND_H_
@@ -0,0 +1,67 @@
+#ifndef ENCODER_SETTINGS_H_
+#define ENCODER_SETTINGS_H_
+
+#include "export/YuvFrame.h"
+#include <string>
+
+namespace csci3081 {
+
+/**
+ * @brief How an encoder decides how many bits each frame gets
+ */
+enum class RateControl {
+  CONSTANT_QUALITY,   // crf: the same quality throughout, the bit rate follows the content
+  VBR,                // Average bitRate, peaks up to maxBitRate
+  CBR                 // Constant bitRate, for streaming
+};
+
+/**
+ * @brief Video encoder settings of an export
+ *
+ * Which encoder is used and how. Whether the local FFmpeg has the encoder
+ * and supports these settings is only known when exporting
+ * (VideoWriterSink::checkSettings()); check() catches settings that
+ * make no sense for any encoder.
+ */
+struct EncoderSettings {
+  std::string codec;      // FFmpeg encoder name, e.g. "libx264", "libx265", "libvpx-vp9"
+  std::string preset;     // Speed preset, "ultrafast" to "veryslow" for x264; empty for none
+  std::string tune;       // e.g. "film" or "animation"; empty for none
+  int threads;            // Encoder threads, 0 to let the encoder choose
+  int keyframeInterval;   // Frames from one keyframe to the next
+  int bFrames;            // Most B-frames in a row (encoders without them use none)
+  RateControl rateControl;
+  int crf;                // CONSTANT_QUALITY: lower is better, 23 is x264's default
+  int bitRate;            // VBR and CBR: kbit/s
+  int maxBitRate;         // VBR: peak kbit/s, 0 for no limit
+  bool twoPass;           // VBR and CBR: analyse the whole video before encoding it
+  YuvFormat yuvFormat;    // Matrix and range frames are converted to and tagged with
+
+  EncoderSettings()
+    : codec("libx264"), preset("medium"), threads(0), keyframeInterval(12), bFrames(2),
+      rateControl(RateControl::CONSTANT_QUALITY), crf(23), bitRate(2000), maxBitRate(0),
+      twoPass(false) {}
+
+  /**
+   * @brief Settings for quick previews: the fastest preset, lower quality
+   * @return The settings
+   */
+  static EncoderSettings draft();
+
+  /**
+   * @brief Settings for final renders: a slow preset, near transparent quality
+   * @return The settings
+   */
+  static EncoderSettings master();
+
+  /**
+   * @brief Check that the settings are consistent
+   * @param error Receives what is wrong, if anything
+   * @return true if any encoder could be asked to use them
+   */
+  bool check(std::string& error) const;
+};
+
+} // namespace csci3081
+
+#endif // ENCODER_SETTINGS_H_
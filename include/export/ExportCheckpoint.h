@@ -0,0 +1,178 @@
+#ifndef EXPORT_CHECKPOINT_H_
+#define EXPORT_CHECKPOINT_H_
+
+#include "assets/IAsset.h"
+#include "export/EncoderSettings.h"
+#include "export/SegmentedExport.h"
+#include "timeline/Timebase.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+class Timeline;
+
+/**
+ * @brief Records which segments of a segmented export are finished
+ *
+ * The manifest is a small JSON file next to the output. It holds a key
+ * identifying what is exported (see makeKey()), the segment plan and the
+ * segments whose part files are complete, and is rewritten, by replacing
+ * the whole file, each time a segment finishes. An export that dies part
+ * way through can be run again with the same key and plan, and only the
+ * segments not yet finished are rendered before the parts are joined.
+ *
+ * Every segment is a separate encode that starts with a keyframe and
+ * refers to no frame outside it (a closed GOP), so finished parts never
+ * need re-encoding.
+ */
+class ExportCheckpoint {
+public:
+  /**
+   * @brief Seconds of video in each segment of a checkpointed export
+   *
+   * At most this much per worker is rendered again after a restart.
+   */
+  static const int SEGMENT_SECONDS = 30;
+
+  /**
+   * @brief Create a checkpoint stored in a file
+   * @param path Manifest file, e.g. "<output>.manifest"
+   */
+  explicit ExportCheckpoint(const std::string& path);
+
+  /**
+   * @brief Start or resume an export
+   *
+   * If the manifest has the same key and plan, the segments it lists as
+   * finished stay finished. Otherwise it is started afresh.
+   *
+   * @param key Identifies what is exported
+   * @param plan The segments, in order
+   * @return false if the manifest could not be written
+   */
+  bool begin(const std::string& key, const std::vector<ExportSegment>& plan);
+
+  /**
+   * @brief Check if a segment was finished, now or by an earlier run
+   * @param segment A segment of the plan
+   * @return true if its part file is complete
+   */
+  bool isDone(const ExportSegment& segment) const;
+
+  /**
+   * @brief Record that a segment's part file is complete
+   *
+   * May be called from several threads at once.
+   *
+   * @param segment A segment of the plan
+   * @return false if the manifest could not be written
+   */
+  bool markDone(const ExportSegment& segment);
+
+  /**
+   * @brief Count the frames of the finished segments
+   * @return Frames in segments isDone() is true for
+   */
+  int64_t getDoneFrames() const;
+
+  /**
+   * @brief Delete the manifest, once the output is complete
+   */
+  void finish();
+
+  /**
+   * @brief Get the manifest's path
+   * @return The file given to the constructor
+   */
+  const std::string& getPath() const { return path; }
+
+  /**
+   * @brief Get the last error message
+   * @return String describing the last error, or empty if no error
+   */
+  std::string getLastError() const;
+
+  /**
+   * @brief Split an export into segments of about SEGMENT_SECONDS each
+   *
+   * The plan depends only on its arguments, never on the machine, so a
+   * restarted export plans the same segments.
+   *
+   * @param frameCount Frames in the export
+   * @param gopSize Frames per GOP (the keyframe interval)
+   * @param rate Frames per second
+   * @return Segments in order, each starting a GOP
+   */
+  static std::vector<ExportSegment> planSegments(int64_t frameCount, int gopSize,
+                                                 const Rational& rate);
+
+  /**
+   * @brief Identify what an export of a timeline renders
+   *
+   * The key is a hash of the timeline as a project file holds it, each
+   * asset's source (see describeSource()), the frame size and rate, and
+   * the encoder settings. Editing the timeline, replacing a source file
+   * or changing a setting gives another key.
+   *
+   * @param timeline The timeline
+   * @param sources What each asset on the timeline was created from
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param encoder Encoder settings
+   * @param key Receives the key
+   * @return false if the timeline can't be identified: an asset has no
+   *         source, or a track has CPU filters, which are not saved
+   */
+  static bool makeKey(const Timeline& timeline, const std::map<IAsset*, std::string>& sources,
+                      int width, int height, const Rational& rate,
+                      const EncoderSettings& encoder, std::string& key);
+
+  /**
+   * @brief Describe the frame size, rate and encoder settings a key covers
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param encoder Encoder settings
+   * @return Text that differs whenever any of them do
+   */
+  static std::string describeOutput(int width, int height, const Rational& rate,
+                                    const EncoderSettings& encoder);
+
+  /**
+   * @brief Describe the version of an asset's source a key covers
+   *
+   * A file written again since, even with the same size, is described
+   * differently: its modification time is part of it.
+   *
+   * @param source What the asset was created from
+   * @return Its name, and its file's size and modification time if it is a file
+   */
+  static std::string describeSource(const std::string& source);
+
+  ExportCheckpoint(const ExportCheckpoint&) = delete;
+  ExportCheckpoint& operator=(const ExportCheckpoint&) = delete;
+
+private:
+  std::string path;
+  std::string key;
+  std::vector<ExportSegment> plan;
+  std::set<int> done;             // Indices of finished segments
+  mutable std::mutex mutex;       // Guards done, lastError and the file
+  std::string lastError;
+
+  /**
+   * @brief Write the manifest (the mutex must be held)
+   * @return false if it could not be written
+   */
+  bool save();
+};
+
+} // namespace csci3081
+
+#endif // EXPORT_CHECKPOINT_H_
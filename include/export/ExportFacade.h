@@ -3,11 +3,17 @@
 
 #include "Image.h"
 #include "assets/IAsset.h"
+#include "assets/IAssetFactory.h"
+#include "export/EncoderSettings.h"
+#include "export/PngEncoder.h"
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace csci3081 {
 
+class ExportMonitor;
+
 /**
  * @brief Supported export formats
  */
@@ -16,7 +22,9 @@ enum class ExportFormat {
   JPEG,
   BMP,
   PPM,
-  MP4
+  MP4,
+  Y4M,    // Uncompressed YUV4MPEG2 stream (see FrameServerSink)
+  RAW     // Uncompressed YUV 4:2:0 planes with no headers
 };
 
 /**
@@ -27,10 +35,23 @@ struct ExportSettings {
   int quality;        // 0-100 for JPEG, ignored for other formats
   int width;          // Output width, -1 to keep original
   int height;         // Output height, -1 to keep original
-  double frameRate;   // For video exports only
+  double frameRate;   // For video exports only; 29.97 and 23.976 are NTSC's x/1.001 rates
+  int segments;       // Timeline videos: segments encoded in parallel, 1 for a
+                      // single encoder, 0 for one per two cores
+  bool smartRender;   // Timeline videos: copy untouched H.264 spans, re-encode the rest
+  bool imageSequence; // Timelines in an image format: write every frame as a
+                      // numbered file instead of only the first frame
+  bool resumable;     // Timeline videos: keep finished segments and a manifest,
+                      // so the same export run again renders only what is missing
+  bool incremental;   // Timeline videos: copy the segments an edit didn't change
+                      // from the last export to the same file
+  EncoderSettings encoder;   // For video exports only
+  PngSettings png;           // For PNG exports only
 
   ExportSettings()
-    : format(ExportFormat::PNG), quality(90), width(-1), height(-1), frameRate(30.0) {}
+    : format(ExportFormat::PNG), quality(90), width(-1), height(-1), frameRate(30.0),
+      segments(1), smartRender(true), imageSequence(false),
+      resumable(false), incremental(false) {}
 };
 
 /**
@@ -85,6 +106,43 @@ public:
 
   /**
    * @brief Export a timeline as a video by rendering each frame
+   *
+   * Frames are streamed to the encoder through an ExportPipeline, so memory
+   * use does not grow with the length of the timeline. With
+   * settings.segments other than 1, a SegmentedExport encodes GOP-aligned
+   * segments in parallel and joins them; the video has the same frames.
+   * With settings.smartRender, spans that show one untouched H.264 video
+   * (see planSmartRender()) are copied from it without re-encoding, and
+   * only the frames around them are rendered. A two-pass encode
+   * (settings.encoder.twoPass) renders every frame twice in one encoder,
+   * so it is never split or copied.
+   *
+   * With settings.resumable, the video is encoded as segments of
+   * ExportCheckpoint::SEGMENT_SECONDS, and "<filename>.manifest" and the
+   * finished part files are kept until the segments are joined. If the
+   * export stops part way, exporting the same timeline with the same
+   * settings to the same file renders only the segments not finished.
+   *
+   * With settings.incremental, the video is encoded as segments of the
+   * same length, and "<filename>.segments" indexes them by what they show
+   * (see SegmentCache). Exporting to the same file again copies every
+   * segment an edit didn't change from the earlier video and renders only
+   * the rest; the share of frames reused is reported.
+   *
+   * The export renders a snapshot with its own copy of each video that
+   * has a source, so it may run on another thread while the editor keeps
+   * editing and playing the timeline. A video that fails or is cancelled
+   * is deleted.
+   *
+   * Y4M and RAW stream every frame uncompressed through an ExportPipeline
+   * into a FrameServerSink, to stdout if filename is "-" or to a file or
+   * named pipe, at the speed the reader takes them. A stream that fails
+   * is not deleted (it may be a pipe).
+   *
+   * In an image format the timeline's first frame is exported, or with
+   * settings.imageSequence every frame as numbered files (see
+   * ImageSequenceExport), encoded on every core.
+   *
    * @param timeline The timeline to export
    * @param filename Output filename (should have .mp4 extension)
    * @param settings Export settings (frameRate is important)
@@ -92,18 +150,58 @@ public:
    * @param height Height of output video
    * @return true if export succeeded, false otherwise
    */
-  bool exportTimeline(class Timeline* timeline,
+  bool exportTimeline(const class Timeline* timeline,
                       const std::string& filename,
                       const ExportSettings& settings,
                       int width,
                       int height);
 
+  /**
+   * @brief Say where the editor's assets came from
+   *
+   * Segmented exports give every segment its own copy of each video, made
+   * from its source, so segments never share a decoder. Without sources a
+   * timeline with video is exported as one segment.
+   *
+   * @param factory Creates assets from their sources (not owned)
+   * @param assets The editor's assets (not owned, read at export time)
+   * @param sources What each of assets was created from (not owned)
+   */
+  void setAssetSources(const IAssetFactory* factory, const std::vector<IAsset*>* assets,
+                       const std::vector<std::string>* sources);
+
+  /**
+   * @brief Copy the asset lists given to setAssetSources() now
+   *
+   * A facade that exports on another thread must not read the editor's
+   * lists while the editor adds to them. Copies of the facade made
+   * afterwards share the frozen lists.
+   */
+  void freezeAssetSources();
+
+  /**
+   * @brief Report the progress of video exports to a monitor
+   *
+   * exportVideo() and exportTimeline() start the monitor, count the frames
+   * they write and stop early, failing with "Export cancelled", once it is
+   * cancelled.
+   *
+   * @param monitor The monitor (not owned), or nullptr for none
+   */
+  void setMonitor(ExportMonitor* monitor) { this->monitor = monitor; }
+
   /**
    * @brief Get the last error message
    * @return String describing the last error, or empty if no error
    */
   std::string getLastError() const { return lastError; }
 
+  /**
+   * @brief List the encoders videos can be exported with
+   * @return FFmpeg encoder names for ExportSettings::encoder.codec
+   */
+  static std::vector<std::string> getAvailableEncoders();
+
   /**
    * @brief Check if a filename has a valid extension for the given format
    * @param filename The filename to check
@@ -121,6 +219,20 @@ public:
 
 private:
   std::string lastError;
+  const IAssetFactory* assetFactory;
+  const std::vector<IAsset*>* assets;
+  const std::vector<std::string>* assetSources;
+  std::shared_ptr<const std::vector<IAsset*> > frozenAssets;
+  std::shared_ptr<const std::vector<std::string> > frozenSources;
+  ExportMonitor* monitor;
+
+  /**
+   * @brief Record why a video export failed and delete what it wrote
+   * @param filename The unfinished video
+   * @param error What went wrong (replaced if the export was cancelled)
+   * @return false
+   */
+  bool failVideo(const std::string& filename, const std::string& error);
 
   /**
    * @brief Resize an image if needed based on settings
@@ -132,22 +244,16 @@ private:
 
   /**
    * @brief Convert image format if needed
+   *
+   * Premultiplied frames are converted to straight alpha for formats that
+   * store alpha (see formatKeepsAlpha()); ImageSequenceExport does the
+   * same to each frame it writes.
+   *
    * @param image Input image
    * @param targetFormat Target format
-   * @return Converted image, or copy of original if no conversion needed
+   * @return Converted image (caller owns it)
    */
   Image* convertFormat(const Image& image, ExportFormat targetFormat);
-
-  /**
-   * @brief Write image to file using STB library
-   * @param image The image to write
-   * @param filename Output filename
-   * @param format Output format
-   * @param quality JPEG quality (ignored for other formats)
-   * @return true if write succeeded, false otherwise
-   */
-  bool writeImageFile(const Image& image, const std::string& filename,
-                      ExportFormat format, int quality);
 };
 
 } // namespace csci3081
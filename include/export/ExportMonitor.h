@@ -0,0 +1,97 @@
+#ifndef EXPORT_MONITOR_H_
+#define EXPORT_MONITOR_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace csci3081 {
+
+/**
+ * @brief How far an export has got
+ */
+struct ExportProgress {
+  int64_t framesDone;      // Frames encoded or copied so far
+  int64_t frameCount;      // Frames the export will write, 0 if not known yet
+  double elapsedSeconds;   // Since the export started
+
+  ExportProgress() : framesDone(0), frameCount(0), elapsedSeconds(0.0) {}
+
+  /**
+   * @brief Get the part of the export that is done
+   * @return 0 to 1, 0 if the frame count isn't known
+   */
+  double getFraction() const;
+
+  /**
+   * @brief Get the average speed so far
+   * @return Frames per second, 0 before the first frame
+   */
+  double getFramesPerSecond() const;
+
+  /**
+   * @brief Estimate the time left at the average speed so far
+   * @return Seconds, or -1 if there is nothing to estimate from yet
+   */
+  double getSecondsRemaining() const;
+};
+
+/**
+ * @brief Progress and cancellation shared by an export and whoever started it
+ *
+ * The export counts frames as it writes them and checks isCancelled()
+ * between frames; any other thread can read the progress or cancel. A
+ * cancelled export stops at the next frame, removes what it had written
+ * and fails with "Export cancelled".
+ *
+ * Design Pattern: Observer (the export is the subject, polled through
+ * getProgress())
+ */
+class ExportMonitor {
+public:
+  ExportMonitor();
+
+  /**
+   * @brief Start counting an export (called by the export)
+   *
+   * Resets the count and the clock, but not a cancel() that came first.
+   *
+   * @param frameCount Frames it will write, counting every pass
+   */
+  void start(int64_t frameCount);
+
+  /**
+   * @brief Count frames that were written (called by the export)
+   * @param frames Number of frames
+   */
+  void addFrames(int64_t frames) { framesDone += frames; }
+
+  /**
+   * @brief Ask the export to stop
+   */
+  void cancel() { cancelled = true; }
+
+  /**
+   * @brief Check whether the export was asked to stop
+   * @return true after cancel()
+   */
+  bool isCancelled() const { return cancelled; }
+
+  /**
+   * @brief Get the progress so far
+   * @return Frames done and time taken
+   */
+  ExportProgress getProgress() const;
+
+  ExportMonitor(const ExportMonitor&) = delete;
+  ExportMonitor& operator=(const ExportMonitor&) = delete;
+
+private:
+  std::atomic<int64_t> framesDone;
+  std::atomic<int64_t> frameCount;
+  std::atomic<int64_t> startNanoseconds;   // steady_clock time of start(), 0 before
+  std::atomic<bool> cancelled;
+};
+
+} // namespace csci3081
+
+#endif // EXPORT_MONITOR_H_
@@ -0,0 +1,154 @@
+#ifndef EXPORT_PIPELINE_H_
+#define EXPORT_PIPELINE_H_
+
+#include "export/IFrameSink.h"
+#include "timeline/Timebase.h"
+#include <cstdint>
+#include <string>
+
+namespace csci3081 {
+
+class ExportMonitor;
+class Timeline;
+class ThreadPool;
+
+/**
+ * @brief What one pipeline stage did during an export
+ */
+struct StageStats {
+  int64_t frames;        // Frames the stage finished
+  double busySeconds;    // Time spent working on frames
+  double waitSeconds;    // Time blocked on its input or output queue
+
+  StageStats() : frames(0), busySeconds(0.0), waitSeconds(0.0) {}
+
+  /**
+   * @brief Get how fast the stage runs when it isn't waiting
+   * @return Frames per second of busy time, 0 if it did nothing
+   */
+  double getFramesPerSecond() const {
+    return busySeconds > 0.0 ? frames / busySeconds : 0.0;
+  }
+};
+
+/**
+ * @brief Counters for a whole export
+ */
+struct PipelineStats {
+  StageStats render;
+  StageStats convert;
+  StageStats encode;
+  int frameBuffers;       // RGBA and YUV buffers allocated (of each)
+  double elapsedSeconds;  // Wall time of run()
+
+  PipelineStats() : frameBuffers(0), elapsedSeconds(0.0) {}
+};
+
+/**
+ * @brief Streams a timeline through render, convert and encode stages
+ *
+ * Each stage runs on its own thread (encoding on the caller's) and hands
+ * frames to the next through a BoundedQueue, so rendering frame n+2,
+ * converting frame n+1 and encoding frame n overlap. The stages pass a
+ * fixed pool of frame buffers around instead of allocating, so peak memory
+ * is queueCapacity + 2 RGBA frames and as many YUV frames, however long
+ * the export is.
+ *
+ * Design Pattern: Pipes and Filters
+ */
+class ExportPipeline {
+public:
+  static const int DEFAULT_QUEUE_CAPACITY = 3;
+
+  /**
+   * @brief Create a pipeline
+   * @param queueCapacity Frames that may wait between two stages
+   */
+  explicit ExportPipeline(int queueCapacity = DEFAULT_QUEUE_CAPACITY);
+
+  /**
+   * @brief Render every frame of a timeline into a sink
+   *
+   * Frame n shows the timeline at frameToTicks(n, rate), as in every other
+   * export. The timeline must not change during the call; export a
+   * Timeline::snapshot() of the one being edited.
+   *
+   * @param timeline Timeline to export
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param sink Receives the frames in order
+   * @return true if every frame was written and the sink closed cleanly
+   */
+  bool run(const Timeline& timeline, int width, int height, const Rational& rate,
+           IFrameSink& sink);
+
+  /**
+   * @brief Render a range of a timeline's frames into a sink
+   *
+   * The sink receives frames firstFrame to firstFrame + frameCount - 1 of
+   * the export, showing the same pictures run() would give them.
+   *
+   * @param timeline Timeline to export
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param sink Receives the frames in order
+   * @param firstFrame Index of the first frame to render
+   * @param frameCount Number of frames to render
+   * @return true if every frame was written and the sink closed cleanly
+   */
+  bool run(const Timeline& timeline, int width, int height, const Rational& rate,
+           IFrameSink& sink, int64_t firstFrame, int64_t frameCount);
+
+  /**
+   * @brief Set the threads the convert stage shares each frame's rows between
+   *
+   * Defaults to ThreadPool::shared(). Pipelines that already run side by
+   * side, one per thread, convert on their own thread instead.
+   *
+   * @param pool The pool, or nullptr to convert on the stage's thread only
+   */
+  void setConvertPool(ThreadPool* pool) { convertPool = pool; }
+
+  /**
+   * @brief Report each written frame to a monitor, and stop when it is cancelled
+   *
+   * The pipeline only counts frames: whoever runs it calls start() on the
+   * monitor.
+   *
+   * @param monitor The monitor (not owned), or nullptr for none
+   */
+  void setMonitor(ExportMonitor* monitor) { this->monitor = monitor; }
+
+  /**
+   * @brief Count the frames an export of a timeline has
+   * @param timeline The timeline
+   * @param rate Frames per second
+   * @return Frames up to the end of the last entry, 0 if there are none
+   */
+  static int64_t getFrameCount(const Timeline& timeline, const Rational& rate);
+
+  /**
+   * @brief Get the counters of the last run()
+   * @return Per-stage counters
+   */
+  const PipelineStats& getStats() const { return stats; }
+
+  /**
+   * @brief Get the last error message
+   * @return String describing the last error, or empty if no error
+   */
+  std::string getLastError() const { return lastError; }
+
+private:
+  int queueCapacity;
+  ThreadPool* convertPool;
+  ExportMonitor* monitor;
+  PipelineStats stats;
+  std::string lastError;
+};
+
+} // namespace csci3081
+
+#endif // EXPORT_PIPELINE_H_
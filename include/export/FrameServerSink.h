@@ -0,0 +1,104 @@
+#ifndef FRAME_SERVER_SINK_H_
+#define FRAME_SERVER_SINK_H_
+
+#include "export/ExportFacade.h"
+#include "export/IFrameSink.h"
+#include <cstdio>
+#include <string>
+
+namespace csci3081 {
+
+class ExportMonitor;
+
+/**
+ * @brief Streams uncompressed frames to stdout, a named pipe or a file
+ *
+ * For tools that read the editor's frames directly instead of decoding a
+ * video. ExportFormat::Y4M writes a YUV4MPEG2 stream: a header line with
+ * the size, rate, chroma siting and range, then "FRAME\n" and the Y, U
+ * and V planes of each frame. ExportFormat::RAW writes only the planes,
+ * as FFmpeg's rawvideo yuv420p reads them.
+ *
+ * Nothing is encoded and nothing is copied: each plane goes to the
+ * destination straight from the pipeline's frame. Writes to a pipe wait
+ * while the reader is behind, and since the pipeline's queues are
+ * bounded, rendering waits for it too. Waiting for a named pipe's reader
+ * to open it, or for a reader to catch up, ends when the export is
+ * cancelled (see setMonitor()).
+ *
+ * A reader that exits early fails the export with "Broken pipe" rather
+ * than stopping the editor with SIGPIPE, which is ignored while the sink
+ * is open. Only one sink streams to stdout at a time, and the export
+ * code prints its messages to stderr so they stay out of the stream.
+ */
+class FrameServerSink : public IFrameSink {
+public:
+  /**
+   * @brief Create a sink for a destination
+   * @param destination "-" for stdout, otherwise a file or named pipe
+   *        (opening a pipe waits for its reader)
+   * @param format ExportFormat::Y4M or ExportFormat::RAW
+   * @param yuvFormat The matrix and range to convert frames to
+   */
+  FrameServerSink(const std::string& destination, ExportFormat format,
+                  const YuvFormat& yuvFormat = YuvFormat());
+  ~FrameServerSink() override;
+
+  bool open(int width, int height, const Rational& rate) override;
+  bool writeFrame(const YuvFrame& frame) override;
+  bool close() override;
+  std::string getLastError() const override { return lastError; }
+  YuvFormat getYuvFormat() const override { return yuvFormat; }
+
+  /**
+   * @brief Stop waiting for the reader when an export is cancelled
+   * @param monitor The export's monitor (not owned), or nullptr for none
+   */
+  void setMonitor(ExportMonitor* monitor) { this->monitor = monitor; }
+
+  /**
+   * @brief Check if a format is streamed by a FrameServerSink
+   * @param format The export format
+   * @return true for Y4M and RAW
+   */
+  static bool isStreamFormat(ExportFormat format);
+
+  /**
+   * @brief Make the header line of a Y4M stream
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param yuvFormat The frames' range (Y4M has no field for the matrix)
+   * @return e.g. "YUV4MPEG2 W1920 H1080 F30:1 Ip A1:1 C420jpeg ...\n"
+   */
+  static std::string makeY4mHeader(int width, int height, const Rational& rate,
+                                   const YuvFormat& yuvFormat);
+
+  FrameServerSink(const FrameServerSink&) = delete;
+  FrameServerSink& operator=(const FrameServerSink&) = delete;
+
+private:
+  std::string destination;
+  ExportFormat format;
+  YuvFormat yuvFormat;
+  ExportMonitor* monitor;
+  std::FILE* file;   // Not closed if it is stdout
+  bool pipe;         // file is a pipe or socket, which the reader may stop reading
+  std::string lastError;
+
+  /**
+   * @brief Open the destination file, waiting for a named pipe's reader
+   * @return false if it could not be opened, or the export was cancelled
+   */
+  bool openDestination();
+
+  /**
+   * @brief Write bytes, failing with the system's reason
+   * @return false if not all of them were written
+   */
+  bool writeAll(const void* data, size_t size);
+};
+
+} // namespace csci3081
+
+#endif // FRAME_SERVER_SINK_H_
@@ -0,0 +1,57 @@
+#ifndef I_FRAME_SINK_H_
+#define I_FRAME_SINK_H_
+
+#include "export/YuvFrame.h"
+#include "timeline/Timebase.h"
+#include <string>
+
+namespace csci3081 {
+
+/**
+ * @brief Where an export pipeline sends its converted frames
+ *
+ * Frames arrive in order, one writeFrame() call per output frame. The
+ * frame is only valid during the call: the pipeline reuses its buffer.
+ */
+class IFrameSink {
+public:
+  virtual ~IFrameSink() {}
+
+  /**
+   * @brief Prepare to receive frames
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @return true if frames can be written
+   */
+  virtual bool open(int width, int height, const Rational& rate) = 0;
+
+  /**
+   * @brief Write the next frame
+   * @param frame The frame
+   * @return false to stop the export
+   */
+  virtual bool writeFrame(const YuvFrame& frame) = 0;
+
+  /**
+   * @brief Finish writing (called once after a successful open())
+   * @return true if everything written was kept
+   */
+  virtual bool close() = 0;
+
+  /**
+   * @brief Describe the last failure
+   * @return Error message, or empty if nothing failed
+   */
+  virtual std::string getLastError() const = 0;
+
+  /**
+   * @brief Get the matrix and range the sink wants its frames in
+   * @return The format to convert to (BT.601, limited range unless overridden)
+   */
+  virtual YuvFormat getYuvFormat() const { return YuvFormat(); }
+};
+
+} // namespace csci3081
+
+#endif // I_FRAME_SINK_H_
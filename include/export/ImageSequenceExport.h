@@ -0,0 +1,127 @@
+#ifndef IMAGE_SEQUENCE_EXPORT_H_
+#define IMAGE_SEQUENCE_EXPORT_H_
+
+#include "export/ExportFacade.h"
+#include "export/ExportPipeline.h"
+#include "timeline/Timebase.h"
+#include <cstdint>
+#include <string>
+
+namespace csci3081 {
+
+class ExportMonitor;
+class Timeline;
+
+/**
+ * @brief Counters for an image sequence export
+ */
+struct SequenceStats {
+  StageStats render;    // Rendering, on the caller's thread
+  StageStats encode;    // Encoding and writing, summed over the workers
+  int workers;          // Threads that encoded files
+  int frameBuffers;     // Frames allocated
+  double elapsedSeconds;
+
+  SequenceStats() : workers(0), frameBuffers(0), elapsedSeconds(0.0) {}
+
+  /**
+   * @brief Get how many files were written per second of the export
+   * @return Files per second of wall time, 0 if nothing was written
+   */
+  double getFilesPerSecond() const {
+    return elapsedSeconds > 0.0 ? encode.frames / elapsedSeconds : 0.0;
+  }
+};
+
+/**
+ * @brief Writes every frame of a timeline as a numbered image file
+ *
+ * Frames are rendered in order on the calling thread and handed through a
+ * BoundedQueue to worker threads, which encode and write them. Encoding a
+ * PNG (mostly deflate) is much slower than rendering a frame, so this is
+ * how a sequence uses more than one core. Frames come from a fixed pool of
+ * queueCapacity + workers + 1 buffers, so memory use does not grow with
+ * the length of the timeline.
+ *
+ * Files are named after the filename given with the frame number before
+ * the extension: "shot.png" gives "shot_000000.png", "shot_000001.png" and
+ * so on. Files already written are kept if the export fails or is
+ * cancelled.
+ *
+ * Design Pattern: Producer-Consumer
+ */
+class ImageSequenceExport {
+public:
+  static const int DEFAULT_QUEUE_CAPACITY = 4;
+
+  /**
+   * @brief Create a sequence export
+   * @param workerCount Threads that encode files, 0 for one per core
+   * @param queueCapacity Rendered frames that may wait for a worker
+   */
+  explicit ImageSequenceExport(int workerCount = 0,
+                               int queueCapacity = DEFAULT_QUEUE_CAPACITY);
+
+  /**
+   * @brief Write every frame of a timeline
+   *
+   * Frame n shows the timeline at frameToTicks(n, rate), as in a video
+   * export. The timeline must not change during the call. If a file
+   * can't be written or the monitor is cancelled, the files already
+   * written are deleted.
+   *
+   * @param timeline Timeline to export
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param filename Name the frames' names are made from
+   * @param settings Format, JPEG quality and PNG settings
+   * @return true if every file was written
+   */
+  bool run(const Timeline& timeline, int width, int height, const Rational& rate,
+           const std::string& filename, const ExportSettings& settings);
+
+  /**
+   * @brief Report each written file to a monitor, and stop when it is cancelled
+   * @param monitor The monitor (not owned), or nullptr for none; whoever
+   *        runs the export starts it
+   */
+  void setMonitor(ExportMonitor* monitor) { this->monitor = monitor; }
+
+  /**
+   * @brief Get the name of one frame's file
+   * @param filename Name the sequence is named after, e.g. "shot.png"
+   * @param frame Frame number
+   * @return e.g. "shot_000042.png"
+   */
+  static std::string getFrameFilename(const std::string& filename, int64_t frame);
+
+  /**
+   * @brief Get the number of workers used when 0 is asked for
+   * @return One per core, at least 1
+   */
+  static int getDefaultWorkerCount();
+
+  /**
+   * @brief Get the counters of the last run()
+   * @return Render and encode counters
+   */
+  const SequenceStats& getStats() const { return stats; }
+
+  /**
+   * @brief Get the last error message
+   * @return String describing the last error, or empty if no error
+   */
+  std::string getLastError() const { return lastError; }
+
+private:
+  int workerCount;
+  int queueCapacity;
+  ExportMonitor* monitor;
+  SequenceStats stats;
+  std::string lastError;
+};
+
+} // namespace csci3081
+
+#endif // IMAGE_SEQUENCE_EXPORT_H_
@@ -0,0 +1,37 @@
+#ifndef IMAGE_WRITER_H_
+#define IMAGE_WRITER_H_
+
+#include "Image.h"
+#include "export/ExportFacade.h"
+#include <string>
+
+namespace csci3081 {
+
+/**
+ * @brief Check if a format stores the alpha channel
+ *
+ * Frames are premultiplied; formats that keep alpha store it straight.
+ *
+ * @param format The export format
+ * @return true for PNG and PPM (written as TGA)
+ */
+bool formatKeepsAlpha(ExportFormat format);
+
+/**
+ * @brief Write an image to a file in any image format
+ *
+ * Safe to call from several threads at once, with different settings.
+ *
+ * @param image The image to write, with straight alpha if
+ *        formatKeepsAlpha(settings.format)
+ * @param filename Output filename
+ * @param settings Format, JPEG quality and PNG settings
+ * @param error Set to why the write failed
+ * @return true if write succeeded, false otherwise
+ */
+bool writeImageFile(const Image& image, const std::string& filename,
+                    const ExportSettings& settings, std::string& error);
+
+} // namespace csci3081
+
+#endif // IMAGE_WRITER_H_
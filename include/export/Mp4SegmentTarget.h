@@ -0,0 +1,75 @@
+#ifndef MP4_SEGMENT_TARGET_H_
+#define MP4_SEGMENT_TARGET_H_
+
+#include "export/EncoderSettings.h"
+#include "export/SegmentedExport.h"
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief Encodes segments to temporary MP4 files and joins them into one
+ *
+ * Segment n is written next to the output as "<filename>.part<n>.mp4" by
+ * a VideoWriterSink, and concatenate() copies their packets, and those of
+ * passthrough segments' sources, into the output without decoding them.
+ * The part files are deleted once joined, or when the target is destroyed
+ * unless they are kept for a checkpointed export to resume from.
+ */
+class Mp4SegmentTarget : public ISegmentTarget {
+public:
+  /**
+   * @brief Create a target for a file
+   * @param filename Output filename (should have .mp4 extension)
+   * @param settings How to encode the segments (one pass; keyframeInterval
+   *        must be the GOP size the export was planned with)
+   */
+  explicit Mp4SegmentTarget(const std::string& filename,
+                            const EncoderSettings& settings = EncoderSettings());
+  ~Mp4SegmentTarget() override;
+
+  IFrameSink* createSegmentSink(const ExportSegment& segment) override;
+  bool concatenate(const std::vector<ExportSegment>& segments, const Rational& rate) override;
+  std::string getLastError() const override { return lastError; }
+
+  /**
+   * @brief Check if a segment's part file is still there from an earlier export
+   * @param segment The segment
+   * @return true if the part file exists
+   */
+  bool hasSegment(const ExportSegment& segment) const override;
+
+  /**
+   * @brief Keep the part files if the export fails or is cancelled
+   *
+   * With a checkpoint, an export run again resumes from them. They are
+   * still deleted once joined.
+   *
+   * @param keep true to keep them
+   */
+  void setKeepParts(bool keep) { keepParts = keep; }
+
+  /**
+   * @brief Get the file a segment is encoded to
+   * @param segment The segment
+   * @return Path of the part file
+   */
+  std::string getPartPath(const ExportSegment& segment) const;
+
+  Mp4SegmentTarget(const Mp4SegmentTarget&) = delete;
+  Mp4SegmentTarget& operator=(const Mp4SegmentTarget&) = delete;
+
+private:
+  std::string filename;
+  EncoderSettings settings;
+  std::vector<std::string> parts;   // Part files created so far
+  bool keepParts;
+  std::string lastError;
+
+  void removeParts();
+};
+
+} // namespace csci3081
+
+#endif // MP4_SEGMENT_TARGET_H_
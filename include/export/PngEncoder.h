@@ -0,0 +1,61 @@
+#ifndef PNG_ENCODER_H_
+#define PNG_ENCODER_H_
+
+#include "Image.h"
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief How each row of a PNG is predicted from the pixels before it
+ *
+ * Filtering makes the rows more alike, so deflate finds more repeats.
+ */
+enum class PngFilter {
+  ADAPTIVE,   // Try every filter on each row and keep the one with the smallest residuals
+  NONE,
+  SUB,        // From the pixel to the left
+  UP,         // From the pixel above
+  AVERAGE,    // From the mean of left and above
+  PAETH       // From whichever of left, above and above-left is closest
+};
+
+/**
+ * @brief PNG compression settings
+ */
+struct PngSettings {
+  int compressionLevel;   // 0 stores the pixels uncompressed (fastest, largest);
+                          // higher searches harder for repeats. Levels 1-5 all
+                          // search like 5. 8 is what stbi_write_png uses.
+  PngFilter filter;
+
+  PngSettings() : compressionLevel(8), filter(PngFilter::ADAPTIVE) {}
+};
+
+/**
+ * @brief Encode an RGBA image as a PNG in memory
+ *
+ * Unlike stbi_write_png(), which reads its level and filter from globals,
+ * every call takes its own settings, so frames with different settings
+ * can be encoded on several threads at once.
+ *
+ * @param image Straight-alpha RGBA image
+ * @param settings Compression level and filter
+ * @param png Receives the file's bytes
+ * @return true on success, false if the image is empty or memory ran out
+ */
+bool encodePng(const Image& image, const PngSettings& settings, std::vector<unsigned char>& png);
+
+/**
+ * @brief Encode an RGBA image as a PNG file
+ * @param image Straight-alpha RGBA image
+ * @param filename Output filename
+ * @param settings Compression level and filter
+ * @return true if the whole file was written
+ */
+bool writePng(const Image& image, const std::string& filename, const PngSettings& settings);
+
+} // namespace csci3081
+
+#endif // PNG_ENCODER_H_
@@ -0,0 +1,156 @@
+#ifndef SEGMENT_CACHE_H_
+#define SEGMENT_CACHE_H_
+
+#include "assets/IAsset.h"
+#include "export/EncoderSettings.h"
+#include "export/SegmentedExport.h"
+#include "timeline/Timebase.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+class Timeline;
+
+/**
+ * @brief Reuses the encoded segments of the last export of a video
+ *
+ * Every segment of a segmented export is a closed GOP run that starts
+ * with a keyframe, so it can be copied into another video without
+ * re-encoding. After an export the cache writes an index,
+ * "<filename>.segments", listing the content hash (see hashSegments()) and
+ * frames of each segment in the output. Exporting to the same file again
+ * looks up each planned segment's hash: segments with an unchanged hash
+ * become passthrough segments copied from the earlier video, which is
+ * moved aside to "<filename>.previous.mp4" while the new one is written,
+ * and only the others are rendered and encoded.
+ *
+ * The earlier export is the cache, so nothing is kept beyond the video and
+ * its index, and a video that was replaced or edited by another program
+ * (a different size to the one indexed) is not used.
+ */
+class SegmentCache {
+public:
+  /**
+   * @brief Create the cache of a video
+   * @param filename The output video
+   */
+  explicit SegmentCache(const std::string& filename);
+
+  /**
+   * @brief Read the index of the last export
+   * @return true if a video matching the index was found
+   */
+  bool load();
+
+  /**
+   * @brief Copy the segments whose hashes match the last export
+   *
+   * Rendered segments of plan found in the index are made passthrough
+   * segments of getPreviousPath(). Segments already passthrough are left
+   * alone.
+   *
+   * @param plan The export's segments, changed in place
+   * @param hashes The hash of each segment of plan (see hashSegments())
+   * @return Frames reused
+   */
+  int64_t reuse(std::vector<ExportSegment>& plan, const std::vector<std::string>& hashes);
+
+  /**
+   * @brief Move the last export to getPreviousPath(), before it's overwritten
+   *
+   * Does nothing if no segment was reused or it is already there.
+   *
+   * @return false if it could not be moved
+   */
+  bool keepPrevious();
+
+  /**
+   * @brief Index a finished export and delete the last one
+   * @param plan The export's segments
+   * @param hashes The hash of each segment of plan
+   * @return false if the index could not be written
+   */
+  bool store(const std::vector<ExportSegment>& plan, const std::vector<std::string>& hashes);
+
+  /**
+   * @brief Put the last export back after an export failed
+   *
+   * The failed video must already be deleted.
+   */
+  void restore();
+
+  /**
+   * @brief Get the frames reuse() found
+   * @return Frames of the plan copied from the last export
+   */
+  int64_t getReusedFrames() const { return reusedFrames; }
+
+  /**
+   * @brief Get where the last export is kept while the new one is written
+   * @return "<filename>.previous.mp4"
+   */
+  std::string getPreviousPath() const { return filename + ".previous.mp4"; }
+
+  /**
+   * @brief Get the index's path
+   * @return "<filename>.segments"
+   */
+  std::string getIndexPath() const { return filename + ".segments"; }
+
+  /**
+   * @brief Get the last error message
+   * @return String describing the last error, or empty if no error
+   */
+  std::string getLastError() const { return lastError; }
+
+  /**
+   * @brief Identify what each segment of an export shows
+   *
+   * A segment's hash covers the entries drawn in its frames (including
+   * those shown by a transition across a cut): their assets' sources (as
+   * ExportCheckpoint::describeSource() tells their versions apart),
+   * timing, transforms, keyframes and transitions, and the
+   * blend mode of their tracks, plus the timeline's background, the frame
+   * size and rate, the encoder settings and the segment's frames. An edit
+   * changes the hashes of the segments it is seen in and no others.
+   *
+   * @param timeline The timeline
+   * @param sources What each asset on the timeline was created from
+   * @param plan The export's segments
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param encoder Encoder settings
+   * @param hashes Receives one hash per segment of plan
+   * @return false if the timeline can't be identified: an asset has no
+   *         source, or a track has CPU filters (see ExportCheckpoint::makeKey())
+   */
+  static bool hashSegments(const Timeline& timeline,
+                           const std::map<IAsset*, std::string>& sources,
+                           const std::vector<ExportSegment>& plan, int width, int height,
+                           const Rational& rate, const EncoderSettings& encoder,
+                           std::vector<std::string>& hashes);
+
+private:
+  /**
+   * @brief Where a segment of the last export is
+   */
+  struct CachedSegment {
+    int64_t firstFrame;
+    int64_t frameCount;
+  };
+
+  std::string filename;
+  std::string cachedPath;                        // Video the index describes, or empty
+  std::map<std::string, CachedSegment> cached;   // By hash
+  int64_t reusedFrames;
+  bool moved;                                    // keepPrevious() moved the video
+  std::string lastError;
+};
+
+} // namespace csci3081
+
+#endif // SEGMENT_CACHE_H_
@@ -0,0 +1,251 @@
+#ifndef SEGMENTED_EXPORT_H_
+#define SEGMENTED_EXPORT_H_
+
+#include "assets/IAssetFactory.h"
+#include "export/ExportPipeline.h"
+#include "export/IFrameSink.h"
+#include "timeline/Timebase.h"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+class ExportCheckpoint;
+class Timeline;
+
+/**
+ * @brief A run of frames of an export that is encoded on its own
+ *
+ * A passthrough segment is not rendered: its frames are the already
+ * encoded frames sourceFirstFrame onwards of the video at sourcePath,
+ * copied as they are.
+ */
+struct ExportSegment {
+  int index;                  // Position of the segment in the export
+  int64_t firstFrame;         // Export frame the segment starts at
+  int64_t frameCount;         // Frames in the segment
+  std::string sourcePath;     // Video to copy from, empty to render
+  int64_t sourceFirstFrame;   // Frame of the video to start copying at
+
+  ExportSegment() : index(0), firstFrame(0), frameCount(0), sourceFirstFrame(0) {}
+  ExportSegment(int index, int64_t firstFrame, int64_t frameCount)
+    : index(index), firstFrame(firstFrame), frameCount(frameCount), sourceFirstFrame(0) {}
+
+  /**
+   * @brief Check if the segment is copied rather than rendered
+   * @return true if it has a source video
+   */
+  bool isPassthrough() const { return !sourcePath.empty(); }
+};
+
+/**
+ * @brief Split an export into segments that each start a GOP
+ *
+ * Every segment but the last is a whole number of GOPs, so an encoder
+ * started at each segment puts its keyframes on the frames a single
+ * encoder would. GOPs are shared out as evenly as possible.
+ *
+ * @param frameCount Frames in the export
+ * @param gopSize Frames per GOP (the keyframe interval)
+ * @param maxSegments Most segments to make (fewer if there are fewer GOPs)
+ * @return Segments in order, covering every frame once; empty if frameCount <= 0
+ */
+std::vector<ExportSegment> planSegments(int64_t frameCount, int gopSize, int maxSegments);
+
+/**
+ * @brief Where a segmented export writes its segments and joins them
+ */
+class ISegmentTarget {
+public:
+  virtual ~ISegmentTarget() {}
+
+  /**
+   * @brief Create the sink that encodes one segment
+   *
+   * Called on the exporting thread for every rendered segment before any
+   * is rendered. Each sink is then used by one worker thread.
+   *
+   * @param segment The segment
+   * @return The sink (caller owns it), or nullptr on failure
+   */
+  virtual IFrameSink* createSegmentSink(const ExportSegment& segment) = 0;
+
+  /**
+   * @brief Join the encoded segments into the final output
+   *
+   * Called once every segment's sink has been closed. Segments are joined
+   * without re-encoding, passthrough segments copied from their source;
+   * segment n's frames are timed from segment.firstFrame on.
+   *
+   * @param segments The segments, in order
+   * @param rate Frames per second
+   * @return true if the output was written
+   */
+  virtual bool concatenate(const std::vector<ExportSegment>& segments,
+                           const Rational& rate) = 0;
+
+  /**
+   * @brief Check if a segment was encoded by an earlier export
+   *
+   * Resumed exports skip segments their checkpoint lists as finished, as
+   * long as the target still has them.
+   *
+   * @param segment The segment
+   * @return true if concatenate() can use it without encoding it again
+   */
+  virtual bool hasSegment(const ExportSegment& segment) const { return false; }
+
+  /**
+   * @brief Describe the last failure
+   * @return Error message, or empty if nothing failed
+   */
+  virtual std::string getLastError() const = 0;
+};
+
+/**
+ * @brief Exports a timeline as segments encoded in parallel
+ *
+ * The export is split with planSegments() (or follows a given plan) and
+ * up to maxSegments worker threads take the segments to render in turn.
+ * Each worker has an ExportPipeline and a copy of the timeline
+ * (Timeline::copyWithAssets()) whose videos are fresh assets made from
+ * their sources, so no two workers share a decoder or render state; each
+ * segment has a sink from the target. When all segments are encoded the
+ * target joins them. The output has the frames, in the same order and at
+ * the same times, that one ExportPipeline would write.
+ *
+ * A video whose source is unknown can't be copied; a timeline showing one
+ * is rendered by a single worker, in one segment unless a plan is given.
+ */
+class SegmentedExport {
+public:
+  /**
+   * @brief Create a segmented export
+   * @param maxSegments Most segments (and workers), 0 for getDefaultSegmentCount()
+   * @param gopSize Keyframe interval of the encoder the target uses
+   */
+  SegmentedExport(int maxSegments, int gopSize);
+
+  /**
+   * @brief Say how to make a worker's own copy of each asset
+   * @param factory Creates assets from their sources (not owned)
+   * @param sources The source of each asset that has one
+   */
+  void setAssetSources(const IAssetFactory* factory,
+                       const std::map<IAsset*, std::string>& sources);
+
+  /**
+   * @brief Report progress to a monitor, and stop when it is cancelled
+   *
+   * Rendered frames are counted as they are encoded, copied ones once the
+   * output is joined. Whoever runs the export calls start() on the monitor.
+   *
+   * @param monitor The monitor (not owned), or nullptr for none
+   */
+  void setMonitor(ExportMonitor* monitor) { this->monitor = monitor; }
+
+  /**
+   * @brief Record finished segments, and skip those an earlier run finished
+   *
+   * Segments the checkpoint lists as finished, and the target still has,
+   * are not rendered again; they are counted as resumed frames. Each
+   * segment is marked finished as soon as its sink has closed. Whoever
+   * runs the export calls begin() on the checkpoint with the plan.
+   *
+   * @param checkpoint The checkpoint (not owned), or nullptr for none
+   */
+  void setCheckpoint(ExportCheckpoint* checkpoint) { this->checkpoint = checkpoint; }
+
+  /**
+   * @brief Export every frame of a timeline
+   *
+   * The timeline is only read on the calling thread, to make the workers'
+   * copies, so the live timeline may be passed.
+   *
+   * @param timeline Timeline to export
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param target Encodes and joins the segments
+   * @return true if every segment was encoded and the output joined
+   */
+  bool run(const Timeline& timeline, int width, int height, const Rational& rate,
+           ISegmentTarget& target);
+
+  /**
+   * @brief Export a timeline split into given segments
+   * @param timeline Timeline to export
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param plan Segments in order, covering every frame once; passthrough
+   *        segments are left to the target
+   * @param target Encodes and joins the segments
+   * @return true if every segment was encoded and the output joined
+   */
+  bool run(const Timeline& timeline, int width, int height, const Rational& rate,
+           const std::vector<ExportSegment>& plan, ISegmentTarget& target);
+
+  /**
+   * @brief Get the segments of the last run()
+   * @return The segments, in order
+   */
+  const std::vector<ExportSegment>& getSegments() const { return segments; }
+
+  /**
+   * @brief Get the counters of the last run(), summed over every segment
+   * @return Per-stage counters of the rendered frames; elapsedSeconds is wall time
+   */
+  const PipelineStats& getStats() const { return stats; }
+
+  /**
+   * @brief Count the frames of the last run() copied instead of rendered
+   * @return Frames in passthrough segments
+   */
+  int64_t getPassthroughFrames() const;
+
+  /**
+   * @brief Count the frames of the last run() an earlier run had encoded
+   * @return Frames in segments skipped because of the checkpoint
+   */
+  int64_t getResumedFrames() const { return resumedFrames; }
+
+  /**
+   * @brief Get the last error message
+   * @return String describing the last error, or empty if no error
+   */
+  std::string getLastError() const { return lastError; }
+
+  /**
+   * @brief Get a segment count that keeps this machine busy
+   * @return One segment per two hardware threads, at least 1
+   */
+  static int getDefaultSegmentCount();
+
+private:
+  /**
+   * @brief Collect the videos a timeline shows
+   * @param timeline The timeline
+   * @param videos Receives every video asset on its tracks
+   * @return true if workers can make their own copy of each of them
+   */
+  bool findVideos(const Timeline& timeline, std::set<IAsset*>& videos) const;
+
+  int maxSegments;
+  int gopSize;
+  const IAssetFactory* factory;
+  ExportMonitor* monitor;
+  ExportCheckpoint* checkpoint;
+  std::map<IAsset*, std::string> sources;
+  std::vector<ExportSegment> segments;
+  int64_t resumedFrames;
+  PipelineStats stats;
+  std::string lastError;
+};
+
+} // namespace csci3081
+
+#endif // SEGMENTED_EXPORT_H_
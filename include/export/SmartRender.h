@@ -0,0 +1,76 @@
+#ifndef SMART_RENDER_H_
+#define SMART_RENDER_H_
+
+#include "export/SegmentedExport.h"
+#include "timeline/Timebase.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+class IAsset;
+class Timeline;
+
+/**
+ * @brief What an encoded video file holds, read without decoding it
+ */
+struct SourceVideoInfo {
+  bool copyable;                  // H.264, 8-bit 4:2:0: packets can go into our output
+  int width;
+  int height;
+  Rational rate;                  // Frames per second
+  int64_t frameCount;
+  std::vector<int64_t> keyframes; // Frames a decoder can start at, ascending
+
+  SourceVideoInfo() : copyable(false), width(0), height(0), frameCount(0) {}
+};
+
+/**
+ * @brief Reads SourceVideoInfo from video files
+ */
+class IVideoProbe {
+public:
+  virtual ~IVideoProbe() {}
+
+  /**
+   * @brief Read what a video file holds
+   * @param path The video file
+   * @param info Receives the stream description
+   * @return false if the file could not be read
+   */
+  virtual bool probe(const std::string& path, SourceVideoInfo& info) = 0;
+};
+
+/**
+ * @brief Plan an export that copies untouched video instead of rendering it
+ *
+ * A frame can be copied when exactly one entry is on screen and the
+ * output is that entry's video frame unchanged: the video is copyable,
+ * the output size and rate, starts on a frame of the export, fills the
+ * frame with opacity 1 and no animation, and its track has no filters,
+ * no transition and the normal blend mode. The copied run of such frames
+ * is trimmed to whole GOPs of the source, since a copy has to start on a
+ * keyframe and can't end inside a GOP that continues past the cut. The
+ * frames left over (around cuts, overlays and everything else) are split
+ * into rendered segments with planSegments().
+ *
+ * @param timeline Timeline to export
+ * @param width Output width
+ * @param height Output height
+ * @param rate Output frames per second
+ * @param sources The file each video asset was created from
+ * @param probe Reads the video files (each at most once)
+ * @param gopSize Keyframe interval of the encoder for rendered segments
+ * @param maxSegments Most segments to split each rendered run into
+ * @return Segments in order, covering every frame once
+ */
+std::vector<ExportSegment> planSmartRender(const Timeline& timeline, int width, int height,
+                                           const Rational& rate,
+                                           const std::map<IAsset*, std::string>& sources,
+                                           IVideoProbe& probe, int gopSize, int maxSegments);
+
+} // namespace csci3081
+
+#endif // SMART_RENDER_H_
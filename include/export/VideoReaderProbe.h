@@ -0,0 +1,21 @@
+#ifndef VIDEO_READER_PROBE_H_
+#define VIDEO_READER_PROBE_H_
+
+#include "export/SmartRender.h"
+
+namespace csci3081 {
+
+/**
+ * @brief Reads video files with video_reader_probe_stream()
+ *
+ * Design Pattern: Adapter Pattern
+ * - Adapts the C-style video_reader functions to IVideoProbe
+ */
+class VideoReaderProbe : public IVideoProbe {
+public:
+  bool probe(const std::string& path, SourceVideoInfo& info) override;
+};
+
+} // namespace csci3081
+
+#endif // VIDEO_READER_PROBE_H_
@@ -0,0 +1,87 @@
+#ifndef VIDEO_WRITER_SINK_H_
+#define VIDEO_WRITER_SINK_H_
+
+#include "export/EncoderSettings.h"
+#include "export/IFrameSink.h"
+#include <string>
+#include <vector>
+
+struct VideoWriterState;
+
+namespace csci3081 {
+
+/**
+ * @brief Frame sink that encodes to a video file with video_writer
+ *
+ * Design Pattern: Adapter Pattern
+ * - Adapts the C-style video_writer functions to IFrameSink
+ */
+class VideoWriterSink : public IFrameSink {
+public:
+  /**
+   * @brief Create a sink for a file
+   * @param filename Output filename (the container is chosen from its extension)
+   * @param settings How to encode
+   */
+  explicit VideoWriterSink(const std::string& filename,
+                           const EncoderSettings& settings = EncoderSettings());
+  ~VideoWriterSink() override;
+
+  /**
+   * @brief Make the next open() start one pass of a two-pass encode
+   *
+   * Pass 1 writes statistics to logPath (and a file the second pass
+   * overwrites); pass 2 reads them to spend the bit rate where it's needed.
+   *
+   * @param pass 1 or 2, or 0 for a single pass
+   * @param logPath Statistics file shared by both passes
+   */
+  void setPass(int pass, const std::string& logPath);
+
+  bool open(int width, int height, const Rational& rate) override;
+  bool writeFrame(const YuvFrame& frame) override;
+  bool close() override;
+  std::string getLastError() const override { return lastError; }
+  YuvFormat getYuvFormat() const override { return settings.yuvFormat; }
+
+  /**
+   * @brief Check that the local FFmpeg can encode with some settings
+   * @param settings The settings
+   * @param width Frame width
+   * @param height Frame height
+   * @param rate Frames per second
+   * @param error Receives what is wrong or unsupported, if anything
+   * @return true if open() would accept them
+   */
+  static bool checkSettings(const EncoderSettings& settings, int width, int height,
+                            const Rational& rate, std::string& error);
+
+  /**
+   * @brief Get the format an encoder writes
+   * @param codec FFmpeg encoder name (e.g. "libx264")
+   * @return Codec name (e.g. "h264"), or empty if the encoder isn't available
+   */
+  static std::string getEncoderFormat(const std::string& codec);
+
+  /**
+   * @brief List the encoders the local FFmpeg can export video with
+   * @return Encoder names, e.g. "libx264"
+   */
+  static std::vector<std::string> getAvailableEncoders();
+
+  VideoWriterSink(const VideoWriterSink&) = delete;
+  VideoWriterSink& operator=(const VideoWriterSink&) = delete;
+
+private:
+  std::string filename;
+  EncoderSettings settings;
+  int pass;
+  std::string passLog;
+  VideoWriterState* writer;
+  bool opened;
+  std::string lastError;
+};
+
+} // namespace csci3081
+
+#endif // VIDEO_WRITER_SINK_H_
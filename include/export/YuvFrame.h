@@ -0,0 +1,96 @@
+#ifndef YUV_FRAME_H_
+#define YUV_FRAME_H_
+
+#include "Image.h"
+#include <cstdint>
+#include <vector>
+
+namespace csci3081 {
+
+class ThreadPool;
+
+/**
+ * @brief The matrix that turns RGB into luma and color differences
+ */
+enum class YuvMatrix {
+  BT601,   // Standard definition video
+  BT709    // HD video
+};
+
+/**
+ * @brief The code values YUV samples use
+ */
+enum class YuvRange {
+  LIMITED,   // Y 16-235, U and V 16-240 ("TV" range, what players expect)
+  FULL       // 0-255 ("PC" or JPEG range)
+};
+
+/**
+ * @brief How a YUV frame's samples relate to RGB
+ */
+struct YuvFormat {
+  YuvMatrix matrix;
+  YuvRange range;
+
+  YuvFormat() : matrix(YuvMatrix::BT601), range(YuvRange::LIMITED) {}
+  YuvFormat(YuvMatrix matrix, YuvRange range) : matrix(matrix), range(range) {}
+};
+
+/**
+ * @brief A planar YUV 4:2:0 frame, the format the video encoder takes
+ *
+ * The chroma planes are half the size of the luma plane in each direction,
+ * rounded up. Rows are packed (the stride of each plane is its width).
+ */
+struct YuvFrame {
+  int width;
+  int height;
+  std::vector<uint8_t> y;
+  std::vector<uint8_t> u;
+  std::vector<uint8_t> v;
+
+  YuvFrame() : width(0), height(0) {}
+  YuvFrame(int width, int height) : width(0), height(0) { resize(width, height); }
+
+  int getChromaWidth() const { return (width + 1) / 2; }
+  int getChromaHeight() const { return (height + 1) / 2; }
+
+  /**
+   * @brief Set the size, reallocating the planes only if it changed
+   * @param newWidth Luma width
+   * @param newHeight Luma height
+   */
+  void resize(int newWidth, int newHeight);
+};
+
+/**
+ * @brief Convert a frame to YUV 4:2:0 (BT.601, limited range) on this thread
+ *
+ * The RGBA frame is premultiplied, so its colors are already the frame over
+ * black, which is what a format without alpha shows. Each chroma sample is
+ * the average of its 2x2 block. This is the matrix and range sws_scale
+ * uses by default, and the result is within 1 of its output.
+ *
+ * @param image The frame
+ * @param frame Receives the converted frame (resized to match)
+ */
+void convertToYuv420(const Image& image, YuvFrame& frame);
+
+/**
+ * @brief Convert a frame to YUV 4:2:0 in a given format
+ *
+ * Converts 16 pixels of two rows at a time with SSE2 where available
+ * (the result is the same without it). With a pool, bands of rows are
+ * converted in parallel.
+ *
+ * @param image The frame (premultiplied RGBA)
+ * @param frame Receives the converted frame (resized to match)
+ * @param format Matrix and range to convert to
+ * @param pool Threads to share the rows between, or nullptr for this thread only
+ */
+void convertToYuv420(const Image& image, YuvFrame& frame, const YuvFormat& format,
+                     ThreadPool* pool);
+
+} // namespace csci3081
+
+#endif // YUV_FRAME_H_
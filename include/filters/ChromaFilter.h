@@ -1,5 +1,5 @@
-#ifndef GREYSCALEFILTER_H_
-#define GREYSCALEFILTER_H_
+#ifndef CHROMAFILTER_H_
+#define CHROMAFILTER_H_
 
 #include "filters/SimpleFilter.h"
 
@@ -15,7 +15,10 @@ protected:
     if (GreenStrengthAtPixel > 0) {
       int NewGreen = color.green() - GreenStrengthAtPixel * GreenSuppressionCoefficient;
       NewGreen = NewGreen < 0 ? 0 : NewGreen; // Make sure value doesn't go negative
-      return {color.red(), NewGreen, color.blue(), NewGreen};
+      // The green level becomes the alpha; premultiply the keyed color by it
+      int alpha = (color.alpha() * NewGreen + 127) / 255;
+      return {(color.red() * NewGreen + 127) / 255, (NewGreen * alpha + 127) / 255,
+              (color.blue() * NewGreen + 127) / 255, alpha};
     } else {
       return color;
     }
@@ -24,4 +27,4 @@ protected:
 
 } // namespace csci3081
 
-#endif // GREYSCALEFILTER_H_
+#endif // CHROMAFILTER_H_
@@ -7,6 +7,9 @@ namespace csci3081 {
 
 /**
  * @brief Base class using Template Method Pattern for pixel-by-pixel filters
+ *
+ * Pixels are premultiplied (see IAsset::getFrame()); a filter that changes
+ * alpha must scale the color channels with it.
  */
 class SimpleFilter : public IFilter {
 public:
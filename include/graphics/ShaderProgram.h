@@ -2,7 +2,13 @@
 #define SHADER_PROGRAM_H
 
 #include <string>
+#include <algorithm>
 #include "graphics/Texture.h"
+#include "graphics/TextureArray.h"
+#include "graphics/Color.h"
+#include "compositor/Blend.h"
+#include "timeline/EntryTransform.h"
+#include "timeline/Transition.h"
 #include <vector>
 
 namespace csci3081 {
@@ -15,8 +21,11 @@ public:
   void use() const;
   unsigned int getId() const { return shaderProgram; }
 
+  void setInt(const std::string& name, int value) const;
   void setFloat(const std::string& name, float value) const;
+  void setVec2(const std::string& name, float x, float y) const;
   void setVec3(const std::string& name, float x, float y, float z) const;
+  void setVec4(const std::string& name, float x, float y, float z, float w) const;
   void setTexture(const std::string& name, const Texture& texture, int index = 0) const;
   void setTextures(const std::string& name, const std::vector<Texture*> textures) const;
 
@@ -30,50 +39,311 @@ private:
   bool compiled = false;
 };
 
+/**
+ * @brief The shader that composites every track in one draw
+ *
+ * Track frames live in one texture array (layer i holds track i, and the
+ * incoming entries of transitions take the layers after the tracks), and
+ * everything else about a track is a row of a small float texture. The
+ * shader loops over the rows, so its source depends only on the filters
+ * and blend modes in use, never on the number of tracks, and a draw binds
+ * two textures however many tracks there are.
+ */
 class TrackShader : public ShaderProgram {
 public:
-  TrackShader() {
-    vertexShaderSourceStr = load_shader_file("src/graphics/shaders/quad.vsh");
-    std::string fragmentShaderSourceStr = load_shader_file("src/graphics/shaders/composite.fsh");
-    compile(vertexShaderSourceStr, fragmentShaderSourceStr);
-  }
+  /**
+   * @brief Create the track compositing shader
+   * @param shaderDirectory Directory holding quad.vsh
+   */
+  TrackShader(const std::string& shaderDirectory = "src/graphics/shaders/");
+  ~TrackShader();
+
+  /**
+   * @brief Set the filters and blend modes of the tracks
+   *
+   * The shader is only recompiled when its source changes, so adding a
+   * track without a filter costs nothing.
+   *
+   * @param trackFilters GLSL filter code per track (one per track)
+   * @param blendModes Blend mode per track (missing entries are NORMAL)
+   */
+  void update(const vector<std::string>& trackFilters,
+              const vector<BlendMode>& blendModes = vector<BlendMode>());
 
-  void update(const vector<std::string>& trackFilters) {
+  /**
+   * @brief Generate the compositing fragment shader
+   *
+   * Only the blend functions of modes that are actually used are emitted,
+   * and only tracks with filter code get a branch in compositeLayer().
+   *
+   * @param trackFilters GLSL filter code per track
+   * @param blendModes Blend mode per track (missing entries are NORMAL)
+   * @return GLSL source
+   */
+  static std::string fragmentSource(const vector<std::string>& trackFilters,
+                                    const vector<BlendMode>& blendModes) {
     std::string fragmentShaderSourceStr = 
     "#version 330 core\n"
     "out vec4 FragColor;\n"
     "uniform float duration;\n"
     "uniform float timeSinceStart;\n"
-    "uniform int texArray_size;\n"
-    "uniform sampler2D texArray[];\n"
+    // Layer i is track i; transitions' incoming entries follow the tracks
+    "uniform sampler2DArray layers;\n"
+    "uniform vec2 layersSize;\n"
+    // One row per track, see TrackShader::Param
+    "uniform sampler2D trackParams;\n"
+    "uniform int trackCount;\n"
+    "uniform vec2 frameSize;\n"
+    "uniform vec3 backgroundColor;\n"
+    // 1.0 blends in linear light (CompositingMode::LINEAR_16BIT)
+    "uniform float linearLight;\n"
     "in vec2 interpCoord;\n"
-    "void main()\n"
+    // sRGB transfer functions, as in compositor/LinearBlend
+    "vec3 toLinear(vec3 c)\n"
+    "{\n"
+    "    if (linearLight < 0.5) return c;\n"
+    "    return mix(pow((c + 0.055) / 1.055, vec3(2.4)), c / 12.92, vec3(lessThanEqual(c, vec3(0.04045))));\n"
+    "}\n"
+    // Premultiplied colors are converted through their straight values
+    "vec4 toLinear(vec4 c)\n"
+    "{\n"
+    "    if (linearLight < 0.5 || c.a <= 0.0) return c;\n"
+    "    return vec4(toLinear(c.rgb / c.a) * c.a, c.a);\n"
+    "}\n"
+    "vec3 toSrgb(vec3 c)\n"
+    "{\n"
+    "    if (linearLight < 0.5) return c;\n"
+    "    c = clamp(c, 0.0, 1.0);\n"
+    "    return mix(1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055, c * 12.92, vec3(lessThanEqual(c, vec3(0.0031308))));\n"
+    "}\n"
+    "vec4 trackParam(int track, int param)\n"
+    "{\n"
+    "    return texelFetch(trackParams, ivec2(param, track), 0);\n"
+    "}\n"
+    // Same inverse mapping as AffineBlitter: frame position -> layer texcoord
+    "vec2 layerCoord(vec2 coord, vec4 transform, float rotation)\n"
+    "{\n"
+    "    vec2 d = (coord - transform.xy) * frameSize;\n"
+    "    float c = cos(rotation);\n"
+    "    float s = sin(rotation);\n"
+    "    vec2 q = vec2(c * d.x + s * d.y, -s * d.x + c * d.y);\n"
+    "    return q / (transform.zw * frameSize) + 0.5;\n"
+    "}\n"
+    // placement: rotation, opacity, frame width and height (0 for no frame)
+    "vec4 sampleLayer(float layer, vec4 transform, vec4 placement)\n"
+    "{\n"
+    "    vec2 layerPos = layerCoord(interpCoord, transform, placement.x);\n"
+    "    if (placement.z <= 0.0 || any(lessThan(layerPos, vec2(0.0))) || any(greaterThanEqual(layerPos, vec2(1.0)))) {\n"
+    "        return vec4(0.0);\n"
+    "    }\n"
+    // Frames sit in the corner of their layer; clamping to the frame's own
+    // edge texels keeps the rest of the layer out of bilinear filtering
+    "    vec2 texel = clamp(layerPos * placement.zw, vec2(0.5), placement.zw - 0.5);\n"
+    "    vec4 trackColor = textureLod(layers, vec3(texel / layersSize, layer), 0.0);\n"
+    // Textures hold premultiplied colors, so opacity scales every channel
+    "    return trackColor * placement.y;\n"
+    "}\n"
+    // Same as applyTransition() in compositor/TransitionBlend
+    "vec3 transitionMix(vec3 from, vec3 to, vec2 transition, vec3 dipColor)\n"
     "{\n"
-    "    vec3 color = vec3(1.0);\n";
+    "    float p = transition.y;\n"
+    "    if (transition.x < 1.5) {\n"
+    "        return mix(from, to, p);\n"
+    "    }\n"
+    "    if (transition.x < 2.5) {\n"
+    "        return interpCoord.x < p ? to : from;\n"
+    "    }\n"
+    "    dipColor = toLinear(dipColor);\n"
+    "    return p < 0.5 ? mix(from, dipColor, p * 2.0) : mix(to, dipColor, 2.0 - p * 2.0);\n"
+    "}\n";
 
-    for (int i = 0; i < trackFilters.size(); i++) {
-      fragmentShaderSourceStr +=
-      "     {\n"
-      "        float time = timeSinceStart/duration;\n"
-      "        vec2 pos = interpCoord;\n"
-      "        vec4 aggregateColor = vec4(color, 1.0);\n"
-      "        vec4 trackColor = texture(texArray[" + std::to_string(i) + "], interpCoord);\n";
-
-      fragmentShaderSourceStr += trackFilters[i] +
-      "        color = vec3(aggregateColor) * (1-trackColor.a) + vec3(trackColor) * trackColor.a;\n"
-      "     }\n";
+    bool used[BLEND_MODE_COUNT] = {false};
+    for (size_t i = 0; i < trackFilters.size(); i++) {
+      BlendMode mode = i < blendModes.size() ? blendModes[i] : BlendMode::NORMAL;
+      int m = static_cast<int>(mode);
+      if (mode != BlendMode::NORMAL && !used[m]) {
+        fragmentShaderSourceStr += blendFunction(mode);
+        used[m] = true;
+      }
     }
 
+    // Runs a track's filter and composites a layer color, so both sides of
+    // a transition go through the same code. Filters see sRGB values in
+    // either mode; in linear light the results are converted before
+    // blending. Layer colors are premultiplied; the aggregate is opaque.
+    fragmentShaderSourceStr +=
+    "vec3 compositeLayer(int track, int mode, vec3 color, vec4 trackColor, vec2 pos, float time)\n"
+    "{\n"
+    "    vec4 aggregateColor = vec4(toSrgb(color), 1.0);\n";
+    for (size_t i = 0; i < trackFilters.size(); i++) {
+      if (trackFilters[i].empty()) {
+        continue;
+      }
+      fragmentShaderSourceStr +=
+      "    if (track == " + std::to_string(i) + ") {\n" +
+      trackFilters[i] + "\n"
+      "    }\n";
+    }
+    fragmentShaderSourceStr +=
+    "    aggregateColor.rgb = toLinear(aggregateColor.rgb);\n"
+    "    trackColor = toLinear(trackColor);\n"
+    "    vec3 mixTerm = vec3(trackColor);\n";
+    for (int m = 0; m < BLEND_MODE_COUNT; m++) {
+      if (used[m]) {
+        BlendMode mode = static_cast<BlendMode>(m);
+        fragmentShaderSourceStr +=
+        "    if (mode == " + std::to_string(m) + ") {\n"
+        "        mixTerm = blend" + std::string(blendModeName(mode)) + "(vec3(trackColor), trackColor.a, vec3(aggregateColor));\n"
+        "    }\n";
+      }
+    }
     fragmentShaderSourceStr +=
-    "   FragColor = vec4(color, 1.0);\n"
+    "    return vec3(aggregateColor) * (1-trackColor.a) + mixTerm;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "    vec3 color = toLinear(backgroundColor);\n"
+    "    float time = timeSinceStart/duration;\n"
+    "    vec2 pos = interpCoord;\n"
+    "    for (int i = 0; i < trackCount; i++) {\n"
+    "        vec4 mixing = trackParam(i, " + std::to_string(PARAM_MIXING) + ");\n"
+    "        int mode = int(mixing.w);\n"
+    "        vec4 trackColor = sampleLayer(float(i), trackParam(i, " + std::to_string(PARAM_TRANSFORM) + "), trackParam(i, " + std::to_string(PARAM_PLACEMENT) + "));\n"
+    "        vec3 result = compositeLayer(i, mode, color, trackColor, pos, time);\n"
+    "        if (mixing.x > 0.5) {\n"
+    "            vec4 incoming = sampleLayer(mixing.z, trackParam(i, " + std::to_string(PARAM_INCOMING_TRANSFORM) + "), trackParam(i, " + std::to_string(PARAM_INCOMING_PLACEMENT) + "));\n"
+    "            vec3 dipColor = trackParam(i, " + std::to_string(PARAM_TRANSITION_COLOR) + ").rgb;\n"
+    "            result = transitionMix(result, compositeLayer(i, mode, color, incoming, pos, time), mixing.xy, dipColor);\n"
+    "        }\n"
+    "        color = result;\n"
+    "    }\n"
+    "    FragColor = vec4(toSrgb(color), 1.0);\n"
     "}\n";
-    compile(vertexShaderSourceStr, fragmentShaderSourceStr);
+    return fragmentShaderSourceStr;
+  }
+
+  /**
+   * @brief Upload the frame a track shows and where it goes
+   * @param track Track index
+   * @param frame The entry's frame
+   * @param transform Entry transform (same one the CPU compositor uses)
+   */
+  void setTrackFrame(int track, const Image& frame, const EntryTransform& transform);
+
+  /**
+   * @brief Show nothing on a track
+   *
+   * Filters still run, as they do over a transparent frame. No pixels are
+   * uploaded.
+   *
+   * @param track Track index
+   */
+  void clearTrackFrame(int track);
+
+  /**
+   * @brief Upload the transition in progress on a track
+   *
+   * The incoming frame takes the next free layer after the tracks; those
+   * layers are handed out again after every bindLayers().
+   *
+   * @param track Track index
+   * @param transition The transition
+   * @param progress Position in the transition (0-1)
+   * @param incomingFrame Frame of the incoming entry
+   * @param incoming Transform of the incoming entry
+   */
+  void setTrackTransition(int track, const Transition& transition, double progress,
+                          const Image& incomingFrame, const EntryTransform& incoming);
+
+  /**
+   * @brief Mark a track as having no transition in progress
+   * @param track Track index
+   */
+  void clearTrackTransition(int track);
+
+  /**
+   * @brief Bind the track layers and parameters for the next draw
+   *
+   * Call after use() and the setTrack*() calls for a frame, and before
+   * drawing. Uses texture units 0 and 1.
+   */
+  void bindLayers();
+
+  /**
+   * @brief Set the color shown where no track covers the frame
+   * @param color Background color (same one the CPU compositor uses)
+   */
+  void setBackgroundColor(const Color& color) const {
+    setVec3("backgroundColor", color.red() / 255.0f, color.green() / 255.0f,
+            color.blue() / 255.0f);
+  }
+
+  /**
+   * @brief Choose whether layers are blended in linear light
+   *
+   * Colors are converted to linear light as they are read and the result
+   * is converted back once per pixel, as the CPU compositor does in
+   * CompositingMode::LINEAR_16BIT.
+   *
+   * @param enabled true to blend in linear light
+   */
+  void setLinearLight(bool enabled) const {
+    setFloat("linearLight", enabled ? 1.0f : 0.0f);
   }
 
 private:
+  /**
+   * @brief Texels (RGBA floats) of a track's row in trackParams
+   */
+  enum Param {
+    PARAM_TRANSFORM,            // positionX, positionY, scaleX, scaleY
+    PARAM_PLACEMENT,            // rotation (radians), opacity, frame width, height
+    PARAM_INCOMING_TRANSFORM,   // as PARAM_TRANSFORM, for the incoming entry
+    PARAM_INCOMING_PLACEMENT,   // as PARAM_PLACEMENT, for the incoming entry
+    PARAM_MIXING,               // TransitionType + 1 (0 = none), progress, incoming layer, BlendMode
+    PARAM_TRANSITION_COLOR,     // dip color
+    PARAM_COUNT
+  };
+
+  float* param(int track, Param p);
+  void setPlacement(int track, Param transformParam, Param placementParam,
+                    const Image& frame, const EntryTransform& transform);
+
   std::string vertexShaderSourceStr;
+  std::string compiledFragmentSource;
+  TextureArray layers;
+  unsigned int paramTexture;
+  std::vector<float> params;
+  int trackCount;
+  int nextIncomingLayer;
+
+  /**
+   * @brief GLSL for the premultiplied mix term of a blend mode
+   *
+   * Returns sa * B(s / sa, d) for a premultiplied source over an opaque
+   * destination, matching compositor/Blend.
+   *
+   * @param mode A blend mode other than NORMAL
+   * @return Definition of vec3 blend<Name>(vec3 s, float sa, vec3 d)
+   */
+  static std::string blendFunction(BlendMode mode) {
+    std::string body;
+    switch (mode) {
+      case BlendMode::NORMAL: body = "s"; break;
+      case BlendMode::ADD: body = "min(s + d * sa, vec3(sa))"; break;
+      case BlendMode::MULTIPLY: body = "s * d"; break;
+      case BlendMode::SCREEN: body = "s + d * sa - s * d"; break;
+      case BlendMode::OVERLAY:
+        body = "mix(sa - 2.0 * (sa - s) * (1.0 - d), 2.0 * s * d, vec3(lessThan(d, vec3(0.5))))";
+        break;
+      case BlendMode::DARKEN: body = "min(s, d * sa)"; break;
+      case BlendMode::LIGHTEN: body = "max(s, d * sa)"; break;
+    }
+    return "vec3 blend" + std::string(blendModeName(mode)) +
+           "(vec3 s, float sa, vec3 d)\n{\n    return " + body + ";\n}\n";
+  }
 };
 
 } // namespace csci3081
 
-#endif
\ No newline at end of file
+#endif
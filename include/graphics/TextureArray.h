@@ -0,0 +1,59 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include "Image.h"
+
+namespace csci3081 {
+
+/**
+ * @brief A GL_TEXTURE_2D_ARRAY holding one frame per layer
+ *
+ * All layers share one size, so frames are stored in the top-left corner of
+ * their layer and shaders scale their coordinates by frame size / array
+ * size. The array grows to fit the largest frame and the highest layer it
+ * is given, keeping the layers already uploaded. Layers are not mipmapped.
+ */
+class TextureArray {
+public:
+    TextureArray();
+    ~TextureArray();
+    void use() const;
+
+    /**
+     * @brief Make sure the array has at least this many layers
+     *
+     * Growing copies every layer, so callers that know how many layers they
+     * will fill reserve them up front. Before the first upload this only
+     * records the count.
+     *
+     * @param layerCount Number of layers
+     */
+    void reserve(int layerCount);
+
+    /**
+     * @brief Upload a frame into a layer, growing the array if needed
+     * @param layer Layer index
+     * @param image The frame (premultiplied RGBA)
+     */
+    void copyToGPU(int layer, const Image& image);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getLayerCount() const { return layers; }
+
+    TextureArray(const TextureArray& other) = delete;
+    TextureArray& operator=(const TextureArray& other) = delete;
+
+private:
+    void grow(int newWidth, int newHeight, int newLayers);
+
+    unsigned int texture;
+    int width;
+    int height;
+    int layers;
+    int reserved;
+};
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef PROJECT_FILE_H_
+#define PROJECT_FILE_H_
+
+#include "assets/IAssetFactory.h"
+#include "export/ExportFacade.h"
+#include "timeline/Timeline.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief Editor state saved along with the timeline
+ *
+ * Assets are saved as the strings they were created from (a path, or
+ * "text:..." for text), never as pixels.
+ */
+struct Project {
+  std::vector<std::string> assetSources;   // What each asset was created from
+  std::vector<IAsset*> assets;             // One per source (not owned)
+  std::vector<std::string> trackFilters;   // Preview shader code, one per track
+  ExportSettings exportSettings;
+};
+
+/**
+ * @brief Saves and opens projects
+ *
+ * The binary format is what the editor saves: a little-endian stream of
+ * fixed-size records that is memory-mapped and read in a single pass,
+ * so opening a project costs about as much as adding its entries to the
+ * tracks. Assets are not loaded when a project is opened; each becomes a
+ * LazyAsset that loads on its first frame.
+ *
+ * The JSON format holds the same data in a readable, diffable form.
+ *
+ * Both formats carry a version number. Files from older versions open;
+ * files from newer versions are refused.
+ *
+ * CPU filters attached with Track::addFilter() are not saved.
+ */
+class ProjectFile {
+public:
+  /**
+   * @brief Current format version
+   */
+  static const uint32_t VERSION;
+
+  /**
+   * @brief Create a project reader/writer
+   * @param factory Creates assets from their sources when opening (not owned)
+   */
+  explicit ProjectFile(const IAssetFactory* factory);
+
+  /**
+   * @brief Save a project in the binary format
+   * @param path Output file
+   * @param project Assets, filters and export settings
+   * @param timeline The timeline (every entry must use one of project.assets)
+   * @return true if saved
+   */
+  bool save(const std::string& path, const Project& project, const Timeline& timeline);
+
+  /**
+   * @brief Encode a project in the binary format, as save() writes it
+   *
+   * The same project and timeline always give the same bytes.
+   *
+   * @param project Assets, filters and export settings
+   * @param timeline The timeline (every entry must use one of project.assets)
+   * @param bytes Receives the file's contents
+   * @return true if encoded
+   */
+  bool serialize(const Project& project, const Timeline& timeline, std::string& bytes);
+
+  /**
+   * @brief Open a project saved in the binary format
+   *
+   * On success the timeline's tracks are replaced and project is
+   * overwritten; project.assets then holds new LazyAssets that the caller
+   * owns. On failure neither is changed.
+   *
+   * @param path Project file
+   * @param project Receives assets, filters and export settings
+   * @param timeline Receives the tracks
+   * @return true if opened
+   */
+  bool load(const std::string& path, Project& project, Timeline& timeline);
+
+  /**
+   * @brief Save a project as JSON
+   * @see save()
+   */
+  bool exportJson(const std::string& path, const Project& project, const Timeline& timeline);
+
+  /**
+   * @brief Open a project saved as JSON
+   * @see load()
+   */
+  bool importJson(const std::string& path, Project& project, Timeline& timeline);
+
+  /**
+   * @brief Get the last error message
+   * @return Error message, or empty string if no error
+   */
+  const std::string& getLastError() const { return lastError; }
+
+private:
+  const IAssetFactory* factory;
+  std::string lastError;
+
+  bool fail(const std::string& message);
+};
+
+} // namespace csci3081
+
+#endif // PROJECT_FILE_H_
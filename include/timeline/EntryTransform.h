@@ -0,0 +1,90 @@
+#ifndef ENTRY_TRANSFORM_H_
+#define ENTRY_TRANSFORM_H_
+
+namespace csci3081 {
+
+/**
+ * @brief The animatable fields of an EntryTransform
+ */
+enum class EntryProperty {
+  POSITION_X,
+  POSITION_Y,
+  SCALE_X,
+  SCALE_Y,
+  ROTATION,
+  OPACITY
+};
+
+const int ENTRY_PROPERTY_COUNT = 6;
+
+/**
+ * @brief Placement of a timeline entry inside the output frame
+ *
+ * All values are relative to the output frame so the same transform works
+ * for the preview and for exports at any resolution:
+ * - position is the center of the layer (0,0 = top-left, 1,1 = bottom-right)
+ * - scale is the layer size as a fraction of the frame (1,1 = fill the frame)
+ * - rotation is clockwise in degrees around the layer center
+ * - opacity multiplies the layer alpha (0 = invisible, 1 = unchanged)
+ *
+ * The default transform stretches the layer over the whole frame, which is
+ * how every layer was composited before transforms existed.
+ */
+struct EntryTransform {
+  float positionX;
+  float positionY;
+  float scaleX;
+  float scaleY;
+  float rotation;
+  float opacity;
+
+  EntryTransform()
+    : positionX(0.5f), positionY(0.5f), scaleX(1.0f), scaleY(1.0f),
+      rotation(0.0f), opacity(1.0f) {}
+
+  /**
+   * @brief Check if the layer fills the frame unrotated
+   * @return true if position, scale and rotation are the defaults
+   */
+  bool fillsFrame() const {
+    return positionX == 0.5f && positionY == 0.5f &&
+           scaleX == 1.0f && scaleY == 1.0f && rotation == 0.0f;
+  }
+
+  /**
+   * @brief Get a field by property
+   * @param property Which field to read
+   * @return The field value
+   */
+  float get(EntryProperty property) const {
+    switch (property) {
+      case EntryProperty::POSITION_X: return positionX;
+      case EntryProperty::POSITION_Y: return positionY;
+      case EntryProperty::SCALE_X: return scaleX;
+      case EntryProperty::SCALE_Y: return scaleY;
+      case EntryProperty::ROTATION: return rotation;
+      case EntryProperty::OPACITY: return opacity;
+    }
+    return 0.0f;
+  }
+
+  /**
+   * @brief Set a field by property
+   * @param property Which field to write
+   * @param value New value
+   */
+  void set(EntryProperty property, float value) {
+    switch (property) {
+      case EntryProperty::POSITION_X: positionX = value; break;
+      case EntryProperty::POSITION_Y: positionY = value; break;
+      case EntryProperty::SCALE_X: scaleX = value; break;
+      case EntryProperty::SCALE_Y: scaleY = value; break;
+      case EntryProperty::ROTATION: rotation = value; break;
+      case EntryProperty::OPACITY: opacity = value; break;
+    }
+  }
+};
+
+} // namespace csci3081
+
+#endif // ENTRY_TRANSFORM_H_
@@ -0,0 +1,225 @@
+#ifndef ENTRY_TREE_H_
+#define ENTRY_TREE_H_
+
+#include "timeline/TimelineEntry.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief The entries of a track, ordered by start time
+ *
+ * A treap (randomized balanced binary tree) keyed on start time, with
+ * subtree sizes so entries can also be reached by index. Inserting,
+ * erasing, moving and finding an entry are O(log n).
+ *
+ * shift() moves every entry from an index onwards in O(log n) by leaving
+ * an offset tag on the few subtrees involved. Tags are pushed down to the
+ * children of each node on the way to any entry, so the entries callers
+ * see always carry their current start time. Because that happens during
+ * reads too, an EntryTree must not be read from two threads at once.
+ *
+ * Copies are persistent: a copy shares every node with the original, and
+ * an edit copies only the nodes on its path, so copying is O(1) and each
+ * edit stays O(log n). Shared nodes are never modified, so a copy can be
+ * read on another thread while the original is edited. Offsets still
+ * pending in the original are pushed down before it is shared, which
+ * costs as much as the entries they cover.
+ *
+ * References to entries stay valid until the tree is next edited.
+ */
+class EntryTree {
+private:
+  struct Node;
+
+public:
+  /**
+   * @brief Visits the entries in start time order
+   */
+  class const_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef TimelineEntry value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const TimelineEntry* pointer;
+    typedef const TimelineEntry& reference;
+
+    const_iterator() {}
+
+    reference operator*() const;
+    pointer operator->() const { return &**this; }
+    const_iterator& operator++();
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    bool operator==(const const_iterator& other) const { return path == other.path; }
+    bool operator!=(const const_iterator& other) const { return path != other.path; }
+
+  private:
+    friend class EntryTree;
+
+    // Nodes whose entry hasn't been visited yet, innermost last
+    std::vector<Node*> path;
+
+    void descendLeft(Node* node);
+  };
+
+  /**
+   * @brief Returned by searches that find nothing
+   */
+  static const size_t npos;
+
+  EntryTree();
+  ~EntryTree();
+
+  /**
+   * @brief Share another tree's entries
+   * @param other The tree to copy (not modified, apart from pushing down
+   *        pending offsets)
+   */
+  EntryTree(const EntryTree& other);
+
+  EntryTree& operator=(const EntryTree&) = delete;
+
+  /**
+   * @brief Get the number of entries
+   * @return Entry count
+   */
+  size_t size() const;
+
+  /**
+   * @brief Check if there are no entries
+   * @return true if empty
+   */
+  bool empty() const { return root == nullptr; }
+
+  /**
+   * @brief Get an entry by position, O(log n)
+   * @param index Index of the entry (must be less than size())
+   * @return The entry
+   */
+  const TimelineEntry& operator[](size_t index) const;
+
+  /**
+   * @brief Get an entry for editing, O(log n)
+   *
+   * Use move() or shift() to change start times; anything else may be
+   * edited through the reference.
+   *
+   * @param index Index of the entry (must be less than size())
+   * @return The entry
+   */
+  TimelineEntry& at(size_t index);
+
+  /**
+   * @brief Get the entry that starts last
+   * @return The entry (the tree must not be empty)
+   */
+  const TimelineEntry& back() const;
+
+  /**
+   * @brief Insert an entry after any entries starting at the same time
+   * @param entry The entry
+   * @return Index of the new entry
+   */
+  size_t insert(const TimelineEntry& entry);
+
+  /**
+   * @brief Remove an entry
+   * @param index Index of the entry (must be less than size())
+   */
+  void erase(size_t index);
+
+  /**
+   * @brief Remove all entries
+   */
+  void clear();
+
+  /**
+   * @brief Change the start time of an entry and restore the order
+   * @param index Index of the entry (must be less than size())
+   * @param start New start time (in ticks)
+   * @return New index of the entry
+   */
+  size_t move(size_t index, Ticks start);
+
+  /**
+   * @brief Move every entry from an index onwards by the same amount
+   *
+   * The caller keeps the order intact: the shifted entries must not start
+   * before the entry at index - 1.
+   *
+   * @param index Index of the first entry to move
+   * @param offset Ticks to add to each start time
+   */
+  void shift(size_t index, Ticks offset);
+
+  /**
+   * @brief Count the entries starting before a time
+   * @param time The time (in ticks)
+   * @return Index of the first entry starting at or after time
+   */
+  size_t countStartingBefore(Ticks time) const;
+
+  /**
+   * @brief Find the last entry starting at or before a time
+   * @param time The time (in ticks)
+   * @return Entry index, or npos if every entry starts after time
+   */
+  size_t lastStartingAt(Ticks time) const;
+
+  const_iterator begin() const;
+  const_iterator end() const { return const_iterator(); }
+
+private:
+  struct Node {
+    TimelineEntry entry;
+    Ticks offset;        // Already applied to entry, not yet to the children
+    uint32_t priority;   // Heap order: parents have higher priorities
+    size_t size;         // Entries in this subtree
+    bool pending;        // Some node in this subtree has an offset
+    std::atomic<int> references;   // Parents and trees pointing here
+    Node* left;
+    Node* right;
+
+    Node(const TimelineEntry& entry, uint32_t priority)
+      : entry(entry), offset(0), priority(priority), size(1), pending(false),
+        references(1), left(nullptr), right(nullptr) {}
+  };
+
+  Node* root;
+  uint32_t seed;
+
+  uint32_t nextPriority();
+
+  static size_t sizeOf(const Node* node) { return node ? node->size : 0; }
+  static void push(Node* node);
+  static void update(Node* node);
+  static void settle(Node* node);
+  static void release(Node* node);
+  // Get a node only this tree points to: node itself, or a copy of it
+  static Node* own(Node* node);
+
+  // Split into entries starting at or before start, and the rest
+  static void splitAfter(Node* node, Ticks start, Node*& upTo, Node*& rest);
+  // Split into the first count entries, and the rest
+  static void splitIndex(Node* node, size_t count, Node*& first, Node*& rest);
+  // Join two trees, every entry of first starting no later than those of second
+  static Node* merge(Node* first, Node* second);
+
+  Node* nodeAt(size_t index) const;
+  Node* ownNodeAt(size_t index);
+  Node* detach(size_t index);
+  size_t attach(Node* node);
+};
+
+} // namespace csci3081
+
+#endif // ENTRY_TREE_H_
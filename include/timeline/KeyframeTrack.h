@@ -0,0 +1,99 @@
+#ifndef KEYFRAME_TRACK_H_
+#define KEYFRAME_TRACK_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief How a value moves from one keyframe to the next
+ */
+enum class Interpolation {
+  LINEAR,   // Straight line between the two values
+  BEZIER,   // Eased with a cubic-bezier curve (like CSS timing functions)
+  HOLD      // Keep this keyframe's value until the next keyframe
+};
+
+/**
+ * @brief A value pinned to a point in time
+ *
+ * The interpolation describes the segment that starts at this keyframe.
+ * For BEZIER, the easing curve runs from (0,0) to (1,1) with control points
+ * (easeOutX, easeOutY) and (easeInX, easeInY), in normalized time/value.
+ */
+struct Keyframe {
+  double time;    // Seconds, relative to the start of the entry
+  float value;
+  Interpolation interpolation;
+  float easeOutX;
+  float easeOutY;
+  float easeInX;
+  float easeInY;
+
+  Keyframe(double time = 0.0, float value = 0.0f,
+           Interpolation interpolation = Interpolation::LINEAR)
+    : time(time), value(value), interpolation(interpolation),
+      easeOutX(0.42f), easeOutY(0.0f), easeInX(0.58f), easeInY(1.0f) {}
+};
+
+/**
+ * @brief Animation curve for a single numeric property
+ *
+ * Keyframes are kept sorted by time, so evaluation is a binary search
+ * (O(log k)) followed by one interpolation. Before the first keyframe and
+ * after the last one the curve holds the nearest keyframe's value.
+ */
+class KeyframeTrack {
+public:
+  /**
+   * @brief Add a keyframe, replacing any keyframe at the same time
+   * @param keyframe The keyframe to add
+   */
+  void setKeyframe(const Keyframe& keyframe);
+
+  /**
+   * @brief Remove a keyframe by index
+   * @param index Index of the keyframe (in time order)
+   * @return true if removed, false if index out of bounds
+   */
+  bool removeKeyframe(size_t index);
+
+  /**
+   * @brief Remove all keyframes
+   */
+  void clear() { keyframes.clear(); }
+
+  /**
+   * @brief Get all keyframes in time order
+   * @return Reference to keyframe vector
+   */
+  const std::vector<Keyframe>& getKeyframes() const { return keyframes; }
+
+  /**
+   * @brief Get the number of keyframes
+   * @return Keyframe count
+   */
+  size_t getKeyframeCount() const { return keyframes.size(); }
+
+  /**
+   * @brief Check if the curve has any keyframes
+   * @return true if at least one keyframe is set
+   */
+  bool isAnimated() const { return !keyframes.empty(); }
+
+  /**
+   * @brief Evaluate the curve
+   * @param time Time relative to the start of the entry (in seconds)
+   * @param defaultValue Value returned when there are no keyframes
+   * @return The interpolated value at time
+   */
+  float evaluate(double time, float defaultValue) const;
+
+private:
+  std::vector<Keyframe> keyframes;  // Sorted by time, unique times
+};
+
+} // namespace csci3081
+
+#endif // KEYFRAME_TRACK_H_
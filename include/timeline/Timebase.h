@@ -0,0 +1,138 @@
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include <cstdint>
+
+namespace csci3081 {
+
+/**
+ * @brief A position or length on the timeline, in ticks
+ *
+ * Timeline math is done on integer ticks so that cut points, frame times
+ * and decode positions compare exactly and exports are reproducible.
+ * Seconds (double) are only used at the edges: the UI, keyframe curves and
+ * IAsset::getFrame().
+ */
+typedef int64_t Ticks;
+
+/**
+ * @brief Ticks in one second
+ *
+ * 705,600,000 is divisible by every common frame rate (24, 25, 30, 48, 50,
+ * 60, 90, 100, 120 and their NTSC 1000/1001 variants) and audio rate
+ * (44.1 and 48 kHz), so frame boundaries at those rates are whole ticks.
+ * int64_t holds about 400 years of them.
+ */
+const Ticks TICKS_PER_SECOND = 705600000;
+
+/**
+ * @brief How rescale() rounds inexact results
+ */
+enum class Rounding {
+  DOWN,     // Toward negative infinity
+  UP,       // Toward positive infinity
+  NEAREST   // Halves away from zero
+};
+
+/**
+ * @brief An exact rational number, for frame rates and stream time bases
+ */
+struct Rational {
+  int64_t num;
+  int64_t den;
+
+  Rational(int64_t num = 0, int64_t den = 1) : num(num), den(den) {}
+
+  /**
+   * @brief Get the value as a double (for display only)
+   * @return num / den
+   */
+  double toDouble() const { return den ? static_cast<double>(num) / den : 0.0; }
+
+  bool operator==(const Rational& other) const {
+    return num * other.den == other.num * den;
+  }
+  bool operator!=(const Rational& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Compute value * mul / div without intermediate overflow
+ * @param value The value to scale
+ * @param mul Multiplier
+ * @param div Divisor (must be positive)
+ * @param rounding How to round an inexact result
+ * @return The scaled value
+ */
+int64_t rescale(int64_t value, int64_t mul, int64_t div,
+                Rounding rounding = Rounding::NEAREST);
+
+/**
+ * @brief Convert seconds to the nearest tick
+ * @param seconds Time in seconds
+ * @return Time in ticks
+ */
+Ticks secondsToTicks(double seconds);
+
+/**
+ * @brief Convert ticks to seconds
+ *
+ * secondsToTicks(ticksToSeconds(t)) == t up to 2^53 ticks (about 147
+ * days), so times can pass through double APIs without drifting.
+ *
+ * @param ticks Time in ticks
+ * @return Time in seconds
+ */
+double ticksToSeconds(Ticks ticks);
+
+/**
+ * @brief Convert a stream timestamp to ticks
+ * @param timestamp Timestamp in units of timeBase (e.g. a decoded PTS)
+ * @param timeBase Seconds per timestamp unit (e.g. 1/90000)
+ * @return Time in ticks, rounded to the nearest tick
+ */
+Ticks timestampToTicks(int64_t timestamp, const Rational& timeBase);
+
+/**
+ * @brief Convert ticks to a stream timestamp
+ * @param ticks Time in ticks
+ * @param timeBase Seconds per timestamp unit
+ * @param rounding How to round when ticks fall between timestamps
+ * @return Timestamp in units of timeBase
+ */
+int64_t ticksToTimestamp(Ticks ticks, const Rational& timeBase,
+                         Rounding rounding = Rounding::NEAREST);
+
+/**
+ * @brief Get the time at which a frame starts
+ *
+ * Rounded up for rates that don't divide TICKS_PER_SECOND, so that
+ * ticksToFrame(frameToTicks(n, rate), rate) == n at every rate.
+ *
+ * @param frame Frame number (0 = first frame)
+ * @param rate Frames per second
+ * @return Start of the frame in ticks
+ */
+Ticks frameToTicks(int64_t frame, const Rational& rate);
+
+/**
+ * @brief Get the frame shown at a time
+ * @param ticks Time in ticks
+ * @param rate Frames per second
+ * @return Frame number (the last frame starting at or before ticks)
+ */
+int64_t ticksToFrame(Ticks ticks, const Rational& rate);
+
+/**
+ * @brief Get the exact rate for a frame rate given in frames per second
+ *
+ * Whole rates become n/1, NTSC rates (29.97, 23.976, 59.94...) become
+ * n*1000/1001, anything else is kept to a thousandth of a frame.
+ *
+ * @param fps Frames per second
+ * @return The rate as a fraction
+ */
+Rational rateFromDouble(double fps);
+
+} // namespace csci3081
+
+#endif // TIMEBASE_H_
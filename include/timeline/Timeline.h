@@ -2,12 +2,18 @@
 #define TIMELINE_H_
 
 #include "timeline/Track.h"
+#include "compositor/LinearFrame.h"
+#include "compositor/RenderGraph.h"
 #include "Image.h"
+#include <cstdint>
+#include <map>
 #include <vector>
 #include <memory>
 
 namespace csci3081 {
 
+class SourceNode;
+
 /**
  * @brief Manages multiple tracks and composites them into a single output
  *
@@ -21,12 +27,60 @@ namespace csci3081 {
  * - etc.
  *
  * This allows for layering effects, overlays, and complex compositions.
+ *
+ * CPU rendering goes through a RenderGraph compiled from the tracks. The
+ * graph is kept while the set of entries and transitions on screen stays
+ * the same (and no track is edited), so it is rebuilt at cuts and edits
+ * rather than every frame, and parts of the frame that don't change
+ * (still images, static overlays) are not redrawn.
+ *
+ * By default layers are blended on 8-bit sRGB values, like the original
+ * preview. CompositingMode::LINEAR_16BIT blends in linear light instead,
+ * which keeps soft edges, fades and stacked translucent layers from
+ * darkening, at some cost per layer.
+ *
+ * A Timeline is used from one thread. To render it on another thread
+ * (exports) while the UI keeps editing, take a snapshot().
  */
 class Timeline {
 public:
   Timeline();
   ~Timeline();
 
+  Timeline(const Timeline&) = delete;
+  Timeline& operator=(const Timeline&) = delete;
+
+  /**
+   * @brief Freeze the current state of the timeline
+   *
+   * The snapshot is a Timeline of its own that shares every entry with
+   * this one, so taking it costs one Track per track rather than a copy of
+   * the entries. Edits made here afterwards copy only what they change and
+   * never show up in the snapshot. The snapshot has its own render graph
+   * and may be rendered on another thread while this timeline is edited;
+   * hold the pointer for as long as that takes.
+   *
+   * Assets are not copied. Rendering the snapshot and this timeline at
+   * the same time is only safe if they don't decode the same video.
+   *
+   * @return The snapshot
+   */
+  std::shared_ptr<const Timeline> snapshot() const;
+
+  /**
+   * @brief Copy the timeline, swapping some assets for others
+   *
+   * Unlike snapshot(), every entry is copied, so the copy shares nothing
+   * that rendering changes with this timeline or with other copies. Copies
+   * whose videos are replaced by assets of their own can be rendered on
+   * different threads at the same time.
+   *
+   * @param replacements Asset to use in place of each key (not owned)
+   * @return The copy
+   */
+  std::shared_ptr<const Timeline> copyWithAssets(
+      const std::map<IAsset*, IAsset*>& replacements) const;
+
   /**
    * @brief Add a new track to the timeline
    * @param name Track name
@@ -76,10 +130,20 @@ public:
 
   /**
    * @brief Get the total duration of the timeline
+   *
+   * Cached until a track is added, removed or edited, so calling it every
+   * frame is cheap.
+   *
    * @return Duration in seconds (longest track duration)
    */
   double getTotalDuration() const;
 
+  /**
+   * @brief Get the total duration of the timeline
+   * @return Duration in ticks (longest track duration)
+   */
+  Ticks getTotalTicks() const;
+
   /**
    * @brief Render the composite frame at a given time
    * @param time The time to render (in seconds)
@@ -89,6 +153,67 @@ public:
    */
   Image* renderFrameAt(double time, int width, int height) const;
 
+  /**
+   * @brief Render the composite frame at a given time into an existing image
+   *
+   * The frame is rendered at the target's dimensions. Between cuts no memory
+   * is allocated, so callers that render many frames (playback, export) can
+   * reuse a single buffer for every frame.
+   *
+   * @param time The time to render (in seconds)
+   * @param target Image to render into (overwritten)
+   */
+  void renderFrameInto(double time, Image& target) const;
+
+  /**
+   * @brief Decode every video frame needed at a given time
+   *
+   * Video sources used at time (both sides of a transition included) are
+   * decoded concurrently on the shared ThreadPool. Entries that will start
+   * within PREFETCH_LEAD seconds are decoded too, so their decoder has
+   * already seeked to the first frame when the cut arrives.
+   * renderFrameInto() calls this itself; the GPU preview calls it before
+   * uploading track textures.
+   *
+   * @param time The time about to be rendered (in seconds)
+   */
+  void prepareFrame(double time) const;
+
+  /**
+   * @brief How far ahead upcoming entries are decoded (in seconds)
+   */
+  static const double PREFETCH_LEAD;
+
+  /**
+   * @brief Get the render graph used by the last renderFrameInto()
+   * @return The compiled graph (for inspection and statistics)
+   */
+  const RenderGraph& getRenderGraph() const { return graph; }
+
+  /**
+   * @brief Get the color drawn behind all tracks
+   * @return Background color
+   */
+  const Color& getBackgroundColor() const { return backgroundColor; }
+
+  /**
+   * @brief Set the color drawn behind all tracks
+   * @param color New background color
+   */
+  void setBackgroundColor(const Color& color) { backgroundColor = color; }
+
+  /**
+   * @brief Get how layers are blended by the CPU compositor
+   * @return The compositing mode
+   */
+  CompositingMode getCompositingMode() const { return compositingMode; }
+
+  /**
+   * @brief Set how layers are blended by the CPU compositor
+   * @param mode The compositing mode
+   */
+  void setCompositingMode(CompositingMode mode);
+
   /**
    * @brief Get the current playback time
    * @return Current time in seconds
@@ -102,15 +227,72 @@ public:
   void setCurrentTime(double time) { currentTime = time; }
 
 private:
+  /**
+   * @brief A video frame to decode before compositing
+   */
+  struct DecodeJob {
+    IAsset* asset;
+    double localTime;
+    bool conflict;    // Needed at two different times this frame
+  };
+
   std::vector<Track*> tracks;
   double currentTime;
+  Color backgroundColor;
+  CompositingMode compositingMode;
+  unsigned int revision;   // Changes when tracks are added, removed or edited
+
+  // getTotalTicks() result and the revision it was computed at
+  mutable Ticks totalTicks;
+  mutable unsigned int durationRevision;
+
+  // Per-frame scratch state, reused so rendering does not allocate
+  mutable std::vector<DecodeJob> decodeJobs;
+
+  // Render graph and the layout of tracks it was compiled for
+  mutable RenderGraph graph;
+  mutable std::vector<uintptr_t> compiledLayout;
+  mutable std::vector<uintptr_t> frameLayout;
+
+  /**
+   * @brief Queue a decode unless the asset is already queued
+   * @param asset The asset to decode
+   * @param localTime Time in the asset
+   * @param required false for prefetches, which never displace a real decode
+   */
+  void queueDecode(IAsset* asset, double localTime, bool required) const;
+
+  /**
+   * @brief ThreadPool task that decodes one DecodeJob
+   */
+  static void decodeTask(void* context, int index);
+
+  /**
+   * @brief Describe what is on screen at a time
+   *
+   * Two times with the same layout can be rendered by the same graph: the
+   * same tracks and revisions, with the same entry or transition on each.
+   *
+   * @param time The time (in seconds)
+   * @param layout Filled with the description
+   */
+  void describeLayout(double time, std::vector<uintptr_t>& layout) const;
+
+  /**
+   * @brief Rebuild the render graph for what is on screen at a time
+   * @param time The time (in seconds)
+   */
+  void compileGraph(double time) const;
 
   /**
-   * @brief Composite (blend) two images together
-   * @param bottom The bottom layer image (modified in place)
-   * @param top The top layer image
+   * @brief Add the nodes producing one entry's placed layer
+   * @param entry The entry
+   * @param track The entry's track (for its filters)
+   * @param sources SourceNodes added so far, to detect shared assets
+   * @return A TransformNode placing the entry's (filtered) frame
    */
-  void compositeImages(Image& bottom, const Image& top) const;
+  RenderNode* compileLayer(const TimelineEntry* entry, const Track* track,
+                           std::vector<SourceNode*>& sources) const;
 
   /**
    * @brief Generate default track colors
@@ -2,6 +2,11 @@
 #define TIMELINE_ENTRY_H_
 
 #include "assets/IAsset.h"
+#include "timeline/EntryTransform.h"
+#include "timeline/KeyframeTrack.h"
+#include "timeline/Timebase.h"
+#include "timeline/Transition.h"
+#include <algorithm>
 
 namespace csci3081 {
 
@@ -14,6 +19,11 @@ namespace csci3081 {
  *
  * For videos, the duration can be the full video length or trimmed.
  * For images, the duration determines how long the image is shown.
+ *
+ * Start and duration are stored in Ticks. The accessors in seconds convert
+ * on the way in and out; comparisons between entries and times are done on
+ * ticks, so an entry ending where the next starts never overlaps it and a
+ * time on a cut always belongs to the entry after the cut.
  */
 class TimelineEntry {
 public:
@@ -25,41 +35,162 @@ public:
    */
   TimelineEntry(IAsset* asset, double startTime, double duration);
 
+  /**
+   * @brief Create a timeline entry from exact tick positions
+   * @param asset The asset to place on timeline (not owned by entry)
+   * @param start When the asset should start
+   * @param length How long the asset should play
+   * @return The entry
+   */
+  static TimelineEntry fromTicks(IAsset* asset, Ticks start, Ticks length);
+
   /**
    * @brief Get the asset
    * @return Pointer to the asset
    */
   IAsset* getAsset() const { return asset; }
 
+  /**
+   * @brief Show a different asset in the same place
+   * @param a The asset (not owned by entry)
+   */
+  void setAsset(IAsset* a) { asset = a; }
+
   /**
    * @brief Get the start time
    * @return Start time in seconds
    */
-  double getStartTime() const { return startTime; }
+  double getStartTime() const { return ticksToSeconds(startTicks); }
 
   /**
    * @brief Get the duration
    * @return Duration in seconds
    */
-  double getDuration() const { return duration; }
+  double getDuration() const { return ticksToSeconds(durationTicks); }
 
   /**
    * @brief Get the end time (start + duration)
    * @return End time in seconds
    */
-  double getEndTime() const { return startTime + duration; }
+  double getEndTime() const { return ticksToSeconds(getEndTicks()); }
+
+  /**
+   * @brief Get the start time
+   * @return Start time in ticks
+   */
+  Ticks getStartTicks() const { return startTicks; }
+
+  /**
+   * @brief Get the duration
+   * @return Duration in ticks
+   */
+  Ticks getDurationTicks() const { return durationTicks; }
+
+  /**
+   * @brief Get the end time (start + duration)
+   * @return End time in ticks
+   */
+  Ticks getEndTicks() const { return startTicks + durationTicks; }
 
   /**
    * @brief Set the start time
    * @param time New start time in seconds
    */
-  void setStartTime(double time) { startTime = time; }
+  void setStartTime(double time) { setStartTicks(secondsToTicks(time)); }
+
+  /**
+   * @brief Set the start time
+   * @param ticks New start time in ticks
+   */
+  void setStartTicks(Ticks ticks) {
+    startTicks = ticks;
+    invalidateTransformCache();
+  }
 
   /**
    * @brief Set the duration
    * @param dur New duration in seconds
    */
-  void setDuration(double dur) { duration = dur; }
+  void setDuration(double dur) { durationTicks = secondsToTicks(dur); }
+
+  /**
+   * @brief Set the duration
+   * @param ticks New duration in ticks
+   */
+  void setDurationTicks(Ticks ticks) { durationTicks = ticks; }
+
+  /**
+   * @brief Get the static placement of this entry in the output frame
+   *
+   * Properties with keyframes override these values; use getTransformAt()
+   * to get the placement at a given time.
+   *
+   * @return Position, scale, rotation and opacity
+   */
+  const EntryTransform& getTransform() const { return transform; }
+
+  /**
+   * @brief Set the static placement of this entry in the output frame
+   * @param t New transform
+   */
+  void setTransform(const EntryTransform& t) {
+    transform = t;
+    invalidateTransformCache();
+  }
+
+  /**
+   * @brief Get the keyframes of an animated property
+   * @param property The property
+   * @return The property's keyframe curve (empty if not animated)
+   */
+  const KeyframeTrack& getKeyframes(EntryProperty property) const {
+    return keyframes[static_cast<int>(property)];
+  }
+
+  /**
+   * @brief Replace the keyframes of a property
+   * @param property The property to animate
+   * @param track Keyframes with times relative to the entry start
+   */
+  void setKeyframes(EntryProperty property, const KeyframeTrack& track);
+
+  /**
+   * @brief Add or replace a single keyframe of a property
+   * @param property The property to animate
+   * @param keyframe Keyframe with time relative to the entry start
+   */
+  void setKeyframe(EntryProperty property, const Keyframe& keyframe);
+
+  /**
+   * @brief Check if any property has keyframes
+   * @return true if the placement changes over time
+   */
+  bool isAnimated() const;
+
+  /**
+   * @brief Get the placement of this entry at a given global time
+   *
+   * Animated properties are evaluated from their keyframes, the rest come
+   * from getTransform(). The result for the last requested time is cached,
+   * so repeated requests for the same frame only evaluate the curves once.
+   * The cache is not synchronized; evaluate an entry from one thread at a
+   * time, or use evaluateTransformAt().
+   *
+   * @param globalTime The global timeline time (in seconds)
+   * @return The evaluated transform (valid until the next call)
+   */
+  const EntryTransform& getTransformAt(double globalTime) const;
+
+  /**
+   * @brief Get the placement of this entry at a given global time, uncached
+   *
+   * Same result as getTransformAt() without touching the cache, so entries
+   * shared with a Timeline snapshot can be evaluated on another thread.
+   *
+   * @param globalTime The global timeline time (in seconds)
+   * @return The evaluated transform
+   */
+  EntryTransform evaluateTransformAt(double globalTime) const;
 
   /**
    * @brief Check if this entry is active at a given time
@@ -67,7 +198,16 @@ public:
    * @return true if time is within [startTime, endTime), false otherwise
    */
   bool isActiveAt(double time) const {
-    return time >= startTime && time < getEndTime();
+    return isActiveAtTicks(secondsToTicks(time));
+  }
+
+  /**
+   * @brief Check if this entry is active at a given time
+   * @param ticks The time to check
+   * @return true if ticks is within [start, end), false otherwise
+   */
+  bool isActiveAtTicks(Ticks ticks) const {
+    return ticks >= startTicks && ticks < getEndTicks();
   }
 
   /**
@@ -76,11 +216,61 @@ public:
    * @return The image frame to display
    */
   const Image& getFrameAt(double globalTime) const {
-    // Convert global time to asset-local time
-    double localTime = globalTime - startTime;
-    return asset->getFrame(localTime);
+    return asset->getFrame(getLocalTime(globalTime));
   }
 
+  /**
+   * @brief Convert a global time to asset-local time
+   *
+   * Times before the entry starts map to 0, so an incoming entry that is
+   * shown early by a transition holds its first frame.
+   *
+   * @param globalTime The global timeline time (in seconds)
+   * @return Time in the asset (in seconds)
+   */
+  double getLocalTime(double globalTime) const {
+    return ticksToSeconds(getLocalTicks(secondsToTicks(globalTime)));
+  }
+
+  /**
+   * @brief Convert a global time to asset-local time
+   * @param globalTicks The global timeline time
+   * @return Time in the asset, in ticks (0 before the entry starts)
+   */
+  Ticks getLocalTicks(Ticks globalTicks) const {
+    return std::max<Ticks>(0, globalTicks - startTicks);
+  }
+
+  /**
+   * @brief Check if this entry has a transition into the next entry
+   * @return true if a transition is attached
+   */
+  bool hasOutTransition() const { return hasTransition; }
+
+  /**
+   * @brief Get the transition into the next entry
+   * @return The transition (only meaningful if hasOutTransition())
+   */
+  const Transition& getOutTransition() const { return outTransition; }
+
+  /**
+   * @brief Attach a transition into the next entry on the track
+   *
+   * Use Track::setTransition() to validate the transition against the
+   * neighbouring entry.
+   *
+   * @param transition The transition
+   */
+  void setOutTransition(const Transition& transition) {
+    outTransition = transition;
+    hasTransition = true;
+  }
+
+  /**
+   * @brief Remove the transition into the next entry
+   */
+  void clearOutTransition() { hasTransition = false; }
+
   /**
    * @brief Check if this entry overlaps with another entry
    * @param other The other entry to check
@@ -88,13 +278,24 @@ public:
    */
   bool overlapsWith(const TimelineEntry& other) const {
     // Two intervals overlap if: start1 < end2 AND start2 < end1
-    return startTime < other.getEndTime() && other.startTime < getEndTime();
+    return startTicks < other.getEndTicks() && other.startTicks < getEndTicks();
   }
 
 private:
   IAsset* asset;      // Not owned - Application manages asset lifetime
-  double startTime;   // Start time in seconds
-  double duration;    // Duration in seconds
+  Ticks startTicks;
+  Ticks durationTicks;
+  EntryTransform transform;
+  KeyframeTrack keyframes[ENTRY_PROPERTY_COUNT];
+  bool hasTransition;
+  Transition outTransition;   // Into the next entry on the track
+
+  // Last evaluated transform, keyed by global time
+  mutable bool cacheValid;
+  mutable double cachedTime;
+  mutable EntryTransform cachedTransform;
+
+  void invalidateTransformCache() { cacheValid = false; }
 };
 
 } // namespace csci3081
@@ -1,11 +1,14 @@
 #ifndef TRACK_H_
 #define TRACK_H_
 
+#include "timeline/EntryTree.h"
 #include "timeline/TimelineEntry.h"
+#include "compositor/Blend.h"
+#include "filters/IFilter.h"
 #include "graphics/Color.h"
 #include <vector>
 #include <string>
-#include <algorithm>
+#include <memory>
 
 namespace csci3081 {
 
@@ -18,9 +21,28 @@ namespace csci3081 {
  *
  * Tracks are rendered in order (track 0 first, then track 1 on top, etc.)
  * to create the final composite image.
+ *
+ * Because entries are kept sorted and never overlap, they form an interval
+ * index: lookups by time are O(log n) tree searches, and a playback cursor
+ * remembers the last entry found so sequential lookups (playback, export)
+ * only look at that entry and the next one. Edits are O(log n) too,
+ * including ripple edits that move every later entry.
+ *
+ * Lookups update the cursor and the entry tree, so a track must not be
+ * read from two threads at once.
  */
 class Track {
 public:
+  /**
+   * @brief A transition in progress at some time
+   */
+  struct ActiveTransition {
+    const TimelineEntry* from;      // Outgoing entry
+    const TimelineEntry* to;        // Incoming entry
+    const Transition* transition;
+    double progress;                // 0 at the start, 1 at the end
+  };
+
   /**
    * @brief Create a track with optional name and color
    * @param name Track name (e.g., "Video Layer 1")
@@ -30,19 +52,39 @@ public:
 
   ~Track();
 
+  /**
+   * @brief Copy a track, sharing its entries
+   *
+   * O(1): the copy shares the original's entry tree, and whichever track
+   * is edited next copies only the tree nodes it changes. The copy can be
+   * read on another thread while the original is edited. Filters are
+   * shared, and the copy is not connected to the original's edit counter.
+   *
+   * @param other The track to copy
+   */
+  Track(const Track& other);
+
+  Track& operator=(const Track&) = delete;
+
   /**
    * @brief Add an entry to the track
+   *
+   * A ripple insert first moves the entries starting at or after the new
+   * entry later by its duration, making room for it.
+   *
    * @param entry The timeline entry to add
+   * @param ripple Push later entries back instead of failing on overlap
    * @return true if added successfully, false if it would overlap with existing entry
    */
-  bool addEntry(const TimelineEntry& entry);
+  bool addEntry(const TimelineEntry& entry, bool ripple = false);
 
   /**
    * @brief Remove an entry at a specific index
    * @param index Index of entry to remove
+   * @param ripple Move later entries earlier to close the hole
    * @return true if removed, false if index out of bounds
    */
-  bool removeEntry(size_t index);
+  bool removeEntry(size_t index, bool ripple = false);
 
   /**
    * @brief Update the start time of an entry
@@ -56,9 +98,84 @@ public:
    * @brief Update the duration of an entry
    * @param index Index of entry to update
    * @param newDuration New duration in seconds
+   * @param ripple Move later entries by the change instead of failing on overlap
    * @return true if updated successfully, false if would cause overlap or duration invalid
    */
-  bool updateEntryDuration(size_t index, double newDuration);
+  bool updateEntryDuration(size_t index, double newDuration, bool ripple = false);
+
+  /**
+   * @brief Move an entry and every entry after it by the same amount
+   *
+   * O(log n) however many entries follow.
+   *
+   * @param index Index of the first entry to move
+   * @param offset Seconds to add to each start time (negative for earlier)
+   * @return true if moved, false if index invalid or the first moved entry
+   *         would start before 0 or overlap the entry before it
+   */
+  bool shiftEntries(size_t index, double offset);
+
+  /**
+   * @brief Replace the keyframes of one property of an entry
+   * @param index Index of entry to update
+   * @param property The property to animate
+   * @param keyframes Keyframes with times relative to the entry start
+   * @return true if updated, false if index out of bounds
+   */
+  bool updateEntryKeyframes(size_t index, EntryProperty property,
+                            const KeyframeTrack& keyframes);
+
+  /**
+   * @brief Attach a transition between an entry and the next one
+   *
+   * The two entries must touch (the first ends where the second starts),
+   * and each must be at least half the transition duration long.
+   *
+   * @param index Index of the outgoing entry
+   * @param transition The transition
+   * @return true if attached, false if the entries can't take it
+   */
+  bool setTransition(size_t index, const Transition& transition);
+
+  /**
+   * @brief Check if two entries can take a transition between them
+   * @param from The outgoing entry
+   * @param to The incoming entry
+   * @param transition The transition
+   * @return true if setTransition() would attach it
+   */
+  static bool canTransition(const TimelineEntry& from, const TimelineEntry& to,
+                            const Transition& transition);
+
+  /**
+   * @brief Check if an entry ends where the next one starts
+   *
+   * Entries less than 1ms apart count as touching, so entries placed by
+   * dragging still take transitions.
+   *
+   * @param from The earlier entry
+   * @param to The later entry
+   * @return true if they touch
+   */
+  static bool adjacent(const TimelineEntry& from, const TimelineEntry& to);
+
+  /**
+   * @brief Remove the transition after an entry
+   * @param index Index of the outgoing entry
+   * @return true if removed, false if index out of bounds
+   */
+  bool removeTransition(size_t index);
+
+  /**
+   * @brief Get the transition in progress at a given time
+   *
+   * Transitions whose entries were moved apart are ignored.
+   *
+   * @param time The time to check (in seconds)
+   * @param active Filled in if a transition is in progress
+   * @return true if a transition covers time
+   */
+  bool getTransitionAt(double time, ActiveTransition& active) const;
 
   /**
    * @brief Clear all entries from the track
@@ -67,16 +184,49 @@ public:
 
   /**
    * @brief Get the entry active at a given time
+   *
+   * O(1) when time is in the entry found by the previous lookup or the one
+   * after it, O(log n) otherwise.
+   *
    * @param time The time to check (in seconds)
    * @return Pointer to active entry, or nullptr if no entry at that time
    */
   const TimelineEntry* getEntryAt(double time) const;
 
+  /**
+   * @brief Get the index of the entry active at a given time
+   * @param time The time to check (in seconds)
+   * @return Entry index, or npos if no entry at that time
+   */
+  size_t getEntryIndexAt(double time) const;
+
+  /**
+   * @brief Get the index of the entry active at a given time
+   * @param time The time to check (in ticks)
+   * @return Entry index, or npos if no entry at that time
+   */
+  size_t getEntryIndexAtTicks(Ticks time) const;
+
+  /**
+   * @brief Returned by getEntryIndexAt() when no entry is active
+   */
+  static const size_t npos;
+
   /**
    * @brief Get all entries on this track
-   * @return Vector of timeline entries
+   *
+   * Iterate over the result to visit every entry; indexing it is O(log n).
+   *
+   * @return Timeline entries in start time order
+   */
+  const EntryTree& getEntries() const { return entries; }
+
+  /**
+   * @brief Get one entry
+   * @param index Index of the entry (must be less than getEntryCount())
+   * @return The entry
    */
-  const std::vector<TimelineEntry>& getEntries() const { return entries; }
+  const TimelineEntry& getEntry(size_t index) const { return entries[index]; }
 
   /**
    * @brief Get the number of entries
@@ -118,7 +268,61 @@ public:
    * @brief Set track visibility
    * @param v Visibility state
    */
-  void setVisible(bool v) { visible = v; }
+  void setVisible(bool v) { visible = v; touch(); }
+
+  /**
+   * @brief Get how this track combines with the tracks below it
+   * @return The track's blend mode
+   */
+  BlendMode getBlendMode() const { return blendMode; }
+
+  /**
+   * @brief Set how this track combines with the tracks below it
+   * @param mode New blend mode
+   */
+  void setBlendMode(BlendMode mode) { blendMode = mode; touch(); }
+
+  /**
+   * @brief Add a CPU filter applied to every entry on this track
+   *
+   * Filters run in the order they were added, on each entry's frame before
+   * it is placed by its transform. Exports and other CPU renders use them;
+   * the GPU preview has its own GLSL filters.
+   *
+   * @param filter The filter (shared with any render graph using it)
+   */
+  void addFilter(const std::shared_ptr<IFilter>& filter);
+
+  /**
+   * @brief Remove all CPU filters
+   */
+  void clearFilters();
+
+  /**
+   * @brief Get the CPU filters, in the order they are applied
+   * @return The filters
+   */
+  const std::vector<std::shared_ptr<IFilter> >& getFilters() const { return filters; }
+
+  /**
+   * @brief Get a counter that changes every time the track is edited
+   *
+   * The Timeline compares revisions to know when the render graph it
+   * compiled from this track is out of date.
+   *
+   * @return Revision number
+   */
+  unsigned int getRevision() const { return revision; }
+
+  /**
+   * @brief Share a counter that is incremented on every edit of this track
+   *
+   * The Timeline passes its own revision so it can cache values computed
+   * from all tracks without polling each one.
+   *
+   * @param counter The counter (nullptr to stop sharing)
+   */
+  void setEditCounter(unsigned int* counter) { editCounter = counter; }
 
   /**
    * @brief Get the total duration of all entries on this track
@@ -126,18 +330,55 @@ public:
    */
   double getTotalDuration() const;
 
+  /**
+   * @brief Get the end time of the last entry on this track
+   * @return Duration in ticks
+   */
+  Ticks getTotalTicks() const;
+
 private:
   std::string name;
   Color color;
   bool visible;
-  std::vector<TimelineEntry> entries;
+  BlendMode blendMode;
+  EntryTree entries;
+  std::vector<std::shared_ptr<IFilter> > filters;
+  unsigned int revision;
+  unsigned int* editCounter;   // Also incremented on edits (not owned)
+
+  // The entry found by the last lookup and the one after it, valid while
+  // revision == cursorRevision
+  struct Cursor {
+    size_t index;
+    const TimelineEntry* entry;
+    const TimelineEntry* next;
+  };
+  mutable Cursor cursor;
+  mutable unsigned int cursorRevision;
+
+  /**
+   * @brief Record an edit
+   */
+  void touch();
+
+  /**
+   * @brief Point the playback cursor at an entry
+   * @param index Entry index, or npos to clear the cursor
+   */
+  void moveCursor(size_t index) const;
 
   /**
-   * @brief Check if an entry would overlap with existing entries
-   * @param entry The entry to check
+   * @brief Check if an interval would overlap with existing entries
+   *
+   * Only the entry starting last before the interval ends needs checking,
+   * since entries are sorted and disjoint.
+   *
+   * @param startTime Start of the new interval (in ticks)
+   * @param endTime End of the new interval (in ticks)
+   * @param ignore Index of an entry to skip (the one being edited), or npos
    * @return true if would overlap, false otherwise
    */
-  bool wouldOverlap(const TimelineEntry& entry) const;
+  bool wouldOverlap(Ticks startTime, Ticks endTime, size_t ignore = npos) const;
 };
 
 } // namespace csci3081
@@ -0,0 +1,52 @@
+#ifndef TRANSITION_H_
+#define TRANSITION_H_
+
+#include "graphics/Color.h"
+
+namespace csci3081 {
+
+/**
+ * @brief Kinds of transition between two adjacent entries
+ */
+enum class TransitionType {
+  CROSSFADE,     // Outgoing fades into incoming
+  WIPE,          // Incoming is revealed from left to right
+  DIP_TO_COLOR   // Outgoing fades to a color, then the color fades to incoming
+};
+
+const int TRANSITION_TYPE_COUNT = 3;
+
+/**
+ * @brief A transition at the cut between an entry and the next one
+ *
+ * The transition is centered on the cut: it starts duration/2 before the
+ * outgoing entry ends and finishes duration/2 after the incoming entry
+ * starts. During that window both entries are rendered.
+ */
+struct Transition {
+  TransitionType type;
+  double duration;   // Seconds
+  Color color;       // Used by DIP_TO_COLOR
+
+  Transition(TransitionType type = TransitionType::CROSSFADE,
+             double duration = 1.0)
+    : type(type), duration(duration), color(0, 0, 0, 255) {}
+};
+
+/**
+ * @brief Get the display name of a transition type (e.g. "Crossfade")
+ * @param type The transition type
+ * @return Name of the type
+ */
+inline const char* transitionTypeName(TransitionType type) {
+  switch (type) {
+    case TransitionType::CROSSFADE: return "Crossfade";
+    case TransitionType::WIPE: return "Wipe";
+    case TransitionType::DIP_TO_COLOR: return "Dip to Color";
+  }
+  return "Crossfade";
+}
+
+} // namespace csci3081
+
+#endif // TRANSITION_H_
@@ -5,6 +5,7 @@
 #include "ui/export/ExportMenuView.h"
 #include "export/ExportFacade.h"
 #include "commands/ICommand.h"
+#include "commands/ExportJobManager.h"
 #include <string>
 
 namespace csci3081 {
@@ -25,6 +26,8 @@ class ExportMenuView;
  * - ExportMenuController is the Controller (user interaction handling)
  *
  * The controller also uses the Command pattern to execute export operations.
+ * With a job manager, timeline videos are exported on worker threads so
+ * the editor stays responsive; otherwise every export runs on the caller.
  */
 class ExportMenuController {
 public:
@@ -38,6 +41,12 @@ public:
 
   ~ExportMenuController();
 
+  /**
+   * @brief Export timeline videos in the background
+   * @param jobs Runs the exports (not owned), or nullptr to export on the caller
+   */
+  void setJobManager(ExportJobManager* jobs) { this->jobs = jobs; }
+
   /**
    * @brief Handle format button click
    * @param format The format to select
@@ -54,6 +63,16 @@ public:
    */
   void onExportVideoClicked();
 
+  /**
+   * @brief Handle timeline option button click (see ExportMenuModel::nextTimelineOption())
+   */
+  void onTimelineOptionClicked();
+
+  /**
+   * @brief Handle cancel exports button click (stops every background export)
+   */
+  void onCancelExportsClicked();
+
   /**
    * @brief Set the filename for export
    * @param filename The filename to use
@@ -79,6 +98,7 @@ private:
   ExportMenuModel* model;
   ExportMenuView* view;
   ExportFacade* facade;
+  ExportJobManager* jobs;
 
   /**
    * @brief Execute a command
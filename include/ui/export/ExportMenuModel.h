@@ -74,6 +74,23 @@ public:
    */
   const std::string& getFilename() const { return filename; }
 
+  /**
+   * @brief Switch to the next way of exporting the timeline in the current format
+   *
+   * In an image format the timeline is exported as a single frame (the
+   * default) or as a numbered file per frame. An MP4 is encoded whole
+   * (the default), resumably (keeping each finished segment so an
+   * interrupted export can go on where it stopped), reusing the segments
+   * of the last export that an edit didn't change, or both.
+   */
+  void nextTimelineOption();
+
+  /**
+   * @brief Describe how the timeline is exported in the current format
+   * @return e.g. "Single frame", or empty if the format has no options
+   */
+  std::string getTimelineOptionLabel() const;
+
   /**
    * @brief Get available export formats for current asset
    * @return Vector of available export formats
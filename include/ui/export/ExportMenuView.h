@@ -2,8 +2,10 @@
 #define EXPORT_MENU_VIEW_H_
 
 #include "ui/export/ExportMenuModel.h"
+#include "commands/ExportJobManager.h"
 #include "ui/Container.h"
 #include "ui/TextButton.h"
+#include <string>
 #include <vector>
 
 namespace csci3081 {
@@ -24,9 +26,14 @@ class ExportMenuController;
  *
  * The view contains buttons for:
  * - Selecting export format (PNG, JPEG, BMP)
+ * - Choosing how the timeline is exported in that format
  * - Exporting the current asset
+ * - Cancelling background exports, while there are any
+ *
+ * It also observes the export jobs and draws a progress bar for each of
+ * the latest few.
  */
-class ExportMenuView {
+class ExportMenuView : public IExportJobObserver {
 public:
   /**
    * @brief Create an export menu view
@@ -38,7 +45,7 @@ public:
    */
   ExportMenuView(float x, float y, float w, float h, ExportMenuModel* model);
 
-  ~ExportMenuView();
+  ~ExportMenuView() override;
 
   /**
    * @brief Set the controller for this view
@@ -72,11 +79,20 @@ public:
    */
   const std::vector<Button*>& getButtons() const { return buttons; }
 
+  /**
+   * @brief Show the state of the export jobs
+   * @param jobs Every job, oldest first
+   */
+  void onJobsChanged(const std::vector<ExportJobStatus>& jobs) override;
+
 private:
   ExportMenuModel* model;
   ExportMenuController* controller;
   Container* container;
   std::vector<Button*> buttons;
+  std::vector<Glyph*> jobGlyphs;          // Progress bars and their labels
+  std::vector<std::string> jobLabels;     // What jobGlyphs show, without the speed
+  bool jobsActive;                        // Some job is queued or running
 
   float x, y, w, h;
 
@@ -89,6 +105,11 @@ private:
    * @brief Clear all UI elements
    */
   void clearUI();
+
+  /**
+   * @brief Clear the progress bars
+   */
+  void clearJobs();
 };
 
 } // namespace csci3081
@@ -0,0 +1,93 @@
+#ifndef BOUNDED_QUEUE_H_
+#define BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace csci3081 {
+
+/**
+ * @brief Blocking FIFO with a fixed capacity, for handing work between threads
+ *
+ * push() waits while the queue is full and pop() waits while it is empty,
+ * so a fast producer can never run more than capacity items ahead of its
+ * consumer. close() wakes everyone: later pushes fail, and pops fail once
+ * the items already queued have been taken.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+  /**
+   * @brief Create an empty queue
+   * @param capacity Most items held at once (at least 1)
+   */
+  explicit BoundedQueue(size_t capacity)
+    : capacity(capacity > 0 ? capacity : 1), closed(false) {}
+
+  /**
+   * @brief Add an item, waiting for room
+   * @param item The item
+   * @return false if the queue was closed (the item is not added)
+   */
+  bool push(const T& item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+    if (closed) {
+      return false;
+    }
+    items.push_back(item);
+    notEmpty.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Take the oldest item, waiting for one
+   * @param item Receives the item
+   * @return false if the queue is closed and empty
+   */
+  bool pop(T& item) {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+    if (items.empty()) {
+      return false;
+    }
+    item = items.front();
+    items.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Stop accepting items and wake every waiting thread
+   */
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    notFull.notify_all();
+    notEmpty.notify_all();
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return items.size();
+  }
+
+  size_t getCapacity() const { return capacity; }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+private:
+  std::deque<T> items;
+  size_t capacity;
+  bool closed;
+  mutable std::mutex mutex;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+};
+
+} // namespace csci3081
+
+#endif // BOUNDED_QUEUE_H_
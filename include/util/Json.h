@@ -0,0 +1,121 @@
+#ifndef JSON_H_
+#define JSON_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief A JSON document or part of one
+ *
+ * Just enough JSON for human-readable project files: objects keep their
+ * members in insertion order so the same project always prints the same
+ * way, and integers are kept exactly (as int64) rather than as doubles.
+ */
+class JsonValue {
+public:
+  enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+  JsonValue() : type(Type::NUL), boolean(false), number(0.0), integer(0), exact(false) {}
+  JsonValue(bool value);
+  JsonValue(int value);
+  JsonValue(int64_t value);
+  JsonValue(double value);
+  JsonValue(const char* value);
+  JsonValue(const std::string& value);
+
+  /**
+   * @brief Create an empty array
+   */
+  static JsonValue array();
+
+  /**
+   * @brief Create an empty object
+   */
+  static JsonValue object();
+
+  Type getType() const { return type; }
+  bool isNull() const { return type == Type::NUL; }
+
+  /**
+   * @brief Read a value, falling back to a default if it has another type
+   */
+  bool asBool(bool defaultValue = false) const;
+  double asDouble(double defaultValue = 0.0) const;
+  int64_t asInt(int64_t defaultValue = 0) const;
+  std::string asString(const std::string& defaultValue = "") const;
+
+  /**
+   * @brief Get the number of array items or object members
+   * @return Item count, 0 for other types
+   */
+  size_t size() const;
+
+  /**
+   * @brief Get an array item
+   * @param index Item index
+   * @return The item, or null if out of range
+   */
+  const JsonValue& operator[](size_t index) const;
+  const JsonValue& operator[](int index) const {
+    return (*this)[static_cast<size_t>(index)];
+  }
+
+  /**
+   * @brief Get an object member
+   * @param key Member name
+   * @return The member, or null if missing
+   */
+  const JsonValue& operator[](const std::string& key) const;
+  const JsonValue& operator[](const char* key) const { return (*this)[std::string(key)]; }
+
+  /**
+   * @brief Append to an array
+   * @param item The item
+   */
+  void push(const JsonValue& item);
+
+  /**
+   * @brief Add or replace an object member
+   * @param key Member name
+   * @param value The value
+   */
+  void set(const std::string& key, const JsonValue& value);
+
+  /**
+   * @brief Print as JSON text
+   * @param indent Spaces per nesting level, or 0 for a single line
+   * @return The text
+   */
+  std::string dump(int indent = 2) const;
+
+  /**
+   * @brief Parse JSON text
+   * @param text The text
+   * @param result The parsed value
+   * @param error Description of the first problem found
+   * @return true if the whole text is one valid value
+   */
+  static bool parse(const std::string& text, JsonValue& result, std::string& error);
+
+private:
+  Type type;
+  bool boolean;
+  double number;
+  int64_t integer;
+  bool exact;   // number is an integer, kept in integer
+  std::string text;
+  std::vector<JsonValue> items;
+  std::vector<std::pair<std::string, JsonValue> > members;
+
+  void dump(std::string& out, int indent, int depth) const;
+  friend class JsonParser;
+};
+
+} // namespace csci3081
+
+#endif // JSON_H_
@@ -0,0 +1,59 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief Read-only view of a whole file
+ *
+ * The file is memory-mapped, so opening it costs the same however large
+ * it is and only the pages that are read get loaded. Where mmap is not
+ * available the file is read into memory instead.
+ */
+class MappedFile {
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * @brief Map a file, closing any file mapped before
+   * @param path Path of the file
+   * @return true if the file could be opened
+   */
+  bool open(const std::string& path);
+
+  /**
+   * @brief Unmap the file
+   */
+  void close();
+
+  /**
+   * @brief Get the file contents
+   * @return First byte, or nullptr if nothing is mapped or the file is empty
+   */
+  const uint8_t* data() const { return bytes; }
+
+  /**
+   * @brief Get the file size
+   * @return Size in bytes
+   */
+  size_t size() const { return length; }
+
+private:
+  const uint8_t* bytes;
+  size_t length;
+  bool mapped;                  // bytes came from mmap, not buffer
+  std::vector<uint8_t> buffer;  // Fallback copy of the file
+};
+
+} // namespace csci3081
+
+#endif // MAPPED_FILE_H_
@@ -0,0 +1,91 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace csci3081 {
+
+/**
+ * @brief Fixed set of worker threads for data-parallel loops
+ *
+ * parallelFor() splits a loop over [0, count) between the workers and the
+ * calling thread and returns when every index has run. Tasks are plain
+ * function pointers with a context pointer, so dispatching work does not
+ * allocate and can be used from per-frame code such as the compositor.
+ *
+ * Calls from different threads are serialized. A task must not call
+ * parallelFor() on the same pool.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Signature of a loop body
+   * @param context Caller data passed to parallelFor()
+   * @param index Loop index in [0, count)
+   */
+  typedef void (*Task)(void* context, int index);
+
+  /**
+   * @brief Start the worker threads
+   * @param threadCount Number of workers (the caller also runs tasks)
+   */
+  explicit ThreadPool(int threadCount);
+
+  /**
+   * @brief Stop and join the worker threads
+   */
+  ~ThreadPool();
+
+  /**
+   * @brief Run task(context, i) for every i in [0, count)
+   * @param count Number of loop iterations
+   * @param task Loop body
+   * @param context Data passed to every call of task
+   */
+  void parallelFor(int count, Task task, void* context);
+
+  /**
+   * @brief Get the number of worker threads
+   * @return Worker count (not including the calling thread)
+   */
+  int getThreadCount() const { return static_cast<int>(workers.size()); }
+
+  /**
+   * @brief Get the pool shared by the compositor and exporters
+   *
+   * Created on first use with one worker per hardware thread, minus the
+   * calling thread.
+   *
+   * @return The shared pool
+   */
+  static ThreadPool& shared();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+  void workerLoop();
+  void runTasks();
+
+  std::vector<std::thread> workers;
+  std::mutex callMutex;           // Serializes parallelFor() callers
+  std::mutex mutex;               // Guards the fields below
+  std::condition_variable wake;   // Signals workers that a loop started
+  std::condition_variable idle;   // Signals the caller that workers finished
+
+  Task task;
+  void* context;
+  int count;
+  std::atomic<int> nextIndex;
+  int busyWorkers;
+  unsigned int generation;
+  bool stopping;
+};
+
+} // namespace csci3081
+
+#endif // THREAD_POOL_H_
@@ -1,4 +1,5 @@
 #include "video_reader.hpp"
+#include <algorithm>
 #include <iostream>
 
 // av_err2str returns a temporary array. This doesn't work in gcc.
@@ -42,12 +43,12 @@ bool video_reader_open(VideoReaderState *state, const char *filename) {
   // Open the file using libavformat
   av_format_ctx = avformat_alloc_context();
   if (!av_format_ctx) {
-    printf("Couldn't created AVFormatContext\n");
+    fprintf(stderr, "Couldn't created AVFormatContext\n");
     return false;
   }
 
   if (avformat_open_input(&av_format_ctx, filename, NULL, NULL) != 0) {
-    printf("Couldn't open video file\n");
+    fprintf(stderr, "Couldn't open video file\n");
     return false;
   }
 
@@ -70,37 +71,39 @@ bool video_reader_open(VideoReaderState *state, const char *filename) {
       width = av_codec_params->width;
       height = av_codec_params->height;
       time_base = av_format_ctx->streams[i]->time_base;
+      state->frame_rate =
+          av_guess_frame_rate(av_format_ctx, av_format_ctx->streams[i], NULL);
       break;
     }
   }
   if (video_stream_index == -1) {
-    printf("Couldn't find valid video stream inside file\n");
+    fprintf(stderr, "Couldn't find valid video stream inside file\n");
     return false;
   }
 
   // Set up a codec context for the decoder
   av_codec_ctx = avcodec_alloc_context3(av_codec);
   if (!av_codec_ctx) {
-    printf("Couldn't create AVCodecContext\n");
+    fprintf(stderr, "Couldn't create AVCodecContext\n");
     return false;
   }
   if (avcodec_parameters_to_context(av_codec_ctx, av_codec_params) < 0) {
-    printf("Couldn't initialize AVCodecContext\n");
+    fprintf(stderr, "Couldn't initialize AVCodecContext\n");
     return false;
   }
   if (avcodec_open2(av_codec_ctx, av_codec, NULL) < 0) {
-    printf("Couldn't open codec\n");
+    fprintf(stderr, "Couldn't open codec\n");
     return false;
   }
 
   av_frame = av_frame_alloc();
   if (!av_frame) {
-    printf("Couldn't allocate AVFrame\n");
+    fprintf(stderr, "Couldn't allocate AVFrame\n");
     return false;
   }
   av_packet = av_packet_alloc();
   if (!av_packet) {
-    printf("Couldn't allocate AVPacket\n");
+    fprintf(stderr, "Couldn't allocate AVPacket\n");
     return false;
   }
 
@@ -130,7 +133,7 @@ bool video_reader_read_frame(VideoReaderState *state, uint8_t *frame_buffer,
 
     response = avcodec_send_packet(av_codec_ctx, av_packet);
     if (response < 0) {
-      printf("Failed to decode packet: %s\n", av_make_error(response));
+      fprintf(stderr, "Failed to decode packet: %s\n", av_make_error(response));
       return false;
     }
 
@@ -139,7 +142,7 @@ bool video_reader_read_frame(VideoReaderState *state, uint8_t *frame_buffer,
       av_packet_unref(av_packet);
       continue;
     } else if (response < 0) {
-      printf("Failed to decode packet: %s\n", av_make_error(response));
+      fprintf(stderr, "Failed to decode packet: %s\n", av_make_error(response));
       return false;
     }
 
@@ -158,7 +161,7 @@ bool video_reader_read_frame(VideoReaderState *state, uint8_t *frame_buffer,
                        AV_PIX_FMT_RGB0, SWS_BILINEAR, NULL, NULL, NULL);
   }
   if (!sws_scaler_ctx) {
-    printf("Couldn't initialize sw scaler\n");
+    fprintf(stderr, "Couldn't initialize sw scaler\n");
     return false;
   }
 
@@ -193,7 +196,7 @@ bool video_reader_seek_frame(VideoReaderState *state, int64_t ts) {
 
     response = avcodec_send_packet(av_codec_ctx, av_packet);
     if (response < 0) {
-      printf("Failed to decode packet: %s\n", av_make_error(response));
+      fprintf(stderr, "Failed to decode packet: %s\n", av_make_error(response));
       return false;
     }
 
@@ -202,7 +205,7 @@ bool video_reader_seek_frame(VideoReaderState *state, int64_t ts) {
       av_packet_unref(av_packet);
       continue;
     } else if (response < 0) {
-      printf("Failed to decode packet: %s\n", av_make_error(response));
+      fprintf(stderr, "Failed to decode packet: %s\n", av_make_error(response));
       return false;
     }
 
@@ -221,3 +224,56 @@ void video_reader_close(VideoReaderState *state) {
   av_packet_free(&state->av_packet);
   avcodec_free_context(&state->av_codec_ctx);
 }
+
+bool video_reader_probe_stream(const char *filename, VideoStreamInfo *info) {
+  AVFormatContext *av_format_ctx = NULL;
+  if (avformat_open_input(&av_format_ctx, filename, NULL, NULL) != 0) {
+    fprintf(stderr, "Couldn't open video file\n");
+    return false;
+  }
+  avformat_find_stream_info(av_format_ctx, NULL);
+
+  int index = av_find_best_stream(av_format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+  if (index < 0) {
+    fprintf(stderr, "Couldn't find valid video stream inside file\n");
+    avformat_close_input(&av_format_ctx);
+    return false;
+  }
+  AVStream *stream = av_format_ctx->streams[index];
+  AVCodecParameters *params = stream->codecpar;
+
+  info->is_h264_yuv420p = params->codec_id == AV_CODEC_ID_H264 &&
+                          (params->format == AV_PIX_FMT_YUV420P ||
+                           params->format == AV_PIX_FMT_YUVJ420P);
+  info->width = params->width;
+  info->height = params->height;
+  info->frame_rate = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate
+                                                    : stream->r_frame_rate;
+  info->frame_count = 0;
+  info->keyframes.clear();
+  if (info->frame_rate.num <= 0 || info->frame_rate.den <= 0) {
+    avformat_close_input(&av_format_ctx);
+    return false;
+  }
+
+  // Frame n starts at start + n frame durations
+  int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+  AVRational frame_base = av_inv_q(info->frame_rate);
+  AVPacket *av_packet = av_packet_alloc();
+  while (av_packet && av_read_frame(av_format_ctx, av_packet) >= 0) {
+    if (av_packet->stream_index == index) {
+      info->frame_count++;
+      if ((av_packet->flags & AV_PKT_FLAG_KEY) && av_packet->pts != AV_NOPTS_VALUE) {
+        info->keyframes.push_back(av_rescale_q_rnd(
+            av_packet->pts - start, stream->time_base, frame_base,
+            static_cast<AVRounding>(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX)));
+      }
+    }
+    av_packet_unref(av_packet);
+  }
+  av_packet_free(&av_packet);
+  avformat_close_input(&av_format_ctx);
+
+  std::sort(info->keyframes.begin(), info->keyframes.end());
+  return true;
+}
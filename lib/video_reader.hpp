@@ -7,11 +7,13 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libswscale/swscale.h>
 }
+#include <vector>
 
 struct VideoReaderState {
   // Public things for other parts of the program to read from
   int width, height;
   AVRational time_base;
+  AVRational frame_rate;
   double duration;
 
   // Private internal state
@@ -23,10 +25,31 @@ struct VideoReaderState {
   SwsContext *sws_scaler_ctx;
 };
 
+// A video stream as stored, read without decoding it
+struct VideoStreamInfo {
+  bool is_h264_yuv420p;           // Packets can be copied into video_writer output
+  int width, height;
+  AVRational frame_rate;
+  int64_t frame_count;
+  std::vector<int64_t> keyframes; // Frame numbers of keyframes, ascending
+};
+
 bool video_reader_open(VideoReaderState *state, const char *filename);
 bool video_reader_read_frame(VideoReaderState *state, uint8_t *frame_buffer,
                              int64_t *pts);
 bool video_reader_seek_frame(VideoReaderState *state, int64_t ts);
 void video_reader_close(VideoReaderState *state);
 
+/**
+ * @brief Describe a file's video stream by reading its packets
+ *
+ * Nothing is decoded: frame numbers come from packet timestamps at the
+ * stream's frame rate, so this is quick even for long files.
+ *
+ * @param filename The video file
+ * @param info Receives the description
+ * @return true if the file has a video stream
+ */
+bool video_reader_probe_stream(const char *filename, VideoStreamInfo *info);
+
 #endif
@@ -1,19 +1,238 @@
 #include "video_writer.hpp"
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
 #include <iostream>
 
-// Helper function for error messages
-static const char *av_make_error(int errnum) {
-  static char str[AV_ERROR_MAX_STRING_SIZE];
-  memset(str, 0, sizeof(str));
+// Helper function for error messages (a copy, as writers on several
+// threads may fail at once)
+static std::string av_make_error(int errnum) {
+  char str[AV_ERROR_MAX_STRING_SIZE] = {0};
   return av_make_error_string(str, AV_ERROR_MAX_STRING_SIZE, errnum);
 }
 
+// An option of the encoder's own (like "preset" or "crf"), or NULL
+static const AVOption *find_encoder_option(const AVCodec *codec, const char *name) {
+  if (!codec->priv_class) {
+    return NULL;
+  }
+  return av_opt_find(const_cast<const AVClass **>(&codec->priv_class), name, NULL, 0,
+                     AV_OPT_SEARCH_FAKE_OBJ);
+}
+
+static bool takes_yuv420p(const AVCodec *codec) {
+  if (!codec->pix_fmts) {
+    return false;
+  }
+  for (const enum AVPixelFormat *format = codec->pix_fmts; *format != AV_PIX_FMT_NONE;
+       format++) {
+    if (*format == AV_PIX_FMT_YUV420P) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void video_writer_default_config(VideoWriterConfig *config, int fps) {
+  config->encoder = "libx264";
+  config->fps_num = fps;
+  config->fps_den = 1;
+  config->preset = "medium";
+  config->tune = NULL;
+  config->threads = 0;
+  config->gop_size = VIDEO_WRITER_GOP_SIZE;
+  config->max_b_frames = 2;
+  config->rate_control = VIDEO_WRITER_CRF;
+  config->crf = 23;
+  config->bit_rate = 2000000; // 2 Mbps
+  config->max_bit_rate = 0;
+  config->pass = 0;
+  config->pass_log = NULL;
+  config->bt709 = false;
+  config->full_range = false;
+}
+
+// What the encoder can't do of a configuration, or empty if it can do all of it
+static std::string config_problem(const VideoWriterConfig *config, int width, int height) {
+  if (width <= 0 || height <= 0) {
+    return "frame size must be positive";
+  }
+  if (config->fps_num <= 0 || config->fps_den <= 0) {
+    return "frame rate must be positive";
+  }
+  if (config->gop_size < 1) {
+    return "keyframe interval must be at least 1 frame";
+  }
+  if (config->threads < 0 || config->max_b_frames < 0) {
+    return "thread and B-frame counts can't be negative";
+  }
+
+  const AVCodec *codec = config->encoder ? avcodec_find_encoder_by_name(config->encoder) : NULL;
+  if (!codec || codec->type != AVMEDIA_TYPE_VIDEO) {
+    return std::string("no video encoder named '") + (config->encoder ? config->encoder : "") +
+           "' in this FFmpeg";
+  }
+  const std::string name = codec->name;
+  if (!takes_yuv420p(codec)) {
+    return name + " does not take YUV 4:2:0 frames";
+  }
+  if (codec->supported_framerates) {
+    AVRational rate = AVRational{config->fps_num, config->fps_den};
+    const AVRational *supported = codec->supported_framerates;
+    while (supported->num != 0 && av_cmp_q(*supported, rate) != 0) {
+      supported++;
+    }
+    if (supported->num == 0) {
+      return name + " does not support " + std::to_string(config->fps_num) + "/" +
+             std::to_string(config->fps_den) + " fps";
+    }
+  }
+
+#ifdef AV_CODEC_CAP_OTHER_THREADS
+  const int thread_caps =
+      AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_OTHER_THREADS;
+#else
+  const int thread_caps =
+      AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_AUTO_THREADS;
+#endif
+  if (config->threads > 1 && !(codec->capabilities & thread_caps)) {
+    return name + " can only use one thread";
+  }
+  if (config->preset && !find_encoder_option(codec, "preset")) {
+    return name + " has no presets";
+  }
+  if (config->tune && !find_encoder_option(codec, "tune")) {
+    return name + " has no tunings";
+  }
+
+  if (config->rate_control == VIDEO_WRITER_CRF) {
+    const AVOption *crf = find_encoder_option(codec, "crf");
+    if (!crf) {
+      return name + " has no constant quality (CRF) mode";
+    }
+    if (config->crf < 0 || config->crf < crf->min || config->crf > crf->max) {
+      return "CRF " + std::to_string(config->crf) + " is out of range for " + name;
+    }
+  } else if (config->bit_rate <= 0 ||
+             (config->max_bit_rate > 0 && config->max_bit_rate < config->bit_rate)) {
+    return "bit rate must be positive and no more than the peak bit rate";
+  }
+
+  if (config->pass < 0 || config->pass > 2) {
+    return "pass must be 0, 1 or 2";
+  }
+  if (config->pass > 0 && (config->rate_control == VIDEO_WRITER_CRF || !config->pass_log)) {
+    return "two-pass encoding needs a bit rate and a statistics file";
+  }
+
+  // The encoder parses its own option values
+  AVCodecContext *ctx = avcodec_alloc_context3(codec);
+  if (!ctx) {
+    return "could not allocate codec context";
+  }
+  std::string problem;
+  if (config->preset && av_opt_set(ctx->priv_data, "preset", config->preset, 0) < 0) {
+    problem = name + " has no preset '" + config->preset + "'";
+  } else if (config->tune && av_opt_set(ctx->priv_data, "tune", config->tune, 0) < 0) {
+    problem = name + " has no tuning '" + config->tune + "'";
+  }
+  avcodec_free_context(&ctx);
+  return problem;
+}
+
+bool video_writer_check_config(const VideoWriterConfig *config, int width, int height,
+                               std::string *error) {
+  std::string problem = config_problem(config, width, height);
+  if (error) {
+    *error = problem;
+  }
+  return problem.empty();
+}
+
+const char *video_writer_encoder_format(const char *encoder) {
+  const AVCodec *codec = avcodec_find_encoder_by_name(encoder);
+  return codec ? avcodec_get_name(codec->id) : NULL;
+}
+
+std::vector<std::string> video_writer_list_encoders() {
+  std::vector<std::string> names;
+  void *iterator = NULL;
+  const AVCodec *codec;
+  while ((codec = av_codec_iterate(&iterator))) {
+    if (av_codec_is_encoder(codec) && codec->type == AVMEDIA_TYPE_VIDEO &&
+        takes_yuv420p(codec)) {
+      names.push_back(codec->name);
+    }
+  }
+  return names;
+}
+
+// Set up pass 1 or 2 of a two-pass encode before the encoder is opened
+static bool set_up_pass(VideoWriterState *state, const AVCodec *codec,
+                        const VideoWriterConfig *config) {
+  AVCodecContext *ctx = state->av_codec_ctx;
+  ctx->flags |= config->pass == 1 ? AV_CODEC_FLAG_PASS1 : AV_CODEC_FLAG_PASS2;
+
+  // Encoders with a statistics file option (libx264) read and write it themselves
+  if (find_encoder_option(codec, "stats")) {
+    av_opt_set(ctx->priv_data, "stats", config->pass_log, 0);
+    return true;
+  }
+
+  // Others hand out their statistics in stats_out, and take them back in stats_in
+  if (config->pass == 1) {
+    state->pass_log = fopen(config->pass_log, "w");
+    if (!state->pass_log) {
+      std::cerr << "Could not create pass log: " << config->pass_log << std::endl;
+      return false;
+    }
+    return true;
+  }
+  FILE *log = fopen(config->pass_log, "rb");
+  if (!log) {
+    std::cerr << "Could not read pass log: " << config->pass_log << std::endl;
+    return false;
+  }
+  std::string stats;
+  char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), log)) > 0) {
+    stats.append(buffer, read);
+  }
+  fclose(log);
+  ctx->stats_in = av_strdup(stats.c_str());
+  return ctx->stats_in != NULL;
+}
+
+// Append the encoder's statistics so far to the pass 1 log
+static void write_pass_stats(VideoWriterState *state) {
+  if (state->pass_log && state->av_codec_ctx->stats_out) {
+    fputs(state->av_codec_ctx->stats_out, state->pass_log);
+  }
+}
+
 bool video_writer_open(VideoWriterState *state, const char *filename,
                        int width, int height, int fps) {
+  VideoWriterConfig config;
+  video_writer_default_config(&config, fps);
+  return video_writer_open_config(state, filename, width, height, &config);
+}
+
+bool video_writer_open_config(VideoWriterState *state, const char *filename,
+                              int width, int height, const VideoWriterConfig *config) {
   state->width = width;
   state->height = height;
-  state->fps = fps;
+  state->fps_num = config->fps_num;
+  state->fps_den = config->fps_den;
   state->frame_count = 0;
+  state->pass_log = NULL;
+
+  std::string problem;
+  if (!video_writer_check_config(config, width, height, &problem)) {
+    std::cerr << "Unsupported encoder settings: " << problem << std::endl;
+    return false;
+  }
 
   // Allocate output format context
   avformat_alloc_output_context2(&state->av_format_ctx, NULL, NULL, filename);
@@ -22,10 +241,10 @@ bool video_writer_open(VideoWriterState *state, const char *filename,
     return false;
   }
 
-  // Find H.264 encoder
-  const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+  // Find the encoder
+  const AVCodec *codec = avcodec_find_encoder_by_name(config->encoder);
   if (!codec) {
-    std::cerr << "H.264 codec not found" << std::endl;
+    std::cerr << config->encoder << " encoder not found" << std::endl;
     return false;
   }
 
@@ -43,30 +262,69 @@ bool video_writer_open(VideoWriterState *state, const char *filename,
     return false;
   }
 
-  // Set codec parameters
+  // Set codec parameters. One tick per frame, so 29.97 fps is 1001/30000.
   state->av_codec_ctx->width = width;
   state->av_codec_ctx->height = height;
-  state->av_codec_ctx->time_base = AVRational{1, fps};
-  state->av_codec_ctx->framerate = AVRational{fps, 1};
+  state->av_codec_ctx->time_base = AVRational{config->fps_den, config->fps_num};
+  state->av_codec_ctx->framerate = AVRational{config->fps_num, config->fps_den};
   state->av_codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
-  state->av_codec_ctx->bit_rate = 2000000; // 2 Mbps
-
-  // Set GOP size (keyframe interval)
-  state->av_codec_ctx->gop_size = 12;
-  state->av_codec_ctx->max_b_frames = 2;
+  state->av_codec_ctx->colorspace = config->bt709 ? AVCOL_SPC_BT709 : AVCOL_SPC_SMPTE170M;
+  state->av_codec_ctx->color_primaries = config->bt709 ? AVCOL_PRI_BT709 : AVCOL_PRI_SMPTE170M;
+  state->av_codec_ctx->color_trc = config->bt709 ? AVCOL_TRC_BT709 : AVCOL_TRC_SMPTE170M;
+  state->av_codec_ctx->color_range = config->full_range ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+  state->av_codec_ctx->thread_count = config->threads;
+
+  // Set GOP size (keyframe interval). Closed GOPs never reference frames
+  // before their keyframe, so files can be cut and joined on GOP boundaries.
+  const AVCodecDescriptor *descriptor = avcodec_descriptor_get(codec->id);
+  state->av_codec_ctx->gop_size = config->gop_size;
+  state->av_codec_ctx->max_b_frames =
+      descriptor && (descriptor->props & AV_CODEC_PROP_REORDER) ? config->max_b_frames : 0;
+  state->av_codec_ctx->flags |= AV_CODEC_FLAG_CLOSED_GOP;
 
   // Some formats require global headers
   if (state->av_format_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
     state->av_codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
   }
 
-  // Set H.264 specific options for better compression
-  av_opt_set(state->av_codec_ctx->priv_data, "preset", "medium", 0);
-  av_opt_set(state->av_codec_ctx->priv_data, "crf", "23", 0);
+  // Speed/size trade-off and rate control
+  void *options = state->av_codec_ctx->priv_data;
+  if (config->preset) {
+    av_opt_set(options, "preset", config->preset, 0);
+  }
+  if (config->tune) {
+    av_opt_set(options, "tune", config->tune, 0);
+  }
+  switch (config->rate_control) {
+    case VIDEO_WRITER_CRF:
+      av_opt_set_int(options, "crf", config->crf, 0);
+      break;
+    case VIDEO_WRITER_VBR:
+      state->av_codec_ctx->bit_rate = config->bit_rate;
+      if (config->max_bit_rate > 0) {
+        state->av_codec_ctx->rc_max_rate = config->max_bit_rate;
+        state->av_codec_ctx->rc_buffer_size = static_cast<int>(config->max_bit_rate);
+      }
+      break;
+    case VIDEO_WRITER_CBR:
+      // A one second buffer that never over- or underflows
+      state->av_codec_ctx->bit_rate = config->bit_rate;
+      state->av_codec_ctx->rc_min_rate = config->bit_rate;
+      state->av_codec_ctx->rc_max_rate = config->bit_rate;
+      state->av_codec_ctx->rc_buffer_size = static_cast<int>(config->bit_rate);
+      if (find_encoder_option(codec, "nal-hrd")) {
+        av_opt_set(options, "nal-hrd", "cbr", 0);
+      }
+      break;
+  }
+  if (config->pass > 0 && !set_up_pass(state, codec, config)) {
+    return false;
+  }
 
   // Open codec
-  if (avcodec_open2(state->av_codec_ctx, codec, NULL) < 0) {
-    std::cerr << "Could not open codec" << std::endl;
+  int ret = avcodec_open2(state->av_codec_ctx, codec, NULL);
+  if (ret < 0) {
+    std::cerr << "Could not open codec: " << av_make_error(ret) << std::endl;
     return false;
   }
 
@@ -102,17 +360,6 @@ bool video_writer_open(VideoWriterState *state, const char *filename,
     return false;
   }
 
-  // Create scaler context to convert RGBA to YUV420P
-  state->sws_scaler_ctx = sws_getContext(
-      width, height, AV_PIX_FMT_RGBA,
-      width, height, AV_PIX_FMT_YUV420P,
-      SWS_BILINEAR, NULL, NULL, NULL);
-
-  if (!state->sws_scaler_ctx) {
-    std::cerr << "Could not create scaler context" << std::endl;
-    return false;
-  }
-
   // Open output file
   if (!(state->av_format_ctx->oformat->flags & AVFMT_NOFILE)) {
     if (avio_open(&state->av_format_ctx->pb, filename, AVIO_FLAG_WRITE) < 0) {
@@ -127,26 +374,22 @@ bool video_writer_open(VideoWriterState *state, const char *filename,
     return false;
   }
 
-  std::cout << "Video writer opened: " << filename << " (" << width << "x" << height
-            << " @ " << fps << " fps)" << std::endl;
+  std::cerr << "Video writer opened: " << filename << " (" << width << "x" << height
+            << " @ " << config->fps_num;
+  if (config->fps_den != 1) {
+    std::cerr << "/" << config->fps_den;
+  }
+  std::cerr << " fps, " << config->encoder;
+  if (config->preset) {
+    std::cerr << " " << config->preset;
+  }
+  std::cerr << ")" << std::endl;
 
   return true;
 }
 
-bool video_writer_write_frame(VideoWriterState *state, const uint8_t *frame_buffer) {
-  // Make frame writable
-  if (av_frame_make_writable(state->av_frame) < 0) {
-    std::cerr << "Could not make frame writable" << std::endl;
-    return false;
-  }
-
-  // Convert RGBA to YUV420P
-  const uint8_t *src_data[1] = {frame_buffer};
-  int src_linesize[1] = {state->width * 4}; // RGBA has 4 bytes per pixel
-
-  sws_scale(state->sws_scaler_ctx, src_data, src_linesize, 0, state->height,
-            state->av_frame->data, state->av_frame->linesize);
-
+// Send state->av_frame to the encoder and write out any packets it returns
+static bool encode_frame(VideoWriterState *state) {
   // Set frame PTS (presentation timestamp)
   state->av_frame->pts = state->frame_count;
   state->frame_count++;
@@ -169,6 +412,8 @@ bool video_writer_write_frame(VideoWriterState *state, const uint8_t *frame_buff
       return false;
     }
 
+    write_pass_stats(state);
+
     // Rescale packet timestamps
     av_packet_rescale_ts(state->av_packet, state->av_codec_ctx->time_base,
                          state->video_stream->time_base);
@@ -188,11 +433,256 @@ bool video_writer_write_frame(VideoWriterState *state, const uint8_t *frame_buff
   return true;
 }
 
+bool video_writer_write_yuv_frame(VideoWriterState *state, const uint8_t *const planes[3],
+                                  const int linesizes[3]) {
+  // The encoder may still hold the previous frame's buffer
+  if (av_frame_make_writable(state->av_frame) < 0) {
+    std::cerr << "Could not make frame writable" << std::endl;
+    return false;
+  }
+
+  const uint8_t *src_data[4] = {planes[0], planes[1], planes[2], NULL};
+  int src_linesize[4] = {linesizes[0], linesizes[1], linesizes[2], 0};
+  av_image_copy(state->av_frame->data, state->av_frame->linesize, src_data,
+                src_linesize, AV_PIX_FMT_YUV420P, state->width, state->height);
+
+  return encode_frame(state);
+}
+
+// Append the SPS and PPS of an avcC record to out as length-prefixed NAL
+// units, the way they appear inside MP4 samples
+static bool avcc_parameter_sets(const uint8_t *avcc, int size, std::vector<uint8_t> &out) {
+  if (size < 7 || avcc[0] != 1) {
+    return false;
+  }
+  int length_size = (avcc[4] & 3) + 1;
+  int pos = 5;
+  for (int set = 0; set < 2; set++) {
+    if (pos >= size) {
+      return false;
+    }
+    int count = set == 0 ? (avcc[pos] & 0x1f) : avcc[pos];
+    pos++;
+    for (int i = 0; i < count; i++) {
+      if (pos + 2 > size) {
+        return false;
+      }
+      int length = (avcc[pos] << 8) | avcc[pos + 1];
+      pos += 2;
+      if (pos + length > size) {
+        return false;
+      }
+      for (int byte = length_size - 1; byte >= 0; byte--) {
+        out.push_back(static_cast<uint8_t>(length >> (8 * byte)));
+      }
+      out.insert(out.end(), avcc + pos, avcc + pos + length);
+      pos += length;
+    }
+  }
+  return true;
+}
+
+// Bytes in the NAL length prefixes of an avcC record, or -1 if it isn't one
+static int avcc_length_size(const AVCodecParameters *par) {
+  if (par->codec_id != AV_CODEC_ID_H264 || par->extradata_size < 7 ||
+      par->extradata[0] != 1) {
+    return -1;
+  }
+  return (par->extradata[4] & 3) + 1;
+}
+
+static bool same_extradata(const AVCodecParameters *a, const AVCodecParameters *b) {
+  return a->extradata_size == b->extradata_size &&
+         (a->extradata_size == 0 ||
+          memcmp(a->extradata, b->extradata, a->extradata_size) == 0);
+}
+
+bool video_writer_concat(const char *filename, const VideoWriterPiece *pieces,
+                         int piece_count, int fps_num, int fps_den) {
+  AVFormatContext *out_ctx = NULL;
+  AVStream *out_stream = NULL;
+  const AVRational out_frame_base = AVRational{fps_den, fps_num};
+  int64_t last_dts = AV_NOPTS_VALUE;
+  bool header_written = false;
+  bool ok = true;
+
+  AVPacket *packet = av_packet_alloc();
+  if (!packet) {
+    std::cerr << "Could not allocate packet" << std::endl;
+    return false;
+  }
+
+  for (int i = 0; ok && i < piece_count; i++) {
+    const VideoWriterPiece &piece = pieces[i];
+    AVFormatContext *in_ctx = NULL;
+    if (avformat_open_input(&in_ctx, piece.filename, NULL, NULL) < 0 ||
+        avformat_find_stream_info(in_ctx, NULL) < 0) {
+      std::cerr << "Could not read: " << piece.filename << std::endl;
+      avformat_close_input(&in_ctx);
+      ok = false;
+      break;
+    }
+
+    int video_index = av_find_best_stream(in_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    if (video_index < 0) {
+      std::cerr << "No video stream in: " << piece.filename << std::endl;
+      avformat_close_input(&in_ctx);
+      ok = false;
+      break;
+    }
+    AVStream *in_stream = in_ctx->streams[video_index];
+    AVRational in_rate = in_stream->avg_frame_rate.num > 0 ? in_stream->avg_frame_rate
+                                                           : in_stream->r_frame_rate;
+    AVRational in_frame_base = av_inv_q(in_rate);
+    int64_t in_start = in_stream->start_time != AV_NOPTS_VALUE ? in_stream->start_time : 0;
+
+    // The first piece's stream parameters (and H.264 headers) describe the output
+    if (!out_ctx) {
+      avformat_alloc_output_context2(&out_ctx, NULL, NULL, filename);
+      if (!out_ctx) {
+        std::cerr << "Could not allocate output format context" << std::endl;
+        avformat_close_input(&in_ctx);
+        ok = false;
+        break;
+      }
+      out_stream = avformat_new_stream(out_ctx, NULL);
+      if (!out_stream ||
+          avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar) < 0) {
+        std::cerr << "Could not create video stream" << std::endl;
+        avformat_close_input(&in_ctx);
+        ok = false;
+        break;
+      }
+      out_stream->codecpar->codec_tag = 0;
+      out_stream->time_base = out_frame_base;
+
+      if (!(out_ctx->oformat->flags & AVFMT_NOFILE) &&
+          avio_open(&out_ctx->pb, filename, AVIO_FLAG_WRITE) < 0) {
+        std::cerr << "Could not open output file: " << filename << std::endl;
+        avformat_close_input(&in_ctx);
+        ok = false;
+        break;
+      }
+      if (avformat_write_header(out_ctx, NULL) < 0) {
+        std::cerr << "Could not write header" << std::endl;
+        avformat_close_input(&in_ctx);
+        ok = false;
+        break;
+      }
+      header_written = true;
+    }
+
+    // A piece with other headers repeats them in its first packet
+    std::vector<uint8_t> headers;
+    if (in_stream->codecpar->codec_id != out_stream->codecpar->codec_id ||
+        (!same_extradata(in_stream->codecpar, out_stream->codecpar) &&
+         (avcc_length_size(in_stream->codecpar) < 0 ||
+          avcc_length_size(in_stream->codecpar) != avcc_length_size(out_stream->codecpar) ||
+          !avcc_parameter_sets(in_stream->codecpar->extradata,
+                               in_stream->codecpar->extradata_size, headers)))) {
+      std::cerr << "Can't join " << piece.filename << ": incompatible codec headers"
+                << std::endl;
+      avformat_close_input(&in_ctx);
+      ok = false;
+      break;
+    }
+
+    if (piece.first_frame > 0) {
+      av_seek_frame(in_ctx, video_index,
+                    in_start + av_rescale_q(piece.first_frame, in_frame_base,
+                                            in_stream->time_base),
+                    AVSEEK_FLAG_BACKWARD);
+    }
+
+    // Copy the packets of the piece's frames, which are consecutive in
+    // decode order because its GOPs are closed
+    int64_t copied = 0;
+    while (ok && copied < piece.frame_count && av_read_frame(in_ctx, packet) >= 0) {
+      if (packet->stream_index != video_index || packet->pts == AV_NOPTS_VALUE) {
+        av_packet_unref(packet);
+        continue;
+      }
+      const AVRounding rounding =
+          static_cast<AVRounding>(AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+      int64_t frame = av_rescale_q_rnd(packet->pts - in_start, in_stream->time_base,
+                                       in_frame_base, rounding);
+      if (frame < piece.first_frame || frame >= piece.first_frame + piece.frame_count) {
+        av_packet_unref(packet);
+        continue;
+      }
+      int64_t dts_frame = packet->dts == AV_NOPTS_VALUE
+                              ? frame
+                              : av_rescale_q_rnd(packet->dts - in_start, in_stream->time_base,
+                                                 in_frame_base, rounding);
+      int64_t shift = piece.output_frame - piece.first_frame;
+      packet->pts = av_rescale_q(frame + shift, out_frame_base, out_stream->time_base);
+      packet->dts = av_rescale_q(dts_frame + shift, out_frame_base, out_stream->time_base);
+      packet->duration = av_rescale_q(1, out_frame_base, out_stream->time_base);
+      // Files with more reordering delay start further back; keep dts increasing
+      if (last_dts != AV_NOPTS_VALUE && packet->dts <= last_dts) {
+        packet->dts = last_dts + 1;
+      }
+      last_dts = packet->dts;
+      packet->pos = -1;
+      packet->stream_index = out_stream->index;
+
+      if (copied == 0 && !headers.empty()) {
+        AVPacket *with_headers = av_packet_alloc();
+        if (!with_headers ||
+            av_new_packet(with_headers, static_cast<int>(headers.size()) + packet->size) < 0) {
+          std::cerr << "Could not allocate packet" << std::endl;
+          av_packet_free(&with_headers);
+          av_packet_unref(packet);
+          ok = false;
+          break;
+        }
+        av_packet_copy_props(with_headers, packet);
+        memcpy(with_headers->data, headers.data(), headers.size());
+        memcpy(with_headers->data + headers.size(), packet->data, packet->size);
+        av_packet_unref(packet);
+        av_packet_move_ref(packet, with_headers);
+        av_packet_free(&with_headers);
+      }
+
+      int ret = av_interleaved_write_frame(out_ctx, packet);
+      if (ret < 0) {
+        std::cerr << "Error writing packet: " << av_make_error(ret) << std::endl;
+        ok = false;
+      }
+      av_packet_unref(packet);
+      copied++;
+    }
+    if (ok && copied != piece.frame_count) {
+      std::cerr << "Only found " << copied << " of " << piece.frame_count << " frames in "
+                << piece.filename << std::endl;
+      ok = false;
+    }
+    avformat_close_input(&in_ctx);
+  }
+
+  if (header_written && av_write_trailer(out_ctx) < 0) {
+    std::cerr << "Could not write trailer" << std::endl;
+    ok = false;
+  }
+  if (out_ctx) {
+    if (!(out_ctx->oformat->flags & AVFMT_NOFILE)) {
+      avio_closep(&out_ctx->pb);
+    }
+    avformat_free_context(out_ctx);
+  }
+  av_packet_free(&packet);
+
+  if (ok) {
+    std::cerr << "Joined " << piece_count << " pieces into " << filename << std::endl;
+  }
+  return ok;
+}
+
 void video_writer_close(VideoWriterState *state) {
   // Flush encoder
   avcodec_send_frame(state->av_codec_ctx, NULL);
 
-  int ret;
+  int ret = 0;
   while (ret >= 0) {
     ret = avcodec_receive_packet(state->av_codec_ctx, state->av_packet);
     if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
@@ -200,6 +690,7 @@ void video_writer_close(VideoWriterState *state) {
     } else if (ret < 0) {
       break;
     }
+    write_pass_stats(state);
 
     av_packet_rescale_ts(state->av_packet, state->av_codec_ctx->time_base,
                          state->video_stream->time_base);
@@ -208,14 +699,17 @@ void video_writer_close(VideoWriterState *state) {
     av_packet_unref(state->av_packet);
   }
 
+  // Some encoders only give their statistics at the end of the stream
+  write_pass_stats(state);
+  if (state->pass_log) {
+    fclose(state->pass_log);
+    state->pass_log = NULL;
+  }
+
   // Write file trailer
   av_write_trailer(state->av_format_ctx);
 
   // Clean up
-  if (state->sws_scaler_ctx) {
-    sws_freeContext(state->sws_scaler_ctx);
-  }
-
   if (state->av_frame) {
     av_frame_free(&state->av_frame);
   }
@@ -225,6 +719,7 @@ void video_writer_close(VideoWriterState *state) {
   }
 
   if (state->av_codec_ctx) {
+    av_freep(&state->av_codec_ctx->stats_in);
     avcodec_free_context(&state->av_codec_ctx);
   }
 
@@ -235,5 +730,5 @@ void video_writer_close(VideoWriterState *state) {
     avformat_free_context(state->av_format_ctx);
   }
 
-  std::cout << "Video writer closed (" << state->frame_count << " frames written)" << std::endl;
+  std::cerr << "Video writer closed (" << state->frame_count << " frames written)" << std::endl;
 }
@@ -5,14 +5,46 @@ extern "C" {
 #include <inttypes.h>
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
-#include <libswscale/swscale.h>
 #include <libavutil/opt.h>
 }
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Frames from one keyframe to the next by default. GOPs are closed, so a
+// file can be cut on any multiple of the interval and each piece decoded
+// on its own.
+const int VIDEO_WRITER_GOP_SIZE = 12;
+
+enum VideoWriterRateControl {
+  VIDEO_WRITER_CRF,   // Constant quality: crf, the bit rate follows the content
+  VIDEO_WRITER_VBR,   // Average bit_rate, peaks up to max_bit_rate
+  VIDEO_WRITER_CBR    // Constant bit_rate
+};
+
+// How to encode. Strings are only read by video_writer_open_config.
+struct VideoWriterConfig {
+  const char *encoder;      // FFmpeg encoder name, e.g. "libx264", "libx265", "libvpx-vp9"
+  int fps_num, fps_den;     // Frames per second, e.g. 30000/1001 for 29.97
+  const char *preset;       // Speed preset, e.g. "ultrafast" to "veryslow"; NULL for none
+  const char *tune;         // e.g. "film" or "animation"; NULL for none
+  int threads;              // Encoder threads, 0 to let the encoder choose
+  int gop_size;             // Keyframe interval in frames
+  int max_b_frames;         // Encoders that can't reorder frames use none
+  VideoWriterRateControl rate_control;
+  int crf;                  // VIDEO_WRITER_CRF quality, lower is better
+  int64_t bit_rate;         // VIDEO_WRITER_VBR and VIDEO_WRITER_CBR, bits per second
+  int64_t max_bit_rate;     // VIDEO_WRITER_VBR peak, 0 for no limit
+  int pass;                 // 0 for a single pass, or pass 1 or 2 of a two-pass encode
+  const char *pass_log;     // Where pass 1 leaves its statistics for pass 2
+  bool bt709;               // Frames use the BT.709 matrix rather than BT.601
+  bool full_range;          // Frames use 0-255 rather than 16-235
+};
 
 struct VideoWriterState {
   // Public configuration
   int width, height;
-  int fps;
+  int fps_num, fps_den;
 
   // Private internal state
   AVFormatContext *av_format_ctx;
@@ -20,10 +52,50 @@ struct VideoWriterState {
   AVStream *video_stream;
   AVFrame *av_frame;
   AVPacket *av_packet;
-  SwsContext *sws_scaler_ctx;
   int frame_count;
+  FILE *pass_log;   // Pass 1 statistics of encoders that don't write their own
 };
 
+/**
+ * @brief Get the configuration video_writer_open uses
+ *
+ * H.264 (libx264) with preset "medium" at CRF 23, a keyframe every
+ * VIDEO_WRITER_GOP_SIZE frames and up to 2 B-frames, in one pass.
+ *
+ * @param config Receives the configuration
+ * @param fps Frames per second (e.g., 30)
+ */
+void video_writer_default_config(VideoWriterConfig *config, int fps);
+
+/**
+ * @brief Check that an encoder is available and can use a configuration
+ *
+ * Looks up the encoder in the local FFmpeg and checks it takes YUV 4:2:0
+ * at the frame rate, has the preset, tune and CRF options asked for (with
+ * values it accepts), and can use more than one thread if asked to.
+ *
+ * @param config The configuration
+ * @param width Video width in pixels
+ * @param height Video height in pixels
+ * @param error Receives what is unsupported (may be NULL)
+ * @return true if video_writer_open_config can use it
+ */
+bool video_writer_check_config(const VideoWriterConfig *config, int width, int height,
+                               std::string *error);
+
+/**
+ * @brief Get the format an encoder writes
+ * @param encoder FFmpeg encoder name (e.g. "libx264")
+ * @return Codec name (e.g. "h264"), or NULL if there is no such encoder
+ */
+const char *video_writer_encoder_format(const char *encoder);
+
+/**
+ * @brief List the video encoders of the local FFmpeg that take YUV 4:2:0
+ * @return Encoder names, e.g. "libx264"
+ */
+std::vector<std::string> video_writer_list_encoders();
+
 /**
  * @brief Open a video file for writing
  * @param state Video writer state structure
@@ -37,12 +109,57 @@ bool video_writer_open(VideoWriterState *state, const char *filename,
                        int width, int height, int fps);
 
 /**
- * @brief Write a single frame to the video
+ * @brief Open a video file for writing with a given encoder configuration
+ * @param state Video writer state structure
+ * @param filename Output filename (should end in .mp4)
+ * @param width Video width in pixels
+ * @param height Video height in pixels
+ * @param config How to encode (see video_writer_check_config)
+ * @return true if successful, false otherwise
+ */
+bool video_writer_open_config(VideoWriterState *state, const char *filename,
+                              int width, int height, const VideoWriterConfig *config);
+
+/**
+ * @brief Write a YUV 4:2:0 frame
+ *
+ * The samples are in the matrix and range of the configuration; the
+ * stream is tagged with them so players convert back the same way.
+ *
  * @param state Video writer state
- * @param frame_buffer RGBA pixel data (width * height * 4 bytes)
+ * @param planes Y, U and V planes (chroma planes are half size, rounded up)
+ * @param linesizes Bytes per row of each plane
+ * @return true if successful, false otherwise
+ */
+bool video_writer_write_yuv_frame(VideoWriterState *state, const uint8_t *const planes[3],
+                                  const int linesizes[3]);
+
+// A run of frames of an encoded file to copy into a joined file
+struct VideoWriterPiece {
+  const char *filename;
+  int64_t first_frame;    // First frame of the file to copy (a keyframe)
+  int64_t frame_count;    // Frames to copy
+  int64_t output_frame;   // Frame of the joined file the first one becomes
+};
+
+/**
+ * @brief Join runs of frames of H.264 files into one file without re-encoding
+ *
+ * Each piece must start on a keyframe and end at the end of a closed GOP.
+ * Packets are copied as they are and retimed to their output frame.
+ * Pieces from files whose H.264 headers differ from the first piece's
+ * (another encoder, or other settings) carry their own headers in band;
+ * other formats must all have the same headers.
+ *
+ * @param filename Output filename (should end in .mp4)
+ * @param pieces Runs of frames to join, in output order
+ * @param piece_count Number of pieces
+ * @param fps_num Output frames per second, numerator
+ * @param fps_den Output frames per second, denominator
  * @return true if successful, false otherwise
  */
-bool video_writer_write_frame(VideoWriterState *state, const uint8_t *frame_buffer);
+bool video_writer_concat(const char *filename, const VideoWriterPiece *pieces,
+                         int piece_count, int fps_num, int fps_den);
 
 /**
  * @brief Close the video file and finalize encoding
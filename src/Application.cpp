@@ -6,12 +6,15 @@
 #include "assets/ImageAssetFactory.h"
 #include "assets/TextAssetFactory.h"
 #include "assets/VideoAssetFactory.h"
+#include "commands/EditCommands.h"
+#include "project/ProjectFile.h"
 #include "graphics/Glyph.h"
 #include "graphics/ShaderProgram.h"
 #include "graphics/Text.h"
 #include "ui/Button.h"
 #include "ui/IconButton.h"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iostream>
@@ -24,10 +27,20 @@ static csci3081::Application *g_app = nullptr;
 
 namespace csci3081 {
 
+namespace {
+
+bool hasExtension(const std::string &path, const std::string &extension) {
+  return path.size() >= extension.size() &&
+         path.compare(path.size() - extension.size(), extension.size(),
+                      extension) == 0;
+}
+
+} // namespace
+
 const double FrameRate = 30.0;
 const double FRAME_DURATION = 1.0 / FrameRate;
 
-Application::Application() : blank(10, 10) {
+Application::Application() {
 
   glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -58,16 +71,13 @@ Application::Application() : blank(10, 10) {
   exportMenuModel = nullptr;
   exportMenuView = nullptr;
   exportMenuController = nullptr;
-
-  for (int y = 0; y < blank.getHeight(); y++) {
-    for (int x = 0; x < blank.getWidth(); x++) {
-      // blank.setPixel(x, y, Color(32, 32, 32, 255));
-      blank.setPixel(x, y, Color(255, 255, 255, 0));
-    }
-  }
+  exportJobs = nullptr;
 }
 
 Application::~Application() {
+  // Stop background exports before deleting what they read
+  delete exportJobs;
+
   // Delete assets
   for (IAsset *asset : assets) {
     delete asset;
@@ -104,7 +114,7 @@ void Application::addFilters() {
     // Reset the filter
     std::string code = "";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("Bright (1)", [this]() {
@@ -112,14 +122,14 @@ void Application::addFilters() {
     std::string code = "aggregateColor *= vec4(2.0, 2.0, 2.0, 1);\n"
                        "trackColor *= vec4(2.0, 2.0, 2.0, 1);\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("Gradient (2)", [this]() {
     // Draw a color gradient
     std::string code = "trackColor *= vec4(pos.x , pos.y, time, 1.0);\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("Low (3)", [this]() {
@@ -128,7 +138,7 @@ void Application::addFilters() {
                        "   trackColor = vec4(0, 0, 0, 0);\n"
                        "}\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("High (4)", [this]() {
@@ -137,7 +147,7 @@ void Application::addFilters() {
                        "   trackColor = vec4(0, 0, 0, 0);\n"
                        "}\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("Greyscale (5)", [this]() {
@@ -146,7 +156,7 @@ void Application::addFilters() {
         "float L = (trackColor.r + trackColor.g + trackColor.b) / 3.0;\n"
         "trackColor = vec4(L, L, L, trackColor.a);\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("Red (6)", [this]() {
@@ -154,7 +164,7 @@ void Application::addFilters() {
     std::string code =
         "trackColor = vec4(trackColor.r, 0.0, 0.0, trackColor.a);\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("Chroma (7)", [this]() {
@@ -170,7 +180,7 @@ void Application::addFilters() {
         "  trackColor.a -= greenStrength * supressionCoefficient;"
         "}";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("Circle (8)", [this]() {
@@ -183,14 +193,11 @@ void Application::addFilters() {
                        "  trackColor = vec4(0.0, 0.0, 0.0, 0.0);"
                        "}\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   filterPanel->addTextButton("Disolve (9)", [this]() {
-    // Set the transparency of the trackColor to disolve over time
-    std::string code = "trackColor.a *= (1.0 - time);\n";
-    this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->dissolveSelectedTrack();
   });
 
   filterPanel->addTextButton("Special (S)", [this]() {
@@ -202,28 +209,185 @@ void Application::addFilters() {
                        "trackColor.b *= 0.90;\n";
 
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
+  });
+
+  filterPanel->addTextButton("Blend Mode (B)", [this]() {
+    this->cycleSelectedBlendMode();
+  });
+
+  filterPanel->addTextButton("Linear Light (L)", [this]() {
+    this->toggleLinearLight();
   });
 }
 
+void Application::updateTrackShader() {
+  std::vector<BlendMode> blendModes;
+  for (size_t i = 0; i < trackFilters.size(); i++) {
+    const Track *track = timeline->getTrack(i);
+    blendModes.push_back(track ? track->getBlendMode() : BlendMode::NORMAL);
+  }
+  trackShader->update(trackFilters, blendModes);
+}
+
+void Application::cycleSelectedBlendMode() {
+  Track *track = timeline->getTrack(trackSelected);
+  if (!track) {
+    return;
+  }
+
+  int next = (static_cast<int>(track->getBlendMode()) + 1) % BLEND_MODE_COUNT;
+  track->setBlendMode(static_cast<BlendMode>(next));
+  std::cout << "Track " << trackSelected << " blend mode: "
+            << blendModeName(track->getBlendMode()) << std::endl;
+  updateTrackShader();
+}
+
+void Application::toggleLinearLight() {
+  bool linear = timeline->getCompositingMode() == CompositingMode::LINEAR_16BIT;
+  timeline->setCompositingMode(linear ? CompositingMode::GAMMA_8BIT
+                                      : CompositingMode::LINEAR_16BIT);
+  std::cout << "Linear light compositing " << (linear ? "off" : "on") << std::endl;
+}
+
+void Application::cycleSelectedTransition() {
+  Track *track = timeline->getTrack(trackSelected);
+  if (!track || entrySelected < 0 ||
+      entrySelected + 1 >= (int)track->getEntryCount()) {
+    std::cerr << "Select an entry that is followed by another entry"
+              << std::endl;
+    return;
+  }
+
+  // None -> Crossfade -> Wipe -> Dip to Color -> None
+  const TimelineEntry &from = track->getEntry(entrySelected);
+  int next = 0;
+  if (from.hasOutTransition()) {
+    next = static_cast<int>(from.getOutTransition().type) + 1;
+  }
+  if (next >= TRANSITION_TYPE_COUNT) {
+    history.perform(
+        new SetTransitionCommand(timeline, trackSelected, entrySelected));
+    std::cout << "Removed transition" << std::endl;
+    return;
+  }
+
+  // Up to one second, limited by the shorter of the two entries
+  const TimelineEntry &to = track->getEntry(entrySelected + 1);
+  double duration =
+      std::min(1.0, 2.0 * std::min(from.getDuration(), to.getDuration()));
+  Transition transition(static_cast<TransitionType>(next), duration);
+  if (history.perform(new SetTransitionCommand(timeline, trackSelected,
+                                               entrySelected, transition))) {
+    std::cout << "Transition: " << transitionTypeName(transition.type)
+              << std::endl;
+  } else {
+    std::cerr << "Entries must touch to add a transition" << std::endl;
+  }
+}
+
+void Application::dissolveSelectedTrack() {
+  Track *track = timeline->getTrack(trackSelected);
+  if (!track) {
+    return;
+  }
+
+  // Fade out over each entry's own duration, undone as one step
+  EditGroupCommand *dissolve = new EditGroupCommand("Dissolve track");
+  for (size_t i = 0; i < track->getEntryCount(); i++) {
+    KeyframeTrack fade;
+    fade.setKeyframe(Keyframe(0.0, 1.0f));
+    fade.setKeyframe(Keyframe(track->getEntry(i).getDuration(), 0.0f));
+    dissolve->add(new SetKeyframesCommand(timeline, trackSelected, i,
+                                          EntryProperty::OPACITY, fade));
+  }
+  history.perform(dissolve);
+}
+
+bool Application::openProject(ExportSettings &settings) {
+  Project project;
+  ProjectFile file(assetFactory);
+  bool opened = hasExtension(projectPath, ".json") ? file.importJson(projectPath, project, *timeline)
+                     : file.load(projectPath, project, *timeline);
+  if (!opened) {
+    std::cerr << "Failed to open project: " << file.getLastError() << std::endl;
+    return false;
+  }
+
+  // Project assets follow any given on the command line
+  assets.insert(assets.end(), project.assets.begin(), project.assets.end());
+  assetSources.insert(assetSources.end(), project.assetSources.begin(),
+                      project.assetSources.end());
+  trackFilters = project.trackFilters;
+  settings = project.exportSettings;
+  std::cout << "Opened project " << projectPath << " ("
+            << timeline->getTrackCount() << " tracks)" << std::endl;
+  return true;
+}
+
+void Application::saveProject(bool json) {
+  Project project;
+  project.assetSources = assetSources;
+  project.assets = assets;
+  project.trackFilters = trackFilters;
+  project.exportSettings = exportMenuModel->getSettings();
+
+  // Save next to the project that was opened, or in the working directory
+  std::string path = projectPath.empty() ? "project.vedp" : projectPath;
+  size_t dot = path.find_last_of('.');
+  path = path.substr(0, dot) + (json ? ".json" : ".vedp");
+
+  ProjectFile file(assetFactory);
+  bool saved = json ? file.exportJson(path, project, *timeline)
+                    : file.save(path, project, *timeline);
+  if (saved) {
+    std::cout << "Saved project to " << path << std::endl;
+  } else {
+    std::cerr << "Failed to save project: " << file.getLastError() << std::endl;
+  }
+}
+
+void Application::undoEdit() {
+  // Stop any drag first, so it doesn't carry on from the restored state
+  isDraggingEntry = false;
+  isResizingEntry = false;
+
+  std::string description = history.getUndoDescription();
+  if (history.undo()) {
+    entrySelected = -1;
+    std::cout << "Undo " << description << std::endl;
+  }
+}
+
+void Application::redoEdit() {
+  isDraggingEntry = false;
+  isResizingEntry = false;
+
+  std::string description = history.getRedoDescription();
+  if (history.redo()) {
+    entrySelected = -1;
+    std::cout << "Redo " << description << std::endl;
+  }
+}
+
 void Application::onKeyPress(int key) {
   if (key == GLFW_KEY_0) {
     std::string code = "";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_1) {
     // Calculate brighten the entire image
     std::string code = "aggregateColor *= vec4(2.0, 2.0, 2.0, 1);\n"
                        "trackColor *= vec4(2.0, 2.0, 2.0, 1);\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_2) {
     // Draw a color gradient
     std::string code = "trackColor *= vec4(pos.x , pos.y, time, 1.0);\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_3) {
     // Calculate a low threshold
@@ -231,7 +395,7 @@ void Application::onKeyPress(int key) {
                        "   trackColor = vec4(0, 0, 0, 0);\n"
                        "}\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_4) {
     // Calculate a high threshold
@@ -239,7 +403,7 @@ void Application::onKeyPress(int key) {
                        "   trackColor = vec4(0, 0, 0, 0);\n"
                        "}\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_5) {
     // Greyscale the image
@@ -247,14 +411,14 @@ void Application::onKeyPress(int key) {
         "float L = (trackColor.r + trackColor.g + trackColor.b) / 3.0;\n"
         "trackColor = vec4(L, L, L, trackColor.a);\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_6) {
     // Only show the red channel
     std::string code =
         "trackColor = vec4(trackColor.r, 0.0, 0.0, trackColor.a);\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_7) {
     // Green screen effect
@@ -269,7 +433,7 @@ void Application::onKeyPress(int key) {
         "  trackColor.a -= greenStrength * supressionCoefficient;"
         "}";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_8) {
     // Set the transparency the the trackColor to 0 if it is outside of the
@@ -281,13 +445,10 @@ void Application::onKeyPress(int key) {
                        "  trackColor = vec4(0.0, 0.0, 0.0, 0.0);"
                        "}\n";
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   }
   if (key == GLFW_KEY_9) {
-    // Set the transparency of the trackColor to disolve over time
-    std::string code = "trackColor.a *= (1.0 - time);\n";
-    this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    dissolveSelectedTrack();
   }
 
   if (key == GLFW_KEY_S) {
@@ -299,7 +460,31 @@ void Application::onKeyPress(int key) {
                        "trackColor.b *= 0.90;\n";
 
     this->trackFilters[this->trackSelected] = code;
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
+  }
+
+  if (key == GLFW_KEY_B) {
+    cycleSelectedBlendMode();
+  }
+
+  if (key == GLFW_KEY_L) {
+    toggleLinearLight();
+  }
+
+  if (key == GLFW_KEY_P) {
+    saveProject(false);
+  }
+
+  if (key == GLFW_KEY_J) {
+    saveProject(true);
+  }
+
+  if (key == GLFW_KEY_Z) {
+    undoEdit();
+  }
+
+  if (key == GLFW_KEY_Y) {
+    redoEdit();
   }
 
   if (key == GLFW_KEY_SPACE) {
@@ -344,22 +529,34 @@ int Application::run(int argc, char *argv[]) {
   compositeFactory->add(new DefaultAssetFactory());
   assetFactory = compositeFactory;
 
-  // Loops through command line arguments and create assets using factory
+  // Loops through command line arguments and create assets using factory;
+  // a project file brings its own assets and tracks
   for (int i = 1; i < argc; i++) {
+    if (hasExtension(argv[i], ".vedp") || hasExtension(argv[i], ".json")) {
+      projectPath = argv[i];
+      continue;
+    }
     assets.push_back(assetFactory->create(argv[i]));
+    assetSources.push_back(argv[i]);
   }
 
+  // --------------------------------------------------------------------
+  // Setup Timeline, from the project or with an initial track
+  // --------------------------------------------------------------------
+  timeline = new Timeline();
+  ExportSettings projectSettings;
+  bool projectOpened = !projectPath.empty() && openProject(projectSettings);
+
   if (assets.size() == 0) {
     assets.push_back(assetFactory->create("default"));
+    assetSources.push_back("default");
   }
 
-  // --------------------------------------------------------------------
-  // Setup Timeline with initial track
-  // --------------------------------------------------------------------
-  timeline = new Timeline();
-  trackSelected = timeline->addTrack("Video Layer 1");
-  this->trackTextures.push_back(new Texture(blank));
-  this->trackFilters.push_back("");
+  if (timeline->getTrackCount() == 0) {
+    timeline->addTrack("Video Layer 1");
+  }
+  trackSelected = 0;
+  this->trackFilters.resize(timeline->getTrackCount());
 
   std::cout << "Timeline created with " << timeline->getTrackCount()
             << " track(s)" << std::endl;
@@ -490,8 +687,23 @@ int Application::run(int argc, char *argv[]) {
     // Create timeline entry
     TimelineEntry entry(asset, startTime, duration);
 
+    // Place text in the lower third at its own aspect ratio instead of
+    // stretching it over the whole frame
+    const Image &thumbnail = asset->getThumbnail();
+    if (asset->getAssetType() == AssetType::TEXT &&
+        thumbnail.getHeight() > 0 && compositeFrame.getWidth() > 0) {
+      EntryTransform placement;
+      placement.positionY = 0.85f;
+      placement.scaleY = 0.1f;
+      placement.scaleX = std::min(
+          0.9f, placement.scaleY * thumbnail.getWidth() / thumbnail.getHeight() *
+                    compositeFrame.getHeight() / compositeFrame.getWidth());
+      entry.setTransform(placement);
+    }
+
     // Add to selected track
-    bool success = timeline->addEntryToTrack(trackSelected, entry);
+    bool success =
+        history.perform(new AddEntryCommand(timeline, trackSelected, entry));
 
     if (success) {
       std::cout << "Added asset " << assetSelected << " to track "
@@ -521,7 +733,8 @@ int Application::run(int argc, char *argv[]) {
       return;
     }
 
-    bool success = track->removeEntry(entrySelected);
+    bool success = history.perform(
+        new RemoveEntryCommand(timeline, trackSelected, entrySelected));
     if (success) {
       std::cout << "Removed entry " << entrySelected << " from track "
                 << trackSelected << std::endl;
@@ -531,6 +744,10 @@ int Application::run(int argc, char *argv[]) {
     }
   });
 
+  assetActionsPanel->addTextButton("~ Transition", [this]() {
+    this->cycleSelectedTransition();
+  });
+
   filterPanel = new ButtonPanel(VIEWPORT_X, TITLE_HEIGHT + VIEWPORT_HEIGHT,
                                 VIEWPORT_WIDTH, ASSET_ACTIONS_HEIGHT,
                                 Color(80, 80, 80, 255), // Dark gray background
@@ -582,28 +799,25 @@ int Application::run(int argc, char *argv[]) {
     std::cout << "Created track " << trackIndex << ", now using track "
               << trackSelected << std::endl;
 
-    this->trackTextures.push_back(new Texture(blank));
     this->trackFilters.push_back("");
-    this->video->setTextures(trackTextures);
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   trackActionsPanel->addTextButton("X Clear All", [this]() {
     std::cout << "Clear Tracks clicked" << std::endl;
 
-    // Clear all tracks and create a new one
+    // Clear all tracks and create a new one; the old edits refer to tracks
+    // that are gone
     timeline->clearTracks();
+    history.clear();
     trackSelected = timeline->addTrack("Video Layer 1");
     entrySelected = -1; // Clear entry selection
 
     std::cout << "Cleared all tracks, created new track 0" << std::endl;
 
-    this->trackTextures.clear();
-    this->trackTextures.push_back(new Texture(blank));
     this->trackFilters.clear();
     this->trackFilters.push_back("");
-    this->video->setTextures(trackTextures);
-    this->trackShader->update(this->trackFilters);
+    this->updateTrackShader();
   });
 
   trackActionsPanel->addTextButton("< Prev Track", [this]() {
@@ -646,6 +860,7 @@ int Application::run(int argc, char *argv[]) {
 
   // Create EXPORT MENU (MVC pattern on right side)
   exportFacade = new ExportFacade();
+  exportFacade->setAssetSources(assetFactory, &assets, &assetSources);
   exportMenuModel = new ExportMenuModel();
   exportMenuView =
       new ExportMenuView(EXPORT_MENU_X, TITLE_HEIGHT, EXPORT_MENU_WIDTH,
@@ -654,6 +869,12 @@ int Application::run(int argc, char *argv[]) {
       new ExportMenuController(exportMenuModel, exportMenuView, exportFacade);
   exportMenuView->setController(exportMenuController);
 
+  // Export videos in the background, one at a time: each export already
+  // keeps every core busy
+  exportJobs = new ExportJobManager(1);
+  exportJobs->addObserver(exportMenuView);
+  exportMenuController->setJobManager(exportJobs);
+
   // Set initial asset for export
   if (assets.size() > 0) {
     exportMenuModel->setAsset(assets[0]);
@@ -662,6 +883,9 @@ int Application::run(int argc, char *argv[]) {
 
   // Set timeline for video export
   exportMenuModel->setTimeline(timeline);
+  if (projectOpened) {
+    exportMenuModel->setSettings(projectSettings);
+  }
 
   // Update view to create UI buttons now that controller is set
   exportMenuView->update();
@@ -670,10 +894,9 @@ int Application::run(int argc, char *argv[]) {
   const Image &image = assets[0]->getFrame();
   // Texture videoTexture(image);
   trackShader = new TrackShader();
-  trackShader->update(trackFilters);
+  updateTrackShader();
   video = new Glyph(VIEWPORT_X, TITLE_HEIGHT, VIEWPORT_WIDTH, VIEWPORT_HEIGHT,
                     trackShader);
-  video->setTextures(trackTextures);
   // video.addTexture(videoTexture);
 
   // video.addTexture(imageTexture);
@@ -689,6 +912,9 @@ int Application::run(int argc, char *argv[]) {
       TRACK_ACTIONS_WIDTH, TRACKS_Y + 0.05f, 1.0f - TRACK_ACTIONS_WIDTH,
       TRACKS_HEIGHT - 0.05f, timeline);
 
+  // CPU composite buffer, allocated once and reused for every frame
+  compositeFrame = Image(image.getWidth(), image.getHeight());
+
   // Set the window drawing area
   glViewport(0, 0, image.getWidth(), image.getHeight());
 
@@ -700,6 +926,11 @@ int Application::run(int argc, char *argv[]) {
       glfwSetWindowShouldClose(window->getWindow(), true);
     }
 
+    // Show the progress of background exports
+    if (exportJobs) {
+      exportJobs->update();
+    }
+
     double timeSinceStart = 0.0;
     if (is_playing) {
       std::chrono::steady_clock::time_point currentTime =
@@ -724,25 +955,45 @@ int Application::run(int argc, char *argv[]) {
     // Render the timeline composite at current time
     // If timeline is empty, show the currently selected asset
     const Image *current_image = nullptr;
-    Image *timeline_image = nullptr;
 
     trackShader->use();
     trackShader->setFloat("duration", timeline->getTotalDuration());
     trackShader->setFloat("timeSinceStart", timeSinceStart);
+    trackShader->setVec2("frameSize", compositeFrame.getWidth(),
+                         compositeFrame.getHeight());
+    trackShader->setBackgroundColor(timeline->getBackgroundColor());
+    trackShader->setLinearLight(timeline->getCompositingMode() ==
+                                CompositingMode::LINEAR_16BIT);
 
     if (timeline->getTrackCount() > 0 && timeline->getTotalDuration() > 0) {
-      // Render timeline composite
-      // timeline_image = timeline->renderFrameAt(timeSinceStart,
-      // image.getWidth(),
-      // image.getHeight());
-      // current_image = timeline_image;
+      // Render timeline composite on the CPU (reuses the same buffer every
+      // frame, so playback does not allocate):
+      // timeline->renderFrameInto(timeSinceStart, compositeFrame);
+      // current_image = &compositeFrame;
       const std::vector<Track *> &tracks = timeline->getTracks();
 
+      // Decode all video tracks concurrently and prefetch upcoming clips
+      timeline->prepareFrame(timeSinceStart);
+
       for (int i = 0; i < tracks.size(); i++) {
         const Track *track = tracks[i];
+        trackShader->clearTrackTransition(i);
 
         if (!track->isVisible()) {
-          trackTextures[i]->copyToGPU(blank);
+          trackShader->clearTrackFrame(i);
+          continue;
+        }
+
+        // Both entries are uploaded while a transition is in progress
+        Track::ActiveTransition active;
+        if (track->getTransitionAt(timeSinceStart, active)) {
+          trackShader->setTrackFrame(
+              i, active.from->getFrameAt(timeSinceStart),
+              active.from->getTransformAt(timeSinceStart));
+          trackShader->setTrackTransition(
+              i, *active.transition, active.progress,
+              active.to->getFrameAt(timeSinceStart),
+              active.to->getTransformAt(timeSinceStart));
           continue;
         }
 
@@ -752,7 +1003,7 @@ int Application::run(int argc, char *argv[]) {
           // Uncomment for verbose debugging:
           // std::cout << "Track " << i << " (" << track->getName() << ") has
           // no entry at time " << time << "s" << std::endl;
-          trackTextures[i]->copyToGPU(blank);
+          trackShader->clearTrackFrame(i);
           continue; // No entry active on this track at this time
         }
 
@@ -767,7 +1018,8 @@ int Application::run(int argc, char *argv[]) {
         // return result;
 
         // Composite this layer onto the result
-        trackTextures[i]->copyToGPU(layerImage);
+        trackShader->setTrackFrame(i, layerImage,
+                                   entry->getTransformAt(timeSinceStart));
       }
 
     } else {
@@ -780,14 +1032,12 @@ int Application::run(int argc, char *argv[]) {
       }
     }
 
+    // The viewport composites every track from these two textures
+    trackShader->bindLayers();
+
     // videoTexture.copyToGPU(*current_image);
     // trackPanel.update(*current_image);
 
-    // Clean up timeline rendered image
-    if (timeline_image) {
-      delete timeline_image;
-    }
-
     // -------------------------------------
     // Render Graphics - NEW LAYOUT
     // -------------------------------------
@@ -859,14 +1109,15 @@ void Application::onMouseMove(float x, float y) {
   if (isResizingEntry && trackVisualization) {
     Track *track = timeline->getTrack(trackSelected);
     if (track && entrySelected >= 0 && entrySelected < track->getEntryCount()) {
-      const TimelineEntry &entry = track->getEntries()[entrySelected];
+      const TimelineEntry &entry = track->getEntry(entrySelected);
 
       // Calculate new duration based on mouse position
       double clickTime = trackVisualization->getTimeAtPosition(x);
       double newDuration = clickTime - entry.getStartTime();
 
       // Update entry duration
-      bool success = track->updateEntryDuration(entrySelected, newDuration);
+      bool success = history.perform(new ResizeEntryCommand(
+          timeline, trackSelected, entrySelected, newDuration));
       if (success) {
         resizeStartDuration = newDuration;
       }
@@ -886,8 +1137,12 @@ void Application::onMouseMove(float x, float y) {
     // Update entry position
     Track *track = timeline->getTrack(trackSelected);
     if (track && entrySelected >= 0 && entrySelected < track->getEntryCount()) {
-      bool success = track->updateEntryStartTime(entrySelected, newStartTime);
+      bool success = history.perform(new MoveEntryCommand(
+          timeline, trackSelected, entrySelected, newStartTime));
       if (success) {
+        // Jumping past another entry changes the index
+        entrySelected = (int)track->getEntryIndexAtTicks(
+            secondsToTicks(newStartTime));
         // Update drag start for next frame
         dragStartX = x;
         dragStartTime = newStartTime;
@@ -962,6 +1217,10 @@ void Application::onMouseClick(int button, int action, int mods) {
 
   // Handle mouse release - stop dragging/resizing
   if (action == GLFW_RELEASE) {
+    if (isDraggingEntry || isResizingEntry) {
+      // The drag's moves were merged into one step; end it
+      history.seal();
+    }
     if (isDraggingEntry) {
       isDraggingEntry = false;
       std::cout << "Finished dragging entry" << std::endl;
@@ -987,7 +1246,7 @@ void Application::onMouseClick(int button, int action, int mods) {
       Track *track = timeline->getTrack(trackSelected);
       if (track && entrySelected >= 0 &&
           entrySelected < track->getEntryCount()) {
-        const TimelineEntry &entry = track->getEntries()[entrySelected];
+        const TimelineEntry &entry = track->getEntry(entrySelected);
         resizeStartDuration = entry.getDuration();
         isResizingEntry = true;
         std::cout << "Started resizing entry " << clickedEntry << " on track "
@@ -1007,7 +1266,7 @@ void Application::onMouseClick(int button, int action, int mods) {
       Track *track = timeline->getTrack(trackSelected);
       if (track && entrySelected >= 0 &&
           entrySelected < track->getEntryCount()) {
-        const TimelineEntry &entry = track->getEntries()[entrySelected];
+        const TimelineEntry &entry = track->getEntry(entrySelected);
         dragStartTime = entry.getStartTime();
         dragStartX = x;
         isDraggingEntry = true;
@@ -1,4 +1,5 @@
 #include "assets/Caption.h"
+#include "compositor/Blend.h"
 #include <iostream>
 #include <fstream>
 
@@ -75,6 +76,7 @@ void Caption::regenerateImage() {
 
     // Generate the text image using the current project's API
     Image* newImage = textRenderer->renderToImage();
+    premultiplySpan(newImage->getData(), newImage->getWidth() * newImage->getHeight());
 
     // Store the new image
     if (renderedImage) {
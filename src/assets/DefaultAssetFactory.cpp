@@ -47,7 +47,7 @@ private:
 };
 
 IAsset *DefaultAssetFactory::create(const std::string &value) const {
-  std::cout << value << ": No suitable factory found (creating default asset)."
+  std::cerr << value << ": No suitable factory found (creating default asset)."
             << std::endl;
   return new DefaultAsset();
 }
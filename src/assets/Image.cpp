@@ -1,6 +1,7 @@
 #include "Image.h"
 
 #include <algorithm>
+#include <cstring>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -72,6 +73,31 @@ void Image::setPixel(int x, int y, const Color &color) {
   pixel[3] = color[3];
 }
 
+void Image::fill(const Color &color) {
+  size_t total = static_cast<size_t>(width) * height * components;
+  if (!pixels || total == 0) {
+    return;
+  }
+
+  unsigned char pattern[4] = {color[0], color[1], color[2], color[3]};
+
+  // Uniform bytes (black, white, grey with matching alpha) are a plain memset
+  if (pattern[0] == pattern[1] && pattern[1] == pattern[2] &&
+      pattern[2] == pattern[3]) {
+    std::memset(pixels, pattern[0], total);
+    return;
+  }
+
+  // Seed one pixel, then keep doubling the filled span with memcpy
+  std::memcpy(pixels, pattern, components);
+  size_t filled = components;
+  while (filled < total) {
+    size_t count = std::min(filled, total - filled);
+    std::memcpy(pixels + filled, pixels, count);
+    filled += count;
+  }
+}
+
 void Image::saveAs(const std::string &filename) const {
   stbi_write_png(filename.c_str(), width, height, components, pixels,
                  width * components);
@@ -86,4 +112,11 @@ void Image::operator=(const Image &image) {
   std::copy(image.pixels, image.pixels + width * height * components, pixels);
 }
 
+void Image::swap(Image &other) {
+  std::swap(width, other.width);
+  std::swap(height, other.height);
+  std::swap(components, other.components);
+  std::swap(pixels, other.pixels);
+}
+
 } // namespace csci3081
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "assets/ImageAsset.h"
+#include "compositor/Blend.h"
 
 namespace csci3081 {
 
 ImageAsset::ImageAsset(const std::string &filename) {
   image = new Image(filename);
+  premultiplySpan(image->getData(), image->getWidth() * image->getHeight());
 }
 
 ImageAsset::~ImageAsset() { delete image; }
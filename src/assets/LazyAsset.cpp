@@ -0,0 +1,43 @@
+#include "assets/LazyAsset.h"
+#include <iostream>
+
+namespace csci3081 {
+
+LazyAsset::LazyAsset(const IAssetFactory* factory, const std::string& source,
+                     double duration, AssetType type)
+  : factory(factory), source(source), duration(duration), type(type),
+    asset(nullptr), placeholder(1, 1) {
+  placeholder.fill(Color(0, 0, 0, 0));
+}
+
+LazyAsset::~LazyAsset() {
+  delete asset;
+}
+
+const Image& LazyAsset::getFrame(double time) {
+  IAsset* real = resolve();
+  return real ? real->getFrame(time) : placeholder;
+}
+
+const Image& LazyAsset::getThumbnail() {
+  IAsset* real = resolve();
+  return real ? real->getThumbnail() : placeholder;
+}
+
+bool LazyAsset::isLoaded() const {
+  // Only meaningful on the thread that loaded it, or after a frame request
+  // has returned
+  return asset != nullptr;
+}
+
+IAsset* LazyAsset::resolve() {
+  std::call_once(loaded, [this]() {
+    asset = factory ? factory->create(source) : nullptr;
+    if (!asset) {
+      std::cerr << "Could not load asset '" << source << "'" << std::endl;
+    }
+  });
+  return asset;
+}
+
+} // namespace csci3081
@@ -1,10 +1,13 @@
 #include "assets/TextAsset.h"
+#include "compositor/Blend.h"
 
 namespace csci3081 {
 
 TextAsset::TextAsset(const std::string& textStr, const Color& color, int fontSize, const std::string& fontFamily) {
   text = new Text(textStr, color, fontSize, fontFamily);
   renderedImage = text->renderToImage();
+  premultiplySpan(renderedImage->getData(),
+                  renderedImage->getWidth() * renderedImage->getHeight());
 }
 
 TextAsset::~TextAsset() {
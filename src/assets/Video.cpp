@@ -1,20 +1,31 @@
 #include "Video.h"
+#include <cstring>
 #include <iostream>
 
 namespace csci3081 {
 
+namespace {
+
+// Decoding further than this ahead is slower than seeking
+const Ticks MAX_DECODE_AHEAD = TICKS_PER_SECOND;
+
+} // namespace
+
 Video::Video(const std::string &filename) {
   memset(&videoState, 0, sizeof(videoState));
 
   if (video_reader_open(&videoState, filename.c_str())) {
     // video_loaded = true;
     frame = new Image(videoState.width, videoState.height);
-    frameRate = av_q2d(videoState.time_base);
-    frameRate = 1.0 / frameRate; // Convert to fps
-    if (frameRate > 60 || frameRate < 1) {
-      frameRate = 30.0; // Fallback to reasonable frame rate
+    timeBase = Rational(videoState.time_base.num, videoState.time_base.den);
+    rate = Rational(videoState.frame_rate.num, videoState.frame_rate.den);
+    frameRate = rate.toDouble();
+    if (frameRate > 240 || frameRate < 1) {
+      rate = Rational(30, 1); // Fallback to reasonable frame rate
+      frameRate = 30.0;
     }
-    std::cout << "Video loaded: " << videoState.width << "x"
+    frameLength = frameToTicks(1, rate);
+    std::cerr << "Video loaded: " << videoState.width << "x"
               << videoState.height << " @ " << frameRate << " fps"
               << " (" << videoState.duration << " seconds)" << std::endl;
     // Load the first frame immediately
@@ -22,8 +33,9 @@ Video::Video(const std::string &filename) {
     int64_t pts;
     video_reader_read_frame(&videoState, frame_buffer, &pts);
     currentPts = pts;
+    firstPts = pts;
   } else {
-    std::cout << "Failed to load video" << std::endl;
+    std::cerr << "Failed to load video" << std::endl;
   }
 }
 
@@ -32,46 +44,55 @@ Video::~Video() {
   video_reader_close(&videoState);
 }
 
+Ticks Video::ptsToTicks(int64_t pts) const {
+  return timestampToTicks(pts - firstPts, timeBase);
+}
+
 bool Video::nextFrame(double time) {
-  // If time jumped backwards significantly (more than 2 frames), we need to seek/restart
-  double timeJump = time - lastFrameTime;
-  if (timeJump < -(2.0 / frameRate)) {
-    // Significant backwards jump - need to restart video
-    std::cout << "[Video] Backward jump detected: " << lastFrameTime << "s -> " << time << "s (seeking)" << std::endl;
+  Ticks target = secondsToTicks(time);
+  Ticks current = ptsToTicks(currentPts);
+
+  // Frames can only be decoded forward: going back means seeking
+  if (target < current) {
+    std::cerr << "[Video] Backward jump detected: " << ticksToSeconds(current)
+              << "s -> " << time << "s (seeking)" << std::endl;
     seekFrame(time);
-    // Note: seekFrame() sets lastFrameTime, so we don't set it again here
     return true;
   }
 
   // If time jumped forward significantly (more than 1 second), seek to catch up
-  if (timeJump > 1.0) {
-    std::cout << "[Video] Forward jump detected: " << lastFrameTime << "s -> " << time << "s (seeking)" << std::endl;
+  if (target - current > MAX_DECODE_AHEAD) {
+    std::cerr << "[Video] Forward jump detected: " << ticksToSeconds(current)
+              << "s -> " << time << "s (seeking)" << std::endl;
     seekFrame(time);
-    // Note: seekFrame() sets lastFrameTime, so we don't set it again here
     return true;
   }
 
-  double time_since_last_frame = time - lastFrameTime;
+  return decodeUntil(target);
+}
 
-  if (time_since_last_frame >= (1.0 / frameRate)) {
-    uint8_t *frame_buffer = static_cast<uint8_t *>(frame->getData());
+bool Video::decodeUntil(Ticks target) {
+  uint8_t *frame_buffer = static_cast<uint8_t *>(frame->getData());
+  while (ptsToTicks(currentPts) + frameLength <= target) {
     int64_t pts;
-    if (video_reader_read_frame(&videoState, frame_buffer, &pts)) {
-      currentPts = pts;
-    } else {
-      std::cerr << "[Video] FAILED to read frame at time " << time << "s" << std::endl;
+    if (!video_reader_read_frame(&videoState, frame_buffer, &pts)) {
+      std::cerr << "[Video] FAILED to read frame at time "
+                << ticksToSeconds(target) << "s" << std::endl;
       return false;
     }
-
-    lastFrameTime = time;
+    if (pts <= currentPts) {
+      break;   // End of stream (the last frame is repeated)
+    }
+    currentPts = pts;
   }
-
   return true;
 }
 
 void Video::seekFrame(double time) {
-  // Seek to specific time in video
-  int64_t target_pts = (int64_t)(time / av_q2d(videoState.time_base));
+  // Seek to specific time in video; the seek lands on the keyframe at or
+  // before it, so decode forward from there
+  Ticks target = secondsToTicks(time);
+  int64_t target_pts = firstPts + ticksToTimestamp(target, timeBase, Rounding::DOWN);
 
   // Use ffmpeg seek to jump to the target time
   if (video_reader_seek_frame(&videoState, target_pts)) {
@@ -80,18 +101,16 @@ void Video::seekFrame(double time) {
     int64_t pts;
     if (video_reader_read_frame(&videoState, frame_buffer, &pts)) {
       currentPts = pts;
-      lastFrameTime = time;
+      decodeUntil(target);
     }
   } else {
     // If seek fails, try to seek to beginning as fallback
-    std::cout << "Seek to " << time << "s failed, trying beginning" << std::endl;
-    if (video_reader_seek_frame(&videoState, 0)) {
+    std::cerr << "Seek to " << time << "s failed, trying beginning" << std::endl;
+    if (video_reader_seek_frame(&videoState, firstPts)) {
       uint8_t *frame_buffer = static_cast<uint8_t *>(frame->getData());
       int64_t pts;
       if (video_reader_read_frame(&videoState, frame_buffer, &pts)) {
         currentPts = pts;
-        // We seeked to beginning (0), not to requested time, so set lastFrameTime accordingly
-        lastFrameTime = 0.0;
       }
     } else {
       std::cerr << "WARNING: Video seeking completely failed, playback may be broken" << std::endl;
@@ -99,4 +118,4 @@ void Video::seekFrame(double time) {
   }
 }
 
-} // namespace csci3081
\ No newline at end of file
+} // namespace csci3081
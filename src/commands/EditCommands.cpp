@@ -0,0 +1,251 @@
+#include "commands/EditCommands.h"
+#include <stdexcept>
+
+namespace csci3081 {
+
+namespace {
+
+size_t keyframeMemory(const KeyframeTrack& keyframes) {
+  return keyframes.getKeyframeCount() * sizeof(Keyframe);
+}
+
+size_t entryMemory(const TimelineEntry& entry) {
+  size_t size = sizeof(TimelineEntry);
+  for (int i = 0; i < ENTRY_PROPERTY_COUNT; i++) {
+    size += keyframeMemory(entry.getKeyframes(static_cast<EntryProperty>(i)));
+  }
+  return size;
+}
+
+// Find an entry by its start time after an edit moved it
+size_t indexStartingAt(const Track& track, Ticks start) {
+  size_t index = track.getEntryIndexAtTicks(start);
+  if (index == Track::npos || track.getEntry(index).getStartTicks() != start) {
+    throw std::runtime_error("Edited entry not found");
+  }
+  return index;
+}
+
+} // namespace
+
+// ==============================================================================
+// EntryCommand
+// ==============================================================================
+
+bool EntryCommand::canExecute() const {
+  return timeline != nullptr && timeline->getTrack(trackIndex) != nullptr;
+}
+
+Track& EntryCommand::getTrack() const {
+  Track* track = timeline ? timeline->getTrack(trackIndex) : nullptr;
+  if (!track) {
+    throw std::runtime_error("Track " + std::to_string(trackIndex) + " does not exist");
+  }
+  return *track;
+}
+
+// ==============================================================================
+// AddEntryCommand
+// ==============================================================================
+
+void AddEntryCommand::execute() {
+  Track& track = getTrack();
+  if (!track.addEntry(entry, ripple)) {
+    throw std::runtime_error("Entry overlaps an existing entry");
+  }
+  index = indexStartingAt(track, entry.getStartTicks());
+}
+
+void AddEntryCommand::undo() {
+  if (!getTrack().removeEntry(index, ripple)) {
+    throw std::runtime_error("Added entry not found");
+  }
+}
+
+size_t AddEntryCommand::getMemoryUsage() const {
+  return sizeof(*this) - sizeof(TimelineEntry) + entryMemory(entry);
+}
+
+// ==============================================================================
+// RemoveEntryCommand
+// ==============================================================================
+
+void RemoveEntryCommand::execute() {
+  Track& track = getTrack();
+  if (index >= track.getEntryCount()) {
+    throw std::runtime_error("Invalid entry index");
+  }
+  removed = track.getEntry(index);
+  track.removeEntry(index, ripple);
+}
+
+void RemoveEntryCommand::undo() {
+  // A ripple insert pushes the later entries back by as much as the ripple
+  // delete pulled them in
+  if (!getTrack().addEntry(removed, ripple)) {
+    throw std::runtime_error("Removed entry no longer fits");
+  }
+}
+
+size_t RemoveEntryCommand::getMemoryUsage() const {
+  return sizeof(*this) - sizeof(TimelineEntry) + entryMemory(removed);
+}
+
+// ==============================================================================
+// MoveEntryCommand
+// ==============================================================================
+
+void MoveEntryCommand::execute() {
+  Track& track = getTrack();
+  if (index >= track.getEntryCount()) {
+    throw std::runtime_error("Invalid entry index");
+  }
+  oldStart = track.getEntry(index).getStartTicks();
+  if (!track.updateEntryStartTime(index, ticksToSeconds(newStart))) {
+    throw std::runtime_error("Entry would overlap another entry");
+  }
+  newIndex = indexStartingAt(track, newStart);
+}
+
+void MoveEntryCommand::undo() {
+  if (!getTrack().updateEntryStartTime(newIndex, ticksToSeconds(oldStart))) {
+    throw std::runtime_error("Entry can't move back");
+  }
+}
+
+bool MoveEntryCommand::mergeWith(const IEditCommand& next) {
+  const MoveEntryCommand* move = dynamic_cast<const MoveEntryCommand*>(&next);
+  if (!move || !sameTrack(*move) || move->index != newIndex) {
+    return false;
+  }
+
+  // The entry was free at both ends, so one move between them is valid
+  newStart = move->newStart;
+  newIndex = move->newIndex;
+  return true;
+}
+
+// ==============================================================================
+// ResizeEntryCommand
+// ==============================================================================
+
+void ResizeEntryCommand::execute() {
+  Track& track = getTrack();
+  if (index >= track.getEntryCount()) {
+    throw std::runtime_error("Invalid entry index");
+  }
+  oldDuration = track.getEntry(index).getDurationTicks();
+  if (!track.updateEntryDuration(index, ticksToSeconds(newDuration), ripple)) {
+    throw std::runtime_error("Entry can't take that duration");
+  }
+}
+
+void ResizeEntryCommand::undo() {
+  if (!getTrack().updateEntryDuration(index, ticksToSeconds(oldDuration), ripple)) {
+    throw std::runtime_error("Entry can't take its old duration");
+  }
+}
+
+bool ResizeEntryCommand::mergeWith(const IEditCommand& next) {
+  const ResizeEntryCommand* resize = dynamic_cast<const ResizeEntryCommand*>(&next);
+  if (!resize || !sameTrack(*resize) || resize->index != index ||
+      resize->ripple != ripple) {
+    return false;
+  }
+
+  newDuration = resize->newDuration;
+  return true;
+}
+
+// ==============================================================================
+// SetTransitionCommand
+// ==============================================================================
+
+void SetTransitionCommand::execute() {
+  Track& track = getTrack();
+  if (index >= track.getEntryCount()) {
+    throw std::runtime_error("Invalid entry index");
+  }
+  const TimelineEntry& entry = track.getEntry(index);
+  hadTransition = entry.hasOutTransition();
+  if (hadTransition) {
+    oldTransition = entry.getOutTransition();
+  }
+  apply(hasTransition, newTransition);
+}
+
+void SetTransitionCommand::undo() {
+  apply(hadTransition, oldTransition);
+}
+
+void SetTransitionCommand::apply(bool has, const Transition& transition) {
+  Track& track = getTrack();
+  bool applied = has ? track.setTransition(index, transition)
+                     : track.removeTransition(index);
+  if (!applied) {
+    throw std::runtime_error("Entries can't take the transition");
+  }
+}
+
+// ==============================================================================
+// SetKeyframesCommand
+// ==============================================================================
+
+void SetKeyframesCommand::execute() {
+  Track& track = getTrack();
+  if (index >= track.getEntryCount()) {
+    throw std::runtime_error("Invalid entry index");
+  }
+  oldKeyframes = track.getEntry(index).getKeyframes(property);
+  track.updateEntryKeyframes(index, property, newKeyframes);
+}
+
+void SetKeyframesCommand::undo() {
+  if (!getTrack().updateEntryKeyframes(index, property, oldKeyframes)) {
+    throw std::runtime_error("Invalid entry index");
+  }
+}
+
+size_t SetKeyframesCommand::getMemoryUsage() const {
+  return sizeof(*this) + keyframeMemory(oldKeyframes) + keyframeMemory(newKeyframes);
+}
+
+// ==============================================================================
+// EditGroupCommand
+// ==============================================================================
+
+EditGroupCommand::~EditGroupCommand() {
+  for (IEditCommand* command : commands) {
+    delete command;
+  }
+}
+
+void EditGroupCommand::execute() {
+  for (size_t i = 0; i < commands.size(); i++) {
+    try {
+      commands[i]->execute();
+    } catch (...) {
+      while (i > 0) {
+        commands[--i]->undo();
+      }
+      throw;
+    }
+  }
+}
+
+void EditGroupCommand::undo() {
+  for (size_t i = commands.size(); i > 0; i--) {
+    commands[i - 1]->undo();
+  }
+}
+
+size_t EditGroupCommand::getMemoryUsage() const {
+  size_t size = sizeof(*this) + description.capacity() +
+                commands.capacity() * sizeof(IEditCommand*);
+  for (const IEditCommand* command : commands) {
+    size += command->getMemoryUsage();
+  }
+  return size;
+}
+
+} // namespace csci3081
@@ -0,0 +1,137 @@
+#include "commands/EditHistory.h"
+#include <exception>
+#include <iostream>
+
+namespace csci3081 {
+
+const size_t EditHistory::DEFAULT_MEMORY_LIMIT = 16 * 1024 * 1024;
+
+EditHistory::EditHistory(size_t memoryLimit)
+  : memoryUsage(0), memoryLimit(memoryLimit), sealed(true) {
+}
+
+EditHistory::~EditHistory() {
+  clear();
+}
+
+bool EditHistory::perform(IEditCommand* command) {
+  if (!command) {
+    return false;
+  }
+  if (!command->canExecute()) {
+    delete command;
+    return false;
+  }
+
+  try {
+    command->execute();
+  } catch (const std::exception& e) {
+    std::cerr << command->getDescription() << " failed: " << e.what() << std::endl;
+    delete command;
+    return false;
+  }
+
+  clearRedo();
+
+  if (!sealed && !done.empty()) {
+    IEditCommand* last = done.back();
+    size_t before = last->getMemoryUsage();
+    if (last->mergeWith(*command)) {
+      memoryUsage = memoryUsage - before + last->getMemoryUsage();
+      delete command;
+      return true;
+    }
+  }
+
+  done.push_back(command);
+  memoryUsage += command->getMemoryUsage();
+  sealed = false;
+  trim();
+  return true;
+}
+
+bool EditHistory::undo() {
+  if (done.empty()) {
+    return false;
+  }
+
+  IEditCommand* command = done.back();
+  try {
+    command->undo();
+  } catch (const std::exception& e) {
+    // The timeline no longer matches the history, so none of it can be
+    // trusted
+    std::cerr << "Undo " << command->getDescription() << " failed: " << e.what()
+              << std::endl;
+    clear();
+    return false;
+  }
+
+  done.pop_back();
+  undone.push_back(command);
+  sealed = true;
+  return true;
+}
+
+bool EditHistory::redo() {
+  if (undone.empty()) {
+    return false;
+  }
+
+  IEditCommand* command = undone.back();
+  try {
+    command->execute();
+  } catch (const std::exception& e) {
+    std::cerr << "Redo " << command->getDescription() << " failed: " << e.what()
+              << std::endl;
+    clearRedo();
+    return false;
+  }
+
+  undone.pop_back();
+  done.push_back(command);
+  sealed = true;
+  return true;
+}
+
+void EditHistory::clear() {
+  for (IEditCommand* command : done) {
+    delete command;
+  }
+  done.clear();
+  clearRedo();
+  memoryUsage = 0;
+  sealed = true;
+}
+
+void EditHistory::setMemoryLimit(size_t limit) {
+  memoryLimit = limit;
+  trim();
+}
+
+std::string EditHistory::getUndoDescription() const {
+  return done.empty() ? std::string() : done.back()->getDescription();
+}
+
+std::string EditHistory::getRedoDescription() const {
+  return undone.empty() ? std::string() : undone.back()->getDescription();
+}
+
+void EditHistory::clearRedo() {
+  for (IEditCommand* command : undone) {
+    memoryUsage -= command->getMemoryUsage();
+    delete command;
+  }
+  undone.clear();
+}
+
+void EditHistory::trim() {
+  while (memoryUsage > memoryLimit && done.size() > 1) {
+    IEditCommand* oldest = done.front();
+    memoryUsage -= oldest->getMemoryUsage();
+    delete oldest;
+    done.pop_front();
+  }
+}
+
+} // namespace csci3081
@@ -0,0 +1,192 @@
+#include "commands/ExportJobManager.h"
+#include <algorithm>
+#include <exception>
+
+namespace csci3081 {
+
+ExportJobManager::ExportJobManager(int maxConcurrent) : nextId(1), stopping(false) {
+  for (int i = 0; i < std::max(1, maxConcurrent); i++) {
+    workers.emplace_back(&ExportJobManager::workerLoop, this);
+  }
+}
+
+ExportJobManager::~ExportJobManager() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  cancelAll();
+  wake.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+int ExportJobManager::submit(ICommand* command) {
+  std::unique_ptr<Job> job(new Job());
+  job->command.reset(command);
+  if (!command || !command->canExecute()) {
+    return -1;
+  }
+  job->description = command->getDescription();
+  job->state = ExportJobState::QUEUED;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (stopping) {
+    return -1;
+  }
+  job->id = nextId++;
+  queue.push_back(job.get());
+  jobs.push_back(std::move(job));
+  wake.notify_one();
+  return jobs.back()->id;
+}
+
+bool ExportJobManager::cancel(int id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const std::unique_ptr<Job>& job : jobs) {
+    if (job->id != id) {
+      continue;
+    }
+    if (job->state == ExportJobState::QUEUED) {
+      queue.erase(std::find(queue.begin(), queue.end(), job.get()));
+      job->state = ExportJobState::CANCELLED;
+      finished.notify_all();
+      return true;
+    }
+    if (job->state == ExportJobState::RUNNING) {
+      job->monitor.cancel();
+      return true;
+    }
+    return false;
+  }
+  return false;
+}
+
+void ExportJobManager::cancelAll() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (Job* job : queue) {
+    job->state = ExportJobState::CANCELLED;
+  }
+  queue.clear();
+  for (const std::unique_ptr<Job>& job : jobs) {
+    if (job->state == ExportJobState::RUNNING) {
+      job->monitor.cancel();
+    }
+  }
+  finished.notify_all();
+}
+
+std::vector<ExportJobStatus> ExportJobManager::getJobs() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<ExportJobStatus> statuses;
+  for (const std::unique_ptr<Job>& job : jobs) {
+    statuses.push_back(statusOf(*job));
+  }
+  return statuses;
+}
+
+bool ExportJobManager::isBusy() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const std::unique_ptr<Job>& job : jobs) {
+    if (!isOver(*job)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ExportJobManager::waitForAll() {
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [this]() {
+    for (const std::unique_ptr<Job>& job : jobs) {
+      if (!isOver(*job)) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
+
+void ExportJobManager::removeFinished() {
+  std::lock_guard<std::mutex> lock(mutex);
+  jobs.erase(std::remove_if(jobs.begin(), jobs.end(),
+                            [](const std::unique_ptr<Job>& job) { return isOver(*job); }),
+             jobs.end());
+}
+
+void ExportJobManager::update() {
+  std::vector<ExportJobStatus> statuses = getJobs();
+  bool changed = statuses.size() != lastNotified.size();
+  for (size_t i = 0; !changed && i < statuses.size(); i++) {
+    changed = statuses[i].id != lastNotified[i].id ||
+              statuses[i].state != lastNotified[i].state ||
+              statuses[i].progress.framesDone != lastNotified[i].progress.framesDone;
+  }
+  if (!changed) {
+    return;
+  }
+  lastNotified = statuses;
+  for (IExportJobObserver* observer : observers) {
+    observer->onJobsChanged(statuses);
+  }
+}
+
+void ExportJobManager::addObserver(IExportJobObserver* observer) {
+  if (observer && std::find(observers.begin(), observers.end(), observer) == observers.end()) {
+    observers.push_back(observer);
+  }
+}
+
+void ExportJobManager::removeObserver(IExportJobObserver* observer) {
+  observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+}
+
+void ExportJobManager::workerLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+    if (queue.empty()) {
+      return;   // Stopping, and cancelAll() emptied the queue
+    }
+    Job* job = queue.front();
+    queue.pop_front();
+    job->state = ExportJobState::RUNNING;
+    lock.unlock();
+
+    std::string error;
+    try {
+      job->command->setMonitor(&job->monitor);
+      job->command->execute();
+    } catch (const std::exception& e) {
+      error = e.what();
+    } catch (...) {
+      error = "Unknown error";
+    }
+
+    lock.lock();
+    job->error = error;
+    if (job->monitor.isCancelled() && !error.empty()) {
+      job->state = ExportJobState::CANCELLED;
+    } else {
+      job->state = error.empty() ? ExportJobState::FINISHED : ExportJobState::FAILED;
+    }
+    finished.notify_all();
+  }
+}
+
+bool ExportJobManager::isOver(const Job& job) {
+  return job.state != ExportJobState::QUEUED && job.state != ExportJobState::RUNNING;
+}
+
+ExportJobStatus ExportJobManager::statusOf(const Job& job) const {
+  ExportJobStatus status;
+  status.id = job.id;
+  status.description = job.description;
+  status.state = job.state;
+  status.progress = job.monitor.getProgress();
+  status.error = job.error;
+  return status;
+}
+
+} // namespace csci3081
@@ -0,0 +1,260 @@
+#include "compositor/AffineBlitter.h"
+#include "compositor/Blend.h"
+#include "compositor/LinearBlend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace csci3081 {
+
+namespace {
+
+const int SPAN_CHUNK = 64; // Pixels sampled per blend call
+
+/**
+ * @brief Narrow [xlo, xhi) to the x values where lo <= a + b*x < hi
+ */
+void clipRange(float a, float b, float lo, float hi, float& xlo, float& xhi) {
+  if (std::fabs(b) < 1e-8f) {
+    if (a < lo || a >= hi) {
+      xhi = xlo; // Empty
+    }
+    return;
+  }
+
+  float x1 = (lo - a) / b;
+  float x2 = (hi - a) / b;
+  if (b < 0) {
+    std::swap(x1, x2);
+  }
+  xlo = std::max(xlo, x1);
+  xhi = std::min(xhi, x2);
+}
+
+inline void bilinearPixel(const unsigned char* pixels, int width, int height,
+                          float u, float v, unsigned char* out) {
+  // Texel centers sit at +0.5
+  float fx = u - 0.5f;
+  float fy = v - 0.5f;
+  float flx = std::floor(fx);
+  float fly = std::floor(fy);
+  int wx = static_cast<int>((fx - flx) * 256.0f);
+  int wy = static_cast<int>((fy - fly) * 256.0f);
+  int x0 = static_cast<int>(flx);
+  int y0 = static_cast<int>(fly);
+  int x1 = x0 + 1;
+  int y1 = y0 + 1;
+
+  x0 = std::max(0, std::min(x0, width - 1));
+  x1 = std::max(0, std::min(x1, width - 1));
+  y0 = std::max(0, std::min(y0, height - 1));
+  y1 = std::max(0, std::min(y1, height - 1));
+
+  const unsigned char* p00 = pixels + (y0 * width + x0) * 4;
+  const unsigned char* p10 = pixels + (y0 * width + x1) * 4;
+  const unsigned char* p01 = pixels + (y1 * width + x0) * 4;
+  const unsigned char* p11 = pixels + (y1 * width + x1) * 4;
+
+#if defined(__SSE2__)
+  int t00, t10, t01, t11;
+  std::memcpy(&t00, p00, 4);
+  std::memcpy(&t10, p10, 4);
+  std::memcpy(&t01, p01, 4);
+  std::memcpy(&t11, p11, 4);
+
+  const __m128i zero = _mm_setzero_si128();
+  // 16-bit lanes: [left texel RGBA | right texel RGBA]
+  __m128i top = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, t10, t00), zero);
+  __m128i bottom = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, t11, t01), zero);
+
+  // Vertical lerp (weights sum to 256, products stay below 2^16)
+  __m128i column = _mm_add_epi16(
+      _mm_mullo_epi16(top, _mm_set1_epi16(static_cast<short>(256 - wy))),
+      _mm_mullo_epi16(bottom, _mm_set1_epi16(static_cast<short>(wy))));
+  column = _mm_srli_epi16(column, 8);
+
+  // Horizontal lerp: weight the left and right halves, then fold them
+  const short wl = static_cast<short>(256 - wx);
+  const short wr = static_cast<short>(wx);
+  __m128i weighted = _mm_mullo_epi16(
+      column, _mm_set_epi16(wr, wr, wr, wr, wl, wl, wl, wl));
+  __m128i sum = _mm_add_epi16(weighted, _mm_srli_si128(weighted, 8));
+  sum = _mm_srli_epi16(sum, 8);
+
+  int result = _mm_cvtsi128_si32(_mm_packus_epi16(sum, zero));
+  std::memcpy(out, &result, 4);
+#else
+  for (int c = 0; c < 4; c++) {
+    int left = (p00[c] * (256 - wy) + p01[c] * wy) >> 8;
+    int right = (p10[c] * (256 - wy) + p11[c] * wy) >> 8;
+    out[c] = static_cast<unsigned char>((left * (256 - wx) + right * wx) >> 8);
+  }
+#endif
+}
+
+} // namespace
+
+void AffineBlitter::sampleSpan(const Image& src, float u, float v, float du,
+                               float dv, unsigned char* out, int count) {
+  const unsigned char* pixels = src.getData();
+  int width = src.getWidth();
+  int height = src.getHeight();
+
+  for (int i = 0; i < count; i++) {
+    bilinearPixel(pixels, width, height, u + i * du, v + i * dv, out + i * 4);
+  }
+}
+
+namespace {
+
+/**
+ * @brief Blends 8-bit spans straight into an Image
+ */
+struct ImageSink {
+  unsigned char* pixels;
+  int opacity;
+  BlendMode mode;
+
+  void blend(size_t offset, const unsigned char* span, int count) {
+    blendSpan(pixels + offset * 4, span, count, opacity, mode);
+  }
+};
+
+/**
+ * @brief Converts spans to linear light and blends them into a LinearFrame
+ */
+struct LinearSink {
+  uint16_t* pixels;
+  int opacity;
+  BlendMode mode;
+
+  void blend(size_t offset, const unsigned char* span, int count) {
+    uint16_t linear[SPAN_CHUNK * 4];
+    for (int i = 0; i < count; i += SPAN_CHUNK) {
+      int chunk = std::min(SPAN_CHUNK, count - i);
+      srgbToLinearSpan(linear, span + i * 4, chunk);
+      blendLinearSpan(pixels + (offset + i) * 4, linear, chunk, opacity, mode);
+    }
+  }
+};
+
+int toOpacity(const EntryTransform& transform) {
+  float clampedOpacity = std::max(0.0f, std::min(transform.opacity, 1.0f));
+  return static_cast<int>(clampedOpacity * 255.0f + 0.5f);
+}
+
+/**
+ * @brief Walk the destination spans covered by a layer
+ *
+ * Samples the layer along each covered span and hands the pixels to
+ * sink.blend(offset, pixels, count), where offset is the index of the
+ * first destination pixel.
+ */
+template <typename Sink>
+void rasterize(const Image& src, int dstWidth, int dstHeight,
+               const EntryTransform& transform, Sink& sink) {
+  int srcWidth = src.getWidth();
+  int srcHeight = src.getHeight();
+  if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) {
+    return;
+  }
+
+  // Same size, full frame: no resampling needed
+  if (transform.fillsFrame() && srcWidth == dstWidth && srcHeight == dstHeight) {
+    sink.blend(0, src.getData(), dstWidth * dstHeight);
+    return;
+  }
+
+  // Layer size and center in destination pixels
+  float layerWidth = transform.scaleX * dstWidth;
+  float layerHeight = transform.scaleY * dstHeight;
+  if (std::fabs(layerWidth) < 1e-3f || std::fabs(layerHeight) < 1e-3f) {
+    return;
+  }
+  float centerX = transform.positionX * dstWidth;
+  float centerY = transform.positionY * dstHeight;
+
+  float radians = transform.rotation * 3.14159265358979f / 180.0f;
+  float c = std::cos(radians);
+  float s = std::sin(radians);
+
+  // Inverse mapping from destination pixel centers to source coordinates:
+  // u = (c*dx + s*dy) * srcWidth/layerWidth + srcWidth/2
+  // v = (-s*dx + c*dy) * srcHeight/layerHeight + srcHeight/2
+  float su = srcWidth / layerWidth;
+  float sv = srcHeight / layerHeight;
+  float dudx = c * su;
+  float dudy = s * su;
+  float dvdx = -s * sv;
+  float dvdy = c * sv;
+  float dx0 = 0.5f - centerX;
+  float dy0 = 0.5f - centerY;
+  float u00 = (c * dx0 + s * dy0) * su + srcWidth * 0.5f;
+  float v00 = (-s * dx0 + c * dy0) * sv + srcHeight * 0.5f;
+
+  // Destination bounding box of the rotated layer
+  float hw = layerWidth * 0.5f;
+  float hh = layerHeight * 0.5f;
+  float minY = centerY, maxY = centerY;
+  const float cornerX[4] = {-hw, hw, hw, -hw};
+  const float cornerY[4] = {-hh, -hh, hh, hh};
+  for (int i = 0; i < 4; i++) {
+    float y = centerY + s * cornerX[i] + c * cornerY[i];
+    minY = std::min(minY, y);
+    maxY = std::max(maxY, y);
+  }
+  int yStart = std::max(0, static_cast<int>(std::floor(minY)));
+  int yEnd = std::min(dstHeight, static_cast<int>(std::ceil(maxY)));
+
+  unsigned char span[SPAN_CHUNK * 4];
+
+  for (int y = yStart; y < yEnd; y++) {
+    float uRow = u00 + y * dudy;
+    float vRow = v00 + y * dvdy;
+
+    // Pixels of this row whose centers map inside the source
+    float xlo = 0.0f;
+    float xhi = static_cast<float>(dstWidth);
+    clipRange(uRow, dudx, 0.0f, static_cast<float>(srcWidth), xlo, xhi);
+    clipRange(vRow, dvdx, 0.0f, static_cast<float>(srcHeight), xlo, xhi);
+    int xStart = std::max(0, static_cast<int>(std::ceil(xlo)));
+    int xEnd = std::min(dstWidth, static_cast<int>(std::ceil(xhi)));
+
+    size_t row = static_cast<size_t>(y) * dstWidth;
+    for (int x = xStart; x < xEnd; x += SPAN_CHUNK) {
+      int count = std::min(SPAN_CHUNK, xEnd - x);
+      AffineBlitter::sampleSpan(src, uRow + x * dudx, vRow + x * dvdx, dudx, dvdx,
+                                span, count);
+      sink.blend(row + x, span, count);
+    }
+  }
+}
+
+} // namespace
+
+void AffineBlitter::blit(const Image& src, Image& dst,
+                         const EntryTransform& transform, BlendMode mode) {
+  int opacity = toOpacity(transform);
+  if (opacity == 0) {
+    return;
+  }
+  ImageSink sink = { dst.getData(), opacity, mode };
+  rasterize(src, dst.getWidth(), dst.getHeight(), transform, sink);
+}
+
+void AffineBlitter::blit(const Image& src, LinearFrame& dst,
+                         const EntryTransform& transform, BlendMode mode) {
+  int opacity = toOpacity(transform);
+  if (opacity == 0) {
+    return;
+  }
+  LinearSink sink = { dst.getData(), opacity, mode };
+  rasterize(src, dst.getWidth(), dst.getHeight(), transform, sink);
+}
+
+} // namespace csci3081
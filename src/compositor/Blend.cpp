@@ -0,0 +1,288 @@
+#include "compositor/Blend.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace csci3081 {
+
+namespace {
+
+// Exact rounding division by 255 for values in [0, 65025]
+inline int div255(int x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+// Blended color scaled by both alphas, sa * da * B(S, D), for one 8-bit
+// channel. s and d are premultiplied (S = s / sa, D = d / da), which lets
+// every mode be written without dividing by alpha.
+template <BlendMode Mode>
+inline int mixChannel(int s, int sa, int d, int da) {
+  return div255(s * da);   // NORMAL: B(S, D) = S
+}
+
+template <>
+inline int mixChannel<BlendMode::ADD>(int s, int sa, int d, int da) {
+  return std::min(div255(s * da) + div255(d * sa), div255(sa * da));
+}
+
+template <>
+inline int mixChannel<BlendMode::MULTIPLY>(int s, int sa, int d, int da) {
+  return div255(s * d);
+}
+
+template <>
+inline int mixChannel<BlendMode::SCREEN>(int s, int sa, int d, int da) {
+  return div255(s * da) + div255(d * sa) - div255(s * d);
+}
+
+template <>
+inline int mixChannel<BlendMode::OVERLAY>(int s, int sa, int d, int da) {
+  // 2 * div255() rather than div255(2 * ...) keeps the products in 16 bits
+  // so the vector path can match exactly
+  if (2 * d < da) {
+    return 2 * div255(s * d);
+  }
+  return div255(sa * da) - 2 * div255((sa - s) * (da - d));
+}
+
+template <>
+inline int mixChannel<BlendMode::DARKEN>(int s, int sa, int d, int da) {
+  return std::min(div255(s * da), div255(d * sa));
+}
+
+template <>
+inline int mixChannel<BlendMode::LIGHTEN>(int s, int sa, int d, int da) {
+  return std::max(div255(s * da), div255(d * sa));
+}
+
+inline unsigned char clampChannel(int value) {
+  return static_cast<unsigned char>(std::max(0, std::min(value, 255)));
+}
+
+template <BlendMode Mode>
+inline void blendPixel(unsigned char* d, const unsigned char* s, int opacity) {
+  int src[4] = {s[0], s[1], s[2], s[3]};
+  if (opacity != 255) {
+    for (int c = 0; c < 4; c++) {
+      src[c] = div255(src[c] * opacity);
+    }
+  }
+  int sa = src[3];
+  int da = d[3];
+
+  if (Mode == BlendMode::NORMAL) {
+    for (int c = 0; c < 4; c++) {
+      d[c] = clampChannel(src[c] + div255(d[c] * (255 - sa)));
+    }
+    return;
+  }
+
+  for (int c = 0; c < 3; c++) {
+    d[c] = clampChannel(div255(src[c] * (255 - da)) + div255(d[c] * (255 - sa)) +
+                        mixChannel<Mode>(src[c], sa, d[c], da));
+  }
+  d[3] = clampChannel(sa + div255(da * (255 - sa)));
+}
+
+#if defined(__SSE2__)
+inline __m128i div255(__m128i x) {
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+inline __m128i mul255(__m128i a, __m128i b) {
+  return div255(_mm_mullo_epi16(a, b));
+}
+
+// sa * da * B(S, D) on 16-bit lanes holding premultiplied 0-255 values
+template <BlendMode Mode>
+inline __m128i mixLanes(__m128i s, __m128i sa, __m128i d, __m128i da) {
+  return mul255(s, da);   // NORMAL
+}
+
+template <>
+inline __m128i mixLanes<BlendMode::ADD>(__m128i s, __m128i sa, __m128i d,
+                                        __m128i da) {
+  return _mm_min_epi16(_mm_add_epi16(mul255(s, da), mul255(d, sa)), mul255(sa, da));
+}
+
+template <>
+inline __m128i mixLanes<BlendMode::MULTIPLY>(__m128i s, __m128i sa, __m128i d,
+                                             __m128i da) {
+  return mul255(s, d);
+}
+
+template <>
+inline __m128i mixLanes<BlendMode::SCREEN>(__m128i s, __m128i sa, __m128i d,
+                                           __m128i da) {
+  return _mm_sub_epi16(_mm_add_epi16(mul255(s, da), mul255(d, sa)), mul255(s, d));
+}
+
+template <>
+inline __m128i mixLanes<BlendMode::OVERLAY>(__m128i s, __m128i sa, __m128i d,
+                                            __m128i da) {
+  __m128i low = _mm_slli_epi16(mul255(s, d), 1);
+  __m128i inverse = mul255(_mm_sub_epi16(sa, s), _mm_sub_epi16(da, d));
+  __m128i high = _mm_sub_epi16(mul255(sa, da), _mm_slli_epi16(inverse, 1));
+  __m128i dark = _mm_cmplt_epi16(_mm_slli_epi16(d, 1), da);
+  return _mm_or_si128(_mm_and_si128(dark, low), _mm_andnot_si128(dark, high));
+}
+
+template <>
+inline __m128i mixLanes<BlendMode::DARKEN>(__m128i s, __m128i sa, __m128i d,
+                                           __m128i da) {
+  return _mm_min_epi16(mul255(s, da), mul255(d, sa));
+}
+
+template <>
+inline __m128i mixLanes<BlendMode::LIGHTEN>(__m128i s, __m128i sa, __m128i d,
+                                            __m128i da) {
+  return _mm_max_epi16(mul255(s, da), mul255(d, sa));
+}
+
+inline __m128i broadcastAlpha(__m128i x) {
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xFF), 0xFF);
+}
+
+// Blend two pixels held as 16-bit lanes (RGBA RGBA)
+template <BlendMode Mode>
+inline __m128i blend2(__m128i s, __m128i d, __m128i opacity, bool scale) {
+  const __m128i full = _mm_set1_epi16(255);
+  if (scale) {
+    s = mul255(s, opacity);
+  }
+  __m128i sa = broadcastAlpha(s);
+
+  // "Over" on all four channels: s + d * (1 - sa)
+  __m128i below = mul255(d, _mm_sub_epi16(full, sa));
+  __m128i over = _mm_add_epi16(s, below);
+  if (Mode == BlendMode::NORMAL) {
+    return over;
+  }
+
+  // Other modes replace the color channels; alpha stays "over"
+  const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+  __m128i da = broadcastAlpha(d);
+  __m128i color = _mm_add_epi16(_mm_add_epi16(mul255(s, _mm_sub_epi16(full, da)), below),
+                                mixLanes<Mode>(s, sa, d, da));
+  return _mm_or_si128(_mm_and_si128(alphaLanes, over),
+                      _mm_andnot_si128(alphaLanes, color));
+}
+#endif
+
+template <BlendMode Mode>
+void blendSpanMode(unsigned char* dst, const unsigned char* src, int count,
+                   int opacity) {
+  int i = 0;
+
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i opacityVec = _mm_set1_epi16(static_cast<short>(opacity));
+  const bool scale = opacity != 255;
+
+  for (; i + 4 <= count; i += 4) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+
+    __m128i lo = blend2<Mode>(_mm_unpacklo_epi8(s, zero),
+                              _mm_unpacklo_epi8(d, zero), opacityVec, scale);
+    __m128i hi = blend2<Mode>(_mm_unpackhi_epi8(s, zero),
+                              _mm_unpackhi_epi8(d, zero), opacityVec, scale);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4),
+                     _mm_packus_epi16(lo, hi));
+  }
+#endif
+
+  for (; i < count; i++) {
+    blendPixel<Mode>(dst + i * 4, src + i * 4, opacity);
+  }
+}
+
+} // namespace
+
+const char* blendModeName(BlendMode mode) {
+  switch (mode) {
+    case BlendMode::NORMAL: return "Normal";
+    case BlendMode::ADD: return "Add";
+    case BlendMode::MULTIPLY: return "Multiply";
+    case BlendMode::SCREEN: return "Screen";
+    case BlendMode::OVERLAY: return "Overlay";
+    case BlendMode::DARKEN: return "Darken";
+    case BlendMode::LIGHTEN: return "Lighten";
+  }
+  return "Normal";
+}
+
+void blendSpan(unsigned char* dst, const unsigned char* src, int count,
+               int opacity, BlendMode mode) {
+  switch (mode) {
+    case BlendMode::NORMAL:
+      blendSpanMode<BlendMode::NORMAL>(dst, src, count, opacity);
+      break;
+    case BlendMode::ADD:
+      blendSpanMode<BlendMode::ADD>(dst, src, count, opacity);
+      break;
+    case BlendMode::MULTIPLY:
+      blendSpanMode<BlendMode::MULTIPLY>(dst, src, count, opacity);
+      break;
+    case BlendMode::SCREEN:
+      blendSpanMode<BlendMode::SCREEN>(dst, src, count, opacity);
+      break;
+    case BlendMode::OVERLAY:
+      blendSpanMode<BlendMode::OVERLAY>(dst, src, count, opacity);
+      break;
+    case BlendMode::DARKEN:
+      blendSpanMode<BlendMode::DARKEN>(dst, src, count, opacity);
+      break;
+    case BlendMode::LIGHTEN:
+      blendSpanMode<BlendMode::LIGHTEN>(dst, src, count, opacity);
+      break;
+  }
+}
+
+void blendSpanOver(unsigned char* dst, const unsigned char* src, int count,
+                   int opacity) {
+  blendSpanMode<BlendMode::NORMAL>(dst, src, count, opacity);
+}
+
+void premultiplySpan(unsigned char* pixels, int count) {
+  for (int i = 0; i < count * 4; i += 4) {
+    int a = pixels[i + 3];
+    if (a == 255) {
+      continue;
+    }
+    pixels[i] = static_cast<unsigned char>(div255(pixels[i] * a));
+    pixels[i + 1] = static_cast<unsigned char>(div255(pixels[i + 1] * a));
+    pixels[i + 2] = static_cast<unsigned char>(div255(pixels[i + 2] * a));
+  }
+}
+
+void unpremultiplySpan(unsigned char* dst, const unsigned char* src, int count) {
+  for (int i = 0; i < count * 4; i += 4) {
+    int a = src[i + 3];
+    dst[i + 3] = static_cast<unsigned char>(a);
+    if (a == 255 || a == 0) {
+      dst[i] = src[i];
+      dst[i + 1] = src[i + 1];
+      dst[i + 2] = src[i + 2];
+      continue;
+    }
+    for (int c = 0; c < 3; c++) {
+      dst[i + c] = static_cast<unsigned char>(
+          std::min(255, (src[i + c] * 255 + a / 2) / a));
+    }
+  }
+}
+
+Color premultiplyColor(const Color& color) {
+  int a = color.alpha();
+  return Color(div255(color.red() * a), div255(color.green() * a),
+               div255(color.blue() * a), a);
+}
+
+} // namespace csci3081
@@ -0,0 +1,392 @@
+#include "compositor/LinearBlend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace csci3081 {
+
+namespace {
+
+const int SRGB_TABLE_BITS = 12;
+const int SRGB_TABLE_SHIFT = 16 - SRGB_TABLE_BITS;
+
+/**
+ * @brief Lookup tables between sRGB-encoded and linear values
+ */
+struct TransferTables {
+  uint16_t toLinear[256];
+  unsigned char toSrgb[1 << SRGB_TABLE_BITS];
+
+  TransferTables() {
+    for (int i = 0; i < 256; i++) {
+      double c = i / 255.0;
+      double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+      toLinear[i] = static_cast<uint16_t>(std::floor(linear * 65535.0 + 0.5));
+    }
+
+    for (int i = 0; i < (1 << SRGB_TABLE_BITS); i++) {
+      // Encode the middle of the range of linear values sharing this entry
+      double linear = ((i << SRGB_TABLE_SHIFT) + (1 << SRGB_TABLE_SHIFT) / 2) / 65535.0;
+      linear = std::min(linear, 1.0);
+      double c = linear <= 0.0031308 ? linear * 12.92
+                                     : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+      toSrgb[i] = static_cast<unsigned char>(std::floor(c * 255.0 + 0.5));
+    }
+
+    // Every 8-bit value lands in an entry of its own, so it can be made to
+    // round trip exactly
+    for (int i = 0; i < 256; i++) {
+      toSrgb[toLinear[i] >> SRGB_TABLE_SHIFT] = static_cast<unsigned char>(i);
+    }
+  }
+};
+
+const TransferTables& tables() {
+  static const TransferTables instance;
+  return instance;
+}
+
+const float INV_FULL = 1.0f / 65535.0f;
+
+// sa * da * B(S, D) for one premultiplied channel on the 0-65535 scale,
+// as in compositor/Blend
+template <BlendMode Mode>
+inline float mixLinear(float s, float sa, float d, float da) {
+  return s * da * INV_FULL;   // NORMAL: B(S, D) = S
+}
+
+template <>
+inline float mixLinear<BlendMode::ADD>(float s, float sa, float d, float da) {
+  return std::min((s * da + d * sa) * INV_FULL, sa * da * INV_FULL);
+}
+
+template <>
+inline float mixLinear<BlendMode::MULTIPLY>(float s, float sa, float d, float da) {
+  return s * d * INV_FULL;
+}
+
+template <>
+inline float mixLinear<BlendMode::SCREEN>(float s, float sa, float d, float da) {
+  return (s * da + d * sa - s * d) * INV_FULL;
+}
+
+template <>
+inline float mixLinear<BlendMode::OVERLAY>(float s, float sa, float d, float da) {
+  if (2.0f * d < da) {
+    return 2.0f * s * d * INV_FULL;
+  }
+  return (sa * da - 2.0f * (sa - s) * (da - d)) * INV_FULL;
+}
+
+template <>
+inline float mixLinear<BlendMode::DARKEN>(float s, float sa, float d, float da) {
+  return std::min(s * da, d * sa) * INV_FULL;
+}
+
+template <>
+inline float mixLinear<BlendMode::LIGHTEN>(float s, float sa, float d, float da) {
+  return std::max(s * da, d * sa) * INV_FULL;
+}
+
+inline uint16_t toChannel(float value) {
+  long rounded = std::lrint(value);
+  return static_cast<uint16_t>(std::max(0L, std::min(rounded, 65535L)));
+}
+
+template <BlendMode Mode>
+inline void blendLinearPixel(uint16_t* d, const uint16_t* s, float scale) {
+  float src[4] = {s[0] * scale, s[1] * scale, s[2] * scale, s[3] * scale};
+  float dst[4] = {static_cast<float>(d[0]), static_cast<float>(d[1]),
+                  static_cast<float>(d[2]), static_cast<float>(d[3])};
+  float ia = 1.0f - src[3] * INV_FULL;
+
+  if (Mode == BlendMode::NORMAL) {
+    for (int c = 0; c < 4; c++) {
+      d[c] = toChannel(src[c] + dst[c] * ia);
+    }
+    return;
+  }
+
+  float ida = 1.0f - dst[3] * INV_FULL;
+  for (int c = 0; c < 3; c++) {
+    d[c] = toChannel(src[c] * ida + dst[c] * ia +
+                     mixLinear<Mode>(src[c], src[3], dst[c], dst[3]));
+  }
+  d[3] = toChannel(src[3] + dst[3] * ia);
+}
+
+#if defined(__SSE2__)
+// sa * da * B(S, D) on float lanes holding premultiplied 0-65535 values
+template <BlendMode Mode>
+inline __m128 mixLanes(__m128 s, __m128 sa, __m128 d, __m128 da) {
+  return _mm_mul_ps(_mm_mul_ps(s, da), _mm_set1_ps(INV_FULL));   // NORMAL
+}
+
+template <>
+inline __m128 mixLanes<BlendMode::ADD>(__m128 s, __m128 sa, __m128 d, __m128 da) {
+  const __m128 inv = _mm_set1_ps(INV_FULL);
+  return _mm_min_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(s, da), _mm_mul_ps(d, sa)), inv),
+                    _mm_mul_ps(_mm_mul_ps(sa, da), inv));
+}
+
+template <>
+inline __m128 mixLanes<BlendMode::MULTIPLY>(__m128 s, __m128 sa, __m128 d, __m128 da) {
+  return _mm_mul_ps(_mm_mul_ps(s, d), _mm_set1_ps(INV_FULL));
+}
+
+template <>
+inline __m128 mixLanes<BlendMode::SCREEN>(__m128 s, __m128 sa, __m128 d, __m128 da) {
+  __m128 sum = _mm_add_ps(_mm_mul_ps(s, da), _mm_mul_ps(d, sa));
+  return _mm_mul_ps(_mm_sub_ps(sum, _mm_mul_ps(s, d)), _mm_set1_ps(INV_FULL));
+}
+
+template <>
+inline __m128 mixLanes<BlendMode::OVERLAY>(__m128 s, __m128 sa, __m128 d, __m128 da) {
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 inv = _mm_set1_ps(INV_FULL);
+  __m128 low = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(two, s), d), inv);
+  __m128 inverse = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(sa, s)), _mm_sub_ps(da, d));
+  __m128 high = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sa, da), inverse), inv);
+  __m128 dark = _mm_cmplt_ps(_mm_mul_ps(two, d), da);
+  return _mm_or_ps(_mm_and_ps(dark, low), _mm_andnot_ps(dark, high));
+}
+
+template <>
+inline __m128 mixLanes<BlendMode::DARKEN>(__m128 s, __m128 sa, __m128 d, __m128 da) {
+  return _mm_mul_ps(_mm_min_ps(_mm_mul_ps(s, da), _mm_mul_ps(d, sa)),
+                    _mm_set1_ps(INV_FULL));
+}
+
+template <>
+inline __m128 mixLanes<BlendMode::LIGHTEN>(__m128 s, __m128 sa, __m128 d, __m128 da) {
+  return _mm_mul_ps(_mm_max_ps(_mm_mul_ps(s, da), _mm_mul_ps(d, sa)),
+                    _mm_set1_ps(INV_FULL));
+}
+
+// Load one pixel into float lanes
+inline __m128 loadPixel(const uint16_t* p) {
+  __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, _mm_setzero_si128()));
+}
+
+// Round float lanes to 0-65535 and store them as one pixel
+inline void storePixel(uint16_t* p, __m128 value) {
+  // packs_epi32 saturates to signed 16 bits, so pack around zero
+  __m128i rounded = _mm_sub_epi32(_mm_cvtps_epi32(value), _mm_set1_epi32(32768));
+  __m128i packed = _mm_xor_si128(_mm_packs_epi32(rounded, rounded),
+                                 _mm_set1_epi16(static_cast<short>(0x8000)));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(p), packed);
+}
+
+inline __m128 broadcastAlpha(__m128 x) {
+  return _mm_shuffle_ps(x, x, 0xFF);
+}
+#endif
+
+template <BlendMode Mode>
+void blendLinearSpanMode(uint16_t* dst, const uint16_t* src, int count,
+                         int opacity) {
+  const float scale = opacity / 255.0f;
+  int i = 0;
+
+#if defined(__SSE2__)
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 inv = _mm_set1_ps(INV_FULL);
+  const __m128 scaleVec = _mm_set1_ps(scale);
+  const __m128 alphaMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+  for (; i < count; i++) {
+    __m128 s = _mm_mul_ps(loadPixel(src + i * 4), scaleVec);
+    __m128 d = loadPixel(dst + i * 4);
+    __m128 sa = broadcastAlpha(s);
+    __m128 ia = _mm_sub_ps(one, _mm_mul_ps(sa, inv));
+
+    // "Over" on all four channels: s + d * (1 - sa)
+    __m128 below = _mm_mul_ps(d, ia);
+    __m128 over = _mm_add_ps(s, below);
+    if (Mode == BlendMode::NORMAL) {
+      storePixel(dst + i * 4, over);
+      continue;
+    }
+
+    // Other modes replace the color channels; alpha stays "over"
+    __m128 da = broadcastAlpha(d);
+    __m128 ida = _mm_sub_ps(one, _mm_mul_ps(da, inv));
+    __m128 color = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s, ida), below),
+                              mixLanes<Mode>(s, sa, d, da));
+    storePixel(dst + i * 4, _mm_or_ps(_mm_and_ps(alphaMask, over),
+                                      _mm_andnot_ps(alphaMask, color)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    blendLinearPixel<Mode>(dst + i * 4, src + i * 4, scale);
+  }
+}
+
+// Interpolate 16-bit values; weight is 0-65536
+inline uint16_t lerpLinear(uint32_t a, uint32_t b, uint32_t weight) {
+  return static_cast<uint16_t>((a * (65536 - weight) + b * weight + 32768) >> 16);
+}
+
+inline uint32_t toLinearWeight(double t) {
+  return static_cast<uint32_t>(std::max(0.0, std::min(std::floor(t * 65536.0 + 0.5),
+                                                      65536.0)));
+}
+
+void lerpLinearSpan(uint16_t* dst, const uint16_t* from, const uint16_t* to,
+                    size_t values, uint32_t weight) {
+  for (size_t i = 0; i < values; i++) {
+    dst[i] = lerpLinear(from[i], to[i], weight);
+  }
+}
+
+void lerpLinearSpanToColor(uint16_t* dst, const uint16_t* from,
+                           const uint16_t* color, size_t values, uint32_t weight) {
+  for (size_t i = 0; i < values; i++) {
+    dst[i] = lerpLinear(from[i], color[i & 3], weight);
+  }
+}
+
+} // namespace
+
+uint16_t srgbToLinear(int value) {
+  return tables().toLinear[std::max(0, std::min(value, 255))];
+}
+
+void srgbToLinearSpan(uint16_t* dst, const unsigned char* src, int count) {
+  const uint16_t* toLinear = tables().toLinear;
+  for (int i = 0; i < count * 4; i += 4) {
+    int a = src[i + 3];
+    dst[i + 3] = static_cast<uint16_t>(a * 257);
+    if (a == 255) {
+      dst[i] = toLinear[src[i]];
+      dst[i + 1] = toLinear[src[i + 1]];
+      dst[i + 2] = toLinear[src[i + 2]];
+      continue;
+    }
+
+    // The transfer curve applies to the straight color
+    float inverse = a ? 255.0f / a : 0.0f;
+    for (int c = 0; c < 3; c++) {
+      int straight = std::min(255, static_cast<int>(src[i + c] * inverse + 0.5f));
+      dst[i + c] = static_cast<uint16_t>((toLinear[straight] * a + 127) / 255);
+    }
+  }
+}
+
+void linearToSrgbSpan(unsigned char* dst, const uint16_t* src, int count) {
+  const unsigned char* toSrgb = tables().toSrgb;
+  for (int i = 0; i < count * 4; i += 4) {
+    uint32_t a = src[i + 3];
+    if (a == 65535) {
+      dst[i] = toSrgb[src[i] >> SRGB_TABLE_SHIFT];
+      dst[i + 1] = toSrgb[src[i + 1] >> SRGB_TABLE_SHIFT];
+      dst[i + 2] = toSrgb[src[i + 2] >> SRGB_TABLE_SHIFT];
+      dst[i + 3] = 255;
+      continue;
+    }
+
+    uint32_t a8 = (a * 255 + 32768) >> 16;
+    dst[i + 3] = static_cast<unsigned char>(a8);
+    float inverse = a ? 65535.0f / a : 0.0f;
+    for (int c = 0; c < 3; c++) {
+      uint32_t straight = std::min<uint32_t>(
+          65535, static_cast<uint32_t>(src[i + c] * inverse + 0.5f));
+      dst[i + c] = static_cast<unsigned char>(
+          (toSrgb[straight >> SRGB_TABLE_SHIFT] * a8 + 127) / 255);
+    }
+  }
+}
+
+void colorToLinear(const Color& color, uint16_t* rgba) {
+  uint32_t a = color.alpha() * 257;
+  rgba[0] = static_cast<uint16_t>((srgbToLinear(color.red()) * a + 32767) / 65535);
+  rgba[1] = static_cast<uint16_t>((srgbToLinear(color.green()) * a + 32767) / 65535);
+  rgba[2] = static_cast<uint16_t>((srgbToLinear(color.blue()) * a + 32767) / 65535);
+  rgba[3] = static_cast<uint16_t>(a);
+}
+
+void blendLinearSpan(uint16_t* dst, const uint16_t* src, int count, int opacity,
+                     BlendMode mode) {
+  switch (mode) {
+    case BlendMode::NORMAL:
+      blendLinearSpanMode<BlendMode::NORMAL>(dst, src, count, opacity);
+      break;
+    case BlendMode::ADD:
+      blendLinearSpanMode<BlendMode::ADD>(dst, src, count, opacity);
+      break;
+    case BlendMode::MULTIPLY:
+      blendLinearSpanMode<BlendMode::MULTIPLY>(dst, src, count, opacity);
+      break;
+    case BlendMode::SCREEN:
+      blendLinearSpanMode<BlendMode::SCREEN>(dst, src, count, opacity);
+      break;
+    case BlendMode::OVERLAY:
+      blendLinearSpanMode<BlendMode::OVERLAY>(dst, src, count, opacity);
+      break;
+    case BlendMode::DARKEN:
+      blendLinearSpanMode<BlendMode::DARKEN>(dst, src, count, opacity);
+      break;
+    case BlendMode::LIGHTEN:
+      blendLinearSpanMode<BlendMode::LIGHTEN>(dst, src, count, opacity);
+      break;
+  }
+}
+
+void applyLinearTransition(const LinearFrame& from, const LinearFrame& to,
+                           LinearFrame& dst, const Transition& transition,
+                           double progress) {
+  int width = dst.getWidth();
+  int height = dst.getHeight();
+  size_t values = static_cast<size_t>(width) * height * 4;
+  progress = std::max(0.0, std::min(progress, 1.0));
+
+  switch (transition.type) {
+    case TransitionType::CROSSFADE:
+      lerpLinearSpan(dst.getData(), from.getData(), to.getData(), values,
+                     toLinearWeight(progress));
+      break;
+
+    case TransitionType::WIPE: {
+      // Same edge as applyTransition()
+      int edge = static_cast<int>(std::ceil(progress * width - 0.5));
+      edge = std::max(0, std::min(edge, width));
+      size_t rowValues = static_cast<size_t>(width) * 4;
+      size_t edgeValues = static_cast<size_t>(edge) * 4;
+      for (int y = 0; y < height; y++) {
+        size_t row = y * rowValues;
+        if (dst.getData() != to.getData()) {
+          std::memmove(dst.getData() + row, to.getData() + row,
+                       edgeValues * sizeof(uint16_t));
+        }
+        if (dst.getData() != from.getData()) {
+          std::memmove(dst.getData() + row + edgeValues,
+                       from.getData() + row + edgeValues,
+                       (rowValues - edgeValues) * sizeof(uint16_t));
+        }
+      }
+      break;
+    }
+
+    case TransitionType::DIP_TO_COLOR: {
+      uint16_t rgba[4];
+      colorToLinear(transition.color, rgba);
+      if (progress < 0.5) {
+        lerpLinearSpanToColor(dst.getData(), from.getData(), rgba, values,
+                              toLinearWeight(progress * 2.0));
+      } else {
+        lerpLinearSpanToColor(dst.getData(), to.getData(), rgba, values,
+                              toLinearWeight(2.0 - progress * 2.0));
+      }
+      break;
+    }
+  }
+}
+
+} // namespace csci3081
@@ -0,0 +1,33 @@
+#include "compositor/LinearFrame.h"
+#include "compositor/LinearBlend.h"
+
+#include <cstring>
+
+namespace csci3081 {
+
+LinearFrame::LinearFrame(int width, int height) : width(0), height(0) {
+  resize(width, height);
+}
+
+void LinearFrame::resize(int newWidth, int newHeight) {
+  if (newWidth == width && newHeight == height) {
+    return;
+  }
+  width = newWidth;
+  height = newHeight;
+  pixels.resize(static_cast<size_t>(width) * height * 4);
+}
+
+void LinearFrame::fill(const Color& color) {
+  uint16_t rgba[4];
+  colorToLinear(color, rgba);
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    std::memcpy(&pixels[i], rgba, sizeof(rgba));
+  }
+}
+
+void LinearFrame::toImage(Image& image) const {
+  linearToSrgbSpan(image.getData(), pixels.data(), width * height);
+}
+
+} // namespace csci3081
@@ -0,0 +1,198 @@
+#include "compositor/RenderGraph.h"
+#include "util/ThreadPool.h"
+#include <algorithm>
+#include <iostream>
+
+namespace csci3081 {
+
+RenderGraph::RenderGraph()
+  : output(nullptr), threadPool(&ThreadPool::shared()), orderValid(false),
+    processedCount(0), levelCount(0), width(0), height(0),
+    currentLevel(nullptr) {
+}
+
+RenderGraph::~RenderGraph() {
+  clear();
+}
+
+void RenderGraph::setOutput(RenderNode* node) {
+  output = node;
+  orderValid = false;
+}
+
+void RenderGraph::clear() {
+  for (RenderNode* node : nodes) {
+    delete node;
+  }
+  nodes.clear();
+  order.clear();
+  output = nullptr;
+  orderValid = false;
+}
+
+void RenderGraph::buildOrder() {
+  // Depth-first post-order from every node puts inputs before readers
+  order.clear();
+  order.reserve(nodes.size());
+  std::vector<std::pair<RenderNode*, size_t> > stack;
+  for (RenderNode* node : nodes) {
+    node->consumers = 0;
+    node->needed = false;   // Reused as the "visited" mark while sorting
+    node->cached = false;
+    node->donated = false;
+    node->pinned = false;
+  }
+
+  for (RenderNode* root : nodes) {
+    if (root->needed) {
+      continue;
+    }
+    root->needed = true;
+    stack.push_back(std::make_pair(root, static_cast<size_t>(0)));
+    while (!stack.empty()) {
+      RenderNode* node = stack.back().first;
+      size_t next = stack.back().second;
+      if (next < node->inputs.size()) {
+        stack.back().second++;
+        RenderNode* input = node->inputs[next];
+        input->consumers++;
+        if (!input->needed) {
+          input->needed = true;
+          stack.push_back(std::make_pair(input, static_cast<size_t>(0)));
+        }
+      } else {
+        order.push_back(node);
+        stack.pop_back();
+      }
+    }
+  }
+
+  if (output) {
+    output->consumers++;  // Read by the caller of evaluate()
+  }
+  orderValid = true;
+}
+
+void RenderGraph::processNode(RenderNode* node, int width, int height) {
+  node->process(width, height);
+  node->cachedKey = node->key;
+  node->cached = true;
+  node->donated = false;
+  node->processed = true;
+}
+
+void RenderGraph::processTask(void* context, int index) {
+  RenderGraph* graph = static_cast<RenderGraph*>(context);
+  processNode((*graph->currentLevel)[index], graph->width, graph->height);
+}
+
+const Image& RenderGraph::evaluate(double time, int frameWidth, int frameHeight) {
+  if (!output) {
+    std::cerr << "RenderGraph has no output node" << std::endl;
+    static Image empty;
+    return empty;
+  }
+  if (!orderValid) {
+    buildOrder();
+  }
+  width = frameWidth;
+  height = frameHeight;
+
+  // 1. Pull from the output: read parameters, mark the inputs in use
+  for (RenderNode* node : order) {
+    node->needed = false;
+    node->required = false;
+    node->processed = false;
+  }
+  output->needed = true;
+  for (size_t i = order.size(); i-- > 0;) {
+    RenderNode* node = order[i];
+    if (!node->needed) {
+      continue;
+    }
+    node->key = node->prepare(time, width, height);
+    for (size_t j = 0; j < node->inputs.size(); j++) {
+      if (node->needsInput(j)) {
+        node->inputs[j]->needed = true;
+      }
+    }
+  }
+
+  // 2. Keys: parameters, frame size and the keys of the inputs in use
+  for (RenderNode* node : order) {
+    if (!node->needed) {
+      continue;
+    }
+    uint64_t key = hashCombine(node->key, static_cast<uint64_t>(width) << 32 |
+                                          static_cast<uint32_t>(height));
+    for (size_t j = 0; j < node->inputs.size(); j++) {
+      if (node->needsInput(j)) {
+        key = hashCombine(key, node->inputs[j]->key);
+      }
+    }
+    node->key = key;
+  }
+
+  // 3. Out of date nodes, looking only below nodes that will be processed
+  output->required = !output->cached || output->cachedKey != output->key;
+  for (size_t i = order.size(); i-- > 0;) {
+    RenderNode* node = order[i];
+    if (!node->required) {
+      continue;
+    }
+    for (size_t j = 0; j < node->inputs.size(); j++) {
+      RenderNode* input = node->inputs[j];
+      if (!node->needsInput(j) || (input->cached && input->cachedKey == input->key)) {
+        continue;
+      }
+      // Given away although it did not change: keep it from now on
+      if (input->donated && input->cachedKey == input->key) {
+        input->pinned = true;
+      }
+      input->required = true;
+    }
+  }
+
+  // 4. Levels: a node runs one level after its latest required input
+  for (size_t i = 0; i < levels.size(); i++) {
+    levels[i].clear();
+  }
+  levelCount = 0;
+  processedCount = 0;
+  for (RenderNode* node : order) {
+    if (!node->required) {
+      continue;
+    }
+    int level = 0;
+    for (size_t j = 0; j < node->inputs.size(); j++) {
+      RenderNode* input = node->inputs[j];
+      if (input->required && node->needsInput(j)) {
+        level = std::max(level, input->level + 1);
+      }
+    }
+    node->level = level;
+    if (levels.size() <= static_cast<size_t>(level)) {
+      levels.resize(level + 1);
+    }
+    levels[level].push_back(node);
+    levelCount = std::max(levelCount, static_cast<size_t>(level + 1));
+    processedCount++;
+  }
+
+  // 5. Process each level, independent nodes in parallel
+  for (size_t i = 0; i < levelCount; i++) {
+    const std::vector<RenderNode*>& level = levels[i];
+    if (level.size() == 1 || !threadPool) {
+      for (RenderNode* node : level) {
+        processNode(node, width, height);
+      }
+    } else {
+      currentLevel = &level;
+      threadPool->parallelFor(static_cast<int>(level.size()), processTask, this);
+    }
+  }
+
+  return output->getResult();
+}
+
+} // namespace csci3081
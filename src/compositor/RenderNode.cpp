@@ -0,0 +1,37 @@
+#include "compositor/RenderNode.h"
+
+namespace csci3081 {
+
+RenderNode::RenderNode()
+  : result(&buffer), key(0), cachedKey(0), cached(false), needed(false),
+    required(false), processed(false), donated(false), pinned(false), level(0),
+    consumers(0) {
+}
+
+Image& RenderNode::ownResult(int width, int height) {
+  if (buffer.getWidth() != width || buffer.getHeight() != height) {
+    Image resized(width, height);
+    buffer.swap(resized);
+  }
+  result = &buffer;
+  return buffer;
+}
+
+bool RenderNode::takeInput(size_t index) {
+  RenderNode* source = inputs[index];
+  if (!source->processed || source->pinned || source->consumers != 1 ||
+      source->result != &source->buffer) {
+    return false;
+  }
+
+  buffer.swap(source->buffer);
+  result = &buffer;
+
+  // The input's buffer now holds whatever this node had before
+  source->result = &source->buffer;
+  source->cached = false;
+  source->donated = true;
+  return true;
+}
+
+} // namespace csci3081
@@ -0,0 +1,364 @@
+#include "compositor/RenderNodes.h"
+#include "compositor/AffineBlitter.h"
+#include "compositor/LinearBlend.h"
+#include "compositor/TransitionBlend.h"
+#include "assets/IAsset.h"
+#include <algorithm>
+#include <cstring>
+
+namespace csci3081 {
+
+namespace {
+
+uint64_t hashTransform(uint64_t seed, const EntryTransform& transform) {
+  seed = hashCombine(seed, transform.positionX);
+  seed = hashCombine(seed, transform.positionY);
+  seed = hashCombine(seed, transform.scaleX);
+  seed = hashCombine(seed, transform.scaleY);
+  seed = hashCombine(seed, transform.rotation);
+  return hashCombine(seed, transform.opacity);
+}
+
+uint64_t hashColor(uint64_t seed, const Color& color) {
+  uint64_t packed = static_cast<uint64_t>(color.red()) |
+                    static_cast<uint64_t>(color.green()) << 8 |
+                    static_cast<uint64_t>(color.blue()) << 16 |
+                    static_cast<uint64_t>(color.alpha()) << 24;
+  return hashCombine(seed, packed);
+}
+
+/**
+ * @brief Find where a time falls in the transition after an entry
+ *
+ * Same window as Track::getTransitionAt(), centered on the cut.
+ *
+ * @return true if the transition is running at time
+ */
+bool transitionAt(const TimelineEntry* from, const TimelineEntry* to, double time,
+                  Transition& transition, double& progress) {
+  transition = from->getOutTransition();
+  double start = to->getStartTime() - transition.duration / 2.0;
+  if (!from->hasOutTransition() || time < start ||
+      time >= start + transition.duration) {
+    return false;
+  }
+  progress = (time - start) / transition.duration;
+  return true;
+}
+
+uint64_t hashTransition(uint64_t seed, const Transition& transition,
+                        double progress) {
+  seed = hashCombine(seed, static_cast<uint64_t>(transition.type));
+  seed = hashCombine(seed, progress);
+  return hashColor(seed, transition.color);
+}
+
+// Start a blend or transition output from a copy of the frame below
+void copyBelow(const Image& below, Image& out) {
+  std::memcpy(out.getData(), below.getData(),
+              static_cast<size_t>(out.getWidth()) * out.getHeight() * 4);
+}
+
+} // namespace
+
+// ==============================================================================
+// BackgroundNode
+// ==============================================================================
+
+BackgroundNode::BackgroundNode(const Color& color) : color(color) {
+}
+
+uint64_t BackgroundNode::prepare(double time, int width, int height) {
+  return hashColor(0, color);
+}
+
+void BackgroundNode::process(int width, int height) {
+  ownResult(width, height).fill(premultiplyColor(color));
+}
+
+// ==============================================================================
+// SourceNode
+// ==============================================================================
+
+SourceNode::SourceNode(const TimelineEntry* entry, SourceNode* previousUse)
+  : entry(entry), localTime(0.0), copyFrames(false) {
+  if (previousUse) {
+    // Decode after the earlier user of the asset, and keep our own copy
+    addInput(previousUse);
+    previousUse->copyFrames = true;
+    copyFrames = true;
+  }
+}
+
+uint64_t SourceNode::prepare(double time, int width, int height) {
+  localTime = entry->getLocalTime(time);
+  // Only videos change over time
+  return hashCombine(0, entry->getAsset()->isVideo() ? localTime : 0.0);
+}
+
+void SourceNode::process(int width, int height) {
+  const Image& frame = entry->getAsset()->getFrame(localTime);
+  if (!copyFrames) {
+    setResult(frame);
+    return;
+  }
+
+  Image& copy = ownResult(frame.getWidth(), frame.getHeight());
+  std::memcpy(copy.getData(), frame.getData(),
+              static_cast<size_t>(frame.getWidth()) * frame.getHeight() * 4);
+}
+
+// ==============================================================================
+// FilterNode
+// ==============================================================================
+
+FilterNode::FilterNode(RenderNode* input, const std::shared_ptr<IFilter>& filter)
+  : filter(filter) {
+  addInput(input);
+}
+
+uint64_t FilterNode::prepare(double time, int width, int height) {
+  // The output only depends on the input
+  return 0;
+}
+
+void FilterNode::process(int width, int height) {
+  const Image& source = input(0);
+  filter->Apply(source, ownResult(source.getWidth(), source.getHeight()));
+}
+
+// ==============================================================================
+// TransformNode
+// ==============================================================================
+
+TransformNode::TransformNode(RenderNode* input, const TimelineEntry* entry)
+  : entry(entry) {
+  addInput(input);
+}
+
+TransformNode::TransformNode(RenderNode* input, const EntryTransform& transform)
+  : entry(nullptr), transform(transform) {
+  addInput(input);
+}
+
+EntryTransform TransformNode::transformAt(double time) const {
+  return entry ? entry->evaluateTransformAt(time) : transform;
+}
+
+uint64_t TransformNode::prepare(double time, int width, int height) {
+  if (entry) {
+    transform = entry->evaluateTransformAt(time);
+  }
+  return hashTransform(0, transform);
+}
+
+void TransformNode::process(int width, int height) {
+  Image& out = ownResult(width, height);
+  out.fill(Color(0, 0, 0, 0));
+  AffineBlitter::blit(input(0), out, transform);
+}
+
+// ==============================================================================
+// BlendNode
+// ==============================================================================
+
+BlendNode::BlendNode(RenderNode* below, RenderNode* layer, BlendMode mode)
+  : placement(layer->asTransform()), mode(mode) {
+  addInput(below);
+  addInput(placement ? placement->getLayer() : layer);
+}
+
+uint64_t BlendNode::prepare(double time, int width, int height) {
+  transform = placement ? placement->transformAt(time) : EntryTransform();
+  uint64_t key = hashCombine(0, static_cast<uint64_t>(mode));
+  return hashTransform(key, transform);
+}
+
+bool BlendNode::needsInput(size_t index) const {
+  // An invisible layer is never pulled
+  return index == 0 || transform.opacity > 0.0f;
+}
+
+void BlendNode::process(int width, int height) {
+  if (transform.opacity <= 0.0f) {
+    setResult(input(0));
+    return;
+  }
+
+  // Draw in place when the frame below is ours to take
+  if (!takeInput(0)) {
+    copyBelow(input(0), ownResult(width, height));
+  }
+  AffineBlitter::blit(input(1), ownResult(width, height), transform, mode);
+}
+
+// ==============================================================================
+// TransitionNode
+// ==============================================================================
+
+TransitionNode::TransitionNode(RenderNode* below, RenderNode* fromLayer,
+                               RenderNode* toLayer, const TimelineEntry* from,
+                               const TimelineEntry* to, BlendMode mode)
+  : fromPlacement(fromLayer->asTransform()), toPlacement(toLayer->asTransform()),
+    from(from), to(to), mode(mode), active(false), progress(0.0) {
+  addInput(below);
+  addInput(fromPlacement ? fromPlacement->getLayer() : fromLayer);
+  addInput(toPlacement ? toPlacement->getLayer() : toLayer);
+}
+
+uint64_t TransitionNode::prepare(double time, int width, int height) {
+  active = transitionAt(from, to, time, transition, progress);
+  if (!active) {
+    return 0;
+  }
+
+  fromTransform = fromPlacement ? fromPlacement->transformAt(time) : EntryTransform();
+  toTransform = toPlacement ? toPlacement->transformAt(time) : EntryTransform();
+
+  uint64_t key = hashCombine(1, static_cast<uint64_t>(mode));
+  key = hashTransition(key, transition, progress);
+  key = hashTransform(key, fromTransform);
+  return hashTransform(key, toTransform);
+}
+
+bool TransitionNode::needsInput(size_t index) const {
+  return index == 0 || active;
+}
+
+void TransitionNode::process(int width, int height) {
+  if (!active) {
+    setResult(input(0));
+    return;
+  }
+
+  if (incoming.getWidth() != width || incoming.getHeight() != height) {
+    Image resized(width, height);
+    incoming.swap(resized);
+  }
+
+  // Both sides start from the frame below; the outgoing side is drawn in
+  // the output buffer and mixed in place
+  if (!takeInput(0)) {
+    copyBelow(input(0), ownResult(width, height));
+  }
+  Image& out = ownResult(width, height);
+  std::memcpy(incoming.getData(), out.getData(),
+              static_cast<size_t>(width) * height * 4);
+
+  AffineBlitter::blit(input(1), out, fromTransform, mode);
+  AffineBlitter::blit(input(2), incoming, toTransform, mode);
+  applyTransition(out, incoming, out, transition, progress);
+}
+
+// ==============================================================================
+// LinearCompositeNode
+// ==============================================================================
+
+LinearCompositeNode::LinearCompositeNode(const Color& background)
+  : background(background) {
+}
+
+void LinearCompositeNode::addLayer(RenderNode* layer, BlendMode mode) {
+  Step step;
+  step.placement[0] = layer->asTransform();
+  step.placement[1] = nullptr;
+  step.input = getInputs().size();
+  step.from = nullptr;
+  step.to = nullptr;
+  step.mode = mode;
+  step.active = true;
+  step.progress = 0.0;
+  steps.push_back(step);
+
+  addInput(step.placement[0] ? step.placement[0]->getLayer() : layer);
+  inputSteps.push_back(steps.size() - 1);
+}
+
+void LinearCompositeNode::addTransition(RenderNode* fromLayer, RenderNode* toLayer,
+                                        const TimelineEntry* from,
+                                        const TimelineEntry* to, BlendMode mode) {
+  Step step;
+  step.placement[0] = fromLayer->asTransform();
+  step.placement[1] = toLayer->asTransform();
+  step.input = getInputs().size();
+  step.from = from;
+  step.to = to;
+  step.mode = mode;
+  step.active = false;
+  step.progress = 0.0;
+  steps.push_back(step);
+
+  addInput(step.placement[0] ? step.placement[0]->getLayer() : fromLayer);
+  addInput(step.placement[1] ? step.placement[1]->getLayer() : toLayer);
+  inputSteps.push_back(steps.size() - 1);
+  inputSteps.push_back(steps.size() - 1);
+}
+
+uint64_t LinearCompositeNode::prepare(double time, int width, int height) {
+  uint64_t key = hashColor(2, background);
+  for (size_t i = 0; i < steps.size(); i++) {
+    Step& step = steps[i];
+    if (step.from) {
+      step.active = transitionAt(step.from, step.to, time, step.transition,
+                                 step.progress);
+    }
+    if (!step.active) {
+      key = hashCombine(key, static_cast<uint64_t>(0));
+      continue;
+    }
+
+    for (int side = 0; side < (step.from ? 2 : 1); side++) {
+      step.transform[side] = step.placement[side] ?
+                             step.placement[side]->transformAt(time) : EntryTransform();
+      key = hashTransform(key, step.transform[side]);
+    }
+    key = hashCombine(key, static_cast<uint64_t>(step.mode));
+    if (step.from) {
+      key = hashTransition(key, step.transition, step.progress);
+    }
+  }
+  return key;
+}
+
+bool LinearCompositeNode::needsInput(size_t index) const {
+  const Step& step = steps[inputSteps[index]];
+  return step.active && step.transform[index - step.input].opacity > 0.0f;
+}
+
+void LinearCompositeNode::process(int width, int height) {
+  frame.resize(width, height);
+  frame.fill(background);
+
+  for (size_t i = 0; i < steps.size(); i++) {
+    const Step& step = steps[i];
+    if (!step.active) {
+      continue;
+    }
+
+    if (!step.from) {
+      if (needsInput(step.input)) {
+        AffineBlitter::blit(input(step.input), frame, step.transform[0], step.mode);
+      }
+      continue;
+    }
+
+    // Both sides start from everything below; the outgoing side is drawn in
+    // place and the two are mixed there
+    incoming.resize(width, height);
+    std::memcpy(incoming.getData(), frame.getData(),
+                static_cast<size_t>(width) * height * 4 * sizeof(uint16_t));
+    if (needsInput(step.input)) {
+      AffineBlitter::blit(input(step.input), frame, step.transform[0], step.mode);
+    }
+    if (needsInput(step.input + 1)) {
+      AffineBlitter::blit(input(step.input + 1), incoming, step.transform[1],
+                          step.mode);
+    }
+    applyLinearTransition(frame, incoming, frame, step.transition, step.progress);
+  }
+
+  // The only conversion back to 8 bits
+  frame.toImage(ownResult(width, height));
+}
+
+} // namespace csci3081
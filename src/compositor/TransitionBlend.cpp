@@ -0,0 +1,137 @@
+#include "compositor/TransitionBlend.h"
+#include "compositor/Blend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace csci3081 {
+
+namespace {
+
+inline unsigned char lerpChannel(int a, int b, int weight) {
+  return static_cast<unsigned char>((a * (256 - weight) + b * weight + 128) >> 8);
+}
+
+#if defined(__SSE2__)
+// Interpolate 16-bit lanes; products stay below 2^16
+inline __m128i lerpLanes(__m128i a, __m128i b, __m128i wa, __m128i wb) {
+  __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, wa), _mm_mullo_epi16(b, wb));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+inline __m128i lerp4(__m128i a, __m128i b, __m128i wa, __m128i wb) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lo = lerpLanes(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero),
+                         wa, wb);
+  __m128i hi = lerpLanes(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero),
+                         wa, wb);
+  return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+inline int toWeight(double t) {
+  return std::max(0, std::min(256, static_cast<int>(std::floor(t * 256.0 + 0.5))));
+}
+
+} // namespace
+
+void lerpSpan(unsigned char* dst, const unsigned char* from,
+              const unsigned char* to, int count, int weight) {
+  int i = 0;
+
+#if defined(__SSE2__)
+  const __m128i wa = _mm_set1_epi16(static_cast<short>(256 - weight));
+  const __m128i wb = _mm_set1_epi16(static_cast<short>(weight));
+  for (; i + 4 <= count; i += 4) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i * 4));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(to + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4),
+                     lerp4(a, b, wa, wb));
+  }
+#endif
+
+  for (int c = i * 4; c < count * 4; c++) {
+    dst[c] = lerpChannel(from[c], to[c], weight);
+  }
+}
+
+void lerpSpanToColor(unsigned char* dst, const unsigned char* from,
+                     const Color& straight, int count, int weight) {
+  Color color = premultiplyColor(straight);
+  unsigned char rgba[4] = {
+    static_cast<unsigned char>(color.red()),
+    static_cast<unsigned char>(color.green()),
+    static_cast<unsigned char>(color.blue()),
+    static_cast<unsigned char>(color.alpha())
+  };
+  int i = 0;
+
+#if defined(__SSE2__)
+  int packed;
+  std::memcpy(&packed, rgba, 4);
+  const __m128i b = _mm_set1_epi32(packed);
+  const __m128i wa = _mm_set1_epi16(static_cast<short>(256 - weight));
+  const __m128i wb = _mm_set1_epi16(static_cast<short>(weight));
+  for (; i + 4 <= count; i += 4) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4),
+                     lerp4(a, b, wa, wb));
+  }
+#endif
+
+  for (int c = i * 4; c < count * 4; c++) {
+    dst[c] = lerpChannel(from[c], rgba[c & 3], weight);
+  }
+}
+
+void applyTransition(const Image& from, const Image& to, Image& dst,
+                     const Transition& transition, double progress) {
+  int width = dst.getWidth();
+  int height = dst.getHeight();
+  int count = width * height;
+  progress = std::max(0.0, std::min(progress, 1.0));
+
+  switch (transition.type) {
+    case TransitionType::CROSSFADE:
+      lerpSpan(dst.getData(), from.getData(), to.getData(), count,
+               toWeight(progress));
+      break;
+
+    case TransitionType::WIPE: {
+      // Pixel x shows the incoming frame when its center (x + 0.5) / width
+      // is left of the edge, same test as the shader
+      int edge = static_cast<int>(std::ceil(progress * width - 0.5));
+      edge = std::max(0, std::min(edge, width));
+      size_t rowBytes = static_cast<size_t>(width) * 4;
+      size_t edgeBytes = static_cast<size_t>(edge) * 4;
+      for (int y = 0; y < height; y++) {
+        size_t row = y * rowBytes;
+        if (dst.getData() != to.getData()) {
+          std::memmove(dst.getData() + row, to.getData() + row, edgeBytes);
+        }
+        if (dst.getData() != from.getData()) {
+          std::memmove(dst.getData() + row + edgeBytes,
+                       from.getData() + row + edgeBytes, rowBytes - edgeBytes);
+        }
+      }
+      break;
+    }
+
+    case TransitionType::DIP_TO_COLOR:
+      if (progress < 0.5) {
+        lerpSpanToColor(dst.getData(), from.getData(), transition.color, count,
+                        toWeight(progress * 2.0));
+      } else {
+        lerpSpanToColor(dst.getData(), to.getData(), transition.color, count,
+                        toWeight(2.0 - progress * 2.0));
+      }
+      break;
+  }
+}
+
+} // namespace csci3081
@@ -0,0 +1,41 @@
+#include "export/EncoderSettings.h"
+
+namespace csci3081 {
+
+EncoderSettings EncoderSettings::draft() {
+  EncoderSettings settings;
+  settings.preset = "ultrafast";
+  settings.crf = 28;
+  return settings;
+}
+
+EncoderSettings EncoderSettings::master() {
+  EncoderSettings settings;
+  settings.preset = "slow";
+  settings.crf = 18;
+  return settings;
+}
+
+bool EncoderSettings::check(std::string& error) const {
+  error = "";
+  if (codec.empty()) {
+    error = "No encoder chosen";
+  } else if (threads < 0 || bFrames < 0) {
+    error = "Thread and B-frame counts can't be negative";
+  } else if (keyframeInterval < 1) {
+    error = "Keyframe interval must be at least 1 frame";
+  } else if (rateControl == RateControl::CONSTANT_QUALITY) {
+    if (crf < 0 || crf > 63) {
+      error = "CRF must be from 0 to 63";
+    } else if (twoPass) {
+      error = "Two-pass encoding needs a bit rate (VBR or CBR)";
+    }
+  } else if (bitRate <= 0) {
+    error = "Bit rate must be positive";
+  } else if (rateControl == RateControl::VBR && maxBitRate != 0 && maxBitRate < bitRate) {
+    error = "Peak bit rate is below the average bit rate";
+  }
+  return error.empty();
+}
+
+} // namespace csci3081
@@ -0,0 +1,256 @@
+#include "export/ExportCheckpoint.h"
+#include "project/ProjectFile.h"
+#include "timeline/Timeline.h"
+#include "util/Json.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace csci3081 {
+
+namespace {
+
+const int64_t MANIFEST_VERSION = 1;
+
+/**
+ * @brief 64-bit FNV-1a hash
+ */
+uint64_t hashBytes(const std::string& bytes, uint64_t hash = 14695981039346656037ull) {
+  for (unsigned char byte : bytes) {
+    hash = (hash ^ byte) * 1099511628211ull;
+  }
+  return hash;
+}
+
+bool samePlan(const std::vector<ExportSegment>& a, const std::vector<ExportSegment>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].index != b[i].index || a[i].firstFrame != b[i].firstFrame ||
+        a[i].frameCount != b[i].frameCount || a[i].sourcePath != b[i].sourcePath ||
+        a[i].sourceFirstFrame != b[i].sourceFirstFrame) {
+      return false;
+    }
+  }
+  return true;
+}
+
+JsonValue planToJson(const std::vector<ExportSegment>& plan) {
+  JsonValue segments = JsonValue::array();
+  for (const ExportSegment& segment : plan) {
+    JsonValue item = JsonValue::object();
+    item.set("index", segment.index);
+    item.set("firstFrame", segment.firstFrame);
+    item.set("frameCount", segment.frameCount);
+    if (segment.isPassthrough()) {
+      item.set("sourcePath", segment.sourcePath);
+      item.set("sourceFirstFrame", segment.sourceFirstFrame);
+    }
+    segments.push(item);
+  }
+  return segments;
+}
+
+std::vector<ExportSegment> planFromJson(const JsonValue& segments) {
+  std::vector<ExportSegment> plan;
+  for (size_t i = 0; i < segments.size(); i++) {
+    const JsonValue& item = segments[i];
+    ExportSegment segment(static_cast<int>(item["index"].asInt(-1)), item["firstFrame"].asInt(-1),
+                          item["frameCount"].asInt(-1));
+    segment.sourcePath = item["sourcePath"].asString();
+    segment.sourceFirstFrame = item["sourceFirstFrame"].asInt(0);
+    plan.push_back(segment);
+  }
+  return plan;
+}
+
+} // namespace
+
+ExportCheckpoint::ExportCheckpoint(const std::string& path) : path(path) {}
+
+bool ExportCheckpoint::begin(const std::string& exportKey,
+                             const std::vector<ExportSegment>& exportPlan) {
+  std::lock_guard<std::mutex> lock(mutex);
+  key = exportKey;
+  plan = exportPlan;
+  done.clear();
+  lastError.clear();
+
+  // Anything unreadable, or from another export, is started afresh
+  std::ifstream file(path, std::ios::binary);
+  if (file) {
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    JsonValue root;
+    std::string error;
+    if (JsonValue::parse(text, root, error) && root["version"].asInt(0) == MANIFEST_VERSION &&
+        root["key"].asString() == key && samePlan(planFromJson(root["segments"]), plan)) {
+      const JsonValue& finished = root["done"];
+      for (size_t i = 0; i < finished.size(); i++) {
+        int64_t index = finished[i].asInt(-1);
+        if (index >= 0 && index < static_cast<int64_t>(plan.size()) &&
+            !plan[index].isPassthrough()) {
+          done.insert(static_cast<int>(index));
+        }
+      }
+    }
+  }
+  return save();
+}
+
+bool ExportCheckpoint::isDone(const ExportSegment& segment) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return done.count(segment.index) > 0;
+}
+
+bool ExportCheckpoint::markDone(const ExportSegment& segment) {
+  std::lock_guard<std::mutex> lock(mutex);
+  done.insert(segment.index);
+  return save();
+}
+
+int64_t ExportCheckpoint::getDoneFrames() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  int64_t frames = 0;
+  for (const ExportSegment& segment : plan) {
+    if (done.count(segment.index)) {
+      frames += segment.frameCount;
+    }
+  }
+  return frames;
+}
+
+void ExportCheckpoint::finish() {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::remove(path.c_str());
+  done.clear();
+}
+
+std::string ExportCheckpoint::getLastError() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return lastError;
+}
+
+bool ExportCheckpoint::save() {
+  JsonValue root = JsonValue::object();
+  root.set("version", MANIFEST_VERSION);
+  root.set("key", key);
+  root.set("segments", planToJson(plan));
+  JsonValue finished = JsonValue::array();
+  for (int index : done) {
+    finished.push(index);
+  }
+  root.set("done", finished);
+
+  // Write a new file and put it in place, so a crash mid-write leaves the
+  // old manifest rather than half of the new one
+  const std::string temporary = path + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file << root.dump();
+    if (!file.flush()) {
+      lastError = "Could not write " + temporary;
+      return false;
+    }
+  }
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    // Windows won't rename over an existing file
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+      lastError = "Could not replace " + path;
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<ExportSegment> ExportCheckpoint::planSegments(int64_t frameCount, int gopSize,
+                                                          const Rational& rate) {
+  if (rate.num <= 0 || rate.den <= 0) {
+    return std::vector<ExportSegment>();
+  }
+  const int64_t segmentFrames =
+      std::max<int64_t>(1, SEGMENT_SECONDS * rate.num / rate.den);
+  const int64_t count = (frameCount + segmentFrames - 1) / segmentFrames;
+  return csci3081::planSegments(frameCount, gopSize, static_cast<int>(count));
+}
+
+std::string ExportCheckpoint::describeOutput(int width, int height, const Rational& rate,
+                                             const EncoderSettings& encoder) {
+  std::ostringstream details;
+  details << width << 'x' << height << '@' << rate.num << '/' << rate.den << ' '
+          << encoder.codec << ' ' << encoder.preset << ' ' << encoder.tune << ' '
+          << encoder.threads << ' ' << encoder.keyframeInterval << ' ' << encoder.bFrames << ' '
+          << static_cast<int>(encoder.rateControl) << ' ' << encoder.crf << ' '
+          << encoder.bitRate << ' ' << encoder.maxBitRate << ' '
+          << static_cast<int>(encoder.yuvFormat.matrix) << ' '
+          << static_cast<int>(encoder.yuvFormat.range);
+  return details.str();
+}
+
+std::string ExportCheckpoint::describeSource(const std::string& source) {
+  std::ostringstream details;
+  details << source;
+  struct stat info;
+  if (stat(source.c_str(), &info) != 0) {
+    return details.str();   // Not a file, e.g. "text:..."
+  }
+#if defined(_WIN32)
+  const long nanoseconds = 0;
+#elif defined(__APPLE__)
+  const long nanoseconds = info.st_mtimespec.tv_nsec;
+#else
+  const long nanoseconds = info.st_mtim.tv_nsec;
+#endif
+  details << ' ' << static_cast<int64_t>(info.st_size) << ' '
+          << static_cast<int64_t>(info.st_mtime) << '.' << nanoseconds;
+  return details.str();
+}
+
+bool ExportCheckpoint::makeKey(const Timeline& timeline,
+                               const std::map<IAsset*, std::string>& sources, int width,
+                               int height, const Rational& rate,
+                               const EncoderSettings& encoder, std::string& key) {
+  // The assets in the order the timeline first shows them, so the same
+  // timeline always lists them the same way
+  Project project;
+  for (const Track* track : timeline.getTracks()) {
+    if (!track->getFilters().empty()) {
+      return false;
+    }
+    for (const TimelineEntry& entry : track->getEntries()) {
+      IAsset* asset = entry.getAsset();
+      std::map<IAsset*, std::string>::const_iterator source = sources.find(asset);
+      if (source == sources.end()) {
+        return false;
+      }
+      if (std::find(project.assets.begin(), project.assets.end(), asset) == project.assets.end()) {
+        project.assets.push_back(asset);
+        project.assetSources.push_back(source->second);
+      }
+    }
+  }
+
+  std::string bytes;
+  ProjectFile file(nullptr);
+  if (!file.serialize(project, timeline, bytes)) {
+    return false;
+  }
+
+  std::ostringstream details;
+  details << describeOutput(width, height, rate, encoder);
+  for (const std::string& source : project.assetSources) {
+    details << '\n' << describeSource(source);
+  }
+
+  char text[17];
+  std::snprintf(text, sizeof(text), "%016llx",
+                static_cast<unsigned long long>(hashBytes(details.str(), hashBytes(bytes))));
+  key = text;
+  return true;
+}
+
+} // namespace csci3081
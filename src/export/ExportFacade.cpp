@@ -1,18 +1,97 @@
 #include "export/ExportFacade.h"
+#include "assets/LazyAsset.h"
+#include "export/ExportCheckpoint.h"
+#include "export/ExportMonitor.h"
+#include "export/ExportPipeline.h"
+#include "export/FrameServerSink.h"
+#include "export/ImageSequenceExport.h"
+#include "export/ImageWriter.h"
+#include "export/Mp4SegmentTarget.h"
+#include "export/SegmentCache.h"
+#include "export/SegmentedExport.h"
+#include "export/SmartRender.h"
+#include "export/VideoReaderProbe.h"
+#include "export/VideoWriterSink.h"
+#include "export/YuvFrame.h"
+#include "compositor/Blend.h"
 #include "timeline/Timeline.h"
-#include "video_writer.hpp"
+#include "util/ThreadPool.h"
 #include <algorithm>
+#include <cstdio>
 #include <iostream>
-
-// STB image write for multiple formats
-#include "stb_image_write.h"
+#include <map>
+#include <memory>
 
 namespace csci3081 {
 
-ExportFacade::ExportFacade() : lastError("") {}
+namespace {
+
+/**
+ * @brief Delete the statistics files of a two-pass encode
+ */
+void removePassLogs(const std::string& passLog) {
+  std::remove(passLog.c_str());
+  std::remove((passLog + ".mbtree").c_str());   // x264's macroblock-tree statistics
+}
+
+/**
+ * @brief Copy a timeline, giving it its own copy of each video that has a source
+ *
+ * The copy can be rendered on another thread while the editor plays the
+ * original videos. Videos without a source stay shared.
+ */
+std::shared_ptr<const Timeline> copyWithOwnVideos(
+    const std::shared_ptr<const Timeline>& timeline, const IAssetFactory* factory,
+    const std::map<IAsset*, std::string>& sources,
+    std::vector<std::unique_ptr<IAsset> >& owned) {
+  std::map<IAsset*, IAsset*> replacements;
+  for (const Track* track : timeline->getTracks()) {
+    for (size_t i = 0; factory && i < track->getEntryCount(); i++) {
+      IAsset* asset = track->getEntry(i).getAsset();
+      std::map<IAsset*, std::string>::const_iterator source = sources.find(asset);
+      if (asset && asset->isVideo() && source != sources.end() && !replacements.count(asset)) {
+        owned.emplace_back(new LazyAsset(factory, source->second, asset->getDuration(),
+                                         asset->getAssetType()));
+        replacements[asset] = owned.back().get();
+      }
+    }
+  }
+  return replacements.empty() ? timeline : timeline->copyWithAssets(replacements);
+}
+
+} // namespace
+
+ExportFacade::ExportFacade()
+  : lastError(""), assetFactory(nullptr), assets(nullptr), assetSources(nullptr),
+    monitor(nullptr) {}
 
 ExportFacade::~ExportFacade() {}
 
+void ExportFacade::setAssetSources(const IAssetFactory* factory,
+                                   const std::vector<IAsset*>* editorAssets,
+                                   const std::vector<std::string>* sources) {
+  assetFactory = factory;
+  assets = editorAssets;
+  assetSources = sources;
+}
+
+void ExportFacade::freezeAssetSources() {
+  if (assets) {
+    frozenAssets = std::make_shared<const std::vector<IAsset*> >(*assets);
+    assets = frozenAssets.get();
+  }
+  if (assetSources) {
+    frozenSources = std::make_shared<const std::vector<std::string> >(*assetSources);
+    assetSources = frozenSources.get();
+  }
+}
+
+bool ExportFacade::failVideo(const std::string& filename, const std::string& error) {
+  lastError = monitor && monitor->isCancelled() ? "Export cancelled" : error;
+  std::remove(filename.c_str());   // Players can't open an unfinished video
+  return false;
+}
+
 bool ExportFacade::exportImage(const Image& image, const std::string& filename,
                                 const ExportSettings& settings) {
   lastError = "";
@@ -32,10 +111,14 @@ bool ExportFacade::exportImage(const Image& image, const std::string& filename,
   // Resize if needed
   Image* processedImage = resizeIfNeeded(image, settings);
 
+  // Formats that keep alpha store it straight
+  Image* convertedImage = convertFormat(*processedImage, settings.format);
+
   // Write to file
-  bool success = writeImageFile(*processedImage, filename, settings.format, settings.quality);
+  bool success = writeImageFile(*convertedImage, filename, settings, lastError);
 
   // Clean up
+  delete convertedImage;
   if (processedImage != &image) {
     delete processedImage;
   }
@@ -67,52 +150,87 @@ bool ExportFacade::exportVideo(const std::vector<const Image*>& frames,
   // Get dimensions from first frame
   int width = frames[0]->getWidth();
   int height = frames[0]->getHeight();
-  int fps = static_cast<int>(settings.frameRate);
-
-  std::cout << "Exporting video: " << filename << " (" << width << "x" << height
-            << " @ " << fps << " fps, " << frames.size() << " frames)" << std::endl;
-
-  // Initialize video writer
-  VideoWriterState writer;
-  if (!video_writer_open(&writer, filename.c_str(), width, height, fps)) {
-    lastError = "Failed to open video writer";
+  Rational rate = rateFromDouble(settings.frameRate);
+  if (!VideoWriterSink::checkSettings(settings.encoder, width, height, rate, lastError)) {
     return false;
   }
 
-  // Write each frame
-  for (size_t i = 0; i < frames.size(); i++) {
-    const Image* frame = frames[i];
+  std::cerr << "Exporting video: " << filename << " (" << width << "x" << height
+            << " @ " << settings.frameRate << " fps, " << frames.size() << " frames)"
+            << std::endl;
 
-    // Validate frame dimensions
-    if (frame->getWidth() != width || frame->getHeight() != height) {
-      std::cerr << "Warning: Frame " << i << " has different dimensions ("
-                << frame->getWidth() << "x" << frame->getHeight()
-                << "), expected (" << width << "x" << height << ")" << std::endl;
-      // Skip this frame or resize it
-      continue;
+  // A two-pass encode sends every frame to the encoder twice
+  const int passes = settings.encoder.twoPass ? 2 : 1;
+  const std::string passLog = filename + ".passlog";
+  if (monitor) {
+    monitor->start(static_cast<int64_t>(frames.size()) * passes);
+  }
+  YuvFrame converted;
+  bool success = true;
+  for (int pass = 1; success && pass <= passes; pass++) {
+    VideoWriterSink sink(filename, settings.encoder);
+    if (passes > 1) {
+      sink.setPass(pass, passLog);
     }
-
-    // Write frame
-    if (!video_writer_write_frame(&writer, frame->getData())) {
-      lastError = "Failed to write frame " + std::to_string(i);
-      video_writer_close(&writer);
-      return false;
+    if (!sink.open(width, height, rate)) {
+      lastError = sink.getLastError();
+      success = false;
+      break;
     }
 
-    // Progress indicator every 30 frames
-    if (i % 30 == 0 || i == frames.size() - 1) {
-      std::cout << "Encoded " << (i + 1) << "/" << frames.size() << " frames" << std::endl;
+    // Write each frame
+    for (size_t i = 0; i < frames.size(); i++) {
+      const Image* frame = frames[i];
+
+      // Validate frame dimensions
+      if (frame->getWidth() != width || frame->getHeight() != height) {
+        std::cerr << "Warning: Frame " << i << " has different dimensions ("
+                  << frame->getWidth() << "x" << frame->getHeight()
+                  << "), expected (" << width << "x" << height << ")" << std::endl;
+        // Skip this frame or resize it
+        continue;
+      }
+
+      // Write frame
+      if (monitor && monitor->isCancelled()) {
+        success = false;
+        break;
+      }
+      convertToYuv420(*frame, converted, sink.getYuvFormat(), &ThreadPool::shared());
+      if (!sink.writeFrame(converted)) {
+        lastError = "Failed to write frame " + std::to_string(i);
+        success = false;
+        break;
+      }
+      if (monitor) {
+        monitor->addFrames(1);
+      }
+
+      // Progress indicator every 30 frames
+      if (i % 30 == 0 || i == frames.size() - 1) {
+        std::cerr << "Encoded " << (i + 1) << "/" << frames.size() << " frames";
+        if (passes > 1) {
+          std::cerr << " (pass " << pass << " of " << passes << ")";
+        }
+        std::cerr << std::endl;
+      }
     }
-  }
 
-  // Close video writer
-  video_writer_close(&writer);
+    // Close video writer
+    sink.close();
+  }
+  if (passes > 1) {
+    removePassLogs(passLog);
+  }
+  if (!success) {
+    return failVideo(filename, lastError);
+  }
 
-  std::cout << "Video export complete: " << filename << std::endl;
+  std::cerr << "Video export complete: " << filename << std::endl;
   return true;
 }
 
-bool ExportFacade::exportTimeline(class Timeline* timeline,
+bool ExportFacade::exportTimeline(const class Timeline* timeline,
                                    const std::string& filename,
                                    const ExportSettings& settings,
                                    int width,
@@ -125,68 +243,221 @@ bool ExportFacade::exportTimeline(class Timeline* timeline,
   // For now, just export a single frame at time 0.0 as an image
   // TODO: Implement full video export with FFmpeg
 
-  double duration = timeline->getTotalDuration();
+  // Render from a snapshot: the export sees the timeline as it was when it
+  // started, and the live timeline's render graph is left alone
+  std::shared_ptr<const Timeline> frozen = timeline->snapshot();
+
+  double duration = frozen->getTotalDuration();
   if (duration <= 0.0) {
     lastError = "Timeline has no duration (empty or no tracks)";
     return false;
   }
 
-  // For image export, render the first frame
-  if (settings.format != ExportFormat::MP4) {
-    std::cout << "Exporting timeline as single frame image at time 0.0s" << std::endl;
-    Image* frame = timeline->renderFrameAt(0.0, width, height);
-    if (!frame) {
-      lastError = "Failed to render timeline frame";
+  std::map<IAsset*, std::string> sources;
+  if (assets && assetSources) {
+    for (size_t i = 0; i < assets->size() && i < assetSources->size(); i++) {
+      sources[(*assets)[i]] = (*assetSources)[i];
+    }
+  }
+  // Unsplit exports decode their own copies of the videos, so the editor
+  // can keep playing them (segmented exports make their own per worker)
+  std::vector<std::unique_ptr<IAsset> > ownVideos;
+  std::shared_ptr<const Timeline> own =
+      copyWithOwnVideos(frozen, assetFactory, sources, ownVideos);
+
+  // Streams skip the encoder: converted frames go straight to the reader,
+  // and the pipeline's bounded queues hold rendering back to its pace
+  if (FrameServerSink::isStreamFormat(settings.format)) {
+    Rational rate = rateFromDouble(settings.frameRate);
+    FrameServerSink sink(filename, settings.format, settings.encoder.yuvFormat);
+    sink.setMonitor(monitor);
+    ExportPipeline pipeline;
+    pipeline.setMonitor(monitor);
+    if (monitor) {
+      monitor->start(ExportPipeline::getFrameCount(*own, rate));
+    }
+    if (!pipeline.run(*own, width, height, rate, sink)) {
+      lastError = pipeline.getLastError();
       return false;
     }
-
-    bool success = exportImage(*frame, filename, settings);
-    delete frame;
-    return success;
+    const PipelineStats& stats = pipeline.getStats();
+    std::cerr << "Streamed " << stats.encode.frames << " frames in " << stats.elapsedSeconds
+              << "s (render " << stats.render.getFramesPerSecond() << " fps, write "
+              << stats.encode.getFramesPerSecond() << " fps)" << std::endl;
+    return true;
   }
 
-  // For MP4, we need to render all frames and export as video
-  std::cout << "Preparing to export timeline as MP4 video..." << std::endl;
-  std::cout << "Timeline duration: " << duration << "s" << std::endl;
-  std::cout << "Frame rate: " << settings.frameRate << " fps" << std::endl;
+  // Image sequences render in order and encode the files on every core
+  if (settings.format != ExportFormat::MP4 && settings.imageSequence) {
+    Rational rate = rateFromDouble(settings.frameRate);
+    ImageSequenceExport sequence;
+    sequence.setMonitor(monitor);
+    if (monitor) {
+      monitor->start(ExportPipeline::getFrameCount(*own, rate));
+    }
+    if (!sequence.run(*own, width, height, rate, filename, settings)) {
+      lastError = sequence.getLastError();
+      return false;
+    }
+    const SequenceStats& stats = sequence.getStats();
+    std::cerr << "Exported " << stats.encode.frames << " images in " << stats.elapsedSeconds
+              << "s (" << stats.getFilesPerSecond() << " files/s on " << stats.workers
+              << " threads)" << std::endl;
+    return true;
+  }
 
-  // Calculate number of frames
-  int numFrames = static_cast<int>(duration * settings.frameRate);
-  std::cout << "Total frames to render: " << numFrames << std::endl;
+  // For image export, render the first frame
+  if (settings.format != ExportFormat::MP4) {
+    std::cerr << "Exporting timeline as single frame image at time 0.0s" << std::endl;
+    Image frame(width, height);
+    own->renderFrameInto(0.0, frame);
+    return exportImage(frame, filename, settings);
+  }
 
-  // Render all frames
-  std::vector<const Image*> frames;
-  for (int i = 0; i < numFrames; i++) {
-    double time = i / settings.frameRate;
-    Image* frame = timeline->renderFrameAt(time, width, height);
-    if (!frame) {
-      lastError = "Failed to render frame at time " + std::to_string(time);
+  // For MP4, stream the frames through the render, convert and encode
+  // stages, so only a few frames are ever in memory
+  std::cerr << "Preparing to export timeline as MP4 video..." << std::endl;
+  std::cerr << "Timeline duration: " << duration << "s" << std::endl;
+  std::cerr << "Frame rate: " << settings.frameRate << " fps" << std::endl;
+
+  // Frame times are exact ticks, so every export of a timeline samples the
+  // same instants and frames on a cut always show the entry after it
+  Rational rate = rateFromDouble(settings.frameRate);
+  const EncoderSettings& encoder = settings.encoder;
+  if (!VideoWriterSink::checkSettings(encoder, width, height, rate, lastError)) {
+    return false;
+  }
 
-      // Clean up already-rendered frames
-      for (const Image* f : frames) {
-        delete f;
-      }
-      return false;
+  // Smart render: spans showing one untouched H.264 video are copied from
+  // it and only the frames around them are rendered. A two-pass encode
+  // needs one encoder to see every frame, so it is neither split nor copied.
+  const int segments = encoder.twoPass ? 1 : settings.segments;
+  SegmentedExport segmented(segments, encoder.keyframeInterval);
+  segmented.setAssetSources(assetFactory, sources);
+  segmented.setMonitor(monitor);
+  std::vector<ExportSegment> plan;
+  int64_t copied = 0;
+  if (settings.smartRender && !encoder.twoPass &&
+      VideoWriterSink::getEncoderFormat(encoder.codec) == "h264") {
+    VideoReaderProbe probe;
+    int maxSegments = segments > 0 ? segments : SegmentedExport::getDefaultSegmentCount();
+    plan = planSmartRender(*frozen, width, height, rate, sources, probe,
+                           encoder.keyframeInterval, maxSegments);
+    for (const ExportSegment& segment : plan) {
+      copied += segment.isPassthrough() ? segment.frameCount : 0;
     }
-    frames.push_back(frame);
+  }
+
+  // A resumable export is split into segments of a fixed length, and a
+  // manifest next to the output lists the finished ones, so running it
+  // again after a crash only renders what is missing
+  std::string key;
+  const bool resumable = settings.resumable && !encoder.twoPass &&
+      ExportCheckpoint::makeKey(*frozen, sources, width, height, rate, encoder, key);
+  if (settings.resumable && !resumable) {
+    std::cerr << "NOTE: This export can't be resumed (two-pass, CPU filters, or an asset "
+              << "without a source)" << std::endl;
+  }
+  // An incremental export copies the segments an edit didn't touch from
+  // the last export to the same file, and renders only the others
+  std::vector<std::string> hashes;
+  bool incremental = settings.incremental && !encoder.twoPass;
+  if ((resumable || incremental) && copied == 0) {
+    plan = ExportCheckpoint::planSegments(ExportPipeline::getFrameCount(*frozen, rate),
+                                          encoder.keyframeInterval, rate);
+  }
+  if (incremental && !SegmentCache::hashSegments(*frozen, sources, plan, width, height, rate,
+                                                 encoder, hashes)) {
+    std::cerr << "NOTE: This export can't reuse earlier exports (CPU filters, or an asset "
+              << "without a source)" << std::endl;
+    incremental = false;
+  }
+  SegmentCache cache(filename);
+  if (incremental && cache.load()) {
+    cache.reuse(plan, hashes);
+  }
 
-    // Progress indicator
-    if (i % 30 == 0) {
-      std::cout << "Rendered " << i << "/" << numFrames << " frames..." << std::endl;
+  ExportCheckpoint checkpoint(filename + ".manifest");
+  if (resumable) {
+    if (!checkpoint.begin(key, plan)) {
+      lastError = checkpoint.getLastError();
+      return false;
     }
+    segmented.setCheckpoint(&checkpoint);
   }
 
-  std::cout << "All frames rendered, exporting video..." << std::endl;
+  const int passes = encoder.twoPass ? 2 : 1;
+  if (monitor) {
+    monitor->start(ExportPipeline::getFrameCount(*frozen, rate) * passes);
+  }
 
-  // Export the frames as video
-  bool success = exportVideo(frames, filename, settings);
+  if (copied > 0 || segments != 1 || resumable || incremental) {
+    if (!cache.keepPrevious()) {
+      lastError = cache.getLastError();
+      return false;
+    }
+    Mp4SegmentTarget target(filename, encoder);
+    target.setKeepParts(resumable);
+    bool exported = copied > 0 || resumable || incremental
+                        ? segmented.run(*frozen, width, height, rate, plan, target)
+                        : segmented.run(*frozen, width, height, rate, target);
+    if (!exported) {
+      failVideo(filename, segmented.getLastError());
+      cache.restore();
+      return false;
+    }
+    if (resumable) {
+      checkpoint.finish();
+    }
+    if (incremental && !cache.store(plan, hashes)) {
+      std::cerr << "WARNING: " << cache.getLastError() << std::endl;
+    }
+    const PipelineStats& stats = segmented.getStats();
+    const int64_t frames = stats.encode.frames + segmented.getPassthroughFrames() +
+                           segmented.getResumedFrames();
+    const int64_t reused = cache.getReusedFrames();
+    std::cerr << "Exported " << frames << " frames in " << segmented.getSegments().size()
+              << " segments in " << stats.elapsedSeconds << "s ("
+              << segmented.getPassthroughFrames() - reused << " copied, " << reused
+              << " reused, " << segmented.getResumedFrames() << " resumed, "
+              << stats.encode.frames << " re-encoded)" << std::endl;
+    if (incremental) {
+      std::cerr << "Reused " << (frames > 0 ? 100.0 * reused / frames : 0.0)
+                << "% of the last export" << std::endl;
+    }
+    return true;
+  }
 
-  // Clean up frames
-  for (const Image* frame : frames) {
-    delete frame;
+  const std::string passLog = filename + ".passlog";
+  ExportPipeline pipeline;
+  pipeline.setMonitor(monitor);
+  for (int pass = 1; pass <= passes; pass++) {
+    VideoWriterSink sink(filename, encoder);
+    if (passes > 1) {
+      sink.setPass(pass, passLog);
+      std::cerr << "Pass " << pass << " of " << passes << std::endl;
+    }
+    if (!pipeline.run(*own, width, height, rate, sink)) {
+      if (passes > 1) {
+        removePassLogs(passLog);
+      }
+      return failVideo(filename, pipeline.getLastError());
+    }
+  }
+  if (passes > 1) {
+    removePassLogs(passLog);
   }
 
-  return success;
+  const PipelineStats& stats = pipeline.getStats();
+  std::cerr << "Exported " << stats.encode.frames << " frames in "
+            << stats.elapsedSeconds << "s (render " << stats.render.getFramesPerSecond()
+            << " fps, convert " << stats.convert.getFramesPerSecond()
+            << " fps, encode " << stats.encode.getFramesPerSecond() << " fps)" << std::endl;
+  return true;
+}
+
+std::vector<std::string> ExportFacade::getAvailableEncoders() {
+  return VideoWriterSink::getAvailableEncoders();
 }
 
 std::string ExportFacade::getDefaultExtension(ExportFormat format) {
@@ -201,6 +472,10 @@ std::string ExportFacade::getDefaultExtension(ExportFormat format) {
       return ".ppm";
     case ExportFormat::MP4:
       return ".mp4";
+    case ExportFormat::Y4M:
+      return ".y4m";
+    case ExportFormat::RAW:
+      return ".yuv";
     default:
       return ".png";
   }
@@ -241,58 +516,14 @@ Image* ExportFacade::resizeIfNeeded(const Image& image, const ExportSettings& se
 }
 
 Image* ExportFacade::convertFormat(const Image& image, ExportFormat targetFormat) {
-  // For now, all our images are RGBA, so no conversion needed
-  // Just return a copy
-  return new Image(image);
-}
-
-bool ExportFacade::writeImageFile(const Image& image, const std::string& filename,
-                                   ExportFormat format, int quality) {
-  int width = image.getWidth();
-  int height = image.getHeight();
-  const unsigned char* data = image.getData();
-
-  // Components is always 4 (RGBA) for our Image class
-  int components = 4;
-
-  int result = 0;
-
-  switch (format) {
-    case ExportFormat::PNG:
-      result = stbi_write_png(filename.c_str(), width, height, components, data, width * components);
-      break;
-
-    case ExportFormat::JPEG:
-      // JPEG doesn't support alpha, so we'd need to convert to RGB
-      // For now, just write with alpha (STB will ignore it)
-      result = stbi_write_jpg(filename.c_str(), width, height, components, data, quality);
-      break;
-
-    case ExportFormat::BMP:
-      result = stbi_write_bmp(filename.c_str(), width, height, components, data);
-      break;
+  Image* converted = new Image(image);
 
-    case ExportFormat::PPM:
-      // PPM is not directly supported by STB, but we can use TGA instead
-      // Or implement custom PPM writer
-      result = stbi_write_tga(filename.c_str(), width, height, components, data);
-      break;
-
-    case ExportFormat::MP4:
-      lastError = "Use exportVideo() for MP4 format";
-      return false;
-
-    default:
-      lastError = "Unknown export format";
-      return false;
-  }
-
-  if (result == 0) {
-    lastError = "Failed to write image file (disk full or permission denied)";
-    return false;
+  // JPEG and BMP drop alpha, so their colors are already the frame over black
+  if (formatKeepsAlpha(targetFormat)) {
+    unpremultiplySpan(converted->getData(), converted->getData(),
+                      converted->getWidth() * converted->getHeight());
   }
-
-  return true;
+  return converted;
 }
 
 } // namespace csci3081
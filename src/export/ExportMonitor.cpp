@@ -0,0 +1,55 @@
+#include "export/ExportMonitor.h"
+#include <algorithm>
+#include <chrono>
+
+namespace csci3081 {
+
+namespace {
+
+int64_t nowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+double ExportProgress::getFraction() const {
+  if (frameCount <= 0) {
+    return 0.0;
+  }
+  return std::min(1.0, static_cast<double>(framesDone) / frameCount);
+}
+
+double ExportProgress::getFramesPerSecond() const {
+  return elapsedSeconds > 0.0 ? framesDone / elapsedSeconds : 0.0;
+}
+
+double ExportProgress::getSecondsRemaining() const {
+  double framesPerSecond = getFramesPerSecond();
+  if (frameCount <= 0 || framesPerSecond <= 0.0) {
+    return -1.0;
+  }
+  return std::max<int64_t>(0, frameCount - framesDone) / framesPerSecond;
+}
+
+ExportMonitor::ExportMonitor()
+  : framesDone(0), frameCount(0), startNanoseconds(0), cancelled(false) {}
+
+void ExportMonitor::start(int64_t frames) {
+  framesDone = 0;
+  frameCount = frames;
+  startNanoseconds = nowNanoseconds();
+}
+
+ExportProgress ExportMonitor::getProgress() const {
+  ExportProgress progress;
+  progress.framesDone = framesDone;
+  progress.frameCount = frameCount;
+  int64_t started = startNanoseconds;
+  if (started != 0) {
+    progress.elapsedSeconds = (nowNanoseconds() - started) / 1e9;
+  }
+  return progress;
+}
+
+} // namespace csci3081
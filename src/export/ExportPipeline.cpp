@@ -0,0 +1,174 @@
+#include "export/ExportPipeline.h"
+#include "export/ExportMonitor.h"
+#include "timeline/Timeline.h"
+#include "util/BoundedQueue.h"
+#include "util/ThreadPool.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace csci3081 {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+ExportPipeline::ExportPipeline(int queueCapacity)
+  : queueCapacity(queueCapacity > 0 ? queueCapacity : 1), convertPool(&ThreadPool::shared()),
+    monitor(nullptr) {}
+
+bool ExportPipeline::run(const Timeline& timeline, int width, int height,
+                         const Rational& rate, IFrameSink& sink) {
+  if (timeline.getTotalTicks() <= 0) {
+    stats = PipelineStats();
+    lastError = "Timeline has no duration (empty or no tracks)";
+    return false;
+  }
+  return run(timeline, width, height, rate, sink, 0, getFrameCount(timeline, rate));
+}
+
+bool ExportPipeline::run(const Timeline& timeline, int width, int height,
+                         const Rational& rate, IFrameSink& sink, int64_t firstFrame,
+                         int64_t frameCount) {
+  stats = PipelineStats();
+  lastError = "";
+  Clock::time_point started = Clock::now();
+
+  if (width <= 0 || height <= 0 || rate.num <= 0 || rate.den <= 0) {
+    lastError = "Invalid frame size or rate";
+    return false;
+  }
+  if (firstFrame < 0 || frameCount <= 0) {
+    lastError = "No frames to export";
+    return false;
+  }
+
+  if (!sink.open(width, height, rate)) {
+    lastError = "Could not open output: " + sink.getLastError();
+    return false;
+  }
+  const YuvFormat format = sink.getYuvFormat();
+
+  // Each stage holds one buffer while it works and the queue between two
+  // stages holds the rest, so this many keeps every stage busy
+  const int buffers = queueCapacity + 2;
+  std::vector<std::unique_ptr<Image> > images;
+  std::vector<std::unique_ptr<YuvFrame> > yuvFrames;
+  BoundedQueue<Image*> freeImages(buffers);
+  BoundedQueue<Image*> rendered(queueCapacity);
+  BoundedQueue<YuvFrame*> freeYuvFrames(buffers);
+  BoundedQueue<YuvFrame*> converted(queueCapacity);
+  for (int i = 0; i < buffers; i++) {
+    images.emplace_back(new Image(width, height));
+    freeImages.push(images.back().get());
+    yuvFrames.emplace_back(new YuvFrame(width, height));
+    freeYuvFrames.push(yuvFrames.back().get());
+  }
+  stats.frameBuffers = buffers;
+
+  std::thread renderThread([&]() {
+    for (int64_t i = 0; i < frameCount; i++) {
+      Clock::time_point waiting = Clock::now();
+      Image* image;
+      if (!freeImages.pop(image)) {
+        break;
+      }
+      Clock::time_point working = Clock::now();
+      stats.render.waitSeconds += std::chrono::duration<double>(working - waiting).count();
+
+      timeline.renderFrameInto(ticksToSeconds(frameToTicks(firstFrame + i, rate)), *image);
+      stats.render.busySeconds += secondsSince(working);
+      stats.render.frames++;
+
+      waiting = Clock::now();
+      if (!rendered.push(image)) {
+        break;
+      }
+      stats.render.waitSeconds += secondsSince(waiting);
+    }
+    rendered.close();
+  });
+
+  std::thread convertThread([&]() {
+    while (true) {
+      Clock::time_point waiting = Clock::now();
+      Image* image;
+      YuvFrame* frame;
+      if (!rendered.pop(image) || !freeYuvFrames.pop(frame)) {
+        break;
+      }
+      Clock::time_point working = Clock::now();
+      stats.convert.waitSeconds += std::chrono::duration<double>(working - waiting).count();
+
+      convertToYuv420(*image, *frame, format, convertPool);
+      freeImages.push(image);
+      stats.convert.busySeconds += secondsSince(working);
+      stats.convert.frames++;
+
+      waiting = Clock::now();
+      if (!converted.push(frame)) {
+        break;
+      }
+      stats.convert.waitSeconds += secondsSince(waiting);
+    }
+    converted.close();
+  });
+
+  // Encode on this thread; a failing sink stops the other stages
+  bool written = true;
+  while (true) {
+    Clock::time_point waiting = Clock::now();
+    YuvFrame* frame;
+    if (!converted.pop(frame)) {
+      break;
+    }
+    Clock::time_point working = Clock::now();
+    stats.encode.waitSeconds += std::chrono::duration<double>(working - waiting).count();
+
+    bool cancelled = monitor && monitor->isCancelled();
+    if (cancelled || !sink.writeFrame(*frame)) {
+      lastError = cancelled ? "Export cancelled"
+                            : "Failed to write frame " + std::to_string(stats.encode.frames) +
+                              ": " + sink.getLastError();
+      written = false;
+      freeImages.close();
+      rendered.close();
+      freeYuvFrames.close();
+      converted.close();
+      break;
+    }
+    freeYuvFrames.push(frame);
+    stats.encode.busySeconds += secondsSince(working);
+    stats.encode.frames++;
+    if (monitor) {
+      monitor->addFrames(1);
+    }
+  }
+
+  renderThread.join();
+  convertThread.join();
+
+  bool closed = sink.close();
+  if (written && !closed) {
+    lastError = "Could not finish output: " + sink.getLastError();
+  }
+  stats.elapsedSeconds = secondsSince(started);
+  return written && closed && stats.encode.frames == frameCount;
+}
+
+int64_t ExportPipeline::getFrameCount(const Timeline& timeline, const Rational& rate) {
+  Ticks total = timeline.getTotalTicks();
+  if (total <= 0 || rate.num <= 0 || rate.den <= 0) {
+    return 0;
+  }
+  return ticksToFrame(total - 1, rate) + 1;
+}
+
+} // namespace csci3081
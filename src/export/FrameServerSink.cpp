@@ -0,0 +1,241 @@
+#include "export/FrameServerSink.h"
+#include "export/ExportMonitor.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <climits>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace csci3081 {
+
+namespace {
+
+// How often a sink waiting for its reader checks for a cancel
+const int WAIT_MILLISECONDS = 50;
+
+std::mutex sinksMutex;
+bool streamingToStdout = false;           // A sink is open on "-"
+
+#ifndef _WIN32
+int sigpipeUsers = 0;                     // Open sinks that need SIGPIPE ignored
+void (*previousSigpipe)(int) = SIG_DFL;   // The handler before the first of them
+
+/**
+ * @brief Ignore SIGPIPE while any sink is open
+ *
+ * Sinks may be open on several export threads at once, so the handler
+ * the process had is put back only when the last of them closes.
+ */
+void ignoreSigpipe() {
+  std::lock_guard<std::mutex> lock(sinksMutex);
+  if (sigpipeUsers++ == 0) {
+    previousSigpipe = std::signal(SIGPIPE, SIG_IGN);
+  }
+}
+
+void restoreSigpipe() {
+  std::lock_guard<std::mutex> lock(sinksMutex);
+  if (--sigpipeUsers == 0) {
+    std::signal(SIGPIPE, previousSigpipe);
+  }
+}
+#endif
+
+} // namespace
+
+FrameServerSink::FrameServerSink(const std::string& destination, ExportFormat format,
+                                 const YuvFormat& yuvFormat)
+  : destination(destination), format(format), yuvFormat(yuvFormat), monitor(nullptr),
+    file(nullptr), pipe(false) {}
+
+FrameServerSink::~FrameServerSink() {
+  if (file) {
+    close();
+  }
+}
+
+bool FrameServerSink::isStreamFormat(ExportFormat format) {
+  return format == ExportFormat::Y4M || format == ExportFormat::RAW;
+}
+
+std::string FrameServerSink::makeY4mHeader(int width, int height, const Rational& rate,
+                                           const YuvFormat& yuvFormat) {
+  // Chroma samples average their 2x2 block, so they sit in its center
+  // (420jpeg siting), as they do for every codec but MPEG-2
+  std::ostringstream header;
+  header << "YUV4MPEG2 W" << width << " H" << height << " F" << rate.num << ':' << rate.den
+         << " Ip A1:1 C420jpeg XYSCSS=420JPEG XCOLORRANGE="
+         << (yuvFormat.range == YuvRange::FULL ? "FULL" : "LIMITED") << '\n';
+  return header.str();
+}
+
+bool FrameServerSink::open(int width, int height, const Rational& rate) {
+  lastError = "";
+  if (!isStreamFormat(format)) {
+    lastError = "Frame servers stream Y4M or raw frames";
+    return false;
+  }
+
+  if (destination == "-") {
+    {
+      std::lock_guard<std::mutex> lock(sinksMutex);
+      if (streamingToStdout) {
+        lastError = "Another export is streaming to stdout";
+        return false;
+      }
+      streamingToStdout = true;
+    }
+#ifdef _WIN32
+    // Text mode would turn every 0x0A byte into two
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    // Whatever was printed goes out before the stream
+    std::fflush(stdout);
+    file = stdout;
+  } else if (!openDestination()) {
+    return false;
+  }
+#ifndef _WIN32
+  // A reader that exits early fails the write instead of ending the editor
+  ignoreSigpipe();
+  struct stat info;
+  pipe = fstat(fileno(file), &info) == 0 && (S_ISFIFO(info.st_mode) || S_ISSOCK(info.st_mode));
+#endif
+
+  if (format == ExportFormat::Y4M) {
+    const std::string header = makeY4mHeader(width, height, rate, yuvFormat);
+    return writeAll(header.data(), header.size());
+  }
+  return true;
+}
+
+bool FrameServerSink::writeFrame(const YuvFrame& frame) {
+  static const char FRAME_HEADER[] = "FRAME\n";
+  if (!file) {
+    lastError = "Not open";
+    return false;
+  }
+  return (format != ExportFormat::Y4M || writeAll(FRAME_HEADER, sizeof(FRAME_HEADER) - 1)) &&
+         writeAll(frame.y.data(), frame.y.size()) && writeAll(frame.u.data(), frame.u.size()) &&
+         writeAll(frame.v.data(), frame.v.size());
+}
+
+bool FrameServerSink::close() {
+  if (!file) {
+    return true;
+  }
+  bool closed;
+  if (file == stdout) {
+    closed = std::fflush(file) == 0;
+    std::lock_guard<std::mutex> lock(sinksMutex);
+    streamingToStdout = false;
+  } else {
+    closed = std::fclose(file) == 0;
+  }
+  file = nullptr;
+#ifndef _WIN32
+  restoreSigpipe();
+#endif
+  if (!closed && lastError.empty()) {
+    lastError = "Could not finish " + destination + ": " + std::strerror(errno);
+  }
+  return closed;
+}
+
+bool FrameServerSink::openDestination() {
+#ifndef _WIN32
+  // Opening a named pipe to write blocks until it has a reader, so wait
+  // for one without blocking, to notice a cancel
+  struct stat info;
+  if (stat(destination.c_str(), &info) == 0 && S_ISFIFO(info.st_mode)) {
+    int fd;
+    while ((fd = ::open(destination.c_str(), O_WRONLY | O_NONBLOCK)) < 0 &&
+           (errno == ENXIO || errno == EINTR)) {
+      if (monitor && monitor->isCancelled()) {
+        lastError = "Export cancelled";
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MILLISECONDS));
+    }
+    if (fd >= 0) {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+      file = fdopen(fd, "wb");
+      if (!file) {
+        ::close(fd);
+      }
+    }
+  } else {
+    file = std::fopen(destination.c_str(), "wb");
+  }
+#else
+  file = std::fopen(destination.c_str(), "wb");
+#endif
+  if (!file) {
+    lastError = "Could not open " + destination + ": " + std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+bool FrameServerSink::writeAll(const void* data, size_t size) {
+#ifdef _WIN32
+  if (std::fwrite(data, 1, size, file) != size) {
+    lastError = std::strerror(errno);
+    return false;
+  }
+  return true;
+#else
+  // Straight to the file, from the frame. A pipe is written PIPE_BUF bytes
+  // at a time once it has room, which never blocks, so a reader that
+  // stops reading can't keep a cancelled export waiting.
+  const int fd = fileno(file);
+  const char* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    if (pipe) {
+      struct pollfd ready;
+      ready.fd = fd;
+      ready.events = POLLOUT;
+      ready.revents = 0;
+      int polled = poll(&ready, 1, WAIT_MILLISECONDS);
+      if (monitor && monitor->isCancelled()) {
+        lastError = "Export cancelled";
+        return false;
+      }
+      if (polled <= 0) {
+        if (polled < 0 && errno != EINTR) {
+          lastError = std::strerror(errno);
+          return false;
+        }
+        continue;
+      }
+    }
+    ssize_t written = ::write(fd, bytes, pipe ? std::min<size_t>(size, PIPE_BUF) : size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      lastError = std::strerror(errno);
+      return false;
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+#endif
+}
+
+} // namespace csci3081
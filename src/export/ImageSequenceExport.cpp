@@ -0,0 +1,187 @@
+#include "export/ImageSequenceExport.h"
+#include "export/ExportMonitor.h"
+#include "export/FrameServerSink.h"
+#include "export/ImageWriter.h"
+#include "compositor/Blend.h"
+#include "timeline/Timeline.h"
+#include "util/BoundedQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace csci3081 {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * @brief A rendered frame waiting to be written
+ */
+struct RenderedFrame {
+  Image* image;
+  int64_t frame;
+};
+
+} // namespace
+
+ImageSequenceExport::ImageSequenceExport(int workerCount, int queueCapacity)
+  : workerCount(workerCount > 0 ? workerCount : getDefaultWorkerCount()),
+    queueCapacity(queueCapacity > 0 ? queueCapacity : 1), monitor(nullptr) {}
+
+int ImageSequenceExport::getDefaultWorkerCount() {
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+std::string ImageSequenceExport::getFrameFilename(const std::string& filename, int64_t frame) {
+  char number[32];
+  std::snprintf(number, sizeof(number), "_%06lld", static_cast<long long>(frame));
+
+  // Only a dot after the last directory separator starts the extension
+  size_t dot = filename.find_last_of('.');
+  size_t slash = filename.find_last_of("/\\");
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    return filename + number;
+  }
+  return filename.substr(0, dot) + number + filename.substr(dot);
+}
+
+bool ImageSequenceExport::run(const Timeline& timeline, int width, int height,
+                              const Rational& rate, const std::string& filename,
+                              const ExportSettings& settings) {
+  stats = SequenceStats();
+  lastError = "";
+  Clock::time_point started = Clock::now();
+
+  if (settings.format == ExportFormat::MP4 || FrameServerSink::isStreamFormat(settings.format)) {
+    lastError = "Image sequences need an image format";
+    return false;
+  }
+  if (width <= 0 || height <= 0 || rate.num <= 0 || rate.den <= 0) {
+    lastError = "Invalid frame size or rate";
+    return false;
+  }
+  const int64_t frameCount = ExportPipeline::getFrameCount(timeline, rate);
+  if (frameCount <= 0) {
+    lastError = "Timeline has no duration (empty or no tracks)";
+    return false;
+  }
+
+  // Every worker holds a frame while it writes, the queue holds the rest
+  // and one more lets rendering run ahead of them
+  const int workers = static_cast<int>(std::min<int64_t>(workerCount, frameCount));
+  const int buffers = queueCapacity + workers + 1;
+  std::vector<std::unique_ptr<Image> > images;
+  BoundedQueue<Image*> freeImages(buffers);
+  BoundedQueue<RenderedFrame> rendered(queueCapacity);
+  for (int i = 0; i < buffers; i++) {
+    images.emplace_back(new Image(width, height));
+    freeImages.push(images.back().get());
+  }
+  stats.workers = workers;
+  stats.frameBuffers = buffers;
+
+  // The first failure stops everything; frames already queued are dropped.
+  // Each frame is written by one worker, so each flag has one writer.
+  std::vector<char> written(static_cast<size_t>(frameCount), 0);
+  std::atomic<bool> failed(false);
+  std::mutex mutex;
+  std::string error;
+  std::vector<std::thread> threads;
+  for (int w = 0; w < workers; w++) {
+    threads.emplace_back([&]() {
+      StageStats mine;
+      RenderedFrame work;
+      while (!failed && rendered.pop(work)) {
+        Clock::time_point working = Clock::now();
+        Image& image = *work.image;
+        if (formatKeepsAlpha(settings.format)) {
+          unpremultiplySpan(image.getData(), image.getData(), width * height);
+        }
+        std::string name = getFrameFilename(filename, work.frame);
+        std::string why;
+        if (!writeImageFile(image, name, settings, why)) {
+          std::remove(name.c_str());   // Whatever part of it was written
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!failed) {
+            error = "Failed to write " + name + ": " + why;
+            failed = true;
+          }
+          freeImages.close();
+          rendered.close();
+          break;
+        }
+        written[work.frame] = 1;
+        freeImages.push(work.image);
+        mine.busySeconds += secondsSince(working);
+        mine.frames++;
+        if (monitor) {
+          monitor->addFrames(1);
+        }
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      stats.encode.frames += mine.frames;
+      stats.encode.busySeconds += mine.busySeconds;
+    });
+  }
+
+  // Render in order on this thread
+  bool cancelled = false;
+  for (int64_t i = 0; i < frameCount && !failed; i++) {
+    if (monitor && monitor->isCancelled()) {
+      cancelled = true;
+      break;
+    }
+    Clock::time_point waiting = Clock::now();
+    Image* image;
+    if (!freeImages.pop(image)) {
+      break;
+    }
+    Clock::time_point working = Clock::now();
+    stats.render.waitSeconds += std::chrono::duration<double>(working - waiting).count();
+
+    timeline.renderFrameInto(ticksToSeconds(frameToTicks(i, rate)), *image);
+    stats.render.busySeconds += secondsSince(working);
+    stats.render.frames++;
+
+    waiting = Clock::now();
+    RenderedFrame work = {image, i};
+    if (!rendered.push(work)) {
+      break;
+    }
+    stats.render.waitSeconds += secondsSince(waiting);
+  }
+  rendered.close();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  stats.elapsedSeconds = secondsSince(started);
+  if (failed) {
+    lastError = error;
+  } else if (cancelled) {
+    lastError = "Export cancelled";
+  }
+  const bool complete = !failed && !cancelled && stats.encode.frames == frameCount;
+
+  // Like a video that fails, an unfinished sequence leaves nothing behind
+  if (!complete) {
+    for (int64_t i = 0; i < frameCount; i++) {
+      if (written[i]) {
+        std::remove(getFrameFilename(filename, i).c_str());
+      }
+    }
+  }
+  return complete;
+}
+
+} // namespace csci3081
@@ -0,0 +1,70 @@
+#include "export/ImageWriter.h"
+#include "export/PngEncoder.h"
+
+// STB image write for multiple formats
+#include "stb_image_write.h"
+
+namespace csci3081 {
+
+bool formatKeepsAlpha(ExportFormat format) {
+  // PNG and TGA (written for PPM) keep the alpha channel and expect it straight
+  return format == ExportFormat::PNG || format == ExportFormat::PPM;
+}
+
+bool writeImageFile(const Image& image, const std::string& filename,
+                    const ExportSettings& settings, std::string& error) {
+  int width = image.getWidth();
+  int height = image.getHeight();
+  const unsigned char* data = image.getData();
+
+  // Components is always 4 (RGBA) for our Image class
+  int components = 4;
+
+  int result = 0;
+
+  switch (settings.format) {
+    case ExportFormat::PNG:
+      // Not stbi_write_png(): it reads its level and filter from globals
+      result = writePng(image, filename, settings.png) ? 1 : 0;
+      break;
+
+    case ExportFormat::JPEG:
+      // JPEG doesn't support alpha, so we'd need to convert to RGB
+      // For now, just write with alpha (STB will ignore it)
+      result = stbi_write_jpg(filename.c_str(), width, height, components, data,
+                              settings.quality);
+      break;
+
+    case ExportFormat::BMP:
+      result = stbi_write_bmp(filename.c_str(), width, height, components, data);
+      break;
+
+    case ExportFormat::PPM:
+      // PPM is not directly supported by STB, but we can use TGA instead
+      // Or implement custom PPM writer
+      result = stbi_write_tga(filename.c_str(), width, height, components, data);
+      break;
+
+    case ExportFormat::MP4:
+      error = "Use exportVideo() for MP4 format";
+      return false;
+
+    case ExportFormat::Y4M:
+    case ExportFormat::RAW:
+      error = "Use exportTimeline() for Y4M and raw streams";
+      return false;
+
+    default:
+      error = "Unknown export format";
+      return false;
+  }
+
+  if (result == 0) {
+    error = "Failed to write image file (disk full or permission denied)";
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace csci3081
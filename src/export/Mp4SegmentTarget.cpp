@@ -0,0 +1,80 @@
+#include "export/Mp4SegmentTarget.h"
+#include "export/VideoWriterSink.h"
+#include "video_writer.hpp"
+#include <cstdio>
+
+namespace csci3081 {
+
+Mp4SegmentTarget::Mp4SegmentTarget(const std::string& filename,
+                                   const EncoderSettings& settings)
+  : filename(filename), settings(settings), keepParts(false) {}
+
+Mp4SegmentTarget::~Mp4SegmentTarget() {
+  if (!keepParts) {
+    removeParts();
+  }
+}
+
+std::string Mp4SegmentTarget::getPartPath(const ExportSegment& segment) const {
+  return filename + ".part" + std::to_string(segment.index) + ".mp4";
+}
+
+bool Mp4SegmentTarget::hasSegment(const ExportSegment& segment) const {
+  FILE* file = std::fopen(getPartPath(segment).c_str(), "rb");
+  if (file) {
+    std::fclose(file);
+  }
+  return file != nullptr;
+}
+
+IFrameSink* Mp4SegmentTarget::createSegmentSink(const ExportSegment& segment) {
+  parts.push_back(getPartPath(segment));
+  return new VideoWriterSink(parts.back(), settings);
+}
+
+bool Mp4SegmentTarget::concatenate(const std::vector<ExportSegment>& segments,
+                                   const Rational& rate) {
+  lastError = "";
+  std::vector<std::string> paths;
+  for (const ExportSegment& segment : segments) {
+    paths.push_back(segment.isPassthrough() ? segment.sourcePath : getPartPath(segment));
+  }
+
+  // Rendered parts are copied whole; passthrough segments are a run of
+  // frames of their source
+  std::vector<VideoWriterPiece> pieces;
+  for (size_t i = 0; i < segments.size(); i++) {
+    VideoWriterPiece piece;
+    piece.filename = paths[i].c_str();
+    piece.first_frame = segments[i].isPassthrough() ? segments[i].sourceFirstFrame : 0;
+    piece.frame_count = segments[i].frameCount;
+    piece.output_frame = segments[i].firstFrame;
+    pieces.push_back(piece);
+  }
+
+  bool joined = video_writer_concat(filename.c_str(), pieces.data(),
+                                    static_cast<int>(pieces.size()),
+                                    static_cast<int>(rate.num), static_cast<int>(rate.den));
+  if (!joined) {
+    lastError = "Failed to join segments into " + filename;
+  }
+  if (joined || !keepParts) {
+    // Parts resumed from an earlier export were not created by this target
+    for (const ExportSegment& segment : segments) {
+      if (!segment.isPassthrough()) {
+        std::remove(getPartPath(segment).c_str());
+      }
+    }
+    parts.clear();
+  }
+  return joined;
+}
+
+void Mp4SegmentTarget::removeParts() {
+  for (const std::string& part : parts) {
+    std::remove(part.c_str());
+  }
+  parts.clear();
+}
+
+} // namespace csci3081
@@ -0,0 +1,250 @@
+#include "export/PngEncoder.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// stb's deflater; its implementation is compiled with the rest of stb in Image.cpp
+#include "stb_image_write.h"
+STBIWDEF unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len,
+                                           int quality);
+
+namespace csci3081 {
+
+namespace {
+
+const int BYTES_PER_PIXEL = 4;
+
+/**
+ * @brief CRC-32 lookup table, as used by PNG chunks
+ */
+struct CrcTable {
+  uint32_t entries[256];
+
+  CrcTable() {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      entries[n] = c;
+    }
+  }
+};
+
+uint32_t crc32(const unsigned char* data, size_t length) {
+  static const CrcTable table;
+  uint32_t c = 0xFFFFFFFFu;
+  for (size_t i = 0; i < length; i++) {
+    c = table.entries[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+  }
+  return c ^ 0xFFFFFFFFu;
+}
+
+void putBigEndian(std::vector<unsigned char>& out, uint32_t value) {
+  out.push_back(static_cast<unsigned char>(value >> 24));
+  out.push_back(static_cast<unsigned char>(value >> 16));
+  out.push_back(static_cast<unsigned char>(value >> 8));
+  out.push_back(static_cast<unsigned char>(value));
+}
+
+/**
+ * @brief Append a chunk: length, type, data and the CRC of type and data
+ */
+void putChunk(std::vector<unsigned char>& out, const char* type, const unsigned char* data,
+              size_t length) {
+  putBigEndian(out, static_cast<uint32_t>(length));
+  size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data, data + length);
+  putBigEndian(out, crc32(&out[start], length + 4));
+}
+
+unsigned char paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = std::abs(p - a);
+  int pb = std::abs(p - b);
+  int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return static_cast<unsigned char>(a);
+  }
+  return static_cast<unsigned char>(pb <= pc ? b : c);
+}
+
+/**
+ * @brief Filter one row
+ * @param type PNG filter type, 0 (none) to 4 (Paeth)
+ * @param row The row's pixels
+ * @param above The row above, all zeros for the first row
+ * @param length Bytes in a row
+ * @param out Receives the filtered bytes
+ */
+void filterRow(int type, const unsigned char* row, const unsigned char* above, int length,
+               unsigned char* out) {
+  const int n = BYTES_PER_PIXEL;
+  switch (type) {
+    case 0:
+      std::memcpy(out, row, length);
+      break;
+    case 1:
+      std::memcpy(out, row, n);
+      for (int i = n; i < length; i++) {
+        out[i] = static_cast<unsigned char>(row[i] - row[i - n]);
+      }
+      break;
+    case 2:
+      for (int i = 0; i < length; i++) {
+        out[i] = static_cast<unsigned char>(row[i] - above[i]);
+      }
+      break;
+    case 3:
+      for (int i = 0; i < n; i++) {
+        out[i] = static_cast<unsigned char>(row[i] - (above[i] >> 1));
+      }
+      for (int i = n; i < length; i++) {
+        out[i] = static_cast<unsigned char>(row[i] - ((row[i - n] + above[i]) >> 1));
+      }
+      break;
+    case 4:
+      for (int i = 0; i < n; i++) {
+        out[i] = static_cast<unsigned char>(row[i] - paeth(0, above[i], 0));
+      }
+      for (int i = n; i < length; i++) {
+        out[i] = static_cast<unsigned char>(row[i] - paeth(row[i - n], above[i], above[i - n]));
+      }
+      break;
+  }
+}
+
+/**
+ * @brief Estimate how well a filtered row compresses; smaller is better
+ */
+int costOf(const unsigned char* filtered, int length) {
+  int cost = 0;
+  for (int i = 0; i < length; i++) {
+    cost += std::abs(static_cast<signed char>(filtered[i]));
+  }
+  return cost;
+}
+
+uint32_t adler32(const unsigned char* data, size_t length) {
+  uint32_t a = 1;
+  uint32_t b = 0;
+  while (length > 0) {
+    // Largest run before b can overflow 32 bits
+    size_t run = length < 5552 ? length : 5552;
+    length -= run;
+    while (run-- > 0) {
+      a += *data++;
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+/**
+ * @brief Wrap data in a zlib stream of uncompressed deflate blocks
+ */
+void storeZlib(const std::vector<unsigned char>& data, std::vector<unsigned char>& out) {
+  const size_t MAX_BLOCK = 65535;
+  out.reserve(out.size() + data.size() + (data.size() / MAX_BLOCK + 1) * 5 + 6);
+  out.push_back(0x78);   // Deflate, 32K window
+  out.push_back(0x01);   // Fastest compression, header check bits
+  size_t offset = 0;
+  do {
+    size_t length = data.size() - offset < MAX_BLOCK ? data.size() - offset : MAX_BLOCK;
+    out.push_back(offset + length == data.size() ? 1 : 0);   // BFINAL, BTYPE 0 (stored)
+    out.push_back(static_cast<unsigned char>(length));
+    out.push_back(static_cast<unsigned char>(length >> 8));
+    out.push_back(static_cast<unsigned char>(~length));
+    out.push_back(static_cast<unsigned char>(~length >> 8));
+    out.insert(out.end(), data.begin() + offset, data.begin() + offset + length);
+    offset += length;
+  } while (offset < data.size());
+  putBigEndian(out, adler32(data.data(), data.size()));
+}
+
+} // namespace
+
+bool encodePng(const Image& image, const PngSettings& settings, std::vector<unsigned char>& png) {
+  const int width = image.getWidth();
+  const int height = image.getHeight();
+  png.clear();
+  if (width <= 0 || height <= 0 || !image.getData()) {
+    return false;
+  }
+
+  // Each row is its filter type followed by the filtered bytes
+  const int rowBytes = width * BYTES_PER_PIXEL;
+  std::vector<unsigned char> filtered(static_cast<size_t>(rowBytes + 1) * height);
+  std::vector<unsigned char> zeros(rowBytes, 0);
+  std::vector<unsigned char> trial(rowBytes);
+  const int fixedType = static_cast<int>(settings.filter) - static_cast<int>(PngFilter::NONE);
+  for (int y = 0; y < height; y++) {
+    const unsigned char* row = image.getData() + static_cast<size_t>(y) * rowBytes;
+    const unsigned char* above = y > 0 ? row - rowBytes : zeros.data();
+    unsigned char* out = &filtered[static_cast<size_t>(y) * (rowBytes + 1)];
+    int type = fixedType;
+    if (settings.filter == PngFilter::ADAPTIVE) {
+      int best = -1;
+      for (int candidate = 0; candidate <= 4; candidate++) {
+        filterRow(candidate, row, above, rowBytes, trial.data());
+        int cost = costOf(trial.data(), rowBytes);
+        if (best < 0 || cost < best) {
+          best = cost;
+          type = candidate;
+        }
+      }
+    }
+    out[0] = static_cast<unsigned char>(type);
+    filterRow(type, row, above, rowBytes, out + 1);
+  }
+
+  std::vector<unsigned char> idat;
+  if (settings.compressionLevel <= 0) {
+    storeZlib(filtered, idat);
+  } else {
+    int length = 0;
+    unsigned char* zlib = stbi_zlib_compress(filtered.data(), static_cast<int>(filtered.size()),
+                                             &length, settings.compressionLevel);
+    if (!zlib) {
+      return false;
+    }
+    idat.assign(zlib, zlib + length);
+    std::free(zlib);
+  }
+
+  static const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  png.reserve(idat.size() + 57);
+  png.insert(png.end(), signature, signature + 8);
+
+  std::vector<unsigned char> header;
+  putBigEndian(header, static_cast<uint32_t>(width));
+  putBigEndian(header, static_cast<uint32_t>(height));
+  header.push_back(8);   // Bits per sample
+  header.push_back(6);   // RGBA
+  header.push_back(0);   // Deflate
+  header.push_back(0);   // Adaptive filtering
+  header.push_back(0);   // Not interlaced
+  putChunk(png, "IHDR", header.data(), header.size());
+  putChunk(png, "IDAT", idat.data(), idat.size());
+  putChunk(png, "IEND", nullptr, 0);
+  return true;
+}
+
+bool writePng(const Image& image, const std::string& filename, const PngSettings& settings) {
+  std::vector<unsigned char> png;
+  if (!encodePng(image, settings, png)) {
+    return false;
+  }
+  FILE* file = std::fopen(filename.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  bool written = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+  return std::fclose(file) == 0 && written;
+}
+
+} // namespace csci3081
@@ -0,0 +1,296 @@
+#include "export/SegmentCache.h"
+#include "export/ExportCheckpoint.h"
+#include "timeline/Timeline.h"
+#include "util/Json.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace csci3081 {
+
+namespace {
+
+const int64_t INDEX_VERSION = 1;
+
+/**
+ * @brief Get the size of a file, or -1 if it can't be opened
+ */
+int64_t fileSize(const std::string& path) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  return file ? static_cast<int64_t>(file.tellg()) : -1;
+}
+
+/**
+ * @brief Ticks before a cut that the transition out of an entry starts
+ *
+ * Transitions are centered on the cut (see Track::getTransitionAt()), so
+ * the next entry is shown this early.
+ */
+Ticks transitionLead(const TimelineEntry& entry) {
+  return entry.hasOutTransition() ? secondsToTicks(entry.getOutTransition().duration) / 2 : 0;
+}
+
+/**
+ * @brief Ticks after its end that the transition out of an entry still shows it
+ */
+Ticks transitionTail(const TimelineEntry& entry) {
+  return entry.hasOutTransition()
+             ? secondsToTicks(entry.getOutTransition().duration) - transitionLead(entry)
+             : 0;
+}
+
+/**
+ * @brief 64-bit FNV-1a hash of fields added one at a time
+ */
+struct FieldHasher {
+  uint64_t hash;
+
+  FieldHasher() : hash(14695981039346656037ull) {}
+
+  void addBytes(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+
+  template <typename T>
+  void add(const T& value) {
+    addBytes(&value, sizeof(value));
+  }
+
+  void addString(const std::string& text) {
+    add(static_cast<uint64_t>(text.size()));
+    addBytes(text.data(), text.size());
+  }
+
+  void addColor(const Color& color) {
+    for (int c = 0; c < 4; c++) {
+      add(color[c]);
+    }
+  }
+
+  /**
+   * @brief Add everything about an entry that its frames show
+   * @param entry The entry
+   * @param source Its asset's source (see ExportCheckpoint::describeSource())
+   */
+  void addEntry(const TimelineEntry& entry, const std::string& source) {
+    addString(source);
+    add(entry.getStartTicks());
+    add(entry.getDurationTicks());
+    const EntryTransform& transform = entry.getTransform();
+    for (int p = 0; p < ENTRY_PROPERTY_COUNT; p++) {
+      add(transform.get(static_cast<EntryProperty>(p)));
+      const std::vector<Keyframe>& keyframes =
+          entry.getKeyframes(static_cast<EntryProperty>(p)).getKeyframes();
+      add(static_cast<uint64_t>(keyframes.size()));
+      for (const Keyframe& keyframe : keyframes) {
+        add(keyframe.time);
+        add(keyframe.value);
+        add(static_cast<int>(keyframe.interpolation));
+        add(keyframe.easeOutX);
+        add(keyframe.easeOutY);
+        add(keyframe.easeInX);
+        add(keyframe.easeInY);
+      }
+    }
+    add(entry.hasOutTransition());
+    if (entry.hasOutTransition()) {
+      const Transition& transition = entry.getOutTransition();
+      add(static_cast<int>(transition.type));
+      add(transition.duration);
+      addColor(transition.color);
+    }
+  }
+};
+
+} // namespace
+
+SegmentCache::SegmentCache(const std::string& filename)
+  : filename(filename), reusedFrames(0), moved(false) {}
+
+bool SegmentCache::load() {
+  cachedPath.clear();
+  cached.clear();
+  lastError.clear();
+
+  std::ifstream file(getIndexPath(), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  JsonValue root;
+  std::string error;
+  if (!JsonValue::parse(text, root, error) || root["version"].asInt(0) != INDEX_VERSION) {
+    return false;
+  }
+
+  // An export that stopped after moving the video aside left it there
+  const int64_t size = root["size"].asInt(-1);
+  if (size >= 0 && fileSize(getPreviousPath()) == size) {
+    cachedPath = getPreviousPath();
+  } else if (size >= 0 && fileSize(filename) == size) {
+    cachedPath = filename;
+  } else {
+    return false;
+  }
+
+  const JsonValue& segments = root["segments"];
+  for (size_t i = 0; i < segments.size(); i++) {
+    CachedSegment segment;
+    segment.firstFrame = segments[i]["firstFrame"].asInt(-1);
+    segment.frameCount = segments[i]["frameCount"].asInt(-1);
+    if (segment.firstFrame >= 0 && segment.frameCount > 0) {
+      cached[segments[i]["hash"].asString()] = segment;
+    }
+  }
+  return true;
+}
+
+int64_t SegmentCache::reuse(std::vector<ExportSegment>& plan,
+                            const std::vector<std::string>& hashes) {
+  reusedFrames = 0;
+  for (size_t i = 0; i < plan.size() && i < hashes.size(); i++) {
+    ExportSegment& segment = plan[i];
+    std::map<std::string, CachedSegment>::const_iterator found = cached.find(hashes[i]);
+    if (segment.isPassthrough() || found == cached.end() ||
+        found->second.frameCount != segment.frameCount) {
+      continue;
+    }
+    segment.sourcePath = getPreviousPath();
+    segment.sourceFirstFrame = found->second.firstFrame;
+    reusedFrames += segment.frameCount;
+  }
+  return reusedFrames;
+}
+
+bool SegmentCache::keepPrevious() {
+  if (reusedFrames == 0 || cachedPath != filename) {
+    return true;
+  }
+  std::remove(getPreviousPath().c_str());
+  if (std::rename(filename.c_str(), getPreviousPath().c_str()) != 0) {
+    lastError = "Could not move " + filename + " to " + getPreviousPath();
+    return false;
+  }
+  cachedPath = getPreviousPath();
+  moved = true;
+  return true;
+}
+
+bool SegmentCache::store(const std::vector<ExportSegment>& plan,
+                         const std::vector<std::string>& hashes) {
+  JsonValue segments = JsonValue::array();
+  for (size_t i = 0; i < plan.size() && i < hashes.size(); i++) {
+    JsonValue item = JsonValue::object();
+    item.set("hash", hashes[i]);
+    item.set("firstFrame", plan[i].firstFrame);
+    item.set("frameCount", plan[i].frameCount);
+    segments.push(item);
+  }
+  JsonValue root = JsonValue::object();
+  root.set("version", INDEX_VERSION);
+  root.set("size", fileSize(filename));
+  root.set("segments", segments);
+
+  // The last export is no longer needed, whether or not the index is written
+  if (cachedPath == getPreviousPath()) {
+    std::remove(getPreviousPath().c_str());
+  }
+  cachedPath = filename;
+  moved = false;
+
+  std::ofstream file(getIndexPath(), std::ios::binary | std::ios::trunc);
+  file << root.dump();
+  if (!file.flush()) {
+    lastError = "Could not write " + getIndexPath();
+    return false;
+  }
+  return true;
+}
+
+void SegmentCache::restore() {
+  if (moved && std::rename(getPreviousPath().c_str(), filename.c_str()) == 0) {
+    cachedPath = filename;
+    moved = false;
+  }
+}
+
+bool SegmentCache::hashSegments(const Timeline& timeline,
+                                const std::map<IAsset*, std::string>& sources,
+                                const std::vector<ExportSegment>& plan, int width, int height,
+                                const Rational& rate, const EncoderSettings& encoder,
+                                std::vector<std::string>& hashes) {
+  hashes.clear();
+  for (const Track* track : timeline.getTracks()) {
+    if (!track->getFilters().empty()) {
+      return false;
+    }
+  }
+
+  // What every segment shares: the output settings and the background
+  FieldHasher common;
+  common.addString(ExportCheckpoint::describeOutput(width, height, rate, encoder));
+  common.addColor(timeline.getBackgroundColor());
+  common.add(static_cast<int>(timeline.getCompositingMode()));
+
+  std::map<std::string, std::string> described;   // Each source, looked up once
+  const std::vector<Track*>& tracks = timeline.getTracks();
+  for (const ExportSegment& segment : plan) {
+    const Ticks first = frameToTicks(segment.firstFrame, rate);
+    const Ticks last = frameToTicks(segment.firstFrame + segment.frameCount - 1, rate);
+    FieldHasher hasher = common;
+    hasher.add(segment.firstFrame);
+    hasher.add(segment.frameCount);
+
+    for (size_t t = 0; t < tracks.size(); t++) {
+      const Track* track = tracks[t];
+      if (!track->isVisible()) {
+        continue;
+      }
+      // Entries on a track don't overlap, and a transition reaches at most
+      // one entry past a cut, so the entries shown start two before the
+      // one under the segment's first frame
+      const EntryTree& entries = track->getEntries();
+      size_t i = entries.lastStartingAt(first);
+      i = i == EntryTree::npos ? 0 : (i >= 2 ? i - 2 : 0);
+      bool trackAdded = false;
+      for (; i < entries.size(); i++) {
+        const TimelineEntry& entry = entries[i];
+        const Ticks before = i > 0 ? transitionLead(entries[i - 1]) : 0;
+        if (entry.getStartTicks() - before > last) {
+          break;   // A transition is no longer than its entries, so none later is shown
+        }
+        if (entry.getEndTicks() + transitionTail(entry) <= first) {
+          continue;
+        }
+
+        std::map<IAsset*, std::string>::const_iterator source = sources.find(entry.getAsset());
+        if (source == sources.end()) {
+          return false;
+        }
+        std::map<std::string, std::string>::iterator description =
+            described.find(source->second);
+        if (description == described.end()) {
+          description = described.insert(std::make_pair(
+              source->second, ExportCheckpoint::describeSource(source->second))).first;
+        }
+        if (!trackAdded) {
+          hasher.add(static_cast<uint64_t>(t));
+          hasher.add(static_cast<int>(track->getBlendMode()));
+          trackAdded = true;
+        }
+        hasher.addEntry(entry, description->second);
+      }
+    }
+
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hasher.hash));
+    hashes.push_back(std::string(text) + '-' + std::to_string(segment.firstFrame) + '+' +
+                     std::to_string(segment.frameCount));
+  }
+  return true;
+}
+
+} // namespace csci3081
@@ -0,0 +1,256 @@
+#include "export/SegmentedExport.h"
+#include "assets/LazyAsset.h"
+#include "export/ExportCheckpoint.h"
+#include "export/ExportMonitor.h"
+#include "timeline/Timeline.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace csci3081 {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * @brief Passes frames on to a segment's sink until any segment fails
+ */
+class StoppableSink : public IFrameSink {
+public:
+  StoppableSink(IFrameSink& sink, const std::atomic<bool>& stop) : sink(sink), stop(stop) {}
+
+  bool open(int width, int height, const Rational& rate) override {
+    return sink.open(width, height, rate);
+  }
+
+  bool writeFrame(const YuvFrame& frame) override {
+    if (stop) {
+      stopped = true;
+      return false;
+    }
+    return sink.writeFrame(frame);
+  }
+
+  bool close() override { return sink.close(); }
+
+  std::string getLastError() const override {
+    return stopped ? "stopped because another segment failed" : sink.getLastError();
+  }
+
+  YuvFormat getYuvFormat() const override { return sink.getYuvFormat(); }
+
+private:
+  IFrameSink& sink;
+  const std::atomic<bool>& stop;
+  bool stopped = false;
+};
+
+/**
+ * @brief Everything one worker thread uses
+ */
+struct Worker {
+  std::vector<std::unique_ptr<IAsset> > assets;   // Copies of the timeline's videos
+  std::shared_ptr<const Timeline> timeline;
+  ExportPipeline pipeline;
+  PipelineStats stats;                            // Summed over its segments
+};
+
+void addStage(StageStats& total, const StageStats& part) {
+  total.frames += part.frames;
+  total.busySeconds += part.busySeconds;
+  total.waitSeconds += part.waitSeconds;
+}
+
+} // namespace
+
+std::vector<ExportSegment> planSegments(int64_t frameCount, int gopSize, int maxSegments) {
+  std::vector<ExportSegment> planned;
+  if (frameCount <= 0) {
+    return planned;
+  }
+
+  const int64_t gop = std::max(gopSize, 1);
+  const int64_t gops = (frameCount + gop - 1) / gop;
+  const int64_t count = std::min<int64_t>(std::max(maxSegments, 1), gops);
+  for (int64_t i = 0; i < count; i++) {
+    int64_t first = gops * i / count * gop;
+    int64_t end = i + 1 == count ? frameCount : gops * (i + 1) / count * gop;
+    planned.push_back(ExportSegment(static_cast<int>(i), first, end - first));
+  }
+  return planned;
+}
+
+SegmentedExport::SegmentedExport(int maxSegments, int gopSize)
+  : maxSegments(maxSegments > 0 ? maxSegments : getDefaultSegmentCount()),
+    gopSize(gopSize), factory(nullptr), monitor(nullptr), checkpoint(nullptr), resumedFrames(0) {}
+
+void SegmentedExport::setAssetSources(const IAssetFactory* assetFactory,
+                                      const std::map<IAsset*, std::string>& assetSources) {
+  factory = assetFactory;
+  sources = assetSources;
+}
+
+int SegmentedExport::getDefaultSegmentCount() {
+  // Each worker keeps a render, a convert and an encode thread busy
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency() / 2));
+}
+
+int64_t SegmentedExport::getPassthroughFrames() const {
+  int64_t frames = 0;
+  for (const ExportSegment& segment : segments) {
+    if (segment.isPassthrough()) {
+      frames += segment.frameCount;
+    }
+  }
+  return frames;
+}
+
+bool SegmentedExport::findVideos(const Timeline& timeline, std::set<IAsset*>& videos) const {
+  // Workers can't share a decoder, so every video needs a source to make
+  // each worker its own copy from. Images and text are only read.
+  bool copyable = factory != nullptr;
+  for (const Track* track : timeline.getTracks()) {
+    for (size_t i = 0; i < track->getEntryCount(); i++) {
+      IAsset* asset = track->getEntry(i).getAsset();
+      if (asset && asset->isVideo() && videos.insert(asset).second) {
+        copyable = copyable && sources.count(asset) > 0;
+      }
+    }
+  }
+  return copyable;
+}
+
+bool SegmentedExport::run(const Timeline& timeline, int width, int height,
+                          const Rational& rate, ISegmentTarget& target) {
+  // A timeline rendered by one worker isn't split
+  std::set<IAsset*> videos;
+  const int segmentCount = findVideos(timeline, videos) ? maxSegments : 1;
+  return run(timeline, width, height, rate,
+             planSegments(ExportPipeline::getFrameCount(timeline, rate), gopSize, segmentCount),
+             target);
+}
+
+bool SegmentedExport::run(const Timeline& timeline, int width, int height,
+                          const Rational& rate, const std::vector<ExportSegment>& plan,
+                          ISegmentTarget& target) {
+  segments = plan;
+  resumedFrames = 0;
+  stats = PipelineStats();
+  lastError = "";
+  Clock::time_point started = Clock::now();
+
+  if (width <= 0 || height <= 0 || rate.num <= 0 || rate.den <= 0) {
+    lastError = "Invalid frame size or rate";
+    return false;
+  }
+  if (segments.empty()) {
+    lastError = "Timeline has no duration (empty or no tracks)";
+    return false;
+  }
+
+  std::set<IAsset*> videos;
+  const bool copyable = findVideos(timeline, videos);
+
+  std::vector<const ExportSegment*> rendered;
+  std::vector<std::unique_ptr<IFrameSink> > sinks;
+  for (const ExportSegment& segment : segments) {
+    if (segment.isPassthrough()) {
+      continue;
+    }
+    if (checkpoint && checkpoint->isDone(segment) && target.hasSegment(segment)) {
+      resumedFrames += segment.frameCount;
+      continue;
+    }
+    sinks.emplace_back(target.createSegmentSink(segment));
+    if (!sinks.back()) {
+      lastError = "Could not create segment " + std::to_string(segment.index) + ": " +
+                  target.getLastError();
+      return false;
+    }
+    rendered.push_back(&segment);
+  }
+
+  if (monitor) {
+    monitor->addFrames(resumedFrames);
+  }
+
+  const int workerCount =
+      copyable ? std::min<int>(maxSegments, static_cast<int>(rendered.size())) : 1;
+  std::vector<std::unique_ptr<Worker> > workers;
+  for (int i = 0; i < workerCount && !rendered.empty(); i++) {
+    std::unique_ptr<Worker> worker(new Worker());
+    std::map<IAsset*, IAsset*> replacements;
+    if (copyable) {
+      for (IAsset* video : videos) {
+        worker->assets.emplace_back(new LazyAsset(factory, sources[video], video->getDuration(),
+                                                  video->getAssetType()));
+        replacements[video] = worker->assets.back().get();
+      }
+    }
+    worker->timeline = timeline.copyWithAssets(replacements);
+    worker->pipeline.setMonitor(monitor);
+    if (workerCount > 1) {
+      // The workers already keep the cores busy
+      worker->pipeline.setConvertPool(nullptr);
+    }
+    workers.push_back(std::move(worker));
+  }
+
+  // Workers take the next segment until none are left. The first segment
+  // to fail stops the others and reports the error.
+  std::atomic<size_t> next(0);
+  std::atomic<bool> failed(false);
+  std::mutex errorMutex;
+  std::vector<std::thread> threads;
+  for (std::unique_ptr<Worker>& worker : workers) {
+    Worker* w = worker.get();
+    threads.emplace_back([&, w]() {
+      for (size_t i = next++; i < rendered.size() && !failed; i = next++) {
+        const ExportSegment& segment = *rendered[i];
+        StoppableSink sink(*sinks[i], failed);
+        bool done = w->pipeline.run(*w->timeline, width, height, rate, sink,
+                                    segment.firstFrame, segment.frameCount);
+        const PipelineStats& part = w->pipeline.getStats();
+        addStage(w->stats.render, part.render);
+        addStage(w->stats.convert, part.convert);
+        addStage(w->stats.encode, part.encode);
+        w->stats.frameBuffers = std::max(w->stats.frameBuffers, part.frameBuffers);
+        std::string error = done ? "" : w->pipeline.getLastError();
+        if (done && checkpoint && !checkpoint->markDone(segment)) {
+          error = checkpoint->getLastError();
+        }
+        if (!error.empty() && !failed.exchange(true)) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          lastError = "Segment " + std::to_string(segment.index) + " failed: " + error;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  sinks.clear();
+
+  for (const std::unique_ptr<Worker>& worker : workers) {
+    addStage(stats.render, worker->stats.render);
+    addStage(stats.convert, worker->stats.convert);
+    addStage(stats.encode, worker->stats.encode);
+    stats.frameBuffers += worker->stats.frameBuffers;
+  }
+
+  bool joined = !failed && target.concatenate(segments, rate);
+  if (!failed && !joined) {
+    lastError = "Could not join segments: " + target.getLastError();
+  }
+  if (joined && monitor) {
+    monitor->addFrames(getPassthroughFrames());
+  }
+  stats.elapsedSeconds = std::chrono::duration<double>(Clock::now() - started).count();
+  return joined;
+}
+
+} // namespace csci3081
@@ -0,0 +1,186 @@
+#include "export/SmartRender.h"
+#include "timeline/Timeline.h"
+#include <algorithm>
+
+namespace csci3081 {
+
+namespace {
+
+/**
+ * @brief Export frames showing consecutive frames of one video
+ */
+struct CopyRun {
+  IAsset* asset;
+  int64_t firstFrame;         // First export frame
+  int64_t frameCount;
+  int64_t sourceFirstFrame;   // Video frame shown on firstFrame
+};
+
+/**
+ * @brief Probes videos once each and keeps the ones an export can copy
+ */
+class SourceCache {
+public:
+  SourceCache(const std::map<IAsset*, std::string>& sources, IVideoProbe& probe, int width,
+              int height, const Rational& rate)
+    : sources(sources), probe(probe), width(width), height(height), rate(rate) {}
+
+  /**
+   * @brief Get a video's description if its frames can be copied to the output
+   * @param asset The asset
+   * @return The description, or nullptr if it has to be rendered
+   */
+  const SourceVideoInfo* find(IAsset* asset) {
+    std::map<IAsset*, SourceVideoInfo>::iterator known = probed.find(asset);
+    if (known == probed.end()) {
+      SourceVideoInfo info;
+      std::map<IAsset*, std::string>::const_iterator source = sources.find(asset);
+      if (asset->isVideo() && source != sources.end() && probe.probe(source->second, info)) {
+        info.copyable = info.copyable && info.width == width && info.height == height &&
+                        info.rate.num * rate.den == rate.num * info.rate.den &&
+                        !info.keyframes.empty();
+      } else {
+        info.copyable = false;
+      }
+      known = probed.insert(std::make_pair(asset, info)).first;
+    }
+    return known->second.copyable ? &known->second : nullptr;
+  }
+
+  const std::string& getPath(IAsset* asset) const { return sources.find(asset)->second; }
+
+private:
+  const std::map<IAsset*, std::string>& sources;
+  IVideoProbe& probe;
+  int width;
+  int height;
+  Rational rate;
+  std::map<IAsset*, SourceVideoInfo> probed;
+};
+
+/**
+ * @brief Find the video frame an export frame shows unchanged, if any
+ * @return true if the frame is exactly frame sourceFrame of asset
+ */
+bool findCopyableFrame(const Timeline& timeline, int64_t frame, const Rational& rate,
+                       SourceCache& cache, IAsset*& asset, int64_t& sourceFrame) {
+  Ticks ticks = frameToTicks(frame, rate);
+  const TimelineEntry* shown = nullptr;
+  const Track* shownTrack = nullptr;
+  for (const Track* track : timeline.getTracks()) {
+    if (!track->isVisible()) {
+      continue;
+    }
+    Track::ActiveTransition active;
+    if (track->getTransitionAt(ticksToSeconds(ticks), active)) {
+      return false;
+    }
+    size_t index = track->getEntryIndexAtTicks(ticks);
+    if (index == Track::npos) {
+      continue;
+    }
+    if (shown) {
+      return false;   // Two layers are composited
+    }
+    shown = &track->getEntry(index);
+    shownTrack = track;
+  }
+  if (!shown || !shownTrack->getFilters().empty() ||
+      shownTrack->getBlendMode() != BlendMode::NORMAL) {
+    return false;
+  }
+
+  const EntryTransform& transform = shown->getTransform();
+  if (shown->isAnimated() || !transform.fillsFrame() || transform.opacity != 1.0f) {
+    return false;
+  }
+  const SourceVideoInfo* info = cache.find(shown->getAsset());
+  if (!info) {
+    return false;
+  }
+
+  // The entry's frames line up with the export's only if it starts on one
+  int64_t startFrame = ticksToFrame(shown->getStartTicks(), rate);
+  if (frameToTicks(startFrame, rate) != shown->getStartTicks() ||
+      frame - startFrame >= info->frameCount) {
+    return false;
+  }
+  asset = shown->getAsset();
+  sourceFrame = frame - startFrame;
+  return true;
+}
+
+/**
+ * @brief Append rendered segments covering a run of frames
+ */
+void addRendered(std::vector<ExportSegment>& plan, int64_t firstFrame, int64_t frameCount,
+                 int gopSize, int maxSegments) {
+  for (ExportSegment segment : planSegments(frameCount, gopSize, maxSegments)) {
+    segment.index = static_cast<int>(plan.size());
+    segment.firstFrame += firstFrame;
+    plan.push_back(segment);
+  }
+}
+
+} // namespace
+
+std::vector<ExportSegment> planSmartRender(const Timeline& timeline, int width, int height,
+                                           const Rational& rate,
+                                           const std::map<IAsset*, std::string>& sources,
+                                           IVideoProbe& probe, int gopSize, int maxSegments) {
+  std::vector<ExportSegment> plan;
+  const int64_t frameCount = ExportPipeline::getFrameCount(timeline, rate);
+  if (frameCount <= 0) {
+    return plan;
+  }
+
+  SourceCache cache(sources, probe, width, height, rate);
+  int64_t renderFrom = 0;   // First frame not planned yet
+  CopyRun run = {nullptr, 0, 0, 0};
+  for (int64_t frame = 0; frame <= frameCount; frame++) {
+    IAsset* asset = nullptr;
+    int64_t sourceFrame = 0;
+    if (frame < frameCount) {
+      findCopyableFrame(timeline, frame, rate, cache, asset, sourceFrame);
+    }
+    if (run.frameCount > 0 && asset == run.asset &&
+        sourceFrame == run.sourceFirstFrame + run.frameCount) {
+      run.frameCount++;
+      continue;
+    }
+
+    // The run ended. Copy the whole GOPs in it: from its first keyframe
+    // to the last keyframe before its end, or to the end of the video.
+    if (run.frameCount > 0) {
+      const SourceVideoInfo& info = *cache.find(run.asset);
+      const int64_t sourceEnd = run.sourceFirstFrame + run.frameCount;
+      std::vector<int64_t>::const_iterator start =
+          std::lower_bound(info.keyframes.begin(), info.keyframes.end(), run.sourceFirstFrame);
+      std::vector<int64_t>::const_iterator end =
+          std::upper_bound(info.keyframes.begin(), info.keyframes.end(), sourceEnd);
+      if (start != info.keyframes.end()) {
+        int64_t copyStart = *start;
+        int64_t copyEnd = sourceEnd == info.frameCount ? sourceEnd
+                          : end == info.keyframes.begin() ? copyStart : *(end - 1);
+        if (copyEnd > copyStart) {
+          ExportSegment copy(0, run.firstFrame + copyStart - run.sourceFirstFrame,
+                             copyEnd - copyStart);
+          copy.sourcePath = cache.getPath(run.asset);
+          copy.sourceFirstFrame = copyStart;
+          addRendered(plan, renderFrom, copy.firstFrame - renderFrom, gopSize, maxSegments);
+          copy.index = static_cast<int>(plan.size());
+          plan.push_back(copy);
+          renderFrom = copy.firstFrame + copy.frameCount;
+        }
+      }
+    }
+    run.asset = asset;
+    run.firstFrame = frame;
+    run.frameCount = asset ? 1 : 0;
+    run.sourceFirstFrame = sourceFrame;
+  }
+  addRendered(plan, renderFrom, frameCount - renderFrom, gopSize, maxSegments);
+  return plan;
+}
+
+} // namespace csci3081
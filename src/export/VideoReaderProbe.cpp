@@ -0,0 +1,20 @@
+#include "export/VideoReaderProbe.h"
+#include "video_reader.hpp"
+
+namespace csci3081 {
+
+bool VideoReaderProbe::probe(const std::string& path, SourceVideoInfo& info) {
+  VideoStreamInfo stream;
+  if (!video_reader_probe_stream(path.c_str(), &stream)) {
+    return false;
+  }
+  info.copyable = stream.is_h264_yuv420p;
+  info.width = stream.width;
+  info.height = stream.height;
+  info.rate = Rational(stream.frame_rate.num, stream.frame_rate.den);
+  info.frameCount = stream.frame_count;
+  info.keyframes = stream.keyframes;
+  return true;
+}
+
+} // namespace csci3081
@@ -0,0 +1,117 @@
+#include "export/VideoWriterSink.h"
+#include "video_writer.hpp"
+
+namespace csci3081 {
+
+namespace {
+
+/**
+ * @brief Fill a video_writer configuration (which points into settings and passLog)
+ */
+void fillConfig(const EncoderSettings& settings, const Rational& rate, int pass,
+                const std::string& passLog, VideoWriterConfig& config) {
+  video_writer_default_config(&config, 30);
+  config.encoder = settings.codec.c_str();
+  config.fps_num = static_cast<int>(rate.num);
+  config.fps_den = static_cast<int>(rate.den);
+  config.preset = settings.preset.empty() ? NULL : settings.preset.c_str();
+  config.tune = settings.tune.empty() ? NULL : settings.tune.c_str();
+  config.threads = settings.threads;
+  config.gop_size = settings.keyframeInterval;
+  config.max_b_frames = settings.bFrames;
+  switch (settings.rateControl) {
+    case RateControl::CONSTANT_QUALITY:
+      config.rate_control = VIDEO_WRITER_CRF;
+      break;
+    case RateControl::VBR:
+      config.rate_control = VIDEO_WRITER_VBR;
+      break;
+    case RateControl::CBR:
+      config.rate_control = VIDEO_WRITER_CBR;
+      break;
+  }
+  config.crf = settings.crf;
+  config.bit_rate = settings.bitRate * static_cast<int64_t>(1000);
+  config.max_bit_rate = settings.maxBitRate * static_cast<int64_t>(1000);
+  config.pass = pass;
+  config.pass_log = passLog.empty() ? NULL : passLog.c_str();
+  config.bt709 = settings.yuvFormat.matrix == YuvMatrix::BT709;
+  config.full_range = settings.yuvFormat.range == YuvRange::FULL;
+}
+
+} // namespace
+
+VideoWriterSink::VideoWriterSink(const std::string& filename, const EncoderSettings& settings)
+  : filename(filename), settings(settings), pass(0), writer(new VideoWriterState()),
+    opened(false) {}
+
+VideoWriterSink::~VideoWriterSink() {
+  if (opened) {
+    close();
+  }
+  delete writer;
+}
+
+void VideoWriterSink::setPass(int pass, const std::string& logPath) {
+  this->pass = pass;
+  passLog = logPath;
+}
+
+bool VideoWriterSink::open(int width, int height, const Rational& rate) {
+  lastError = "";
+  VideoWriterConfig config;
+  fillConfig(settings, rate, pass, passLog, config);
+  if (!video_writer_open_config(writer, filename.c_str(), width, height, &config)) {
+    lastError = "Failed to open video writer for " + filename;
+    return false;
+  }
+  opened = true;
+  return true;
+}
+
+bool VideoWriterSink::writeFrame(const YuvFrame& frame) {
+  const uint8_t* planes[3] = {frame.y.data(), frame.u.data(), frame.v.data()};
+  int linesizes[3] = {frame.width, frame.getChromaWidth(), frame.getChromaWidth()};
+  if (!video_writer_write_yuv_frame(writer, planes, linesizes)) {
+    lastError = "Encoder rejected the frame";
+    return false;
+  }
+  return true;
+}
+
+bool VideoWriterSink::close() {
+  if (!opened) {
+    return false;
+  }
+  video_writer_close(writer);
+  opened = false;
+  return true;
+}
+
+bool VideoWriterSink::checkSettings(const EncoderSettings& settings, int width, int height,
+                                    const Rational& rate, std::string& error) {
+  if (!settings.check(error)) {
+    return false;
+  }
+  // Any statistics file will do to check a two-pass configuration
+  const std::string passLog = settings.twoPass ? "check" : "";
+  VideoWriterConfig config;
+  std::string problem;
+  fillConfig(settings, rate, settings.twoPass ? 1 : 0, passLog, config);
+  if (!video_writer_check_config(&config, width, height, &problem)) {
+    error = "Unsupported encoder settings: " + problem;
+    return false;
+  }
+  return true;
+}
+
+std::string VideoWriterSink::getEncoderFormat(const std::string& codec) {
+  const char* format = video_writer_encoder_format(codec.c_str());
+  return format ? format : "";
+}
+
+std::vector<std::string> VideoWriterSink::getAvailableEncoders() {
+  return video_writer_list_encoders();
+}
+
+} // namespace csci3081
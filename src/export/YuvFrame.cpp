@@ -0,0 +1,258 @@
+#include "export/YuvFrame.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace csci3081 {
+
+namespace {
+
+/**
+ * @brief Fixed-point weights of a YuvFormat
+ *
+ * Luma is (yr * r + yg * g + yb * b + yOffset) >> 15. Chroma is the same
+ * on the sums of 2x2 blocks (up to 4 * 255) with cOffset, shifted by 17.
+ * The weights of each row are rounded to add up exactly, so greys have no
+ * chroma and white is exactly full scale. Every product fits 16 x 16 bits
+ * into 32, which the vector path relies on.
+ */
+struct Weights {
+  int yr, yg, yb, yOffset;
+  int ur, ug, ub;
+  int vr, vg, vb;
+  int cOffset;
+};
+
+Weights weightsFor(const YuvFormat& format) {
+  const double kr = format.matrix == YuvMatrix::BT709 ? 0.2126 : 0.299;
+  const double kb = format.matrix == YuvMatrix::BT709 ? 0.0722 : 0.114;
+  const bool limited = format.range == YuvRange::LIMITED;
+  const double lumaScale = (limited ? 219.0 / 255.0 : 1.0) * 32768.0;
+  const double chromaScale = (limited ? 224.0 / 255.0 : 1.0) * 32768.0;
+
+  Weights w;
+  w.yr = static_cast<int>(std::lround(kr * lumaScale));
+  w.yb = static_cast<int>(std::lround(kb * lumaScale));
+  w.yg = static_cast<int>(std::lround(lumaScale)) - w.yr - w.yb;
+  w.yOffset = ((limited ? 16 : 0) << 15) + (1 << 14);
+
+  w.ub = static_cast<int>(std::lround(0.5 * chromaScale));
+  w.ur = static_cast<int>(std::lround(-0.5 * kr / (1.0 - kb) * chromaScale));
+  w.ug = -w.ur - w.ub;
+  w.vr = w.ub;
+  w.vb = static_cast<int>(std::lround(-0.5 * kb / (1.0 - kr) * chromaScale));
+  w.vg = -w.vr - w.vb;
+  w.cOffset = (128 << 17) + (1 << 16);
+  return w;
+}
+
+// Full-range chroma of pure blue and red rounds to 256
+inline uint8_t clampByte(int value) {
+  return static_cast<uint8_t>(std::min(value, 255));
+}
+
+inline uint8_t lumaOf(const Weights& w, int r, int g, int b) {
+  return clampByte((w.yr * r + w.yg * g + w.yb * b + w.yOffset) >> 15);
+}
+
+// r, g and b are sums over a 2x2 block
+inline uint8_t blueDifferenceOf(const Weights& w, int r, int g, int b) {
+  return clampByte((w.ur * r + w.ug * g + w.ub * b + w.cOffset) >> 17);
+}
+
+inline uint8_t redDifferenceOf(const Weights& w, int r, int g, int b) {
+  return clampByte((w.vr * r + w.vg * g + w.vb * b + w.cOffset) >> 17);
+}
+
+#if defined(__SSE2__)
+// Red, green and blue of 8 RGBA pixels as 16-bit lanes
+inline void loadRgb(const unsigned char* pixels, __m128i& r, __m128i& g, __m128i& b) {
+  const __m128i mask = _mm_set1_epi32(0xFF);
+  __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+  __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 16));
+  r = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+  g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), mask),
+                      _mm_and_si128(_mm_srli_epi32(hi, 8), mask));
+  b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), mask),
+                      _mm_and_si128(_mm_srli_epi32(hi, 16), mask));
+}
+
+// Two 16-bit weights, a in the low half, for _mm_madd_epi16
+inline __m128i weightPair(int a, int b) {
+  return _mm_set1_epi32(static_cast<int>((static_cast<unsigned>(b) << 16) |
+                                         (static_cast<unsigned>(a) & 0xFFFF)));
+}
+
+// (wr * r + wg * g + wb * b + offset) >> Shift on 8 lanes
+template <int Shift>
+inline __m128i weigh(__m128i r, __m128i g, __m128i b, __m128i rg, __m128i b0, __m128i offset) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r, g), rg),
+                             _mm_madd_epi16(_mm_unpacklo_epi16(b, zero), b0));
+  __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r, g), rg),
+                             _mm_madd_epi16(_mm_unpackhi_epi16(b, zero), b0));
+  return _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(lo, offset), Shift),
+                         _mm_srai_epi32(_mm_add_epi32(hi, offset), Shift));
+}
+
+// Sums of horizontal pairs of two rows' 16 lanes, as 8 lanes
+inline __m128i blockSums(__m128i top0, __m128i top1, __m128i bottom0, __m128i bottom1) {
+  const __m128i ones = _mm_set1_epi16(1);
+  return _mm_packs_epi32(_mm_madd_epi16(_mm_add_epi16(top0, bottom0), ones),
+                         _mm_madd_epi16(_mm_add_epi16(top1, bottom1), ones));
+}
+#endif
+
+/**
+ * @brief One conversion, shared by the threads converting its bands
+ */
+struct Conversion {
+  const unsigned char* pixels;
+  int width;
+  int height;
+  uint8_t* planes[3];
+  int strides[3];
+  Weights weights;
+  int pairsPerBand;   // Pairs of rows each band converts
+};
+
+void convertRowPair(const Conversion& c, int row) {
+  const Weights& w = c.weights;
+  const int width = c.width;
+  const unsigned char* top = c.pixels + static_cast<size_t>(row) * width * 4;
+  // An odd last row pairs with itself
+  const unsigned char* bottom = row + 1 < c.height ? top + width * 4 : top;
+  uint8_t* lumaTop = c.planes[0] + static_cast<size_t>(row) * c.strides[0];
+  uint8_t* lumaBottom = row + 1 < c.height ? lumaTop + c.strides[0] : nullptr;
+  uint8_t* u = c.planes[1] + static_cast<size_t>(row / 2) * c.strides[1];
+  uint8_t* v = c.planes[2] + static_cast<size_t>(row / 2) * c.strides[2];
+
+  int x = 0;
+#if defined(__SSE2__)
+  if (lumaBottom) {
+    const __m128i yRg = weightPair(w.yr, w.yg);
+    const __m128i yB = weightPair(w.yb, 0);
+    const __m128i yOffset = _mm_set1_epi32(w.yOffset);
+    const __m128i uRg = weightPair(w.ur, w.ug);
+    const __m128i uB = weightPair(w.ub, 0);
+    const __m128i vRg = weightPair(w.vr, w.vg);
+    const __m128i vB = weightPair(w.vb, 0);
+    const __m128i cOffset = _mm_set1_epi32(w.cOffset);
+
+    for (; x + 16 <= width; x += 16) {
+      __m128i r0, g0, b0, r1, g1, b1, r2, g2, b2, r3, g3, b3;
+      loadRgb(top + x * 4, r0, g0, b0);
+      loadRgb(top + x * 4 + 32, r1, g1, b1);
+      loadRgb(bottom + x * 4, r2, g2, b2);
+      loadRgb(bottom + x * 4 + 32, r3, g3, b3);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(lumaTop + x),
+                       _mm_packus_epi16(weigh<15>(r0, g0, b0, yRg, yB, yOffset),
+                                        weigh<15>(r1, g1, b1, yRg, yB, yOffset)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(lumaBottom + x),
+                       _mm_packus_epi16(weigh<15>(r2, g2, b2, yRg, yB, yOffset),
+                                        weigh<15>(r3, g3, b3, yRg, yB, yOffset)));
+
+      __m128i r = blockSums(r0, r1, r2, r3);
+      __m128i g = blockSums(g0, g1, g2, g3);
+      __m128i b = blockSums(b0, b1, b2, b3);
+      __m128i uv = _mm_packus_epi16(weigh<17>(r, g, b, uRg, uB, cOffset),
+                                    weigh<17>(r, g, b, vRg, vB, cOffset));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2), uv);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2), _mm_srli_si128(uv, 8));
+    }
+  }
+#endif
+
+  for (; x < width; x += 2) {
+    // An odd last column pairs with itself
+    int next = x + 1 < width ? 4 : 0;
+    const unsigned char* a = top + x * 4;
+    const unsigned char* b = bottom + x * 4;
+
+    lumaTop[x] = lumaOf(w, a[0], a[1], a[2]);
+    if (next) {
+      lumaTop[x + 1] = lumaOf(w, a[next], a[next + 1], a[next + 2]);
+    }
+    if (lumaBottom) {
+      lumaBottom[x] = lumaOf(w, b[0], b[1], b[2]);
+      if (next) {
+        lumaBottom[x + 1] = lumaOf(w, b[next], b[next + 1], b[next + 2]);
+      }
+    }
+
+    int r = a[0] + a[next] + b[0] + b[next];
+    int g = a[1] + a[next + 1] + b[1] + b[next + 1];
+    int bl = a[2] + a[next + 2] + b[2] + b[next + 2];
+    u[x / 2] = blueDifferenceOf(w, r, g, bl);
+    v[x / 2] = redDifferenceOf(w, r, g, bl);
+  }
+}
+
+void convertBand(void* context, int band) {
+  const Conversion& c = *static_cast<const Conversion*>(context);
+  const int pairs = (c.height + 1) / 2;
+  const int end = std::min(pairs, (band + 1) * c.pairsPerBand);
+  for (int pair = band * c.pairsPerBand; pair < end; pair++) {
+    convertRowPair(c, pair * 2);
+  }
+}
+
+} // namespace
+
+void YuvFrame::resize(int newWidth, int newHeight) {
+  if (newWidth == width && newHeight == height) {
+    return;
+  }
+  width = newWidth;
+  height = newHeight;
+  y.assign(static_cast<size_t>(width) * height, 0);
+  u.assign(static_cast<size_t>(getChromaWidth()) * getChromaHeight(), 128);
+  v.assign(u.size(), 128);
+}
+
+void convertToYuv420(const Image& image, YuvFrame& frame) {
+  convertToYuv420(image, frame, YuvFormat(), nullptr);
+}
+
+void convertToYuv420(const Image& image, YuvFrame& frame, const YuvFormat& format,
+                     ThreadPool* pool) {
+  frame.resize(image.getWidth(), image.getHeight());
+  if (frame.width <= 0 || frame.height <= 0) {
+    return;
+  }
+
+  Conversion c;
+  c.pixels = image.getData();
+  c.width = frame.width;
+  c.height = frame.height;
+  c.planes[0] = frame.y.data();
+  c.planes[1] = frame.u.data();
+  c.planes[2] = frame.v.data();
+  c.strides[0] = frame.width;
+  c.strides[1] = frame.getChromaWidth();
+  c.strides[2] = frame.getChromaWidth();
+  c.weights = weightsFor(format);
+
+  // A few bands per thread even out uneven threads; small frames aren't
+  // worth waking them for
+  const int pairs = (frame.height + 1) / 2;
+  int bands = 1;
+  if (pool && pool->getThreadCount() > 0) {
+    bands = std::max(1, std::min(pairs / 16, (pool->getThreadCount() + 1) * 2));
+  }
+  c.pairsPerBand = (pairs + bands - 1) / bands;
+  bands = (pairs + c.pairsPerBand - 1) / c.pairsPerBand;
+  if (bands == 1) {
+    convertBand(&c, 0);
+  } else {
+    pool->parallelFor(bands, convertBand, &c);
+  }
+}
+
+} // namespace csci3081
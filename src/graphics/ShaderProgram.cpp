@@ -78,16 +78,31 @@ void ShaderProgram::use() const {
     glUseProgram(shaderProgram);
 }
 
+void ShaderProgram::setInt(const std::string& name, int value) const {
+    int loc = glGetUniformLocation(shaderProgram, name.c_str());
+    glUniform1i(loc, value);
+}
+
 void ShaderProgram::setFloat(const std::string& name, float value) const {
     int loc = glGetUniformLocation(shaderProgram, name.c_str());
     glUniform1f(loc, value);
 }
 
+void ShaderProgram::setVec2(const std::string& name, float x, float y) const {
+    int loc = glGetUniformLocation(shaderProgram, name.c_str());
+    glUniform2f(loc, x, y);
+}
+
 void ShaderProgram::setVec3(const std::string& name, float x, float y, float z) const {
     int loc = glGetUniformLocation(shaderProgram, name.c_str());
     glUniform3f(loc, x, y, z);
 }
 
+void ShaderProgram::setVec4(const std::string& name, float x, float y, float z, float w) const {
+    int loc = glGetUniformLocation(shaderProgram, name.c_str());
+    glUniform4f(loc, x, y, z, w);
+}
+
 void ShaderProgram::setTexture(const std::string& name, const Texture& texture, int index) const {
     glActiveTexture(GL_TEXTURE0 + index);
     texture.use();
@@ -112,4 +127,107 @@ void ShaderProgram::setTextures(const std::string& name, const std::vector<Textu
     glUniform1i(texSizeLoc, texArray.size());
 }
 
-}
\ No newline at end of file
+TrackShader::TrackShader(const std::string& shaderDirectory)
+    : paramTexture(0), trackCount(0), nextIncomingLayer(0) {
+    vertexShaderSourceStr = load_shader_file(shaderDirectory + "quad.vsh");
+    update(std::vector<std::string>());
+
+    glGenTextures(1, &paramTexture);
+    glBindTexture(GL_TEXTURE_2D, paramTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+TrackShader::~TrackShader() {
+    glDeleteTextures(1, &paramTexture);
+}
+
+void TrackShader::update(const std::vector<std::string>& trackFilters,
+                         const std::vector<BlendMode>& blendModes) {
+    std::string source = fragmentSource(trackFilters, blendModes);
+    if (source != compiledFragmentSource) {
+        compile(vertexShaderSourceStr, source);
+        compiledFragmentSource = source;
+    }
+
+    trackCount = static_cast<int>(trackFilters.size());
+    for (size_t i = 0; i < trackFilters.size(); i++) {
+        BlendMode mode = i < blendModes.size() ? blendModes[i] : BlendMode::NORMAL;
+        param(static_cast<int>(i), PARAM_MIXING)[3] = static_cast<float>(mode);
+    }
+    layers.reserve(trackCount);
+}
+
+void TrackShader::setTrackFrame(int track, const Image& frame, const EntryTransform& transform) {
+    layers.copyToGPU(track, frame);
+    setPlacement(track, PARAM_TRANSFORM, PARAM_PLACEMENT, frame, transform);
+}
+
+void TrackShader::clearTrackFrame(int track) {
+    float* placement = param(track, PARAM_PLACEMENT);
+    placement[2] = 0.0f;
+    placement[3] = 0.0f;
+}
+
+void TrackShader::setTrackTransition(int track, const Transition& transition, double progress,
+                                     const Image& incomingFrame, const EntryTransform& incoming) {
+    int layer = trackCount + nextIncomingLayer++;
+    layers.copyToGPU(layer, incomingFrame);
+    setPlacement(track, PARAM_INCOMING_TRANSFORM, PARAM_INCOMING_PLACEMENT, incomingFrame, incoming);
+
+    float* mixing = param(track, PARAM_MIXING);
+    mixing[0] = static_cast<float>(transition.type) + 1.0f;
+    mixing[1] = static_cast<float>(progress);
+    mixing[2] = static_cast<float>(layer);
+    float* color = param(track, PARAM_TRANSITION_COLOR);
+    color[0] = transition.color.red() / 255.0f;
+    color[1] = transition.color.green() / 255.0f;
+    color[2] = transition.color.blue() / 255.0f;
+}
+
+void TrackShader::clearTrackTransition(int track) {
+    param(track, PARAM_MIXING)[0] = 0.0f;
+}
+
+void TrackShader::bindLayers() {
+    int rows = std::max<int>(params.size() / (PARAM_COUNT * 4), 1);
+    params.resize(rows * PARAM_COUNT * 4, 0.0f);
+
+    glActiveTexture(GL_TEXTURE0);
+    layers.use();
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, paramTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, PARAM_COUNT, rows, 0, GL_RGBA, GL_FLOAT, params.data());
+    glActiveTexture(GL_TEXTURE0);
+
+    setInt("layers", 0);
+    setInt("trackParams", 1);
+    setInt("trackCount", trackCount);
+    setVec2("layersSize", std::max(layers.getWidth(), 1), std::max(layers.getHeight(), 1));
+
+    nextIncomingLayer = 0;
+}
+
+float* TrackShader::param(int track, Param p) {
+    size_t offset = (static_cast<size_t>(track) * PARAM_COUNT + p) * 4;
+    if (offset >= params.size()) {
+        params.resize((static_cast<size_t>(track) + 1) * PARAM_COUNT * 4, 0.0f);
+    }
+    return &params[offset];
+}
+
+void TrackShader::setPlacement(int track, Param transformParam, Param placementParam,
+                               const Image& frame, const EntryTransform& transform) {
+    float* placement = param(track, transformParam);
+    placement[0] = transform.positionX;
+    placement[1] = transform.positionY;
+    placement[2] = transform.scaleX;
+    placement[3] = transform.scaleY;
+    placement = param(track, placementParam);
+    placement[0] = transform.rotation * 3.14159265f / 180.0f;
+    placement[1] = transform.opacity;
+    placement[2] = static_cast<float>(frame.getWidth());
+    placement[3] = static_cast<float>(frame.getHeight());
+}
+
+}
@@ -0,0 +1,86 @@
+#include "graphics/TextureArray.h"
+
+// Include glad graphics
+#include <glad/glad.h>
+
+#include <algorithm>
+
+namespace csci3081 {
+
+namespace {
+
+void setLayerParameters() {
+    // Frames only fill part of a layer, so shaders clamp to each frame's
+    // own edges; without mipmaps no level can mix in the unused part
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+}
+
+TextureArray::TextureArray() : width(0), height(0), layers(0), reserved(0) {
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    setLayerParameters();
+}
+
+TextureArray::~TextureArray() {
+    glDeleteTextures(1, &texture);
+}
+
+void TextureArray::use() const {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+}
+
+void TextureArray::reserve(int layerCount) {
+    reserved = std::max(reserved, layerCount);
+    if (width > 0 && layers < reserved) {
+        grow(width, height, reserved);
+    }
+}
+
+void TextureArray::copyToGPU(int layer, const Image& image) {
+    if (image.getWidth() > width || image.getHeight() > height || layer >= layers) {
+        grow(std::max(width, image.getWidth()), std::max(height, image.getHeight()),
+             std::max(reserved, std::max(layers, layer + 1)));
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, image.getWidth(), image.getHeight(), 1,
+                    GL_RGBA, GL_UNSIGNED_BYTE, image.getData());
+}
+
+void TextureArray::grow(int newWidth, int newHeight, int newLayers) {
+    unsigned int grown;
+    glGenTextures(1, &grown);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, grown);
+    setLayerParameters();
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, newWidth, newHeight, newLayers, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    // Copy the old layers on the GPU, reading each through a framebuffer
+    if (layers > 0) {
+        GLint previous;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+        unsigned int fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        for (int i = 0; i < layers; i++) {
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0, i);
+            glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, 0, 0, width, height);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previous);
+        glDeleteFramebuffers(1, &fbo);
+    }
+
+    glDeleteTextures(1, &texture);
+    texture = grown;
+    width = newWidth;
+    height = newHeight;
+    layers = newLayers;
+}
+
+}
@@ -0,0 +1,920 @@
+#include "project/ProjectFile.h"
+#include "assets/LazyAsset.h"
+#include "util/Json.h"
+#include "util/MappedFile.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+namespace csci3081 {
+
+const uint32_t ProjectFile::VERSION = 1;
+
+namespace {
+
+const char MAGIC[4] = {'V', 'E', 'D', 'P'};
+const uint32_t NO_ASSET = 0xFFFFFFFFu;
+
+// ==============================================================================
+// Enum names for JSON
+// ==============================================================================
+
+const char* const ASSET_TYPE_NAMES[] = {"image", "video", "text", "default"};
+const char* const EXPORT_FORMAT_NAMES[] = {"png", "jpeg", "bmp", "ppm", "mp4", "y4m", "raw"};
+const char* const BLEND_MODE_NAMES[] = {"normal", "add", "multiply", "screen",
+                                        "overlay", "darken", "lighten"};
+const char* const COMPOSITING_NAMES[] = {"8bit", "linear16"};
+const char* const TRANSITION_NAMES[] = {"crossfade", "wipe", "dip"};
+const char* const INTERPOLATION_NAMES[] = {"linear", "bezier", "hold"};
+const char* const PROPERTY_NAMES[] = {"positionX", "positionY", "scaleX",
+                                      "scaleY", "rotation", "opacity"};
+
+const int ASSET_TYPE_COUNT = 4;
+const int EXPORT_FORMAT_COUNT = 7;
+const int COMPOSITING_MODE_COUNT = 2;
+const int INTERPOLATION_COUNT = 3;
+
+/**
+ * @brief Look up a name in a table
+ * @return Its index, or -1 if it isn't there
+ */
+int findName(const char* const* names, int count, const std::string& name) {
+  for (int i = 0; i < count; i++) {
+    if (name == names[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// ==============================================================================
+// Decoded project
+// ==============================================================================
+
+struct DecodedTrack {
+  std::string name;
+  Color color;
+  bool visible;
+  BlendMode blendMode;
+  std::string filter;
+  std::vector<TimelineEntry> entries;
+
+  DecodedTrack() : color(0, 0, 0, 255), visible(true), blendMode(BlendMode::NORMAL) {}
+};
+
+/**
+ * @brief A project read from a file but not yet applied
+ *
+ * Owns the assets it created until it is applied, so a file that turns
+ * out to be broken part way leaves nothing behind.
+ */
+struct DecodedProject {
+  std::vector<std::string> sources;
+  std::vector<IAsset*> assets;
+  ExportSettings exportSettings;
+  Color background;
+  CompositingMode compositingMode;
+  std::vector<DecodedTrack> tracks;
+  bool applied;
+
+  DecodedProject()
+    : background(0, 0, 0, 255), compositingMode(CompositingMode::GAMMA_8BIT),
+      applied(false) {}
+
+  ~DecodedProject() {
+    if (!applied) {
+      for (IAsset* asset : assets) {
+        delete asset;
+      }
+    }
+  }
+
+  void apply(Project& project, Timeline& timeline) {
+    project.assetSources = sources;
+    project.assets = assets;
+    project.exportSettings = exportSettings;
+    project.trackFilters.clear();
+
+    timeline.clearTracks();
+    timeline.setBackgroundColor(background);
+    timeline.setCompositingMode(compositingMode);
+    for (const DecodedTrack& decoded : tracks) {
+      Track* track = timeline.getTrack(timeline.addTrack(decoded.name));
+      track->setColor(decoded.color);
+      track->setVisible(decoded.visible);
+      track->setBlendMode(decoded.blendMode);
+      // Entries were checked to be in order without overlaps
+      for (const TimelineEntry& entry : decoded.entries) {
+        track->addEntry(entry);
+      }
+      project.trackFilters.push_back(decoded.filter);
+    }
+    applied = true;
+  }
+};
+
+/**
+ * @brief Check that an entry can follow the entries before it on a track
+ * @return Empty string, or what is wrong
+ */
+std::string checkEntry(const DecodedTrack& track, size_t assetIndex, size_t assetCount,
+                       Ticks start, Ticks duration) {
+  if (assetIndex >= assetCount) {
+    return "entry refers to a missing asset";
+  }
+  if (start < 0 || duration <= 0) {
+    return "entry has a negative start or no duration";
+  }
+  if (start > INT64_MAX - duration) {
+    return "entry ends too late";
+  }
+  if (!track.entries.empty() && start < track.entries.back().getEndTicks()) {
+    return "entries overlap or are out of order";
+  }
+  return "";
+}
+
+/**
+ * @brief Check an entry's transition, and the one into it, as
+ * Track::setTransition() would
+ *
+ * A transition whose entries no longer touch (the next one was moved or
+ * removed) isn't shown, but it must still fit its own entry.
+ *
+ * @return Empty string, or what is wrong
+ */
+std::string checkTransitions(const DecodedTrack& track, const TimelineEntry& entry) {
+  if (entry.hasOutTransition()) {
+    double duration = entry.getOutTransition().duration;
+    if (!std::isfinite(duration) || duration <= 0.0 || duration / 2.0 > entry.getDuration()) {
+      return "transition is longer than its entry or has no duration";
+    }
+  }
+  if (!track.entries.empty()) {
+    const TimelineEntry& from = track.entries.back();
+    if (from.hasOutTransition() && Track::adjacent(from, entry) &&
+        !Track::canTransition(from, entry, from.getOutTransition())) {
+      return "transition is longer than the entry after it";
+    }
+  }
+  return "";
+}
+
+// Map each project asset to its index in the file
+bool indexAssets(const Project& project, const Timeline& timeline,
+                 std::unordered_map<const IAsset*, uint32_t>& indices,
+                 std::string& error) {
+  if (project.assetSources.size() != project.assets.size()) {
+    error = "Project has a different number of assets and asset sources";
+    return false;
+  }
+  for (size_t i = 0; i < project.assets.size(); i++) {
+    indices.insert(std::make_pair(project.assets[i], static_cast<uint32_t>(i)));
+  }
+  for (const Track* track : timeline.getTracks()) {
+    for (const TimelineEntry& entry : track->getEntries()) {
+      if (indices.find(entry.getAsset()) == indices.end()) {
+        error = "Track '" + track->getName() + "' uses an asset that is not in the project";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// ==============================================================================
+// Binary encoding
+// ==============================================================================
+
+/**
+ * @brief Appends little-endian values to a byte buffer
+ */
+class BinaryWriter {
+public:
+  std::string bytes;
+
+  void put8(uint8_t value) { bytes += static_cast<char>(value); }
+
+  void put32(uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+      bytes += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+  }
+
+  void put64(uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+      bytes += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+  }
+
+  void putFloat(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put32(bits);
+  }
+
+  void putDouble(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put64(bits);
+  }
+
+  void putColor(const Color& color) {
+    for (int i = 0; i < 4; i++) {
+      put8(color[i]);
+    }
+  }
+
+  void putString(const std::string& text) {
+    put32(static_cast<uint32_t>(text.size()));
+    bytes += text;
+  }
+};
+
+/**
+ * @brief Reads little-endian values from a byte range
+ *
+ * Reads past the end return zero and mark the reader as failed, so a
+ * record can be read in full and checked once.
+ */
+class BinaryReader {
+public:
+  BinaryReader(const uint8_t* data, size_t size) : data(data), size(size), pos(0), failed(false) {}
+
+  bool ok() const { return !failed; }
+  size_t remaining() const { return size - pos; }
+
+  uint8_t get8() {
+    if (!take(1)) {
+      return 0;
+    }
+    return data[pos - 1];
+  }
+
+  uint32_t get32() {
+    if (!take(4)) {
+      return 0;
+    }
+    const uint8_t* p = data + pos - 4;
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+  }
+
+  uint64_t get64() {
+    uint64_t low = get32();
+    uint64_t high = get32();
+    return low | (high << 32);
+  }
+
+  float getFloat() {
+    uint32_t bits = get32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  double getDouble() {
+    uint64_t bits = get64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  Color getColor() {
+    int r = get8();
+    int g = get8();
+    int b = get8();
+    int a = get8();
+    return Color(r, g, b, a);
+  }
+
+  std::string getString() {
+    uint32_t length = get32();
+    if (!take(length)) {
+      return std::string();
+    }
+    return std::string(reinterpret_cast<const char*>(data + pos - length), length);
+  }
+
+  /**
+   * @brief Check a count read from the file against the bytes left
+   * @param count Number of records
+   * @param minimumSize Smallest possible size of one record
+   * @return true if that many records could fit
+   */
+  bool fits(uint32_t count, size_t minimumSize) {
+    if (failed || count > remaining() / minimumSize) {
+      failed = true;
+    }
+    return !failed;
+  }
+
+private:
+  const uint8_t* data;
+  size_t size;
+  size_t pos;
+  bool failed;
+
+  bool take(size_t count) {
+    if (failed || count > size - pos) {
+      failed = true;
+      return false;
+    }
+    pos += count;
+    return true;
+  }
+};
+
+// Smallest encoded sizes, used to reject counts larger than the file
+const size_t MIN_ASSET_SIZE = 4 + 1 + 8;
+const size_t MIN_TRACK_SIZE = 4 + 4 + 1 + 1 + 4 + 4;
+const size_t MIN_ENTRY_SIZE = 4 + 8 + 8 + 6 * 4 + 1 + 1;
+const size_t KEYFRAME_SIZE = 8 + 4 + 1 + 4 * 4;
+
+void writeEntry(BinaryWriter& out, const TimelineEntry& entry, uint32_t asset) {
+  out.put32(asset);
+  out.put64(static_cast<uint64_t>(entry.getStartTicks()));
+  out.put64(static_cast<uint64_t>(entry.getDurationTicks()));
+  const EntryTransform& transform = entry.getTransform();
+  for (int p = 0; p < ENTRY_PROPERTY_COUNT; p++) {
+    out.putFloat(transform.get(static_cast<EntryProperty>(p)));
+  }
+
+  uint8_t animated = 0;
+  for (int p = 0; p < ENTRY_PROPERTY_COUNT; p++) {
+    if (entry.getKeyframes(static_cast<EntryProperty>(p)).isAnimated()) {
+      animated |= 1 << p;
+    }
+  }
+  out.put8(entry.hasOutTransition() ? 1 : 0);
+  out.put8(animated);
+
+  if (entry.hasOutTransition()) {
+    const Transition& transition = entry.getOutTransition();
+    out.put8(static_cast<uint8_t>(transition.type));
+    out.putDouble(transition.duration);
+    out.putColor(transition.color);
+  }
+  for (int p = 0; p < ENTRY_PROPERTY_COUNT; p++) {
+    if (!(animated & (1 << p))) {
+      continue;
+    }
+    const std::vector<Keyframe>& keyframes =
+        entry.getKeyframes(static_cast<EntryProperty>(p)).getKeyframes();
+    out.put32(static_cast<uint32_t>(keyframes.size()));
+    for (const Keyframe& keyframe : keyframes) {
+      out.putDouble(keyframe.time);
+      out.putFloat(keyframe.value);
+      out.put8(static_cast<uint8_t>(keyframe.interpolation));
+      out.putFloat(keyframe.easeOutX);
+      out.putFloat(keyframe.easeOutY);
+      out.putFloat(keyframe.easeInX);
+      out.putFloat(keyframe.easeInY);
+    }
+  }
+}
+
+std::string readEntry(BinaryReader& in, DecodedProject& decoded, DecodedTrack& track) {
+  uint32_t asset = in.get32();
+  Ticks start = static_cast<Ticks>(in.get64());
+  Ticks duration = static_cast<Ticks>(in.get64());
+  EntryTransform transform;
+  for (int p = 0; p < ENTRY_PROPERTY_COUNT; p++) {
+    transform.set(static_cast<EntryProperty>(p), in.getFloat());
+  }
+  uint8_t flags = in.get8();
+  uint8_t animated = in.get8();
+  if (!in.ok()) {
+    return "file is truncated";
+  }
+  std::string problem = checkEntry(track, asset, decoded.assets.size(), start, duration);
+  if (!problem.empty()) {
+    return problem;
+  }
+
+  TimelineEntry entry = TimelineEntry::fromTicks(decoded.assets[asset], start, duration);
+  entry.setTransform(transform);
+  if (flags & 1) {
+    uint8_t type = in.get8();
+    Transition transition(static_cast<TransitionType>(type), in.getDouble());
+    transition.color = in.getColor();
+    if (type >= TRANSITION_TYPE_COUNT) {
+      return "unknown transition type";
+    }
+    entry.setOutTransition(transition);
+  }
+  for (int p = 0; p < ENTRY_PROPERTY_COUNT; p++) {
+    if (!(animated & (1 << p))) {
+      continue;
+    }
+    uint32_t count = in.get32();
+    if (!in.fits(count, KEYFRAME_SIZE)) {
+      return "file is truncated";
+    }
+    KeyframeTrack keyframes;
+    for (uint32_t k = 0; k < count; k++) {
+      double time = in.getDouble();
+      Keyframe keyframe(time, in.getFloat());
+      uint8_t interpolation = in.get8();
+      if (interpolation >= INTERPOLATION_COUNT) {
+        return "unknown interpolation";
+      }
+      keyframe.interpolation = static_cast<Interpolation>(interpolation);
+      keyframe.easeOutX = in.getFloat();
+      keyframe.easeOutY = in.getFloat();
+      keyframe.easeInX = in.getFloat();
+      keyframe.easeInY = in.getFloat();
+      keyframes.setKeyframe(keyframe);
+    }
+    entry.setKeyframes(static_cast<EntryProperty>(p), keyframes);
+  }
+  if (!in.ok()) {
+    return "file is truncated";
+  }
+  problem = checkTransitions(track, entry);
+  if (!problem.empty()) {
+    return problem;
+  }
+  track.entries.push_back(entry);
+  return "";
+}
+
+// ==============================================================================
+// JSON encoding
+// ==============================================================================
+
+// Shortest decimal that reads back as the same float, so 0.85f is
+// written as 0.85 rather than 0.85000002384185791
+JsonValue floatToJson(float value) {
+  char digits[32];
+  for (int precision = 6; precision < 9; precision++) {
+    std::snprintf(digits, sizeof(digits), "%.*g", precision, value);
+    if (std::strtof(digits, nullptr) == value) {
+      return JsonValue(std::strtod(digits, nullptr));
+    }
+  }
+  return JsonValue(static_cast<double>(value));
+}
+
+JsonValue colorToJson(const Color& color) {
+  JsonValue value = JsonValue::array();
+  for (int i = 0; i < 4; i++) {
+    value.push(JsonValue(static_cast<int>(color[i])));
+  }
+  return value;
+}
+
+bool colorFromJson(const JsonValue& value, Color& color) {
+  if (value.getType() != JsonValue::Type::ARRAY || value.size() != 4) {
+    return false;
+  }
+  int channels[4];
+  for (int i = 0; i < 4; i++) {
+    int64_t channel = value[i].asInt(-1);
+    if (channel < 0 || channel > 255) {
+      return false;
+    }
+    channels[i] = static_cast<int>(channel);
+  }
+  color = Color(channels[0], channels[1], channels[2], channels[3]);
+  return true;
+}
+
+JsonValue entryToJson(const TimelineEntry& entry, uint32_t asset) {
+  JsonValue value = JsonValue::object();
+  value.set("asset", JsonValue(static_cast<int64_t>(asset)));
+  value.set("start", JsonValue(static_cast<int64_t>(entry.getStartTicks())));
+  value.set("duration", JsonValue(static_cast<int64_t>(entry.getDurationTicks())));
+
+  // Only what differs from the defaults, to keep diffs small
+  EntryTransform defaults;
+  JsonValue transform = JsonValue::object();
+  JsonValue keyframes = JsonValue::object();
+  for (int p = 0; p < ENTRY_PROPERTY_COUNT; p++) {
+    EntryProperty property = static_cast<EntryProperty>(p);
+    float field = entry.getTransform().get(property);
+    if (field != defaults.get(property)) {
+      transform.set(PROPERTY_NAMES[p], floatToJson(field));
+    }
+
+    const KeyframeTrack& track = entry.getKeyframes(property);
+    if (!track.isAnimated()) {
+      continue;
+    }
+    JsonValue list = JsonValue::array();
+    for (const Keyframe& keyframe : track.getKeyframes()) {
+      JsonValue item = JsonValue::object();
+      item.set("time", JsonValue(keyframe.time));
+      item.set("value", floatToJson(keyframe.value));
+      item.set("interpolation",
+               JsonValue(INTERPOLATION_NAMES[static_cast<int>(keyframe.interpolation)]));
+      if (keyframe.interpolation == Interpolation::BEZIER) {
+        JsonValue ease = JsonValue::array();
+        ease.push(floatToJson(keyframe.easeOutX));
+        ease.push(floatToJson(keyframe.easeOutY));
+        ease.push(floatToJson(keyframe.easeInX));
+        ease.push(floatToJson(keyframe.easeInY));
+        item.set("ease", ease);
+      }
+      list.push(item);
+    }
+    keyframes.set(PROPERTY_NAMES[p], list);
+  }
+  if (transform.size() > 0) {
+    value.set("transform", transform);
+  }
+  if (keyframes.size() > 0) {
+    value.set("keyframes", keyframes);
+  }
+
+  if (entry.hasOutTransition()) {
+    const Transition& transition = entry.getOutTransition();
+    JsonValue out = JsonValue::object();
+    out.set("type", JsonValue(TRANSITION_NAMES[static_cast<int>(transition.type)]));
+    out.set("duration", JsonValue(transition.duration));
+    out.set("color", colorToJson(transition.color));
+    value.set("transition", out);
+  }
+  return value;
+}
+
+std::string entryFromJson(const JsonValue& value, DecodedProject& decoded,
+                          DecodedTrack& track) {
+  int64_t asset = value["asset"].asInt(-1);
+  Ticks start = value["start"].asInt(-1);
+  Ticks duration = value["duration"].asInt(0);
+  std::string problem =
+      checkEntry(track, asset < 0 ? NO_ASSET : static_cast<size_t>(asset),
+                 decoded.assets.size(), start, duration);
+  if (!problem.empty()) {
+    return problem;
+  }
+
+  TimelineEntry entry = TimelineEntry::fromTicks(decoded.assets[asset], start, duration);
+  EntryTransform transform;
+  for (int p = 0; p < ENTRY_PROPERTY_COUNT; p++) {
+    EntryProperty property = static_cast<EntryProperty>(p);
+    const JsonValue& field = value["transform"][PROPERTY_NAMES[p]];
+    transform.set(property, static_cast<float>(field.asDouble(transform.get(property))));
+
+    const JsonValue& list = value["keyframes"][PROPERTY_NAMES[p]];
+    if (list.size() == 0) {
+      continue;
+    }
+    KeyframeTrack keyframes;
+    for (size_t k = 0; k < list.size(); k++) {
+      const JsonValue& item = list[k];
+      int interpolation = findName(INTERPOLATION_NAMES, INTERPOLATION_COUNT,
+                                   item["interpolation"].asString("linear"));
+      if (interpolation < 0) {
+        return "unknown interpolation '" + item["interpolation"].asString() + "'";
+      }
+      Keyframe keyframe(item["time"].asDouble(), static_cast<float>(item["value"].asDouble()),
+                        static_cast<Interpolation>(interpolation));
+      const JsonValue& ease = item["ease"];
+      keyframe.easeOutX = static_cast<float>(ease[0].asDouble(keyframe.easeOutX));
+      keyframe.easeOutY = static_cast<float>(ease[1].asDouble(keyframe.easeOutY));
+      keyframe.easeInX = static_cast<float>(ease[2].asDouble(keyframe.easeInX));
+      keyframe.easeInY = static_cast<float>(ease[3].asDouble(keyframe.easeInY));
+      keyframes.setKeyframe(keyframe);
+    }
+    entry.setKeyframes(property, keyframes);
+  }
+  entry.setTransform(transform);
+
+  const JsonValue& out = value["transition"];
+  if (!out.isNull()) {
+    int type = findName(TRANSITION_NAMES, TRANSITION_TYPE_COUNT, out["type"].asString());
+    if (type < 0) {
+      return "unknown transition type '" + out["type"].asString() + "'";
+    }
+    Transition transition(static_cast<TransitionType>(type), out["duration"].asDouble(1.0));
+    if (!out["color"].isNull() && !colorFromJson(out["color"], transition.color)) {
+      return "invalid transition color";
+    }
+    entry.setOutTransition(transition);
+  }
+  problem = checkTransitions(track, entry);
+  if (!problem.empty()) {
+    return problem;
+  }
+  track.entries.push_back(entry);
+  return "";
+}
+
+} // namespace
+
+// ==============================================================================
+// ProjectFile
+// ==============================================================================
+
+ProjectFile::ProjectFile(const IAssetFactory* factory) : factory(factory) {
+}
+
+bool ProjectFile::fail(const std::string& message) {
+  lastError = message;
+  return false;
+}
+
+bool ProjectFile::save(const std::string& path, const Project& project,
+                       const Timeline& timeline) {
+  std::string bytes;
+  if (!serialize(project, timeline, bytes)) {
+    return false;
+  }
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    return fail("Could not open " + path + " for writing");
+  }
+  file.write(bytes.data(), bytes.size());
+  if (!file) {
+    return fail("Could not write " + path);
+  }
+  return true;
+}
+
+bool ProjectFile::serialize(const Project& project, const Timeline& timeline,
+                            std::string& bytes) {
+  lastError.clear();
+  std::unordered_map<const IAsset*, uint32_t> indices;
+  if (!indexAssets(project, timeline, indices, lastError)) {
+    return false;
+  }
+
+  BinaryWriter out;
+  out.bytes.append(MAGIC, sizeof(MAGIC));
+  out.put32(VERSION);
+
+  out.put32(static_cast<uint32_t>(project.assets.size()));
+  for (size_t i = 0; i < project.assets.size(); i++) {
+    out.putString(project.assetSources[i]);
+    out.put8(static_cast<uint8_t>(project.assets[i]->getAssetType()));
+    out.putDouble(project.assets[i]->getDuration());
+  }
+
+  const ExportSettings& settings = project.exportSettings;
+  out.put8(static_cast<uint8_t>(settings.format));
+  out.put32(static_cast<uint32_t>(settings.quality));
+  out.put32(static_cast<uint32_t>(settings.width));
+  out.put32(static_cast<uint32_t>(settings.height));
+  out.putDouble(settings.frameRate);
+
+  out.putColor(timeline.getBackgroundColor());
+  out.put8(static_cast<uint8_t>(timeline.getCompositingMode()));
+
+  out.put32(static_cast<uint32_t>(timeline.getTrackCount()));
+  for (size_t t = 0; t < timeline.getTrackCount(); t++) {
+    const Track* track = timeline.getTrack(t);
+    out.putString(track->getName());
+    out.putColor(track->getColor());
+    out.put8(track->isVisible() ? 1 : 0);
+    out.put8(static_cast<uint8_t>(track->getBlendMode()));
+    out.putString(t < project.trackFilters.size() ? project.trackFilters[t] : "");
+    out.put32(static_cast<uint32_t>(track->getEntryCount()));
+    for (const TimelineEntry& entry : track->getEntries()) {
+      writeEntry(out, entry, indices[entry.getAsset()]);
+    }
+  }
+
+  bytes.swap(out.bytes);
+  return true;
+}
+
+bool ProjectFile::load(const std::string& path, Project& project, Timeline& timeline) {
+  lastError.clear();
+  MappedFile file;
+  if (!file.open(path)) {
+    return fail("Could not open " + path);
+  }
+
+  BinaryReader in(file.data(), file.size());
+  char magic[4] = {0, 0, 0, 0};
+  for (char& c : magic) {
+    c = static_cast<char>(in.get8());
+  }
+  uint32_t version = in.get32();
+  if (!in.ok() || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+    return fail(path + " is not a project file");
+  }
+  if (version == 0 || version > VERSION) {
+    return fail(path + " was saved by a newer version (format " + std::to_string(version) + ")");
+  }
+
+  DecodedProject decoded;
+  uint32_t assetCount = in.get32();
+  if (!in.fits(assetCount, MIN_ASSET_SIZE)) {
+    return fail(path + " is truncated");
+  }
+  for (uint32_t i = 0; i < assetCount; i++) {
+    std::string source = in.getString();
+    uint8_t type = in.get8();
+    double duration = in.getDouble();
+    if (!in.ok()) {
+      return fail(path + " is truncated");
+    }
+    if (type >= ASSET_TYPE_COUNT) {
+      return fail(path + ": unknown type for asset '" + source + "'");
+    }
+    decoded.sources.push_back(source);
+    decoded.assets.push_back(
+        new LazyAsset(factory, source, duration, static_cast<AssetType>(type)));
+  }
+
+  ExportSettings& settings = decoded.exportSettings;
+  uint8_t format = in.get8();
+  settings.quality = static_cast<int32_t>(in.get32());
+  settings.width = static_cast<int32_t>(in.get32());
+  settings.height = static_cast<int32_t>(in.get32());
+  settings.frameRate = in.getDouble();
+  decoded.background = in.getColor();
+  uint8_t compositing = in.get8();
+  if (format >= EXPORT_FORMAT_COUNT || compositing >= COMPOSITING_MODE_COUNT) {
+    return fail(path + ": unknown export format or compositing mode");
+  }
+  settings.format = static_cast<ExportFormat>(format);
+  decoded.compositingMode = static_cast<CompositingMode>(compositing);
+
+  uint32_t trackCount = in.get32();
+  if (!in.fits(trackCount, MIN_TRACK_SIZE)) {
+    return fail(path + " is truncated");
+  }
+  decoded.tracks.resize(trackCount);
+  for (DecodedTrack& track : decoded.tracks) {
+    track.name = in.getString();
+    track.color = in.getColor();
+    track.visible = in.get8() != 0;
+    uint8_t blend = in.get8();
+    track.filter = in.getString();
+    uint32_t entryCount = in.get32();
+    if (!in.fits(entryCount, MIN_ENTRY_SIZE)) {
+      return fail(path + " is truncated");
+    }
+    if (blend >= BLEND_MODE_COUNT) {
+      return fail(path + ": unknown blend mode on track '" + track.name + "'");
+    }
+    track.blendMode = static_cast<BlendMode>(blend);
+
+    track.entries.reserve(entryCount);
+    for (uint32_t e = 0; e < entryCount; e++) {
+      std::string problem = readEntry(in, decoded, track);
+      if (!problem.empty()) {
+        return fail(path + ", track '" + track.name + "': " + problem);
+      }
+    }
+  }
+
+  decoded.apply(project, timeline);
+  return true;
+}
+
+bool ProjectFile::exportJson(const std::string& path, const Project& project,
+                             const Timeline& timeline) {
+  lastError.clear();
+  std::unordered_map<const IAsset*, uint32_t> indices;
+  if (!indexAssets(project, timeline, indices, lastError)) {
+    return false;
+  }
+
+  JsonValue root = JsonValue::object();
+  root.set("version", JsonValue(static_cast<int64_t>(VERSION)));
+
+  JsonValue assets = JsonValue::array();
+  for (size_t i = 0; i < project.assets.size(); i++) {
+    JsonValue asset = JsonValue::object();
+    asset.set("source", JsonValue(project.assetSources[i]));
+    asset.set("type",
+              JsonValue(ASSET_TYPE_NAMES[static_cast<int>(project.assets[i]->getAssetType())]));
+    asset.set("duration", JsonValue(project.assets[i]->getDuration()));
+    assets.push(asset);
+  }
+  root.set("assets", assets);
+
+  const ExportSettings& settings = project.exportSettings;
+  JsonValue exportSettings = JsonValue::object();
+  exportSettings.set("format", JsonValue(EXPORT_FORMAT_NAMES[static_cast<int>(settings.format)]));
+  exportSettings.set("quality", JsonValue(settings.quality));
+  exportSettings.set("width", JsonValue(settings.width));
+  exportSettings.set("height", JsonValue(settings.height));
+  exportSettings.set("frameRate", JsonValue(settings.frameRate));
+  root.set("export", exportSettings);
+
+  root.set("background", colorToJson(timeline.getBackgroundColor()));
+  root.set("compositing",
+           JsonValue(COMPOSITING_NAMES[static_cast<int>(timeline.getCompositingMode())]));
+
+  JsonValue tracks = JsonValue::array();
+  for (size_t t = 0; t < timeline.getTrackCount(); t++) {
+    const Track* track = timeline.getTrack(t);
+    JsonValue value = JsonValue::object();
+    value.set("name", JsonValue(track->getName()));
+    value.set("color", colorToJson(track->getColor()));
+    value.set("visible", JsonValue(track->isVisible()));
+    value.set("blend", JsonValue(BLEND_MODE_NAMES[static_cast<int>(track->getBlendMode())]));
+    value.set("filter", JsonValue(t < project.trackFilters.size() ? project.trackFilters[t] : ""));
+    JsonValue entries = JsonValue::array();
+    for (const TimelineEntry& entry : track->getEntries()) {
+      entries.push(entryToJson(entry, indices[entry.getAsset()]));
+    }
+    value.set("entries", entries);
+    tracks.push(value);
+  }
+  root.set("tracks", tracks);
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    return fail("Could not open " + path + " for writing");
+  }
+  file << root.dump();
+  if (!file) {
+    return fail("Could not write " + path);
+  }
+  return true;
+}
+
+bool ProjectFile::importJson(const std::string& path, Project& project, Timeline& timeline) {
+  lastError.clear();
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return fail("Could not open " + path);
+  }
+  std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  JsonValue root;
+  std::string error;
+  if (!JsonValue::parse(text, root, error)) {
+    return fail(path + ": " + error);
+  }
+  int64_t version = root["version"].asInt(0);
+  if (root.getType() != JsonValue::Type::OBJECT || version <= 0) {
+    return fail(path + " is not a project file");
+  }
+  if (version > VERSION) {
+    return fail(path + " was saved by a newer version (format " + std::to_string(version) + ")");
+  }
+
+  DecodedProject decoded;
+  const JsonValue& assets = root["assets"];
+  for (size_t i = 0; i < assets.size(); i++) {
+    std::string source = assets[i]["source"].asString();
+    int type = findName(ASSET_TYPE_NAMES, ASSET_TYPE_COUNT, assets[i]["type"].asString());
+    if (type < 0) {
+      return fail(path + ": unknown type for asset '" + source + "'");
+    }
+    decoded.sources.push_back(source);
+    decoded.assets.push_back(new LazyAsset(factory, source, assets[i]["duration"].asDouble(),
+                                           static_cast<AssetType>(type)));
+  }
+
+  const JsonValue& exportSettings = root["export"];
+  ExportSettings& settings = decoded.exportSettings;
+  int format = findName(EXPORT_FORMAT_NAMES, EXPORT_FORMAT_COUNT,
+                        exportSettings["format"].asString("png"));
+  int compositing = findName(COMPOSITING_NAMES, COMPOSITING_MODE_COUNT,
+                             root["compositing"].asString("8bit"));
+  if (format < 0 || compositing < 0) {
+    return fail(path + ": unknown export format or compositing mode");
+  }
+  settings.format = static_cast<ExportFormat>(format);
+  settings.quality = static_cast<int>(exportSettings["quality"].asInt(settings.quality));
+  settings.width = static_cast<int>(exportSettings["width"].asInt(settings.width));
+  settings.height = static_cast<int>(exportSettings["height"].asInt(settings.height));
+  settings.frameRate = exportSettings["frameRate"].asDouble(settings.frameRate);
+  decoded.compositingMode = static_cast<CompositingMode>(compositing);
+  if (!root["background"].isNull() && !colorFromJson(root["background"], decoded.background)) {
+    return fail(path + ": invalid background color");
+  }
+
+  const JsonValue& tracks = root["tracks"];
+  decoded.tracks.resize(tracks.size());
+  for (size_t t = 0; t < tracks.size(); t++) {
+    const JsonValue& value = tracks[t];
+    DecodedTrack& track = decoded.tracks[t];
+    track.name = value["name"].asString("Track");
+    track.visible = value["visible"].asBool(true);
+    track.filter = value["filter"].asString();
+    int blend = findName(BLEND_MODE_NAMES, BLEND_MODE_COUNT, value["blend"].asString("normal"));
+    if (blend < 0 || (!value["color"].isNull() && !colorFromJson(value["color"], track.color))) {
+      return fail(path + ": invalid blend mode or color on track '" + track.name + "'");
+    }
+    track.blendMode = static_cast<BlendMode>(blend);
+
+    const JsonValue& entries = value["entries"];
+    track.entries.reserve(entries.size());
+    for (size_t e = 0; e < entries.size(); e++) {
+      std::string problem = entryFromJson(entries[e], decoded, track);
+      if (!problem.empty()) {
+        return fail(path + ", track '" + track.name + "': " + problem);
+      }
+    }
+  }
+
+  decoded.apply(project, timeline);
+  return true;
+}
+
+} // namespace csci3081
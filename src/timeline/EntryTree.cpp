@@ -0,0 +1,317 @@
+#include "timeline/EntryTree.h"
+
+namespace csci3081 {
+
+const size_t EntryTree::npos = static_cast<size_t>(-1);
+
+EntryTree::EntryTree() : root(nullptr), seed(2463534242u) {
+}
+
+EntryTree::EntryTree(const EntryTree& other) : root(other.root), seed(other.seed) {
+  // Shared nodes must never need pushing, since either tree may be read
+  // at any time
+  settle(root);
+  if (root) {
+    root->references++;
+  }
+}
+
+EntryTree::~EntryTree() {
+  release(root);
+}
+
+size_t EntryTree::size() const {
+  return sizeOf(root);
+}
+
+const TimelineEntry& EntryTree::operator[](size_t index) const {
+  return nodeAt(index)->entry;
+}
+
+TimelineEntry& EntryTree::at(size_t index) {
+  return ownNodeAt(index)->entry;
+}
+
+const TimelineEntry& EntryTree::back() const {
+  return nodeAt(size() - 1)->entry;
+}
+
+size_t EntryTree::insert(const TimelineEntry& entry) {
+  return attach(new Node(entry, nextPriority()));
+}
+
+void EntryTree::erase(size_t index) {
+  release(detach(index));
+}
+
+void EntryTree::clear() {
+  release(root);
+  root = nullptr;
+}
+
+size_t EntryTree::move(size_t index, Ticks start) {
+  Node* node = detach(index);
+  node->entry.setStartTicks(start);
+  return attach(node);
+}
+
+void EntryTree::shift(size_t index, Ticks offset) {
+  if (offset == 0 || index >= size()) {
+    return;
+  }
+
+  // Only the root of the shifted part is updated now; its tag reaches the
+  // other entries as they are visited
+  Node* first;
+  Node* rest;
+  splitIndex(root, index, first, rest);
+  rest->entry.setStartTicks(rest->entry.getStartTicks() + offset);
+  rest->offset += offset;
+  rest->pending = true;
+  root = merge(first, rest);
+}
+
+size_t EntryTree::countStartingBefore(Ticks time) const {
+  size_t count = 0;
+  Node* node = root;
+  while (node) {
+    push(node);
+    if (node->entry.getStartTicks() < time) {
+      count += sizeOf(node->left) + 1;
+      node = node->right;
+    } else {
+      node = node->left;
+    }
+  }
+  return count;
+}
+
+size_t EntryTree::lastStartingAt(Ticks time) const {
+  size_t count = 0;
+  Node* node = root;
+  while (node) {
+    push(node);
+    if (node->entry.getStartTicks() <= time) {
+      count += sizeOf(node->left) + 1;
+      node = node->right;
+    } else {
+      node = node->left;
+    }
+  }
+  return count == 0 ? npos : count - 1;
+}
+
+EntryTree::const_iterator EntryTree::begin() const {
+  const_iterator it;
+  it.descendLeft(root);
+  return it;
+}
+
+const TimelineEntry& EntryTree::const_iterator::operator*() const {
+  return path.back()->entry;
+}
+
+EntryTree::const_iterator& EntryTree::const_iterator::operator++() {
+  Node* node = path.back();
+  path.pop_back();
+  descendLeft(node->right);
+  return *this;
+}
+
+void EntryTree::const_iterator::descendLeft(Node* node) {
+  while (node) {
+    push(node);
+    path.push_back(node);
+    node = node->left;
+  }
+}
+
+uint32_t EntryTree::nextPriority() {
+  // xorshift32: priorities only need to look random to keep the tree
+  // balanced, and a fixed seed keeps runs reproducible
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+void EntryTree::push(Node* node) {
+  // Only nodes owned by one tree carry offsets, but their children may be
+  // shared
+  if (node->offset == 0) {
+    return;
+  }
+  Node** children[2] = {&node->left, &node->right};
+  for (Node** child : children) {
+    if (*child) {
+      Node* owned = own(*child);
+      owned->entry.setStartTicks(owned->entry.getStartTicks() + node->offset);
+      owned->offset += node->offset;
+      owned->pending = true;
+      *child = owned;
+    }
+  }
+  node->offset = 0;
+}
+
+void EntryTree::update(Node* node) {
+  node->size = sizeOf(node->left) + sizeOf(node->right) + 1;
+  node->pending = node->offset != 0 || (node->left && node->left->pending) ||
+                  (node->right && node->right->pending);
+}
+
+void EntryTree::settle(Node* node) {
+  if (!node || !node->pending) {
+    return;
+  }
+  push(node);
+  settle(node->left);
+  settle(node->right);
+  node->pending = false;
+}
+
+void EntryTree::release(Node* node) {
+  if (node && --node->references == 0) {
+    release(node->left);
+    release(node->right);
+    delete node;
+  }
+}
+
+EntryTree::Node* EntryTree::own(Node* node) {
+  if (node->references.load() == 1) {
+    return node;
+  }
+
+  // The copy takes this tree's reference; the children gain a parent
+  Node* copy = new Node(node->entry, node->priority);
+  copy->offset = node->offset;
+  copy->size = node->size;
+  copy->pending = node->pending;
+  copy->left = node->left;
+  copy->right = node->right;
+  if (copy->left) {
+    copy->left->references++;
+  }
+  if (copy->right) {
+    copy->right->references++;
+  }
+  release(node);
+  return copy;
+}
+
+void EntryTree::splitAfter(Node* node, Ticks start, Node*& upTo, Node*& rest) {
+  if (!node) {
+    upTo = rest = nullptr;
+    return;
+  }
+  node = own(node);
+  push(node);
+  if (node->entry.getStartTicks() <= start) {
+    splitAfter(node->right, start, node->right, rest);
+    upTo = node;
+  } else {
+    splitAfter(node->left, start, upTo, node->left);
+    rest = node;
+  }
+  update(node);
+}
+
+void EntryTree::splitIndex(Node* node, size_t count, Node*& first, Node*& rest) {
+  if (!node) {
+    first = rest = nullptr;
+    return;
+  }
+  node = own(node);
+  push(node);
+  size_t leftSize = sizeOf(node->left);
+  if (leftSize < count) {
+    splitIndex(node->right, count - leftSize - 1, node->right, rest);
+    first = node;
+  } else {
+    splitIndex(node->left, count, first, node->left);
+    rest = node;
+  }
+  update(node);
+}
+
+EntryTree::Node* EntryTree::merge(Node* first, Node* second) {
+  if (!first) {
+    return second;
+  }
+  if (!second) {
+    return first;
+  }
+  if (first->priority > second->priority) {
+    first = own(first);
+    push(first);
+    first->right = merge(first->right, second);
+    update(first);
+    return first;
+  }
+  second = own(second);
+  push(second);
+  second->left = merge(first, second->left);
+  update(second);
+  return second;
+}
+
+EntryTree::Node* EntryTree::nodeAt(size_t index) const {
+  Node* node = root;
+  while (node) {
+    push(node);
+    size_t leftSize = sizeOf(node->left);
+    if (index < leftSize) {
+      node = node->left;
+    } else if (index == leftSize) {
+      return node;
+    } else {
+      index -= leftSize + 1;
+      node = node->right;
+    }
+  }
+  return nullptr;
+}
+
+EntryTree::Node* EntryTree::ownNodeAt(size_t index) {
+  // Copy shared nodes from the root down, so the node returned is only
+  // reachable from this tree
+  Node** slot = &root;
+  while (*slot) {
+    Node* node = own(*slot);
+    *slot = node;
+    push(node);
+    size_t leftSize = sizeOf(node->left);
+    if (index < leftSize) {
+      slot = &node->left;
+    } else if (index == leftSize) {
+      return node;
+    } else {
+      index -= leftSize + 1;
+      slot = &node->right;
+    }
+  }
+  return nullptr;
+}
+
+EntryTree::Node* EntryTree::detach(size_t index) {
+  Node* first;
+  Node* middle;
+  Node* rest;
+  Node* last;
+  splitIndex(root, index, first, rest);
+  splitIndex(rest, 1, middle, last);
+  root = merge(first, last);
+  return middle;
+}
+
+size_t EntryTree::attach(Node* node) {
+  Node* upTo;
+  Node* rest;
+  splitAfter(root, node->entry.getStartTicks(), upTo, rest);
+  size_t index = sizeOf(upTo);
+  root = merge(merge(upTo, node), rest);
+  return index;
+}
+
+} // namespace csci3081
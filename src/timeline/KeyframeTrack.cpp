@@ -0,0 +1,126 @@
+#include "timeline/KeyframeTrack.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace csci3081 {
+
+namespace {
+
+bool keyframeBefore(const Keyframe& keyframe, double time) {
+  return keyframe.time < time;
+}
+
+bool timeBefore(double time, const Keyframe& keyframe) {
+  return time < keyframe.time;
+}
+
+// One coordinate of a cubic bezier from 0 to 1 with control points p1, p2
+float bezierAt(float p1, float p2, float s) {
+  float is = 1.0f - s;
+  return 3.0f * is * is * s * p1 + 3.0f * is * s * s * p2 + s * s * s;
+}
+
+float bezierSlope(float p1, float p2, float s) {
+  float is = 1.0f - s;
+  return 3.0f * is * is * p1 + 6.0f * is * s * (p2 - p1) +
+         3.0f * s * s * (1.0f - p2);
+}
+
+/**
+ * @brief Map normalized time through a cubic-bezier easing curve
+ *
+ * Solves x(s) = t for the curve parameter s (Newton's method, falling back
+ * to bisection where the slope is flat), then returns y(s).
+ */
+float easeBezier(const Keyframe& k, float t) {
+  float x1 = std::max(0.0f, std::min(k.easeOutX, 1.0f));
+  float x2 = std::max(0.0f, std::min(k.easeInX, 1.0f));
+
+  float s = t;
+  for (int i = 0; i < 8; i++) {
+    float error = bezierAt(x1, x2, s) - t;
+    if (std::fabs(error) < 1e-5f) {
+      return bezierAt(k.easeOutY, k.easeInY, s);
+    }
+    float slope = bezierSlope(x1, x2, s);
+    if (std::fabs(slope) < 1e-6f) {
+      break;
+    }
+    s -= error / slope;
+  }
+
+  // x(s) is monotonic for control points in [0,1], so bisection converges
+  float lo = 0.0f;
+  float hi = 1.0f;
+  s = t;
+  for (int i = 0; i < 32; i++) {
+    float x = bezierAt(x1, x2, s);
+    if (std::fabs(x - t) < 1e-5f) {
+      break;
+    }
+    if (x < t) {
+      lo = s;
+    } else {
+      hi = s;
+    }
+    s = 0.5f * (lo + hi);
+  }
+  return bezierAt(k.easeOutY, k.easeInY, s);
+}
+
+} // namespace
+
+void KeyframeTrack::setKeyframe(const Keyframe& keyframe) {
+  std::vector<Keyframe>::iterator it = std::lower_bound(
+      keyframes.begin(), keyframes.end(), keyframe.time, keyframeBefore);
+
+  if (it != keyframes.end() && it->time == keyframe.time) {
+    *it = keyframe;
+  } else {
+    keyframes.insert(it, keyframe);
+  }
+}
+
+bool KeyframeTrack::removeKeyframe(size_t index) {
+  if (index >= keyframes.size()) {
+    return false;
+  }
+
+  keyframes.erase(keyframes.begin() + index);
+  return true;
+}
+
+float KeyframeTrack::evaluate(double time, float defaultValue) const {
+  if (keyframes.empty()) {
+    return defaultValue;
+  }
+  if (time <= keyframes.front().time) {
+    return keyframes.front().value;
+  }
+  if (time >= keyframes.back().time) {
+    return keyframes.back().value;
+  }
+
+  // First keyframe after time; the segment starts one before it
+  std::vector<Keyframe>::const_iterator next = std::upper_bound(
+      keyframes.begin(), keyframes.end(), time, timeBefore);
+  const Keyframe& from = *(next - 1);
+  const Keyframe& to = *next;
+
+  float t = static_cast<float>((time - from.time) / (to.time - from.time));
+
+  switch (from.interpolation) {
+    case Interpolation::HOLD:
+      return from.value;
+    case Interpolation::BEZIER:
+      t = easeBezier(from, t);
+      break;
+    case Interpolation::LINEAR:
+      break;
+  }
+
+  return from.value + (to.value - from.value) * t;
+}
+
+} // namespace csci3081
@@ -0,0 +1,105 @@
+#include "timeline/Timebase.h"
+#include <cmath>
+
+namespace csci3081 {
+
+namespace {
+
+#if !defined(__SIZEOF_INT128__)
+// Divide, rounding as requested (div > 0)
+int64_t divide(int64_t value, int64_t div, Rounding rounding) {
+  int64_t quotient = value / div;
+  int64_t remainder = value % div;
+  if (remainder == 0) {
+    return quotient;
+  }
+  switch (rounding) {
+    case Rounding::DOWN:
+      return remainder < 0 ? quotient - 1 : quotient;
+    case Rounding::UP:
+      return remainder > 0 ? quotient + 1 : quotient;
+    case Rounding::NEAREST:
+      if (remainder > 0) {
+        return 2 * remainder >= div ? quotient + 1 : quotient;
+      }
+      return -2 * remainder >= div ? quotient - 1 : quotient;
+  }
+  return quotient;
+}
+#endif
+
+} // namespace
+
+int64_t rescale(int64_t value, int64_t mul, int64_t div, Rounding rounding) {
+  if (div < 0) {
+    div = -div;
+    mul = -mul;
+  }
+#if defined(__SIZEOF_INT128__)
+  __int128 product = static_cast<__int128>(value) * mul;
+  __int128 quotient = product / div;
+  __int128 remainder = product % div;
+  if (remainder != 0) {
+    switch (rounding) {
+      case Rounding::DOWN:
+        if (remainder < 0) quotient--;
+        break;
+      case Rounding::UP:
+        if (remainder > 0) quotient++;
+        break;
+      case Rounding::NEAREST:
+        if (remainder > 0 && 2 * remainder >= div) quotient++;
+        if (remainder < 0 && -2 * remainder >= div) quotient--;
+        break;
+    }
+  }
+  return static_cast<int64_t>(quotient);
+#else
+  // value = q * div + r, so value * mul / div = q * mul + r * mul / div;
+  // r * mul fits in 64 bits while div and mul stay below 2^31
+  int64_t quotient = value / div;
+  int64_t remainder = value % div;
+  return quotient * mul + divide(remainder * mul, div, rounding);
+#endif
+}
+
+Ticks secondsToTicks(double seconds) {
+  return static_cast<Ticks>(std::llround(seconds * TICKS_PER_SECOND));
+}
+
+double ticksToSeconds(Ticks ticks) {
+  return static_cast<double>(ticks) / TICKS_PER_SECOND;
+}
+
+Ticks timestampToTicks(int64_t timestamp, const Rational& timeBase) {
+  return rescale(timestamp, timeBase.num * TICKS_PER_SECOND, timeBase.den);
+}
+
+int64_t ticksToTimestamp(Ticks ticks, const Rational& timeBase, Rounding rounding) {
+  return rescale(ticks, timeBase.den, timeBase.num * TICKS_PER_SECOND, rounding);
+}
+
+Ticks frameToTicks(int64_t frame, const Rational& rate) {
+  return rescale(frame, rate.den * TICKS_PER_SECOND, rate.num, Rounding::UP);
+}
+
+int64_t ticksToFrame(Ticks ticks, const Rational& rate) {
+  return rescale(ticks, rate.num, rate.den * TICKS_PER_SECOND, Rounding::DOWN);
+}
+
+Rational rateFromDouble(double fps) {
+  double whole = std::round(fps);
+  if (std::fabs(fps - whole) < 1e-6) {
+    return Rational(static_cast<int64_t>(whole), 1);
+  }
+
+  // 30000/1001 is printed as 29.97, so allow for the rounding
+  double ntsc = std::round(fps * 1.001);
+  if (std::fabs(fps - ntsc / 1.001) < 5e-3) {
+    return Rational(static_cast<int64_t>(ntsc) * 1000, 1001);
+  }
+
+  return Rational(static_cast<int64_t>(std::llround(fps * 1000.0)), 1000);
+}
+
+} // namespace csci3081
@@ -1,16 +1,79 @@
 #include "timeline/Timeline.h"
+#include "compositor/RenderNodes.h"
+#include "util/ThreadPool.h"
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 
 namespace csci3081 {
 
-Timeline::Timeline() : currentTime(0.0) {
+const double Timeline::PREFETCH_LEAD = 0.5;
+
+namespace {
+
+// Entries sampled per track per frame (both sides of a transition)
+const size_t MAX_DECODES_PER_TRACK = 3;
+
+} // namespace
+
+// Dark gray makes transparent areas visible against the black UI
+Timeline::Timeline()
+  : currentTime(0.0), backgroundColor(32, 32, 32, 255),
+    compositingMode(CompositingMode::GAMMA_8BIT), revision(0),
+    totalTicks(0), durationRevision(0) {
+  revision++;   // Differ from durationRevision until computed
 }
 
 Timeline::~Timeline() {
   clearTracks();
 }
 
+std::shared_ptr<const Timeline> Timeline::snapshot() const {
+  std::shared_ptr<Timeline> copy = std::make_shared<Timeline>();
+  copy->currentTime = currentTime;
+  copy->backgroundColor = backgroundColor;
+  copy->compositingMode = compositingMode;
+
+  copy->tracks.reserve(tracks.size());
+  for (const Track* track : tracks) {
+    Track* shared = new Track(*track);
+    shared->setEditCounter(&copy->revision);
+    copy->tracks.push_back(shared);
+  }
+  copy->revision++;
+  return copy;
+}
+
+std::shared_ptr<const Timeline> Timeline::copyWithAssets(
+    const std::map<IAsset*, IAsset*>& replacements) const {
+  std::shared_ptr<Timeline> copy = std::make_shared<Timeline>();
+  copy->currentTime = currentTime;
+  copy->backgroundColor = backgroundColor;
+  copy->compositingMode = compositingMode;
+
+  copy->tracks.reserve(tracks.size());
+  for (const Track* track : tracks) {
+    Track* copied = new Track(track->getName(), track->getColor());
+    copied->setVisible(track->isVisible());
+    copied->setBlendMode(track->getBlendMode());
+    for (const std::shared_ptr<IFilter>& filter : track->getFilters()) {
+      copied->addFilter(filter);
+    }
+    for (size_t i = 0; i < track->getEntryCount(); i++) {
+      TimelineEntry entry = track->getEntry(i);
+      std::map<IAsset*, IAsset*>::const_iterator found = replacements.find(entry.getAsset());
+      if (found != replacements.end()) {
+        entry.setAsset(found->second);
+      }
+      copied->addEntry(entry);
+    }
+    copied->setEditCounter(&copy->revision);
+    copy->tracks.push_back(copied);
+  }
+  copy->revision++;
+  return copy;
+}
+
 size_t Timeline::addTrack(const std::string& name) {
   size_t index = tracks.size();
   Color trackColor = generateTrackColor(index);
@@ -21,9 +84,11 @@ size_t Timeline::addTrack(const std::string& name) {
   }
 
   Track* track = new Track(trackName, trackColor);
+  track->setEditCounter(&revision);
   tracks.push_back(track);
+  revision++;
 
-  std::cout << "Added track " << index << ": " << trackName << std::endl;
+  std::cerr << "Added track " << index << ": " << trackName << std::endl;
 
   return index;
 }
@@ -35,6 +100,7 @@ bool Timeline::removeTrack(size_t trackIndex) {
 
   delete tracks[trackIndex];
   tracks.erase(tracks.begin() + trackIndex);
+  revision++;
   return true;
 }
 
@@ -43,6 +109,7 @@ void Timeline::clearTracks() {
     delete track;
   }
   tracks.clear();
+  revision++;
 }
 
 Track* Timeline::getTrack(size_t trackIndex) {
@@ -70,27 +137,94 @@ bool Timeline::addEntryToTrack(size_t trackIndex, const TimelineEntry& entry) {
 }
 
 double Timeline::getTotalDuration() const {
-  double maxDuration = 0.0;
+  return ticksToSeconds(getTotalTicks());
+}
+
+Ticks Timeline::getTotalTicks() const {
+  // Every track edit bumps revision, so the cached value is current until
+  // something changes
+  if (durationRevision == revision) {
+    return totalTicks;
+  }
+
+  Ticks maxDuration = 0;
 
   for (const Track* track : tracks) {
-    double trackDuration = track->getTotalDuration();
+    Ticks trackDuration = track->getTotalTicks();
     if (trackDuration > maxDuration) {
       maxDuration = trackDuration;
     }
   }
 
+  totalTicks = maxDuration;
+  durationRevision = revision;
   return maxDuration;
 }
 
+void Timeline::setCompositingMode(CompositingMode mode) {
+  if (mode != compositingMode) {
+    compositingMode = mode;
+    revision++;   // The graph is built differently
+  }
+}
+
 Image* Timeline::renderFrameAt(double time, int width, int height) const {
-  // Create blank image (dark gray background to show transparency better)
   Image* result = new Image(width, height);
+  renderFrameInto(time, *result);
+  return result;
+}
+
+void Timeline::renderFrameInto(double time, Image& target) const {
+  prepareFrame(time);
+
+  // The graph only changes at cuts and edits
+  describeLayout(time, frameLayout);
+  if (frameLayout != compiledLayout) {
+    compileGraph(time);
+    compiledLayout = frameLayout;
+  }
+
+  const Image& frame = graph.evaluate(time, target.getWidth(), target.getHeight());
+  std::memcpy(target.getData(), frame.getData(),
+              static_cast<size_t>(target.getWidth()) * target.getHeight() * 4);
+}
 
-  // Fill with dark gray (makes transparent areas visible against black UI)
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      result->setPixel(x, y, Color(32, 32, 32, 255));
+void Timeline::describeLayout(double time, std::vector<uintptr_t>& layout) const {
+  layout.clear();
+  layout.push_back(revision);
+
+  for (size_t i = 0; i < tracks.size(); i++) {
+    const Track* track = tracks[i];
+    const TimelineEntry* first = nullptr;
+    const TimelineEntry* second = nullptr;
+
+    if (track->isVisible()) {
+      Track::ActiveTransition active;
+      if (track->getTransitionAt(time, active)) {
+        first = active.from;
+        second = active.to;
+      } else {
+        first = track->getEntryAt(time);
+      }
     }
+
+    layout.push_back(track->getRevision());
+    layout.push_back(reinterpret_cast<uintptr_t>(first));
+    layout.push_back(reinterpret_cast<uintptr_t>(second));
+  }
+}
+
+void Timeline::compileGraph(double time) const {
+  graph.clear();
+  std::vector<SourceNode*> sources;
+
+  // In linear light one node composites every layer into a 16-bit frame
+  LinearCompositeNode* linear = nullptr;
+  RenderNode* frame = nullptr;
+  if (compositingMode == CompositingMode::LINEAR_16BIT) {
+    linear = graph.addNode(new LinearCompositeNode(backgroundColor));
+  } else {
+    frame = graph.addNode(new BackgroundNode(backgroundColor));
   }
 
   // Composite each track in order (bottom to top)
@@ -98,69 +232,144 @@ Image* Timeline::renderFrameAt(double time, int width, int height) const {
     const Track* track = tracks[i];
 
     if (!track->isVisible()) {
-      // Uncomment for debugging:
-      // std::cout << "Track " << i << " (" << track->getName() << ") is not visible, skipping" << std::endl;
+      continue;
+    }
+
+    // Both entries are drawn while a transition is in progress
+    Track::ActiveTransition active;
+    if (track->getTransitionAt(time, active)) {
+      RenderNode* from = compileLayer(active.from, track, sources);
+      RenderNode* to = compileLayer(active.to, track, sources);
+      if (linear) {
+        linear->addTransition(from, to, active.from, active.to, track->getBlendMode());
+      } else {
+        frame = graph.addNode(new TransitionNode(frame, from, to, active.from,
+                                                 active.to, track->getBlendMode()));
+      }
       continue;
     }
 
     // Get the active entry at this time
     const TimelineEntry* entry = track->getEntryAt(time);
     if (!entry) {
-      // Uncomment for verbose debugging:
-      // std::cout << "Track " << i << " (" << track->getName() << ") has no entry at time " << time << "s" << std::endl;
       continue; // No entry active on this track at this time
     }
 
-    // Uncomment for debugging:
-    // std::cout << "Rendering track " << i << " (" << track->getName() << ") at time " << time << "s" << std::endl;
+    RenderNode* layer = compileLayer(entry, track, sources);
+    if (linear) {
+      linear->addLayer(layer, track->getBlendMode());
+    } else {
+      frame = graph.addNode(new BlendNode(frame, layer, track->getBlendMode()));
+    }
+  }
 
-    // Get the frame from the entry
-    const Image& layerImage = entry->getFrameAt(time);
+  graph.setOutput(linear ? linear : frame);
+}
 
-    //(*result) = layerImage;
-    //return result;
+RenderNode* Timeline::compileLayer(const TimelineEntry* entry, const Track* track,
+                                   std::vector<SourceNode*>& sources) const {
+  // An asset can only be decoded at one time at once
+  SourceNode* previousUse = nullptr;
+  for (size_t i = 0; i < sources.size(); i++) {
+    if (sources[i]->getEntry()->getAsset() == entry->getAsset()) {
+      previousUse = sources[i];
+    }
+  }
+  SourceNode* source = graph.addNode(new SourceNode(entry, previousUse));
+  sources.push_back(source);
 
-    // Composite this layer onto the result
-    compositeImages(*result, layerImage);
+  RenderNode* layer = source;
+  const std::vector<std::shared_ptr<IFilter> >& filters = track->getFilters();
+  for (size_t i = 0; i < filters.size(); i++) {
+    layer = graph.addNode(new FilterNode(layer, filters[i]));
   }
 
-  return result;
+  return graph.addNode(new TransformNode(layer, entry));
+}
+
+void Timeline::decodeTask(void* context, int index) {
+  const DecodeJob& job = static_cast<DecodeJob*>(context)[index];
+  job.asset->getFrame(job.localTime);
 }
 
-void Timeline::compositeImages(Image& bottom, const Image& top) const {
-  // Alpha blending composite with scaling
-  // If top and bottom are different sizes, scale the top image to fit
+void Timeline::queueDecode(IAsset* asset, double localTime, bool required) const {
+  // Only videos do real work in getFrame()
+  if (!asset || !asset->isVideo()) {
+    return;
+  }
+
+  for (size_t i = 0; i < decodeJobs.size(); i++) {
+    if (decodeJobs[i].asset != asset) {
+      continue;
+    }
+    // One asset can only be at one position at a time. If two entries need
+    // it at different times, leave it to the compositor to decode in order.
+    if (required && decodeJobs[i].localTime != localTime) {
+      decodeJobs[i].conflict = true;
+    }
+    return;
+  }
 
-  int bottomWidth = bottom.getWidth();
-  int bottomHeight = bottom.getHeight();
-  int topWidth = top.getWidth();
-  int topHeight = top.getHeight();
+  DecodeJob job;
+  job.asset = asset;
+  job.localTime = localTime;
+  job.conflict = false;
+  decodeJobs.push_back(job);
+}
 
-  // Composite with nearest-neighbor scaling
-  for (int y = 0; y < bottomHeight; y++) {
-    for (int x = 0; x < bottomWidth; x++) {
-      // Map bottom coordinates to top coordinates (scaling)
-      int topX = (x * topWidth) / bottomWidth;
-      int topY = (y * topHeight) / bottomHeight;
+void Timeline::prepareFrame(double time) const {
+  decodeJobs.clear();
+  if (decodeJobs.capacity() < tracks.size() * MAX_DECODES_PER_TRACK) {
+    decodeJobs.reserve(tracks.size() * MAX_DECODES_PER_TRACK);
+  }
 
-      // Clamp to ensure we don't go out of bounds
-      topX = std::min(topX, topWidth - 1);
-      topY = std::min(topY, topHeight - 1);
+  // Sources shown at this time
+  for (size_t i = 0; i < tracks.size(); i++) {
+    const Track* track = tracks[i];
+    if (!track->isVisible()) {
+      continue;
+    }
 
-      Color topPixel = top.getPixel(topX, topY);
-      Color bottomPixel = bottom.getPixel(x, y);
+    Track::ActiveTransition active;
+    if (track->getTransitionAt(time, active)) {
+      queueDecode(active.from->getAsset(), active.from->getLocalTime(time), true);
+      queueDecode(active.to->getAsset(), active.to->getLocalTime(time), true);
+    } else if (const TimelineEntry* entry = track->getEntryAt(time)) {
+      queueDecode(entry->getAsset(), entry->getLocalTime(time), true);
+    }
+  }
 
-      // Simple alpha blending: result = top * alpha + bottom * (1 - alpha)
-      float alpha = topPixel.alpha() / 255.0f;
+  // Sources about to be shown: position their decoders at the first frame
+  double ahead = time + PREFETCH_LEAD;
+  for (size_t i = 0; i < tracks.size(); i++) {
+    const Track* track = tracks[i];
+    if (!track->isVisible()) {
+      continue;
+    }
 
-      int r = static_cast<int>(topPixel.red()   * alpha + bottomPixel.red()   * (1 - alpha));
-      int g = static_cast<int>(topPixel.green() * alpha + bottomPixel.green() * (1 - alpha));
-      int b = static_cast<int>(topPixel.blue()  * alpha + bottomPixel.blue()  * (1 - alpha));
-      int a = 255; // Result is always opaque
+    Track::ActiveTransition active;
+    const TimelineEntry* upcoming = nullptr;
+    if (track->getTransitionAt(ahead, active)) {
+      upcoming = active.to;
+    } else {
+      upcoming = track->getEntryAt(ahead);
+    }
+    if (upcoming && upcoming->getStartTicks() > secondsToTicks(time)) {
+      queueDecode(upcoming->getAsset(), 0.0, false);
+    }
+  }
 
-      bottom.setPixel(x, y, Color(r, g, b, a));
+  // Drop assets that were claimed twice
+  size_t kept = 0;
+  for (size_t i = 0; i < decodeJobs.size(); i++) {
+    if (!decodeJobs[i].conflict) {
+      decodeJobs[kept++] = decodeJobs[i];
     }
   }
+  decodeJobs.resize(kept);
+
+  ThreadPool::shared().parallelFor(static_cast<int>(decodeJobs.size()),
+                                   decodeTask, decodeJobs.data());
 }
 
 Color Timeline::generateTrackColor(size_t index) const {
@@ -3,7 +3,62 @@
 namespace csci3081 {
 
 TimelineEntry::TimelineEntry(IAsset* asset, double startTime, double duration)
-  : asset(asset), startTime(startTime), duration(duration) {
+  : asset(asset), startTicks(secondsToTicks(startTime)),
+    durationTicks(secondsToTicks(duration)),
+    hasTransition(false), cacheValid(false), cachedTime(0.0) {
+}
+
+TimelineEntry TimelineEntry::fromTicks(IAsset* asset, Ticks start, Ticks length) {
+  TimelineEntry entry(asset, 0.0, 0.0);
+  entry.startTicks = start;
+  entry.durationTicks = length;
+  return entry;
+}
+
+void TimelineEntry::setKeyframes(EntryProperty property,
+                                 const KeyframeTrack& track) {
+  keyframes[static_cast<int>(property)] = track;
+  invalidateTransformCache();
+}
+
+void TimelineEntry::setKeyframe(EntryProperty property,
+                                const Keyframe& keyframe) {
+  keyframes[static_cast<int>(property)].setKeyframe(keyframe);
+  invalidateTransformCache();
+}
+
+bool TimelineEntry::isAnimated() const {
+  for (int i = 0; i < ENTRY_PROPERTY_COUNT; i++) {
+    if (keyframes[i].isAnimated()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const EntryTransform& TimelineEntry::getTransformAt(double globalTime) const {
+  if (cacheValid && cachedTime == globalTime) {
+    return cachedTransform;
+  }
+
+  cachedTransform = evaluateTransformAt(globalTime);
+  cachedTime = globalTime;
+  cacheValid = true;
+  return cachedTransform;
+}
+
+EntryTransform TimelineEntry::evaluateTransformAt(double globalTime) const {
+  // Keyframe times are relative to the entry, so moving it moves the animation
+  double localTime = ticksToSeconds(secondsToTicks(globalTime) - startTicks);
+
+  EntryTransform result = transform;
+  for (int i = 0; i < ENTRY_PROPERTY_COUNT; i++) {
+    if (keyframes[i].isAnimated()) {
+      EntryProperty property = static_cast<EntryProperty>(i);
+      result.set(property, keyframes[i].evaluate(localTime, transform.get(property)));
+    }
+  }
+  return result;
 }
 
 } // namespace csci3081
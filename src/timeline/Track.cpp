@@ -1,10 +1,28 @@
 #include "timeline/Track.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 
 namespace csci3081 {
 
+const size_t Track::npos = static_cast<size_t>(-1);
+
 Track::Track(const std::string& name, const Color& color)
-  : name(name), color(color), visible(true) {
+  : name(name), color(color), visible(true), blendMode(BlendMode::NORMAL),
+    revision(0), editCounter(nullptr), cursorRevision(0) {
+  cursor.index = npos;
+  cursor.entry = nullptr;
+  cursor.next = nullptr;
+}
+
+Track::Track(const Track& other)
+  : name(other.name), color(other.color), visible(other.visible),
+    blendMode(other.blendMode), entries(other.entries), filters(other.filters),
+    revision(other.revision), editCounter(nullptr), cursorRevision(0) {
+  cursor.index = npos;
+  cursor.entry = nullptr;
+  cursor.next = nullptr;
 }
 
 Track::~Track() {
@@ -12,30 +30,44 @@ Track::~Track() {
   // Assets are not owned by Track
 }
 
-bool Track::addEntry(const TimelineEntry& entry) {
-  // Check for overlap
-  if (wouldOverlap(entry)) {
+bool Track::addEntry(const TimelineEntry& entry, bool ripple) {
+  Ticks start = entry.getStartTicks();
+  if (ripple) {
+    // Entries starting at or after the new one make room; an entry that
+    // is already playing at that time can't be split
+    size_t later = entries.countStartingBefore(start);
+    if (later > 0 && entries[later - 1].getEndTicks() > start) {
+      std::cerr << "Cannot insert entry on track '" << name
+                << "': another entry is playing at that time" << std::endl;
+      return false;
+    }
+    entries.shift(later, entry.getDurationTicks());
+  } else if (wouldOverlap(start, entry.getEndTicks())) {
     std::cerr << "Cannot add entry to track '" << name
               << "': overlaps with existing entry" << std::endl;
     return false;
   }
 
-  // Add entry and sort by start time
-  entries.push_back(entry);
-  std::sort(entries.begin(), entries.end(),
-            [](const TimelineEntry& a, const TimelineEntry& b) {
-              return a.getStartTime() < b.getStartTime();
-            });
+  // Insert in start time order, after entries starting at the same time
+  entries.insert(entry);
 
+  touch();
   return true;
 }
 
-bool Track::removeEntry(size_t index) {
+bool Track::removeEntry(size_t index, bool ripple) {
   if (index >= entries.size()) {
     return false;
   }
 
-  entries.erase(entries.begin() + index);
+  Ticks duration = entries[index].getDurationTicks();
+  entries.erase(index);
+  if (ripple) {
+    // The entries after it start no earlier than its end, so moving them
+    // back by its duration keeps them clear of the entries before it
+    entries.shift(index, -duration);
+  }
+  touch();
   return true;
 }
 
@@ -49,32 +81,20 @@ bool Track::updateEntryStartTime(size_t index, double newStartTime) {
     return false;
   }
 
-  // Create a temporary entry with the new start time to test for overlaps
-  TimelineEntry& entry = entries[index];
-  double oldStartTime = entry.getStartTime();
-
-  // Temporarily update the start time
-  entry.setStartTime(newStartTime);
-
   // Check if it would overlap with other entries (excluding itself)
-  for (size_t i = 0; i < entries.size(); i++) {
-    if (i != index && entry.overlapsWith(entries[i])) {
-      // Restore old start time and return false
-      entry.setStartTime(oldStartTime);
-      return false;
-    }
+  Ticks start = secondsToTicks(newStartTime);
+  if (wouldOverlap(start, start + entries[index].getDurationTicks(), index)) {
+    return false;
   }
 
-  // No overlap, keep the new start time and re-sort
-  std::sort(entries.begin(), entries.end(),
-            [](const TimelineEntry& a, const TimelineEntry& b) {
-              return a.getStartTime() < b.getStartTime();
-            });
+  // No overlap, keep the new start time and restore the order
+  entries.move(index, start);
 
+  touch();
   return true;
 }
 
-bool Track::updateEntryDuration(size_t index, double newDuration) {
+bool Track::updateEntryDuration(size_t index, double newDuration, bool ripple) {
   if (index >= entries.size()) {
     return false;
   }
@@ -84,64 +104,210 @@ bool Track::updateEntryDuration(size_t index, double newDuration) {
     return false;
   }
 
-  TimelineEntry& entry = entries[index];
-  double oldDuration = entry.getDuration();
-
-  // Temporarily update the duration
-  entry.setDuration(newDuration);
-
   // Check if it would overlap with other entries (excluding itself)
-  for (size_t i = 0; i < entries.size(); i++) {
-    if (i != index && entry.overlapsWith(entries[i])) {
-      // Restore old duration and return false
-      entry.setDuration(oldDuration);
-      return false;
-    }
+  TimelineEntry& entry = entries.at(index);
+  Ticks duration = secondsToTicks(newDuration);
+  if (ripple) {
+    // Later entries keep their distance from this one's end
+    entries.shift(index + 1, duration - entry.getDurationTicks());
+  } else if (wouldOverlap(entry.getStartTicks(), entry.getStartTicks() + duration, index)) {
+    return false;
   }
 
   // No overlap, keep the new duration
+  entry.setDurationTicks(duration);
+  touch();
+  return true;
+}
+
+bool Track::shiftEntries(size_t index, double offset) {
+  if (index >= entries.size()) {
+    return false;
+  }
+
+  // Moving every entry from index keeps their order and spacing, so only
+  // the first one can run into anything
+  Ticks delta = secondsToTicks(offset);
+  Ticks start = entries[index].getStartTicks() + delta;
+  if (start < 0 || (index > 0 && entries[index - 1].getEndTicks() > start)) {
+    return false;
+  }
+
+  entries.shift(index, delta);
+  touch();
+  return true;
+}
+
+bool Track::updateEntryKeyframes(size_t index, EntryProperty property,
+                                 const KeyframeTrack& keyframes) {
+  if (index >= entries.size()) {
+    return false;
+  }
+
+  entries.at(index).setKeyframes(property, keyframes);
+  touch();
   return true;
 }
 
+namespace {
+
+// Entries closer than this (1ms) are treated as touching, so entries
+// placed by dragging still take transitions
+const Ticks ADJACENT_EPSILON = TICKS_PER_SECOND / 1000;
+
+} // namespace
+
+bool Track::adjacent(const TimelineEntry& from, const TimelineEntry& to) {
+  return std::llabs(to.getStartTicks() - from.getEndTicks()) < ADJACENT_EPSILON;
+}
+
+bool Track::setTransition(size_t index, const Transition& transition) {
+  if (index + 1 >= entries.size()) {
+    return false;
+  }
+
+  TimelineEntry& from = entries.at(index);
+  if (!canTransition(from, entries[index + 1], transition)) {
+    return false;
+  }
+
+  from.setOutTransition(transition);
+  touch();
+  return true;
+}
+
+bool Track::canTransition(const TimelineEntry& from, const TimelineEntry& to,
+                          const Transition& transition) {
+  // Written so that a NaN duration fails too
+  double half = transition.duration / 2.0;
+  return adjacent(from, to) && transition.duration > 0.0 &&
+         half <= from.getDuration() && half <= to.getDuration();
+}
+
+bool Track::removeTransition(size_t index) {
+  if (index >= entries.size()) {
+    return false;
+  }
+
+  entries.at(index).clearOutTransition();
+  touch();
+  return true;
+}
+
+bool Track::getTransitionAt(double time, ActiveTransition& active) const {
+  // Only the cuts at the start of the entry under time and of the next one
+  // can be close enough
+  Ticks ticks = secondsToTicks(time);
+  size_t last = entries.lastStartingAt(ticks);
+  if (last == npos) {
+    return false;   // Before the first entry, which has no cut
+  }
+  for (size_t i = std::max<size_t>(last, 1); i <= last + 1 && i < entries.size(); i++) {
+    const TimelineEntry& from = entries[i - 1];
+    const TimelineEntry& to = entries[i];
+    if (!from.hasOutTransition() || !adjacent(from, to)) {
+      continue;
+    }
+
+    // Centered on the cut
+    const Transition& transition = from.getOutTransition();
+    Ticks length = secondsToTicks(transition.duration);
+    Ticks start = to.getStartTicks() - length / 2;
+    if (ticks >= start && ticks < start + length) {
+      active.from = &from;
+      active.to = &to;
+      active.transition = &transition;
+      active.progress = static_cast<double>(ticks - start) / length;
+      return true;
+    }
+  }
+  return false;
+}
+
 void Track::clearEntries() {
   entries.clear();
+  touch();
+}
+
+void Track::addFilter(const std::shared_ptr<IFilter>& filter) {
+  filters.push_back(filter);
+  touch();
+}
+
+void Track::clearFilters() {
+  filters.clear();
+  touch();
 }
 
 const TimelineEntry* Track::getEntryAt(double time) const {
-  // Find the entry active at the given time
-  for (const TimelineEntry& entry : entries) {
-    if (entry.isActiveAt(time)) {
-      return &entry;
+  // A successful lookup leaves the cursor on the entry it found
+  size_t index = getEntryIndexAt(time);
+  return index == npos ? nullptr : cursor.entry;
+}
+
+size_t Track::getEntryIndexAt(double time) const {
+  return getEntryIndexAtTicks(secondsToTicks(time));
+}
+
+size_t Track::getEntryIndexAtTicks(Ticks time) const {
+  // Playback moves forward a frame at a time: try the last hit and the
+  // entry after it before searching
+  if (cursorRevision == revision) {
+    if (cursor.entry && cursor.entry->isActiveAtTicks(time)) {
+      return cursor.index;
+    }
+    if (cursor.next && cursor.next->isActiveAtTicks(time)) {
+      moveCursor(cursor.index + 1);
+      return cursor.index;
     }
   }
-  return nullptr;
+
+  // In a gap the cursor stays on the entry before it, so the next entry
+  // is found without a search once playback reaches it
+  size_t index = entries.lastStartingAt(time);
+  moveCursor(index);
+  return cursor.entry && cursor.entry->isActiveAtTicks(time) ? index : npos;
 }
 
 double Track::getTotalDuration() const {
-  if (entries.empty()) {
-    return 0.0;
-  }
+  return ticksToSeconds(getTotalTicks());
+}
 
-  // Entries are sorted by start time
-  // Find the entry with the latest end time
-  double maxEndTime = 0.0;
-  for (const TimelineEntry& entry : entries) {
-    double endTime = entry.getEndTime();
-    if (endTime > maxEndTime) {
-      maxEndTime = endTime;
-    }
+Ticks Track::getTotalTicks() const {
+  // Entries are sorted and disjoint, so the last one ends last
+  return entries.empty() ? 0 : entries.back().getEndTicks();
+}
+
+void Track::touch() {
+  revision++;
+  if (editCounter) {
+    (*editCounter)++;
   }
+}
 
-  return maxEndTime;
+void Track::moveCursor(size_t index) const {
+  // Entry references stay valid until the tree is edited, which also
+  // changes the revision. Before the first entry index is npos
+  // and next is entry 0.
+  cursorRevision = revision;
+  cursor.index = index;
+  cursor.entry = index == npos ? nullptr : &entries[index];
+  cursor.next = index + 1 < entries.size() ? &entries[index + 1] : nullptr;
 }
 
-bool Track::wouldOverlap(const TimelineEntry& entry) const {
-  for (const TimelineEntry& existing : entries) {
-    if (entry.overlapsWith(existing)) {
-      return true;
-    }
+bool Track::wouldOverlap(Ticks startTime, Ticks endTime, size_t ignore) const {
+  // Ends are sorted like starts, so the last entry starting before endTime
+  // (other than the ignored one) is the only one that can reach startTime
+  size_t index = entries.countStartingBefore(endTime);
+  if (index > 0 && index - 1 == ignore) {
+    index--;
   }
-  return false;
+  if (index == 0) {
+    return false;
+  }
+
+  const TimelineEntry& existing = entries[index - 1];
+  return startTime < existing.getEndTicks() && existing.getStartTicks() < endTime;
 }
 
 } // namespace csci3081
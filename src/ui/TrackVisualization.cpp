@@ -1,6 +1,7 @@
 #include "ui/TrackVisualization.h"
 #include "graphics/ColorRect.h"
 #include "graphics/Glyph.h"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -82,12 +83,12 @@ void TrackVisualization::drawTrack(const Track* track, size_t trackIndex, bool i
   }
 
   // Draw each entry in the track
-  const std::vector<TimelineEntry>& entries = track->getEntries();
-  for (size_t i = 0; i < entries.size(); i++) {
-    const TimelineEntry& entry = entries[i];
+  int i = 0;
+  for (const TimelineEntry& entry : track->getEntries()) {
     // Entry is selected if this track is selected AND this entry index matches
-    bool entryIsSelected = isSelected && (static_cast<int>(i) == selectedEntryIndex);
+    bool entryIsSelected = isSelected && (i == selectedEntryIndex);
     drawEntry(entry, trackY, track->getColor(), entryIsSelected);
+    i++;
   }
 }
 
@@ -193,18 +194,15 @@ bool TrackVisualization::getEntryAtPosition(float xPos, float yPos, int& outTrac
 
   double clickTime = getTimeAtPosition(xPos);
 
-  // Check each entry in the track
-  const std::vector<TimelineEntry>& entries = track->getEntries();
-  for (size_t i = 0; i < entries.size(); i++) {
-    const TimelineEntry& entry = entries[i];
-    if (clickTime >= entry.getStartTime() && clickTime < entry.getEndTime()) {
-      outTrack = trackIndex;
-      outEntry = i;
-      return true;
-    }
+  // Find the entry under the click
+  size_t index = track->getEntryIndexAt(clickTime);
+  if (index == Track::npos) {
+    return false;
   }
 
-  return false;
+  outTrack = trackIndex;
+  outEntry = static_cast<int>(index);
+  return true;
 }
 
 bool TrackVisualization::isNearEntryRightEdge(float xPos, float yPos, int& outTrack, int& outEntry) const {
@@ -220,24 +218,20 @@ bool TrackVisualization::isNearEntryRightEdge(float xPos, float yPos, int& outTr
 
   double clickTime = getTimeAtPosition(xPos);
 
-  // Check each entry in the track
-  const std::vector<TimelineEntry>& entries = track->getEntries();
-  for (size_t i = 0; i < entries.size(); i++) {
-    const TimelineEntry& entry = entries[i];
-    double endTime = entry.getEndTime();
-
-    // Check if within entry bounds
-    if (clickTime >= entry.getStartTime() && clickTime < endTime) {
-      // Check if near right edge (within 5% of entry duration or 0.02 normalized coords)
-      double edgeThreshold = std::min(entry.getDuration() * 0.1, 0.5);  // 10% of duration or 0.5s
-      double distanceFromEnd = endTime - clickTime;
-
-      if (distanceFromEnd <= edgeThreshold) {
-        outTrack = trackIndex;
-        outEntry = i;
-        return true;
-      }
-    }
+  // Find the entry under the click
+  size_t index = track->getEntryIndexAt(clickTime);
+  if (index == Track::npos) {
+    return false;
+  }
+
+  // Check if near right edge (within 10% of entry duration or 0.5s)
+  const TimelineEntry& entry = track->getEntry(index);
+  double edgeThreshold = std::min(entry.getDuration() * 0.1, 0.5);
+  double distanceFromEnd = entry.getEndTime() - clickTime;
+  if (distanceFromEnd <= edgeThreshold) {
+    outTrack = trackIndex;
+    outEntry = static_cast<int>(index);
+    return true;
   }
 
   return false;
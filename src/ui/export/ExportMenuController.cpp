@@ -1,5 +1,8 @@
 #include "ui/export/ExportMenuController.h"
 #include "commands/ExportAssetCommand.h"
+#include "commands/ExportTimelineCommand.h"
+#include "export/FrameServerSink.h"
+#include "export/ImageSequenceExport.h"
 #include "timeline/Timeline.h"
 #include <iostream>
 #include <GLFW/glfw3.h>
@@ -7,7 +10,7 @@
 namespace csci3081 {
 
 ExportMenuController::ExportMenuController(ExportMenuModel* model, ExportMenuView* view, ExportFacade* facade)
-  : model(model), view(view), facade(facade) {
+  : model(model), view(view), facade(facade), jobs(nullptr) {
 }
 
 ExportMenuController::~ExportMenuController() {
@@ -111,8 +114,12 @@ void ExportMenuController::onExportVideoClicked() {
   ExportSettings settings = model->getSettings();
   std::cout << "Original export format: " << static_cast<int>(settings.format) << std::endl;
 
-  // For video export, use a video-friendly default filename
+  // For video export, use a video-friendly default filename. Exports still
+  // running keep theirs.
   std::string filename = "timeline_export";
+  if (jobs && jobs->isBusy()) {
+    filename += "_" + std::to_string(jobs->getJobs().back().id + 1);
+  }
 
   // Use the current format's extension
   std::string ext = ExportFacade::getDefaultExtension(settings.format);
@@ -120,10 +127,12 @@ void ExportMenuController::onExportVideoClicked() {
 
   filename += ext;
 
-  // Warn if not using a video format
-  if (settings.format != ExportFormat::MP4) {
-    std::cout << "NOTE: Exporting timeline as single frame " << ext << " (video format not selected)" << std::endl;
-    std::cout << "      To export as video, MP4 support needs to be implemented" << std::endl;
+  // How the timeline is exported in its format is the menu's option (see
+  // ExportMenuModel::nextTimelineOption()); a sequence is a file per frame
+  if (settings.imageSequence && settings.format != ExportFormat::MP4 &&
+      !FrameServerSink::isStreamFormat(settings.format)) {
+    std::cout << "NOTE: Exporting timeline as an image sequence: "
+              << ImageSequenceExport::getFrameFilename(filename, 0) << ", ..." << std::endl;
   }
 
   std::cout << "Final output filename: '" << filename << "'" << std::endl;
@@ -133,6 +142,19 @@ void ExportMenuController::onExportVideoClicked() {
   int height = 480;
   std::cout << "Output dimensions: " << width << "x" << height << std::endl;
 
+  // Export the timeline in the background: the command exports a snapshot,
+  // so editing can go on
+  if (jobs) {
+    int id = jobs->submit(new ExportTimelineCommand(*facade, *timeline, filename, settings,
+                                                    width, height));
+    if (id < 0) {
+      std::cerr << "FAILED: Timeline export could not be queued" << std::endl;
+    } else {
+      std::cout << "Queued export job " << id << ": " << filename << std::endl;
+    }
+    return;
+  }
+
   // Export the timeline
   std::cout << "Calling facade->exportTimeline()..." << std::endl;
   bool success = facade->exportTimeline(timeline, filename, settings, width, height);
@@ -147,6 +169,24 @@ void ExportMenuController::onExportVideoClicked() {
   std::cout << "=== Export Video Complete ===" << std::endl;
 }
 
+void ExportMenuController::onTimelineOptionClicked() {
+  if (!model) {
+    return;
+  }
+  model->nextTimelineOption();
+  std::cout << "Timeline export: " << model->getTimelineOptionLabel() << std::endl;
+  if (view) {
+    view->update();
+  }
+}
+
+void ExportMenuController::onCancelExportsClicked() {
+  if (jobs) {
+    jobs->cancelAll();
+    std::cout << "Cancelling exports" << std::endl;
+  }
+}
+
 void ExportMenuController::setFilename(const std::string& filename) {
   if (model) {
     model->setFilename(filename);
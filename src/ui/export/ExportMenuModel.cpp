@@ -1,4 +1,5 @@
 #include "ui/export/ExportMenuModel.h"
+#include "export/FrameServerSink.h"
 
 namespace csci3081 {
 
@@ -34,6 +35,28 @@ std::vector<ExportFormat> ExportMenuModel::getAvailableFormats() const {
   return formats;
 }
 
+void ExportMenuModel::nextTimelineOption() {
+  if (settings.format == ExportFormat::MP4) {
+    // Whole file, resumable, reusing edits, then both
+    settings.incremental = settings.incremental != settings.resumable;
+    settings.resumable = !settings.resumable;
+  } else if (!FrameServerSink::isStreamFormat(settings.format)) {
+    settings.imageSequence = !settings.imageSequence;
+  }
+}
+
+std::string ExportMenuModel::getTimelineOptionLabel() const {
+  if (settings.format == ExportFormat::MP4) {
+    if (settings.resumable) {
+      return settings.incremental ? "Resume + reuse" : "Resumable";
+    }
+    return settings.incremental ? "Reuse edits" : "Whole file";
+  } else if (!FrameServerSink::isStreamFormat(settings.format)) {
+    return settings.imageSequence ? "Sequence" : "Single frame";
+  }
+  return "";
+}
+
 bool ExportMenuModel::canExport() const {
   if (!asset) {
     return false;
@@ -48,6 +71,11 @@ bool ExportMenuModel::canExport() const {
     return false;
   }
 
+  std::string error;
+  if (settings.format == ExportFormat::MP4 && !settings.encoder.check(error)) {
+    return false;
+  }
+
   return true;
 }
 
@@ -64,6 +92,11 @@ std::string ExportMenuModel::getValidationError() const {
     return "Filename extension does not match format";
   }
 
+  std::string error;
+  if (settings.format == ExportFormat::MP4 && !settings.encoder.check(error)) {
+    return error;
+  }
+
   return "";
 }
 
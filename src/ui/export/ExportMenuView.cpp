@@ -1,12 +1,59 @@
 #include "ui/export/ExportMenuView.h"
 #include "ui/export/ExportMenuController.h"
 #include "graphics/Color.h"
+#include "graphics/Text.h"
+#include <cstdio>
 #include <iostream>
 
 namespace csci3081 {
 
+namespace {
+
+const float BUTTON_HEIGHT = 0.04f;
+const float BUTTON_SPACING = 0.01f;
+const size_t MAX_JOBS_SHOWN = 2;
+
+/**
+ * @brief Describe a job in a few words, e.g. "42% 31 fps 0:12"
+ * @param job The job
+ * @param withSpeed false to leave out the frames per second, which change
+ *        on almost every frame
+ */
+std::string describeJob(const ExportJobStatus& job, bool withSpeed) {
+  char text[64];
+  switch (job.state) {
+    case ExportJobState::QUEUED:
+      return "Queued";
+    case ExportJobState::FINISHED:
+      return "Done";
+    case ExportJobState::FAILED:
+      return "Failed";
+    case ExportJobState::CANCELLED:
+      return "Cancelled";
+    case ExportJobState::RUNNING:
+      break;
+  }
+  const ExportProgress& progress = job.progress;
+  const int percent = static_cast<int>(progress.getFraction() * 100);
+  const double remaining = progress.getSecondsRemaining();
+  if (remaining < 0.0) {
+    std::snprintf(text, sizeof(text), "%d%%", percent);
+    return text;
+  }
+  const int seconds = static_cast<int>(remaining + 0.5);
+  if (withSpeed) {
+    std::snprintf(text, sizeof(text), "%d%% %.0f fps %d:%02d", percent,
+                  progress.getFramesPerSecond(), seconds / 60, seconds % 60);
+  } else {
+    std::snprintf(text, sizeof(text), "%d%% %d:%02d", percent, seconds / 60, seconds % 60);
+  }
+  return text;
+}
+
+} // namespace
+
 ExportMenuView::ExportMenuView(float x, float y, float w, float h, ExportMenuModel* model)
-  : model(model), controller(nullptr), x(x), y(y), w(w), h(h) {
+  : model(model), controller(nullptr), jobsActive(false), x(x), y(y), w(w), h(h) {
 
   // Create container with dark background
   container = new Container(x, y, w, h, Color(40, 40, 40, 255));
@@ -16,6 +63,7 @@ ExportMenuView::ExportMenuView(float x, float y, float w, float h, ExportMenuMod
 
 ExportMenuView::~ExportMenuView() {
   clearUI();
+  clearJobs();
   delete container;
 }
 
@@ -29,9 +77,9 @@ void ExportMenuView::createUI() {
   // Create format selection buttons
   std::vector<ExportFormat> formats = model->getAvailableFormats();
 
-  float buttonHeight = 0.04f;
-  float buttonSpacing = 0.01f;
-  float startY = y + 0.08f;  // Leave space for title
+  float buttonHeight = BUTTON_HEIGHT;
+  float buttonSpacing = BUTTON_SPACING;
+  float startY = y + 0.06f;  // Leave space for title
 
   for (size_t i = 0; i < formats.size(); ++i) {
     ExportFormat format = formats[i];
@@ -76,6 +124,28 @@ void ExportMenuView::createUI() {
     buttons.push_back(button);
   }
 
+  // How the timeline is exported in the selected format, under the formats
+  std::string option = model->getTimelineOptionLabel();
+  if (!option.empty()) {
+    TextButton* optionButton = new TextButton(
+      x + 0.01f,
+      startY + formats.size() * (buttonHeight + buttonSpacing),
+      w - 0.02f,
+      buttonHeight,
+      option,
+      Color(255, 220, 120, 255),  // Yellow color
+      32,
+      "Roboto-Regular.ttf",
+      [this]() {
+        if (this->controller) {
+          this->controller->onTimelineOptionClicked();
+        }
+      }
+    );
+
+    buttons.push_back(optionButton);
+  }
+
   // Create export buttons at bottom
   float exportVideoButtonY = y + h - 2 * buttonHeight - 2 * buttonSpacing - 0.01f;
   float exportButtonY = y + h - buttonHeight - 0.01f;
@@ -117,6 +187,29 @@ void ExportMenuView::createUI() {
   );
 
   buttons.push_back(exportButton);
+
+  // Cancel button above the progress bars, while exports are running
+  if (jobsActive) {
+    float cancelButtonY = exportVideoButtonY -
+                          (MAX_JOBS_SHOWN + 1) * (buttonHeight + buttonSpacing);
+    TextButton* cancelButton = new TextButton(
+      x + 0.01f,
+      cancelButtonY,
+      w - 0.02f,
+      buttonHeight,
+      "Cancel Exports",
+      Color(255, 120, 100, 255),  // Red color
+      32,
+      "Roboto-Regular.ttf",
+      [this]() {
+        if (this->controller) {
+          this->controller->onCancelExportsClicked();
+        }
+      }
+    );
+
+    buttons.push_back(cancelButton);
+  }
 }
 
 void ExportMenuView::clearUI() {
@@ -126,6 +219,60 @@ void ExportMenuView::clearUI() {
   buttons.clear();
 }
 
+void ExportMenuView::clearJobs() {
+  for (Glyph* glyph : jobGlyphs) {
+    delete glyph;
+  }
+  jobGlyphs.clear();
+  jobLabels.clear();
+}
+
+void ExportMenuView::onJobsChanged(const std::vector<ExportJobStatus>& jobs) {
+  bool active = false;
+  for (const ExportJobStatus& job : jobs) {
+    active = active || !job.isDone();
+  }
+
+  // Text is only rendered again when the percentage or time left changes,
+  // not on every frame an export writes
+  size_t first = jobs.size() > MAX_JOBS_SHOWN ? jobs.size() - MAX_JOBS_SHOWN : 0;
+  std::vector<std::string> labels;
+  for (size_t i = first; i < jobs.size(); i++) {
+    labels.push_back(describeJob(jobs[i], false));
+  }
+  if (active != jobsActive) {
+    jobsActive = active;
+    createUI();
+  }
+  if (labels == jobLabels) {
+    return;
+  }
+  clearJobs();
+  jobLabels = labels;
+
+  // Newest at the bottom, just above the export buttons
+  float bottom = y + h - 2 * BUTTON_HEIGHT - 2 * BUTTON_SPACING - 0.01f;
+  for (size_t i = 0; i < labels.size(); i++) {
+    const ExportJobStatus& job = jobs[first + i];
+    float rowY = bottom - (labels.size() - i) * (BUTTON_HEIGHT + BUTTON_SPACING);
+    float barWidth = w - 0.02f;
+    jobGlyphs.push_back(new Container(x + 0.01f, rowY, barWidth, BUTTON_HEIGHT,
+                                      Color(70, 70, 70, 255)));
+    double fraction = job.state == ExportJobState::FINISHED ? 1.0 : job.progress.getFraction();
+    if (fraction > 0.0) {
+      Color fill = job.state == ExportJobState::FAILED ? Color(200, 70, 60, 255)
+                                                      : Color(60, 150, 90, 255);
+      jobGlyphs.push_back(new Container(x + 0.01f, rowY,
+                                        barWidth * static_cast<float>(fraction),
+                                        BUTTON_HEIGHT, fill));
+    }
+    Text text(describeJob(job, true), Color(255, 255, 255, 255), 24);
+    Image* image = text.renderToImage();
+    jobGlyphs.push_back(new Glyph(x + 0.01f, rowY, barWidth, BUTTON_HEIGHT, *image));
+    delete image;
+  }
+}
+
 void ExportMenuView::draw() const {
   if (container) {
     container->draw();
@@ -136,6 +283,10 @@ void ExportMenuView::draw() const {
       button->draw();
     }
   }
+
+  for (const Glyph* glyph : jobGlyphs) {
+    glyph->draw();
+  }
 }
 
 void ExportMenuView::update() {
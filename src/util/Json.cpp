@@ -0,0 +1,510 @@
+#include "util/Json.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace csci3081 {
+
+namespace {
+
+const JsonValue& nullValue() {
+  static const JsonValue value;
+  return value;
+}
+
+void appendEscaped(std::string& out, const std::string& text) {
+  out += '"';
+  for (char c : text) {
+    switch (c) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          out += escaped;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+void appendNumber(std::string& out, double value) {
+  if (!std::isfinite(value)) {
+    out += "null";
+    return;
+  }
+  // Shortest form that reads back as the same double
+  char digits[32];
+  std::snprintf(digits, sizeof(digits), "%.15g", value);
+  if (std::strtod(digits, nullptr) != value) {
+    std::snprintf(digits, sizeof(digits), "%.17g", value);
+  }
+  out += digits;
+}
+
+void appendUtf8(std::string& out, unsigned int code) {
+  if (code < 0x80) {
+    out += static_cast<char>(code);
+  } else if (code < 0x800) {
+    out += static_cast<char>(0xC0 | (code >> 6));
+    out += static_cast<char>(0x80 | (code & 0x3F));
+  } else if (code < 0x10000) {
+    out += static_cast<char>(0xE0 | (code >> 12));
+    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (code >> 18));
+    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (code & 0x3F));
+  }
+}
+
+} // namespace
+
+// ==============================================================================
+// Parser
+// ==============================================================================
+
+/**
+ * @brief Recursive descent parser over a JSON string
+ */
+class JsonParser {
+public:
+  JsonParser(const std::string& text) : text(text), pos(0) {}
+
+  bool parseDocument(JsonValue& result, std::string& error) {
+    if (!parseValue(result, 0)) {
+      error = message;
+      return false;
+    }
+    skipSpace();
+    if (pos != text.size()) {
+      fail("Unexpected text after the value");
+      error = message;
+      return false;
+    }
+    return true;
+  }
+
+private:
+  static const int MAX_DEPTH = 256;
+
+  const std::string& text;
+  size_t pos;
+  std::string message;
+
+  bool fail(const std::string& what) {
+    message = what + " at offset " + std::to_string(pos);
+    return false;
+  }
+
+  void skipSpace() {
+    while (pos < text.size() &&
+           (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+      pos++;
+    }
+  }
+
+  bool consume(const char* word) {
+    size_t length = std::char_traits<char>::length(word);
+    if (text.compare(pos, length, word) != 0) {
+      return false;
+    }
+    pos += length;
+    return true;
+  }
+
+  bool parseValue(JsonValue& value, int depth) {
+    if (depth > MAX_DEPTH) {
+      return fail("Nesting too deep");
+    }
+    skipSpace();
+    if (pos >= text.size()) {
+      return fail("Unexpected end of text");
+    }
+
+    char c = text[pos];
+    if (c == '{') {
+      return parseObject(value, depth);
+    }
+    if (c == '[') {
+      return parseArray(value, depth);
+    }
+    if (c == '"') {
+      value = JsonValue(std::string());
+      return parseString(value.text);
+    }
+    if (consume("true")) {
+      value = JsonValue(true);
+      return true;
+    }
+    if (consume("false")) {
+      value = JsonValue(false);
+      return true;
+    }
+    if (consume("null")) {
+      value = JsonValue();
+      return true;
+    }
+    return parseNumber(value);
+  }
+
+  bool parseObject(JsonValue& value, int depth) {
+    value = JsonValue::object();
+    pos++;
+    skipSpace();
+    if (pos < text.size() && text[pos] == '}') {
+      pos++;
+      return true;
+    }
+    while (true) {
+      skipSpace();
+      std::string key;
+      if (pos >= text.size() || text[pos] != '"' || !parseString(key)) {
+        return message.empty() ? fail("Expected a member name") : false;
+      }
+      skipSpace();
+      if (pos >= text.size() || text[pos] != ':') {
+        return fail("Expected ':'");
+      }
+      pos++;
+      JsonValue member;
+      if (!parseValue(member, depth + 1)) {
+        return false;
+      }
+      value.members.push_back(std::make_pair(key, std::move(member)));
+
+      skipSpace();
+      if (pos < text.size() && text[pos] == ',') {
+        pos++;
+      } else if (pos < text.size() && text[pos] == '}') {
+        pos++;
+        return true;
+      } else {
+        return fail("Expected ',' or '}'");
+      }
+    }
+  }
+
+  bool parseArray(JsonValue& value, int depth) {
+    value = JsonValue::array();
+    pos++;
+    skipSpace();
+    if (pos < text.size() && text[pos] == ']') {
+      pos++;
+      return true;
+    }
+    while (true) {
+      JsonValue item;
+      if (!parseValue(item, depth + 1)) {
+        return false;
+      }
+      value.items.push_back(std::move(item));
+
+      skipSpace();
+      if (pos < text.size() && text[pos] == ',') {
+        pos++;
+      } else if (pos < text.size() && text[pos] == ']') {
+        pos++;
+        return true;
+      } else {
+        return fail("Expected ',' or ']'");
+      }
+    }
+  }
+
+  bool parseHex(unsigned int& code) {
+    if (pos + 4 > text.size()) {
+      return fail("Truncated \\u escape");
+    }
+    code = 0;
+    for (int i = 0; i < 4; i++) {
+      char c = text[pos++];
+      code <<= 4;
+      if (c >= '0' && c <= '9') {
+        code |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        code |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        code |= c - 'A' + 10;
+      } else {
+        return fail("Invalid \\u escape");
+      }
+    }
+    return true;
+  }
+
+  bool parseString(std::string& out) {
+    pos++;   // Opening quote
+    while (pos < text.size()) {
+      char c = text[pos++];
+      if (c == '"') {
+        return true;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return fail("Control character in string");
+      }
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (pos >= text.size()) {
+        break;
+      }
+      char escape = text[pos++];
+      switch (escape) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          unsigned int code;
+          if (!parseHex(code)) {
+            return false;
+          }
+          // A surrogate pair encodes one code point above U+FFFF
+          if (code >= 0xD800 && code < 0xDC00 && consume("\\u")) {
+            unsigned int low;
+            if (!parseHex(low)) {
+              return false;
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          }
+          appendUtf8(out, code);
+          break;
+        }
+        default:
+          return fail("Invalid escape");
+      }
+    }
+    return fail("Unterminated string");
+  }
+
+  bool parseNumber(JsonValue& value) {
+    size_t start = pos;
+    bool integral = true;
+    if (pos < text.size() && text[pos] == '-') {
+      pos++;
+    }
+    size_t digits = pos;
+    while (pos < text.size()) {
+      char c = text[pos];
+      if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+        integral = false;
+      } else if (c < '0' || c > '9') {
+        break;
+      }
+      pos++;
+    }
+    if (pos == digits) {
+      pos = start;
+      return fail("Unexpected character");
+    }
+
+    std::string token = text.substr(start, pos - start);
+    char* end;
+    double number = std::strtod(token.c_str(), &end);
+    if (*end != '\0') {
+      pos = start;
+      return fail("Invalid number");
+    }
+    value = JsonValue(number);
+    if (integral) {
+      long long exact = std::strtoll(token.c_str(), &end, 10);
+      if (*end == '\0') {
+        value = JsonValue(static_cast<int64_t>(exact));
+      }
+    }
+    return true;
+  }
+};
+
+// ==============================================================================
+// JsonValue
+// ==============================================================================
+
+JsonValue::JsonValue(bool value)
+  : type(Type::BOOLEAN), boolean(value), number(0.0), integer(0), exact(false) {
+}
+
+JsonValue::JsonValue(int value)
+  : type(Type::NUMBER), boolean(false), number(value), integer(value), exact(true) {
+}
+
+JsonValue::JsonValue(int64_t value)
+  : type(Type::NUMBER), boolean(false), number(static_cast<double>(value)),
+    integer(value), exact(true) {
+}
+
+JsonValue::JsonValue(double value)
+  : type(Type::NUMBER), boolean(false), number(value), integer(0), exact(false) {
+}
+
+JsonValue::JsonValue(const char* value)
+  : type(Type::STRING), boolean(false), number(0.0), integer(0), exact(false),
+    text(value) {
+}
+
+JsonValue::JsonValue(const std::string& value)
+  : type(Type::STRING), boolean(false), number(0.0), integer(0), exact(false),
+    text(value) {
+}
+
+JsonValue JsonValue::array() {
+  JsonValue value;
+  value.type = Type::ARRAY;
+  return value;
+}
+
+JsonValue JsonValue::object() {
+  JsonValue value;
+  value.type = Type::OBJECT;
+  return value;
+}
+
+bool JsonValue::asBool(bool defaultValue) const {
+  return type == Type::BOOLEAN ? boolean : defaultValue;
+}
+
+double JsonValue::asDouble(double defaultValue) const {
+  return type == Type::NUMBER ? number : defaultValue;
+}
+
+int64_t JsonValue::asInt(int64_t defaultValue) const {
+  if (type != Type::NUMBER) {
+    return defaultValue;
+  }
+  return exact ? integer : static_cast<int64_t>(std::llround(number));
+}
+
+std::string JsonValue::asString(const std::string& defaultValue) const {
+  return type == Type::STRING ? text : defaultValue;
+}
+
+size_t JsonValue::size() const {
+  if (type == Type::ARRAY) {
+    return items.size();
+  }
+  return type == Type::OBJECT ? members.size() : 0;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+  if (type != Type::ARRAY || index >= items.size()) {
+    return nullValue();
+  }
+  return items[index];
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+  if (type == Type::OBJECT) {
+    for (const auto& member : members) {
+      if (member.first == key) {
+        return member.second;
+      }
+    }
+  }
+  return nullValue();
+}
+
+void JsonValue::push(const JsonValue& item) {
+  if (type == Type::ARRAY) {
+    items.push_back(item);
+  }
+}
+
+void JsonValue::set(const std::string& key, const JsonValue& value) {
+  if (type != Type::OBJECT) {
+    return;
+  }
+  for (auto& member : members) {
+    if (member.first == key) {
+      member.second = value;
+      return;
+    }
+  }
+  members.push_back(std::make_pair(key, value));
+}
+
+std::string JsonValue::dump(int indent) const {
+  std::string out;
+  dump(out, indent, 0);
+  if (indent > 0) {
+    out += '\n';
+  }
+  return out;
+}
+
+void JsonValue::dump(std::string& out, int indent, int depth) const {
+  // Line break and indent before an item at the given depth
+  auto newline = [&out, indent](int level) {
+    if (indent > 0) {
+      out += '\n';
+      out.append(level * indent, ' ');
+    }
+  };
+
+  switch (type) {
+    case Type::NUL:
+      out += "null";
+      break;
+    case Type::BOOLEAN:
+      out += boolean ? "true" : "false";
+      break;
+    case Type::NUMBER:
+      if (exact) {
+        out += std::to_string(integer);
+      } else {
+        appendNumber(out, number);
+      }
+      break;
+    case Type::STRING:
+      appendEscaped(out, text);
+      break;
+    case Type::ARRAY:
+      out += '[';
+      for (size_t i = 0; i < items.size(); i++) {
+        out += i > 0 ? "," : "";
+        newline(depth + 1);
+        items[i].dump(out, indent, depth + 1);
+      }
+      if (!items.empty()) {
+        newline(depth);
+      }
+      out += ']';
+      break;
+    case Type::OBJECT:
+      out += '{';
+      for (size_t i = 0; i < members.size(); i++) {
+        out += i > 0 ? "," : "";
+        newline(depth + 1);
+        appendEscaped(out, members[i].first);
+        out += indent > 0 ? ": " : ":";
+        members[i].second.dump(out, indent, depth + 1);
+      }
+      if (!members.empty()) {
+        newline(depth);
+      }
+      out += '}';
+      break;
+  }
+}
+
+bool JsonValue::parse(const std::string& text, JsonValue& result, std::string& error) {
+  JsonParser parser(text);
+  return parser.parseDocument(result, error);
+}
+
+} // namespace csci3081
@@ -0,0 +1,73 @@
+#include "util/MappedFile.h"
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace csci3081 {
+
+MappedFile::MappedFile() : bytes(nullptr), length(0), mapped(false) {
+}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const std::string& path) {
+  close();
+
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    ::close(fd);
+    return false;
+  }
+  length = static_cast<size_t>(info.st_size);
+  if (length == 0) {
+    ::close(fd);
+    return true;
+  }
+
+  void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file alive on its own
+  ::close(fd);
+  if (address != MAP_FAILED) {
+    bytes = static_cast<const uint8_t*>(address);
+    mapped = true;
+    return true;
+  }
+  length = 0;
+#endif
+
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  bytes = buffer.empty() ? nullptr : buffer.data();
+  length = buffer.size();
+  return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+  if (mapped) {
+    munmap(const_cast<uint8_t*>(bytes), length);
+  }
+#endif
+  bytes = nullptr;
+  length = 0;
+  mapped = false;
+  buffer.clear();
+}
+
+} // namespace csci3081
@@ -0,0 +1,97 @@
+#include "util/ThreadPool.h"
+
+namespace csci3081 {
+
+ThreadPool::ThreadPool(int threadCount)
+  : task(nullptr), context(nullptr), count(0), nextIndex(0), busyWorkers(0),
+    generation(0), stopping(false) {
+  for (int i = 0; i < threadCount; i++) {
+    workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+
+  for (size_t i = 0; i < workers.size(); i++) {
+    workers[i].join();
+  }
+}
+
+void ThreadPool::parallelFor(int count, Task task, void* context) {
+  if (count <= 0) {
+    return;
+  }
+
+  // Not worth waking anyone for a single item
+  if (count == 1 || workers.empty()) {
+    for (int i = 0; i < count; i++) {
+      task(context, i);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> callLock(callMutex);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = task;
+    this->context = context;
+    this->count = count;
+    nextIndex = 0;
+    busyWorkers = static_cast<int>(workers.size());
+    generation++;
+  }
+  wake.notify_all();
+
+  runTasks();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (busyWorkers > 0) {
+    idle.wait(lock);
+  }
+}
+
+void ThreadPool::runTasks() {
+  int index;
+  while ((index = nextIndex.fetch_add(1)) < count) {
+    task(context, index);
+  }
+}
+
+void ThreadPool::workerLoop() {
+  unsigned int seen = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!stopping && generation == seen) {
+        wake.wait(lock);
+      }
+      if (stopping) {
+        return;
+      }
+      seen = generation;
+    }
+
+    runTasks();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--busyWorkers == 0) {
+      idle.notify_one();
+    }
+  }
+}
+
+ThreadPool& ThreadPool::shared() {
+  static ThreadPool pool(
+      static_cast<int>(std::thread::hardware_concurrency() > 1
+                           ? std::thread::hardware_concurrency() - 1
+                           : 1));
+  return pool;
+}
+
+} // namespace csci3081
@@ -0,0 +1,150 @@
+/**
+ * @file bench_encoder.cpp
+ * @brief Benchmarks of encoder settings: speed against file size
+ *
+ * Not a correctness test: encodes the same two seconds of video with each
+ * available encoder at several presets and rate controls, and prints the
+ * encoding speed and the size of the file. Encoders the local FFmpeg
+ * doesn't have are skipped. Disabled in test runs, as the slower presets
+ * take minutes; run them with --gtest_also_run_disabled_tests
+ * --gtest_filter=EncoderBenchmark.*
+ */
+
+#include <gtest/gtest.h>
+#include "export/EncoderSettings.h"
+#include "export/VideoWriterSink.h"
+#include "export/YuvFrame.h"
+#include "graphics/Color.h"
+#include "Image.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+/**
+ * @brief Frames of a gradient with a moving box and some grain, converted once
+ */
+std::vector<YuvFrame> makeFrames(int width, int height, int count) {
+    std::vector<YuvFrame> frames(count);
+    Image image(width, height);
+    std::srand(7);
+    for (int f = 0; f < count; f++) {
+        unsigned char* data = image.getData();
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                unsigned char* pixel = data + (y * width + x) * 4;
+                bool box = x >= f * 8 % width && x < f * 8 % width + width / 6 &&
+                           y >= height / 3 && y < height / 3 + height / 4;
+                int grain = std::rand() % 9 - 4;
+                pixel[0] = static_cast<unsigned char>(box ? 230 : 40 + x * 150 / width + grain);
+                pixel[1] = static_cast<unsigned char>(box ? 60 : 60 + y * 120 / height + grain);
+                pixel[2] = static_cast<unsigned char>(box ? 40 : 120 + grain);
+                pixel[3] = 255;
+            }
+        }
+        convertToYuv420(image, frames[f]);
+    }
+    return frames;
+}
+
+long fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? static_cast<long>(file.tellg()) : -1;
+}
+
+const char* rateControlName(const EncoderSettings& settings) {
+    switch (settings.rateControl) {
+        case RateControl::CONSTANT_QUALITY: return "crf";
+        case RateControl::VBR: return settings.twoPass ? "vbr2" : "vbr";
+        case RateControl::CBR: return "cbr";
+    }
+    return "";
+}
+
+/**
+ * @brief Encode the frames with some settings and print how it went
+ */
+void encode(const std::vector<YuvFrame>& frames, const Rational& rate,
+            const EncoderSettings& settings) {
+    const std::string path = "bench_encoder.mp4";
+    const std::string passLog = path + ".passlog";
+    const YuvFrame& first = frames.front();
+    std::string error;
+    if (!VideoWriterSink::checkSettings(settings, first.width, first.height, rate, error)) {
+        std::printf("[ bench    ] %-11s %-9s %-4s skipped: %s\n", settings.codec.c_str(),
+                    settings.preset.c_str(), rateControlName(settings), error.c_str());
+        return;
+    }
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    const int passes = settings.twoPass ? 2 : 1;
+    for (int pass = 1; pass <= passes; pass++) {
+        VideoWriterSink sink(path, settings);
+        if (passes > 1) {
+            sink.setPass(pass, passLog);
+        }
+        ASSERT_TRUE(sink.open(first.width, first.height, rate)) << sink.getLastError();
+        for (const YuvFrame& frame : frames) {
+            ASSERT_TRUE(sink.writeFrame(frame)) << sink.getLastError();
+        }
+        sink.close();
+    }
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::printf("[ bench    ] %-11s %-9s %-4s %7.1f fps %9.1f KB\n", settings.codec.c_str(),
+                settings.preset.c_str(), rateControlName(settings), frames.size() / seconds,
+                fileSize(path) / 1024.0);
+    std::remove(path.c_str());
+    std::remove(passLog.c_str());
+    std::remove((passLog + ".mbtree").c_str());
+}
+
+} // namespace
+
+/**
+ * Benchmark: Two seconds of 1280x720 at 29.97 fps per encoder, preset and rate control
+ * Prints encoding speed and file size for each combination
+ */
+TEST(EncoderBenchmark, DISABLED_PresetAndRateControlMatrix) {
+    const Rational rate(30000, 1001);
+    const std::vector<YuvFrame> frames = makeFrames(1280, 720, 60);
+
+    const char* codecs[] = {"libx264", "libx265", "libvpx-vp9"};
+    const char* presets[] = {"ultrafast", "veryfast", "medium", "slow"};
+    for (const char* codec : codecs) {
+        if (VideoWriterSink::getEncoderFormat(codec).empty()) {
+            std::printf("[ bench    ] %-11s not in this FFmpeg\n", codec);
+            continue;
+        }
+        // libvpx has no presets; its speed is set with its own options
+        const bool hasPresets = std::string(codec) != "libvpx-vp9";
+        for (const char* preset : presets) {
+            EncoderSettings settings;
+            settings.codec = codec;
+            settings.preset = hasPresets ? preset : "";
+            settings.crf = hasPresets ? 23 : 31;
+            encode(frames, rate, settings);
+
+            settings.rateControl = RateControl::CBR;
+            settings.bitRate = 4000;
+            encode(frames, rate, settings);
+
+            settings.rateControl = RateControl::VBR;
+            settings.maxBitRate = 6000;
+            encode(frames, rate, settings);
+
+            settings.twoPass = true;
+            encode(frames, rate, settings);
+            if (!hasPresets) {
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,215 @@
+/**
+ * @file bench_export.cpp
+ * @brief Benchmarks for the streaming export pipeline
+ *
+ * Not a correctness test: prints the throughput of each pipeline stage and
+ * how many frame buffers an export holds, next to what rendering every
+ * frame up front used to hold. Disabled in test runs; run them with
+ * --gtest_also_run_disabled_tests --gtest_filter=ExportBenchmark.*
+ */
+
+#include <gtest/gtest.h>
+#include "compositor/Blend.h"
+#include "export/ExportPipeline.h"
+#include "export/ImageSequenceExport.h"
+#include "timeline/Timeline.h"
+#include "util/ThreadPool.h"
+#include "Image.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+/**
+ * @brief A "video" that always shows the same noisy frame
+ */
+class NoiseVideo : public IAsset {
+public:
+    NoiseVideo(int width, int height, unsigned seed) : frame(width, height) {
+        std::srand(seed);
+        unsigned char* data = frame.getData();
+        for (int i = 0; i < width * height * 4; i++) {
+            data[i] = static_cast<unsigned char>(std::rand() & 255);
+        }
+        premultiplySpan(data, width * height);
+    }
+
+    double getDuration() const override { return 1000.0; }
+    const Image& getFrame(double time = 0.0) override { return frame; }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+private:
+    Image frame;
+};
+
+/**
+ * @brief A "video" that always shows the same soft gradient, more like
+ * footage than noise is for a PNG encoder
+ */
+class GradientVideo : public IAsset {
+public:
+    GradientVideo(int width, int height) : frame(width, height) {
+        for (int y = 0; y < height; y++) {
+            unsigned char* row = frame.getData() + y * width * 4;
+            for (int x = 0; x < width; x++) {
+                row[x * 4] = static_cast<unsigned char>(x * 255 / width);
+                row[x * 4 + 1] = static_cast<unsigned char>(y * 255 / height);
+                row[x * 4 + 2] = static_cast<unsigned char>(128 + (std::rand() & 7));
+                row[x * 4 + 3] = 255;
+            }
+        }
+    }
+
+    double getDuration() const override { return 1000.0; }
+    const Image& getFrame(double time = 0.0) override { return frame; }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+private:
+    Image frame;
+};
+
+/**
+ * @brief Sink that drops every frame, so only the pipeline is measured
+ */
+class NullSink : public IFrameSink {
+public:
+    bool open(int width, int height, const Rational& rate) override { return true; }
+    bool writeFrame(const YuvFrame& frame) override { return true; }
+    bool close() override { return true; }
+    std::string getLastError() const override { return ""; }
+};
+
+} // namespace
+
+/**
+ * Benchmark: Two seconds of a 3-track 1280x720 timeline
+ * Prints per-stage frames per second and memory held by frame buffers
+ */
+TEST(ExportBenchmark, DISABLED_StreamingPipeline) {
+    const int width = 1280;
+    const int height = 720;
+    const double seconds = 2.0;
+
+    std::vector<NoiseVideo*> assets;
+    Timeline timeline;
+    for (int i = 0; i < 3; i++) {
+        assets.push_back(new NoiseVideo(width, height, i));
+        TimelineEntry entry(assets.back(), 0.0, seconds);
+        EntryTransform transform;
+        transform.opacity = i == 0 ? 1.0f : 0.5f;
+        entry.setTransform(transform);
+        timeline.addTrack("Layer");
+        timeline.addEntryToTrack(i, entry);
+    }
+
+    NullSink sink;
+    ExportPipeline pipeline;
+    ASSERT_TRUE(pipeline.run(timeline, width, height, Rational(30, 1), sink))
+        << pipeline.getLastError();
+
+    const PipelineStats& stats = pipeline.getStats();
+    double frameBytes = width * height * 4.0 + width * height * 1.5;
+    double heldMB = stats.frameBuffers * frameBytes / (1024.0 * 1024.0);
+    double upFrontMB = stats.encode.frames * width * height * 4.0 / (1024.0 * 1024.0);
+    std::printf("[ bench    ] %lld frames in %.2f s (%.1f fps): render %.1f fps, "
+                "convert %.1f fps, encode %.1f fps\n",
+                static_cast<long long>(stats.encode.frames), stats.elapsedSeconds,
+                stats.encode.frames / stats.elapsedSeconds,
+                stats.render.getFramesPerSecond(), stats.convert.getFramesPerSecond(),
+                stats.encode.getFramesPerSecond());
+    std::printf("[ bench    ] frame buffers: %.1f MB streaming vs %.1f MB rendering "
+                "every frame first (grows with length)\n", heldMB, upFrontMB);
+
+    for (size_t i = 0; i < assets.size(); i++) {
+        delete assets[i];
+    }
+}
+
+/**
+ * Benchmark: RGBA to YUV 4:2:0 conversion of a 1920x1080 frame
+ * Prints megapixels per second on one thread and on the shared pool
+ */
+TEST(ExportBenchmark, DISABLED_YuvConversion) {
+    NoiseVideo video(1920, 1080, 4);
+    const Image& image = video.getFrame();
+    const int repeats = 50;
+    YuvFrame frame;
+
+    ThreadPool* pools[] = {nullptr, &ThreadPool::shared()};
+    double rates[2];
+    for (int i = 0; i < 2; i++) {
+        convertToYuv420(image, frame, YuvFormat(), pools[i]);   // Warm up
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            convertToYuv420(image, frame, YuvFormat(), pools[i]);
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rates[i] = repeats * 1920.0 * 1080.0 / seconds / 1e6;
+    }
+    std::printf("[ bench    ] 1080p RGBA to YUV 4:2:0: %.0f Mpx/s on one thread, %.0f Mpx/s "
+                "on %d (%.0f fps)\n", rates[0], rates[1],
+                ThreadPool::shared().getThreadCount() + 1, rates[1] * 1e6 / (1920.0 * 1080.0));
+}
+
+/**
+ * Benchmark: Half a second of a 1280x720 timeline as a PNG sequence
+ * Prints files per second on one encoding thread and on one per core, for
+ * a few compression levels and filters
+ */
+TEST(ExportBenchmark, DISABLED_ImageSequence) {
+    const int width = 1280;
+    const int height = 720;
+    GradientVideo video(width, height);
+    Timeline timeline;
+    timeline.addTrack("Video");
+    timeline.addEntryToTrack(0, TimelineEntry(&video, 0.0, 0.5));
+    const Rational rate(30, 1);
+    const std::string filename = ::testing::TempDir() + "bench_sequence.png";
+
+    struct Case {
+        const char* name;
+        int level;
+        PngFilter filter;
+    };
+    const Case cases[] = {{"stored", 0, PngFilter::NONE},
+                          {"level 1, Paeth", 1, PngFilter::PAETH},
+                          {"level 8, adaptive", 8, PngFilter::ADAPTIVE}};
+    const int workerCounts[] = {1, ImageSequenceExport::getDefaultWorkerCount()};
+    for (const Case& test : cases) {
+        double filesPerSecond[2];
+        for (int i = 0; i < 2; i++) {
+            ExportSettings settings;
+            settings.format = ExportFormat::PNG;
+            settings.png.compressionLevel = test.level;
+            settings.png.filter = test.filter;
+            ImageSequenceExport sequence(workerCounts[i]);
+            ASSERT_TRUE(sequence.run(timeline, width, height, rate, filename, settings))
+                << sequence.getLastError();
+            filesPerSecond[i] = sequence.getStats().getFilesPerSecond();
+        }
+
+        FILE* file = std::fopen(ImageSequenceExport::getFrameFilename(filename, 0).c_str(), "rb");
+        long bytes = 0;
+        if (file) {
+            std::fseek(file, 0, SEEK_END);
+            bytes = std::ftell(file);
+            std::fclose(file);
+        }
+        for (int64_t frame = 0; frame < 15; frame++) {
+            std::remove(ImageSequenceExport::getFrameFilename(filename, frame).c_str());
+        }
+        std::printf("[ bench    ] 720p PNG %s: %.1f files/s on one thread, %.1f files/s on %d "
+                    "(%.2f MB per file)\n", test.name, filesPerSecond[0], filesPerSecond[1],
+                    workerCounts[1], bytes / (1024.0 * 1024.0));
+    }
+}
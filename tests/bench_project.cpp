@@ -0,0 +1,139 @@
+/**
+ * @file bench_project.cpp
+ * @brief Benchmarks for saving and opening large projects
+ *
+ * Not a correctness test: prints how long a 10k entry project takes to
+ * save and open in the binary and JSON formats.
+ * Disabled in test runs; run them with --gtest_also_run_disabled_tests
+ * --gtest_filter=ProjectBenchmark.*
+ */
+
+#include <gtest/gtest.h>
+#include "project/ProjectFile.h"
+#include "timeline/Timeline.h"
+#include "Image.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+/**
+ * @brief Asset that is never rendered, only placed
+ */
+class PlaceholderAsset : public IAsset {
+public:
+    PlaceholderAsset() : frame(1, 1) {}
+
+    double getDuration() const override { return 60.0; }
+    const Image& getFrame(double time = 0.0) override { return frame; }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+private:
+    Image frame;
+};
+
+/**
+ * @brief Factory that is never asked for anything when opening
+ */
+class UnusedFactory : public IAssetFactory {
+public:
+    IAsset* create(const std::string& value) const override { return nullptr; }
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+long fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return static_cast<long>(file.tellg());
+}
+
+} // namespace
+
+/**
+ * Benchmark: save and open a 10k entry project
+ * Purpose: Opening should take milliseconds: the binary file is mapped and
+ * read once, and no asset is loaded
+ */
+TEST(ProjectBenchmark, DISABLED_TenThousandEntries) {
+    const int trackCount = 4;
+    const int entriesPerTrack = 2500;
+    const int runs = 10;
+
+    std::vector<PlaceholderAsset> assets(50);
+    Project project;
+    for (size_t i = 0; i < assets.size(); i++) {
+        project.assetSources.push_back("footage/clip_" + std::to_string(i) + ".mp4");
+        project.assets.push_back(&assets[i]);
+    }
+
+    // Every fourth entry fades in, so some entries carry keyframes
+    Timeline timeline;
+    for (int t = 0; t < trackCount; t++) {
+        Track* track = timeline.getTrack(timeline.addTrack("Track " + std::to_string(t)));
+        project.trackFilters.push_back("");
+        for (int e = 0; e < entriesPerTrack; e++) {
+            TimelineEntry entry(&assets[(t * 7 + e) % assets.size()], e * 2.0, 1.5);
+            if (e % 4 == 0) {
+                KeyframeTrack fade;
+                fade.setKeyframe(Keyframe(0.0, 0.0f));
+                fade.setKeyframe(Keyframe(0.5, 1.0f));
+                entry.setKeyframes(EntryProperty::OPACITY, fade);
+            }
+            track->addEntry(entry);
+        }
+    }
+
+    UnusedFactory factory;
+    ProjectFile file(&factory);
+    const std::string binaryPath = ::testing::TempDir() + "bench_project.vedp";
+    const std::string jsonPath = ::testing::TempDir() + "bench_project.json";
+
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(file.save(binaryPath, project, timeline)) << file.getLastError();
+    double save = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(file.exportJson(jsonPath, project, timeline)) << file.getLastError();
+    double exportJson = millisecondsSince(start);
+
+    double load = 0.0;
+    double importJson = 0.0;
+    for (int r = 0; r < runs; r++) {
+        Project loaded;
+        Timeline opened;
+        start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(file.load(binaryPath, loaded, opened)) << file.getLastError();
+        load += millisecondsSince(start) / runs;
+        EXPECT_EQ(opened.getTotalTicks(), timeline.getTotalTicks());
+        for (IAsset* asset : loaded.assets) {
+            delete asset;
+        }
+    }
+    for (int r = 0; r < 3; r++) {
+        Project loaded;
+        Timeline opened;
+        start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(file.importJson(jsonPath, loaded, opened)) << file.getLastError();
+        importJson += millisecondsSince(start) / 3;
+        for (IAsset* asset : loaded.assets) {
+            delete asset;
+        }
+    }
+
+    std::printf("[ bench    ] %d entries: open %.2f ms, save %.2f ms (%ld KB); "
+                "JSON import %.2f ms, export %.2f ms (%ld KB)\n",
+                trackCount * entriesPerTrack, load, save, fileSize(binaryPath) / 1024,
+                importJson, exportJson, fileSize(jsonPath) / 1024);
+    std::remove(binaryPath.c_str());
+    std::remove(jsonPath.c_str());
+}
@@ -0,0 +1,317 @@
+/**
+ * @file bench_timeline.cpp
+ * @brief Benchmarks for looking up and editing entries on long timelines
+ *
+ * Not a correctness test: each case prints its timings next to the way
+ * the same work used to be done (a linear scan, a sorted vector, or a
+ * full copy of the entries per undo step).
+ * Disabled in test runs; run them with --gtest_also_run_disabled_tests
+ * --gtest_filter=TimelineBenchmark.*
+ */
+
+#include <gtest/gtest.h>
+#include "commands/EditCommands.h"
+#include "commands/EditHistory.h"
+#include "timeline/Timeline.h"
+#include "Image.h"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+/**
+ * @brief Asset that is never rendered, only placed
+ */
+class PlaceholderAsset : public IAsset {
+public:
+    PlaceholderAsset() : frame(1, 1) {}
+
+    double getDuration() const override { return 1.0e6; }
+    const Image& getFrame(double time = 0.0) override { return frame; }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return false; }
+    AssetType getAssetType() const override { return AssetType::IMAGE; }
+
+private:
+    Image frame;
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+const TimelineEntry* scanEntries(const Track& track, double time) {
+    for (const TimelineEntry& entry : track.getEntries()) {
+        if (entry.isActiveAt(time)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Entries in a sorted vector, edited the way Track used to be
+ *
+ * Moving an entry rotates it into place; a ripple rewrites every later
+ * start time.
+ */
+struct VectorTrack {
+    std::vector<TimelineEntry> entries;
+
+    static bool startsAfter(Ticks time, const TimelineEntry& entry) {
+        return time < entry.getStartTicks();
+    }
+
+    void move(size_t index, Ticks start) {
+        TimelineEntry entry = entries[index];
+        entries.erase(entries.begin() + index);
+        entry.setStartTicks(start);
+        entries.insert(std::upper_bound(entries.begin(), entries.end(), start,
+                                        startsAfter),
+                       entry);
+    }
+
+    void shift(size_t index, Ticks offset) {
+        for (size_t i = index; i < entries.size(); i++) {
+            entries[i].setStartTicks(entries[i].getStartTicks() + offset);
+        }
+    }
+};
+
+} // namespace
+
+// ==============================================================================
+// Lookups
+// ==============================================================================
+
+/**
+ * Benchmark: 100k entries on 4 tracks, about 28 hours of 1s clips with gaps
+ * Playback at 30 fps, random seeks and the per-frame total duration query
+ */
+TEST(TimelineBenchmark, DISABLED_HundredThousandEntries) {
+    const int tracks = 4;
+    const int perTrack = 25000;
+    PlaceholderAsset asset;
+    Timeline timeline;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < tracks; t++) {
+        timeline.addTrack("Clips");
+        for (int i = 0; i < perTrack; i++) {
+            timeline.addEntryToTrack(t, TimelineEntry(&asset, i * 4.0 + t, 3.0));
+        }
+    }
+    double build = millisecondsSince(start);
+    double duration = timeline.getTotalDuration();
+
+    // Playback: every track is queried every frame
+    const int frames = 30 * 60 * 10;
+    const double playFrom = duration / 2.0;
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        for (const Track* track : timeline.getTracks()) {
+            found += track->getEntryAt(playFrom + f / 30.0) != nullptr;
+        }
+    }
+    double sequential = millisecondsSince(start) / frames;
+
+    const int scanFrames = 30;
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < scanFrames; f++) {
+        for (const Track* track : timeline.getTracks()) {
+            found += scanEntries(*track, playFrom + f / 30.0) != nullptr;
+        }
+    }
+    double scan = millisecondsSince(start) / scanFrames;
+
+    // Scrubbing: random times
+    const int seeks = 100000;
+    std::vector<double> times(seeks);
+    std::srand(3);
+    for (double& time : times) {
+        time = duration * std::rand() / RAND_MAX;
+    }
+    start = std::chrono::steady_clock::now();
+    for (double time : times) {
+        found += timeline.getTrack(0)->getEntryAt(time) != nullptr;
+    }
+    double seek = millisecondsSince(start) * 1000.0 / seeks;
+
+    start = std::chrono::steady_clock::now();
+    double total = 0.0;
+    for (int f = 0; f < frames; f++) {
+        total += timeline.getTotalDuration();
+    }
+    double durationQuery = millisecondsSince(start) * 1000.0 / frames;
+
+    std::printf("[ bench    ] %d entries: build %.1f ms, playback %.4f ms/frame "
+                "(scan %.2f ms/frame), seek %.3f us, duration %.4f us\n",
+                tracks * perTrack, build, sequential, scan, seek, durationQuery);
+    EXPECT_GT(found, 0u);
+    EXPECT_GT(total, 0.0);
+}
+
+// ==============================================================================
+// Edits
+// ==============================================================================
+
+/**
+ * Benchmark: Dragging and ripple edits on tracks of 1k, 10k and 100k entries
+ * A drag moves one entry back and forth across its neighbours once per
+ * mouse event; a ripple trims an early entry so everything after it moves
+ */
+TEST(TimelineBenchmark, DISABLED_EditOperations) {
+    const int sizes[] = {1000, 10000, 100000};
+    const int edits = 2000;
+    PlaceholderAsset asset;
+
+    for (int count : sizes) {
+        Track track;
+        VectorTrack reference;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++) {
+            track.addEntry(TimelineEntry(&asset, i * 2.0, 1.0));
+        }
+        double build = millisecondsSince(start);
+        for (const TimelineEntry& entry : track.getEntries()) {
+            reference.entries.push_back(entry);
+        }
+
+        // Drag the entry in the middle into a gap near it and back
+        const size_t middle = count / 2;
+        const double home = middle * 2.0;
+        start = std::chrono::steady_clock::now();
+        for (int e = 0; e < edits; e++) {
+            double to = (middle + e % 20 - 10) * 2.0 + 1.0;
+            track.updateEntryStartTime(middle, to);
+            track.updateEntryStartTime(track.getEntryIndexAt(to), home);
+        }
+        double drag = millisecondsSince(start) * 1000.0 / (2 * edits);
+
+        const int vectorEdits = count >= 100000 ? 100 : edits;
+        start = std::chrono::steady_clock::now();
+        for (int e = 0; e < vectorEdits; e++) {
+            Ticks to = secondsToTicks((middle + e % 20 - 10) * 2.0 + 1.0);
+            reference.move(middle, to);
+            size_t index = std::upper_bound(reference.entries.begin(),
+                                            reference.entries.end(), to,
+                                            VectorTrack::startsAfter) -
+                           reference.entries.begin() - 1;
+            reference.move(index, secondsToTicks(home));
+        }
+        double vectorDrag = millisecondsSince(start) * 1000.0 / (2 * vectorEdits);
+        EXPECT_EQ(track.getEntry(middle).getStartTime(), home);
+
+        // Ripple trim at the start: every entry after it moves
+        start = std::chrono::steady_clock::now();
+        for (int e = 0; e < edits; e++) {
+            track.updateEntryDuration(1, (e % 2) ? 1.0 : 1.5, true);
+        }
+        double ripple = millisecondsSince(start) * 1000.0 / edits;
+
+        start = std::chrono::steady_clock::now();
+        for (int e = 0; e < vectorEdits; e++) {
+            reference.shift(2, secondsToTicks((e % 2) ? -0.5 : 0.5));
+        }
+        double vectorRipple = millisecondsSince(start) * 1000.0 / vectorEdits;
+
+        // Reading every entry back brings all the lazy offsets down
+        start = std::chrono::steady_clock::now();
+        Ticks last = 0;
+        for (const TimelineEntry& entry : track.getEntries()) {
+            last = std::max(last, entry.getEndTicks());
+        }
+        double iterate = millisecondsSince(start);
+
+        std::printf("[ bench    ] %6d entries: build %.1f ms, drag %.2f us "
+                    "(vector %.2f us), ripple %.2f us (vector %.2f us), "
+                    "read all %.2f ms\n",
+                    count, build, drag, vectorDrag, ripple, vectorRipple, iterate);
+        EXPECT_EQ(track.getEntryCount(), static_cast<size_t>(count));
+        EXPECT_EQ(last, track.getTotalTicks());
+    }
+}
+
+/**
+ * Benchmark: undo and redo on a 100k entry timeline
+ * Purpose: Show steps cost as much as the edit they reverse, and keep only
+ * what they changed, compared with copying the entries for every step
+ */
+TEST(TimelineBenchmark, DISABLED_UndoRedo) {
+    PlaceholderAsset asset;
+    const int count = 100000;
+    const int steps = 10000;
+    Timeline timeline;
+    timeline.addTrack();
+    for (int i = 0; i < count; i++) {
+        timeline.addEntryToTrack(0, TimelineEntry(&asset, i * 2.0, 1.0));
+    }
+    const Track& track = *timeline.getTrack(0);
+    EditHistory history(1024 * 1024 * 1024);
+
+    // One drag of a thousand mouse moves is a single step
+    const size_t middle = count / 2;
+    auto start = std::chrono::steady_clock::now();
+    for (int m = 0; m < 1000; m++) {
+        history.perform(new MoveEntryCommand(&timeline, 0, middle,
+                                             middle * 2.0 + (m % 100) * 0.01));
+    }
+    double drag = millisecondsSince(start) * 1000.0 / 1000;
+    EXPECT_EQ(history.getUndoCount(), 1u);
+    history.seal();
+
+    // Separate steps: moves, trims and ripple trims spread over the track
+    std::srand(7);
+    start = std::chrono::steady_clock::now();
+    for (int e = 0; e < steps; e++) {
+        size_t index = std::rand() % (count - 1);
+        double length = 1.0 + (std::rand() % 50) * 0.01;
+        switch (e % 3) {
+        case 0:
+            history.perform(new MoveEntryCommand(
+                &timeline, 0, index, track.getEntry(index).getStartTime() + 0.25));
+            break;
+        case 1:
+            history.perform(new ResizeEntryCommand(&timeline, 0, index, length));
+            break;
+        default:
+            history.perform(new ResizeEntryCommand(&timeline, 0, index, length, true));
+            break;
+        }
+        history.seal();
+    }
+    double perform = millisecondsSince(start) * 1000.0 / steps;
+    size_t recorded = history.getUndoCount();
+    Ticks edited = track.getTotalTicks();
+
+    start = std::chrono::steady_clock::now();
+    while (history.undo()) {
+    }
+    double undo = millisecondsSince(start) * 1000.0 / recorded;
+
+    start = std::chrono::steady_clock::now();
+    while (history.redo()) {
+    }
+    double redo = millisecondsSince(start) * 1000.0 / recorded;
+    EXPECT_EQ(track.getTotalTicks(), edited);
+
+    // What keeping a copy of the entries for every step would cost
+    start = std::chrono::steady_clock::now();
+    std::vector<TimelineEntry> copy(track.getEntries().begin(), track.getEntries().end());
+    double snapshot = millisecondsSince(start) * 1000.0;
+
+    std::printf("[ bench    ] %d entries, %zu steps: drag move %.2f us, edit %.2f us, "
+                "undo %.2f us, redo %.2f us (copying entries %.0f us/step), "
+                "history %.2f MB (copies %.0f MB)\n",
+                count, recorded, drag, perform, undo, redo, snapshot,
+                history.getMemoryUsage() / 1048576.0,
+                recorded * copy.size() * sizeof(TimelineEntry) / 1048576.0);
+    EXPECT_EQ(copy.size(), static_cast<size_t>(count));
+}
@@ -0,0 +1,418 @@
+/**
+ * @file test_blend_parity.cpp
+ * @brief CPU vs GPU compositing parity tests
+ *
+ * Renders the same timeline with Timeline::renderFrameInto (CPU) and with
+ * the generated TrackShader (GPU) and compares the results for every blend
+ * mode. GPU tests are skipped when no OpenGL 3.3 context can be created
+ * (e.g. headless CI without a display).
+ */
+
+#include <gtest/gtest.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "compositor/Blend.h"
+#include "graphics/ShaderProgram.h"
+#include "graphics/Quad.h"
+#include "graphics/Texture.h"
+#include "timeline/Timeline.h"
+#include "assets/IAsset.h"
+#include "Image.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+// Asset that always shows the same image
+class StillAsset : public IAsset {
+public:
+    explicit StillAsset(const Image& image) : image(image) {}
+    double getDuration() const override { return 10.0; }
+    const Image& getFrame(double time = 0.0) override { return image; }
+    const Image& getThumbnail() override { return image; }
+    bool isVideo() const override { return false; }
+    AssetType getAssetType() const override { return AssetType::IMAGE; }
+
+private:
+    Image image;
+};
+
+} // namespace
+
+// ==============================================================================
+// Shader Source Tests
+// ==============================================================================
+
+/**
+ * Test: Only blend modes in use are compiled into the shader
+ * Purpose: Verify unused blend functions are left out of the GLSL
+ */
+TEST(TrackShaderSourceTest, OnlyUsedBlendModesAreEmitted) {
+    std::vector<std::string> filters(3, "");
+    std::vector<BlendMode> modes;
+    modes.push_back(BlendMode::NORMAL);
+    modes.push_back(BlendMode::MULTIPLY);
+    modes.push_back(BlendMode::MULTIPLY);
+
+    std::string source = TrackShader::fragmentSource(filters, modes);
+
+    EXPECT_NE(source.find("vec3 blendMultiply("), std::string::npos);
+    EXPECT_EQ(source.find("vec3 blendMultiply("),
+              source.rfind("vec3 blendMultiply("));
+    EXPECT_EQ(source.find("blendScreen"), std::string::npos);
+    EXPECT_EQ(source.find("blendOverlay"), std::string::npos);
+}
+
+/**
+ * Test: Missing blend modes default to normal
+ * Purpose: Verify filters-only updates still produce a valid shader
+ */
+TEST(TrackShaderSourceTest, MissingModesAreNormal) {
+    std::vector<std::string> filters(2, "");
+    std::string source = TrackShader::fragmentSource(filters, std::vector<BlendMode>());
+    EXPECT_EQ(source.find("vec3 blend"), std::string::npos);
+    EXPECT_NE(source.find("sampler2DArray layers"), std::string::npos);
+}
+
+/**
+ * Test: The shader doesn't depend on the number of tracks
+ * Purpose: Verify tracks without filters add nothing to the GLSL, so
+ * adding one never recompiles, and filters only branch on their own track
+ */
+TEST(TrackShaderSourceTest, SourceDoesNotGrowWithTracks) {
+    std::vector<BlendMode> modes(2, BlendMode::SCREEN);
+    std::string two = TrackShader::fragmentSource(std::vector<std::string>(2, ""), modes);
+    std::string hundred = TrackShader::fragmentSource(std::vector<std::string>(100, ""), modes);
+    EXPECT_EQ(two, hundred);
+
+    std::vector<std::string> filters(100, "");
+    filters[42] = "trackColor.r = 0.0;";
+    std::string filtered = TrackShader::fragmentSource(filters, modes);
+    EXPECT_NE(filtered.find("if (track == 42)"), std::string::npos);
+    EXPECT_EQ(filtered.find("if (track == 41)"), std::string::npos);
+}
+
+// ==============================================================================
+// GPU Parity Tests
+// ==============================================================================
+
+class BlendParityTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        window = nullptr;
+        if (!glfwInit()) {
+            GTEST_SKIP() << "GLFW could not be initialized";
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(WIDTH, HEIGHT, "parity", NULL, NULL);
+        if (!window) {
+            glfwTerminate();
+            GTEST_SKIP() << "No OpenGL 3.3 context available";
+        }
+        glfwMakeContextCurrent(window);
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            glfwDestroyWindow(window);
+            window = nullptr;
+            glfwTerminate();
+            GTEST_SKIP() << "Could not load OpenGL functions";
+        }
+    }
+
+    void TearDown() override {
+        if (window) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+    }
+
+    // Horizontal ramp in one channel, vertical ramp in another, premultiplied
+    // like every asset frame
+    static Image makeGradient(int alpha, bool flip) {
+        Image image(WIDTH, HEIGHT);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                int gx = x * 255 / (WIDTH - 1);
+                int gy = y * 255 / (HEIGHT - 1);
+                if (flip) {
+                    image.setPixel(x, y, Color(gy, 255 - gx, gx, alpha));
+                } else {
+                    image.setPixel(x, y, Color(gx, gy, 255 - gy, alpha));
+                }
+            }
+        }
+        premultiplySpan(image.getData(), WIDTH * HEIGHT);
+        return image;
+    }
+
+    // Render the timeline's tracks through the TrackShader and read them back
+    Image renderOnGPU(const Timeline& timeline, double time) {
+        std::vector<std::string> filters;
+        std::vector<BlendMode> modes;
+        for (size_t i = 0; i < timeline.getTrackCount(); i++) {
+            filters.push_back("");
+            modes.push_back(timeline.getTrack(i)->getBlendMode());
+        }
+
+        TrackShader shader("../src/graphics/shaders/");
+        shader.update(filters, modes);
+        Quad quad;
+
+        // Off-screen RGBA8 target the size of the frame
+        unsigned int fbo, target;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenTextures(1, &target);
+        glBindTexture(GL_TEXTURE_2D, target);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, WIDTH, HEIGHT, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, NULL);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                               GL_TEXTURE_2D, target, 0);
+        glViewport(0, 0, WIDTH, HEIGHT);
+
+        shader.use();
+        shader.setFloat("duration", 1.0f);
+        shader.setFloat("timeSinceStart", static_cast<float>(time));
+        shader.setVec2("frameSize", WIDTH, HEIGHT);
+        shader.setVec3("offset", 0.0f, 0.0f, 0.0f);
+        shader.setVec3("scale", 1.0f, 1.0f, 1.0f);
+        shader.setBackgroundColor(timeline.getBackgroundColor());
+        shader.setLinearLight(timeline.getCompositingMode() ==
+                              CompositingMode::LINEAR_16BIT);
+
+        for (size_t i = 0; i < timeline.getTrackCount(); i++) {
+            const Track* track = timeline.getTrack(i);
+            Track::ActiveTransition active;
+            if (track->getTransitionAt(time, active)) {
+                shader.setTrackFrame(i, active.from->getFrameAt(time),
+                                     active.from->getTransformAt(time));
+                shader.setTrackTransition(i, *active.transition, active.progress,
+                                          active.to->getFrameAt(time),
+                                          active.to->getTransformAt(time));
+                continue;
+            }
+            const TimelineEntry* entry = track->getEntryAt(time);
+            if (entry) {
+                shader.setTrackFrame(i, entry->getFrameAt(time), entry->getTransformAt(time));
+            } else {
+                shader.clearTrackFrame(i);
+            }
+            shader.clearTrackTransition(i);
+        }
+        shader.bindLayers();
+        quad.draw();
+
+        // Rows come back bottom-up
+        std::vector<unsigned char> pixels(WIDTH * HEIGHT * 4);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        Image result(WIDTH, HEIGHT);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                const unsigned char* p = &pixels[((HEIGHT - 1 - y) * WIDTH + x) * 4];
+                result.setPixel(x, y, Color(p[0], p[1], p[2], p[3]));
+            }
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteTextures(1, &target);
+        glDeleteFramebuffers(1, &fbo);
+        return result;
+    }
+
+    static const int WIDTH = 64;
+    static const int HEIGHT = 32;
+    GLFWwindow* window;
+};
+
+/**
+ * Test: CPU and GPU compositing agree for every blend mode
+ * Purpose: Verify the SIMD kernels and the generated GLSL produce the same
+ * frame (within 8-bit rounding of each layer)
+ */
+TEST_F(BlendParityTest, CpuMatchesGpuForAllBlendModes) {
+    StillAsset base(makeGradient(255, false));
+    StillAsset top(makeGradient(200, true));
+
+    for (int m = 0; m < BLEND_MODE_COUNT; m++) {
+        BlendMode mode = static_cast<BlendMode>(m);
+
+        Timeline timeline;
+        timeline.addTrack("Base");
+        timeline.addTrack("Top");
+        timeline.getTrack(0)->addEntry(TimelineEntry(&base, 0.0, 1.0));
+        TimelineEntry entry(&top, 0.0, 1.0);
+        EntryTransform transform;
+        transform.opacity = 0.8f;
+        entry.setTransform(transform);
+        timeline.getTrack(1)->addEntry(entry);
+        timeline.getTrack(1)->setBlendMode(mode);
+
+        Image cpu(WIDTH, HEIGHT);
+        timeline.renderFrameInto(0.5, cpu);
+        Image gpu = renderOnGPU(timeline, 0.5);
+
+        int maxDiff = 0;
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                Color a = cpu.getPixel(x, y);
+                Color b = gpu.getPixel(x, y);
+                maxDiff = std::max(maxDiff, std::abs(a.red() - b.red()));
+                maxDiff = std::max(maxDiff, std::abs(a.green() - b.green()));
+                maxDiff = std::max(maxDiff, std::abs(a.blue() - b.blue()));
+            }
+        }
+        EXPECT_LE(maxDiff, 3) << blendModeName(mode);
+    }
+}
+
+/**
+ * Test: CPU and GPU transitions agree
+ * Purpose: Verify every transition type mixes the outgoing and incoming
+ * entries the same way in the preview shader and the CPU renderer
+ */
+TEST_F(BlendParityTest, CpuMatchesGpuForAllTransitions) {
+    StillAsset outgoing(makeGradient(255, false));
+    StillAsset incoming(makeGradient(255, true));
+
+    for (int t = 0; t < TRANSITION_TYPE_COUNT; t++) {
+        Transition transition(static_cast<TransitionType>(t), 1.0);
+        transition.color = Color(40, 200, 90, 255);
+
+        Timeline timeline;
+        timeline.addTrack("Video");
+        timeline.getTrack(0)->addEntry(TimelineEntry(&outgoing, 0.0, 1.0));
+        timeline.getTrack(0)->addEntry(TimelineEntry(&incoming, 1.0, 1.0));
+        ASSERT_TRUE(timeline.getTrack(0)->setTransition(0, transition));
+
+        const double times[] = {0.7, 1.1};
+        for (int i = 0; i < 2; i++) {
+            Image cpu(WIDTH, HEIGHT);
+            timeline.renderFrameInto(times[i], cpu);
+            Image gpu = renderOnGPU(timeline, times[i]);
+
+            int maxDiff = 0;
+            for (int y = 0; y < HEIGHT; y++) {
+                for (int x = 0; x < WIDTH; x++) {
+                    Color a = cpu.getPixel(x, y);
+                    Color b = gpu.getPixel(x, y);
+                    maxDiff = std::max(maxDiff, std::abs(a.red() - b.red()));
+                    maxDiff = std::max(maxDiff, std::abs(a.green() - b.green()));
+                    maxDiff = std::max(maxDiff, std::abs(a.blue() - b.blue()));
+                }
+            }
+            EXPECT_LE(maxDiff, 3) << transitionTypeName(transition.type)
+                                  << " at " << times[i];
+        }
+    }
+}
+
+/**
+ * Test: CPU and GPU agree when blending in linear light
+ * Purpose: Verify the shader's transfer functions match the CPU tables and
+ * that layers are converted at the same points
+ */
+TEST_F(BlendParityTest, CpuMatchesGpuInLinearLight) {
+    StillAsset base(makeGradient(255, false));
+    StillAsset top(makeGradient(200, true));
+
+    for (int m = 0; m < BLEND_MODE_COUNT; m++) {
+        BlendMode mode = static_cast<BlendMode>(m);
+
+        Timeline timeline;
+        timeline.setCompositingMode(CompositingMode::LINEAR_16BIT);
+        timeline.addTrack("Base");
+        timeline.addTrack("Top");
+        timeline.getTrack(0)->addEntry(TimelineEntry(&base, 0.0, 1.0));
+        TimelineEntry entry(&top, 0.0, 1.0);
+        EntryTransform transform;
+        transform.opacity = 0.8f;
+        entry.setTransform(transform);
+        timeline.getTrack(1)->addEntry(entry);
+        timeline.getTrack(1)->setBlendMode(mode);
+
+        Image cpu(WIDTH, HEIGHT);
+        timeline.renderFrameInto(0.5, cpu);
+        Image gpu = renderOnGPU(timeline, 0.5);
+
+        int maxDiff = 0;
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                Color a = cpu.getPixel(x, y);
+                Color b = gpu.getPixel(x, y);
+                maxDiff = std::max(maxDiff, std::abs(a.red() - b.red()));
+                maxDiff = std::max(maxDiff, std::abs(a.green() - b.green()));
+                maxDiff = std::max(maxDiff, std::abs(a.blue() - b.blue()));
+            }
+        }
+        EXPECT_LE(maxDiff, 3) << blendModeName(mode);
+    }
+}
+
+/**
+ * Test: Many tracks of different sizes composite in one draw
+ * Purpose: Verify 72 tracks (more than any GPU has texture units) with
+ * frames of different sizes, placements and blend modes, one of them in a
+ * transition, match the CPU compositor
+ */
+TEST_F(BlendParityTest, CpuMatchesGpuForManyTracks) {
+    const int trackCount = 72;
+    std::vector<StillAsset*> assets;
+    Timeline timeline;
+    for (int t = 0; t < trackCount; t++) {
+        // Frames from 8x4 up to 2x the output size, each a different ramp
+        int w = 8 + (t * 13) % (WIDTH * 2 - 8);
+        int h = 4 + (t * 7) % (HEIGHT * 2 - 4);
+        Image frame(w, h);
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                frame.setPixel(x, y, Color((t * 37 + x * 255 / w) % 256, y * 255 / h,
+                                           (t * 91) % 256, 96 + (t * 53) % 160));
+            }
+        }
+        premultiplySpan(frame.getData(), w * h);
+        assets.push_back(new StillAsset(frame));
+
+        timeline.addTrack("Track " + std::to_string(t));
+        TimelineEntry entry(assets.back(), 0.0, 1.0);
+        EntryTransform transform;
+        transform.positionX = 0.2f + 0.6f * ((t * 5) % trackCount) / trackCount;
+        transform.positionY = 0.2f + 0.6f * ((t * 11) % trackCount) / trackCount;
+        transform.scaleX = 0.3f + 0.01f * (t % 40);
+        transform.scaleY = 0.3f + 0.01f * ((t * 3) % 40);
+        transform.opacity = 0.6f;
+        entry.setTransform(transform);
+        timeline.getTrack(t)->addEntry(entry);
+        timeline.getTrack(t)->setBlendMode(static_cast<BlendMode>(t % BLEND_MODE_COUNT));
+    }
+    // The last track cross-fades into the first track's frame
+    timeline.getTrack(trackCount - 1)->addEntry(TimelineEntry(assets[0], 1.0, 1.0));
+    ASSERT_TRUE(timeline.getTrack(trackCount - 1)->setTransition(
+        0, Transition(TransitionType::CROSSFADE, 1.0)));
+
+    Image cpu(WIDTH, HEIGHT);
+    timeline.renderFrameInto(0.75, cpu);
+    Image gpu = renderOnGPU(timeline, 0.75);
+
+    int maxDiff = 0;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            Color a = cpu.getPixel(x, y);
+            Color b = gpu.getPixel(x, y);
+            maxDiff = std::max(maxDiff, std::abs(a.red() - b.red()));
+            maxDiff = std::max(maxDiff, std::abs(a.green() - b.green()));
+            maxDiff = std::max(maxDiff, std::abs(a.blue() - b.blue()));
+        }
+    }
+    // The CPU rounds to 8 bits after each of the 72 layers
+    EXPECT_LE(maxDiff, 6);
+
+    for (size_t i = 0; i < assets.size(); i++) {
+        delete assets[i];
+    }
+}
@@ -0,0 +1,393 @@
+/**
+ * @file test_compositor.cpp
+ * @brief Unit tests for the CPU compositing kernels
+ *
+ * Tests the span blending kernel, the premultiplied-alpha conversions and the
+ * affine blitter used by the Timeline to place layers (position, scale,
+ * rotation, opacity) inside a frame.
+ */
+
+#include <gtest/gtest.h>
+#include "compositor/AffineBlitter.h"
+#include "compositor/Blend.h"
+#include "timeline/EntryTransform.h"
+#include "Image.h"
+#include "graphics/Color.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace csci3081;
+
+// ==============================================================================
+// Test Fixture
+// ==============================================================================
+
+class CompositorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        frame = new Image(40, 20);
+        frame->fill(Color(0, 0, 0, 255));
+
+        layer = new Image(10, 10);
+        layer->fill(Color(255, 255, 255, 255));
+    }
+
+    void TearDown() override {
+        delete frame;
+        delete layer;
+    }
+
+    // Count pixels whose red channel was changed from black
+    int countTouched() const {
+        int touched = 0;
+        for (int y = 0; y < frame->getHeight(); y++) {
+            for (int x = 0; x < frame->getWidth(); x++) {
+                if (frame->getPixel(x, y).red() > 0) {
+                    touched++;
+                }
+            }
+        }
+        return touched;
+    }
+
+    Image* frame;
+    Image* layer;
+};
+
+// ==============================================================================
+// Blend Kernel Tests
+// ==============================================================================
+
+/**
+ * Test: Opaque source replaces the destination
+ * Purpose: Verify "over" with alpha 255 and full opacity
+ */
+TEST_F(CompositorTest, BlendOpaqueReplaces) {
+    unsigned char dst[4] = {10, 20, 30, 255};
+    unsigned char src[4] = {200, 100, 50, 255};
+    blendSpanOver(dst, src, 1, 255);
+
+    EXPECT_EQ(dst[0], 200);
+    EXPECT_EQ(dst[1], 100);
+    EXPECT_EQ(dst[2], 50);
+    EXPECT_EQ(dst[3], 255);
+}
+
+/**
+ * Test: Half opacity averages source and destination
+ * Purpose: Verify opacity scales the source alpha
+ */
+TEST_F(CompositorTest, BlendHalfOpacity) {
+    unsigned char dst[4] = {0, 0, 0, 255};
+    unsigned char src[4] = {255, 255, 255, 255};
+    blendSpanOver(dst, src, 1, 128);
+
+    EXPECT_NEAR(dst[0], 128, 1);
+    EXPECT_EQ(dst[3], 255);
+}
+
+/**
+ * Test: Vector and scalar paths agree
+ * Purpose: Spans of 4+ pixels use SSE2, the tail is scalar; both must give
+ * the same result for the same inputs
+ */
+TEST_F(CompositorTest, BlendVectorMatchesScalarTail) {
+    const int count = 11;
+    std::vector<unsigned char> src(count * 4), dst(count * 4);
+    std::srand(42);
+    for (int i = 0; i < count * 4; i++) {
+        src[i] = static_cast<unsigned char>(std::rand() % 256);
+        dst[i] = static_cast<unsigned char>(std::rand() % 256);
+    }
+
+    // Blend all at once (vector body + tail) and one pixel at a time (tail only)
+    std::vector<unsigned char> together(dst), single(dst);
+    blendSpanOver(together.data(), src.data(), count, 200);
+    for (int i = 0; i < count; i++) {
+        blendSpanOver(&single[i * 4], &src[i * 4], 1, 200);
+    }
+
+    EXPECT_EQ(together, single);
+}
+
+// ==============================================================================
+// Affine Blitter Tests
+// ==============================================================================
+
+/**
+ * Test: Default transform fills the whole frame
+ * Purpose: Verify backward-compatible stretch-to-fit behavior
+ */
+TEST_F(CompositorTest, DefaultTransformFillsFrame) {
+    AffineBlitter::blit(*layer, *frame, EntryTransform());
+    EXPECT_EQ(countTouched(), 40 * 20);
+}
+
+/**
+ * Test: Scaled layer only touches its bounding box
+ * Purpose: Verify picture-in-picture placement and that pixels outside the
+ * layer are left alone
+ */
+TEST_F(CompositorTest, ScaledLayerTouchesOnlyItsBox) {
+    EntryTransform t;
+    t.positionX = 0.25f;   // center at x = 10
+    t.positionY = 0.5f;    // center at y = 10
+    t.scaleX = 0.5f;       // 20 pixels wide
+    t.scaleY = 0.5f;       // 10 pixels tall
+    AffineBlitter::blit(*layer, *frame, t);
+
+    EXPECT_EQ(countTouched(), 20 * 10);
+    EXPECT_EQ(frame->getPixel(10, 10).red(), 255);
+    EXPECT_EQ(frame->getPixel(0, 0).red(), 0);
+    EXPECT_EQ(frame->getPixel(30, 10).red(), 0);
+}
+
+/**
+ * Test: Layer partially outside the frame is clipped
+ * Purpose: Verify spans are clamped to the destination
+ */
+TEST_F(CompositorTest, LayerOutsideFrameIsClipped) {
+    EntryTransform t;
+    t.positionX = 1.0f;    // center on the right edge
+    t.scaleX = 0.5f;
+    t.scaleY = 1.0f;
+    AffineBlitter::blit(*layer, *frame, t);
+
+    EXPECT_EQ(countTouched(), 10 * 20);
+    EXPECT_EQ(frame->getPixel(39, 5).red(), 255);
+    EXPECT_EQ(frame->getPixel(29, 5).red(), 0);
+}
+
+/**
+ * Test: Rotation by 90 degrees swaps the layer's extent
+ * Purpose: Verify rotated layers cover the rotated footprint
+ */
+TEST_F(CompositorTest, RotationSwapsExtent) {
+    EntryTransform t;
+    t.scaleX = 0.5f;       // 20 x 10 box before rotation
+    t.scaleY = 0.5f;
+    t.rotation = 90.0f;    // 10 x 20 after rotation
+    AffineBlitter::blit(*layer, *frame, t);
+
+    EXPECT_EQ(countTouched(), 10 * 20);
+    EXPECT_EQ(frame->getPixel(20, 1).red(), 255);
+    EXPECT_EQ(frame->getPixel(12, 10).red(), 0);
+}
+
+/**
+ * Test: Zero opacity leaves the frame untouched
+ * Purpose: Verify opacity is applied and fully transparent layers are skipped
+ */
+TEST_F(CompositorTest, ZeroOpacityIsInvisible) {
+    EntryTransform t;
+    t.opacity = 0.0f;
+    AffineBlitter::blit(*layer, *frame, t);
+    EXPECT_EQ(countTouched(), 0);
+}
+
+/**
+ * Test: Bilinear sampling interpolates between texels
+ * Purpose: Verify upscaling a 2-pixel gradient produces intermediate values
+ */
+TEST_F(CompositorTest, BilinearSamplingInterpolates) {
+    Image gradient(2, 1);
+    gradient.setPixel(0, 0, Color(0, 0, 0, 255));
+    gradient.setPixel(1, 0, Color(255, 255, 255, 255));
+
+    Image wide(8, 1);
+    wide.fill(Color(0, 0, 0, 255));
+    AffineBlitter::blit(gradient, wide, EntryTransform());
+
+    EXPECT_EQ(wide.getPixel(0, 0).red(), 0);
+    EXPECT_EQ(wide.getPixel(7, 0).red(), 255);
+    int middle = wide.getPixel(4, 0).red();
+    EXPECT_GT(middle, 100);
+    EXPECT_LT(middle, 200);
+    for (int x = 1; x < 8; x++) {
+        EXPECT_GE(wide.getPixel(x, 0).red(), wide.getPixel(x - 1, 0).red());
+    }
+}
+
+// ==============================================================================
+// Blend Mode Tests
+// ==============================================================================
+
+namespace {
+
+// Floating point B(s, d) on straight colors, as in the TrackShader GLSL
+double referenceMix(BlendMode mode, double s, double d) {
+    switch (mode) {
+        case BlendMode::NORMAL: return s;
+        case BlendMode::ADD: return std::min(s + d, 1.0);
+        case BlendMode::MULTIPLY: return s * d;
+        case BlendMode::SCREEN: return s + d - s * d;
+        case BlendMode::OVERLAY:
+            return d < 0.5 ? 2.0 * s * d : 1.0 - 2.0 * (1.0 - s) * (1.0 - d);
+        case BlendMode::DARKEN: return std::min(s, d);
+        case BlendMode::LIGHTEN: return std::max(s, d);
+    }
+    return s;
+}
+
+// Random premultiplied pixels (every color channel <= alpha)
+std::vector<unsigned char> randomPremultiplied(int count) {
+    std::vector<unsigned char> pixels(count * 4);
+    for (int i = 0; i < count; i++) {
+        int alpha = std::rand() % 256;
+        for (int c = 0; c < 3; c++) {
+            pixels[i * 4 + c] = static_cast<unsigned char>(std::rand() % (alpha + 1));
+        }
+        pixels[i * 4 + 3] = static_cast<unsigned char>(alpha);
+    }
+    return pixels;
+}
+
+} // namespace
+
+/**
+ * Test: Every blend mode matches its floating point formula
+ * Purpose: Verify the 8-bit kernels stay within rounding of the premultiplied
+ * compositing equations for translucent sources and destinations
+ */
+TEST_F(CompositorTest, BlendModesMatchReference) {
+    const int count = 64;
+    std::srand(7);
+    std::vector<unsigned char> src = randomPremultiplied(count);
+    std::vector<unsigned char> dst = randomPremultiplied(count);
+
+    for (int m = 0; m < BLEND_MODE_COUNT; m++) {
+        BlendMode mode = static_cast<BlendMode>(m);
+        std::vector<unsigned char> result(dst);
+        blendSpan(result.data(), src.data(), count, 230, mode);
+
+        for (int i = 0; i < count; i++) {
+            double scale = 230 / 255.0;
+            double sa = src[i * 4 + 3] / 255.0 * scale;
+            double da = dst[i * 4 + 3] / 255.0;
+            for (int c = 0; c < 3; c++) {
+                double s = src[i * 4 + c] / 255.0 * scale;
+                double d = dst[i * 4 + c] / 255.0;
+                double expected = s * (1.0 - da) + d * (1.0 - sa);
+                if (sa > 0.0 && da > 0.0) {
+                    expected += sa * da * referenceMix(mode, s / sa, d / da);
+                }
+                if (mode == BlendMode::NORMAL) {
+                    expected = s + d * (1.0 - sa);
+                }
+                EXPECT_NEAR(result[i * 4 + c], expected * 255.0, 2.0)
+                    << blendModeName(mode) << " pixel " << i << " channel " << c;
+            }
+            EXPECT_NEAR(result[i * 4 + 3], (sa + da * (1.0 - sa)) * 255.0, 1.0)
+                << blendModeName(mode) << " pixel " << i << " alpha";
+        }
+    }
+}
+
+/**
+ * Test: Vector and scalar paths agree for every blend mode
+ * Purpose: Verify the SSE2 kernels are bit-identical to the scalar tail
+ */
+TEST_F(CompositorTest, BlendModesVectorMatchesScalar) {
+    const int count = 13;
+    std::srand(11);
+    std::vector<unsigned char> src = randomPremultiplied(count);
+    std::vector<unsigned char> dst = randomPremultiplied(count);
+
+    for (int m = 0; m < BLEND_MODE_COUNT; m++) {
+        BlendMode mode = static_cast<BlendMode>(m);
+        std::vector<unsigned char> together(dst), single(dst);
+        blendSpan(together.data(), src.data(), count, 255, mode);
+        for (int i = 0; i < count; i++) {
+            blendSpan(&single[i * 4], &src[i * 4], 1, 255, mode);
+        }
+        EXPECT_EQ(together, single) << blendModeName(mode);
+    }
+}
+
+/**
+ * Test: Blend mode is applied through the blitter
+ * Purpose: Verify multiply darkens and screen lightens a gray frame
+ */
+TEST_F(CompositorTest, BlitterUsesBlendMode) {
+    Image gray(4, 4);
+    layer->fill(Color(128, 128, 128, 255));
+
+    gray.fill(Color(128, 128, 128, 255));
+    AffineBlitter::blit(*layer, gray, EntryTransform(), BlendMode::MULTIPLY);
+    EXPECT_NEAR(gray.getPixel(1, 1).red(), 64, 1);
+
+    gray.fill(Color(128, 128, 128, 255));
+    AffineBlitter::blit(*layer, gray, EntryTransform(), BlendMode::SCREEN);
+    EXPECT_NEAR(gray.getPixel(1, 1).red(), 192, 1);
+}
+
+// ==============================================================================
+// Premultiplied Alpha Tests
+// ==============================================================================
+
+/**
+ * Test: Premultiplying and unpremultiplying round-trips opaque pixels
+ * Purpose: Verify opaque frames pass through the conversions unchanged and
+ * translucent colors come back within rounding
+ */
+TEST_F(CompositorTest, PremultiplyRoundTrips) {
+    std::vector<unsigned char> pixels;
+    for (int alpha = 0; alpha < 256; alpha += 15) {
+        for (int value = 0; value < 256; value += 17) {
+            unsigned char pixel[4] = {static_cast<unsigned char>(value), 0, 255,
+                                      static_cast<unsigned char>(alpha)};
+            pixels.insert(pixels.end(), pixel, pixel + 4);
+        }
+    }
+    int count = static_cast<int>(pixels.size() / 4);
+    std::vector<unsigned char> premultiplied(pixels);
+    premultiplySpan(premultiplied.data(), count);
+    std::vector<unsigned char> straight(pixels.size());
+    unpremultiplySpan(straight.data(), premultiplied.data(), count);
+
+    for (int i = 0; i < count; i++) {
+        int alpha = pixels[i * 4 + 3];
+        EXPECT_EQ(premultiplied[i * 4 + 3], alpha);
+        EXPECT_NEAR(premultiplied[i * 4], pixels[i * 4] * alpha / 255.0, 0.5);
+        if (alpha == 255) {
+            EXPECT_EQ(premultiplied[i * 4], pixels[i * 4]);
+            EXPECT_EQ(straight[i * 4], pixels[i * 4]);
+        } else if (alpha > 0) {
+            // One premultiplied step is worth 255 / alpha straight steps
+            EXPECT_NEAR(straight[i * 4], pixels[i * 4], 255.0 / alpha);
+            EXPECT_EQ(straight[i * 4 + 2], 255);
+        }
+    }
+
+    Color color = premultiplyColor(Color(200, 100, 0, 128));
+    EXPECT_NEAR(color.red(), 100, 1);
+    EXPECT_NEAR(color.green(), 50, 1);
+    EXPECT_EQ(color.alpha(), 128);
+}
+
+/**
+ * Test: Scaling a layer with a transparent edge leaves no dark fringe
+ * Purpose: With straight alpha, bilinear filtering mixes the black of
+ * transparent texels into the edge; premultiplied texels only fade
+ */
+TEST_F(CompositorTest, ScaledEdgeHasNoDarkFringe) {
+    Image edge(2, 1);
+    edge.setPixel(0, 0, Color(255, 0, 0, 255));
+    edge.setPixel(1, 0, Color(0, 0, 0, 0));
+    premultiplySpan(edge.getData(), 2);
+
+    Image wide(8, 1);
+    wide.fill(Color(255, 255, 255, 255));
+    AffineBlitter::blit(edge, wide, EntryTransform());
+
+    for (int x = 0; x < 8; x++) {
+        EXPECT_EQ(wide.getPixel(x, 0).red(), 255) << "x = " << x;
+        EXPECT_EQ(wide.getPixel(x, 0).alpha(), 255);
+        if (x > 0) {
+            EXPECT_GE(wide.getPixel(x, 0).green(), wide.getPixel(x - 1, 0).green());
+        }
+    }
+    EXPECT_LT(wide.getPixel(0, 0).green(), 5);
+    EXPECT_GT(wide.getPixel(7, 0).green(), 250);
+}
@@ -0,0 +1,244 @@
+/**
+ * @file test_edit_history.cpp
+ * @brief Unit tests for undoable timeline edits
+ *
+ * Tests the edit commands, merging the steps of a drag, the memory limit
+ * and grouped edits in EditHistory.
+ */
+
+#include <gtest/gtest.h>
+#include "commands/EditCommands.h"
+#include "commands/EditHistory.h"
+#include "timeline/Timeline.h"
+#include "Image.h"
+#include "graphics/Color.h"
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Asset
+// ==============================================================================
+
+/**
+ * @brief Asset that always returns the same solid-color frame
+ */
+class SolidAsset : public IAsset {
+public:
+    SolidAsset() : frame(4, 4) { frame.fill(Color(255, 0, 0, 255)); }
+
+    double getDuration() const override { return 5.0; }
+    const Image& getFrame(double time = 0.0) override { return frame; }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return false; }
+    AssetType getAssetType() const override { return AssetType::IMAGE; }
+
+private:
+    Image frame;
+};
+
+// ==============================================================================
+// Test Fixture
+// ==============================================================================
+
+class EditHistoryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        timeline.addTrack("Track");
+        // Entries at 0, 2, 4, 6, 8, one second long
+        for (int i = 0; i < 5; i++) {
+            timeline.addEntryToTrack(0, TimelineEntry(&asset, i * 2.0, 1.0));
+        }
+    }
+
+    std::vector<double> starts() const {
+        std::vector<double> result;
+        for (const TimelineEntry& entry : timeline.getTrack(0)->getEntries()) {
+            result.push_back(entry.getStartTime());
+        }
+        return result;
+    }
+
+    Track& track() { return *timeline.getTrack(0); }
+
+    SolidAsset asset;
+    Timeline timeline;
+    EditHistory history;
+};
+
+} // namespace
+
+// ==============================================================================
+// Command Tests
+// ==============================================================================
+
+/**
+ * Test: Every kind of edit can be undone and redone
+ * Purpose: Verify each command restores the exact previous state
+ */
+TEST_F(EditHistoryTest, UndoRedoRestoresEntries) {
+    const std::vector<double> original = starts();
+
+    ASSERT_TRUE(history.perform(
+        new AddEntryCommand(&timeline, 0, TimelineEntry(&asset, 4.0, 0.5), true)));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 2.0, 4.0, 4.5, 6.5, 8.5}));
+    ASSERT_TRUE(history.perform(new RemoveEntryCommand(&timeline, 0, 1, true)));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 3.0, 3.5, 5.5, 7.5}));
+    ASSERT_TRUE(history.perform(new ResizeEntryCommand(&timeline, 0, 0, 2.0, true)));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 4.0, 4.5, 6.5, 8.5}));
+    ASSERT_TRUE(history.perform(new SetTransitionCommand(
+        &timeline, 0, 1, Transition(TransitionType::WIPE, 0.4))));
+    EXPECT_TRUE(track().getEntry(1).hasOutTransition());
+
+    KeyframeTrack fade;
+    fade.setKeyframe(Keyframe(0.0, 1.0f));
+    fade.setKeyframe(Keyframe(1.0, 0.0f));
+    ASSERT_TRUE(history.perform(
+        new SetKeyframesCommand(&timeline, 0, 3, EntryProperty::OPACITY, fade)));
+    EXPECT_EQ(track().getEntry(3).getKeyframes(EntryProperty::OPACITY).getKeyframeCount(), 2u);
+    EXPECT_EQ(history.getUndoCount(), 5u);
+
+    std::vector<double> edited = starts();
+    while (history.undo()) {
+    }
+    EXPECT_EQ(starts(), original);
+    EXPECT_FALSE(track().getEntry(1).hasOutTransition());
+    EXPECT_FALSE(track().getEntry(3).getKeyframes(EntryProperty::OPACITY).isAnimated());
+    EXPECT_EQ(history.getRedoCount(), 5u);
+
+    while (history.redo()) {
+    }
+    EXPECT_EQ(starts(), edited);
+    EXPECT_TRUE(track().getEntry(1).hasOutTransition());
+    EXPECT_EQ(track().getEntry(3).getKeyframes(EntryProperty::OPACITY).getKeyframeCount(), 2u);
+}
+
+/**
+ * Test: A failed edit is not recorded
+ * Purpose: Verify overlapping or out of range edits leave the history and
+ * the timeline as they were
+ */
+TEST_F(EditHistoryTest, FailedEditIsNotRecorded) {
+    EXPECT_FALSE(history.perform(new MoveEntryCommand(&timeline, 0, 0, 1.5)));   // Onto entry 1
+    EXPECT_FALSE(history.perform(new RemoveEntryCommand(&timeline, 0, 9)));
+    EXPECT_FALSE(history.perform(new MoveEntryCommand(&timeline, 3, 0, 1.5)));   // No such track
+    EXPECT_FALSE(history.perform(new EditGroupCommand("Empty")));
+    EXPECT_FALSE(history.canUndo());
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 2.0, 4.0, 6.0, 8.0}));
+}
+
+/**
+ * Test: A new edit clears the redo stack
+ * Purpose: Verify redo never replays onto a timeline it wasn't recorded on
+ */
+TEST_F(EditHistoryTest, NewEditClearsRedo) {
+    ASSERT_TRUE(history.perform(new MoveEntryCommand(&timeline, 0, 4, 10.0)));
+    ASSERT_TRUE(history.undo());
+    EXPECT_TRUE(history.canRedo());
+
+    ASSERT_TRUE(history.perform(new RemoveEntryCommand(&timeline, 0, 0)));
+    EXPECT_FALSE(history.canRedo());
+    EXPECT_FALSE(history.redo());
+    EXPECT_EQ(starts(), (std::vector<double>{2.0, 4.0, 6.0, 8.0}));
+}
+
+// ==============================================================================
+// Merging Tests
+// ==============================================================================
+
+/**
+ * Test: The moves of one drag are a single step
+ * Purpose: Verify consecutive moves of an entry merge, including a move
+ * that jumps past another entry, and that seal() ends the step
+ */
+TEST_F(EditHistoryTest, DragMergesIntoOneStep) {
+    for (double start = 2.1; start < 2.95; start += 0.1) {
+        ASSERT_TRUE(history.perform(new MoveEntryCommand(&timeline, 0, 1, start)));
+    }
+    // Past the entries at 4, 6 and 8, then on from its new index
+    ASSERT_TRUE(history.perform(new MoveEntryCommand(&timeline, 0, 1, 9.5)));
+    ASSERT_TRUE(history.perform(new MoveEntryCommand(&timeline, 0, 4, 9.6)));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 4.0, 6.0, 8.0, 9.6}));
+    EXPECT_EQ(history.getUndoCount(), 1u);
+
+    history.seal();
+    ASSERT_TRUE(history.perform(new MoveEntryCommand(&timeline, 0, 4, 10.0)));
+    EXPECT_EQ(history.getUndoCount(), 2u);
+
+    ASSERT_TRUE(history.undo());
+    EXPECT_DOUBLE_EQ(track().getEntry(4).getStartTime(), 9.6);
+    ASSERT_TRUE(history.undo());
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 2.0, 4.0, 6.0, 8.0}));
+}
+
+/**
+ * Test: Resizes of different entries don't merge
+ * Purpose: Verify only edits continuing the same gesture are merged
+ */
+TEST_F(EditHistoryTest, DifferentEntriesDontMerge) {
+    ASSERT_TRUE(history.perform(new ResizeEntryCommand(&timeline, 0, 0, 1.5)));
+    ASSERT_TRUE(history.perform(new ResizeEntryCommand(&timeline, 0, 0, 1.8)));
+    ASSERT_TRUE(history.perform(new ResizeEntryCommand(&timeline, 0, 1, 1.5)));
+    ASSERT_TRUE(history.perform(new MoveEntryCommand(&timeline, 0, 1, 2.2)));
+    EXPECT_EQ(history.getUndoCount(), 3u);
+
+    ASSERT_TRUE(history.undo());
+    ASSERT_TRUE(history.undo());
+    EXPECT_DOUBLE_EQ(track().getEntry(1).getDuration(), 1.0);
+    EXPECT_DOUBLE_EQ(track().getEntry(0).getDuration(), 1.8);
+    ASSERT_TRUE(history.undo());
+    EXPECT_DOUBLE_EQ(track().getEntry(0).getDuration(), 1.0);
+}
+
+// ==============================================================================
+// Memory and Group Tests
+// ==============================================================================
+
+/**
+ * Test: The oldest steps are dropped past the memory limit
+ * Purpose: Verify the history stays under its limit and still undoes the
+ * most recent steps
+ */
+TEST_F(EditHistoryTest, MemoryLimitDropsOldestSteps) {
+    RemoveEntryCommand probe(&timeline, 0, 0);
+    history.setMemoryLimit(3 * probe.getMemoryUsage());
+
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(history.perform(new RemoveEntryCommand(&timeline, 0, 0)));
+    }
+    EXPECT_TRUE(track().getEntries().empty());
+    EXPECT_EQ(history.getUndoCount(), 3u);
+    EXPECT_LE(history.getMemoryUsage(), history.getMemoryLimit());
+
+    while (history.undo()) {
+    }
+    EXPECT_EQ(starts(), (std::vector<double>{4.0, 6.0, 8.0}));
+
+    history.clear();
+    EXPECT_EQ(history.getMemoryUsage(), 0u);
+}
+
+/**
+ * Test: A group is done and undone as one step
+ * Purpose: Verify a group that fails part way leaves nothing behind
+ */
+TEST_F(EditHistoryTest, GroupIsAllOrNothing) {
+    EditGroupCommand* group = new EditGroupCommand("Shuffle");
+    group->add(new RemoveEntryCommand(&timeline, 0, 0));
+    group->add(new MoveEntryCommand(&timeline, 0, 0, 0.0));
+    ASSERT_TRUE(history.perform(group));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 4.0, 6.0, 8.0}));
+    EXPECT_EQ(history.getUndoDescription(), "Shuffle");
+    ASSERT_TRUE(history.undo());
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 2.0, 4.0, 6.0, 8.0}));
+
+    group = new EditGroupCommand("Broken");
+    group->add(new RemoveEntryCommand(&timeline, 0, 0));
+    group->add(new MoveEntryCommand(&timeline, 0, 0, 4.0));   // Onto entry 1
+    EXPECT_FALSE(history.perform(group));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 2.0, 4.0, 6.0, 8.0}));
+    EXPECT_EQ(history.getUndoCount(), 0u);
+    EXPECT_EQ(history.getRedoCount(), 1u);
+}
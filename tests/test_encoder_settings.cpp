@@ -0,0 +1,94 @@
+/**
+ * @file test_encoder_settings.cpp
+ * @brief Unit tests for video encoder settings
+ *
+ * Tests the draft and master presets and which settings are rejected
+ * before any encoder is asked about them.
+ */
+
+#include <gtest/gtest.h>
+#include "export/EncoderSettings.h"
+#include "export/ExportFacade.h"
+#include <string>
+
+using namespace csci3081;
+
+// ==============================================================================
+// Preset Tests
+// ==============================================================================
+
+/**
+ * Test: The default and preset settings are valid
+ * Purpose: Verify drafts trade quality for speed and masters the opposite,
+ * and that the defaults are what exports have always used
+ */
+TEST(EncoderSettingsTest, PresetsAreConsistent) {
+    std::string error;
+    EncoderSettings standard;
+    EXPECT_TRUE(standard.check(error)) << error;
+    EXPECT_EQ(standard.codec, "libx264");
+    EXPECT_EQ(standard.preset, "medium");
+    EXPECT_EQ(standard.crf, 23);
+    EXPECT_EQ(standard.keyframeInterval, 12);
+
+    EncoderSettings draft = EncoderSettings::draft();
+    EncoderSettings master = EncoderSettings::master();
+    EXPECT_TRUE(draft.check(error)) << error;
+    EXPECT_TRUE(master.check(error)) << error;
+    EXPECT_EQ(draft.preset, "ultrafast");
+    EXPECT_EQ(master.preset, "slow");
+    EXPECT_GT(draft.crf, standard.crf);
+    EXPECT_LT(master.crf, standard.crf);
+
+    ExportSettings settings;
+    EXPECT_EQ(settings.encoder.codec, standard.codec);
+}
+
+// ==============================================================================
+// Validation Tests
+// ==============================================================================
+
+/**
+ * Test: Inconsistent settings are rejected with a reason
+ * Purpose: Verify bad counts, rates and two-pass without a bit rate fail
+ */
+TEST(EncoderSettingsTest, RejectsInconsistentSettings) {
+    std::string error;
+
+    EncoderSettings noCodec;
+    noCodec.codec = "";
+    EXPECT_FALSE(noCodec.check(error));
+    EXPECT_FALSE(error.empty());
+
+    EncoderSettings keyframes;
+    keyframes.keyframeInterval = 0;
+    EXPECT_FALSE(keyframes.check(error));
+
+    EncoderSettings threads;
+    threads.threads = -1;
+    EXPECT_FALSE(threads.check(error));
+
+    EncoderSettings crf;
+    crf.crf = 64;
+    EXPECT_FALSE(crf.check(error));
+
+    EncoderSettings twoPass;
+    twoPass.twoPass = true;
+    EXPECT_FALSE(twoPass.check(error)) << "two-pass needs a bit rate";
+    twoPass.rateControl = RateControl::VBR;
+    EXPECT_TRUE(twoPass.check(error)) << error;
+    EXPECT_TRUE(error.empty());
+
+    EncoderSettings peak;
+    peak.rateControl = RateControl::VBR;
+    peak.bitRate = 4000;
+    peak.maxBitRate = 3000;
+    EXPECT_FALSE(peak.check(error));
+    peak.maxBitRate = 6000;
+    EXPECT_TRUE(peak.check(error)) << error;
+
+    EncoderSettings cbr;
+    cbr.rateControl = RateControl::CBR;
+    cbr.bitRate = 0;
+    EXPECT_FALSE(cbr.check(error));
+}
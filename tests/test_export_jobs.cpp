@@ -0,0 +1,246 @@
+/**
+ * @file test_export_jobs.cpp
+ * @brief Unit tests for running export commands as background jobs
+ *
+ * Tests that jobs run in order on worker threads within the concurrency
+ * limit, that queued and running jobs can be cancelled, and that observers
+ * hear about progress and failures on the thread that calls update().
+ */
+
+#include <gtest/gtest.h>
+#include "commands/ExportJobManager.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Doubles
+// ==============================================================================
+
+/**
+ * @brief What the test commands saw, shared between them
+ */
+struct Record {
+    std::mutex mutex;
+    std::vector<int> started;   // Command numbers, in the order they ran
+    std::atomic<int> running;
+    std::atomic<int> mostRunning;
+
+    Record() : running(0), mostRunning(0) {}
+};
+
+/**
+ * @brief An "export" of a few frames that can fail or wait to be cancelled
+ */
+class FakeExportCommand : public ICommand {
+public:
+    FakeExportCommand(Record& record, int number, int frames)
+        : record(record), number(number), frames(frames), fail(false), untilCancelled(false),
+          monitor(nullptr) {}
+
+    void execute() override {
+        {
+            std::lock_guard<std::mutex> lock(record.mutex);
+            record.started.push_back(number);
+        }
+        int running = ++record.running;
+        int most = record.mostRunning;
+        while (running > most && !record.mostRunning.compare_exchange_weak(most, running)) {
+        }
+
+        monitor->start(frames);
+        for (int i = 0; i < frames || untilCancelled; i++) {
+            if (monitor->isCancelled()) {
+                record.running--;
+                throw std::runtime_error("Export cancelled");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (i < frames) {
+                monitor->addFrames(1);
+            }
+        }
+        record.running--;
+        if (fail) {
+            throw std::runtime_error("disk full");
+        }
+    }
+
+    std::string getDescription() const override { return "Export " + std::to_string(number); }
+    bool canExecute() const override { return frames > 0; }
+    void setMonitor(ExportMonitor* monitor) override { this->monitor = monitor; }
+
+    Record& record;
+    int number;
+    int frames;
+    bool fail;
+    bool untilCancelled;
+
+private:
+    ExportMonitor* monitor;
+};
+
+/**
+ * @brief Keeps what it was last told, and on which thread
+ */
+class RecordingObserver : public IExportJobObserver {
+public:
+    RecordingObserver() : calls(0) {}
+
+    void onJobsChanged(const std::vector<ExportJobStatus>& jobs) override {
+        this->jobs = jobs;
+        calls++;
+        thread = std::this_thread::get_id();
+    }
+
+    std::vector<ExportJobStatus> jobs;
+    int calls;
+    std::thread::id thread;
+};
+
+ExportJobState stateOf(const ExportJobManager& manager, int id) {
+    for (const ExportJobStatus& job : manager.getJobs()) {
+        if (job.id == id) {
+            return job.state;
+        }
+    }
+    return ExportJobState::FAILED;
+}
+
+void waitForState(const ExportJobManager& manager, int id, ExportJobState state) {
+    for (int i = 0; i < 2000 && stateOf(manager, id) != state; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+} // namespace
+
+// ==============================================================================
+// Scheduling Tests
+// ==============================================================================
+
+/**
+ * Test: Jobs run in the order they were queued, a few at a time
+ * Purpose: Verify submit() returns at once, no more jobs than the limit
+ * run together, and every job finishes
+ */
+TEST(ExportJobManagerTest, RunsJobsInOrderWithinLimit) {
+    Record record;
+    ExportJobManager manager(2);
+    EXPECT_EQ(manager.getMaxConcurrent(), 2);
+
+    std::vector<int> ids;
+    for (int i = 0; i < 6; i++) {
+        ids.push_back(manager.submit(new FakeExportCommand(record, i, 20)));
+        EXPECT_GT(ids.back(), 0);
+    }
+    EXPECT_TRUE(manager.isBusy());
+    manager.waitForAll();
+    EXPECT_FALSE(manager.isBusy());
+
+    std::vector<ExportJobStatus> jobs = manager.getJobs();
+    ASSERT_EQ(jobs.size(), 6u);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        EXPECT_EQ(jobs[i].id, ids[i]);
+        EXPECT_EQ(jobs[i].state, ExportJobState::FINISHED);
+        EXPECT_EQ(jobs[i].description, "Export " + std::to_string(i));
+        EXPECT_EQ(jobs[i].progress.framesDone, 20);
+    }
+    EXPECT_LE(record.mostRunning, 2);
+    // Each worker takes the oldest job, so two started before any third
+    ASSERT_EQ(record.started.size(), 6u);
+    EXPECT_LT(std::max(record.started[0], record.started[1]), 2);
+
+    manager.removeFinished();
+    EXPECT_TRUE(manager.getJobs().empty());
+
+    // Commands that can't execute are not queued
+    EXPECT_EQ(manager.submit(new FakeExportCommand(record, 9, 0)), -1);
+    EXPECT_EQ(manager.submit(nullptr), -1);
+}
+
+/**
+ * Test: Queued and running jobs can be cancelled
+ * Purpose: Verify a queued job never runs, a running one stops through
+ * its monitor, and jobs that are over can't be cancelled
+ */
+TEST(ExportJobManagerTest, CancelsQueuedAndRunningJobs) {
+    Record record;
+    ExportJobManager manager(1);
+    FakeExportCommand* endless = new FakeExportCommand(record, 0, 5);
+    endless->untilCancelled = true;
+    int running = manager.submit(endless);
+    int queued = manager.submit(new FakeExportCommand(record, 1, 5));
+    waitForState(manager, running, ExportJobState::RUNNING);
+    ASSERT_EQ(stateOf(manager, running), ExportJobState::RUNNING);
+
+    EXPECT_TRUE(manager.cancel(queued));
+    EXPECT_EQ(stateOf(manager, queued), ExportJobState::CANCELLED);
+    EXPECT_TRUE(manager.cancel(running));
+    manager.waitForAll();
+    EXPECT_EQ(stateOf(manager, running), ExportJobState::CANCELLED);
+    EXPECT_FALSE(manager.cancel(running));
+    EXPECT_FALSE(manager.cancel(12345));
+    ASSERT_EQ(record.started.size(), 1u);
+
+    // cancelAll() stops everything, and destroying the manager waits for it
+    FakeExportCommand* another = new FakeExportCommand(record, 2, 5);
+    another->untilCancelled = true;
+    int last = manager.submit(another);
+    manager.submit(new FakeExportCommand(record, 3, 5));
+    waitForState(manager, last, ExportJobState::RUNNING);
+    manager.cancelAll();
+    manager.waitForAll();
+    for (const ExportJobStatus& job : manager.getJobs()) {
+        EXPECT_EQ(job.state, ExportJobState::CANCELLED) << job.description;
+    }
+}
+
+// ==============================================================================
+// Observer Tests
+// ==============================================================================
+
+/**
+ * Test: Observers hear about progress and failures from update()
+ * Purpose: Verify observers are called on the updating thread with every
+ * job, only when something changed, and see why a job failed
+ */
+TEST(ExportJobManagerTest, ObserversSeeProgressAndFailures) {
+    Record record;
+    ExportJobManager manager(1);
+    RecordingObserver observer;
+    manager.addObserver(&observer);
+
+    manager.submit(new FakeExportCommand(record, 0, 10));
+    FakeExportCommand* failing = new FakeExportCommand(record, 1, 10);
+    failing->fail = true;
+    manager.submit(failing);
+    manager.waitForAll();
+
+    manager.update();
+    EXPECT_EQ(observer.calls, 1);
+    EXPECT_EQ(observer.thread, std::this_thread::get_id());
+    ASSERT_EQ(observer.jobs.size(), 2u);
+    EXPECT_EQ(observer.jobs[0].state, ExportJobState::FINISHED);
+    EXPECT_EQ(observer.jobs[0].progress.framesDone, 10);
+    EXPECT_DOUBLE_EQ(observer.jobs[0].progress.getFraction(), 1.0);
+    EXPECT_EQ(observer.jobs[1].state, ExportJobState::FAILED);
+    EXPECT_EQ(observer.jobs[1].error, "disk full");
+    EXPECT_TRUE(observer.jobs[1].isDone());
+
+    // Nothing changed
+    manager.update();
+    EXPECT_EQ(observer.calls, 1);
+
+    manager.removeObserver(&observer);
+    manager.removeFinished();
+    manager.update();
+    EXPECT_EQ(observer.calls, 1);
+}
@@ -0,0 +1,438 @@
+/**
+ * @file test_export_pipeline.cpp
+ * @brief Unit tests for the streaming export pipeline
+ *
+ * Tests the bounded queue between stages, the YUV conversion, and that the
+ * pipeline delivers every frame in order using the same few buffers however
+ * long the export is.
+ */
+
+#include <gtest/gtest.h>
+#include "export/ExportMonitor.h"
+#include "export/ExportPipeline.h"
+#include "export/YuvFrame.h"
+#include "util/BoundedQueue.h"
+#include "util/ThreadPool.h"
+#include "timeline/Timeline.h"
+#include "graphics/Color.h"
+#include "Image.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Doubles
+// ==============================================================================
+
+/**
+ * @brief A "video" whose frames are a grey level that counts up 30 times a second
+ */
+class CountingVideo : public IAsset {
+public:
+    explicit CountingVideo(double duration) : frame(8, 6), duration(duration) {}
+
+    static int levelAt(double time) { return static_cast<int>(std::floor(time * 30.0 + 0.5)) % 200; }
+
+    double getDuration() const override { return duration; }
+    const Image& getFrame(double time = 0.0) override {
+        int level = levelAt(time);
+        frame.fill(Color(level, level, level, 255));
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+private:
+    Image frame;
+    double duration;
+};
+
+/**
+ * @brief Sink that remembers what it was given and can fail on request
+ */
+class RecordingSink : public IFrameSink {
+public:
+    RecordingSink() : failAt(-1), opened(false), closed(false) {}
+
+    bool open(int width, int height, const Rational& rate) override {
+        opened = true;
+        return true;
+    }
+
+    bool writeFrame(const YuvFrame& frame) override {
+        if (static_cast<int>(lumas.size()) == failAt) {
+            return false;
+        }
+        lumas.push_back(frame.y[0]);
+        buffers.insert(frame.y.data());
+        return true;
+    }
+
+    bool close() override {
+        closed = true;
+        return true;
+    }
+
+    std::string getLastError() const override { return failAt >= 0 ? "disk full" : ""; }
+
+    int failAt;
+    bool opened;
+    bool closed;
+    std::vector<int> lumas;
+    std::set<const uint8_t*> buffers;
+};
+
+} // namespace
+
+// ==============================================================================
+// Queue and Conversion Tests
+// ==============================================================================
+
+/**
+ * Test: A full queue holds its producer back
+ * Purpose: Verify push() waits for room, items come out in order, and
+ * close() lets the consumer drain what is left
+ */
+TEST(BoundedQueueTest, ProducerWaitsForRoom) {
+    BoundedQueue<int> queue(2);
+    ASSERT_TRUE(queue.push(0));
+    ASSERT_TRUE(queue.push(1));
+
+    std::atomic<bool> pushed(false);
+    std::thread producer([&]() {
+        for (int i = 2; i < 100; i++) {
+            ASSERT_TRUE(queue.push(i));
+            pushed = true;
+            EXPECT_LE(queue.size(), 2u);
+        }
+        queue.close();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed.load());
+
+    std::vector<int> seen;
+    int item;
+    while (queue.pop(item)) {
+        seen.push_back(item);
+    }
+    producer.join();
+
+    ASSERT_EQ(seen.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(seen[i], i);
+    }
+    EXPECT_FALSE(queue.push(100));
+}
+
+/**
+ * Test: Known colors convert to their BT.601 limited-range values
+ * Purpose: Verify the luma and chroma matrix, chroma averaging, and odd sizes
+ */
+TEST(YuvFrameTest, ConvertsKnownColors) {
+    Image image(3, 3);
+    image.fill(Color(255, 255, 255, 255));
+    image.setPixel(0, 0, Color(0, 0, 0, 255));
+    image.setPixel(2, 2, Color(255, 0, 0, 255));
+
+    YuvFrame frame;
+    convertToYuv420(image, frame);
+    ASSERT_EQ(frame.getChromaWidth(), 2);
+    ASSERT_EQ(frame.u.size(), 4u);
+
+    EXPECT_EQ(frame.y[0], 16);         // black
+    EXPECT_EQ(frame.y[1], 235);        // white
+    EXPECT_EQ(frame.y[8], 81);         // red (16 + 219 * 0.299, as swscale gives)
+    EXPECT_EQ(frame.u[1], 128);        // grey block
+    EXPECT_EQ(frame.v[3], 240);        // the red corner pairs with itself
+    EXPECT_EQ(frame.u[3], 90);
+}
+
+namespace {
+
+/**
+ * @brief An image of random colors
+ */
+Image noiseImage(int width, int height, unsigned seed) {
+    Image image(width, height);
+    std::srand(seed);
+    unsigned char* data = image.getData();
+    for (int i = 0; i < width * height * 4; i++) {
+        data[i] = static_cast<unsigned char>(std::rand() & 255);
+    }
+    return image;
+}
+
+/**
+ * @brief Exact luma, blue and red difference of a color, before rounding
+ */
+void referenceYuv(const YuvFormat& format, double r, double g, double b, double yuv[3]) {
+    double kr = format.matrix == YuvMatrix::BT709 ? 0.2126 : 0.299;
+    double kb = format.matrix == YuvMatrix::BT709 ? 0.0722 : 0.114;
+    bool limited = format.range == YuvRange::LIMITED;
+    double luma = kr * r + (1.0 - kr - kb) * g + kb * b;
+    yuv[0] = (limited ? 16.0 : 0.0) + (limited ? 219.0 / 255.0 : 1.0) * luma;
+    double chromaScale = limited ? 224.0 / 255.0 : 1.0;
+    yuv[1] = std::min(255.0, 128.0 + chromaScale * (b - luma) / (2.0 * (1.0 - kb)));
+    yuv[2] = std::min(255.0, 128.0 + chromaScale * (r - luma) / (2.0 * (1.0 - kr)));
+}
+
+// How far a sample is from the exact value, rounded
+int errorOf(uint8_t sample, double exact) {
+    return std::abs(sample - static_cast<int>(std::lround(exact)));
+}
+
+void expectSamePlanes(const YuvFrame& a, const YuvFrame& b) {
+    ASSERT_EQ(a.width, b.width);
+    ASSERT_EQ(a.height, b.height);
+    EXPECT_TRUE(a.y == b.y);
+    EXPECT_TRUE(a.u == b.u);
+    EXPECT_TRUE(a.v == b.v);
+}
+
+} // namespace
+
+/**
+ * Test: Every matrix and range is within 1 of the exact conversion
+ * Purpose: Verify the fixed-point weights of BT.601 and BT.709 in both
+ * ranges, on a size that uses the 16-pixel path and the odd edges
+ */
+TEST(YuvFrameTest, MatchesExactConversionWithinOne) {
+    const YuvFormat formats[] = {
+        YuvFormat(YuvMatrix::BT601, YuvRange::LIMITED), YuvFormat(YuvMatrix::BT601, YuvRange::FULL),
+        YuvFormat(YuvMatrix::BT709, YuvRange::LIMITED), YuvFormat(YuvMatrix::BT709, YuvRange::FULL)};
+    Image image = noiseImage(37, 21, 5);
+    const unsigned char* pixels = image.getData();
+
+    for (const YuvFormat& format : formats) {
+        YuvFrame frame;
+        convertToYuv420(image, frame, format, nullptr);
+        int worst = 0;
+        for (int y = 0; y < 21; y++) {
+            for (int x = 0; x < 37; x++) {
+                const unsigned char* p = pixels + (y * 37 + x) * 4;
+                double yuv[3];
+                referenceYuv(format, p[0], p[1], p[2], yuv);
+                worst = std::max(worst, errorOf(frame.y[y * 37 + x], yuv[0]));
+            }
+        }
+        for (int y = 0; y < 21; y += 2) {
+            for (int x = 0; x < 37; x += 2) {
+                // Average of the 2x2 block, edges pairing with themselves
+                double sum[3] = {0.0, 0.0, 0.0};
+                for (int dy = 0; dy < 2; dy++) {
+                    for (int dx = 0; dx < 2; dx++) {
+                        const unsigned char* p =
+                            pixels + (std::min(y + dy, 20) * 37 + std::min(x + dx, 36)) * 4;
+                        for (int c = 0; c < 3; c++) {
+                            sum[c] += p[c] / 4.0;
+                        }
+                    }
+                }
+                double yuv[3];
+                referenceYuv(format, sum[0], sum[1], sum[2], yuv);
+                int chroma = (y / 2) * frame.getChromaWidth() + x / 2;
+                worst = std::max(worst, errorOf(frame.u[chroma], yuv[1]));
+                worst = std::max(worst, errorOf(frame.v[chroma], yuv[2]));
+            }
+        }
+        EXPECT_LE(worst, 1) << "matrix " << static_cast<int>(format.matrix) << ", range "
+                            << static_cast<int>(format.range);
+    }
+
+    // Greys have no chroma, and white is full scale
+    Image white(4, 2);
+    white.fill(Color(255, 255, 255, 255));
+    YuvFrame frame;
+    convertToYuv420(white, frame, YuvFormat(YuvMatrix::BT709, YuvRange::FULL), nullptr);
+    EXPECT_EQ(frame.y[5], 255);
+    EXPECT_EQ(frame.u[1], 128);
+    EXPECT_EQ(frame.v[1], 128);
+}
+
+/**
+ * Test: A pixel converts the same wherever it is in its row
+ * Purpose: Verify the 16-pixel vector path and the scalar path for the
+ * rest of a row give identical results
+ */
+TEST(YuvFrameTest, VectorAndScalarPathsAgree) {
+    // 48 columns are three whole vector blocks; shifted right by 14, the
+    // last 14 of them fall past the last block of the wider image
+    Image image = noiseImage(48, 4, 9);
+    Image shifted = noiseImage(62, 4, 10);
+    for (int y = 0; y < 4; y++) {
+        std::copy(image.getData() + y * 48 * 4, image.getData() + (y + 1) * 48 * 4,
+                  shifted.getData() + (y * 62 + 14) * 4);
+    }
+
+    const YuvFormat format(YuvMatrix::BT709, YuvRange::LIMITED);
+    YuvFrame frame;
+    YuvFrame shiftedFrame;
+    convertToYuv420(image, frame, format, nullptr);
+    convertToYuv420(shifted, shiftedFrame, format, nullptr);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 48; x++) {
+            EXPECT_EQ(frame.y[y * 48 + x], shiftedFrame.y[y * 62 + x + 14]) << x << ", " << y;
+        }
+    }
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 24; x++) {
+            EXPECT_EQ(frame.u[y * 24 + x], shiftedFrame.u[y * 31 + x + 7]) << x << ", " << y;
+            EXPECT_EQ(frame.v[y * 24 + x], shiftedFrame.v[y * 31 + x + 7]) << x << ", " << y;
+        }
+    }
+}
+
+/**
+ * Test: Converting bands of rows on a pool gives the single-threaded result
+ * Purpose: Verify the bands cover every row pair once, including an odd
+ * last row
+ */
+TEST(YuvFrameTest, ThreadedConversionMatchesSingleThread) {
+    Image image = noiseImage(322, 181, 11);
+    ThreadPool pool(3);
+    YuvFrame single;
+    YuvFrame threaded;
+    convertToYuv420(image, single, YuvFormat(), nullptr);
+    convertToYuv420(image, threaded, YuvFormat(), &pool);
+    expectSamePlanes(single, threaded);
+
+    // The plain overload is the default format
+    YuvFrame plain;
+    convertToYuv420(image, plain);
+    expectSamePlanes(single, plain);
+}
+
+// ==============================================================================
+// Pipeline Tests
+// ==============================================================================
+
+/**
+ * Test: Every frame arrives, in order, with the right picture
+ * Purpose: Verify the three stages hand frames along without dropping,
+ * repeating or reordering any, and the counters add up
+ */
+TEST(ExportPipelineTest, DeliversEveryFrameInOrder) {
+    CountingVideo video(10.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 10.0));
+
+    RecordingSink sink;
+    ExportPipeline pipeline;
+    ASSERT_TRUE(pipeline.run(timeline, 8, 6, Rational(30, 1), sink)) << pipeline.getLastError();
+
+    ASSERT_EQ(sink.lumas.size(), 300u);
+    for (int i = 0; i < 300; i++) {
+        Image expected(8, 6);
+        int level = CountingVideo::levelAt(i / 30.0);
+        expected.fill(Color(level, level, level, 255));
+        YuvFrame converted;
+        convertToYuv420(expected, converted);
+        ASSERT_EQ(sink.lumas[i], converted.y[0]) << "frame " << i;
+    }
+
+    const PipelineStats& stats = pipeline.getStats();
+    EXPECT_TRUE(sink.closed);
+    EXPECT_EQ(stats.render.frames, 300);
+    EXPECT_EQ(stats.convert.frames, 300);
+    EXPECT_EQ(stats.encode.frames, 300);
+}
+
+/**
+ * Test: Memory doesn't grow with the length of the export
+ * Purpose: Verify a 60x longer export reuses the same few buffers
+ */
+TEST(ExportPipelineTest, MemoryIsConstantAcrossLengths) {
+    CountingVideo video(1000.0);
+    std::vector<size_t> buffersUsed;
+    std::vector<int> buffersAllocated;
+
+    for (double seconds : {1.0, 60.0}) {
+        Timeline timeline;
+        timeline.getTrack(timeline.addTrack("Video"))
+            ->addEntry(TimelineEntry(&video, 0.0, seconds));
+        RecordingSink sink;
+        ExportPipeline pipeline(2);
+        ASSERT_TRUE(pipeline.run(timeline, 8, 6, Rational(30, 1), sink));
+        EXPECT_EQ(sink.lumas.size(), static_cast<size_t>(seconds * 30));
+        buffersUsed.push_back(sink.buffers.size());
+        buffersAllocated.push_back(pipeline.getStats().frameBuffers);
+    }
+
+    EXPECT_EQ(buffersAllocated[0], buffersAllocated[1]);
+    EXPECT_LE(buffersUsed[1], static_cast<size_t>(buffersAllocated[1]));
+    EXPECT_LE(buffersAllocated[1], 2 + 2);
+}
+
+/**
+ * Test: A failing sink stops the export
+ * Purpose: Verify the render and convert threads are released, the sink
+ * is still closed, and the error says which frame failed
+ */
+TEST(ExportPipelineTest, SinkFailureStopsEveryStage) {
+    CountingVideo video(100.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 100.0));
+
+    RecordingSink sink;
+    sink.failAt = 10;
+    ExportPipeline pipeline;
+    EXPECT_FALSE(pipeline.run(timeline, 8, 6, Rational(30, 1), sink));
+    EXPECT_TRUE(sink.closed);
+    EXPECT_EQ(sink.lumas.size(), 10u);
+    EXPECT_NE(pipeline.getLastError().find("frame 10"), std::string::npos);
+    EXPECT_NE(pipeline.getLastError().find("disk full"), std::string::npos);
+    // Upstream stages stop within a few frames instead of rendering all 3000
+    EXPECT_LT(pipeline.getStats().render.frames, 30);
+}
+
+/**
+ * Test: A cancelled monitor stops the export and counts what was written
+ * Purpose: Verify frames are reported as they are written, the pipeline
+ * stops at the next frame once cancelled, and says it was cancelled
+ */
+TEST(ExportPipelineTest, MonitorCountsFramesAndCancels) {
+    CountingVideo video(100.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 100.0));
+
+    // Cancels once 10 frames are in
+    class CancellingSink : public RecordingSink {
+    public:
+        explicit CancellingSink(ExportMonitor& monitor) : monitor(monitor) {}
+        bool writeFrame(const YuvFrame& frame) override {
+            if (lumas.size() == 9) {
+                monitor.cancel();
+            }
+            return RecordingSink::writeFrame(frame);
+        }
+        ExportMonitor& monitor;
+    };
+
+    ExportMonitor monitor;
+    monitor.start(3000);
+    CancellingSink sink(monitor);
+    ExportPipeline pipeline;
+    pipeline.setMonitor(&monitor);
+    EXPECT_FALSE(pipeline.run(timeline, 8, 6, Rational(30, 1), sink));
+    EXPECT_EQ(pipeline.getLastError(), "Export cancelled");
+    EXPECT_TRUE(sink.closed);
+    EXPECT_EQ(sink.lumas.size(), 10u);
+
+    ExportProgress progress = monitor.getProgress();
+    EXPECT_EQ(progress.framesDone, 10);
+    EXPECT_EQ(progress.frameCount, 3000);
+    EXPECT_NEAR(progress.getFraction(), 10.0 / 3000.0, 1e-9);
+    EXPECT_GT(progress.getFramesPerSecond(), 0.0);
+    EXPECT_GT(progress.getSecondsRemaining(), 0.0);
+    EXPECT_LT(ExportProgress().getSecondsRemaining(), 0.0);
+}
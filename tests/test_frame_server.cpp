@@ -0,0 +1,329 @@
+/**
+ * @file test_frame_server.cpp
+ * @brief Unit tests for streaming uncompressed frames to other programs
+ *
+ * Tests that a Y4M stream piped through a named pipe into another process
+ * arrives with every frame intact, that streams to stdout hold only the
+ * frames, that raw streams are the bare planes, that a reader that stops
+ * early fails the export instead of ending the process, and that a
+ * cancel ends waiting for a reader.
+ */
+
+#include <gtest/gtest.h>
+#include "export/ExportMonitor.h"
+#include "export/ExportPipeline.h"
+#include "export/FrameServerSink.h"
+#include "timeline/Timeline.h"
+#include "graphics/Color.h"
+#include "Image.h"
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Doubles and Helpers
+// ==============================================================================
+
+/**
+ * @brief A "video" whose frames change color 30 times a second
+ */
+class CountingVideo : public IAsset {
+public:
+    explicit CountingVideo(double duration) : frame(8, 6), duration(duration) {}
+
+    double getDuration() const override { return duration; }
+    const Image& getFrame(double time = 0.0) override {
+        int level = static_cast<int>(std::floor(time * 30.0 + 0.5)) * 7 % 220;
+        frame.fill(Color(level, 255 - level, level / 3, 255));
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+private:
+    Image frame;
+    double duration;
+};
+
+/**
+ * @brief A CountingVideo that reports every frame, as Video reports seeks
+ */
+class ChattyVideo : public CountingVideo {
+public:
+    explicit ChattyVideo(double duration) : CountingVideo(duration) {}
+
+    const Image& getFrame(double time = 0.0) override {
+        std::cerr << "[Video] Decoded frame at " << time << "s" << std::endl;
+        return CountingVideo::getFrame(time);
+    }
+};
+
+/**
+ * @brief Sink that keeps every frame's planes, one after another
+ */
+class PlanesSink : public IFrameSink {
+public:
+    explicit PlanesSink(const YuvFormat& format = YuvFormat()) : format(format) {}
+
+    bool open(int width, int height, const Rational& rate) override { return true; }
+    bool writeFrame(const YuvFrame& frame) override {
+        std::string planes;
+        planes.append(frame.y.begin(), frame.y.end());
+        planes.append(frame.u.begin(), frame.u.end());
+        planes.append(frame.v.begin(), frame.v.end());
+        frames.push_back(planes);
+        return true;
+    }
+    bool close() override { return true; }
+    std::string getLastError() const override { return ""; }
+    YuvFormat getYuvFormat() const override { return format; }
+
+    YuvFormat format;
+    std::vector<std::string> frames;
+};
+
+/**
+ * @brief 64-bit FNV-1a checksum
+ */
+uint64_t checksum(const std::string& bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char byte : bytes) {
+        hash = (hash ^ byte) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+// ==============================================================================
+// Frame Server Tests
+// ==============================================================================
+
+#ifndef _WIN32
+
+/**
+ * Test: A Y4M stream reaches another process through a named pipe
+ * Purpose: Verify the reader gets the header, then every frame in order
+ * with the same checksum as the frames the pipeline converted
+ */
+TEST(FrameServerSinkTest, StreamsY4mIntoAConsumerProcess) {
+    CountingVideo video(1.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 1.0));
+    const Rational rate(30, 1);
+    const int width = 33;    // Odd, so the chroma planes round up
+    const int height = 17;
+
+    const YuvFormat format(YuvMatrix::BT709, YuvRange::FULL);
+    PlanesSink expected(format);
+    ExportPipeline pipeline;
+    ASSERT_TRUE(pipeline.run(timeline, width, height, rate, expected));
+    ASSERT_EQ(expected.frames.size(), 30u);
+
+    const std::string fifo = ::testing::TempDir() + "frame_server_test.fifo";
+    const std::string received = ::testing::TempDir() + "frame_server_test.y4m";
+    std::remove(fifo.c_str());
+    std::remove(received.c_str());
+    ASSERT_EQ(mkfifo(fifo.c_str(), 0600), 0);
+
+    // The consumer blocks opening the pipe until the sink opens it to write
+    FILE* consumer = popen(("cat '" + fifo + "' > '" + received + "'").c_str(), "r");
+    ASSERT_NE(consumer, nullptr);
+    FrameServerSink sink(fifo, ExportFormat::Y4M, format);
+    EXPECT_TRUE(pipeline.run(timeline, width, height, rate, sink)) << pipeline.getLastError();
+    EXPECT_EQ(pclose(consumer), 0);
+
+    const std::string stream = readFile(received);
+    const std::string header = FrameServerSink::makeY4mHeader(width, height, rate, format);
+    EXPECT_EQ(header, "YUV4MPEG2 W33 H17 F30:1 Ip A1:1 C420jpeg XYSCSS=420JPEG "
+                      "XCOLORRANGE=FULL\n");
+    ASSERT_EQ(stream.compare(0, header.size(), header), 0);
+
+    const size_t frameSize = width * height + 2 * (17 * 9);
+    size_t pos = header.size();
+    size_t frames = 0;
+    while (pos < stream.size()) {
+        ASSERT_EQ(stream.compare(pos, 6, "FRAME\n"), 0) << "frame " << frames;
+        ASSERT_LE(pos + 6 + frameSize, stream.size());
+        ASSERT_LT(frames, expected.frames.size());
+        EXPECT_EQ(checksum(stream.substr(pos + 6, frameSize)), checksum(expected.frames[frames]))
+            << "frame " << frames;
+        pos += 6 + frameSize;
+        frames++;
+    }
+    EXPECT_EQ(frames, expected.frames.size());
+
+    std::remove(fifo.c_str());
+    std::remove(received.c_str());
+}
+
+/**
+ * Test: A stream to stdout holds only the frames
+ * Purpose: Verify the messages a video prints while the stream is open
+ * stay out of it, that it has the header and every frame's checksum, that
+ * a second stream to stdout is refused, and that SIGPIPE is handled as it
+ * was after it closes
+ */
+TEST(FrameServerSinkTest, StreamsToStdoutWithoutTheVideosMessages) {
+    ChattyVideo video(1.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 1.0));
+    const Rational rate(30, 1);
+    const int width = 16;
+    const int height = 8;
+
+    PlanesSink expected;
+    ExportPipeline pipeline;
+    ASSERT_TRUE(pipeline.run(timeline, width, height, rate, expected));
+    ASSERT_EQ(expected.frames.size(), 30u);
+
+    void (*const handler)(int) = std::signal(SIGPIPE, SIG_DFL);
+    ::testing::internal::CaptureStdout();
+    FrameServerSink sink("-", ExportFormat::Y4M);
+    const bool streamed = pipeline.run(timeline, width, height, rate, sink);
+    std::cout << "after" << std::endl;
+    const std::string stream = ::testing::internal::GetCapturedStdout();
+    ASSERT_TRUE(streamed) << pipeline.getLastError();
+    EXPECT_EQ(std::signal(SIGPIPE, handler), SIG_DFL);
+
+    const std::string header = FrameServerSink::makeY4mHeader(width, height, rate, YuvFormat());
+    ASSERT_EQ(stream.compare(0, header.size(), header), 0) << stream.substr(0, 80);
+    const size_t frameSize = width * height * 3 / 2;
+    size_t pos = header.size();
+    for (size_t frame = 0; frame < expected.frames.size(); frame++) {
+        ASSERT_EQ(stream.compare(pos, 6, "FRAME\n"), 0) << "frame " << frame;
+        ASSERT_LE(pos + 6 + frameSize, stream.size());
+        EXPECT_EQ(checksum(stream.substr(pos + 6, frameSize)), checksum(expected.frames[frame]))
+            << "frame " << frame;
+        pos += 6 + frameSize;
+    }
+    EXPECT_EQ(stream.substr(pos), "after\n");
+
+    ::testing::internal::CaptureStdout();
+    FrameServerSink first("-", ExportFormat::RAW);
+    FrameServerSink second("-", ExportFormat::RAW);
+    EXPECT_TRUE(first.open(width, height, rate)) << first.getLastError();
+    EXPECT_FALSE(second.open(width, height, rate));
+    EXPECT_NE(second.getLastError().find("stdout"), std::string::npos);
+    EXPECT_TRUE(first.close());
+    EXPECT_TRUE(second.open(width, height, rate)) << second.getLastError();
+    EXPECT_TRUE(second.close());
+    EXPECT_EQ(::testing::internal::GetCapturedStdout(), "");
+}
+
+/**
+ * Test: A cancel ends waiting for a named pipe's reader
+ * Purpose: Verify a sink neither waits forever for a reader to open the
+ * pipe nor for one that stopped reading, once the export is cancelled
+ */
+TEST(FrameServerSinkTest, CancelEndsWaitingForTheReader) {
+    CountingVideo video(1.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 1.0));
+    const Rational rate(30, 1);
+    const std::string fifo = ::testing::TempDir() + "frame_server_cancel.fifo";
+    std::remove(fifo.c_str());
+    ASSERT_EQ(mkfifo(fifo.c_str(), 0600), 0);
+
+    // Nothing ever opens the pipe to read
+    ExportMonitor unread;
+    FrameServerSink waiting(fifo, ExportFormat::Y4M);
+    waiting.setMonitor(&unread);
+    std::thread cancelUnread([&unread]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        unread.cancel();
+    });
+    EXPECT_FALSE(waiting.open(16, 8, rate));
+    EXPECT_NE(waiting.getLastError().find("cancelled"), std::string::npos)
+        << waiting.getLastError();
+    cancelUnread.join();
+
+    // A reader that opens the pipe and never reads, with frames larger
+    // than the pipe's buffer
+    int reader = ::open(fifo.c_str(), O_RDONLY | O_NONBLOCK);
+    ASSERT_GE(reader, 0);
+    ExportMonitor stalled;
+    FrameServerSink sink(fifo, ExportFormat::Y4M);
+    sink.setMonitor(&stalled);
+    ExportPipeline pipeline;
+    pipeline.setMonitor(&stalled);
+    std::thread cancelStalled([&stalled]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        stalled.cancel();
+    });
+    EXPECT_FALSE(pipeline.run(timeline, 640, 360, rate, sink));
+    EXPECT_NE(pipeline.getLastError().find("cancelled"), std::string::npos)
+        << pipeline.getLastError();
+    EXPECT_EQ(pipeline.getStats().encode.frames, 0);
+    cancelStalled.join();
+    ::close(reader);
+    std::remove(fifo.c_str());
+}
+
+/**
+ * Test: Raw streams are the planes alone, and readers that stop fail the export
+ * Purpose: Verify a raw file holds exactly the converted frames, and a
+ * reader that exits after a few bytes stops the pipeline with a broken
+ * pipe instead of a SIGPIPE
+ */
+TEST(FrameServerSinkTest, WritesRawPlanesAndStopsWhenTheReaderDoes) {
+    CountingVideo video(1.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 1.0));
+    const Rational rate(30, 1);
+
+    PlanesSink expected;
+    ExportPipeline pipeline;
+    ASSERT_TRUE(pipeline.run(timeline, 16, 8, rate, expected));
+    const std::string raw = ::testing::TempDir() + "frame_server_test.yuv";
+    FrameServerSink rawSink(raw, ExportFormat::RAW);
+    ASSERT_TRUE(pipeline.run(timeline, 16, 8, rate, rawSink)) << pipeline.getLastError();
+    std::string planes;
+    for (const std::string& frame : expected.frames) {
+        planes += frame;
+    }
+    EXPECT_EQ(readFile(raw), planes);
+    std::remove(raw.c_str());
+
+    // Frames larger than the pipe's buffer, so the writes outlast the reader
+    const std::string fifo = ::testing::TempDir() + "frame_server_stop.fifo";
+    std::remove(fifo.c_str());
+    ASSERT_EQ(mkfifo(fifo.c_str(), 0600), 0);
+    FILE* consumer = popen(("head -c 100 '" + fifo + "' > /dev/null").c_str(), "r");
+    ASSERT_NE(consumer, nullptr);
+    FrameServerSink sink(fifo, ExportFormat::Y4M);
+    EXPECT_FALSE(pipeline.run(timeline, 640, 360, rate, sink));
+    EXPECT_NE(pipeline.getLastError().find("Broken pipe"), std::string::npos)
+        << pipeline.getLastError();
+    EXPECT_LT(pipeline.getStats().encode.frames, 30);
+    pclose(consumer);
+    std::remove(fifo.c_str());
+
+    FrameServerSink image(raw, ExportFormat::PNG);
+    EXPECT_FALSE(image.open(16, 8, rate));
+}
+
+#endif
@@ -0,0 +1,327 @@
+/**
+ * @file test_image_sequence.cpp
+ * @brief Unit tests for PNG encoding and image sequence exports
+ *
+ * Tests that PNGs decode to the pixels they were made from with every
+ * filter and level, and that a sequence export writes one correctly
+ * numbered file per frame however many threads encode them.
+ */
+
+#include <gtest/gtest.h>
+#include "export/ExportMonitor.h"
+#include "export/ImageSequenceExport.h"
+#include "export/PngEncoder.h"
+#include "timeline/Timeline.h"
+#include "graphics/Color.h"
+#include "stb_image.h"
+#include "Image.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Doubles and Helpers
+// ==============================================================================
+
+/**
+ * @brief A "video" whose frames are a grey level that counts up 30 times a second
+ */
+class CountingVideo : public IAsset {
+public:
+    explicit CountingVideo(double duration) : frame(8, 6), duration(duration) {}
+
+    static int levelAt(double time) { return static_cast<int>(std::floor(time * 30.0 + 0.5)) % 200; }
+
+    double getDuration() const override { return duration; }
+    const Image& getFrame(double time = 0.0) override {
+        int level = levelAt(time);
+        frame.fill(Color(level, level, level, 255));
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+private:
+    Image frame;
+    double duration;
+};
+
+/**
+ * @brief A CountingVideo that cancels an export once it is asked for a frame at or after a time
+ */
+class CancellingVideo : public CountingVideo {
+public:
+    CancellingVideo(double duration, ExportMonitor& monitor, double cancelAt)
+        : CountingVideo(duration), monitor(monitor), cancelAt(cancelAt) {}
+
+    const Image& getFrame(double time = 0.0) override {
+        if (time >= cancelAt) {
+            monitor.cancel();
+        }
+        return CountingVideo::getFrame(time);
+    }
+
+private:
+    ExportMonitor& monitor;
+    double cancelAt;
+};
+
+/**
+ * @brief An image with smooth gradients, noise and partly transparent pixels
+ */
+Image makeTestImage(int width, int height) {
+    Image image(width, height);
+    std::srand(7);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char* pixel = image.getData() + (y * width + x) * 4;
+            pixel[0] = static_cast<unsigned char>(x * 4);
+            pixel[1] = static_cast<unsigned char>(y * 5);
+            pixel[2] = static_cast<unsigned char>(x < width / 2 ? std::rand() & 255 : 128);
+            pixel[3] = static_cast<unsigned char>(y < height / 2 ? 255 : x * 3);
+        }
+    }
+    return image;
+}
+
+/**
+ * @brief Decode a PNG in memory and check it gives the image back exactly
+ */
+bool decodesTo(const std::vector<unsigned char>& png, const Image& image) {
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    unsigned char* pixels = stbi_load_from_memory(png.data(), static_cast<int>(png.size()),
+                                                  &width, &height, &components, 4);
+    if (!pixels) {
+        return false;
+    }
+    bool same = width == image.getWidth() && height == image.getHeight() &&
+                std::equal(pixels, pixels + width * height * 4, image.getData());
+    stbi_image_free(pixels);
+    return same;
+}
+
+/**
+ * @brief Read back the grey level of one frame of a sequence
+ * @return The red sample of the first pixel, or -1 if the file is missing
+ */
+int levelOfFile(const std::string& filename) {
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    unsigned char* pixels = stbi_load(filename.c_str(), &width, &height, &components, 4);
+    if (!pixels) {
+        return -1;
+    }
+    int level = pixels[0];
+    stbi_image_free(pixels);
+    return level;
+}
+
+bool fileExists(const std::string& filename) {
+    FILE* file = std::fopen(filename.c_str(), "rb");
+    if (file) {
+        std::fclose(file);
+    }
+    return file != nullptr;
+}
+
+} // namespace
+
+// ==============================================================================
+// PNG Encoder Tests
+// ==============================================================================
+
+/**
+ * Test: Every filter and compression level is lossless
+ * Purpose: Verify the encoded PNGs decode to the same pixels, that level 0
+ * stores them uncompressed, and that filtering makes the file smaller
+ */
+TEST(PngEncoderTest, EveryFilterAndLevelIsLossless) {
+    Image image = makeTestImage(61, 37);   // Odd sizes, so no row lines up with anything
+    const PngFilter filters[] = {PngFilter::ADAPTIVE, PngFilter::NONE, PngFilter::SUB,
+                                 PngFilter::UP, PngFilter::AVERAGE, PngFilter::PAETH};
+    const int levels[] = {0, 1, 8, 12};
+
+    std::vector<unsigned char> png;
+    for (PngFilter filter : filters) {
+        for (int level : levels) {
+            PngSettings settings;
+            settings.filter = filter;
+            settings.compressionLevel = level;
+            ASSERT_TRUE(encodePng(image, settings, png));
+            EXPECT_TRUE(decodesTo(png, image))
+                << "filter " << static_cast<int>(filter) << ", level " << level;
+        }
+    }
+
+    PngSettings stored;
+    stored.compressionLevel = 0;
+    ASSERT_TRUE(encodePng(image, stored, png));
+    EXPECT_GT(png.size(), static_cast<size_t>(61 * 37 * 4));
+    size_t storedSize = png.size();
+
+    // A smooth gradient shrinks far more once each row is predicted
+    Image gradient(64, 64);
+    for (int i = 0; i < 64 * 64; i++) {
+        unsigned char* pixel = gradient.getData() + i * 4;
+        pixel[0] = static_cast<unsigned char>(i % 64 * 3);
+        pixel[1] = static_cast<unsigned char>(i / 64 * 2);
+        pixel[2] = static_cast<unsigned char>(i % 64 + i / 64);
+        pixel[3] = 255;
+    }
+    PngSettings unfiltered;
+    unfiltered.filter = PngFilter::NONE;
+    std::vector<unsigned char> plain;
+    ASSERT_TRUE(encodePng(gradient, unfiltered, plain));
+    ASSERT_TRUE(encodePng(gradient, PngSettings(), png));
+    EXPECT_LT(png.size(), plain.size());
+    EXPECT_LT(png.size(), storedSize);
+
+    EXPECT_FALSE(encodePng(Image(), PngSettings(), png));
+}
+
+// ==============================================================================
+// Sequence Export Tests
+// ==============================================================================
+
+/**
+ * Test: Frame filenames number the frames before the extension
+ * Purpose: Verify dots in directory names are not taken for the extension
+ */
+TEST(ImageSequenceExportTest, NamesFramesBeforeTheExtension) {
+    EXPECT_EQ(ImageSequenceExport::getFrameFilename("shot.png", 42), "shot_000042.png");
+    EXPECT_EQ(ImageSequenceExport::getFrameFilename("out/v1.2/shot", 7), "out/v1.2/shot_000007");
+    EXPECT_EQ(ImageSequenceExport::getFrameFilename("a.b.jpg", 1234567), "a.b_1234567.jpg");
+}
+
+/**
+ * Test: Every frame is written to its own file, whatever the thread count
+ * Purpose: Verify files are numbered in timeline order, alpha is stored
+ * straight, progress counts files, and only a few frames are allocated
+ */
+TEST(ImageSequenceExportTest, WritesEveryFrameInOrder) {
+    CountingVideo video(1.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 1.0));
+    const Rational rate(30, 1);
+    const int64_t frameCount = ExportPipeline::getFrameCount(timeline, rate);
+    ASSERT_EQ(frameCount, 30);
+
+    const int workerCounts[] = {1, 3};
+    for (int workers : workerCounts) {
+        const std::string filename = ::testing::TempDir() + "sequence_test.png";
+        ExportSettings settings;
+        settings.format = ExportFormat::PNG;
+        settings.png.compressionLevel = 1;
+        ExportMonitor monitor;
+        monitor.start(frameCount);
+        ImageSequenceExport sequence(workers, 2);
+        sequence.setMonitor(&monitor);
+        ASSERT_TRUE(sequence.run(timeline, 8, 6, rate, filename, settings))
+            << sequence.getLastError();
+
+        const SequenceStats& stats = sequence.getStats();
+        EXPECT_EQ(stats.workers, workers);
+        EXPECT_EQ(stats.frameBuffers, 2 + workers + 1);
+        EXPECT_EQ(stats.render.frames, frameCount);
+        EXPECT_EQ(stats.encode.frames, frameCount);
+        EXPECT_GT(stats.getFilesPerSecond(), 0.0);
+        EXPECT_EQ(monitor.getProgress().framesDone, frameCount);
+
+        for (int64_t i = 0; i < frameCount; i++) {
+            const std::string name = ImageSequenceExport::getFrameFilename(filename, i);
+            EXPECT_EQ(levelOfFile(name), CountingVideo::levelAt(i / 30.0)) << name;
+            std::remove(name.c_str());
+        }
+        EXPECT_FALSE(fileExists(ImageSequenceExport::getFrameFilename(filename, frameCount)));
+    }
+}
+
+/**
+ * Test: Failing and cancelled sequences stop early
+ * Purpose: Verify a file that can't be written fails the export with its
+ * name, cancelling stops rendering, and video formats are refused
+ */
+TEST(ImageSequenceExportTest, StopsOnFailureAndCancel) {
+    CountingVideo video(2.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 2.0));
+    const Rational rate(30, 1);
+    ExportSettings settings;
+    settings.format = ExportFormat::BMP;
+
+    ImageSequenceExport sequence(2, 2);
+    const std::string missing = ::testing::TempDir() + "no_such_directory/frame.bmp";
+    EXPECT_FALSE(sequence.run(timeline, 8, 6, rate, missing, settings));
+    EXPECT_NE(sequence.getLastError().find("no_such_directory/frame_0000"), std::string::npos)
+        << sequence.getLastError();
+    EXPECT_LT(sequence.getStats().render.frames, 60);
+
+    ExportMonitor monitor;
+    monitor.start(60);
+    monitor.cancel();
+    sequence.setMonitor(&monitor);
+    const std::string filename = ::testing::TempDir() + "cancelled_test.bmp";
+    EXPECT_FALSE(sequence.run(timeline, 8, 6, rate, filename, settings));
+    EXPECT_EQ(sequence.getLastError(), "Export cancelled");
+    EXPECT_EQ(sequence.getStats().render.frames, 0);
+    EXPECT_FALSE(fileExists(ImageSequenceExport::getFrameFilename(filename, 0)));
+
+    settings.format = ExportFormat::MP4;
+    EXPECT_FALSE(sequence.run(timeline, 8, 6, rate, filename, settings));
+}
+
+#ifndef _WIN32
+
+/**
+ * Test: A sequence cancelled part way leaves no files behind
+ * Purpose: Verify frames written before the cancel are deleted, as an
+ * unfinished video is
+ */
+TEST(ImageSequenceExportTest, CancelRemovesWrittenFrames) {
+    ExportMonitor monitor;
+    monitor.start(60);
+    CancellingVideo video(2.0, monitor, 1.0);
+    Timeline timeline;
+    timeline.getTrack(timeline.addTrack("Video"))->addEntry(TimelineEntry(&video, 0.0, 2.0));
+
+    const std::string directory = ::testing::TempDir() + "cancelled_sequence";
+    mkdir(directory.c_str(), 0700);
+    ExportSettings settings;
+    settings.format = ExportFormat::BMP;
+    ImageSequenceExport sequence(2, 2);
+    sequence.setMonitor(&monitor);
+    EXPECT_FALSE(sequence.run(timeline, 8, 6, Rational(30, 1), directory + "/frame.bmp",
+                              settings));
+    EXPECT_EQ(sequence.getLastError(), "Export cancelled");
+    EXPECT_GT(sequence.getStats().encode.frames, 0);   // Some were written, then removed
+
+    DIR* listing = opendir(directory.c_str());
+    ASSERT_NE(listing, nullptr);
+    std::vector<std::string> left;
+    while (dirent* item = readdir(listing)) {
+        std::string name = item->d_name;
+        if (name != "." && name != "..") {
+            left.push_back(name);
+        }
+    }
+    closedir(listing);
+    EXPECT_TRUE(left.empty()) << left.size() << " files left, e.g. " << left.front();
+    rmdir(directory.c_str());
+}
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @file test_keyframes.cpp
+ * @brief Unit tests for keyframed entry properties
+ *
+ * Tests KeyframeTrack interpolation (linear, bezier, hold) and the cached
+ * per-frame transform evaluation on TimelineEntry.
+ */
+
+#include <gtest/gtest.h>
+#include "timeline/KeyframeTrack.h"
+#include "timeline/TimelineEntry.h"
+#include "timeline/Track.h"
+
+using namespace csci3081;
+
+// ==============================================================================
+// Test Fixture
+// ==============================================================================
+
+class KeyframeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Value goes 0 -> 10 over one second
+        ramp.setKeyframe(Keyframe(0.0, 0.0f));
+        ramp.setKeyframe(Keyframe(1.0, 10.0f));
+    }
+
+    KeyframeTrack ramp;
+};
+
+// ==============================================================================
+// Interpolation Tests
+// ==============================================================================
+
+/**
+ * Test: Empty track returns the default value
+ * Purpose: Verify un-animated properties fall back to the static value
+ */
+TEST_F(KeyframeTest, EmptyTrackReturnsDefault) {
+    KeyframeTrack empty;
+    EXPECT_FALSE(empty.isAnimated());
+    EXPECT_FLOAT_EQ(empty.evaluate(0.5, 3.0f), 3.0f);
+}
+
+/**
+ * Test: Linear interpolation
+ * Purpose: Verify values between keyframes lie on a straight line
+ */
+TEST_F(KeyframeTest, LinearInterpolation) {
+    EXPECT_FLOAT_EQ(ramp.evaluate(0.0, -1.0f), 0.0f);
+    EXPECT_FLOAT_EQ(ramp.evaluate(0.25, -1.0f), 2.5f);
+    EXPECT_FLOAT_EQ(ramp.evaluate(0.5, -1.0f), 5.0f);
+    EXPECT_FLOAT_EQ(ramp.evaluate(1.0, -1.0f), 10.0f);
+}
+
+/**
+ * Test: Values outside the keyframe range hold the nearest keyframe
+ * Purpose: Verify clamping before the first and after the last keyframe
+ */
+TEST_F(KeyframeTest, ClampsOutsideRange) {
+    EXPECT_FLOAT_EQ(ramp.evaluate(-5.0, -1.0f), 0.0f);
+    EXPECT_FLOAT_EQ(ramp.evaluate(5.0, -1.0f), 10.0f);
+}
+
+/**
+ * Test: Hold interpolation
+ * Purpose: Verify the value steps at the next keyframe
+ */
+TEST_F(KeyframeTest, HoldInterpolation) {
+    KeyframeTrack steps;
+    steps.setKeyframe(Keyframe(0.0, 1.0f, Interpolation::HOLD));
+    steps.setKeyframe(Keyframe(1.0, 2.0f, Interpolation::HOLD));
+    steps.setKeyframe(Keyframe(2.0, 3.0f));
+
+    EXPECT_FLOAT_EQ(steps.evaluate(0.99, 0.0f), 1.0f);
+    EXPECT_FLOAT_EQ(steps.evaluate(1.0, 0.0f), 2.0f);
+    EXPECT_FLOAT_EQ(steps.evaluate(1.5, 0.0f), 2.0f);
+    EXPECT_FLOAT_EQ(steps.evaluate(2.0, 0.0f), 3.0f);
+}
+
+/**
+ * Test: Bezier interpolation eases in and out
+ * Purpose: Verify the default ease-in-out curve is slow at the ends,
+ * symmetric around the middle and monotonic
+ */
+TEST_F(KeyframeTest, BezierEaseInOut) {
+    KeyframeTrack eased;
+    eased.setKeyframe(Keyframe(0.0, 0.0f, Interpolation::BEZIER));
+    eased.setKeyframe(Keyframe(1.0, 10.0f));
+
+    EXPECT_NEAR(eased.evaluate(0.5, 0.0f), 5.0f, 0.01f);
+    EXPECT_LT(eased.evaluate(0.1, 0.0f), 1.0f);
+    EXPECT_GT(eased.evaluate(0.9, 0.0f), 9.0f);
+
+    float previous = 0.0f;
+    for (int i = 1; i <= 20; i++) {
+        float value = eased.evaluate(i / 20.0, 0.0f);
+        EXPECT_GE(value, previous);
+        previous = value;
+    }
+}
+
+/**
+ * Test: Linear bezier handles reproduce linear interpolation
+ * Purpose: Verify custom ease handles are used
+ */
+TEST_F(KeyframeTest, BezierWithLinearHandles) {
+    Keyframe start(0.0, 0.0f, Interpolation::BEZIER);
+    start.easeOutX = 0.0f;
+    start.easeOutY = 0.0f;
+    start.easeInX = 1.0f;
+    start.easeInY = 1.0f;
+
+    KeyframeTrack track;
+    track.setKeyframe(start);
+    track.setKeyframe(Keyframe(2.0, 4.0f));
+
+    EXPECT_NEAR(track.evaluate(0.5, 0.0f), 1.0f, 0.01f);
+    EXPECT_NEAR(track.evaluate(1.5, 0.0f), 3.0f, 0.01f);
+}
+
+/**
+ * Test: Keyframes stay sorted and unique
+ * Purpose: Verify out-of-order inserts and replacement at the same time
+ */
+TEST_F(KeyframeTest, KeyframesSortedAndReplaced) {
+    ramp.setKeyframe(Keyframe(0.5, 100.0f));
+    ramp.setKeyframe(Keyframe(0.5, 20.0f));
+
+    ASSERT_EQ(ramp.getKeyframeCount(), 3u);
+    EXPECT_DOUBLE_EQ(ramp.getKeyframes()[1].time, 0.5);
+    EXPECT_FLOAT_EQ(ramp.getKeyframes()[1].value, 20.0f);
+    EXPECT_FLOAT_EQ(ramp.evaluate(0.75, 0.0f), 15.0f);
+
+    EXPECT_TRUE(ramp.removeKeyframe(1));
+    EXPECT_FALSE(ramp.removeKeyframe(5));
+    EXPECT_FLOAT_EQ(ramp.evaluate(0.5, 0.0f), 5.0f);
+}
+
+// ==============================================================================
+// TimelineEntry Tests
+// ==============================================================================
+
+/**
+ * Test: Keyframe times are relative to the entry start
+ * Purpose: Verify moving an entry moves its animation with it
+ */
+TEST_F(KeyframeTest, EntryKeyframesAreLocal) {
+    TimelineEntry entry(nullptr, 10.0, 1.0);
+    entry.setKeyframes(EntryProperty::OPACITY, ramp);
+
+    EXPECT_FLOAT_EQ(entry.getTransformAt(10.5).opacity, 5.0f);
+
+    entry.setStartTime(20.0);
+    EXPECT_FLOAT_EQ(entry.getTransformAt(20.5).opacity, 5.0f);
+}
+
+/**
+ * Test: Un-animated properties keep their static values
+ * Purpose: Verify keyframes only override their own property
+ */
+TEST_F(KeyframeTest, StaticPropertiesPassThrough) {
+    TimelineEntry entry(nullptr, 0.0, 1.0);
+    EntryTransform t;
+    t.scaleX = 0.25f;
+    entry.setTransform(t);
+    EXPECT_FALSE(entry.isAnimated());
+
+    entry.setKeyframe(EntryProperty::POSITION_X, Keyframe(0.0, 0.0f));
+    entry.setKeyframe(EntryProperty::POSITION_X, Keyframe(1.0, 1.0f));
+    EXPECT_TRUE(entry.isAnimated());
+
+    const EntryTransform& evaluated = entry.getTransformAt(0.5);
+    EXPECT_FLOAT_EQ(evaluated.positionX, 0.5f);
+    EXPECT_FLOAT_EQ(evaluated.scaleX, 0.25f);
+    EXPECT_FLOAT_EQ(evaluated.positionY, 0.5f);
+}
+
+/**
+ * Test: Evaluated transform is cached per frame and invalidated on edits
+ * Purpose: Verify repeated lookups share one evaluation and that edits
+ * are never hidden by a stale cache
+ */
+TEST_F(KeyframeTest, TransformCacheInvalidatedOnEdit) {
+    TimelineEntry entry(nullptr, 0.0, 1.0);
+    entry.setKeyframes(EntryProperty::OPACITY, ramp);
+
+    const EntryTransform* first = &entry.getTransformAt(0.5);
+    const EntryTransform* second = &entry.getTransformAt(0.5);
+    EXPECT_EQ(first, second);
+    EXPECT_FLOAT_EQ(second->opacity, 5.0f);
+
+    entry.setKeyframe(EntryProperty::OPACITY, Keyframe(1.0, 20.0f));
+    EXPECT_FLOAT_EQ(entry.getTransformAt(0.5).opacity, 10.0f);
+
+    EntryTransform t;
+    t.rotation = 45.0f;
+    entry.setTransform(t);
+    EXPECT_FLOAT_EQ(entry.getTransformAt(0.5).rotation, 45.0f);
+}
+
+/**
+ * Test: Track can animate one of its entries
+ * Purpose: Verify updateEntryKeyframes validates the index and applies
+ */
+TEST_F(KeyframeTest, TrackUpdatesEntryKeyframes) {
+    Track track("Animated");
+    ASSERT_TRUE(track.addEntry(TimelineEntry(nullptr, 0.0, 1.0)));
+
+    EXPECT_TRUE(track.updateEntryKeyframes(0, EntryProperty::SCALE_Y, ramp));
+    EXPECT_FALSE(track.updateEntryKeyframes(3, EntryProperty::SCALE_Y, ramp));
+    EXPECT_FLOAT_EQ(track.getEntryAt(0.5)->getTransformAt(0.5).scaleY, 5.0f);
+}
@@ -0,0 +1,393 @@
+/**
+ * @file test_linear_compositing.cpp
+ * @brief Unit tests for compositing in linear light
+ *
+ * Tests the sRGB transfer tables, the 16-bit blend kernels against a
+ * double-precision reference, and rendering through the Timeline in
+ * CompositingMode::LINEAR_16BIT.
+ */
+
+#include <gtest/gtest.h>
+#include "compositor/LinearBlend.h"
+#include "compositor/LinearFrame.h"
+#include "timeline/Timeline.h"
+#include "Image.h"
+#include "graphics/Color.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Assets and Helpers
+// ==============================================================================
+
+/**
+ * @brief Solid-color still that counts how often it is read
+ */
+class FlatAsset : public IAsset {
+public:
+    FlatAsset(const Color& color, int width = 8, int height = 8)
+        : frame(width, height), reads(0) { frame.fill(color); }
+
+    double getDuration() const override { return 10.0; }
+    const Image& getFrame(double time = 0.0) override {
+        reads++;
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return false; }
+    AssetType getAssetType() const override { return AssetType::IMAGE; }
+
+    Image frame;
+    std::atomic<int> reads;
+};
+
+double toLinear(double c) {
+    return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+}
+
+double toSrgb(double l) {
+    return l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+}
+
+/**
+ * @brief B(s, d) on straight 0-1 values, as documented in compositor/Blend.h
+ */
+double mixReference(BlendMode mode, double s, double d) {
+    switch (mode) {
+        case BlendMode::NORMAL: return s;
+        case BlendMode::ADD: return std::min(s + d, 1.0);
+        case BlendMode::MULTIPLY: return s * d;
+        case BlendMode::SCREEN: return s + d - s * d;
+        case BlendMode::OVERLAY:
+            return d < 0.5 ? 2.0 * s * d : 1.0 - 2.0 * (1.0 - s) * (1.0 - d);
+        case BlendMode::DARKEN: return std::min(s, d);
+        case BlendMode::LIGHTEN: return std::max(s, d);
+    }
+    return s;
+}
+
+TimelineEntry placedEntry(IAsset* asset, float opacity) {
+    TimelineEntry entry(asset, 0.0, 10.0);
+    EntryTransform transform;
+    transform.opacity = opacity;
+    entry.setTransform(transform);
+    return entry;
+}
+
+} // namespace
+
+// ==============================================================================
+// Kernel Tests
+// ==============================================================================
+
+/**
+ * Test: Every 8-bit value survives a trip through linear light
+ * Purpose: Verify the transfer tables invert each other on 8-bit values
+ */
+TEST(LinearBlendTest, TransferRoundTripsEveryValue) {
+    std::vector<unsigned char> src(256 * 4), back(256 * 4);
+    std::vector<uint16_t> linear(256 * 4);
+    for (int i = 0; i < 256; i++) {
+        src[i * 4] = src[i * 4 + 1] = src[i * 4 + 2] = static_cast<unsigned char>(i);
+        src[i * 4 + 3] = 255;
+    }
+
+    srgbToLinearSpan(linear.data(), src.data(), 256);
+    linearToSrgbSpan(back.data(), linear.data(), 256);
+    EXPECT_EQ(back, src);
+
+    // Linear values increase with the encoded value and span the full range
+    for (int i = 1; i < 256; i++) {
+        EXPECT_GT(linear[i * 4], linear[(i - 1) * 4]);
+    }
+    EXPECT_EQ(linear[0], 0);
+    EXPECT_EQ(linear[255 * 4], 65535);
+}
+
+/**
+ * Test: Translucent premultiplied pixels survive a trip through linear light
+ * Purpose: Verify colors are converted through their straight values and
+ * alpha is kept exactly
+ */
+TEST(LinearBlendTest, TransferKeepsPremultipliedAlpha) {
+    std::vector<unsigned char> src, back;
+    for (int alpha = 1; alpha < 255; alpha += 6) {
+        for (int value = 0; value <= alpha; value += 3) {
+            unsigned char pixel[4] = {static_cast<unsigned char>(value),
+                                      static_cast<unsigned char>(alpha / 2), 0,
+                                      static_cast<unsigned char>(alpha)};
+            src.insert(src.end(), pixel, pixel + 4);
+        }
+    }
+    int count = static_cast<int>(src.size() / 4);
+    std::vector<uint16_t> linear(src.size());
+    back.resize(src.size());
+    srgbToLinearSpan(linear.data(), src.data(), count);
+    linearToSrgbSpan(back.data(), linear.data(), count);
+
+    for (int i = 0; i < count * 4; i++) {
+        EXPECT_LE(std::abs(back[i] - src[i]), 1) << "pixel " << i / 4;
+        if (i % 4 < 3) {
+            EXPECT_LE(linear[i], linear[i - i % 4 + 3]) << "pixel " << i / 4;
+        }
+    }
+}
+
+/**
+ * Test: Decoding a linear value lands within one step of the exact curve
+ * Purpose: Verify the 12-bit table is accurate for values between entries
+ */
+TEST(LinearBlendTest, EncodeTableIsAccurate) {
+    for (int value = 0; value < 65536; value += 7) {
+        uint16_t pixel[4] = {static_cast<uint16_t>(value), 0, 0, 65535};
+        unsigned char out[4];
+        linearToSrgbSpan(out, pixel, 1);
+        double exact = toSrgb(value / 65535.0) * 255.0;
+        EXPECT_LE(std::fabs(out[0] - exact), 1.0) << "linear value " << value;
+    }
+}
+
+/**
+ * Test: Opaque layers cover, transparent layers leave the frame alone
+ * Purpose: Verify the alpha endpoints are exact
+ */
+TEST(LinearBlendTest, OpaqueCoversTransparentKeeps) {
+    uint16_t frame[8] = {1000, 2000, 3000, 65535, 4000, 5000, 6000, 30000};
+    uint16_t opaque[8] = {60000, 100, 7, 65535, 1, 2, 3, 65535};
+    uint16_t clear[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+    uint16_t dst[8];
+    std::copy(frame, frame + 8, dst);
+    blendLinearSpan(dst, clear, 2, 255, BlendMode::NORMAL);
+    EXPECT_EQ(std::vector<uint16_t>(dst, dst + 8), std::vector<uint16_t>(frame, frame + 8));
+
+    blendLinearSpan(dst, opaque, 2, 0, BlendMode::NORMAL);
+    EXPECT_EQ(std::vector<uint16_t>(dst, dst + 8), std::vector<uint16_t>(frame, frame + 8));
+
+    blendLinearSpan(dst, opaque, 2, 255, BlendMode::NORMAL);
+    EXPECT_EQ(std::vector<uint16_t>(dst, dst + 8), std::vector<uint16_t>(opaque, opaque + 8));
+}
+
+/**
+ * Test: Every blend mode matches a double-precision reference
+ * Purpose: Verify the single-precision kernels round correctly
+ */
+TEST(LinearBlendTest, BlendModesMatchReference) {
+    const int count = 37;
+    std::srand(11);
+    for (int m = 0; m < BLEND_MODE_COUNT; m++) {
+        BlendMode mode = static_cast<BlendMode>(m);
+        // Premultiplied: every color channel is at most the pixel's alpha
+        std::vector<uint16_t> src(count * 4), dst(count * 4);
+        for (int i = 0; i < count; i++) {
+            int srcAlpha = std::rand() % 65536;
+            int dstAlpha = std::rand() % 65536;
+            for (int c = 0; c < 3; c++) {
+                src[i * 4 + c] = static_cast<uint16_t>(std::rand() % (srcAlpha + 1));
+                dst[i * 4 + c] = static_cast<uint16_t>(std::rand() % (dstAlpha + 1));
+            }
+            src[i * 4 + 3] = static_cast<uint16_t>(srcAlpha);
+            dst[i * 4 + 3] = static_cast<uint16_t>(dstAlpha);
+        }
+        const int opacity = 200;
+        std::vector<uint16_t> out = dst;
+        blendLinearSpan(out.data(), src.data(), count, opacity, mode);
+
+        for (int i = 0; i < count; i++) {
+            double scale = opacity / 255.0;
+            double sa = src[i * 4 + 3] / 65535.0 * scale;
+            double da = dst[i * 4 + 3] / 65535.0;
+            for (int c = 0; c < 3; c++) {
+                double s = src[i * 4 + c] / 65535.0 * scale;
+                double d = dst[i * 4 + c] / 65535.0;
+                double expected = s * (1.0 - da) + d * (1.0 - sa);
+                if (sa > 0.0 && da > 0.0) {
+                    expected += sa * da * mixReference(mode, s / sa, d / da);
+                }
+                if (mode == BlendMode::NORMAL) {
+                    expected = s + d * (1.0 - sa);
+                }
+                EXPECT_LE(std::fabs(out[i * 4 + c] - expected * 65535.0), 1.0)
+                    << blendModeName(mode) << " pixel " << i << " channel " << c;
+            }
+            double expectedAlpha = (sa + da * (1.0 - sa)) * 65535.0;
+            EXPECT_LE(std::fabs(out[i * 4 + 3] - expectedAlpha), 1.0);
+        }
+    }
+}
+
+/**
+ * Test: Linear crossfade midpoint
+ * Purpose: Verify red to blue passes through a bright magenta, not a dark one
+ */
+TEST(LinearBlendTest, CrossfadeMixesInLinearLight) {
+    LinearFrame from(2, 1), to(2, 1), out(2, 1);
+    from.fill(Color(255, 0, 0, 255));
+    to.fill(Color(0, 0, 255, 255));
+
+    applyLinearTransition(from, to, out, Transition(), 0.5);
+    Image image(2, 1);
+    out.toImage(image);
+    EXPECT_NEAR(image.getPixel(0, 0).red(), 188, 1);
+    EXPECT_EQ(image.getPixel(0, 0).green(), 0);
+    EXPECT_NEAR(image.getPixel(0, 0).blue(), 188, 1);
+    EXPECT_EQ(image.getPixel(0, 0).alpha(), 255);
+}
+
+// ==============================================================================
+// Timeline Tests
+// ==============================================================================
+
+class LinearCompositingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        timeline.setBackgroundColor(Color(0, 0, 0, 255));
+    }
+
+    Image render(double time, int width = 8, int height = 8) {
+        Image frame(width, height);
+        timeline.renderFrameInto(time, frame);
+        return frame;
+    }
+
+    Timeline timeline;
+};
+
+/**
+ * Test: Half-transparent white over black
+ * Purpose: Verify linear light gives the physically correct mid gray
+ */
+TEST_F(LinearCompositingTest, HalfWhiteOverBlackIsBrighter) {
+    FlatAsset white(Color(255, 255, 255, 255));
+    timeline.addTrack("Overlay");
+    timeline.addEntryToTrack(0, placedEntry(&white, 0.5f));
+
+    EXPECT_EQ(timeline.getCompositingMode(), CompositingMode::GAMMA_8BIT);
+    EXPECT_NEAR(render(1.0).getPixel(4, 4).red(), 128, 1);
+
+    timeline.setCompositingMode(CompositingMode::LINEAR_16BIT);
+    Image linear = render(1.0);
+    EXPECT_NEAR(linear.getPixel(4, 4).red(), 188, 1);
+    EXPECT_EQ(linear.getPixel(4, 4).red(), linear.getPixel(4, 4).blue());
+    EXPECT_EQ(linear.getPixel(4, 4).alpha(), 255);
+}
+
+/**
+ * Test: Opaque layers look the same in both modes
+ * Purpose: Verify the only conversion back is exact for unblended pixels,
+ * including a scaled picture-in-picture
+ */
+TEST_F(LinearCompositingTest, OpaqueLayersMatchGammaMode) {
+    FlatAsset base(Color(30, 140, 220, 255));
+    Image gradient(16, 16);
+    for (int y = 0; y < 16; y++) {
+        for (int x = 0; x < 16; x++) {
+            gradient.setPixel(x, y, Color(x * 16, y * 16, 77, 255));
+        }
+    }
+    FlatAsset inset(Color(0, 0, 0, 255), 16, 16);
+    inset.frame = gradient;
+
+    timeline.addTrack("Base");
+    timeline.addTrack("Inset");
+    timeline.addEntryToTrack(0, TimelineEntry(&base, 0.0, 10.0));
+    TimelineEntry pip(&inset, 0.0, 10.0);
+    EntryTransform corner;
+    corner.positionX = 0.6f;
+    corner.positionY = 0.4f;
+    corner.scaleX = 0.45f;
+    corner.scaleY = 0.55f;
+    corner.rotation = 20.0f;
+    pip.setTransform(corner);
+    timeline.addEntryToTrack(1, pip);
+
+    Image gamma = render(1.0, 40, 30);
+    timeline.setCompositingMode(CompositingMode::LINEAR_16BIT);
+    Image linear = render(1.0, 40, 30);
+    EXPECT_EQ(std::vector<unsigned char>(linear.getData(), linear.getData() + 40 * 30 * 4),
+              std::vector<unsigned char>(gamma.getData(), gamma.getData() + 40 * 30 * 4));
+}
+
+/**
+ * Test: Many translucent layers do not accumulate rounding error
+ * Purpose: Verify 16 stacked layers stay within one step of a
+ * double-precision linear-light reference
+ */
+TEST_F(LinearCompositingTest, StackedLayersStayAccurate) {
+    const int layers = 16;
+    std::vector<FlatAsset*> assets;
+    double reference[3] = {0.0, 0.0, 0.0};   // Linear, over the black background
+    for (int i = 0; i < layers; i++) {
+        Color color((i * 53) % 256, (i * 97 + 40) % 256, (i * 31 + 200) % 256, 255);
+        assets.push_back(new FlatAsset(color));
+        timeline.addTrack("Layer");
+        timeline.addEntryToTrack(i, placedEntry(assets.back(), 0.2f));
+
+        double a = 51.0 / 255.0;   // Opacity 0.2 as the blitter rounds it
+        const int channels[3] = {color.red(), color.green(), color.blue()};
+        for (int c = 0; c < 3; c++) {
+            double s = srgbToLinear(channels[c]) / 65535.0;
+            reference[c] = s * a + reference[c] * (1.0 - a);
+        }
+    }
+
+    timeline.setCompositingMode(CompositingMode::LINEAR_16BIT);
+    Color result = render(1.0).getPixel(2, 5);
+    EXPECT_NEAR(result.red(), toSrgb(reference[0]) * 255.0, 1.0);
+    EXPECT_NEAR(result.green(), toSrgb(reference[1]) * 255.0, 1.0);
+    EXPECT_NEAR(result.blue(), toSrgb(reference[2]) * 255.0, 1.0);
+
+    for (FlatAsset* asset : assets) {
+        delete asset;
+    }
+}
+
+/**
+ * Test: Transitions are mixed in linear light
+ * Purpose: Verify a crossfade on the timeline uses the linear kernel
+ */
+TEST_F(LinearCompositingTest, CrossfadeOnTimeline) {
+    FlatAsset red(Color(255, 0, 0, 255));
+    FlatAsset blue(Color(0, 0, 255, 255));
+    timeline.addTrack("Video");
+    timeline.addEntryToTrack(0, TimelineEntry(&red, 0.0, 2.0));
+    timeline.addEntryToTrack(0, TimelineEntry(&blue, 2.0, 2.0));
+    ASSERT_TRUE(timeline.getTrack(0)->setTransition(0, Transition()));
+
+    EXPECT_NEAR(render(2.0).getPixel(1, 1).red(), 128, 1);
+
+    timeline.setCompositingMode(CompositingMode::LINEAR_16BIT);
+    Color mid = render(2.0).getPixel(1, 1);
+    EXPECT_NEAR(mid.red(), 188, 1);
+    EXPECT_NEAR(mid.blue(), 188, 1);
+
+    // Outside the window only one side is drawn
+    EXPECT_EQ(render(3.0).getPixel(1, 1).blue(), 255);
+    EXPECT_EQ(render(3.0).getPixel(1, 1).red(), 0);
+}
+
+/**
+ * Test: Invisible layers are skipped in linear mode too
+ * Purpose: Verify the composite node does not pull zero-opacity layers
+ */
+TEST_F(LinearCompositingTest, ZeroOpacityLayerIsNotPulled) {
+    FlatAsset base(Color(90, 90, 90, 255));
+    FlatAsset hidden(Color(255, 0, 0, 255));
+    timeline.addTrack("Base");
+    timeline.addTrack("Hidden");
+    timeline.addEntryToTrack(0, TimelineEntry(&base, 0.0, 10.0));
+    timeline.addEntryToTrack(1, placedEntry(&hidden, 0.0f));
+
+    timeline.setCompositingMode(CompositingMode::LINEAR_16BIT);
+    Color result = render(1.0).getPixel(3, 3);
+    EXPECT_EQ(result.red(), 90);
+    EXPECT_EQ(hidden.reads.load(), 0);
+    EXPECT_EQ(base.reads.load(), 1);
+}
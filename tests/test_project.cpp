@@ -0,0 +1,326 @@
+/**
+ * @file test_project.cpp
+ * @brief Unit tests for saving and opening projects
+ *
+ * Tests round trips through the binary and JSON project formats, lazy
+ * asset loading, and rejecting broken or newer files.
+ */
+
+#include <gtest/gtest.h>
+#include "assets/LazyAsset.h"
+#include "project/ProjectFile.h"
+#include "timeline/Timeline.h"
+#include "util/Json.h"
+#include "Image.h"
+#include "graphics/Color.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Assets
+// ==============================================================================
+
+/**
+ * @brief Asset with a fixed type and duration
+ */
+class StubAsset : public IAsset {
+public:
+    StubAsset(AssetType type, double duration) : frame(2, 2), type(type), duration(duration) {
+        frame.fill(Color(0, 0, 255, 255));
+    }
+
+    double getDuration() const override { return duration; }
+    const Image& getFrame(double time = 0.0) override { return frame; }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return type == AssetType::VIDEO; }
+    AssetType getAssetType() const override { return type; }
+
+private:
+    Image frame;
+    AssetType type;
+    double duration;
+};
+
+/**
+ * @brief Factory that counts the assets it creates
+ */
+class CountingFactory : public IAssetFactory {
+public:
+    CountingFactory() : created(0) {}
+
+    IAsset* create(const std::string& value) const override {
+        created++;
+        return new StubAsset(AssetType::IMAGE, 5.0);
+    }
+
+    mutable int created;
+};
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string& path, const std::string& bytes) {
+    std::ofstream file(path, std::ios::binary);
+    file << bytes;
+}
+
+// ==============================================================================
+// Test Fixture
+// ==============================================================================
+
+class ProjectTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        video = new StubAsset(AssetType::VIDEO, 12.5);
+        image = new StubAsset(AssetType::IMAGE, 5.0);
+        project.assetSources = {"clips/intro.mp4", "stills/logo \"v2\".png"};
+        project.assets = {video, image};
+        project.exportSettings.format = ExportFormat::MP4;
+        project.exportSettings.width = 1920;
+        project.exportSettings.height = 1080;
+        project.exportSettings.frameRate = 30000.0 / 1001.0;
+
+        timeline.setBackgroundColor(Color(10, 20, 30, 255));
+        timeline.setCompositingMode(CompositingMode::LINEAR_16BIT);
+
+        Track* base = timeline.getTrack(timeline.addTrack("Base"));
+        base->addEntry(TimelineEntry(video, 0.0, 2.0));
+        base->addEntry(TimelineEntry(image, 2.0, 1.0 / 3.0));
+        base->setTransition(0, Transition(TransitionType::DIP_TO_COLOR, 0.5));
+        project.trackFilters.push_back("trackColor.r *= 1.25;\n");
+
+        Track* overlay = timeline.getTrack(timeline.addTrack("Overlay"));
+        overlay->setBlendMode(BlendMode::SCREEN);
+        overlay->setVisible(false);
+        TimelineEntry title(image, 0.5, 1.5);
+        EntryTransform placement;
+        placement.positionY = 0.85f;
+        placement.scaleY = 0.1f;
+        title.setTransform(placement);
+        KeyframeTrack fade;
+        fade.setKeyframe(Keyframe(0.0, 0.0f, Interpolation::BEZIER));
+        fade.setKeyframe(Keyframe(1.5, 1.0f, Interpolation::HOLD));
+        title.setKeyframes(EntryProperty::OPACITY, fade);
+        overlay->addEntry(title);
+        project.trackFilters.push_back("");
+
+        binaryPath = ::testing::TempDir() + "project_test.vedp";
+        jsonPath = ::testing::TempDir() + "project_test.json";
+    }
+
+    void TearDown() override {
+        for (IAsset* asset : loaded.assets) {
+            delete asset;
+        }
+        delete video;
+        delete image;
+        std::remove(binaryPath.c_str());
+        std::remove(jsonPath.c_str());
+    }
+
+    // JSON text of a project, used to compare everything at once
+    std::string describe(ProjectFile& file, const Project& p, const Timeline& t) {
+        EXPECT_TRUE(file.exportJson(jsonPath, p, t)) << file.getLastError();
+        return readFile(jsonPath);
+    }
+
+    StubAsset* video;
+    StubAsset* image;
+    Project project;
+    Timeline timeline;
+    Project loaded;
+    Timeline opened;
+    CountingFactory factory;
+    std::string binaryPath;
+    std::string jsonPath;
+};
+
+} // namespace
+
+// ==============================================================================
+// Round Trip Tests
+// ==============================================================================
+
+/**
+ * Test: A saved project opens with everything it had
+ * Purpose: Verify tracks, entries, transforms, keyframes, transitions,
+ * filters and export settings all survive the binary format exactly
+ */
+TEST_F(ProjectTest, BinaryRoundTripKeepsEverything) {
+    ProjectFile file(&factory);
+    ASSERT_TRUE(file.save(binaryPath, project, timeline)) << file.getLastError();
+    ASSERT_TRUE(file.load(binaryPath, loaded, opened)) << file.getLastError();
+
+    ASSERT_EQ(opened.getTrackCount(), 2u);
+    const Track* base = opened.getTrack(0);
+    const Track* overlay = opened.getTrack(1);
+    EXPECT_EQ(base->getName(), "Base");
+    EXPECT_EQ(base->getEntry(1).getDurationTicks(), secondsToTicks(1.0 / 3.0));
+    EXPECT_EQ(base->getEntry(0).getOutTransition().type, TransitionType::DIP_TO_COLOR);
+    EXPECT_EQ(overlay->getBlendMode(), BlendMode::SCREEN);
+    EXPECT_FALSE(overlay->isVisible());
+    EXPECT_FLOAT_EQ(overlay->getEntry(0).getTransform().positionY, 0.85f);
+    EXPECT_EQ(overlay->getEntry(0).getKeyframes(EntryProperty::OPACITY).getKeyframeCount(), 2u);
+    EXPECT_EQ(loaded.trackFilters, project.trackFilters);
+    EXPECT_EQ(loaded.assetSources, project.assetSources);
+    EXPECT_EQ(loaded.exportSettings.frameRate, project.exportSettings.frameRate);
+    EXPECT_EQ(opened.getCompositingMode(), CompositingMode::LINEAR_16BIT);
+    EXPECT_EQ(opened.getBackgroundColor().green(), 20);
+
+    EXPECT_EQ(describe(file, loaded, opened), describe(file, project, timeline));
+}
+
+/**
+ * Test: JSON export and import give back the same project
+ * Purpose: Verify the JSON form is lossless, so it can be diffed and
+ * edited by hand
+ */
+TEST_F(ProjectTest, JsonRoundTripIsLossless) {
+    ProjectFile file(&factory);
+    std::string original = describe(file, project, timeline);
+    ASSERT_TRUE(file.importJson(jsonPath, loaded, opened)) << file.getLastError();
+    EXPECT_EQ(describe(file, loaded, opened), original);
+
+    JsonValue root;
+    std::string error;
+    ASSERT_TRUE(JsonValue::parse(original, root, error)) << error;
+    EXPECT_EQ(root["assets"][1]["source"].asString(), "stills/logo \"v2\".png");
+    EXPECT_EQ(root["tracks"][0]["entries"][1]["duration"].asInt(),
+              secondsToTicks(1.0 / 3.0));
+    EXPECT_EQ(root["tracks"][1]["blend"].asString(), "screen");
+}
+
+/**
+ * Test: Opening a project doesn't load its assets
+ * Purpose: Verify assets are created on their first frame, once, with the
+ * saved duration and type available before that
+ */
+TEST_F(ProjectTest, AssetsLoadOnFirstFrame) {
+    ProjectFile file(&factory);
+    ASSERT_TRUE(file.save(binaryPath, project, timeline));
+    ASSERT_TRUE(file.load(binaryPath, loaded, opened));
+    EXPECT_EQ(factory.created, 0);
+
+    LazyAsset* clip = dynamic_cast<LazyAsset*>(loaded.assets[0]);
+    ASSERT_NE(clip, nullptr);
+    EXPECT_DOUBLE_EQ(clip->getDuration(), 12.5);
+    EXPECT_TRUE(clip->isVideo());
+    EXPECT_FALSE(clip->isLoaded());
+
+    Image frame(4, 4);
+    opened.renderFrameInto(0.5, frame);
+    EXPECT_EQ(factory.created, 1);
+    EXPECT_TRUE(clip->isLoaded());
+    clip->getFrame(1.0);
+    EXPECT_EQ(factory.created, 1);
+}
+
+// ==============================================================================
+// Error Tests
+// ==============================================================================
+
+/**
+ * Test: Broken files are refused without changing anything
+ * Purpose: Verify every truncation of a valid file, a wrong magic number
+ * and a newer version all fail cleanly
+ */
+TEST_F(ProjectTest, BrokenFilesAreRefused) {
+    ProjectFile file(&factory);
+    ASSERT_TRUE(file.save(binaryPath, project, timeline));
+    const std::string bytes = readFile(binaryPath);
+    opened.addTrack("Untouched");
+
+    for (size_t length = 0; length < bytes.size(); length++) {
+        writeFile(binaryPath, bytes.substr(0, length));
+        EXPECT_FALSE(file.load(binaryPath, loaded, opened)) << length;
+    }
+
+    std::string wrongMagic = bytes;
+    wrongMagic[0] = 'X';
+    writeFile(binaryPath, wrongMagic);
+    EXPECT_FALSE(file.load(binaryPath, loaded, opened));
+    EXPECT_NE(file.getLastError().find("not a project"), std::string::npos);
+
+    std::string newer = bytes;
+    newer[4] = static_cast<char>(ProjectFile::VERSION + 1);
+    writeFile(binaryPath, newer);
+    EXPECT_FALSE(file.load(binaryPath, loaded, opened));
+    EXPECT_NE(file.getLastError().find("newer"), std::string::npos);
+
+    writeFile(jsonPath, "{\"version\": 1, \"assets\": [], \"tracks\": [{\"entries\": [{\"asset\": 0}]}]}");
+    EXPECT_FALSE(file.importJson(jsonPath, loaded, opened));
+
+    ASSERT_EQ(opened.getTrackCount(), 1u);
+    EXPECT_EQ(opened.getTrack(0)->getName(), "Untouched");
+    EXPECT_TRUE(loaded.assets.empty());
+}
+
+/**
+ * Test: Transitions the editor couldn't have made are refused
+ * Purpose: Verify a transition with no duration, a NaN or one longer than
+ * its entries, and an entry ending past the last tick, fail to load, as
+ * Track::setTransition() would refuse them
+ */
+TEST_F(ProjectTest, ImpossibleTransitionsAreRefused) {
+    ProjectFile file(&factory);
+    ASSERT_TRUE(file.exportJson(jsonPath, project, timeline));
+    const std::string text = readFile(jsonPath);
+    const std::string duration = "\"duration\": 0.5";
+    const size_t at = text.find(duration);
+    ASSERT_NE(at, std::string::npos) << text;
+
+    // The image after the cut is a third of a second long
+    const char* const broken[] = {"0", "-1", "0.7", "1e300"};
+    for (const char* value : broken) {
+        writeFile(jsonPath, std::string(text).replace(at, duration.size(),
+                                                      "\"duration\": " + std::string(value)));
+        EXPECT_FALSE(file.importJson(jsonPath, loaded, opened)) << value;
+        EXPECT_NE(file.getLastError().find("transition"), std::string::npos)
+            << file.getLastError();
+    }
+    writeFile(jsonPath, std::string(text).replace(at, duration.size(), "\"duration\": 0.6"));
+    EXPECT_TRUE(file.importJson(jsonPath, loaded, opened)) << file.getLastError();
+
+    // A NaN can only come from a binary file
+    Timeline nan;
+    Track* base = nan.getTrack(nan.addTrack("Base"));
+    base->addEntry(TimelineEntry(video, 0.0, 2.0));
+    Transition transition(TransitionType::CROSSFADE, 1.0);
+    transition.duration = std::nan("");
+    TimelineEntry last(image, 2.0, 1.0);
+    last.setOutTransition(transition);
+    base->addEntry(last);
+    ASSERT_TRUE(file.save(binaryPath, project, nan));
+    EXPECT_FALSE(file.load(binaryPath, loaded, opened));
+    EXPECT_NE(file.getLastError().find("transition"), std::string::npos) << file.getLastError();
+
+    writeFile(jsonPath, "{\"version\": 1, \"assets\": [{\"source\": \"a.png\", "
+                        "\"type\": \"image\"}], \"tracks\": [{\"entries\": [{\"asset\": 0, "
+                        "\"start\": 9223372036854775000, \"duration\": 1000}]}]}");
+    EXPECT_FALSE(file.importJson(jsonPath, loaded, opened));
+    EXPECT_NE(file.getLastError().find("too late"), std::string::npos) << file.getLastError();
+}
+
+/**
+ * Test: A timeline using an asset outside the project isn't saved
+ * Purpose: Verify the file never refers to assets it can't recreate
+ */
+TEST_F(ProjectTest, SaveRequiresProjectAssets) {
+    StubAsset stray(AssetType::IMAGE, 1.0);
+    timeline.getTrack(1)->addEntry(TimelineEntry(&stray, 5.0, 1.0));
+
+    ProjectFile file(&factory);
+    EXPECT_FALSE(file.save(binaryPath, project, timeline));
+    EXPECT_FALSE(file.exportJson(jsonPath, project, timeline));
+    EXPECT_NE(file.getLastError().find("Overlay"), std::string::npos);
+}
@@ -0,0 +1,383 @@
+/**
+ * @file test_render_graph.cpp
+ * @brief Unit tests for the render graph
+ *
+ * Tests lazy evaluation, memoization of unchanged nodes, parallel
+ * evaluation of independent branches, and the graph the Timeline compiles.
+ */
+
+#include <gtest/gtest.h>
+#include "compositor/Blend.h"
+#include "compositor/RenderGraph.h"
+#include "compositor/RenderNodes.h"
+#include "filters/RedFilter.h"
+#include "timeline/Timeline.h"
+#include "Image.h"
+#include "graphics/Color.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Assets and Filters
+// ==============================================================================
+
+/**
+ * @brief Solid-color asset that counts how often its frame is read
+ *
+ * Like the real assets, the frame is premultiplied.
+ */
+class CountingAsset : public IAsset {
+public:
+    CountingAsset(const Color& color, bool video)
+        : frame(8, 8), video(video), reads(0) {
+        frame.fill(premultiplyColor(color));
+    }
+
+    double getDuration() const override { return 10.0; }
+    const Image& getFrame(double time = 0.0) override {
+        reads++;
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return video; }
+    AssetType getAssetType() const override {
+        return video ? AssetType::VIDEO : AssetType::IMAGE;
+    }
+
+    Image frame;
+    bool video;
+    std::atomic<int> reads;
+};
+
+/**
+ * @brief Video whose single decoded frame is red before 1s and blue after
+ */
+class TwoColorVideo : public IAsset {
+public:
+    TwoColorVideo() : frame(8, 8) {}
+
+    double getDuration() const override { return 10.0; }
+    const Image& getFrame(double time = 0.0) override {
+        frame.fill(time < 1.0 ? Color(255, 0, 0, 255) : Color(0, 0, 255, 255));
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+private:
+    Image frame;
+};
+
+/**
+ * @brief Pass-through filter that waits for a partner filter to start
+ *
+ * Two of these only finish quickly when they are applied at the same time.
+ */
+class RendezvousFilter : public IFilter {
+public:
+    RendezvousFilter(int* arrived, std::mutex* mutex, std::condition_variable* cv)
+        : arrived(arrived), mutex(mutex), cv(cv), overlapped(false) {}
+
+    void Apply(const Image& original, Image& filtered) override {
+        filtered = original;
+        std::unique_lock<std::mutex> lock(*mutex);
+        (*arrived)++;
+        cv->notify_all();
+        overlapped = cv->wait_for(lock, std::chrono::seconds(2),
+                                  [this]() { return *arrived >= 2; });
+    }
+
+    int* arrived;
+    std::mutex* mutex;
+    std::condition_variable* cv;
+    bool overlapped;
+};
+
+/**
+ * @brief Filter that counts applications and copies its input
+ */
+class CopyCountingFilter : public IFilter {
+public:
+    CopyCountingFilter() : applied(0) {}
+
+    void Apply(const Image& original, Image& filtered) override {
+        applied++;
+        filtered = original;
+    }
+
+    std::atomic<int> applied;
+};
+
+} // namespace
+
+// ==============================================================================
+// Test Fixture
+// ==============================================================================
+
+class RenderGraphTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        still = new CountingAsset(Color(0, 255, 0, 255), false);
+        video = new CountingAsset(Color(0, 0, 255, 128), true);
+    }
+
+    void TearDown() override {
+        delete still;
+        delete video;
+    }
+
+    CountingAsset* still;
+    CountingAsset* video;
+};
+
+// ==============================================================================
+// Graph Evaluation Tests
+// ==============================================================================
+
+/**
+ * Test: Unchanged nodes are not processed again
+ * Purpose: Verify memoization of a static composition
+ */
+TEST_F(RenderGraphTest, StaticGraphIsMemoized) {
+    TimelineEntry entry(still, 0.0, 10.0);
+    Color background(10, 20, 30, 255);
+
+    RenderGraph graph;
+    RenderNode* frame = graph.addNode(new BackgroundNode(background));
+    RenderNode* source = graph.addNode(new SourceNode(&entry));
+    RenderNode* layer = graph.addNode(new TransformNode(source, &entry));
+    graph.setOutput(graph.addNode(new BlendNode(frame, layer, BlendMode::NORMAL)));
+
+    const Image& first = graph.evaluate(1.0, 8, 8);
+    EXPECT_EQ(first.getPixel(4, 4).green(), 255);
+    EXPECT_EQ(graph.getProcessedCount(), 3u);   // Transform is fused into the blend
+
+    graph.evaluate(2.0, 8, 8);
+    EXPECT_EQ(graph.getProcessedCount(), 0u);
+    EXPECT_EQ(still->reads.load(), 1);
+
+    // A new frame size redraws everything
+    const Image& resized = graph.evaluate(2.0, 4, 4);
+    EXPECT_EQ(resized.getWidth(), 4);
+    EXPECT_EQ(graph.getProcessedCount(), 3u);
+
+    // Changing a parameter only redraws what depends on it
+    background = Color(0, 0, 0, 255);
+    graph.evaluate(2.0, 4, 4);
+    EXPECT_EQ(graph.getProcessedCount(), 2u);
+}
+
+/**
+ * Test: Only branches whose inputs changed are processed
+ * Purpose: Verify a filtered still under a video is filtered once
+ */
+TEST_F(RenderGraphTest, ChangingBranchDoesNotRedrawStaticBranch) {
+    TimelineEntry base(still, 0.0, 10.0);
+    TimelineEntry top(video, 0.0, 10.0);
+    std::shared_ptr<CopyCountingFilter> filter(new CopyCountingFilter());
+    Color background(0, 0, 0, 255);
+
+    RenderGraph graph;
+    RenderNode* frame = graph.addNode(new BackgroundNode(background));
+    RenderNode* baseLayer = graph.addNode(new FilterNode(
+        graph.addNode(new SourceNode(&base)), filter));
+    frame = graph.addNode(new BlendNode(
+        frame, graph.addNode(new TransformNode(baseLayer, &base)), BlendMode::NORMAL));
+    RenderNode* topSource = graph.addNode(new SourceNode(&top));
+    frame = graph.addNode(new BlendNode(
+        frame, graph.addNode(new TransformNode(topSource, &top)), BlendMode::NORMAL));
+    graph.setOutput(frame);
+
+    for (int i = 0; i < 10; i++) {
+        graph.evaluate(i / 30.0, 8, 8);
+    }
+
+    EXPECT_EQ(filter->applied.load(), 1);
+    EXPECT_EQ(still->reads.load(), 1);
+    EXPECT_EQ(video->reads.load(), 10);
+    EXPECT_EQ(graph.getProcessedCount(), 2u);   // Video source and top blend
+}
+
+/**
+ * Test: Invisible layers are not evaluated
+ * Purpose: Verify lazy pull skips the source of a zero-opacity layer
+ */
+TEST_F(RenderGraphTest, ZeroOpacityLayerIsNotPulled) {
+    TimelineEntry entry(video, 0.0, 10.0);
+    EntryTransform hidden;
+    hidden.opacity = 0.0f;
+    Color background(10, 20, 30, 255);
+
+    RenderGraph graph;
+    RenderNode* frame = graph.addNode(new BackgroundNode(background));
+    RenderNode* source = graph.addNode(new SourceNode(&entry));
+    RenderNode* layer = graph.addNode(new TransformNode(source, hidden));
+    graph.setOutput(graph.addNode(new BlendNode(frame, layer, BlendMode::NORMAL)));
+
+    const Image& result = graph.evaluate(0.5, 8, 8);
+    EXPECT_EQ(video->reads.load(), 0);
+    EXPECT_EQ(result.getPixel(3, 3).red(), 10);
+    EXPECT_EQ(result.getPixel(3, 3).blue(), 30);
+}
+
+/**
+ * Test: A TransformNode on its own places its layer over transparency
+ * Purpose: Verify standalone transform output
+ */
+TEST_F(RenderGraphTest, TransformNodeRendersPlacedLayer) {
+    TimelineEntry entry(still, 0.0, 10.0);
+    EntryTransform corner;
+    corner.positionX = 0.25f;
+    corner.positionY = 0.25f;
+    corner.scaleX = 0.5f;
+    corner.scaleY = 0.5f;
+
+    RenderGraph graph;
+    RenderNode* source = graph.addNode(new SourceNode(&entry));
+    graph.setOutput(graph.addNode(new TransformNode(source, corner)));
+
+    const Image& result = graph.evaluate(0.0, 16, 16);
+    EXPECT_EQ(result.getPixel(2, 2).green(), 255);
+    EXPECT_EQ(result.getPixel(2, 2).alpha(), 255);
+    EXPECT_EQ(result.getPixel(12, 12).alpha(), 0);
+}
+
+/**
+ * Test: Independent branches are processed at the same time
+ * Purpose: Verify parallel scheduling. Each filter only completes quickly
+ * if the other one is running.
+ */
+TEST_F(RenderGraphTest, IndependentBranchesRunInParallel) {
+    int arrived = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::shared_ptr<RendezvousFilter> left(new RendezvousFilter(&arrived, &mutex, &cv));
+    std::shared_ptr<RendezvousFilter> right(new RendezvousFilter(&arrived, &mutex, &cv));
+    TimelineEntry a(still, 0.0, 10.0);
+    TimelineEntry b(video, 0.0, 10.0);
+    Color background(0, 0, 0, 255);
+
+    RenderGraph graph;
+    RenderNode* frame = graph.addNode(new BackgroundNode(background));
+    RenderNode* leftLayer = graph.addNode(new FilterNode(graph.addNode(new SourceNode(&a)), left));
+    RenderNode* rightLayer = graph.addNode(new FilterNode(graph.addNode(new SourceNode(&b)), right));
+    frame = graph.addNode(new BlendNode(frame, leftLayer, BlendMode::NORMAL));
+    frame = graph.addNode(new BlendNode(frame, rightLayer, BlendMode::NORMAL));
+    graph.setOutput(frame);
+
+    graph.evaluate(0.0, 8, 8);
+
+    EXPECT_TRUE(left->overlapped);
+    EXPECT_TRUE(right->overlapped);
+    EXPECT_EQ(graph.getLevelCount(), 4u);   // Sources, filters, two blends
+}
+
+/**
+ * Test: Evaluating without a pool gives the same result
+ * Purpose: Verify serial evaluation for callers already on a pool thread
+ */
+TEST_F(RenderGraphTest, SerialEvaluationMatchesParallel) {
+    TimelineEntry base(still, 0.0, 10.0);
+    TimelineEntry top(video, 0.0, 10.0);
+    Color background(40, 40, 40, 255);
+
+    RenderGraph parallel;
+    RenderGraph serial;
+    serial.setThreadPool(nullptr);
+    RenderGraph* graphs[] = {&parallel, &serial};
+    for (int g = 0; g < 2; g++) {
+        RenderGraph& graph = *graphs[g];
+        RenderNode* frame = graph.addNode(new BackgroundNode(background));
+        frame = graph.addNode(new BlendNode(frame, graph.addNode(new SourceNode(&base)),
+                                            BlendMode::NORMAL));
+        frame = graph.addNode(new BlendNode(frame, graph.addNode(new SourceNode(&top)),
+                                            BlendMode::SCREEN));
+        graph.setOutput(frame);
+    }
+
+    const Image& a = parallel.evaluate(0.0, 8, 8);
+    const Image& b = serial.evaluate(0.0, 8, 8);
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            EXPECT_EQ(a.getPixel(x, y).red(), b.getPixel(x, y).red());
+            EXPECT_EQ(a.getPixel(x, y).green(), b.getPixel(x, y).green());
+            EXPECT_EQ(a.getPixel(x, y).blue(), b.getPixel(x, y).blue());
+        }
+    }
+}
+
+// ==============================================================================
+// Timeline Graph Tests
+// ==============================================================================
+
+/**
+ * Test: The timeline graph is reused between cuts
+ * Purpose: Verify compilation happens per layout, not per frame
+ */
+TEST_F(RenderGraphTest, TimelineReusesGraphBetweenCuts) {
+    Timeline timeline;
+    timeline.addTrack();
+    timeline.addEntryToTrack(0, TimelineEntry(still, 0.0, 1.0));
+    timeline.addEntryToTrack(0, TimelineEntry(video, 1.0, 1.0));
+    Image frame(8, 8);
+
+    timeline.renderFrameInto(0.1, frame);
+    size_t nodeCount = timeline.getRenderGraph().getNodeCount();
+    timeline.renderFrameInto(0.5, frame);
+    EXPECT_EQ(timeline.getRenderGraph().getNodeCount(), nodeCount);
+    EXPECT_EQ(timeline.getRenderGraph().getProcessedCount(), 0u);
+
+    // A new graph starts with nothing memoized
+    timeline.renderFrameInto(1.5, frame);
+    EXPECT_EQ(timeline.getRenderGraph().getProcessedCount(), 3u);
+    EXPECT_NEAR(frame.getPixel(4, 4).blue(), 144, 1);   // 50% blue over the background
+}
+
+/**
+ * Test: Editing a track rebuilds the graph
+ * Purpose: Verify track revisions invalidate the compiled graph
+ */
+TEST_F(RenderGraphTest, TimelineRecompilesAfterEdit) {
+    Timeline timeline;
+    timeline.addTrack();
+    timeline.addEntryToTrack(0, TimelineEntry(still, 0.0, 5.0));
+    Image frame(8, 8);
+
+    timeline.renderFrameInto(1.0, frame);
+    EXPECT_EQ(frame.getPixel(4, 4).green(), 255);
+
+    timeline.getTrack(0)->addFilter(std::shared_ptr<IFilter>(new RedFilter()));
+    timeline.renderFrameInto(1.0, frame);
+    EXPECT_EQ(frame.getPixel(4, 4).green(), 0);
+
+    timeline.getTrack(0)->setVisible(false);
+    timeline.renderFrameInto(1.0, frame);
+    EXPECT_EQ(frame.getPixel(4, 4).red(), 32);   // Default background
+}
+
+/**
+ * Test: Two entries of one video in a transition get their own frames
+ * Purpose: Verify shared assets are decoded one after the other and copied
+ */
+TEST_F(RenderGraphTest, SharedAssetDecodedPerEntry) {
+    TwoColorVideo clip;
+    Timeline timeline;
+    timeline.addTrack();
+    // The outgoing entry is 1.5s into the clip (blue), the incoming at 0s (red)
+    timeline.addEntryToTrack(0, TimelineEntry(&clip, 0.0, 2.0));
+    timeline.addEntryToTrack(0, TimelineEntry(&clip, 2.0, 2.0));
+    ASSERT_TRUE(timeline.getTrack(0)->setTransition(0, Transition(TransitionType::CROSSFADE, 1.0)));
+    Image frame(8, 8);
+
+    timeline.renderFrameInto(2.0 - 0.5 + 0.5 * 0.5, frame);   // 25% through
+
+    EXPECT_NEAR(frame.getPixel(4, 4).red(), 64, 1);
+    EXPECT_NEAR(frame.getPixel(4, 4).blue(), 191, 1);
+}
@@ -0,0 +1,715 @@
+/**
+ * @file test_segmented_export.cpp
+ * @brief Unit tests for segment-parallel exports
+ *
+ * Tests that segments start on GOP boundaries, that encoding them in
+ * parallel and joining them gives the same frames at the same times as a
+ * single pipeline, that no two workers share a decoder, that a
+ * checkpointed export resumes where it stopped, and that a re-export
+ * reuses the segments an edit didn't change.
+ */
+
+#include <gtest/gtest.h>
+#include "export/ExportCheckpoint.h"
+#include "export/ExportMonitor.h"
+#include "export/ExportPipeline.h"
+#include "export/SegmentCache.h"
+#include "export/SegmentedExport.h"
+#include "timeline/Timeline.h"
+#include "graphics/Color.h"
+#include "Image.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#ifndef _WIN32
+#include <utime.h>
+#endif
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Doubles
+// ==============================================================================
+
+/**
+ * @brief A "video" whose frames count up 30 times a second, noting overlapping decodes
+ */
+class SteppingVideo : public IAsset {
+public:
+    SteppingVideo(double duration, int step, std::atomic<int>* overlapCount = nullptr)
+        : decodes(0), overlaps(overlapCount ? overlapCount : &ownOverlaps), ownOverlaps(0),
+          frame(16, 8), duration(duration), step(step), decoding(false) {}
+
+    double getDuration() const override { return duration; }
+    const Image& getFrame(double time = 0.0) override {
+        if (decoding.exchange(true)) {
+            (*overlaps)++;
+        }
+        decodes++;
+        int level = (static_cast<int>(std::floor(time * 30.0 + 0.5)) * step) % 220;
+        frame.fill(Color(level, 255 - level, level / 2, 255));
+        decoding = false;
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+    std::atomic<int> decodes;     // getFrame() calls
+    std::atomic<int>* overlaps;   // Calls made while another was running
+    std::atomic<int> ownOverlaps;
+
+private:
+    Image frame;
+    double duration;
+    int step;
+    std::atomic<bool> decoding;
+};
+
+/**
+ * @brief Makes SteppingVideos from sources "1", "2", ... (the step)
+ */
+class SteppingVideoFactory : public IAssetFactory {
+public:
+    SteppingVideoFactory() : created(0), overlaps(0) {}
+
+    IAsset* create(const std::string& value) const override {
+        created++;
+        return new SteppingVideo(20.0, std::stoi(value), &overlaps);
+    }
+
+    mutable std::atomic<int> created;
+    mutable std::atomic<int> overlaps;   // Overlapping decodes of any copy
+};
+
+/**
+ * @brief Sink that keeps the luma plane of every frame
+ */
+class PlaneSink : public IFrameSink {
+public:
+    PlaneSink() : failAt(-1) {}
+
+    bool open(int width, int height, const Rational& rate) override {
+        openedRate = rate;
+        return true;
+    }
+    bool writeFrame(const YuvFrame& frame) override {
+        if (static_cast<int>(planes.size()) == failAt) {
+            return false;
+        }
+        planes.push_back(frame.y);
+        return true;
+    }
+    bool close() override { return true; }
+    std::string getLastError() const override { return failAt >= 0 ? "disk full" : ""; }
+
+    int failAt;
+    Rational openedRate;
+    std::vector<std::vector<uint8_t> > planes;
+};
+
+/**
+ * @brief Segment sink that writes into a PlaneSink the target keeps
+ */
+class SegmentSink : public IFrameSink {
+public:
+    explicit SegmentSink(PlaneSink& part) : part(part) {}
+    bool open(int width, int height, const Rational& rate) override {
+        return part.open(width, height, rate);
+    }
+    bool writeFrame(const YuvFrame& frame) override { return part.writeFrame(frame); }
+    bool close() override { return part.close(); }
+    std::string getLastError() const override { return part.getLastError(); }
+
+private:
+    PlaneSink& part;
+};
+
+/**
+ * @brief Target that joins segments by frame time, like a remux would
+ */
+class JoiningTarget : public ISegmentTarget {
+public:
+    JoiningTarget() : failSegment(-1), concatenated(false) {}
+
+    IFrameSink* createSegmentSink(const ExportSegment& segment) override {
+        PlaneSink& part = parts[segment.index];
+        part.planes.clear();   // Like a part file being overwritten
+        part.failAt = -1;
+        if (segment.index == failSegment) {
+            part.failAt = 5;
+        }
+        return new SegmentSink(part);
+    }
+
+    bool concatenate(const std::vector<ExportSegment>& segments, const Rational& rate) override {
+        concatenated = true;
+        for (const ExportSegment& segment : segments) {
+            const PlaneSink& part = parts[segment.index];
+            EXPECT_EQ(part.planes.size(), static_cast<size_t>(segment.frameCount));
+            EXPECT_EQ(part.openedRate.num, rate.num);
+            // Segment frame n plays at the segment's first frame + n
+            for (size_t i = 0; i < part.planes.size(); i++) {
+                framesByTime[segment.firstFrame + static_cast<int64_t>(i)] = part.planes[i];
+            }
+        }
+        return true;
+    }
+
+    std::string getLastError() const override { return ""; }
+
+    bool hasSegment(const ExportSegment& segment) const override {
+        std::map<int, PlaneSink>::const_iterator part = parts.find(segment.index);
+        return part != parts.end() &&
+               part->second.planes.size() == static_cast<size_t>(segment.frameCount);
+    }
+
+    int failSegment;
+    bool concatenated;
+    std::map<int, PlaneSink> parts;
+    std::map<int64_t, std::vector<uint8_t> > framesByTime;
+};
+
+/**
+ * @brief Two overlapping videos, the top one half transparent
+ */
+void buildTimeline(Timeline& timeline, IAsset* bottom, IAsset* top) {
+    timeline.addTrack("Bottom");
+    timeline.addTrack("Top");
+    timeline.addEntryToTrack(0, TimelineEntry(bottom, 0.0, 10.0));
+    TimelineEntry overlay(top, 2.5, 4.5);
+    EntryTransform transform;
+    transform.opacity = 0.5f;
+    overlay.setTransform(transform);
+    timeline.addEntryToTrack(1, overlay);
+}
+
+#ifndef _WIN32
+/**
+ * @brief Write a file and set when it was last modified
+ */
+void writeSource(const std::string& path, const std::string& bytes, time_t modified) {
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << bytes;
+    }
+    struct utimbuf times;
+    times.actime = modified;
+    times.modtime = modified;
+    utime(path.c_str(), &times);
+}
+#endif
+
+} // namespace
+
+// ==============================================================================
+// Segment Planning Tests
+// ==============================================================================
+
+/**
+ * Test: Segments start on keyframes and cover every frame once
+ * Purpose: Verify GOPs are shared out evenly and short exports get fewer segments
+ */
+TEST(SegmentedExportTest, SegmentsStartOnGopBoundaries) {
+    std::vector<ExportSegment> segments = planSegments(100, 12, 4);
+    ASSERT_EQ(segments.size(), 4u);
+    int64_t next = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        EXPECT_EQ(segments[i].index, static_cast<int>(i));
+        EXPECT_EQ(segments[i].firstFrame, next);
+        EXPECT_EQ(segments[i].firstFrame % 12, 0);
+        next += segments[i].frameCount;
+    }
+    EXPECT_EQ(next, 100);
+    EXPECT_EQ(segments[3].frameCount, 28);   // 3 GOPs, the last one short
+
+    EXPECT_EQ(planSegments(20, 12, 8).size(), 2u);
+    EXPECT_EQ(planSegments(5, 12, 8).size(), 1u);
+    EXPECT_TRUE(planSegments(0, 12, 8).empty());
+}
+
+// ==============================================================================
+// Export Tests
+// ==============================================================================
+
+/**
+ * Test: Joined segments equal the serial export
+ * Purpose: Verify the same number of frames, each at the same time with
+ * the same picture, as one ExportPipeline writes
+ */
+TEST(SegmentedExportTest, MatchesSerialExport) {
+    SteppingVideo bottom(20.0, 1);
+    SteppingVideo top(20.0, 3);
+    Timeline timeline;
+    buildTimeline(timeline, &bottom, &top);
+
+    PlaneSink serial;
+    ExportPipeline pipeline;
+    ASSERT_TRUE(pipeline.run(timeline, 16, 8, Rational(30, 1), serial));
+
+    SteppingVideoFactory factory;
+    std::map<IAsset*, std::string> sources;
+    sources[&bottom] = "1";
+    sources[&top] = "3";
+    SegmentedExport segmented(4, 12);
+    segmented.setAssetSources(&factory, sources);
+    JoiningTarget target;
+    ASSERT_TRUE(segmented.run(timeline, 16, 8, Rational(30, 1), target))
+        << segmented.getLastError();
+
+    EXPECT_EQ(segmented.getSegments().size(), 4u);
+    ASSERT_EQ(target.framesByTime.size(), serial.planes.size());
+    for (size_t i = 0; i < serial.planes.size(); i++) {
+        ASSERT_EQ(target.framesByTime.count(static_cast<int64_t>(i)), 1u) << "frame " << i;
+        ASSERT_EQ(target.framesByTime[static_cast<int64_t>(i)], serial.planes[i])
+            << "frame " << i;
+    }
+    EXPECT_EQ(segmented.getStats().encode.frames, 300);
+}
+
+/**
+ * Test: Every worker decodes its own copy of each video
+ * Purpose: Verify the timeline's assets are left alone and no copy is
+ * decoded by two workers at once; without sources the export isn't split
+ */
+TEST(SegmentedExportTest, WorkersDecodeTheirOwnCopies) {
+    SteppingVideo bottom(20.0, 1);
+    SteppingVideo top(20.0, 3);
+    Timeline timeline;
+    buildTimeline(timeline, &bottom, &top);
+
+    SteppingVideoFactory factory;
+    std::map<IAsset*, std::string> sources;
+    sources[&bottom] = "1";
+    sources[&top] = "3";
+    SegmentedExport segmented(3, 12);
+    segmented.setAssetSources(&factory, sources);
+    JoiningTarget target;
+    ASSERT_TRUE(segmented.run(timeline, 16, 8, Rational(30, 1), target));
+
+    EXPECT_EQ(bottom.decodes.load(), 0);
+    EXPECT_EQ(top.decodes.load(), 0);
+    EXPECT_EQ(factory.created.load(), 2 * static_cast<int>(segmented.getSegments().size()));
+    EXPECT_EQ(factory.overlaps.load(), 0);
+
+    SegmentedExport unsplit(3, 12);
+    JoiningTarget whole;
+    ASSERT_TRUE(unsplit.run(timeline, 16, 8, Rational(30, 1), whole));
+    EXPECT_EQ(unsplit.getSegments().size(), 1u);
+    EXPECT_EQ(whole.framesByTime.size(), 300u);
+}
+
+/**
+ * Test: A failing segment fails the export
+ * Purpose: Verify the other workers stop, nothing is joined, and the error
+ * names the segment
+ */
+TEST(SegmentedExportTest, SegmentFailureStopsExport) {
+    SteppingVideo bottom(20.0, 1);
+    SteppingVideo top(20.0, 3);
+    Timeline timeline;
+    buildTimeline(timeline, &bottom, &top);
+
+    SteppingVideoFactory factory;
+    std::map<IAsset*, std::string> sources;
+    sources[&bottom] = "1";
+    sources[&top] = "3";
+    SegmentedExport segmented(4, 12);
+    segmented.setAssetSources(&factory, sources);
+    JoiningTarget target;
+    target.failSegment = 1;
+    EXPECT_FALSE(segmented.run(timeline, 16, 8, Rational(30, 1), target));
+    EXPECT_FALSE(target.concatenated);
+    EXPECT_NE(segmented.getLastError().find("Segment 1"), std::string::npos);
+    EXPECT_NE(segmented.getLastError().find("disk full"), std::string::npos);
+    EXPECT_EQ(target.parts[1].planes.size(), 5u);
+}
+
+// ==============================================================================
+// Checkpoint Tests
+// ==============================================================================
+
+/**
+ * Test: A manifest only resumes the export it was written for
+ * Purpose: Verify finished segments survive a new checkpoint on the same
+ * file with the same key and plan, anything else starts afresh, and
+ * checkpoint plans are fixed-length runs of GOPs
+ */
+TEST(ExportCheckpointTest, ResumesOnlySameKeyAndPlan) {
+    std::vector<ExportSegment> plan = ExportCheckpoint::planSegments(3000, 12, Rational(30, 1));
+    ASSERT_EQ(plan.size(), 4u);   // 100 seconds in segments of about 30
+    for (const ExportSegment& segment : plan) {
+        EXPECT_EQ(segment.firstFrame % 12, 0);
+        EXPECT_NEAR(segment.frameCount, 750, 12);
+    }
+
+    const std::string path = ::testing::TempDir() + "checkpoint_test.manifest";
+    std::remove(path.c_str());
+    {
+        ExportCheckpoint checkpoint(path);
+        ASSERT_TRUE(checkpoint.begin("abc", plan));
+        EXPECT_FALSE(checkpoint.isDone(plan[1]));
+        ASSERT_TRUE(checkpoint.markDone(plan[1]));
+        ASSERT_TRUE(checkpoint.markDone(plan[3]));
+    }
+
+    ExportCheckpoint resumed(path);
+    ASSERT_TRUE(resumed.begin("abc", plan));
+    EXPECT_FALSE(resumed.isDone(plan[0]));
+    EXPECT_TRUE(resumed.isDone(plan[1]));
+    EXPECT_TRUE(resumed.isDone(plan[3]));
+    EXPECT_EQ(resumed.getDoneFrames(), plan[1].frameCount + plan[3].frameCount);
+
+    // Another plan, then another key, start over (and overwrite the manifest)
+    ExportCheckpoint replanned(path);
+    ASSERT_TRUE(replanned.begin("abc", ExportCheckpoint::planSegments(3000, 24, Rational(30, 1))));
+    EXPECT_EQ(replanned.getDoneFrames(), 0);
+    ExportCheckpoint rekeyed(path);
+    ASSERT_TRUE(rekeyed.begin("abd", plan));
+    EXPECT_EQ(rekeyed.getDoneFrames(), 0);
+
+    rekeyed.finish();
+    FILE* file = std::fopen(path.c_str(), "rb");
+    EXPECT_EQ(file, nullptr);
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+/**
+ * Test: The key identifies what is exported, not the objects in memory
+ * Purpose: Verify a timeline rebuilt from the same sources has the same
+ * key, edits and settings change it, and unknown assets can't be keyed
+ */
+TEST(ExportCheckpointTest, KeyFollowsTimelineAndSettings) {
+    SteppingVideo bottom(20.0, 1);
+    SteppingVideo top(20.0, 3);
+    Timeline timeline;
+    buildTimeline(timeline, &bottom, &top);
+    std::map<IAsset*, std::string> sources;
+    sources[&bottom] = "1";
+    sources[&top] = "3";
+
+    // As it would be after restarting the editor
+    SteppingVideo bottomAgain(20.0, 1);
+    SteppingVideo topAgain(20.0, 3);
+    Timeline again;
+    buildTimeline(again, &bottomAgain, &topAgain);
+    std::map<IAsset*, std::string> sourcesAgain;
+    sourcesAgain[&bottomAgain] = "1";
+    sourcesAgain[&topAgain] = "3";
+
+    const Rational rate(30, 1);
+    EncoderSettings encoder;
+    std::string key;
+    std::string keyAgain;
+    std::string other;
+    ASSERT_TRUE(ExportCheckpoint::makeKey(timeline, sources, 16, 8, rate, encoder, key));
+    ASSERT_TRUE(ExportCheckpoint::makeKey(again, sourcesAgain, 16, 8, rate, encoder, keyAgain));
+    EXPECT_EQ(key, keyAgain);
+
+    ASSERT_TRUE(ExportCheckpoint::makeKey(timeline, sources, 32, 8, rate, encoder, other));
+    EXPECT_NE(other, key);
+    EncoderSettings better = encoder;
+    better.crf = encoder.crf - 5;
+    ASSERT_TRUE(ExportCheckpoint::makeKey(timeline, sources, 16, 8, rate, better, other));
+    EXPECT_NE(other, key);
+    sourcesAgain[&topAgain] = "4";
+    ASSERT_TRUE(ExportCheckpoint::makeKey(again, sourcesAgain, 16, 8, rate, encoder, other));
+    EXPECT_NE(other, key);
+
+    TimelineEntry moved = timeline.getTrack(1)->getEntry(0);
+    moved.setStartTime(3.0);
+    timeline.getTrack(1)->removeEntry(0);
+    timeline.addEntryToTrack(1, moved);
+    ASSERT_TRUE(ExportCheckpoint::makeKey(timeline, sources, 16, 8, rate, encoder, other));
+    EXPECT_NE(other, key);
+
+    sources.erase(&top);
+    EXPECT_FALSE(ExportCheckpoint::makeKey(timeline, sources, 16, 8, rate, encoder, other));
+}
+
+#ifndef _WIN32
+/**
+ * Test: A source written again gives another key, even at the same size
+ * Purpose: Verify a resumed export never joins parts rendered from a
+ * source's old content, as with a re-rendered intermediate of a fixed size
+ */
+TEST(ExportCheckpointTest, KeyFollowsSourceFiles) {
+    SteppingVideo video(5.0, 1);
+    Timeline timeline;
+    timeline.addTrack("Video");
+    timeline.addEntryToTrack(0, TimelineEntry(&video, 0.0, 5.0));
+    const std::string path = ::testing::TempDir() + "checkpoint_source.y4m";
+    std::map<IAsset*, std::string> sources;
+    sources[&video] = path;
+
+    const Rational rate(30, 1);
+    EncoderSettings encoder;
+    std::string key;
+    std::string other;
+    writeSource(path, "first render", 1000000);
+    ASSERT_TRUE(ExportCheckpoint::makeKey(timeline, sources, 16, 8, rate, encoder, key));
+    ASSERT_TRUE(ExportCheckpoint::makeKey(timeline, sources, 16, 8, rate, encoder, other));
+    EXPECT_EQ(other, key);
+
+    writeSource(path, "later render", 1000060);
+    ASSERT_TRUE(ExportCheckpoint::makeKey(timeline, sources, 16, 8, rate, encoder, other));
+    EXPECT_NE(other, key);
+    EXPECT_NE(ExportCheckpoint::describeSource(path).find(" 12 "), std::string::npos)
+        << ExportCheckpoint::describeSource(path);
+
+    std::remove(path.c_str());
+    EXPECT_EQ(ExportCheckpoint::describeSource(path), path);
+}
+#endif
+
+/**
+ * Test: An export that stopped part way resumes from its checkpoint
+ * Purpose: Verify segments finished before the failure are not rendered
+ * again, are counted as progress, and the joined frames equal a serial
+ * export
+ */
+TEST(SegmentedExportTest, ResumesFromCheckpoint) {
+    SteppingVideo bottom(20.0, 1);
+    SteppingVideo top(20.0, 3);
+    Timeline timeline;
+    buildTimeline(timeline, &bottom, &top);
+    PlaneSink serial;
+    ExportPipeline pipeline;
+    ASSERT_TRUE(pipeline.run(timeline, 16, 8, Rational(30, 1), serial));
+
+    SteppingVideoFactory factory;
+    std::map<IAsset*, std::string> sources;
+    sources[&bottom] = "1";
+    sources[&top] = "3";
+    const std::vector<ExportSegment> plan = planSegments(300, 12, 5);
+    const std::string path = ::testing::TempDir() + "resume_test.manifest";
+    std::remove(path.c_str());
+
+    // One worker takes the segments in order, so 0 to 2 finish before 3 fails
+    JoiningTarget target;
+    target.failSegment = 3;
+    {
+        ExportCheckpoint checkpoint(path);
+        ASSERT_TRUE(checkpoint.begin("timeline", plan));
+        SegmentedExport segmented(1, 12);
+        segmented.setAssetSources(&factory, sources);
+        segmented.setCheckpoint(&checkpoint);
+        EXPECT_FALSE(segmented.run(timeline, 16, 8, Rational(30, 1), plan, target));
+        EXPECT_EQ(checkpoint.getDoneFrames(),
+                  plan[0].frameCount + plan[1].frameCount + plan[2].frameCount);
+    }
+
+    target.failSegment = -1;
+    ExportCheckpoint checkpoint(path);
+    ASSERT_TRUE(checkpoint.begin("timeline", plan));
+    ExportMonitor monitor;
+    monitor.start(300);
+    SegmentedExport segmented(2, 12);
+    segmented.setAssetSources(&factory, sources);
+    segmented.setCheckpoint(&checkpoint);
+    segmented.setMonitor(&monitor);
+    ASSERT_TRUE(segmented.run(timeline, 16, 8, Rational(30, 1), plan, target))
+        << segmented.getLastError();
+
+    const int64_t resumed = plan[0].frameCount + plan[1].frameCount + plan[2].frameCount;
+    EXPECT_EQ(segmented.getResumedFrames(), resumed);
+    EXPECT_EQ(segmented.getStats().encode.frames, 300 - resumed);
+    EXPECT_EQ(monitor.getProgress().framesDone, 300);
+    EXPECT_EQ(checkpoint.getDoneFrames(), 300);
+    ASSERT_EQ(target.framesByTime.size(), serial.planes.size());
+    for (size_t i = 0; i < serial.planes.size(); i++) {
+        ASSERT_EQ(target.framesByTime[static_cast<int64_t>(i)], serial.planes[i])
+            << "frame " << i;
+    }
+    checkpoint.finish();
+}
+
+// ==============================================================================
+// Segment Cache Tests
+// ==============================================================================
+
+/**
+ * Test: A segment's hash changes only with what its frames show
+ * Purpose: Verify a rebuilt timeline hashes the same, an edit changes only
+ * the segments it is drawn in (a transition reaching across a cut
+ * included), hidden tracks are ignored, nothing is printed, and unknown
+ * assets can't be hashed
+ */
+TEST(SegmentCacheTest, HashesChangeOnlyWhereTheEditIs) {
+    SteppingVideo bottom(20.0, 1);
+    SteppingVideo top(20.0, 3);
+    SteppingVideo caption(20.0, 5);
+    Timeline timeline;
+    buildTimeline(timeline, &bottom, &top);
+    std::map<IAsset*, std::string> sources;
+    sources[&bottom] = "1";
+    sources[&top] = "3";
+    sources[&caption] = "5";
+
+    // Two-second segments; the overlay is drawn from 2.5s to 7s
+    const Rational rate(30, 1);
+    const std::vector<ExportSegment> plan = planSegments(300, 12, 5);
+    EncoderSettings encoder;
+    std::vector<std::string> base;
+    ::testing::internal::CaptureStdout();
+    ASSERT_TRUE(SegmentCache::hashSegments(timeline, sources, plan, 16, 8, rate, encoder, base));
+    EXPECT_EQ(::testing::internal::GetCapturedStdout(), "");   // Streams may be on stdout
+    ASSERT_EQ(base.size(), plan.size());
+
+    SteppingVideo bottomAgain(20.0, 1);
+    SteppingVideo topAgain(20.0, 3);
+    Timeline again;
+    buildTimeline(again, &bottomAgain, &topAgain);
+    std::map<IAsset*, std::string> sourcesAgain;
+    sourcesAgain[&bottomAgain] = "1";
+    sourcesAgain[&topAgain] = "3";
+    std::vector<std::string> hashes;
+    ASSERT_TRUE(SegmentCache::hashSegments(again, sourcesAgain, plan, 16, 8, rate, encoder,
+                                           hashes));
+    EXPECT_EQ(hashes, base);
+
+    // Captions from 0.5s to 2s and 2s to 3s
+    const size_t captions = timeline.addTrack("Captions");
+    timeline.addEntryToTrack(captions, TimelineEntry(&caption, 0.5, 1.5));
+    timeline.addEntryToTrack(captions, TimelineEntry(&caption, 2.0, 1.0));
+    std::vector<std::string> captioned;
+    ASSERT_TRUE(SegmentCache::hashSegments(timeline, sources, plan, 16, 8, rate, encoder,
+                                           captioned));
+    EXPECT_NE(captioned[0], base[0]);
+    EXPECT_NE(captioned[1], base[1]);
+    for (size_t i = 2; i < plan.size(); i++) {
+        EXPECT_EQ(captioned[i], base[i]) << "segment " << i;
+    }
+
+    // Fading out of the first caption shows it in the second segment too
+    ASSERT_TRUE(timeline.getTrack(captions)->setTransition(0, Transition()));
+    ASSERT_TRUE(SegmentCache::hashSegments(timeline, sources, plan, 16, 8, rate, encoder,
+                                           hashes));
+    EXPECT_NE(hashes[0], captioned[0]);
+    EXPECT_NE(hashes[1], captioned[1]);
+    for (size_t i = 2; i < plan.size(); i++) {
+        EXPECT_EQ(hashes[i], base[i]) << "segment " << i;
+    }
+
+    timeline.getTrack(captions)->setVisible(false);
+    ASSERT_TRUE(SegmentCache::hashSegments(timeline, sources, plan, 16, 8, rate, encoder,
+                                           hashes));
+    EXPECT_EQ(hashes, base);
+
+    EncoderSettings better = encoder;
+    better.crf = encoder.crf - 5;
+    ASSERT_TRUE(SegmentCache::hashSegments(timeline, sources, plan, 16, 8, rate, better,
+                                           hashes));
+    EXPECT_NE(hashes[4], base[4]);
+
+    sources.erase(&top);
+    EXPECT_FALSE(SegmentCache::hashSegments(timeline, sources, plan, 16, 8, rate, encoder,
+                                            hashes));
+}
+
+#ifndef _WIN32
+/**
+ * Test: A source written again changes the hashes of the segments showing it
+ * Purpose: Verify a source replaced at the same size isn't reused from the
+ * last export, while segments that don't show it are
+ */
+TEST(SegmentCacheTest, HashesFollowSourceFiles) {
+    SteppingVideo bottom(20.0, 1);
+    SteppingVideo top(20.0, 3);
+    Timeline timeline;
+    buildTimeline(timeline, &bottom, &top);
+    const std::string path = ::testing::TempDir() + "segment_cache_source.y4m";
+    std::map<IAsset*, std::string> sources;
+    sources[&bottom] = "1";
+    sources[&top] = path;
+
+    const Rational rate(30, 1);
+    const std::vector<ExportSegment> plan = planSegments(300, 12, 5);
+    EncoderSettings encoder;
+    std::vector<std::string> base;
+    std::vector<std::string> hashes;
+    writeSource(path, "first render", 1000000);
+    ASSERT_TRUE(SegmentCache::hashSegments(timeline, sources, plan, 16, 8, rate, encoder, base));
+
+    // The overlay is drawn from 2.5s to 7s, in the second to fourth segments
+    writeSource(path, "later render", 1000060);
+    ASSERT_TRUE(SegmentCache::hashSegments(timeline, sources, plan, 16, 8, rate, encoder,
+                                           hashes));
+    EXPECT_EQ(hashes[0], base[0]);
+    EXPECT_NE(hashes[1], base[1]);
+    EXPECT_NE(hashes[2], base[2]);
+    EXPECT_NE(hashes[3], base[3]);
+    EXPECT_EQ(hashes[4], base[4]);
+    std::remove(path.c_str());
+}
+#endif
+
+/**
+ * Test: Unchanged segments are copied from the last export to the file
+ * Purpose: Verify reused segments become passthrough segments of the
+ * earlier video, which is moved aside while the new one is written, put
+ * back if the export fails and deleted once it succeeds, and that a
+ * replaced video is not reused
+ */
+TEST(SegmentCacheTest, ReusesUnchangedSegmentsOfTheLastExport) {
+    const std::string filename = ::testing::TempDir() + "cache_test.mp4";
+    const std::vector<ExportSegment> plan = planSegments(300, 12, 5);
+    std::vector<std::string> hashes = {"a", "b", "c", "d", "e"};
+    {
+        SegmentCache cache(filename);
+        std::remove(filename.c_str());
+        std::remove(cache.getIndexPath().c_str());
+        std::remove(cache.getPreviousPath().c_str());
+        EXPECT_FALSE(cache.load());
+
+        std::ofstream(filename, std::ios::binary) << "first export";
+        ASSERT_TRUE(cache.store(plan, hashes));
+    }
+
+    // The middle segment was edited
+    hashes[2] = "c2";
+    SegmentCache cache(filename);
+    ASSERT_TRUE(cache.load());
+    std::vector<ExportSegment> edited = plan;
+    EXPECT_EQ(cache.reuse(edited, hashes), 300 - plan[2].frameCount);
+    EXPECT_EQ(cache.getReusedFrames(), 300 - plan[2].frameCount);
+    EXPECT_FALSE(edited[2].isPassthrough());
+    ASSERT_TRUE(edited[3].isPassthrough());
+    EXPECT_EQ(edited[3].sourcePath, cache.getPreviousPath());
+    EXPECT_EQ(edited[3].sourceFirstFrame, plan[3].firstFrame);
+    EXPECT_EQ(edited[3].firstFrame, plan[3].firstFrame);
+
+    ASSERT_TRUE(cache.keepPrevious());
+    EXPECT_FALSE(std::ifstream(filename).good());
+    EXPECT_TRUE(std::ifstream(cache.getPreviousPath()).good());
+    cache.restore();
+    EXPECT_TRUE(std::ifstream(filename).good());
+    EXPECT_FALSE(std::ifstream(cache.getPreviousPath()).good());
+
+    ASSERT_TRUE(cache.keepPrevious());
+    std::ofstream(filename, std::ios::binary) << "second export";
+    ASSERT_TRUE(cache.store(edited, hashes));
+    EXPECT_FALSE(std::ifstream(cache.getPreviousPath()).good());
+
+    SegmentCache next(filename);
+    ASSERT_TRUE(next.load());
+    std::vector<ExportSegment> same = plan;
+    EXPECT_EQ(next.reuse(same, hashes), 300);
+
+    std::ofstream(filename, std::ios::binary) << "made by something else";
+    EXPECT_FALSE(next.load());
+    same = plan;
+    EXPECT_EQ(next.reuse(same, hashes), 0);
+
+    std::remove(filename.c_str());
+    std::remove(cache.getIndexPath().c_str());
+}
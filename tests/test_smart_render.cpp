@@ -0,0 +1,268 @@
+/**
+ * @file test_smart_render.cpp
+ * @brief Unit tests for smart-render export planning
+ *
+ * Tests which frames of a timeline are copied from their source video
+ * instead of being rendered, that copies are trimmed to whole GOPs of the
+ * source, and that a segmented export only renders the rest.
+ */
+
+#include <gtest/gtest.h>
+#include "export/SmartRender.h"
+#include "timeline/Timeline.h"
+#include "graphics/Color.h"
+#include "Image.h"
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Doubles
+// ==============================================================================
+
+/**
+ * @brief An asset showing one flat frame, a video or a still
+ */
+class FlatAsset : public IAsset {
+public:
+    explicit FlatAsset(bool video) : frame(16, 8), video(video) {
+        frame.fill(Color(40, 80, 120, 255));
+    }
+
+    double getDuration() const override { return 100.0; }
+    const Image& getFrame(double time = 0.0) override { return frame; }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return video; }
+    AssetType getAssetType() const override { return video ? AssetType::VIDEO : AssetType::IMAGE; }
+
+private:
+    Image frame;
+    bool video;
+};
+
+/**
+ * @brief Describes made-up H.264 files: 16x8 at 30 fps, a keyframe every 30 frames
+ */
+class FakeProbe : public IVideoProbe {
+public:
+    FakeProbe() : probes(0) {}
+
+    bool probe(const std::string& path, SourceVideoInfo& info) override {
+        probes++;
+        info.copyable = path != "prores.mov";
+        info.width = path == "big.mp4" ? 32 : 16;
+        info.height = path == "big.mp4" ? 16 : 8;
+        info.rate = path == "film.mp4" ? Rational(24, 1) : Rational(30, 1);
+        info.frameCount = 300;
+        for (int64_t frame = 0; frame < info.frameCount; frame += 30) {
+            info.keyframes.push_back(frame);
+        }
+        return true;
+    }
+
+    int probes;
+};
+
+/**
+ * @brief Target that counts what it is asked to render and join
+ */
+class CountingTarget : public ISegmentTarget {
+public:
+    CountingTarget() : sinksCreated(0) {}
+
+    class NullSink : public IFrameSink {
+    public:
+        bool open(int width, int height, const Rational& rate) override { return true; }
+        bool writeFrame(const YuvFrame& frame) override { return true; }
+        bool close() override { return true; }
+        std::string getLastError() const override { return ""; }
+    };
+
+    IFrameSink* createSegmentSink(const ExportSegment& segment) override {
+        EXPECT_FALSE(segment.isPassthrough());
+        sinksCreated++;
+        return new NullSink();
+    }
+    bool concatenate(const std::vector<ExportSegment>& segments, const Rational& rate) override {
+        joined = segments;
+        return true;
+    }
+    std::string getLastError() const override { return ""; }
+
+    int sinksCreated;
+    std::vector<ExportSegment> joined;
+};
+
+int64_t countPassthrough(const std::vector<ExportSegment>& plan) {
+    int64_t frames = 0;
+    for (const ExportSegment& segment : plan) {
+        frames += segment.isPassthrough() ? segment.frameCount : 0;
+    }
+    return frames;
+}
+
+/**
+ * @brief Check the plan covers every frame once, in order, with sequential indices
+ */
+void expectCovers(const std::vector<ExportSegment>& plan, int64_t frameCount) {
+    int64_t next = 0;
+    for (size_t i = 0; i < plan.size(); i++) {
+        EXPECT_EQ(plan[i].index, static_cast<int>(i));
+        EXPECT_EQ(plan[i].firstFrame, next) << "segment " << i;
+        EXPECT_GT(plan[i].frameCount, 0);
+        next = plan[i].firstFrame + plan[i].frameCount;
+    }
+    EXPECT_EQ(next, frameCount);
+}
+
+} // namespace
+
+// ==============================================================================
+// Planning Tests
+// ==============================================================================
+
+/**
+ * Test: Untouched spans are copied in whole GOPs, the rest is rendered
+ * Purpose: Verify cuts, a trimmed end and an overlay leave only the
+ * frames up to the next source keyframe to be rendered
+ */
+TEST(SmartRenderTest, CopiesWholeGopsBetweenCuts) {
+    FlatAsset first(true);
+    FlatAsset second(true);
+    FlatAsset title(false);
+    Timeline timeline;
+    timeline.addTrack("Video");
+    timeline.addTrack("Titles");
+    timeline.addEntryToTrack(0, TimelineEntry(&first, 0.0, 4.5));    // frames 0-134
+    timeline.addEntryToTrack(0, TimelineEntry(&second, 4.5, 4.5));   // frames 135-269
+    timeline.addEntryToTrack(1, TimelineEntry(&title, 6.0, 1.0));    // frames 180-209
+
+    std::map<IAsset*, std::string> sources;
+    sources[&first] = "first.mp4";
+    sources[&second] = "second.mp4";
+    FakeProbe probe;
+    std::vector<ExportSegment> plan =
+        planSmartRender(timeline, 16, 8, Rational(30, 1), sources, probe, 12, 1);
+
+    expectCovers(plan, 270);
+    EXPECT_EQ(probe.probes, 2);
+
+    std::vector<ExportSegment> copies;
+    for (const ExportSegment& segment : plan) {
+        if (segment.isPassthrough()) {
+            copies.push_back(segment);
+        }
+    }
+    ASSERT_EQ(copies.size(), 3u);
+    // first.mp4 up to its last keyframe before the cut
+    EXPECT_EQ(copies[0].sourcePath, "first.mp4");
+    EXPECT_EQ(copies[0].firstFrame, 0);
+    EXPECT_EQ(copies[0].frameCount, 120);
+    // second.mp4 from the cut to the last keyframe before the title
+    EXPECT_EQ(copies[1].sourcePath, "second.mp4");
+    EXPECT_EQ(copies[1].firstFrame, 135);
+    EXPECT_EQ(copies[1].sourceFirstFrame, 0);
+    EXPECT_EQ(copies[1].frameCount, 30);
+    // After the title, from second.mp4's next keyframe (its frame 90)
+    EXPECT_EQ(copies[2].firstFrame, 225);
+    EXPECT_EQ(copies[2].sourceFirstFrame, 90);
+    EXPECT_EQ(copies[2].frameCount, 30);
+
+    EXPECT_EQ(countPassthrough(plan), 180);
+}
+
+/**
+ * Test: Frames that change the video are rendered
+ * Purpose: Verify other sizes, rates and codecs, transparency, unaligned
+ * starts and unknown sources all keep the export from copying
+ */
+TEST(SmartRenderTest, RendersVideoThatIsChanged) {
+    const char* files[] = {"big.mp4", "film.mp4", "prores.mov"};
+    for (const char* file : files) {
+        FlatAsset video(true);
+        Timeline timeline;
+        timeline.addTrack("Video");
+        timeline.addEntryToTrack(0, TimelineEntry(&video, 0.0, 5.0));
+        std::map<IAsset*, std::string> sources;
+        sources[&video] = file;
+        FakeProbe probe;
+        std::vector<ExportSegment> plan =
+            planSmartRender(timeline, 16, 8, Rational(30, 1), sources, probe, 12, 4);
+        expectCovers(plan, 150);
+        EXPECT_EQ(countPassthrough(plan), 0) << file;
+    }
+
+    FlatAsset video(true);
+    std::map<IAsset*, std::string> sources;
+    sources[&video] = "clip.mp4";
+    FakeProbe probe;
+
+    Timeline faded;
+    faded.addTrack("Video");
+    TimelineEntry entry(&video, 0.0, 5.0);
+    EntryTransform transform;
+    transform.opacity = 0.5f;
+    entry.setTransform(transform);
+    faded.addEntryToTrack(0, entry);
+    EXPECT_EQ(countPassthrough(planSmartRender(faded, 16, 8, Rational(30, 1), sources, probe,
+                                               12, 4)), 0);
+
+    Timeline unaligned;
+    unaligned.addTrack("Video");
+    unaligned.addEntryToTrack(0, TimelineEntry(&video, 0.01, 5.0));
+    EXPECT_EQ(countPassthrough(planSmartRender(unaligned, 16, 8, Rational(30, 1), sources,
+                                               probe, 12, 4)), 0);
+
+    std::map<IAsset*, std::string> none;
+    Timeline plain;
+    plain.addTrack("Video");
+    plain.addEntryToTrack(0, TimelineEntry(&video, 0.0, 5.0));
+    EXPECT_EQ(countPassthrough(planSmartRender(plain, 16, 8, Rational(30, 1), none, probe, 12,
+                                               4)), 0);
+    EXPECT_EQ(countPassthrough(planSmartRender(plain, 16, 8, Rational(30, 1), sources, probe,
+                                               12, 4)), 150);
+}
+
+// ==============================================================================
+// Export Tests
+// ==============================================================================
+
+/**
+ * Test: A segmented export of a plan renders only what isn't copied
+ * Purpose: Verify passthrough segments get no sink, are passed on to be
+ * joined, and are counted apart from re-encoded frames
+ */
+TEST(SmartRenderTest, SegmentedExportSkipsCopiedFrames) {
+    FlatAsset video(true);
+    FlatAsset title(false);
+    Timeline timeline;
+    timeline.addTrack("Video");
+    timeline.addTrack("Titles");
+    timeline.addEntryToTrack(0, TimelineEntry(&video, 0.0, 10.0));
+    timeline.addEntryToTrack(1, TimelineEntry(&title, 4.0, 1.0));
+
+    std::map<IAsset*, std::string> sources;
+    sources[&video] = "clip.mp4";
+    FakeProbe probe;
+    std::vector<ExportSegment> plan =
+        planSmartRender(timeline, 16, 8, Rational(30, 1), sources, probe, 12, 2);
+    int64_t copied = countPassthrough(plan);
+    ASSERT_GT(copied, 0);
+
+    SegmentedExport segmented(2, 12);
+    CountingTarget target;
+    ASSERT_TRUE(segmented.run(timeline, 16, 8, Rational(30, 1), plan, target))
+        << segmented.getLastError();
+    EXPECT_EQ(target.joined.size(), plan.size());
+    int rendered = 0;
+    for (const ExportSegment& segment : plan) {
+        rendered += segment.isPassthrough() ? 0 : 1;
+    }
+    EXPECT_EQ(target.sinksCreated, rendered);
+    EXPECT_EQ(segmented.getPassthroughFrames(), copied);
+    EXPECT_EQ(segmented.getStats().encode.frames + copied, 300);
+}
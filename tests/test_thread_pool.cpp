@@ -0,0 +1,82 @@
+/**
+ * @file test_thread_pool.cpp
+ * @brief Unit tests for ThreadPool
+ *
+ * Tests that parallelFor runs every index exactly once and can be reused.
+ */
+
+#include <gtest/gtest.h>
+#include "util/ThreadPool.h"
+#include <atomic>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+void countIndex(void* context, int index) {
+    std::vector<std::atomic<int> >& hits =
+        *static_cast<std::vector<std::atomic<int> >*>(context);
+    hits[index]++;
+}
+
+} // namespace
+
+/**
+ * Test: Every index runs exactly once
+ * Purpose: Verify work is split without gaps or duplicates
+ */
+TEST(ThreadPoolTest, RunsEveryIndexOnce) {
+    ThreadPool pool(3);
+    std::vector<std::atomic<int> > hits(1000);
+    for (size_t i = 0; i < hits.size(); i++) {
+        hits[i] = 0;
+    }
+
+    pool.parallelFor(static_cast<int>(hits.size()), countIndex, &hits);
+
+    for (size_t i = 0; i < hits.size(); i++) {
+        EXPECT_EQ(hits[i].load(), 1) << "index " << i;
+    }
+}
+
+/**
+ * Test: The pool can be reused for many loops
+ * Purpose: Verify workers pick up every new loop
+ */
+TEST(ThreadPoolTest, ReusableAcrossCalls) {
+    ThreadPool pool(2);
+    std::vector<std::atomic<int> > hits(17);
+    for (size_t i = 0; i < hits.size(); i++) {
+        hits[i] = 0;
+    }
+
+    for (int round = 0; round < 200; round++) {
+        pool.parallelFor(static_cast<int>(hits.size()), countIndex, &hits);
+    }
+
+    for (size_t i = 0; i < hits.size(); i++) {
+        EXPECT_EQ(hits[i].load(), 200);
+    }
+}
+
+/**
+ * Test: Empty loops and pools without workers
+ * Purpose: Verify edge cases run inline and return
+ */
+TEST(ThreadPoolTest, EmptyLoopAndNoWorkers) {
+    ThreadPool pool(0);
+    EXPECT_EQ(pool.getThreadCount(), 0);
+
+    std::vector<std::atomic<int> > hits(5);
+    for (size_t i = 0; i < hits.size(); i++) {
+        hits[i] = 0;
+    }
+    pool.parallelFor(0, countIndex, &hits);
+    pool.parallelFor(5, countIndex, &hits);
+
+    for (size_t i = 0; i < hits.size(); i++) {
+        EXPECT_EQ(hits[i].load(), 1);
+    }
+    EXPECT_GE(ThreadPool::shared().getThreadCount(), 1);
+}
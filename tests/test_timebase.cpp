@@ -0,0 +1,121 @@
+/**
+ * @file test_timebase.cpp
+ * @brief Unit tests for the integer timeline timebase
+ *
+ * Tests conversions between ticks, seconds, stream timestamps and frame
+ * numbers, including NTSC rates and values large enough to overflow a
+ * naive multiplication.
+ */
+
+#include <gtest/gtest.h>
+#include "timeline/Timebase.h"
+#include <cstdint>
+
+using namespace csci3081;
+
+// ==============================================================================
+// Conversion Tests
+// ==============================================================================
+
+/**
+ * Test: Ticks survive a trip through seconds
+ * Purpose: Verify double APIs at the edges never move a timeline position
+ */
+TEST(TimebaseTest, SecondsRoundTripExactly) {
+    const Ticks samples[] = {0, 1, 7, TICKS_PER_SECOND / 3, TICKS_PER_SECOND - 1,
+                             TICKS_PER_SECOND * 3600 * 24 + 12345,
+                             TICKS_PER_SECOND * 3600LL * 24 * 140 + 1};
+    for (Ticks ticks : samples) {
+        EXPECT_EQ(secondsToTicks(ticksToSeconds(ticks)), ticks);
+        EXPECT_EQ(secondsToTicks(ticksToSeconds(-ticks)), -ticks);
+    }
+    EXPECT_EQ(secondsToTicks(1.5), TICKS_PER_SECOND * 3 / 2);
+}
+
+/**
+ * Test: Common frame rates have whole-tick frames
+ * Purpose: Verify the tick rate is a multiple of every common rate, NTSC
+ * included, so frame boundaries are exact
+ */
+TEST(TimebaseTest, CommonRatesAreExact) {
+    const Rational rates[] = {Rational(24, 1), Rational(25, 1), Rational(30, 1),
+                              Rational(50, 1), Rational(60, 1), Rational(120, 1),
+                              Rational(24000, 1001), Rational(30000, 1001),
+                              Rational(60000, 1001), Rational(48000, 1),
+                              Rational(44100, 1)};
+    for (const Rational& rate : rates) {
+        EXPECT_EQ((TICKS_PER_SECOND * rate.den) % rate.num, 0) << rate.num << "/" << rate.den;
+        Ticks length = frameToTicks(1, rate);
+        EXPECT_EQ(frameToTicks(1000003, rate), length * 1000003);
+    }
+    EXPECT_EQ(frameToTicks(30000, Rational(30000, 1001)), TICKS_PER_SECOND * 1001);
+}
+
+/**
+ * Test: Frame numbers and frame start times invert each other
+ * Purpose: Verify the frame shown at a frame's start is that frame, and
+ * the tick before belongs to the previous one, at exact and inexact rates
+ */
+TEST(TimebaseTest, FramesRoundTrip) {
+    const Rational rates[] = {Rational(30, 1), Rational(30000, 1001), Rational(7, 3),
+                              Rational(1000000007, 1000)};
+    for (const Rational& rate : rates) {
+        for (int64_t frame = 0; frame < 5000; frame += 7) {
+            Ticks start = frameToTicks(frame, rate);
+            EXPECT_EQ(ticksToFrame(start, rate), frame);
+            if (frame > 0) {
+                EXPECT_EQ(ticksToFrame(start - 1, rate), frame - 1);
+            }
+        }
+    }
+    EXPECT_EQ(ticksToFrame(-1, Rational(30, 1)), -1);
+}
+
+/**
+ * Test: Stream timestamps convert both ways
+ * Purpose: Verify the MPEG-TS and millisecond time bases map exactly
+ */
+TEST(TimebaseTest, TimestampsConvertExactly) {
+    Rational mpeg(1, 90000);
+    EXPECT_EQ(timestampToTicks(90000, mpeg), TICKS_PER_SECOND);
+    EXPECT_EQ(timestampToTicks(3003, mpeg), frameToTicks(1, Rational(30000, 1001)));
+    EXPECT_EQ(ticksToTimestamp(frameToTicks(1, Rational(30000, 1001)), mpeg), 3003);
+
+    Rational millis(1, 1000);
+    for (int64_t ms = 0; ms < 100000; ms += 37) {
+        EXPECT_EQ(ticksToTimestamp(timestampToTicks(ms, millis), millis), ms);
+    }
+
+    // A tick between two timestamps rounds as asked
+    Ticks between = timestampToTicks(10, millis) + 1;
+    EXPECT_EQ(ticksToTimestamp(between, millis, Rounding::DOWN), 10);
+    EXPECT_EQ(ticksToTimestamp(between, millis, Rounding::UP), 11);
+    EXPECT_EQ(ticksToTimestamp(between, millis), 10);
+}
+
+/**
+ * Test: Rescaling large values does not overflow
+ * Purpose: Verify value * mul beyond 64 bits still gives the exact result
+ */
+TEST(TimebaseTest, RescaleHandlesLargeProducts) {
+    int64_t big = INT64_C(4000000000000000000);
+    EXPECT_EQ(rescale(big, 1000, 1000), big);
+    EXPECT_EQ(rescale(big, 3, 4), INT64_C(3000000000000000000));
+    EXPECT_EQ(rescale(-7, 1, 2, Rounding::DOWN), -4);
+    EXPECT_EQ(rescale(-7, 1, 2, Rounding::UP), -3);
+    EXPECT_EQ(rescale(-7, 1, 2), -4);
+    EXPECT_EQ(rescale(7, 1, 2), 4);
+}
+
+/**
+ * Test: Frame rates typed as decimals become exact fractions
+ * Purpose: Verify NTSC rates are recognized from their rounded forms
+ */
+TEST(TimebaseTest, RateFromDouble) {
+    EXPECT_EQ(rateFromDouble(30.0), Rational(30, 1));
+    EXPECT_EQ(rateFromDouble(29.97), Rational(30000, 1001));
+    EXPECT_EQ(rateFromDouble(30000.0 / 1001.0), Rational(30000, 1001));
+    EXPECT_EQ(rateFromDouble(23.976), Rational(24000, 1001));
+    EXPECT_EQ(rateFromDouble(59.94), Rational(60000, 1001));
+    EXPECT_EQ(rateFromDouble(12.5), Rational(25, 2));
+}
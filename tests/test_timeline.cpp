@@ -0,0 +1,622 @@
+/**
+ * @file test_timeline.cpp
+ * @brief Unit tests for Timeline rendering
+ *
+ * Tests the CPU compositing path of the Timeline:
+ * - Background fill with a configurable color
+ * - Rendering into a caller-provided buffer (renderFrameInto)
+ * - Steady-state rendering performs no heap allocations
+ */
+
+#include <gtest/gtest.h>
+#include "compositor/Blend.h"
+#include "timeline/Timeline.h"
+#include "Image.h"
+#include "graphics/Color.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace csci3081;
+
+// ==============================================================================
+// Allocation Counting
+// ==============================================================================
+
+// Replacing the global allocation functions lets a test count every heap
+// allocation made while the counter is enabled.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<bool> countAllocations(false);
+static std::atomic<size_t> allocationCount(0);
+
+void* operator new(std::size_t size) {
+    if (countAllocations) {
+        allocationCount++;
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+// ==============================================================================
+// Test Asset
+// ==============================================================================
+
+/**
+ * @brief Asset that always returns the same solid-color frame
+ *
+ * Like the real assets, the frame is premultiplied.
+ */
+class SolidAsset : public IAsset {
+public:
+    SolidAsset(int width, int height, const Color& color) : frame(width, height) {
+        frame.fill(premultiplyColor(color));
+    }
+
+    double getDuration() const override { return 5.0; }
+    const Image& getFrame(double time = 0.0) override { return frame; }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return false; }
+    AssetType getAssetType() const override { return AssetType::IMAGE; }
+
+private:
+    Image frame;
+};
+
+// ==============================================================================
+// Test Fixture
+// ==============================================================================
+
+class TimelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        opaqueRed = new SolidAsset(8, 8, Color(255, 0, 0, 255));
+        transparent = new SolidAsset(8, 8, Color(0, 255, 0, 0));
+    }
+
+    void TearDown() override {
+        delete opaqueRed;
+        delete transparent;
+    }
+
+    SolidAsset* opaqueRed;
+    SolidAsset* transparent;
+};
+
+// ==============================================================================
+// Image Fill Tests
+// ==============================================================================
+
+/**
+ * Test: Image::fill writes the color to every pixel
+ * Purpose: Verify the pattern fill covers the whole buffer (odd sizes too)
+ */
+TEST_F(TimelineTest, ImageFillSetsEveryPixel) {
+    Image img(7, 5);
+    img.fill(Color(10, 20, 30, 40));
+
+    for (int y = 0; y < img.getHeight(); y++) {
+        for (int x = 0; x < img.getWidth(); x++) {
+            Color c = img.getPixel(x, y);
+            EXPECT_EQ(c.red(), 10);
+            EXPECT_EQ(c.green(), 20);
+            EXPECT_EQ(c.blue(), 30);
+            EXPECT_EQ(c.alpha(), 40);
+        }
+    }
+}
+
+/**
+ * Test: Image::fill handles uniform byte patterns
+ * Purpose: Verify the memset shortcut produces the same result
+ */
+TEST_F(TimelineTest, ImageFillUniformBytes) {
+    Image img(3, 3);
+    img.fill(Color(255, 255, 255, 255));
+
+    Color c = img.getPixel(2, 2);
+    EXPECT_EQ(c.red(), 255);
+    EXPECT_EQ(c.alpha(), 255);
+}
+
+// ==============================================================================
+// Rendering Tests
+// ==============================================================================
+
+/**
+ * Test: Empty timeline renders the default background
+ * Purpose: Verify the default dark gray background is preserved
+ */
+TEST_F(TimelineTest, EmptyTimelineRendersDefaultBackground) {
+    Timeline timeline;
+    Image frame(4, 4);
+    timeline.renderFrameInto(0.0, frame);
+
+    Color c = frame.getPixel(1, 1);
+    EXPECT_EQ(c.red(), 32);
+    EXPECT_EQ(c.green(), 32);
+    EXPECT_EQ(c.blue(), 32);
+    EXPECT_EQ(c.alpha(), 255);
+}
+
+/**
+ * Test: Background color is configurable
+ * Purpose: Verify setBackgroundColor is used for the fill
+ */
+TEST_F(TimelineTest, BackgroundColorIsConfigurable) {
+    Timeline timeline;
+    timeline.setBackgroundColor(Color(0, 0, 128, 255));
+
+    Image frame(4, 4);
+    timeline.renderFrameInto(0.0, frame);
+
+    Color c = frame.getPixel(3, 3);
+    EXPECT_EQ(c.red(), 0);
+    EXPECT_EQ(c.blue(), 128);
+}
+
+/**
+ * Test: Transparent layers show the background
+ * Purpose: Verify compositing over the configured background
+ */
+TEST_F(TimelineTest, TransparentLayerShowsBackground) {
+    Timeline timeline;
+    timeline.setBackgroundColor(Color(0, 0, 200, 255));
+    timeline.addTrack();
+    timeline.addEntryToTrack(0, TimelineEntry(transparent, 0.0, 5.0));
+
+    Image frame(4, 4);
+    timeline.renderFrameInto(1.0, frame);
+
+    Color c = frame.getPixel(0, 0);
+    EXPECT_EQ(c.green(), 0);
+    EXPECT_EQ(c.blue(), 200);
+}
+
+/**
+ * Test: renderFrameInto matches renderFrameAt
+ * Purpose: Verify both APIs produce the same composite
+ */
+TEST_F(TimelineTest, RenderIntoMatchesRenderAt) {
+    Timeline timeline;
+    timeline.addTrack();
+    timeline.addEntryToTrack(0, TimelineEntry(opaqueRed, 0.0, 5.0));
+
+    Image* allocated = timeline.renderFrameAt(1.0, 6, 6);
+    Image reused(6, 6);
+    timeline.renderFrameInto(1.0, reused);
+
+    for (int y = 0; y < 6; y++) {
+        for (int x = 0; x < 6; x++) {
+            EXPECT_EQ(allocated->getPixel(x, y).red(), reused.getPixel(x, y).red());
+            EXPECT_EQ(allocated->getPixel(x, y).blue(), reused.getPixel(x, y).blue());
+        }
+    }
+    EXPECT_EQ(reused.getPixel(3, 3).red(), 255);
+
+    delete allocated;
+}
+
+/**
+ * Test: Steady-state rendering does not allocate
+ * Purpose: Playback and export reuse one buffer, so rendering a frame into it
+ * must not touch the heap
+ */
+TEST_F(TimelineTest, RenderFrameIntoDoesNotAllocate) {
+    Timeline timeline;
+    timeline.addTrack();
+    timeline.addTrack();
+    timeline.addEntryToTrack(0, TimelineEntry(opaqueRed, 0.0, 5.0));
+    timeline.addEntryToTrack(1, TimelineEntry(transparent, 0.0, 5.0));
+
+    Image frame(32, 18);
+    timeline.renderFrameInto(0.0, frame); // warm up
+
+    allocationCount = 0;
+    countAllocations = true;
+    for (int i = 0; i < 30; i++) {
+        timeline.renderFrameInto(i / 30.0, frame);
+    }
+    countAllocations = false;
+
+    EXPECT_EQ(allocationCount.load(), 0u);
+}
+
+// ==============================================================================
+// Entry Lookup Tests
+// ==============================================================================
+
+/**
+ * Test: Lookups find entries at their edges and nothing in gaps
+ * Purpose: Verify the binary search honors [start, end) like isActiveAt()
+ */
+TEST_F(TimelineTest, EntryLookupRespectsBoundaries) {
+    Track track;
+    track.addEntry(TimelineEntry(opaqueRed, 2.0, 1.0));
+    track.addEntry(TimelineEntry(opaqueRed, 0.0, 1.0));
+    track.addEntry(TimelineEntry(opaqueRed, 3.0, 2.0));
+
+    EXPECT_EQ(track.getEntryIndexAt(-0.5), Track::npos);
+    EXPECT_EQ(track.getEntryIndexAt(0.0), 0u);
+    EXPECT_EQ(track.getEntryIndexAt(0.999), 0u);
+    EXPECT_EQ(track.getEntryIndexAt(1.0), Track::npos);
+    EXPECT_EQ(track.getEntryIndexAt(1.5), Track::npos);
+    EXPECT_EQ(track.getEntryIndexAt(2.0), 1u);
+    EXPECT_EQ(track.getEntryIndexAt(3.0), 2u);
+    EXPECT_EQ(track.getEntryIndexAt(4.999), 2u);
+    EXPECT_EQ(track.getEntryIndexAt(5.0), Track::npos);
+    EXPECT_EQ(track.getEntryAt(3.5), &track.getEntries()[2]);
+    EXPECT_EQ(track.getEntryAt(7.0), nullptr);
+}
+
+/**
+ * Test: Sequential, backward and random lookups agree with a linear scan
+ * Purpose: Verify the playback cursor never returns a stale entry, including
+ * after entries are moved, trimmed and removed
+ */
+TEST_F(TimelineTest, EntryLookupMatchesScanAfterEdits) {
+    Track track;
+    for (int i = 0; i < 50; i++) {
+        track.addEntry(TimelineEntry(opaqueRed, i * 1.5, 1.0));
+    }
+
+    auto scan = [&track](double time) -> const TimelineEntry* {
+        for (const TimelineEntry& entry : track.getEntries()) {
+            if (entry.isActiveAt(time)) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    };
+    auto checkAll = [&track, &scan]() {
+        for (double t = -1.0; t < 80.0; t += 0.05) {
+            ASSERT_EQ(track.getEntryAt(t), scan(t)) << "forward t = " << t;
+        }
+        for (double t = 80.0; t > -1.0; t -= 0.35) {
+            ASSERT_EQ(track.getEntryAt(t), scan(t)) << "backward t = " << t;
+        }
+        std::srand(5);
+        for (int i = 0; i < 500; i++) {
+            double t = (std::rand() % 8000) / 100.0;
+            ASSERT_EQ(track.getEntryAt(t), scan(t)) << "random t = " << t;
+        }
+    };
+
+    checkAll();
+    track.getEntryAt(30.2);
+    ASSERT_TRUE(track.updateEntryStartTime(20, 76.0));   // Moves to the end
+    ASSERT_TRUE(track.updateEntryStartTime(3, 30.0));    // Into 20's old slot
+    EXPECT_FALSE(track.updateEntryStartTime(0, 1.0));    // Overlaps entry 1
+    ASSERT_TRUE(track.updateEntryDuration(5, 1.4));
+    EXPECT_FALSE(track.updateEntryDuration(5, 1.6));
+    ASSERT_TRUE(track.removeEntry(10));
+    checkAll();
+
+    for (size_t i = 1; i < track.getEntryCount(); i++) {
+        EXPECT_LE(track.getEntries()[i - 1].getEndTime(),
+                  track.getEntries()[i].getStartTime());
+    }
+}
+
+/**
+ * Test: Ripple edits move every later entry and nothing before
+ * Purpose: Verify ripple insert, delete and trim, and that shiftEntries()
+ * refuses to move entries into the one before them
+ */
+TEST_F(TimelineTest, RippleEditsMoveLaterEntries) {
+    Track track;
+    for (int i = 0; i < 5; i++) {
+        track.addEntry(TimelineEntry(opaqueRed, i * 2.0, 1.0));   // 0, 2, 4, 6, 8
+    }
+    auto starts = [&track]() {
+        std::vector<double> result;
+        for (const TimelineEntry& entry : track.getEntries()) {
+            result.push_back(entry.getStartTime());
+        }
+        return result;
+    };
+
+    // Insert at 4: the entries from 4 on make room for it
+    ASSERT_TRUE(track.addEntry(TimelineEntry(opaqueRed, 4.0, 0.5), true));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 2.0, 4.0, 4.5, 6.5, 8.5}));
+    EXPECT_FALSE(track.addEntry(TimelineEntry(opaqueRed, 2.5, 1.0), true));
+
+    ASSERT_TRUE(track.updateEntryDuration(0, 1.5, true));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 2.5, 4.5, 5.0, 7.0, 9.0}));
+
+    ASSERT_TRUE(track.removeEntry(2, true));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 2.5, 4.5, 6.5, 8.5}));
+
+    EXPECT_FALSE(track.shiftEntries(1, -1.5));   // Into entry 0
+    EXPECT_FALSE(track.shiftEntries(0, -0.5));   // Before 0
+    EXPECT_FALSE(track.shiftEntries(5, 1.0));
+    ASSERT_TRUE(track.shiftEntries(1, -1.0));
+    EXPECT_EQ(starts(), (std::vector<double>{0.0, 1.5, 3.5, 5.5, 7.5}));
+    EXPECT_EQ(track.getEntryIndexAt(7.9), 4u);
+    EXPECT_DOUBLE_EQ(track.getTotalDuration(), 8.5);
+}
+
+/**
+ * Test: Random edits leave the same entries as a sorted vector
+ * Purpose: Verify the entry tree keeps order, indices and lazily shifted
+ * start times right through thousands of mixed edits
+ */
+TEST_F(TimelineTest, RandomEditsMatchSortedVector) {
+    Track track;
+    std::vector<std::pair<Ticks, Ticks> > expected;   // Start, duration
+    const Ticks second = TICKS_PER_SECOND;
+
+    auto fits = [&expected](Ticks start, Ticks end, size_t ignore) {
+        for (size_t i = 0; i < expected.size(); i++) {
+            Ticks otherEnd = expected[i].first + expected[i].second;
+            if (i != ignore && start < otherEnd && expected[i].first < end) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::srand(11);
+    for (int step = 0; step < 4000; step++) {
+        int op = std::rand() % 4;
+        size_t index = expected.empty() ? 0 : std::rand() % expected.size();
+        Ticks start = (std::rand() % 2000) * second / 4;
+        Ticks length = (1 + std::rand() % 8) * second / 4;
+        if (op == 0 || expected.size() < 10) {
+            bool added = track.addEntry(
+                TimelineEntry(opaqueRed, ticksToSeconds(start), ticksToSeconds(length)));
+            ASSERT_EQ(added, fits(start, start + length, Track::npos));
+            if (added) {
+                expected.push_back(std::make_pair(start, length));
+            }
+        } else if (op == 1) {
+            Ticks end = start + expected[index].second;
+            bool moved = track.updateEntryStartTime(index, ticksToSeconds(start));
+            ASSERT_EQ(moved, fits(start, end, index));
+            if (moved) {
+                expected[index].first = start;
+            }
+        } else if (op == 2) {
+            Ticks offset = (std::rand() % 9 - 4) * second / 4;
+            Ticks first = expected[index].first + offset;
+            Ticks previousEnd = index > 0 ?
+                expected[index - 1].first + expected[index - 1].second : 0;
+            bool shifted = track.shiftEntries(index, ticksToSeconds(offset));
+            ASSERT_EQ(shifted, first >= previousEnd);
+            for (size_t i = index; shifted && i < expected.size(); i++) {
+                expected[i].first += offset;
+            }
+        } else {
+            bool ripple = std::rand() % 2 == 0;
+            Ticks removed = expected[index].second;
+            ASSERT_TRUE(track.removeEntry(index, ripple));
+            expected.erase(expected.begin() + index);
+            for (size_t i = index; ripple && i < expected.size(); i++) {
+                expected[i].first -= removed;
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        if (step % 100 == 0) {
+            ASSERT_EQ(track.getEntryCount(), expected.size());
+            size_t i = 0;
+            for (const TimelineEntry& entry : track.getEntries()) {
+                ASSERT_EQ(entry.getStartTicks(), expected[i].first) << "step " << step;
+                ASSERT_EQ(entry.getDurationTicks(), expected[i].second);
+                ASSERT_EQ(&track.getEntry(i), &entry);
+                i++;
+            }
+        }
+    }
+}
+
+/**
+ * Test: Total duration follows edits made through the track
+ * Purpose: Verify the cached Timeline duration is invalidated by every
+ * kind of edit, not only by adding entries through the Timeline
+ */
+TEST_F(TimelineTest, TotalDurationCacheFollowsEdits) {
+    Timeline timeline;
+    EXPECT_DOUBLE_EQ(timeline.getTotalDuration(), 0.0);
+
+    timeline.addTrack();
+    timeline.addTrack();
+    timeline.addEntryToTrack(0, TimelineEntry(opaqueRed, 0.0, 4.0));
+    timeline.addEntryToTrack(1, TimelineEntry(opaqueRed, 1.0, 2.0));
+    EXPECT_DOUBLE_EQ(timeline.getTotalDuration(), 4.0);
+
+    timeline.getTrack(1)->updateEntryStartTime(0, 5.0);
+    EXPECT_DOUBLE_EQ(timeline.getTotalDuration(), 7.0);
+
+    timeline.getTrack(1)->updateEntryDuration(0, 3.0);
+    EXPECT_DOUBLE_EQ(timeline.getTotalDuration(), 8.0);
+
+    timeline.getTrack(1)->removeEntry(0);
+    EXPECT_DOUBLE_EQ(timeline.getTotalDuration(), 4.0);
+
+    timeline.removeTrack(0);
+    EXPECT_DOUBLE_EQ(timeline.getTotalDuration(), 0.0);
+}
+
+/**
+ * Test: Frames on a cut show the entry after it
+ * Purpose: Verify thirds of a second, which are inexact in binary, still
+ * line up with 30000/1001 and 30 fps frame times when compared in ticks
+ */
+TEST_F(TimelineTest, CutsLineUpWithFrameTimes) {
+    Track track;
+    for (int i = 0; i < 90; i++) {
+        track.addEntry(TimelineEntry(opaqueRed, i / 3.0, 1.0 / 3.0));
+    }
+    EXPECT_EQ(track.getEntryCount(), 90u);
+    for (size_t i = 1; i < track.getEntryCount(); i++) {
+        EXPECT_EQ(track.getEntries()[i - 1].getEndTicks(),
+                  track.getEntries()[i].getStartTicks());
+    }
+
+    // Every 10th frame at 30 fps lands on a cut; at NTSC rates frames
+    // land close to cuts without being on them
+    const Rational rates[] = {Rational(30, 1), Rational(30000, 1001)};
+    for (const Rational& rate : rates) {
+        for (int64_t frame = 0; ticksToSeconds(frameToTicks(frame, rate)) < 30.0; frame++) {
+            Ticks time = frameToTicks(frame, rate);
+            size_t expected = static_cast<size_t>(time * 3 / TICKS_PER_SECOND);
+            ASSERT_EQ(track.getEntryIndexAt(ticksToSeconds(time)), expected)
+                << "frame " << frame << " at " << rate.num << "/" << rate.den;
+        }
+    }
+}
+
+// ==============================================================================
+// Snapshot Tests
+// ==============================================================================
+
+namespace {
+
+std::vector<double> startTimes(const Track& track) {
+    std::vector<double> result;
+    for (const TimelineEntry& entry : track.getEntries()) {
+        result.push_back(entry.getStartTime());
+    }
+    return result;
+}
+
+} // namespace
+
+/**
+ * Test: Copies of a track share entries until one of them is edited
+ * Purpose: Verify edits on either side, and ripple offsets still pending
+ * when the copy was made, don't leak into the other track
+ */
+TEST_F(TimelineTest, TrackCopiesEditIndependently) {
+    Track original;
+    for (int i = 0; i < 6; i++) {
+        original.addEntry(TimelineEntry(opaqueRed, i * 2.0, 1.0));   // 0, 2, ... 10
+    }
+    ASSERT_TRUE(original.shiftEntries(2, 0.5));
+
+    Track copy(original);
+    ASSERT_TRUE(original.shiftEntries(4, 1.0));
+    ASSERT_TRUE(copy.removeEntry(0, true));
+    Track copyOfCopy(copy);
+    ASSERT_TRUE(copyOfCopy.updateEntryStartTime(0, 20.0));
+
+    EXPECT_EQ(startTimes(original), (std::vector<double>{0.0, 2.0, 4.5, 6.5, 9.5, 11.5}));
+    EXPECT_EQ(startTimes(copy), (std::vector<double>{1.0, 3.5, 5.5, 7.5, 9.5}));
+    EXPECT_EQ(startTimes(copyOfCopy), (std::vector<double>{3.5, 5.5, 7.5, 9.5, 20.0}));
+    EXPECT_EQ(copy.getEntryIndexAt(3.6), 1u);
+    EXPECT_EQ(original.getEntryIndexAt(3.6), Track::npos);
+}
+
+/**
+ * Test: A snapshot keeps the timeline as it was when it was taken
+ * Purpose: Verify entry, track and visibility edits made afterwards don't
+ * change what the snapshot contains or renders
+ */
+TEST_F(TimelineTest, SnapshotIgnoresLaterEdits) {
+    SolidAsset blue(8, 8, Color(0, 0, 255, 255));
+    Timeline timeline;
+    timeline.addTrack();
+    timeline.addTrack();
+    for (int i = 0; i < 20; i++) {
+        timeline.addEntryToTrack(0, TimelineEntry(opaqueRed, i * 1.0, 0.5));
+    }
+    timeline.addEntryToTrack(1, TimelineEntry(&blue, 2.0, 1.0));
+
+    std::shared_ptr<const Timeline> snapshot = timeline.snapshot();
+    std::vector<double> before = startTimes(*timeline.getTrack(0));
+    Ticks duration = timeline.getTotalTicks();
+
+    Track* track = timeline.getTrack(0);
+    ASSERT_TRUE(track->shiftEntries(0, 3.0));
+    ASSERT_TRUE(track->removeEntry(3, true));
+    ASSERT_TRUE(track->updateEntryDuration(0, 0.75));
+    timeline.getTrack(1)->setVisible(false);
+    timeline.addTrack();
+    timeline.addEntryToTrack(2, TimelineEntry(opaqueRed, 0.0, 40.0));
+
+    ASSERT_EQ(snapshot->getTrackCount(), 2u);
+    EXPECT_EQ(startTimes(*snapshot->getTrack(0)), before);
+    EXPECT_DOUBLE_EQ(snapshot->getTrack(0)->getEntry(0).getDuration(), 0.5);
+    EXPECT_EQ(snapshot->getTotalTicks(), duration);
+
+    Image frame(4, 4);
+    snapshot->renderFrameInto(2.25, frame);
+    Color c = frame.getPixel(1, 1);
+    EXPECT_EQ(c.red(), 0);
+    EXPECT_EQ(c.blue(), 255);
+    timeline.renderFrameInto(2.25, frame);
+    EXPECT_EQ(frame.getPixel(1, 1).red(), 255);
+}
+
+/**
+ * Test: A snapshot renders on another thread while the timeline is edited
+ * Purpose: Verify the two share no mutable state (run under
+ * -fsanitize=thread to check for races, not only wrong frames)
+ */
+TEST_F(TimelineTest, SnapshotRendersWhileEditing) {
+    SolidAsset blue(8, 8, Color(0, 0, 255, 255));
+    Timeline timeline;
+    timeline.addTrack();
+    timeline.addTrack();
+    for (int i = 0; i < 200; i++) {
+        TimelineEntry entry(i % 2 ? &blue : opaqueRed, 1.0 + i * 0.1, 0.1);
+        KeyframeTrack fade;
+        fade.setKeyframe(Keyframe(0.0, 1.0f));
+        fade.setKeyframe(Keyframe(0.1, 0.0f));
+        entry.setKeyframes(EntryProperty::OPACITY, fade);
+        timeline.addEntryToTrack(i % 2, entry);
+    }
+
+    std::shared_ptr<const Timeline> snapshot = timeline.snapshot();
+    const int frames = 60;
+    std::vector<std::vector<unsigned char> > expected(frames);
+    Image frame(8, 8);
+    for (int f = 0; f < frames; f++) {
+        snapshot->renderFrameInto(1.0 + f / 3.0, frame);
+        expected[f].assign(frame.getData(), frame.getData() + 8 * 8 * 4);
+    }
+
+    std::atomic<int> mismatches(0);
+    std::thread exporter([&snapshot, &expected, &mismatches]() {
+        Image out(8, 8);
+        for (int pass = 0; pass < 5; pass++) {
+            for (int f = 0; f < frames; f++) {
+                snapshot->renderFrameInto(1.0 + f / 3.0, out);
+                if (std::memcmp(out.getData(), expected[f].data(), expected[f].size()) != 0) {
+                    mismatches++;
+                }
+            }
+        }
+    });
+
+    Image live(8, 8);
+    Track* track = timeline.getTrack(0);
+    for (int i = 0; i < 2000; i++) {
+        track->shiftEntries(i % 50, i % 2 ? -0.05 : 0.05);
+        track->updateEntryStartTime(i % 100, 30.0 + i % 7);
+        if (i % 100 == 0) {
+            track->addEntry(TimelineEntry(opaqueRed, 0.0, 0.5));
+            track->removeEntry(0, true);
+            timeline.renderFrameInto(i / 100.0, live);
+        }
+    }
+    exporter.join();
+
+    EXPECT_EQ(mismatches.load(), 0);
+}
@@ -0,0 +1,353 @@
+/**
+ * @file test_transitions.cpp
+ * @brief Unit tests for transitions between adjacent entries
+ *
+ * Tests the transition kernels, attaching transitions to tracks, rendering
+ * them through the Timeline, and concurrent decoding / prefetching of the
+ * video sources involved.
+ */
+
+#include <gtest/gtest.h>
+#include "compositor/TransitionBlend.h"
+#include "timeline/Timeline.h"
+#include "timeline/Transition.h"
+#include "Image.h"
+#include "graphics/Color.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+using namespace csci3081;
+
+namespace {
+
+// ==============================================================================
+// Test Assets
+// ==============================================================================
+
+/**
+ * @brief Solid-color asset that reports itself as a video and records the
+ * times it was asked for
+ */
+class RecordingVideoAsset : public IAsset {
+public:
+    RecordingVideoAsset(const Color& color) : frame(8, 8) { frame.fill(color); }
+
+    double getDuration() const override { return 10.0; }
+    const Image& getFrame(double time = 0.0) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(time);
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+    std::vector<double> requests;
+
+private:
+    Image frame;
+    std::mutex mutex;
+};
+
+/**
+ * @brief Video asset whose decode waits until a partner decode has started
+ *
+ * Two of these only finish when their getFrame() calls overlap in time.
+ */
+class RendezvousAsset : public IAsset {
+public:
+    RendezvousAsset(int* arrived, std::mutex* mutex, std::condition_variable* cv)
+        : frame(8, 8), arrived(arrived), mutex(mutex), cv(cv), overlapped(false) {
+        frame.fill(Color(0, 0, 0, 255));
+    }
+
+    double getDuration() const override { return 10.0; }
+    const Image& getFrame(double time = 0.0) override {
+        std::unique_lock<std::mutex> lock(*mutex);
+        if (overlapped) {
+            return frame; // Already decoded this frame
+        }
+        (*arrived)++;
+        cv->notify_all();
+        overlapped = cv->wait_for(lock, std::chrono::seconds(2),
+                                  [this]() { return *arrived >= 2; });
+        return frame;
+    }
+    const Image& getThumbnail() override { return frame; }
+    bool isVideo() const override { return true; }
+    AssetType getAssetType() const override { return AssetType::VIDEO; }
+
+    Image frame;
+    int* arrived;
+    std::mutex* mutex;
+    std::condition_variable* cv;
+    bool overlapped;
+};
+
+} // namespace
+
+// ==============================================================================
+// Test Fixture
+// ==============================================================================
+
+class TransitionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        red = new RecordingVideoAsset(Color(255, 0, 0, 255));
+        blue = new RecordingVideoAsset(Color(0, 0, 255, 255));
+
+        // Red for [0, 2), blue for [2, 4), crossfade of 1s centered on 2
+        timeline.addTrack("Video");
+        timeline.addEntryToTrack(0, TimelineEntry(red, 0.0, 2.0));
+        timeline.addEntryToTrack(0, TimelineEntry(blue, 2.0, 2.0));
+    }
+
+    void TearDown() override {
+        delete red;
+        delete blue;
+    }
+
+    Timeline timeline;
+    RecordingVideoAsset* red;
+    RecordingVideoAsset* blue;
+};
+
+// ==============================================================================
+// Kernel Tests
+// ==============================================================================
+
+/**
+ * Test: Lerp endpoints and midpoint
+ * Purpose: Verify weight 0 keeps from, 256 gives to, 128 averages
+ */
+TEST_F(TransitionTest, LerpSpanEndpoints) {
+    unsigned char from[8] = {0, 100, 200, 255, 10, 20, 30, 40};
+    unsigned char to[8] = {255, 0, 100, 255, 50, 60, 70, 80};
+    unsigned char out[8];
+
+    lerpSpan(out, from, to, 2, 0);
+    EXPECT_EQ(std::vector<unsigned char>(out, out + 8),
+              std::vector<unsigned char>(from, from + 8));
+    lerpSpan(out, from, to, 2, 256);
+    EXPECT_EQ(std::vector<unsigned char>(out, out + 8),
+              std::vector<unsigned char>(to, to + 8));
+    lerpSpan(out, from, to, 2, 128);
+    EXPECT_EQ(out[0], 128);
+    EXPECT_EQ(out[1], 50);
+    EXPECT_EQ(out[4], 30);
+}
+
+/**
+ * Test: Vector and scalar lerp agree
+ * Purpose: Verify the SSE2 body matches the scalar tail bit for bit
+ */
+TEST_F(TransitionTest, LerpVectorMatchesScalar) {
+    const int count = 9;
+    std::srand(3);
+    std::vector<unsigned char> from(count * 4), to(count * 4);
+    for (int i = 0; i < count * 4; i++) {
+        from[i] = static_cast<unsigned char>(std::rand() % 256);
+        to[i] = static_cast<unsigned char>(std::rand() % 256);
+    }
+
+    std::vector<unsigned char> together(count * 4), single(count * 4);
+    lerpSpan(together.data(), from.data(), to.data(), count, 77);
+    for (int i = 0; i < count; i++) {
+        lerpSpan(&single[i * 4], &from[i * 4], &to[i * 4], 1, 77);
+    }
+    EXPECT_EQ(together, single);
+
+    Color grey(90, 90, 90, 255);
+    lerpSpanToColor(together.data(), from.data(), grey, count, 200);
+    for (int i = 0; i < count; i++) {
+        lerpSpanToColor(&single[i * 4], &from[i * 4], grey, 1, 200);
+    }
+    EXPECT_EQ(together, single);
+}
+
+/**
+ * Test: Wipe reveals the incoming frame from the left
+ * Purpose: Verify the wipe edge position
+ */
+TEST_F(TransitionTest, WipeRevealsFromLeft) {
+    Image from(10, 2), to(10, 2), out(10, 2);
+    from.fill(Color(255, 0, 0, 255));
+    to.fill(Color(0, 0, 255, 255));
+
+    applyTransition(from, to, out, Transition(TransitionType::WIPE), 0.3);
+
+    for (int x = 0; x < 10; x++) {
+        int expectedBlue = x < 3 ? 255 : 0;
+        EXPECT_EQ(out.getPixel(x, 1).blue(), expectedBlue) << "x = " << x;
+    }
+}
+
+/**
+ * Test: Dip to color passes through the color at the midpoint
+ * Purpose: Verify the two halves of a dip
+ */
+TEST_F(TransitionTest, DipPassesThroughColor) {
+    Image from(4, 4), to(4, 4), out(4, 4);
+    from.fill(Color(255, 0, 0, 255));
+    to.fill(Color(0, 0, 255, 255));
+    Transition dip(TransitionType::DIP_TO_COLOR);
+    dip.color = Color(255, 255, 255, 255);
+
+    applyTransition(from, to, out, dip, 0.5);
+    EXPECT_EQ(out.getPixel(2, 2).green(), 255);
+
+    applyTransition(from, to, out, dip, 0.25);
+    EXPECT_EQ(out.getPixel(2, 2).red(), 255);
+    EXPECT_NEAR(out.getPixel(2, 2).green(), 128, 1);
+    EXPECT_EQ(out.getPixel(2, 2).blue(), 128);
+
+    applyTransition(from, to, out, dip, 1.0);
+    EXPECT_EQ(out.getPixel(2, 2).red(), 0);
+    EXPECT_EQ(out.getPixel(2, 2).blue(), 255);
+}
+
+// ==============================================================================
+// Track Tests
+// ==============================================================================
+
+/**
+ * Test: Transitions need touching entries of sufficient length
+ * Purpose: Verify setTransition validation
+ */
+TEST_F(TransitionTest, SetTransitionValidates) {
+    Track* track = timeline.getTrack(0);
+    EXPECT_FALSE(track->setTransition(1, Transition()));  // No next entry
+    EXPECT_FALSE(track->setTransition(0, Transition(TransitionType::CROSSFADE, 5.0)));
+    EXPECT_FALSE(track->setTransition(0, Transition(TransitionType::CROSSFADE, 0.0)));
+    EXPECT_TRUE(track->setTransition(0, Transition(TransitionType::CROSSFADE, 1.0)));
+
+    // A gap between the entries
+    Track gapped;
+    gapped.addEntry(TimelineEntry(red, 0.0, 2.0));
+    gapped.addEntry(TimelineEntry(blue, 3.0, 2.0));
+    EXPECT_FALSE(gapped.setTransition(0, Transition()));
+}
+
+/**
+ * Test: Transition window is centered on the cut
+ * Purpose: Verify getTransitionAt timing and progress
+ */
+TEST_F(TransitionTest, TransitionWindowCenteredOnCut) {
+    Track* track = timeline.getTrack(0);
+    ASSERT_TRUE(track->setTransition(0, Transition(TransitionType::CROSSFADE, 1.0)));
+
+    Track::ActiveTransition active;
+    EXPECT_FALSE(track->getTransitionAt(1.4, active));
+    ASSERT_TRUE(track->getTransitionAt(1.5, active));
+    EXPECT_DOUBLE_EQ(active.progress, 0.0);
+    ASSERT_TRUE(track->getTransitionAt(2.25, active));
+    EXPECT_DOUBLE_EQ(active.progress, 0.75);
+    EXPECT_EQ(active.from->getAsset(), red);
+    EXPECT_EQ(active.to->getAsset(), blue);
+    EXPECT_FALSE(track->getTransitionAt(2.5, active));
+}
+
+/**
+ * Test: Moving entries apart disables their transition
+ * Purpose: Verify stale transitions are ignored instead of misrendered
+ */
+TEST_F(TransitionTest, MovedEntriesDropTransition) {
+    Track* track = timeline.getTrack(0);
+    ASSERT_TRUE(track->setTransition(0, Transition()));
+    ASSERT_TRUE(track->updateEntryStartTime(1, 3.0));
+
+    Track::ActiveTransition active;
+    EXPECT_FALSE(track->getTransitionAt(2.0, active));
+    EXPECT_FALSE(track->getTransitionAt(3.0, active));
+
+    ASSERT_TRUE(track->updateEntryStartTime(1, 2.0));
+    EXPECT_TRUE(track->getTransitionAt(2.0, active));
+    EXPECT_TRUE(track->removeTransition(0));
+    EXPECT_FALSE(track->getTransitionAt(2.0, active));
+}
+
+// ==============================================================================
+// Rendering Tests
+// ==============================================================================
+
+/**
+ * Test: Crossfade renders a mix of both entries
+ * Purpose: Verify the Timeline draws both sides and mixes them
+ */
+TEST_F(TransitionTest, CrossfadeRendersBothEntries) {
+    timeline.getTrack(0)->setTransition(0, Transition(TransitionType::CROSSFADE, 1.0));
+    Image frame(8, 8);
+
+    timeline.renderFrameInto(1.0, frame);
+    EXPECT_EQ(frame.getPixel(4, 4).red(), 255);
+
+    timeline.renderFrameInto(2.0, frame);
+    EXPECT_NEAR(frame.getPixel(4, 4).red(), 128, 1);
+    EXPECT_NEAR(frame.getPixel(4, 4).blue(), 128, 1);
+
+    timeline.renderFrameInto(3.0, frame);
+    EXPECT_EQ(frame.getPixel(4, 4).blue(), 255);
+    EXPECT_EQ(frame.getPixel(4, 4).red(), 0);
+}
+
+/**
+ * Test: Both sources of a transition are decoded at their own local time
+ * Purpose: Verify outgoing and incoming entries are sampled correctly,
+ * with the incoming entry holding its first frame before its start
+ */
+TEST_F(TransitionTest, BothSourcesDecodedAtLocalTime) {
+    timeline.getTrack(0)->setTransition(0, Transition(TransitionType::CROSSFADE, 1.0));
+    Image frame(8, 8);
+
+    red->requests.clear();
+    blue->requests.clear();
+    timeline.renderFrameInto(1.75, frame);
+
+    ASSERT_FALSE(red->requests.empty());
+    ASSERT_FALSE(blue->requests.empty());
+    EXPECT_DOUBLE_EQ(red->requests.front(), 1.75);
+    EXPECT_DOUBLE_EQ(blue->requests.front(), 0.0);
+}
+
+/**
+ * Test: Upcoming entries are decoded ahead of the cut
+ * Purpose: Verify prefetching positions the next clip's decoder early
+ */
+TEST_F(TransitionTest, UpcomingEntryIsPrefetched) {
+    Image frame(8, 8);
+
+    blue->requests.clear();
+    timeline.renderFrameInto(2.0 - Timeline::PREFETCH_LEAD - 0.1, frame);
+    EXPECT_TRUE(blue->requests.empty());
+
+    timeline.renderFrameInto(2.0 - Timeline::PREFETCH_LEAD / 2.0, frame);
+    ASSERT_EQ(blue->requests.size(), 1u);
+    EXPECT_DOUBLE_EQ(blue->requests.front(), 0.0);
+}
+
+/**
+ * Test: The two sources of a transition decode at the same time
+ * Purpose: Verify decoding runs concurrently on the thread pool. Each
+ * asset's decode only completes quickly if the other one is in progress.
+ */
+TEST_F(TransitionTest, SourcesDecodeConcurrently) {
+    int arrived = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+    RendezvousAsset outgoing(&arrived, &mutex, &cv);
+    RendezvousAsset incoming(&arrived, &mutex, &cv);
+
+    Timeline concurrent;
+    concurrent.addTrack();
+    concurrent.addEntryToTrack(0, TimelineEntry(&outgoing, 0.0, 2.0));
+    concurrent.addEntryToTrack(0, TimelineEntry(&incoming, 2.0, 2.0));
+    concurrent.getTrack(0)->setTransition(0, Transition(TransitionType::CROSSFADE, 1.0));
+
+    concurrent.prepareFrame(2.0);
+
+    EXPECT_TRUE(outgoing.overlapped);
+    EXPECT_TRUE(incoming.overlapped);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file test_yuv_swscale.cpp
+ * @brief Compares the export's YUV conversion with FFmpeg's swscale
+ *
+ * Exports convert frames to YUV 4:2:0 themselves instead of through
+ * sws_scale. These tests check both give the same samples, to within 1,
+ * for every matrix and range the encoder can be asked for.
+ */
+
+#include <gtest/gtest.h>
+#include "export/YuvFrame.h"
+#include "Image.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+using namespace csci3081;
+
+namespace {
+
+/**
+ * @brief Convert an RGBA image with sws_scale
+ */
+bool convertWithSwscale(const Image& image, const YuvFormat& format, YuvFrame& frame) {
+    const int width = image.getWidth();
+    const int height = image.getHeight();
+    frame.resize(width, height);
+    SwsContext* context = sws_getContext(width, height, AV_PIX_FMT_RGBA, width, height,
+                                         AV_PIX_FMT_YUV420P,
+                                         SWS_BILINEAR | SWS_ACCURATE_RND | SWS_BITEXACT,
+                                         NULL, NULL, NULL);
+    if (!context) {
+        return false;
+    }
+    const int colorspace = format.matrix == YuvMatrix::BT709 ? SWS_CS_ITU709 : SWS_CS_ITU601;
+    sws_setColorspaceDetails(context, sws_getCoefficients(SWS_CS_DEFAULT), 1,
+                             sws_getCoefficients(colorspace),
+                             format.range == YuvRange::FULL ? 1 : 0, 0, 1 << 16, 1 << 16);
+
+    const uint8_t* source[1] = {image.getData()};
+    int sourceStride[1] = {width * 4};
+    uint8_t* planes[3] = {frame.y.data(), frame.u.data(), frame.v.data()};
+    int strides[3] = {width, frame.getChromaWidth(), frame.getChromaWidth()};
+    sws_scale(context, source, sourceStride, 0, height, planes, strides);
+    sws_freeContext(context);
+    return true;
+}
+
+int largestDifference(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    int largest = 0;
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        largest = std::max(largest, std::abs(a[i] - b[i]));
+    }
+    return largest;
+}
+
+} // namespace
+
+// ==============================================================================
+// Comparison Tests
+// ==============================================================================
+
+/**
+ * Test: Every matrix and range matches sws_scale to within 1
+ * Purpose: Verify luma on noise, and chroma on gradients where swscale's
+ * chroma filter and 2x2 averaging agree
+ */
+TEST(YuvSwscaleTest, MatchesSwscaleWithinOne) {
+    const YuvFormat formats[] = {
+        YuvFormat(YuvMatrix::BT601, YuvRange::LIMITED), YuvFormat(YuvMatrix::BT601, YuvRange::FULL),
+        YuvFormat(YuvMatrix::BT709, YuvRange::LIMITED), YuvFormat(YuvMatrix::BT709, YuvRange::FULL)};
+
+    const int width = 64;
+    const int height = 48;
+    Image noise(width, height);
+    Image gradient(width, height);
+    std::srand(3);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char* pixel = noise.getData() + (y * width + x) * 4;
+            for (int c = 0; c < 3; c++) {
+                pixel[c] = static_cast<unsigned char>(std::rand() & 255);
+            }
+            pixel[3] = 255;
+            pixel = gradient.getData() + (y * width + x) * 4;
+            pixel[0] = static_cast<unsigned char>(x * 2);
+            pixel[1] = static_cast<unsigned char>(y * 3);
+            pixel[2] = static_cast<unsigned char>(255 - x - y * 2);
+            pixel[3] = 255;
+        }
+    }
+
+    for (const YuvFormat& format : formats) {
+        YuvFrame ours;
+        YuvFrame theirs;
+        convertToYuv420(noise, ours, format, nullptr);
+        ASSERT_TRUE(convertWithSwscale(noise, format, theirs));
+        EXPECT_LE(largestDifference(ours.y, theirs.y), 1);
+
+        convertToYuv420(gradient, ours, format, nullptr);
+        ASSERT_TRUE(convertWithSwscale(gradient, format, theirs));
+        EXPECT_LE(largestDifference(ours.y, theirs.y), 1);
+        EXPECT_LE(largestDifference(ours.u, theirs.u), 1);
+        EXPECT_LE(largestDifference(ours.v, theirs.v), 1);
+    }
+}